@@ -0,0 +1,97 @@
+/* arena.c - Bump-allocated string arena implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "config.h"
+
+/* Length prefix type — 4 bytes keeps every entry's prefix small */
+typedef unsigned int arena_len_t;
+
+/* Round up so every length prefix stays naturally aligned */
+#define ARENA_ALIGN(n)  (((n) + sizeof(arena_len_t) - 1) & ~(sizeof(arena_len_t) - 1))
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* Start a new block of at least 'need' bytes. Returns 0 on failure. */
+static int arena_grow(StringArena *a, size_t need) {
+    size_t      size = ARENA_BLOCK_SIZE;
+    ArenaBlock *b;
+
+    /* Oversized strings get a dedicated block of their own */
+    if (need > size) size = need;
+
+    b = (ArenaBlock *)malloc(sizeof(ArenaBlock) + size);
+    if (!b) return 0;
+    b->next = a->head;
+    b->size = size;
+    b->used = 0;
+    a->head = b;
+    a->bytes_alloc += size;
+    return 1;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void arena_init(StringArena *a) {
+    if (!a) return;
+    a->head        = NULL;
+    a->bytes_used  = 0;
+    a->bytes_alloc = 0;
+}
+
+const char *arena_strndup(StringArena *a, const char *s, size_t len) {
+    size_t      need;
+    arena_len_t n;
+    char       *dst;
+
+    if (!a) return NULL;
+    if (!s) len = 0;
+
+    need = ARENA_ALIGN(sizeof(arena_len_t) + len + 1);
+    if (!a->head || a->head->size - a->head->used < need) {
+        if (!arena_grow(a, need)) {
+            fprintf(stderr, "arena_strndup: malloc failed\n");
+            return NULL;
+        }
+    }
+
+    dst = a->head->data + a->head->used;
+    n   = (arena_len_t)len;
+    memcpy(dst, &n, sizeof(n));
+    dst += sizeof(n);
+    if (len) memcpy(dst, s, len);
+    dst[len] = '\0';
+
+    a->head->used += need;
+    a->bytes_used += need;
+    return dst;
+}
+
+const char *arena_strdup(StringArena *a, const char *s) {
+    return arena_strndup(a, s, s ? strlen(s) : 0);
+}
+
+size_t arena_strlen(const char *s) {
+    arena_len_t n;
+    memcpy(&n, s - sizeof(n), sizeof(n));
+    return (size_t)n;
+}
+
+void arena_free(StringArena *a) {
+    ArenaBlock *b, *next;
+    if (!a) return;
+    for (b = a->head; b; b = next) {
+        next = b->next;
+        free(b);
+    }
+    arena_init(a);
+}
+
+void arena_memory(const StringArena *a, MemUsage *u) {
+    const ArenaBlock *b;
+    size_t            headers = 0;
+    for (b = a->head; b; b = b->next) headers += sizeof(ArenaBlock);
+    u->string_bytes   += a->bytes_used;
+    u->overhead_bytes += a->bytes_alloc - a->bytes_used + headers;
+}
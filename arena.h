@@ -0,0 +1,54 @@
+/* arena.h - Bump-allocated string arena with one-shot release */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>   /* size_t */
+#include "memusage.h"
+
+/*
+ * StringArena - append-only storage for variable-length strings.
+ *
+ * Strings are copied into large blocks back to back, each stored as a
+ * 4-byte length prefix followed by the bytes and a NUL terminator:
+ *
+ *   [len:4][bytes ... len][\0] [len:4][bytes ...][\0] ...
+ *
+ * The pointer handed out points at the first byte, so it is an ordinary
+ * C string; arena_strlen() reads the prefix in O(1).  Individual strings
+ * are never freed — arena_free() releases every block in one pass.
+ * Blocks never move, so returned pointers stay valid until arena_free.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;   /* previously filled block   */
+    size_t             size;   /* capacity of data[]        */
+    size_t             used;   /* bytes handed out so far   */
+    char               data[]; /* C99 flexible array member */
+} ArenaBlock;
+
+typedef struct StringArena {
+    ArenaBlock *head;          /* block currently being filled   */
+    size_t      bytes_used;    /* total bytes handed out         */
+    size_t      bytes_alloc;   /* total bytes malloc'd in blocks */
+} StringArena;
+
+/* Initialise an empty arena (no allocation until the first copy). */
+void arena_init(StringArena *a);
+
+/* Copy len bytes of s into the arena and NUL-terminate them.
+   Returns the stored string, or NULL on malloc failure. */
+const char *arena_strndup(StringArena *a, const char *s, size_t len);
+
+/* Copy a NUL-terminated string (NULL is stored as ""). */
+const char *arena_strdup(StringArena *a, const char *s);
+
+/* Length of a string returned by the arena, read from its prefix. */
+size_t arena_strlen(const char *s);
+
+/* Free every block and reset to the empty state. */
+void arena_free(StringArena *a);
+
+/* Add the arena to u (memusage.h): the bytes handed out as strings
+   (length prefixes included), block slack and headers as overhead. */
+void arena_memory(const StringArena *a, MemUsage *u);
+
+#endif /* ARENA_H */
@@ -2,151 +2,761 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "autocomplete.h"
+#include "stats.h"
 #include "utils.h"
 
-/* Maximum words we ever collect before trimming to top_k.
-   Sized conservatively above any realistic dictionary size. */
-#define MAX_CANDIDATES 512
-
 /* ── Static helpers ──────────────────────────────────────────── */
 
-static int composite_score(const WordRecord *r) {
-    return r->frequency_score + 10 * r->user_select_count;
-}
+/*
+ * The default ranking, word_record_score, with its common case inlined:
+ * a record nobody picked scores its frequency, with no call at all.
+ */
+#define composite_score(r) \
+    ((r)->select_time == 0 ? (r)->frequency_score : word_record_score(r))
 
-/* qsort comparator: higher composite score sorts first */
-static int cmp_score_desc(const void *a, const void *b) {
-    return composite_score((const WordRecord *)b)
-         - composite_score((const WordRecord *)a);
-}
+/*
+ * TopKHeap - streaming top-k selection over record pointers, generated
+ * from ranker.h for composite_score (topk_init, topk_push, ...).
+ *
+ * A bounded min-heap: the root is the worst of the best-so-far, so each
+ * new match costs one score and one compare when it does not qualify and
+ * O(log k) when it does.  Only top_k pointers live on the stack (never
+ * full records), nothing is sorted until the final k are materialised,
+ * and there is no candidate cap — every match is considered.
+ */
+#define RANKER_NAME   topk
+#define RANKER_SCORE  composite_score
+#include "ranker.h"
+
+typedef topk_heap TopKHeap;
+
+/* Count one answered prefix and its n results (stats.h). */
+#define AC_SERVED(n)                                          \
+    do {                                                      \
+        STATS_INC(STAT_AC_QUERIES);                           \
+        STATS_ADD(STAT_AC_RESULTS, (n));                      \
+    } while (0)
 
-/* Recursive BST prefix collector with BST-pruning.
- * strncmp(root->word, prefix, plen):
- *   > 0 → current word is alphabetically past prefix → only left subtree can match
- *   < 0 → current word is before prefix range      → only right subtree can match
- *   = 0 → current word starts with prefix          → collect + recurse both sides */
-static void bst_collect(BSTNode *root, const char *prefix, size_t plen,
-                         WordRecord *buf, int *count) {
-    int cmp;
-    if (!root || *count >= MAX_CANDIDATES) return;
-    cmp = strncmp(root->data.word, prefix, plen);
+/* topk_avl_collect's key-order pruning (ranker.h), plus score pruning,
+ * which only the default ranking can have: node->max_score
+ * bounds every word below, so once the heap is full a subtree whose best
+ * cannot beat the current k-th result is skipped whole.  Inside the
+ * prefix range the richer child goes first, which raises the bar sooner.
+ * Ranks across all matches, yet a short prefix on the 90k list only
+ * touches the few subtrees that hold high scorers. */
+static void avl_collect(AVLNode *root, const char *prefix, size_t plen,
+                        const char *lo, TopKHeap *h) {
+    const char *w;
+    AVLNode    *l, *r;
+    int         cmp;
+
+    if (!root) return;
+    STATS_INC(STAT_NODE_VISITS);
+    if (topk_cannot_enter(h, root->max_score, lo)) return;
+    STATS_INC(STAT_KEY_COMPARES);
+    w   = root->rec->word;   /* exclusive lower bound of the right subtree */
+    cmp = str_key_ncmp(w, prefix, plen);
+    l   = avl_left(root);
+    r   = avl_right(root);
     if (cmp > 0) {
-        bst_collect(root->left,  prefix, plen, buf, count);
+        avl_collect(l, prefix, plen, lo, h);
     } else if (cmp < 0) {
-        bst_collect(root->right, prefix, plen, buf, count);
+        avl_collect(r, prefix, plen, w,  h);
     } else {
-        bst_collect(root->left,  prefix, plen, buf, count);
-        if (*count < MAX_CANDIDATES)
-            buf[(*count)++] = root->data;
-        bst_collect(root->right, prefix, plen, buf, count);
+        topk_push(h, root->rec);
+        if (!r || (l && l->max_score >= r->max_score)) {
+            avl_collect(l, prefix, plen, lo, h);
+            avl_collect(r, prefix, plen, w,  h);
+        } else {
+            avl_collect(r, prefix, plen, w,  h);
+            avl_collect(l, prefix, plen, lo, h);
+        }
     }
 }
 
-/* Identical algorithm for AVL nodes */
-static void avl_collect(AVLNode *root, const char *prefix, size_t plen,
-                         WordRecord *buf, int *count) {
-    int cmp;
-    if (!root || *count >= MAX_CANDIDATES) return;
-    cmp = strncmp(root->data.word, prefix, plen);
-    if (cmp > 0) {
-        avl_collect(root->left,  prefix, plen, buf, count);
-    } else if (cmp < 0) {
-        avl_collect(root->right, prefix, plen, buf, count);
-    } else {
-        avl_collect(root->left,  prefix, plen, buf, count);
-        if (*count < MAX_CANDIDATES)
-            buf[(*count)++] = root->data;
-        avl_collect(root->right, prefix, plen, buf, count);
+static int avl_query(AVLNode *root, const char *prefix,
+                     WordRecord *results, int top_k) {
+    char     buf[MAX_WORD_LEN];
+    TopKHeap h;
+
+    topk_init(&h, top_k);
+    str_tolower(buf, prefix, sizeof(buf));
+    avl_collect(root, buf, strlen(buf), NULL, &h);
+    return topk_finish(&h, results);
+}
+
+static int trie_query(const Trie *trie, const char *prefix,
+                      WordRecord *results, int top_k) {
+    char        buf[MAX_WORD_LEN];
+    WordRecord *best[TRIE_TOPK];
+    int         ret, i;
+
+    str_tolower(buf, prefix, sizeof(buf));
+    if (buf[0] == '\0') return 0;   /* same as TBT: no empty-prefix dump */
+
+    /* Fast path: O(prefix length) descent, then read the node's cached
+       top-k — no subtree walk and no sort. */
+    ret = trie_topk(trie, buf, best, top_k);
+    if (ret >= 0) {
+        for (i = 0; i < ret; i++) results[i] = *best[i];
+        return ret;
+    }
+
+    /* top_k beyond the cache: stream the prefix subtree through the heap */
+    return topk_trie(trie, buf, results, top_k);
+}
+
+/*
+ * Fill level len of the session from the tree's own results: they are
+ * copies, so each is mapped back to its stored record.  Returns 0 if one
+ * is no longer in the store (the level is then left uncached).
+ */
+static int session_store(AutocompleteSession *s, const RecordStore *store, int len,
+                         const WordRecord *results, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        s->best[len][i] = store_find(store, results[i].word);
+        if (!s->best[len][i]) return 0;
     }
+    s->n[len] = n;
+    return 1;
+}
+
+/* Trees whose score caches follow applied picks. */
+typedef struct RescoreCtx {
+    AVLNode *avl_root;
+    Trie    *trie;
+} RescoreCtx;
+
+static void rescore_cb(WordRecord *rec, void *arg) {
+    RescoreCtx *ctx = (RescoreCtx *)arg;
+    avl_score_changed(ctx->avl_root, rec);              /* keep max_score exact */
+    if (ctx->trie) trie_score_changed(ctx->trie, rec);  /* keep top-k caches exact */
+}
+
+/* ── Batch helpers ───────────────────────────────────────────── */
+
+/* One prefix of a batch: its normalised key and where its answer goes. */
+typedef struct BatchItem {
+    DictKey key;
+    int     plen;
+    int     idx;   /* position in the caller's prefixes / counts       */
+    int     dup;   /* same key as the item before it: answered by that */
+} BatchItem;
+
+static int batch_item_cmp(const void *a, const void *b) {
+    const BatchItem *x = (const BatchItem *)a, *y = (const BatchItem *)b;
+    int c = str_key_cmp(x->key.text, y->key.text);
+    return c ? c : x->idx - y->idx;
+}
+
+/* Normalise and sort the prefixes, marking repeats.  NULL on malloc failure. */
+static BatchItem *batch_prepare(const char *const *prefixes, int count) {
+    BatchItem *it;
+    int        i;
+
+    it = (BatchItem *)malloc((size_t)(count > 0 ? count : 1) * sizeof(BatchItem));
+    if (!it) {
+        fprintf(stderr, "[ERROR] autocomplete batch: malloc failed\n");
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        dict_key_init(&it[i].key, prefixes[i]);
+        it[i].plen = (int)strlen(it[i].key.text);
+        it[i].idx  = i;
+    }
+    qsort(it, (size_t)count, sizeof(BatchItem), batch_item_cmp);
+    STATS_INC(STAT_SORTS);
+    STATS_ADD(STAT_SORTED_ITEMS, count);
+    for (i = 0; i < count; i++)
+        it[i].dup = i > 0 && str_key_cmp(it[i].key.text, it[i - 1].key.text) == 0;
+    return it;
+}
+
+/* Write the answer of item q from its heap. */
+static void batch_emit(const BatchItem *q, TopKHeap *h, WordRecord *results,
+                       int *counts, int top_k) {
+    counts[q->idx] = topk_finish(h, results + (size_t)q->idx * (size_t)top_k);
+    AC_SERVED(counts[q->idx]);
+}
+
+/* Give every repeat its first occurrence's answer, then free the items. */
+static void batch_done(BatchItem *it, int count, WordRecord *results,
+                       int *counts, int top_k) {
+    int i, first = 0;
+    for (i = 0; i < count; i++) {
+        if (!it[i].dup) { first = it[i].idx; continue; }
+        counts[it[i].idx] = counts[first];
+        memcpy(results + (size_t)it[i].idx * (size_t)top_k,
+               results + (size_t)first * (size_t)top_k,
+               (size_t)counts[first] * sizeof(WordRecord));
+    }
+    free(it);
+}
+
+/*
+ * BatchChunk - up to AC_BATCH_CHUNK sorted prefixes descending a BST or
+ * AVL together.  Each recursion level passes down the list of chunk
+ * slots still interested in a subtree (act[0..m)), so a node is read
+ * once however many prefixes visit it.
+ */
+typedef struct BatchChunk {
+    const BatchItem *item[AC_BATCH_CHUNK];
+    TopKHeap         heap[AC_BATCH_CHUNK];
+} BatchChunk;
+
+/* Per-slot comparison of word against each active prefix: 1 if the word
+   is past the prefix range, -1 if before it, 0 if it matches. */
+static void batch_compare(const BatchChunk *c, const char *word,
+                          const unsigned char *act, int m, signed char *cmp) {
+    const BatchItem *q;
+    int              i, r;
+    STATS_ADD(STAT_KEY_COMPARES, m);
+    for (i = 0; i < m; i++) {
+        q      = c->item[act[i]];
+        r      = str_key_ncmp(word, q->key.text, (size_t)q->plen);
+        cmp[i] = (signed char)(r > 0 ? 1 : (r < 0 ? -1 : 0));
+    }
+}
+
+/* The slots that continue into one side: left (side 1) wants the words
+   before this one (cmp >= 0), right (side -1) those after (cmp <= 0). */
+static int batch_side(const unsigned char *act, const signed char *cmp, int m,
+                      int side, unsigned char *sub) {
+    int i, n = 0;
+    for (i = 0; i < m; i++)
+        if (cmp[i] != -side) sub[n++] = act[i];
+    return n;
+}
+
+/* bst_collect for a chunk of prefixes. */
+static void bst_collect_batch(BSTNode *root, BatchChunk *c,
+                              const unsigned char *act, int m) {
+    unsigned char sub[AC_BATCH_CHUNK];
+    signed char   cmp[AC_BATCH_CHUNK];
+    int           i, n;
+
+    if (!root || m == 0) return;
+    STATS_INC(STAT_NODE_VISITS);
+    batch_compare(c, root->rec->word, act, m, cmp);
+    n = batch_side(act, cmp, m, 1, sub);
+    if (n > 0) bst_collect_batch(root->left, c, sub, n);
+    for (i = 0; i < m; i++)
+        if (cmp[i] == 0) topk_push(&c->heap[act[i]], root->rec);
+    n = batch_side(act, cmp, m, -1, sub);
+    if (n > 0) bst_collect_batch(root->right, c, sub, n);
+}
+
+/* avl_collect for a chunk of prefixes: a slot drops out of a subtree as
+   soon as its own heap cannot take anything from it. */
+static void avl_collect_batch(AVLNode *root, const char *lo, BatchChunk *c,
+                              const unsigned char *act, int m) {
+    unsigned char live[AC_BATCH_CHUNK], sub[AC_BATCH_CHUNK];
+    signed char   cmp[AC_BATCH_CHUNK];
+    const char   *w;
+    AVLNode      *l, *r;
+    int           i, n, ns, side;
+
+    if (!root) return;
+    STATS_INC(STAT_NODE_VISITS);
+    for (i = n = 0; i < m; i++)
+        if (!topk_cannot_enter(&c->heap[act[i]], root->max_score, lo))
+            live[n++] = act[i];
+    if (n == 0) return;
+
+    w = root->rec->word;
+    batch_compare(c, w, live, n, cmp);
+    for (i = 0; i < n; i++)
+        if (cmp[i] == 0) topk_push(&c->heap[live[i]], root->rec);
+
+    /* Richer child first, as in avl_collect (side 1: left, -1: right) */
+    l    = avl_left(root);
+    r    = avl_right(root);
+    side = (!r || (l && l->max_score >= r->max_score)) ? 1 : -1;
+    for (i = 0; i < 2; i++, side = -side) {
+        ns = batch_side(live, cmp, n, side, sub);
+        if (side > 0) avl_collect_batch(l, lo, c, sub, ns);
+        else          avl_collect_batch(r, w,  c, sub, ns);
+    }
+}
+
+/* Run the sorted items through the AVL, or the BST if avl is NULL, a
+   chunk at a time. */
+static void batch_descend(const BatchItem *it, int count, BSTNode *bst, AVLNode *avl,
+                          WordRecord *results, int *counts, int top_k) {
+    BatchChunk    c;
+    unsigned char act[AC_BATCH_CHUNK];
+    int           i = 0, j, n;
+
+    while (i < count) {
+        for (n = 0; i < count && n < AC_BATCH_CHUNK; i++) {
+            if (it[i].dup) continue;
+            c.item[n] = &it[i];
+            topk_init(&c.heap[n], top_k);
+            act[n] = (unsigned char)n;
+            n++;
+        }
+        if (avl) avl_collect_batch(avl, NULL, &c, act, n);
+        else     bst_collect_batch(bst, &c, act, n);
+        for (j = 0; j < n; j++)
+            batch_emit(c.item[j], &c.heap[j], results, counts, top_k);
+    }
+}
+
+/* A sorted-order position in the TBT (header != NULL) or the B+-tree. */
+typedef struct BatchCursor {
+    TBTNode       *header;
+    TBTNode       *node;
+    const BPTree  *tree;
+    const BPTLeaf *leaf;
+    int            pos;
+} BatchCursor;
+
+/* Record under the cursor, or NULL once past the last word. */
+static WordRecord *cursor_rec(BatchCursor *c) {
+    if (c->header) return c->node && c->node != c->header ? c->node->rec : NULL;
+    while (c->leaf && c->pos >= c->leaf->n) {   /* step over empty leaves */
+        c->leaf = c->leaf->next;
+        c->pos  = 0;
+    }
+    return c->leaf ? c->leaf->rec[c->pos] : NULL;
+}
+
+/* Jump to the first word of q's range (or past it) with one root descent. */
+static WordRecord *cursor_seek(BatchCursor *c, const BatchItem *q) {
+    if (c->header) c->node = tbt_lower_bound_normalized(c->header, &q->key);
+    else           c->leaf = bpt_lower_bound(c->tree, &q->key, &c->pos);
+    return cursor_rec(c);
+}
+
+static WordRecord *cursor_next(BatchCursor *c) {
+    STATS_INC(STAT_NODE_VISITS);
+    if (c->header) c->node = tbt_inorder_successor(c->node);
+    else           c->pos++;
+    return cursor_rec(c);
+}
+
+/*
+ * One forward walk answering every sorted item.  The open prefixes form
+ * a stack of nested ranges (each extends the one below), so a word that
+ * matches the top matches them all.  An open prefix is complete, and is
+ * emitted, as soon as the walk leaves its range: the word is past it, or
+ * the next prefix to open does not extend it.  With nothing open, the
+ * cursor seeks to the next prefix's range unless it is already there, so
+ * adjacent ranges cost no descent.
+ */
+static void batch_scan(const BatchItem *it, int count, BatchCursor *cur,
+                       WordRecord *results, int *counts, int top_k) {
+    TopKHeap         heap[MAX_WORD_LEN];
+    const BatchItem *open[MAX_WORD_LEN];
+    const BatchItem *top;
+    WordRecord      *w = NULL;
+    int              depth = 0, j, d, placed = 0;
+
+    /* An empty prefix lists nothing, as in the single-query calls */
+    for (j = 0; j < count && it[j].plen == 0; j++) counts[it[j].idx] = 0;
+
+    for (;;) {
+        if (depth == 0) {
+            while (j < count && it[j].dup) j++;
+            if (j == count) break;
+            if (!placed ||
+                (w && str_key_ncmp(w->word, it[j].key.text, (size_t)it[j].plen) < 0)) {
+                w      = cursor_seek(cur, &it[j]);
+                placed = 1;
+            }
+        }
+
+        /* Open every prefix whose range the walk has reached */
+        for (; j < count; j++) {
+            if (it[j].dup) continue;
+            if (w && str_key_ncmp(w->word, it[j].key.text, (size_t)it[j].plen) < 0)
+                break;
+            while (depth > 0) {
+                top = open[depth - 1];
+                if (it[j].plen > top->plen &&
+                    memcmp(it[j].key.text, top->key.text, (size_t)top->plen) == 0)
+                    break;
+                depth--;
+                batch_emit(top, &heap[depth], results, counts, top_k);
+            }
+            open[depth] = &it[j];
+            topk_init(&heap[depth], top_k);
+            depth++;
+        }
+        if (!w) break;
+
+        /* Close the ranges w has left; it matches every one still open */
+        while (depth > 0 &&
+               str_key_ncmp(w->word, open[depth - 1]->key.text,
+                            (size_t)open[depth - 1]->plen) != 0) {
+            depth--;
+            batch_emit(open[depth], &heap[depth], results, counts, top_k);
+        }
+        for (d = 0; d < depth; d++) topk_push(&heap[d], w);
+        if (depth > 0) w = cursor_next(cur);
+    }
+    while (depth > 0) {
+        depth--;
+        batch_emit(open[depth], &heap[depth], results, counts, top_k);
+    }
+}
+
+/* One slice of autocomplete_batch_parallel. */
+typedef struct BatchJob {
+    AutocompleteBatchFn batch;
+    void               *arg;
+    const char *const  *prefixes;
+    int                 count;
+    WordRecord         *results;
+    int                *counts;
+    int                 top_k;
+    int                 ret;
+} BatchJob;
+
+static void *batch_job_main(void *arg) {
+    BatchJob *j = (BatchJob *)arg;
+    j->ret = j->batch(j->prefixes, j->count, j->results, j->counts, j->top_k, j->arg);
+    return NULL;
 }
 
 /* ── Public API ──────────────────────────────────────────────── */
 
+/*
+ * The single-prefix calls are timed and counted here, around the query
+ * itself.  The batch calls count each prefix as they emit it
+ * (batch_emit) and time the shared walk; the trie's batch is a run of
+ * single calls, counted by those.
+ */
 int autocomplete_bst(BSTNode *root, const char *prefix,
                      WordRecord *results, int top_k) {
-    char       buf[MAX_WORD_LEN];
-    WordRecord candidates[MAX_CANDIDATES];
-    int        count = 0, ret, i;
-
-    str_tolower(buf, prefix, sizeof(buf));
-    bst_collect(root, buf, strlen(buf), candidates, &count);
-    qsort(candidates, (size_t)count, sizeof(WordRecord), cmp_score_desc);
-    ret = count < top_k ? count : top_k;
-    for (i = 0; i < ret; i++) results[i] = candidates[i];
-    return ret;
+    int n;
+    STATS_TIME(STAT_AC_NS, n = topk_bst(root, prefix, results, top_k));
+    AC_SERVED(n);
+    return n;
 }
 
 int autocomplete_avl(AVLNode *root, const char *prefix,
                      WordRecord *results, int top_k) {
-    char       buf[MAX_WORD_LEN];
-    WordRecord candidates[MAX_CANDIDATES];
-    int        count = 0, ret, i;
-
-    str_tolower(buf, prefix, sizeof(buf));
-    avl_collect(root, buf, strlen(buf), candidates, &count);
-    qsort(candidates, (size_t)count, sizeof(WordRecord), cmp_score_desc);
-    ret = count < top_k ? count : top_k;
-    for (i = 0; i < ret; i++) results[i] = candidates[i];
-    return ret;
+    int n;
+    STATS_TIME(STAT_AC_NS, n = avl_query(root, prefix, results, top_k));
+    AC_SERVED(n);
+    return n;
 }
 
 int autocomplete_tbt(TBTNode *header, const char *prefix,
                      WordRecord *results, int top_k) {
+    int n;
+    STATS_TIME(STAT_AC_NS, n = topk_tbt(header, prefix, results, top_k));
+    AC_SERVED(n);
+    return n;
+}
+
+int autocomplete_bpt(const BPTree *tree, const char *prefix,
+                     WordRecord *results, int top_k) {
+    int n;
+    STATS_TIME(STAT_AC_NS, n = topk_bpt(tree, prefix, results, top_k));
+    AC_SERVED(n);
+    return n;
+}
+
+int autocomplete_trie(const Trie *trie, const char *prefix,
+                      WordRecord *results, int top_k) {
+    int n;
+    STATS_TIME(STAT_AC_NS, n = trie_query(trie, prefix, results, top_k));
+    AC_SERVED(n);
+    return n;
+}
+
+/* Put rec, worth score to this user, into the ranked results[0..*n) if
+   it makes the top top_k. */
+static void boosted_offer(WordRecord *results, int *score, int *n, int top_k,
+                          const WordRecord *rec, int s) {
+    int i = *n;
+    if (i == top_k) {
+        if (s < score[i - 1] ||
+            (s == score[i - 1] && strcmp(rec->word, results[i - 1].word) >= 0))
+            return;
+        i--;
+    } else {
+        (*n)++;
+    }
+    while (i > 0 && (s > score[i - 1] ||
+                     (s == score[i - 1] && strcmp(rec->word, results[i - 1].word) < 0))) {
+        results[i] = results[i - 1];
+        score[i]   = score[i - 1];
+        i--;
+    }
+    results[i] = *rec;
+    score[i]   = s;
+}
+
+int autocomplete_trie_boosted(const Trie *trie, const RecordStore *store,
+                              const BoostTable *boosts, const char *prefix,
+                              WordRecord *results, int top_k) {
     char       buf[MAX_WORD_LEN];
+    WordRecord base[TOP_K_MAX];
+    int        score[TOP_K_MAX];
     size_t     plen;
-    WordRecord candidates[MAX_CANDIDATES];
-    int        count = 0, ret, i, cmp;
-    TBTNode   *cur, *start;
+    int        m, n = 0, i, j, at;
+
+    if (top_k > TOP_K_MAX) top_k = TOP_K_MAX;
+    if (top_k <= 0) return 0;
+    if (!boosts || boosts->count == 0)
+        return autocomplete_trie(trie, prefix, results, top_k);
+
+    /* The shared answer, re-scored for this user */
+    m = autocomplete_trie(trie, prefix, base, top_k);
+    for (i = 0; i < m; i++)
+        boosted_offer(results, score, &n, top_k, &base[i],
+                      word_record_score(&base[i]) + boost_value(boosts, base[i].word));
 
+    /* Then the user's own boosted words under the prefix */
     str_tolower(buf, prefix, sizeof(buf));
     plen = strlen(buf);
+    if (plen == 0) return n;
+    for (at = boost_lower_bound(boosts, buf);
+         at < boosts->count && strncmp(boosts->entries[at].word, buf, plen) == 0;
+         at++) {
+        const BoostEntry *e = &boosts->entries[at];
+        const WordRecord *rec;
 
-    if (plen == 0 || !header || header->lthread) return 0;
-
-    /* Find lower bound: leftmost node whose word >= prefix (first plen chars).
-     * Navigate BST-style: on cmp >= 0, save as candidate and go left
-     *                     (earlier nodes in the sorted order may also match);
-     *                     on cmp < 0, go right (need lexicographically larger). */
-    start = NULL;
-    cur   = header->lthread ? NULL : header->left;
-    while (cur) {
-        cmp = strncmp(cur->data.word, buf, plen);
-        if (cmp >= 0) {
-            start = cur;
-            cur   = cur->lthread ? NULL : cur->left;
-        } else {
-            cur = cur->rthread ? NULL : cur->right;
-        }
+        for (j = 0; j < m && strcmp(base[j].word, e->word) != 0; j++)
+            ;
+        if (j < m) continue;                     /* already ranked above */
+        rec = store_find(store, e->word);
+        if (rec)
+            boosted_offer(results, score, &n, top_k, rec,
+                          word_record_score(rec) + boost_entry_value(e));
     }
+    return n;
+}
 
-    if (!start) return 0;   /* every word sorts before prefix */
+int autocomplete_batch_bst(BSTNode *root, const char *const *prefixes, int count,
+                           WordRecord *results, int *counts, int top_k) {
+    BatchItem *it = batch_prepare(prefixes, count);
+    if (!it) return -1;
+    if (top_k < 0) top_k = 0;
+    STATS_TIME(STAT_AC_NS, batch_descend(it, count, root, NULL, results, counts, top_k));
+    batch_done(it, count, results, counts, top_k);
+    return 0;
+}
 
-    /* Walk forward from the lower-bound using inorder thread successor.
-     * Collect matching nodes; break as soon as we pass the prefix range. */
-    cur = start;
-    while (cur != header) {
-        cmp = strncmp(cur->data.word, buf, plen);
-        if (cmp > 0) break;    /* past the prefix range — subsequent words are larger */
-        if (cmp == 0 && count < MAX_CANDIDATES)
-            candidates[count++] = cur->data;
-        cur = tbt_inorder_successor(cur);
+int autocomplete_batch_avl(AVLNode *root, const char *const *prefixes, int count,
+                           WordRecord *results, int *counts, int top_k) {
+    BatchItem *it = batch_prepare(prefixes, count);
+    if (!it) return -1;
+    if (top_k < 0) top_k = 0;
+    STATS_TIME(STAT_AC_NS, batch_descend(it, count, NULL, root, results, counts, top_k));
+    batch_done(it, count, results, counts, top_k);
+    return 0;
+}
+
+int autocomplete_batch_tbt(TBTNode *header, const char *const *prefixes, int count,
+                           WordRecord *results, int *counts, int top_k) {
+    BatchItem  *it = batch_prepare(prefixes, count);
+    BatchCursor cur;
+    int         i;
+    if (!it) return -1;
+    if (top_k < 0) top_k = 0;
+    memset(&cur, 0, sizeof(cur));
+    cur.header = header;
+    if (header) {
+        STATS_TIME(STAT_AC_NS, batch_scan(it, count, &cur, results, counts, top_k));
+    } else {
+        for (i = 0; i < count; i++) counts[i] = 0;
     }
+    batch_done(it, count, results, counts, top_k);
+    return 0;
+}
+
+int autocomplete_batch_bpt(const BPTree *tree, const char *const *prefixes, int count,
+                           WordRecord *results, int *counts, int top_k) {
+    BatchItem  *it = batch_prepare(prefixes, count);
+    BatchCursor cur;
+    if (!it) return -1;
+    if (top_k < 0) top_k = 0;
+    memset(&cur, 0, sizeof(cur));
+    cur.tree = tree;
+    STATS_TIME(STAT_AC_NS, batch_scan(it, count, &cur, results, counts, top_k));
+    batch_done(it, count, results, counts, top_k);
+    return 0;
+}
+
+int autocomplete_batch_trie(const Trie *trie, const char *const *prefixes, int count,
+                            WordRecord *results, int *counts, int top_k) {
+    BatchItem *it = batch_prepare(prefixes, count);
+    int        i;
+    if (!it) return -1;
+    if (top_k < 0) top_k = 0;
+    for (i = 0; i < count; i++)
+        if (!it[i].dup)
+            counts[it[i].idx] = autocomplete_trie(trie, it[i].key.text,
+                                                  results + (size_t)it[i].idx * (size_t)top_k,
+                                                  top_k);
+    batch_done(it, count, results, counts, top_k);
+    return 0;
+}
+
+int autocomplete_batch_parallel(AutocompleteBatchFn batch, void *arg,
+                                const char *const *prefixes, int count,
+                                WordRecord *results, int *counts, int top_k,
+                                int threads) {
+    BatchJob  jobs[AC_BATCH_THREADS_MAX];
+    pthread_t tid[AC_BATCH_THREADS_MAX];
+    int       started[AC_BATCH_THREADS_MAX];
+    int       i, from, n, ret = 0;
+
+    if (top_k < 0) top_k = 0;
+    if (threads > AC_BATCH_THREADS_MAX) threads = AC_BATCH_THREADS_MAX;
+    if (threads > count) threads = count;
+    if (threads < 1) threads = 1;
 
-    qsort(candidates, (size_t)count, sizeof(WordRecord), cmp_score_desc);
-    ret = count < top_k ? count : top_k;
-    for (i = 0; i < ret; i++) results[i] = candidates[i];
+    for (i = 0, from = 0; i < threads; i++, from += n) {
+        n = count / threads + (i < count % threads);
+        jobs[i].batch    = batch;
+        jobs[i].arg      = arg;
+        jobs[i].prefixes = prefixes + from;
+        jobs[i].count    = n;
+        jobs[i].results  = results + (size_t)from * (size_t)top_k;
+        jobs[i].counts   = counts + from;
+        jobs[i].top_k    = top_k;
+    }
+    for (i = 1; i < threads; i++)
+        started[i] = pthread_create(&tid[i], NULL, batch_job_main, &jobs[i]) == 0;
+    batch_job_main(&jobs[0]);
+    for (i = 1; i < threads; i++) {
+        if (started[i]) pthread_join(tid[i], NULL);
+        else            batch_job_main(&jobs[i]);
+    }
+    for (i = 0; i < threads; i++)
+        if (jobs[i].ret != 0) ret = -1;
     return ret;
 }
 
-void autocomplete_record_selection(const char *word,
-                                   BSTNode *bst_root,
-                                   AVLNode *avl_root,
-                                   TBTNode *tbt_header) {
-    BSTNode *bn = bst_search(bst_root,   word);
-    AVLNode *an = avl_search(avl_root,   word);
-    TBTNode *tn = tbt_search(tbt_header, word);
-    if (bn) bn->data.user_select_count++;
-    if (an) an->data.user_select_count++;
-    if (tn) tn->data.user_select_count++;
+int autocomplete_count_selection(const char *word, RecordStore *store) {
+    /* One lookup is enough — every index points at the same stored record */
+    WordRecord *rec = store_find(store, word);
+    if (!rec) return 0;
+    store_add_pick(store, rec);
+    return 1;
+}
+
+int autocomplete_apply_selections(RecordStore *store, AVLNode *avl_root, Trie *trie) {
+    RescoreCtx ctx;
+    ctx.avl_root = avl_root;
+    ctx.trie     = trie;
+    return store_apply_picks(store, rescore_cb, &ctx);
+}
+
+int autocomplete_apply_decay(RecordStore *store, AVLNode *avl_root, Trie *trie) {
+    RescoreCtx ctx;
+    score_clock_advance(score_minutes());
+    if (!store_decay_due(store)) return 0;
+    ctx.avl_root = avl_root;
+    ctx.trie     = trie;
+    return store_decay(store, rescore_cb, &ctx);
+}
+
+void autocomplete_record_selection(const char *word, RecordStore *store,
+                                   AVLNode *avl_root, Trie *trie) {
+    if (autocomplete_count_selection(word, store))
+        autocomplete_apply_selections(store, avl_root, trie);
+}
+
+void autocomplete_session_reset(AutocompleteSession *s) {
+    int i;
+    s->text[0] = '\0';
+    s->top_k   = 0;
+    for (i = 0; i < MAX_WORD_LEN; i++) s->n[i] = s->count[i] = -1;
+}
+
+/* Move the session to the normalised key (len characters): levels past
+   the point where it leaves the old text are for other words now. */
+static void session_follow(AutocompleteSession *s, const DictKey *key, int len) {
+    int common, i;
+    for (common = 0; common < len && s->text[common] == key->text[common]; common++)
+        ;
+    for (i = common + 1; i < MAX_WORD_LEN; i++) s->n[i] = s->count[i] = -1;
+    memcpy(s->text, key->text, sizeof(s->text));
+}
+
+/* Is some level up to len known to have no match? */
+static int session_dead(const AutocompleteSession *s, int len) {
+    int i;
+    for (i = 1; i <= len; i++)
+        if (s->count[i] == 0) return 1;
+    return 0;
+}
+
+int autocomplete_prefix_count(AVLNode *avl_root, const char *prefix) {
+    return avl_count_prefix(avl_root, prefix);
+}
+
+int autocomplete_prefix_exists(AVLNode *avl_root, const Trie *trie,
+                               const char *prefix) {
+    if (trie && trie_count(trie) > 0) return trie_has_prefix(trie, prefix);
+    return avl_has_prefix(avl_root, prefix);
+}
+
+int autocomplete_session(AutocompleteSession *s, const RecordStore *store,
+                         const char *prefix, WordRecord *results, int top_k,
+                         AutocompleteFn query, void *arg) {
+    DictKey key;
+    int     len, from, i, n;
+
+    dict_key_init(&key, prefix);
+    len = (int)strlen(key.text);
+    if (top_k > TOP_K_MAX) top_k = TOP_K_MAX;
+    if (len == 0 || top_k <= 0) return query(key.text, results, top_k, arg);
+
+    if (top_k != s->top_k) autocomplete_session_reset(s);
+    session_follow(s, &key, len);
+    s->top_k = top_k;
+
+    if (s->n[len] < 0) {
+        for (from = len - 1; from > 0 && s->n[from] < 0; from--)
+            ;
+        if (session_dead(s, len)) {
+            s->n[len] = 0;                 /* nothing starts with it */
+        } else if (from > 0 && s->n[from] < top_k) {
+            /* That level holds every match of its prefix, best first, so
+               the longer prefix's results are a filter of it */
+            for (i = 0, n = 0; i < s->n[from]; i++)
+                if (str_key_ncmp(s->best[from][i]->word, key.text, (size_t)len) == 0)
+                    s->best[len][n++] = s->best[from][i];
+            s->n[len] = n;
+        } else {
+            n = query(key.text, results, top_k, arg);
+            if (!session_store(s, store, len, results, n)) return n;
+        }
+    }
+
+    if (s->n[len] < top_k) s->count[len] = s->n[len];   /* every match */
+
+    for (i = 0; i < s->n[len]; i++) results[i] = *s->best[len][i];
+    return s->n[len];
+}
+
+int autocomplete_session_count(AutocompleteSession *s, AVLNode *avl_root,
+                               const char *prefix) {
+    DictKey key;
+    int     len;
+
+    dict_key_init(&key, prefix);
+    len = (int)strlen(key.text);
+    if (len == 0) return avl_count(avl_root);
+    session_follow(s, &key, len);
+
+    if (s->count[len] < 0) {
+        if (session_dead(s, len - 1))
+            s->count[len] = 0;
+        else if (s->n[len] >= 0 && s->n[len] < s->top_k)
+            s->count[len] = s->n[len];     /* the level holds every match */
+        else
+            s->count[len] = autocomplete_prefix_count(avl_root, key.text);
+    }
+    return s->count[len];
 }
@@ -6,16 +6,33 @@
 #include "bst.h"
 #include "avl.h"
 #include "tbt.h"
+#include "trie.h"
+#include "bpt.h"
+#include "store.h"
+#include "boost.h"
 
 /*
  * Find up to top_k words that start with prefix, ranked by composite score:
- *   composite_score = frequency_score + (10 * user_select_count)
+ *   composite_score = frequency_score + decayed pick weight
+ * (word_record_score, dictionary.h)
+ * (equal scores alphabetically — see word_record_outranks).
  * Results are written into the caller-allocated results[top_k] array.
- * Returns the actual number of matches found (may be less than top_k).
+ * Returns the actual number of matches found (may be less than top_k);
+ * top_k is clamped to TOP_K_MAX.
+ *
+ * Matches stream through a bounded min-heap of top_k record pointers, so
+ * only the final results are copied and no candidate list is sorted.
+ * The heap and the traversals are one core generated from ranker.h,
+ * which other rankings can instantiate too.
  *
  * BST: recursive traversal with BST-pruning (O(log n + k) on average).
- * AVL: same recursive approach, O(log n + k) guaranteed.
+ * AVL: same recursive approach, plus subtree max-score pruning: subtrees
+ *      that cannot beat the current k-th result are never entered.
  * TBT: iterative via inorder thread pointers — zero call stack, zero recursion.
+ * B+:  one root-to-leaf descent to the first match, then a sequential
+ *      scan along the leaf chain — a few wide nodes, not one node per word.
+ * Trie: O(prefix length) descent to the prefix node, then its cached
+ *       top-k list is read directly (top_k <= TRIE_TOPK) — no walk, no sort.
  */
 int autocomplete_bst(BSTNode *root,   const char *prefix,
                      WordRecord *results, int top_k);
@@ -26,14 +43,188 @@ int autocomplete_avl(AVLNode *root,   const char *prefix,
 int autocomplete_tbt(TBTNode *header, const char *prefix,
                      WordRecord *results, int top_k);
 
+int autocomplete_bpt(const BPTree *tree, const char *prefix,
+                     WordRecord *results, int top_k);
+
+int autocomplete_trie(const Trie *trie, const char *prefix,
+                      WordRecord *results, int top_k);
+
+/*
+ * The trie's top_k completions of prefix as one user sees them: each
+ * word's score plus what that user's boosts add (boost.h).  The shared
+ * cached answer is re-scored and merged with the boosted words under
+ * the prefix — O(k log B + boosted matches) for a table of B entries,
+ * no walk and nothing cached per user.  A NULL or empty table gives
+ * autocomplete_trie's answer.  store resolves the boosted words.
+ */
+int autocomplete_trie_boosted(const Trie *trie, const RecordStore *store,
+                              const BoostTable *boosts, const char *prefix,
+                              WordRecord *results, int top_k);
+
+/*
+ * Prefix hints, for a UI to show before or beside the completions:
+ * how many words start with prefix (any case; "" counts them all), in
+ * O(log n + prefix length) from the AVL's subtree sizes, and whether
+ * any does.  The existence test reads the trie when one is passed (it
+ * must hold the same words as the AVL): an O(prefix length) descent
+ * that walks no edge past the prefix; otherwise it is one O(log n)
+ * descent of the AVL.  Front ends ask it before a query, so a prefix
+ * nothing starts with costs no ranking and no cache slot.
+ */
+int autocomplete_prefix_count(AVLNode *avl_root, const char *prefix);
+
+int autocomplete_prefix_exists(AVLNode *avl_root, const Trie *trie,
+                               const char *prefix);
+
+/*
+ * Batched autocomplete: the top_k completions of each of count prefixes,
+ * the same answers the single-query call for that tree gives.  Prefix
+ * i's results go to results[i * top_k ...] (so results holds count *
+ * top_k records) and their number to counts[i].
+ *
+ * The prefixes are normalised and sorted first, so one traversal serves
+ * many of them and equal prefixes are answered once:
+ * BST/AVL: up to AC_BATCH_CHUNK neighbouring prefixes share one descent;
+ *          each node is read once for all of them and split into the
+ *          ones that go left, right or both (the AVL keeps its per-prefix
+ *          max-score pruning).
+ * TBT/B+:  one forward walk along the threads / leaf chain, feeding each
+ *          word to every open prefix it matches (nested prefixes such as
+ *          "a", "ab", "abc" share the range); a root descent is only made
+ *          to jump a gap between ranges.
+ * Trie:    the queries run in sorted order, so consecutive descents
+ *          share the top of the trie.
+ * Returns 0, or -1 on malloc failure (counts is then unspecified).
+ * The index is only read: batches may run in parallel with each other
+ * and with other queries, not with writes.
+ */
+int autocomplete_batch_bst(BSTNode *root, const char *const *prefixes, int count,
+                           WordRecord *results, int *counts, int top_k);
+
+int autocomplete_batch_avl(AVLNode *root, const char *const *prefixes, int count,
+                           WordRecord *results, int *counts, int top_k);
+
+int autocomplete_batch_tbt(TBTNode *header, const char *const *prefixes, int count,
+                           WordRecord *results, int *counts, int top_k);
+
+int autocomplete_batch_bpt(const BPTree *tree, const char *const *prefixes, int count,
+                           WordRecord *results, int *counts, int top_k);
+
+int autocomplete_batch_trie(const Trie *trie, const char *const *prefixes, int count,
+                            WordRecord *results, int *counts, int top_k);
+
+/* A batch call with its index bound through arg (see AutocompleteFn). */
+typedef int (*AutocompleteBatchFn)(const char *const *prefixes, int count,
+                                   WordRecord *results, int *counts, int top_k,
+                                   void *arg);
+
+/*
+ * Split the batch into up to threads contiguous slices (at most
+ * AC_BATCH_THREADS_MAX) and run batch(slice, ..., arg) on each in its own
+ * thread, the first on the calling thread; a slice whose thread cannot be
+ * started runs on the caller.  Same output layout as the calls above.
+ * Returns 0, or -1 if any slice failed.
+ */
+int autocomplete_batch_parallel(AutocompleteBatchFn batch, void *arg,
+                                const char *const *prefixes, int count,
+                                WordRecord *results, int *counts, int top_k,
+                                int threads);
+
+/*
+ * AutocompleteSession - type-ahead state kept between keystrokes.
+ *
+ * The session follows the text being typed and keeps the ranked results
+ * of each prefix of it (record pointers, one level per prefix length):
+ *   - a backspace, or retyping a prefix already seen, is answered from
+ *     its level without a query;
+ *   - a level with fewer than top_k results holds every match of its
+ *     prefix, so any extension of it is a filter of those few records;
+ *   - otherwise the tree is queried once and the level is filled.
+ * A one-letter prefix is the costly query on the scanning trees (BST,
+ * TBT, B+ visit thousands of matches); it now runs once per word typed,
+ * not again on every backspace to it.  When the text leaves the old
+ * prefix, the levels past the common part are dropped.
+ *
+ * The session also memoises each level's match count
+ * (autocomplete_session_count).  A level whose count is 0 is a dead
+ * prefix: it and every extension of it are answered with nothing, from
+ * the count alone, so typing on after a miss costs no query at all.
+ *
+ * The levels borrow the records and their ranking: reset the session
+ * after any insert, delete, load or pick.
+ */
+typedef struct AutocompleteSession {
+    char        text[MAX_WORD_LEN];                /* normalised text followed   */
+    int         top_k;                             /* k the levels were ranked at */
+    int         n[MAX_WORD_LEN];                   /* results per prefix length;  */
+                                                   /* -1 if not cached            */
+    int         count[MAX_WORD_LEN];               /* matches per prefix length;  */
+                                                   /* -1 if not known             */
+    WordRecord *best[MAX_WORD_LEN][TOP_K_MAX];     /* best first                 */
+} AutocompleteSession;
+
+/* The query a session falls back to: any autocomplete_* call, with its
+   index bound through arg.  prefix is already normalised. */
+typedef int (*AutocompleteFn)(const char *prefix, WordRecord *results,
+                              int top_k, void *arg);
+
+/* Drop every cached level.  Also the initialiser: call before first use. */
+void autocomplete_session_reset(AutocompleteSession *s);
+
+/*
+ * Top-k completions of prefix, the same as query(prefix, ...) would
+ * return, taken from the session's levels where possible.  store maps
+ * the query's result copies back to records.  Returns the number of
+ * results.
+ */
+int autocomplete_session(AutocompleteSession *s, const RecordStore *store,
+                         const char *prefix, WordRecord *results, int top_k,
+                         AutocompleteFn query, void *arg);
+
+/*
+ * Number of words starting with prefix, memoised per level like the
+ * results: a count already known, a level that holds every match, or a
+ * dead shorter prefix answers without touching a tree; anything else is
+ * one autocomplete_prefix_count on avl_root.  Calling it moves the
+ * session to prefix, as autocomplete_session does.
+ */
+int autocomplete_session_count(AutocompleteSession *s, AVLNode *avl_root,
+                               const char *prefix);
+
+/*
+ * Count a pick of word without applying it yet (see store_add_pick):
+ * lock-free, so any number of threads holding only read access can
+ * call it at once.  Returns 1 if word is in the store, else 0.
+ */
+int autocomplete_count_selection(const char *word, RecordStore *store);
+
+/*
+ * Apply every pick counted so far: add them to user_select_count and
+ * bring the AVL max-score paths and the trie's cached top-k lists (trie
+ * may be NULL) up to date for each record that moved.  Needs exclusive
+ * access.  Returns the number of records re-ranked.
+ */
+int autocomplete_apply_selections(RecordStore *store, AVLNode *avl_root, Trie *trie);
+
+/*
+ * Move the ranking clock up to the current time and re-rank the records
+ * whose picks decayed since the store was last ranked (store_decay): O(1)
+ * unless the clock stepped, and then O(picked records * depth * K), never
+ * a whole-tree pass.  Call it before ranking — the front ends do so
+ * before each query.  Needs exclusive access.  Returns the number of
+ * records re-ranked; anything caching answers must then be dropped.
+ */
+int autocomplete_apply_decay(RecordStore *store, AVLNode *avl_root, Trie *trie);
+
 /*
- * Increment user_select_count for word in all three trees simultaneously.
+ * Increment user_select_count for word.
  * Call this when the user picks a suggestion from the autocomplete list.
  * This causes frequently selected words to rise in subsequent rankings.
+ * The record is shared by every index, so a single probe of the store's
+ * word index updates what every tree sees.  Counts the pick and applies
+ * it (with any others pending) in one go, for single-threaded callers.
  */
-void autocomplete_record_selection(const char *word,
-                                   BSTNode *bst_root,
-                                   AVLNode *avl_root,
-                                   TBTNode *tbt_header);
+void autocomplete_record_selection(const char *word, RecordStore *store,
+                                   AVLNode *avl_root, Trie *trie);
 
 #endif /* AUTOCOMPLETE_H */
@@ -3,168 +3,528 @@
 #include <stdlib.h>
 #include <string.h>
 #include "avl.h"
+#include "pool.h"
+#include "stats.h"
 #include "utils.h"
 
+/* Every AVLNode of every AVL tree comes from this pool (see pool.h) */
+static NodePool avl_pool = NODE_POOL_INIT(AVLNode);
+
 /* ── Static helpers ──────────────────────────────────────────── */
 
+#define HEIGHT_MASK  ((1u << AVL_HEIGHT_BITS) - 1)
+
+/* The node in a link (a pool slot), or NULL. */
+#define NODE(slot)  ((AVLNode *)pool_node(&avl_pool, (slot)))
+
 static int max_int(int a, int b) { return a > b ? a : b; }
 
-static void update_height(AVLNode *n) {
-    n->height = 1 + max_int(avl_height(n->left), avl_height(n->right));
+static int subtree_max(const AVLNode *n) { return n ? n->max_score : 0; }
+
+static int subtree_size(const AVLNode *n) {
+    return n ? (int)(n->size_height >> AVL_HEIGHT_BITS) : 0;
+}
+
+static int node_height(const AVLNode *n) {
+    return n ? (int)(n->size_height & HEIGHT_MASK) : 0;
+}
+
+static void set_shape(AVLNode *n, int size, int height) {
+    n->size_height = (uint32_t)size << AVL_HEIGHT_BITS | (uint32_t)height;
+}
+
+/* Recompute the augmented fields from the children. */
+static void update_node(AVLNode *n) {
+    const AVLNode *l = NODE(n->left), *r = NODE(n->right);
+    n->max_score = max_int(word_record_score(n->rec),
+                           max_int(subtree_max(l), subtree_max(r)));
+    set_shape(n, 1 + subtree_size(l) + subtree_size(r),
+              1 + max_int(node_height(l), node_height(r)));
+}
+
+static int balance_of(uint32_t slot) {
+    const AVLNode *n = NODE(slot);
+    return n ? node_height(NODE(n->left)) - node_height(NODE(n->right)) : 0;
 }
 
-static AVLNode *rotate_right(AVLNode *y) {
-    AVLNode *x  = y->left;
-    AVLNode *T2 = x->right;
-    x->right = y;
-    y->left  = T2;
-    update_height(y);   /* y is now lower — update first */
-    update_height(x);
-    return x;           /* new subtree root */
+/* Rotations take and return subtree roots as slots, the form links hold. */
+static uint32_t rotate_right(uint32_t ys) {
+    AVLNode *y  = NODE(ys);
+    uint32_t xs = y->left;
+    AVLNode *x  = NODE(xs);
+    STATS_INC(STAT_ROTATIONS);
+    y->left  = x->right;
+    x->right = ys;
+    update_node(y);     /* y is now lower — update first */
+    update_node(x);
+    return xs;          /* new subtree root */
 }
 
-static AVLNode *rotate_left(AVLNode *x) {
-    AVLNode *y  = x->right;
-    AVLNode *T2 = y->left;
-    y->left  = x;
-    x->right = T2;
-    update_height(x);   /* x is now lower — update first */
-    update_height(y);
-    return y;           /* new subtree root */
+static uint32_t rotate_left(uint32_t xs) {
+    AVLNode *x  = NODE(xs);
+    uint32_t ys = x->right;
+    AVLNode *y  = NODE(ys);
+    STATS_INC(STAT_ROTATIONS);
+    x->right = y->left;
+    y->left  = xs;
+    update_node(x);     /* x is now lower — update first */
+    update_node(y);
+    return ys;          /* new subtree root */
 }
 
-static AVLNode *rebalance(AVLNode *node) {
-    int bf = avl_balance_factor(node);
+static uint32_t rebalance(uint32_t slot) {
+    AVLNode *node = NODE(slot);
+    int      bf   = balance_of(slot);
 
     /* LL — left-heavy and left child is also left-heavy or balanced */
-    if (bf > 1 && avl_balance_factor(node->left) >= 0)
-        return rotate_right(node);
+    if (bf > 1 && balance_of(node->left) >= 0)
+        return rotate_right(slot);
 
     /* LR — left-heavy but left child is right-heavy */
-    if (bf > 1 && avl_balance_factor(node->left) < 0) {
+    if (bf > 1 && balance_of(node->left) < 0) {
         node->left = rotate_left(node->left);
-        return rotate_right(node);
+        return rotate_right(slot);
     }
 
     /* RR — right-heavy and right child is also right-heavy or balanced */
-    if (bf < -1 && avl_balance_factor(node->right) <= 0)
-        return rotate_left(node);
+    if (bf < -1 && balance_of(node->right) <= 0)
+        return rotate_left(slot);
 
     /* RL — right-heavy but right child is left-heavy */
-    if (bf < -1 && avl_balance_factor(node->right) > 0) {
+    if (bf < -1 && balance_of(node->right) > 0) {
         node->right = rotate_right(node->right);
-        return rotate_left(node);
+        return rotate_left(slot);
     }
 
-    return node;  /* already balanced */
+    return slot;  /* already balanced */
 }
 
-static AVLNode *avl_min_node(AVLNode *n) {
-    while (n->left) n = n->left;
-    return n;
+/*
+ * Links walked by an insert or delete, root first: path[i] points at the
+ * child link (or a copy of the caller's root) holding the i-th node, so
+ * a rotation there is one store.  An AVL tree of n nodes is at most
+ * 1.44 log2(n + 2) high, under 46 for any int-sized count.
+ */
+#define AVL_PATH_MAX  64
+
+typedef uint32_t *AVLLink;
+
+/* Rebalance the node at *l if it is out of balance (update_node done). */
+static void fix_link(AVLLink l) {
+    int bf = balance_of(*l);
+    if (bf > 1 || bf < -1) *l = rebalance(*l);
 }
 
-static AVLNode *avl_insert_impl(AVLNode *root, const WordRecord *rec) {
-    if (!root) return avl_new_node(rec);
+/* A new node's slot, for linking it. */
+static uint32_t new_slot(WordRecord *rec) {
+    return pool_slot(&avl_pool, avl_new_node(rec));
+}
+
+/* Midpoint build of recs[lo..hi]; equal-size halves satisfy the AVL
+   invariant without any rotation.  Returns the subtree's slot. */
+static uint32_t avl_build_range(WordRecord **recs, int lo, int hi) {
+    AVLNode *n;
+    uint32_t slot;
+    int      mid;
 
-    int cmp = strcmp(rec->word, root->data.word);
-    if      (cmp < 0) root->left  = avl_insert_impl(root->left,  rec);
-    else if (cmp > 0) root->right = avl_insert_impl(root->right, rec);
-    else              return root;  /* duplicate — skip */
+    if (lo > hi) return 0;
+    mid      = lo + (hi - lo) / 2;
+    slot     = new_slot(recs[mid]);
+    n        = NODE(slot);
+    n->left  = avl_build_range(recs, lo, mid - 1);
+    n->right = avl_build_range(recs, mid + 1, hi);
+    update_node(n);
+    return slot;
+}
 
-    update_height(root);
-    return rebalance(root);
+/* Give every node under slot back to the pool, children first. */
+static void free_subtree(uint32_t slot) {
+    AVLNode *n = NODE(slot);
+    if (!n) return;
+    free_subtree(n->left);
+    free_subtree(n->right);
+    pool_release(&avl_pool, n);
 }
 
-static AVLNode *avl_delete_impl(AVLNode *root, const char *word) {
+static AVLNode *avl_search_impl(AVLNode *root, const char *word) {
     if (!root) return NULL;
+    STATS_VISIT();
+    int cmp = str_key_cmp(word, root->rec->word);
+    if (cmp < 0) return avl_search_impl(NODE(root->left),  word);
+    if (cmp > 0) return avl_search_impl(NODE(root->right), word);
+    return root;
+}
+
+/* Re-derive max_score along the path to word, bottom-up. */
+static void avl_refresh_path(AVLNode *root, const char *word) {
+    int cmp;
+    if (!root) return;
+    STATS_VISIT();
+    cmp = str_key_cmp(word, root->rec->word);
+    if      (cmp < 0) avl_refresh_path(NODE(root->left),  word);
+    else if (cmp > 0) avl_refresh_path(NODE(root->right), word);
+    update_node(root);
+}
 
-    int cmp = strcmp(word, root->data.word);
-    if (cmp < 0) {
-        root->left  = avl_delete_impl(root->left,  word);
-    } else if (cmp > 0) {
-        root->right = avl_delete_impl(root->right, word);
-    } else {
-        /* Node to delete found */
-        if (!root->left || !root->right) {
-            /* 0 or 1 child case */
-            AVLNode *child = root->left ? root->left : root->right;
-            free(root);
-            return child;   /* NULL if leaf */
+/*
+ * Count the words w with strncmp(w, key, len) < 0, or <= 0 when
+ * inclusive is set.  Both sets are an inorder prefix of the tree, so one
+ * descent adding up left-subtree sizes finds their length.  With len set
+ * to strlen(key) + 1 this is plain rank; with len = strlen(prefix) and
+ * inclusive, it also counts every word that starts with the prefix.
+ */
+static int avl_rank_impl(const AVLNode *root, const char *key, size_t len,
+                         int inclusive) {
+    int rank = 0, cmp;
+    while (root) {
+        STATS_VISIT();
+        cmp = str_key_ncmp(root->rec->word, key, len);
+        if (cmp < 0 || (inclusive && cmp == 0)) {
+            rank += subtree_size(NODE(root->left)) + 1;
+            root  = NODE(root->right);
+        } else {
+            root  = NODE(root->left);
         }
-        /* 2 children: replace with inorder successor, then delete successor */
-        AVLNode *succ = avl_min_node(root->right);
-        root->data    = succ->data;
-        root->right   = avl_delete_impl(root->right, succ->data.word);
     }
+    return rank;
+}
 
-    update_height(root);
-    return rebalance(root);
+/* A child of n: the left one if left is set, else the right one. */
+static AVLNode *child(const AVLNode *n, int left) {
+    return NODE(left ? n->left : n->right);
 }
 
-static AVLNode *avl_search_impl(AVLNode *root, const char *word) {
-    if (!root) return NULL;
-    int cmp = strcmp(word, root->data.word);
-    if (cmp < 0) return avl_search_impl(root->left,  word);
-    if (cmp > 0) return avl_search_impl(root->right, word);
-    return root;
+/* Push n and then its extreme descendants on one side (left: smallest,
+   right: largest word below n) onto c.  Returns the last node pushed. */
+static AVLNode *cursor_dive(AVLCursor *c, AVLNode *n, int left) {
+    for (; n; n = child(n, left))
+        c->path[c->depth++] = n;
+    return c->path[c->depth - 1];
+}
+
+/* Step c one word forward (left == 0) or back (left == 1). */
+static AVLNode *cursor_step(AVLCursor *c, int left) {
+    AVLNode *n, *from;
+    if (c->depth == 0) return NULL;
+    n = c->path[c->depth - 1];
+    /* A subtree on that side holds the neighbour: its nearest word */
+    if (child(n, left))
+        return cursor_dive(c, child(n, left), !left);
+    /* Otherwise it is the first ancestor we reach from the other side */
+    do {
+        from = c->path[--c->depth];
+        if (c->depth == 0) return NULL;
+        n = c->path[c->depth - 1];
+    } while (child(n, left) == from);
+    return n;
+}
+
+/* Count every node under n, n itself at depth d.  Recursion is as deep
+   as the tree, which stays under 1.45 log2(n). */
+static void avl_shape_impl(const AVLNode *n, int d, TreeShape *s) {
+    for (; n; n = NODE(n->right), d++) {
+        shape_add(s, d, d);
+        avl_shape_impl(NODE(n->left), d + 1, s);
+    }
 }
 
 /* ── Public API ──────────────────────────────────────────────── */
 
-AVLNode *avl_new_node(const WordRecord *rec) {
-    AVLNode *n = (AVLNode *)malloc(sizeof(AVLNode));
+AVLNode *avl_new_node(WordRecord *rec) {
+    AVLNode *n = (AVLNode *)pool_alloc(&avl_pool);
     if (!n) { perror("avl_new_node: malloc"); exit(EXIT_FAILURE); }
-    n->data   = *rec;
-    n->left   = NULL;
-    n->right  = NULL;
-    n->height = 1;
+    n->rec       = rec;
+    n->left      = 0;
+    n->right     = 0;
+    n->max_score = word_record_score(rec);
+    set_shape(n, 1, 1);
     return n;
 }
 
-AVLNode *avl_insert(AVLNode *root, const WordRecord *rec) {
-    char buf[MAX_WORD_LEN];
-    WordRecord r = *rec;
-    str_tolower(buf, rec->word, sizeof(buf));
-    str_safe_copy(r.word, buf, sizeof(r.word));
-    return avl_insert_impl(root, &r);
+AVLNode *avl_left(const AVLNode *n)  { return n ? NODE(n->left)  : NULL; }
+AVLNode *avl_right(const AVLNode *n) { return n ? NODE(n->right) : NULL; }
+
+/*
+ * Iterative insert.  The descent records the path; the climb back
+ * recomputes each node and rotates where needed, but only until a
+ * subtree's height comes out unchanged — after one rotation it always
+ * does.  Above that point no balance can change, so the rest of the path
+ * only gains one in size and, perhaps, a higher max_score.
+ */
+AVLNode *avl_insert(AVLNode *root, WordRecord *rec) {
+    uint32_t top = pool_slot(&avl_pool, root);
+    AVLLink  path[AVL_PATH_MAX], link = &top;
+    AVLNode *n;
+    int      depth = 0, cmp, score, h;
+
+    if (!rec || subtree_size(root) >= AVL_SIZE_MAX) return root;
+    while (*link) {
+        n = NODE(*link);
+        STATS_VISIT();
+        cmp = str_key_cmp(rec->word, n->rec->word);
+        if (cmp == 0) return root;      /* duplicate — skip */
+        path[depth++] = link;
+        link = cmp < 0 ? &n->left : &n->right;
+    }
+    *link = new_slot(rec);
+
+    while (depth > 0) {
+        link = path[--depth];
+        h    = node_height(NODE(*link));
+        update_node(NODE(*link));
+        fix_link(link);
+        if (node_height(NODE(*link)) == h) break;
+    }
+    score = word_record_score(rec);
+    while (depth > 0) {
+        n = NODE(*path[--depth]);
+        n->size_height += 1u << AVL_HEIGHT_BITS;
+        if (score > n->max_score) n->max_score = score;
+    }
+    return NODE(top);
+}
+
+AVLNode *avl_build_from_sorted(WordRecord **recs, int n) {
+    if (!recs || n <= 0) return NULL;
+    if (n > AVL_SIZE_MAX) n = AVL_SIZE_MAX;
+    return NODE(avl_build_range(recs, 0, n - 1));
 }
 
 AVLNode *avl_search(AVLNode *root, const char *word) {
-    char buf[MAX_WORD_LEN];
-    str_tolower(buf, word, sizeof(buf));
-    return avl_search_impl(root, buf);
+    DictKey key;
+    dict_key_init(&key, word);
+    return avl_search_impl(root, key.text);
+}
+
+AVLNode *avl_search_normalized(AVLNode *root, const DictKey *key) {
+    if (!key) return NULL;
+    return avl_search_impl(root, key->text);
 }
 
+/*
+ * Iterative delete, on the same path stack as avl_insert.  A node with
+ * two children takes its inorder successor's record, and the successor
+ * (no left child) is the node unlinked.  The climb rebalances until a
+ * subtree's height is unchanged, then recomputes max_score only until it
+ * stops changing, and from there just shrinks the sizes.  That last cut
+ * needs every subtree above to have lost the same record, so it waits
+ * until the climb is past the successor's path, which lost another.
+ */
 AVLNode *avl_delete(AVLNode *root, const char *word) {
-    char buf[MAX_WORD_LEN];
+    char     buf[MAX_WORD_LEN];
+    uint32_t top = pool_slot(&avl_pool, root);
+    AVLLink  path[AVL_PATH_MAX], link = &top;
+    AVLNode *n, *gone;
+    int      depth = 0, mark, cmp, h, m;
+
+    if (!word) return root;
     str_tolower(buf, word, sizeof(buf));
-    return avl_delete_impl(root, buf);
+    while (*link) {
+        n = NODE(*link);
+        STATS_VISIT();
+        cmp = str_key_cmp(buf, n->rec->word);
+        if (cmp == 0) break;
+        path[depth++] = link;
+        link = cmp < 0 ? &n->left : &n->right;
+    }
+    if (!*link) return root;            /* not in the tree */
+
+    n    = NODE(*link);
+    mark = depth;                       /* from path[mark] up, the deleted record is gone */
+    if (n->left && n->right) {
+        path[depth++] = link;
+        for (link = &n->right; NODE(*link)->left; link = &NODE(*link)->left)
+            path[depth++] = link;
+        n->rec = NODE(*link)->rec;      /* take over the successor's record */
+    }
+    gone  = NODE(*link);
+    *link = gone->left ? gone->left : gone->right;
+    pool_release(&avl_pool, gone);
+
+    while (depth > 0) {
+        link = path[--depth];
+        h    = node_height(NODE(*link));
+        update_node(NODE(*link));
+        fix_link(link);
+        if (node_height(NODE(*link)) == h) break;
+    }
+    while (depth > 0) {
+        n = NODE(*path[--depth]);
+        n->size_height -= 1u << AVL_HEIGHT_BITS;
+        m = max_int(word_record_score(n->rec),
+                    max_int(subtree_max(NODE(n->left)), subtree_max(NODE(n->right))));
+        if (m == n->max_score && depth <= mark) break;
+        n->max_score = m;
+    }
+    while (depth > 0) NODE(*path[--depth])->size_height -= 1u << AVL_HEIGHT_BITS;
+    return NODE(top);
+}
+
+void avl_score_changed(AVLNode *root, const WordRecord *rec) {
+    if (!rec) return;
+    avl_refresh_path(root, rec->word);
+}
+
+void avl_rescore(AVLNode *root) {
+    if (!root) return;
+    avl_rescore(NODE(root->left));
+    avl_rescore(NODE(root->right));
+    update_node(root);
 }
 
 void avl_inorder(AVLNode *root, void (*callback)(AVLNode *, void *), void *arg) {
     if (!root) return;
-    avl_inorder(root->left, callback, arg);
+    avl_inorder(NODE(root->left), callback, arg);
     callback(root, arg);
-    avl_inorder(root->right, callback, arg);
+    avl_inorder(NODE(root->right), callback, arg);
 }
 
 void avl_free(AVLNode **root) {
     if (!root || !*root) return;
-    avl_free(&(*root)->left);
-    avl_free(&(*root)->right);
-    free(*root);
+    free_subtree((*root)->left);
+    free_subtree((*root)->right);
+    pool_release(&avl_pool, *root);
     *root = NULL;
 }
 
+void avl_pool_reset(void) {
+    pool_reset(&avl_pool);
+}
+
+void avl_pool_destroy(void) {
+    pool_destroy(&avl_pool);
+}
+
 int avl_height(AVLNode *node) {
-    return node ? node->height : 0;
+    return node_height(node);
 }
 
 int avl_balance_factor(AVLNode *node) {
-    return node ? avl_height(node->left) - avl_height(node->right) : 0;
+    return node ? node_height(NODE(node->left)) - node_height(NODE(node->right)) : 0;
+}
+
+void avl_shape(AVLNode *root, TreeShape *s) {
+    avl_shape_impl(root, 1, s);
 }
 
 int avl_count(AVLNode *root) {
-    return root ? 1 + avl_count(root->left) + avl_count(root->right) : 0;
+    return subtree_size(root);
+}
+
+void avl_memory(AVLNode *root, MemUsage *u) {
+    MemUsage pool;
+    size_t   n = (size_t)avl_count(root);
+
+    mem_usage_clear(&pool);
+    pool_memory(&avl_pool, &pool);
+    u->node_bytes     += n * sizeof(AVLNode);
+    u->overhead_bytes += pool.overhead_bytes;
+    u->index_bytes    += pool.index_bytes;
+    u->entries        += n;
+}
+
+int avl_rank(AVLNode *root, const char *word) {
+    DictKey key;
+    if (!word) return 0;
+    dict_key_init(&key, word);
+    return avl_rank_impl(root, key.text, strlen(key.text) + 1, 0);
+}
+
+AVLNode *avl_select(AVLNode *root, int i) {
+    int left;
+    if (i < 0) return NULL;
+    while (root) {
+        left = subtree_size(NODE(root->left));
+        if      (i < left)  root = NODE(root->left);
+        else if (i == left) return root;
+        else { i -= left + 1; root = NODE(root->right); }
+    }
+    return NULL;
+}
+
+int avl_count_prefix(AVLNode *root, const char *prefix) {
+    DictKey key;
+    size_t  len;
+    if (!prefix) return 0;
+    dict_key_init(&key, prefix);
+    len = strlen(key.text);
+    if (len == 0) return subtree_size(root);
+    /* Words before the prefix block vs. words up to its end */
+    return avl_rank_impl(root, key.text, len, 1) -
+           avl_rank_impl(root, key.text, len + 1, 0);
+}
+
+/* A node whose word sorts before the prefix block has every match to
+   its right, one after it every match to its left. */
+int avl_has_prefix(AVLNode *root, const char *prefix) {
+    DictKey key;
+    size_t  len;
+    int     cmp;
+
+    if (!prefix) return 0;
+    dict_key_init(&key, prefix);
+    len = strlen(key.text);
+    while (root) {
+        STATS_VISIT();
+        cmp = str_key_ncmp(root->rec->word, key.text, len);
+        if (cmp == 0) return 1;
+        root = cmp > 0 ? NODE(root->left) : NODE(root->right);
+    }
+    return 0;
+}
+
+AVLNode *avl_lower_bound(AVLNode *root, const char *word, AVLCursor *c) {
+    DictKey key;
+    int     found = 0;
+
+    dict_key_init(&key, word);
+    c->depth = 0;
+    /* The answer is the last node we turned left at; the path down to it
+       is a prefix of the search path */
+    while (root) {
+        c->path[c->depth++] = root;
+        STATS_VISIT();
+        if (str_key_cmp(root->rec->word, key.text) >= 0) {
+            found = c->depth;
+            root  = NODE(root->left);
+        } else {
+            root  = NODE(root->right);
+        }
+    }
+    c->depth = found;
+    return avl_cursor_node(c);
+}
+
+AVLNode *avl_first(AVLNode *root, AVLCursor *c) {
+    c->depth = 0;
+    return root ? cursor_dive(c, root, 1) : NULL;
+}
+
+AVLNode *avl_last(AVLNode *root, AVLCursor *c) {
+    c->depth = 0;
+    return root ? cursor_dive(c, root, 0) : NULL;
+}
+
+AVLNode *avl_cursor_next(AVLCursor *c) { return cursor_step(c, 0); }
+AVLNode *avl_cursor_prev(AVLCursor *c) { return cursor_step(c, 1); }
+
+AVLNode *avl_cursor_node(const AVLCursor *c) {
+    return c->depth > 0 ? c->path[c->depth - 1] : NULL;
+}
+
+int avl_range(AVLNode *root, const char *lo, const char *hi, int limit,
+              void (*callback)(AVLNode *, void *), void *arg) {
+    AVLCursor c;
+    DictKey   end;
+    AVLNode  *n;
+    int       visited = 0;
+
+    if (hi) dict_key_init(&end, hi);
+    n = lo ? avl_lower_bound(root, lo, &c) : avl_first(root, &c);
+    for (; n && visited != limit; n = avl_cursor_next(&c)) {
+        if (hi && str_key_cmp(n->rec->word, end.text) >= 0) break;
+        callback(n, arg);
+        visited++;
+    }
+    return visited;
 }
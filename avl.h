@@ -2,53 +2,178 @@
 #ifndef AVL_H
 #define AVL_H
 
+#include <stdint.h>
 #include "dictionary.h"
+#include "memusage.h"
+#include "shape.h"
 
 /*
  * AVLNode - a node in the self-balancing AVL tree.
  *
- * Extends BST with a 'height' field. Balance factor = height(left) - height(right);
- * AVL invariant keeps this in {-1, 0, +1} via rotations on insert/delete.
+ * A compact 24-byte node: the record pointer, the two children as 32-bit
+ * slots in the AVL node pool (pool.h, 0 for none), max_score, and one
+ * word packing the subtree size above a 6-bit height.  Walk the links with
+ * avl_left / avl_right.  Balance factor = height(left) - height(right);
+ * the AVL invariant keeps this in {-1, 0, +1} via rotations on
+ * insert/delete.
  *
  * Storing height (not balance factor directly) makes rotation updates O(1):
  * after a rotation, recalculate height from children without extra traversal.
  *
+ * Each node also carries max_score, the highest word_record_score in its
+ * subtree, so ranked prefix search can skip every subtree that cannot
+ * beat the current k-th result (see autocomplete_avl).  It is maintained
+ * by insert, delete and rotations; after changing a record's score call
+ * avl_score_changed (one record) or avl_rescore (bulk update).
+ *
+ * 'size' counts the nodes in the subtree, so the tree is also an
+ * order-statistic tree: avl_count is O(1), and rank, select and
+ * prefix-count queries are a single O(log n) descent.
+ *
+ * Linking by slot rather than by pointer, and sharing a word between
+ * height and size, keeps a node at 24 bytes instead of 40, so more of the
+ * tree fits in each cache line.  Six height bits cover any AVL tree of up
+ * to AVL_SIZE_MAX nodes, which is as many as a tree holds (further
+ * inserts are refused).
+ *
  * IMPORTANT: avl_insert returns the new subtree root (unlike bst_insert which
  * uses a double pointer). Callers must capture the return value:
  *   g_avl_root = avl_insert(g_avl_root, &rec);
  */
+#define AVL_HEIGHT_BITS  6
+#define AVL_SIZE_MAX     ((1 << (32 - AVL_HEIGHT_BITS)) - 1)
+
 typedef struct AVLNode {
-    WordRecord       data;    /* embedded record payload      */
-    struct AVLNode  *left;    /* left child                   */
-    struct AVLNode  *right;   /* right child                  */
-    int              height;  /* height of this node (leaf=1) */
+    WordRecord *rec;          /* shared record (store-owned)              */
+    uint32_t    left;         /* left child's pool slot, 0 for none       */
+    uint32_t    right;        /* right child's pool slot, 0 for none      */
+    int         max_score;    /* best word_record_score in subtree        */
+    uint32_t    size_height;  /* nodes in subtree << AVL_HEIGHT_BITS |
+                                 height of this node (leaf=1)             */
 } AVLNode;
 
+/* The left / right child of n, or NULL. */
+AVLNode *avl_left(const AVLNode *n);
+AVLNode *avl_right(const AVLNode *n);
+
 /* Allocate and initialise a new AVL node with height = 1. Returns NULL on failure. */
-AVLNode *avl_new_node(const WordRecord *rec);
+AVLNode *avl_new_node(WordRecord *rec);
+
+/* Insert rec (referenced, not copied; word already lowercase), rebalancing
+   as needed. Returns new root of subtree.  Iterative, on a path stack:
+   the climb back stops rebalancing once a subtree's height is unchanged. */
+AVLNode *avl_insert(AVLNode *root, WordRecord *rec);
 
-/* Insert rec, rebalancing as needed. Returns new root of subtree. */
-AVLNode *avl_insert(AVLNode *root, const WordRecord *rec);
+/* Build a perfectly balanced AVL tree over recs[0..n), sorted by word
+   with no duplicates, in O(n) — no rotations.  Returns the new root. */
+AVLNode *avl_build_from_sorted(WordRecord **recs, int n);
 
 /* Search for word. Returns pointer to matching node, or NULL. */
 AVLNode *avl_search(AVLNode *root, const char *word);
 
-/* Delete word, rebalancing as needed. Returns new root of subtree. */
+/* Search for an already-normalised key (no lowercasing per call). */
+AVLNode *avl_search_normalized(AVLNode *root, const DictKey *key);
+
+/* Delete word, rebalancing as needed. Returns new root of subtree.
+   Iterative, like avl_insert. */
 AVLNode *avl_delete(AVLNode *root, const char *word);
 
+/* Re-derive max_score on the path to rec after its score changed. O(log n). */
+void avl_score_changed(AVLNode *root, const WordRecord *rec);
+
+/* Re-derive max_score for every node, e.g. after a frequency reload. O(n). */
+void avl_rescore(AVLNode *root);
+
 /* In-order traversal: calls callback(node, arg) for each node. */
 void avl_inorder(AVLNode *root, void (*callback)(AVLNode *, void *), void *arg);
 
-/* Free all nodes recursively. Sets *root to NULL. */
+/* Free all nodes recursively (records stay in their store). Sets *root to NULL.
+   Nodes go back to the AVL node pool, not to the C library. */
 void avl_free(AVLNode **root);
 
+/* Drop every node of every AVL tree at once in O(slabs), keeping the
+   slabs for reuse. All AVLNode pointers become invalid. */
+void avl_pool_reset(void);
+
+/* Like avl_pool_reset, but also returns the slab memory (use at exit). */
+void avl_pool_destroy(void);
+
 /* Return height of node (0 for NULL). */
 int avl_height(AVLNode *node);
 
 /* Return balance factor of node: height(left) - height(right). Safe for NULL (returns 0). */
 int avl_balance_factor(AVLNode *node);
 
-/* Return total number of nodes. */
+/* Return total number of nodes. O(1). */
 int avl_count(AVLNode *root);
 
+/* Add every node's depth to s (shape.h). */
+void avl_shape(AVLNode *root, TreeShape *s);
+
+/* Add the tree to u (memusage.h): its nodes, plus the spare slots and
+   slab table of the pool every AVL tree shares (normally there is one). */
+void avl_memory(AVLNode *root, MemUsage *u);
+
+/* Return how many words sort strictly before word (its 0-based position
+   if present). O(log n). */
+int avl_rank(AVLNode *root, const char *word);
+
+/* Return the node at 0-based inorder position i, or NULL if i is out of
+   range. O(log n). */
+AVLNode *avl_select(AVLNode *root, int i);
+
+/* Return how many words start with prefix (case-insensitive; the empty
+   prefix matches everything). O(log n + prefix length). */
+int avl_count_prefix(AVLNode *root, const char *prefix);
+
+/* Return 1 if any word starts with prefix (case-insensitive), else 0:
+   one root-to-leaf descent, stopping at the first match.  O(log n). */
+int avl_has_prefix(AVLNode *root, const char *prefix);
+
+/*
+ * AVLCursor - a position in the tree's sorted order, for range and
+ * window queries ("words from X to Y", "the 50 words before X").
+ *
+ * Nodes have no parent pointers, so the cursor keeps the path from the
+ * root down to its node; a step either way is amortised O(1) and at worst
+ * O(log n), and seeking is one O(log n) descent, so k words around any
+ * position cost O(log n + k).  AVL_CURSOR_DEPTH frames cover any AVL
+ * tree that fits in memory (height <= 1.44 log2 n).
+ *
+ * Stepping off either end leaves the cursor empty (every step then
+ * returns NULL); seek again to reuse it.  Any insert or delete in the
+ * tree invalidates its cursors.
+ */
+#define AVL_CURSOR_DEPTH  64
+
+typedef struct AVLCursor {
+    AVLNode *path[AVL_CURSOR_DEPTH];  /* root .. current node           */
+    int      depth;                   /* frames in use; 0 when empty    */
+} AVLCursor;
+
+/* Position c at the first word >= word (case-insensitive) and return
+   it, or NULL (c empty) if every word sorts before word. O(log n). */
+AVLNode *avl_lower_bound(AVLNode *root, const char *word, AVLCursor *c);
+
+/* Position c at the smallest / largest word; NULL for an empty tree. */
+AVLNode *avl_first(AVLNode *root, AVLCursor *c);
+AVLNode *avl_last(AVLNode *root, AVLCursor *c);
+
+/* Move c to the next / previous word and return it, or NULL (c empty)
+   past the end. */
+AVLNode *avl_cursor_next(AVLCursor *c);
+AVLNode *avl_cursor_prev(AVLCursor *c);
+
+/* The node under c, or NULL if c is empty. */
+AVLNode *avl_cursor_node(const AVLCursor *c);
+
+/*
+ * Call callback(node, arg) for each word w with lo <= w < hi in sorted
+ * order (case-insensitive; lo NULL: from the first word, hi NULL: to the
+ * last), stopping after limit words if limit >= 0.  Returns the number
+ * visited.  O(log n + visited).
+ */
+int avl_range(AVLNode *root, const char *lo, const char *hi, int limit,
+              void (*callback)(AVLNode *, void *), void *arg);
+
 #endif /* AVL_H */
@@ -1,29 +1,156 @@
 /* benchmark.c - Performance benchmarking and comparison (Phase 7) */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L   /* clock_gettime under -std=c99 */
+#endif
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
 #include "benchmark.h"
+#include "histogram.h"
+#include "memusage.h"
+#include "shape.h"
+#include "querylog.h"
 #include "dictionary.h"
+#include "autocomplete.h"
+#include "bktree.h"
+#include "suffix.h"
+#include "dawg.h"
+#include "store.h"
+#include "trie.h"
+#include "wbst.h"
+#include "loader.h"
+#include "snapshot.h"
+#include "packed.h"
+#include "shard.h"
+#include "config.h"
 #include "utils.h"
 
 /* Number of search repetitions per trial — large enough to get measurable time */
 #define BENCH_SEARCH_REPS  1000
 
+/* Prefix queries per trial; each prefix "wdNNN" matches up to 100 words */
+#define BENCH_PREFIX_REPS  1000
+
+/* Edit-distance bound for the fuzzy-suggestion trial */
+#define BENCH_FUZZY_DIST   FUZZY_MAX_DIST
+
 /* Dataset sizes to benchmark */
 static const int BENCH_SIZES[] = { 500, 2000, 5000 };
 #define NUM_SIZES  3
 
+/* Scale trial sizes: the structures a full dictionary load uses */
+static const int BENCH_SCALE_SIZES[] = { 1000000, 2000000 };
+#define NUM_SCALE_SIZES  2
+
 /* ── Null traversal callbacks (traverse without printing) ────── */
 static void null_bst(BSTNode *n, void *a) { (void)n; (void)a; }
 static void null_avl(AVLNode *n, void *a) { (void)n; (void)a; }
 static void null_tbt(TBTNode *n, void *a) { (void)n; (void)a; }
+static void null_bpt(WordRecord *r, void *a) { (void)r; (void)a; }
 
 /* ── Helpers ─────────────────────────────────────────────────── */
 
-/* Milliseconds elapsed since start */
-static double ms_since(clock_t start) {
-    return (double)(clock() - start) * 1000.0 / (double)CLOCKS_PER_SEC;
+/* Run call, counting the nanoseconds it took in hist (a LatencyHist *) */
+#define BENCH_TIMED(hist, call)                              \
+    do {                                                     \
+        uint64_t bench_t0_ = bench_now_ns();                 \
+        call;                                                \
+        hist_record((hist), bench_now_ns() - bench_t0_);     \
+    } while (0)
+
+/* Milliseconds elapsed since start (a bench_now_ns reading) */
+static double ms_since(uint64_t start) {
+    return (double)(bench_now_ns() - start) / 1e6;
+}
+
+/* ── Results ─────────────────────────────────────────────────── */
+
+/* Record one measurement; dropped silently if out of memory (the
+   caller's table then shows the row as missing). */
+static void put(BenchResults *r, int words, const char *backend, const char *metric,
+                double value, int lower_better) {
+    BenchResult *e;
+    if (r->count == r->cap) {
+        int          cap   = r->cap ? r->cap * 2 : 128;
+        BenchResult *grown = (BenchResult *)realloc(r->items,
+                                                    (size_t)cap * sizeof(BenchResult));
+        if (!grown) return;
+        r->items = grown;
+        r->cap   = cap;
+    }
+    e = &r->items[r->count++];
+    e->words = words;
+    snprintf(e->backend, sizeof(e->backend), "%s", backend);
+    snprintf(e->metric,  sizeof(e->metric),  "%s", metric);
+    e->value        = value;
+    e->lower_better = lower_better;
+}
+
+/* A timing or a size: a rise is a regression */
+static void put_cost(BenchResults *r, int words, const char *backend,
+                     const char *metric, double value) {
+    put(r, words, backend, metric, value, 1);
+}
+
+/* A height or a count: reported, never compared */
+static void put_info(BenchResults *r, int words, const char *backend,
+                     const char *metric, double value) {
+    put(r, words, backend, metric, value, 0);
+}
+
+static const BenchResult *find_result(const BenchResults *r, int words,
+                                      const char *backend, const char *metric) {
+    int i;
+    for (i = 0; i < r->count; i++)
+        if (r->items[i].words == words && strcmp(r->items[i].backend, backend) == 0 &&
+            strcmp(r->items[i].metric, metric) == 0)
+            return &r->items[i];
+    return NULL;
+}
+
+/* Growing text for benchmark_results_text */
+typedef struct TextBuf {
+    char  *s;
+    size_t len;
+    size_t cap;
+    int    failed;
+} TextBuf;
+
+static void tb_printf(TextBuf *b, const char *fmt, ...) {
+    va_list ap;
+    int     n;
+
+    if (b->failed) return;
+    va_start(ap, fmt);
+    n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0) { b->failed = 1; return; }
+    if (b->len + (size_t)n + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap * 2 : 4096;
+        char  *grown;
+        while (cap < b->len + (size_t)n + 1) cap *= 2;
+        grown = (char *)realloc(b->s, cap);
+        if (!grown) { b->failed = 1; return; }
+        b->s   = grown;
+        b->cap = cap;
+    }
+    va_start(ap, fmt);
+    vsnprintf(b->s + b->len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    b->len += (size_t)n;
+}
+
+static void tb_rule(TextBuf *b, char ch, int width) {
+    int i;
+    tb_printf(b, "  ");
+    for (i = 0; i < width; i++) tb_printf(b, "%c", ch);
+    tb_printf(b, "\n");
 }
 
 /*
@@ -38,7 +165,7 @@ static void gen_words(WordRecord *arr, int n) {
     for (i = 0; i < n; i++) {
         word_record_init(&arr[i]);
         sprintf(arr[i].word, "wd%05d", i + 1);   /* wd00001 … wd05000 */
-        str_safe_copy(arr[i].part_of_speech, "noun", sizeof(arr[i].part_of_speech));
+        arr[i].part_of_speech = "noun";
         arr[i].frequency_score = 1 + (i % 100);
     }
 
@@ -52,138 +179,1792 @@ static void gen_words(WordRecord *arr, int n) {
     }
 }
 
+/* Quick-comparison columns and their names in the results */
+static const char *const QUICK_TREE[4] = { "BST", "AVL", "TBT", "B+" };
+
+/* Bytes per entry of an index's own layout (the records are the
+   store's): nodes, strings and index, without the spare pool slots.
+   The BST, AVL and TBT share their pools with whatever tree of the type
+   was built before, so their slack says more about the run order than
+   about the structure. */
+static double layout_bytes(const MemUsage *u) {
+    return u->entries ? (double)(u->node_bytes + u->string_bytes + u->index_bytes) /
+                        (double)u->entries
+                      : 0.0;
+}
+
 /*
  * Run one benchmark trial for a dataset of n words.
- * Prints a 4-row result block (insert, height, search, traverse).
+ * Records 11 metrics per tree (insert, height, average depth, compares
+ * per hit, search, prefix, their p99 per call, prefix batch, traverse,
+ * bytes per entry).
  */
-static void bench_one(int n) {
+static void bench_one(int n, BenchResults *res) {
     WordRecord *words;
+    WordRecord  found[TOP_K_DEFAULT];
+    WordRecord *batch_res;
+    int        *batch_cnt;
+    char      (*batch_buf)[16];
+    const char **batch_pfx;
     BSTNode    *bst = NULL;
     AVLNode    *avl = NULL;
     TBTNode    *tbt = NULL;
-    char        wbuf[MAX_WORD_LEN];
+    BPTree      bpt;
+    DictKey     key;
+    char        prefix[16];
     int         i, r;
-    clock_t     t;
-    double      bst_ins, avl_ins, tbt_ins;
-    double      bst_srch, avl_srch, tbt_srch;
-    double      bst_trav, avl_trav, tbt_trav;
-    int         bst_h, avl_h;
+    uint64_t    t;
+    double      bst_ins, avl_ins, tbt_ins, bpt_ins;
+    double      bst_srch, avl_srch, tbt_srch, bpt_srch;
+    double      bst_pfx, avl_pfx, tbt_pfx, bpt_pfx;
+    double      bst_bat, avl_bat, tbt_bat, bpt_bat;
+    double      bst_trav, avl_trav, tbt_trav, bpt_trav;
+    int         bst_h, avl_h, tbt_h, bpt_h;
+    static LatencyHist srch_h[4], pfx_h[4];   /* per call, BST AVL TBT B+ */
 
-    words = (WordRecord *)malloc((size_t)n * sizeof(WordRecord));
-    if (!words) {
-        printf("  [benchmark] malloc failed for n=%d — skipping.\n", n);
+    for (i = 0; i < 4; i++) {
+        hist_init(&srch_h[i]);
+        hist_init(&pfx_h[i]);
+    }
+    words     = (WordRecord *)malloc((size_t)n * sizeof(WordRecord));
+    batch_res = (WordRecord *)malloc((size_t)BENCH_PREFIX_REPS * TOP_K_DEFAULT *
+                                     sizeof(WordRecord));
+    batch_cnt = (int *)malloc(BENCH_PREFIX_REPS * sizeof(int));
+    batch_buf = (char (*)[16])malloc(BENCH_PREFIX_REPS * sizeof(*batch_buf));
+    batch_pfx = (const char **)malloc(BENCH_PREFIX_REPS * sizeof(const char *));
+    if (!words || !batch_res || !batch_cnt || !batch_buf || !batch_pfx) {
+        free(words); free(batch_res); free(batch_cnt); free(batch_buf); free(batch_pfx);
         return;
     }
     gen_words(words, n);
 
     /* ── Bulk insertion ── */
-    t = clock();
+    t = bench_now_ns();
     for (i = 0; i < n; i++) bst_insert(&bst, &words[i]);
     bst_ins = ms_since(t);
 
-    t = clock();
+    t = bench_now_ns();
     for (i = 0; i < n; i++) avl = avl_insert(avl, &words[i]);
     avl_ins = ms_since(t);
 
     tbt = tbt_create_header();
-    t = clock();
+    t = bench_now_ns();
     for (i = 0; i < n; i++) tbt_insert(tbt, &words[i]);
     tbt_ins = ms_since(t);
 
+    bpt_init(&bpt);
+    t = bench_now_ns();
+    for (i = 0; i < n; i++) bpt_insert(&bpt, &words[i]);
+    bpt_ins = ms_since(t);
+
     bst_h = bst_height(bst);
     avl_h = avl_height(avl);
+    tbt_h = tbt_height(tbt);
+    bpt_h = bpt_height(&bpt);
 
     /* ── Repeated search (BENCH_SEARCH_REPS lookups) ── */
+    memset(&key, 0, sizeof(key));   /* keys are compared zero-filled */
     srand(99);
-    t = clock();
+    t = bench_now_ns();
     for (r = 0; r < BENCH_SEARCH_REPS; r++) {
-        sprintf(wbuf, "wd%05d", 1 + rand() % n);
-        bst_search(bst, wbuf);
+        sprintf(key.text, "wd%05d", 1 + rand() % n);  /* already lowercase */
+        BENCH_TIMED(&srch_h[0], bst_search_normalized(bst, &key));
     }
     bst_srch = ms_since(t);
 
     srand(99);
-    t = clock();
+    t = bench_now_ns();
     for (r = 0; r < BENCH_SEARCH_REPS; r++) {
-        sprintf(wbuf, "wd%05d", 1 + rand() % n);
-        avl_search(avl, wbuf);
+        sprintf(key.text, "wd%05d", 1 + rand() % n);
+        BENCH_TIMED(&srch_h[1], avl_search_normalized(avl, &key));
     }
     avl_srch = ms_since(t);
 
     srand(99);
-    t = clock();
+    t = bench_now_ns();
     for (r = 0; r < BENCH_SEARCH_REPS; r++) {
-        sprintf(wbuf, "wd%05d", 1 + rand() % n);
-        tbt_search(tbt, wbuf);
+        sprintf(key.text, "wd%05d", 1 + rand() % n);
+        BENCH_TIMED(&srch_h[2], tbt_search_normalized(tbt, &key));
     }
     tbt_srch = ms_since(t);
 
+    srand(99);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_SEARCH_REPS; r++) {
+        sprintf(key.text, "wd%05d", 1 + rand() % n);
+        BENCH_TIMED(&srch_h[3], bpt_search_normalized(&bpt, &key));
+    }
+    bpt_srch = ms_since(t);
+
+    /* ── Repeated top-10 prefix queries (BENCH_PREFIX_REPS) ── */
+    srand(7);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(prefix, "wd%03d", rand() % (n / 100 + 1));
+        BENCH_TIMED(&pfx_h[0], autocomplete_bst(bst, prefix, found, TOP_K_DEFAULT));
+    }
+    bst_pfx = ms_since(t);
+
+    srand(7);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(prefix, "wd%03d", rand() % (n / 100 + 1));
+        BENCH_TIMED(&pfx_h[1], autocomplete_avl(avl, prefix, found, TOP_K_DEFAULT));
+    }
+    avl_pfx = ms_since(t);
+
+    srand(7);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(prefix, "wd%03d", rand() % (n / 100 + 1));
+        BENCH_TIMED(&pfx_h[2], autocomplete_tbt(tbt, prefix, found, TOP_K_DEFAULT));
+    }
+    tbt_pfx = ms_since(t);
+
+    srand(7);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(prefix, "wd%03d", rand() % (n / 100 + 1));
+        BENCH_TIMED(&pfx_h[3], autocomplete_bpt(&bpt, prefix, found, TOP_K_DEFAULT));
+    }
+    bpt_pfx = ms_since(t);
+
+    /* ── The same prefixes as one batch per tree ── */
+    srand(7);
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(batch_buf[r], "wd%03d", rand() % (n / 100 + 1));
+        batch_pfx[r] = batch_buf[r];
+    }
+
+    t = bench_now_ns();
+    autocomplete_batch_bst(bst, batch_pfx, BENCH_PREFIX_REPS, batch_res, batch_cnt,
+                           TOP_K_DEFAULT);
+    bst_bat = ms_since(t);
+
+    t = bench_now_ns();
+    autocomplete_batch_avl(avl, batch_pfx, BENCH_PREFIX_REPS, batch_res, batch_cnt,
+                           TOP_K_DEFAULT);
+    avl_bat = ms_since(t);
+
+    t = bench_now_ns();
+    autocomplete_batch_tbt(tbt, batch_pfx, BENCH_PREFIX_REPS, batch_res, batch_cnt,
+                           TOP_K_DEFAULT);
+    tbt_bat = ms_since(t);
+
+    t = bench_now_ns();
+    autocomplete_batch_bpt(&bpt, batch_pfx, BENCH_PREFIX_REPS, batch_res, batch_cnt,
+                           TOP_K_DEFAULT);
+    bpt_bat = ms_since(t);
+
     /* ── Full sorted traversal ── */
-    t = clock();
+    t = bench_now_ns();
     bst_inorder(bst, null_bst, NULL);
     bst_trav = ms_since(t);
 
-    t = clock();
+    t = bench_now_ns();
     avl_inorder(avl, null_avl, NULL);
     avl_trav = ms_since(t);
 
-    t = clock();
+    t = bench_now_ns();
     tbt_inorder(tbt, null_tbt, NULL);
     tbt_trav = ms_since(t);
 
-    /* ── Print result rows ── */
-    printf("  %-24s|  %7.3f  |  %7.3f  |  %7.3f\n",
-           "  Bulk insert (ms)", bst_ins, avl_ins, tbt_ins);
-    printf("  %-24s|  %7d  |  %7d  |  %7s\n",
-           "  Tree height", bst_h, avl_h, "  n/a");
-    printf("  %-24s|  %7.3f  |  %7.3f  |  %7.3f\n",
-           "  Search x1000 (ms)", bst_srch, avl_srch, tbt_srch);
-    printf("  %-24s|  %7.3f  |  %7.3f  |  %7.3f\n",
-           "  Traverse full (ms)", bst_trav, avl_trav, tbt_trav);
+    t = bench_now_ns();
+    bpt_inorder(&bpt, null_bpt, NULL);
+    bpt_trav = ms_since(t);
+
+    /* ── Record results ── */
+    {
+        const double ins[4]  = { bst_ins,  avl_ins,  tbt_ins,  bpt_ins  };
+        const int    h[4]    = { bst_h,    avl_h,    tbt_h,    bpt_h    };
+        const double srch[4] = { bst_srch, avl_srch, tbt_srch, bpt_srch };
+        const double pfx[4]  = { bst_pfx,  avl_pfx,  tbt_pfx,  bpt_pfx  };
+        const double bat[4]  = { bst_bat,  avl_bat,  tbt_bat,  bpt_bat  };
+        const double trav[4] = { bst_trav, avl_trav, tbt_trav, bpt_trav };
+        MemUsage     mem[4];
+        TreeShape    shp[4];
+        for (i = 0; i < 4; i++) {
+            mem_usage_clear(&mem[i]);
+            shape_clear(&shp[i]);
+        }
+        bst_memory(bst, &mem[0]);
+        avl_memory(avl, &mem[1]);
+        tbt_memory(tbt, &mem[2]);
+        bpt_memory(&bpt, &mem[3]);
+        bst_shape(bst, &shp[0]);
+        avl_shape(avl, &shp[1]);
+        tbt_shape(tbt, &shp[2]);
+        bpt_shape(&bpt, &shp[3]);
+        for (i = 0; i < 4; i++) {
+            put_cost(res, n, QUICK_TREE[i], "insert_ms",     ins[i]);
+            put_info(res, n, QUICK_TREE[i], "height",        h[i]);
+            put_info(res, n, QUICK_TREE[i], "avg_depth",     shape_avg_depth(&shp[i]));
+            put_info(res, n, QUICK_TREE[i], "compares_per_hit",
+                     shape_avg_compares(&shp[i]));
+            put_cost(res, n, QUICK_TREE[i], "search_ms",     srch[i]);
+            put_cost(res, n, QUICK_TREE[i], "prefix_ms",     pfx[i]);
+            put_cost(res, n, QUICK_TREE[i], "search_p99_us",
+                     hist_percentile(&srch_h[i], 99.0) / 1e3);
+            put_cost(res, n, QUICK_TREE[i], "prefix_p99_us",
+                     hist_percentile(&pfx_h[i], 99.0) / 1e3);
+            put_cost(res, n, QUICK_TREE[i], "batch_ms",      bat[i]);
+            put_cost(res, n, QUICK_TREE[i], "traverse_ms",   trav[i]);
+            put_cost(res, n, QUICK_TREE[i], "bytes_per_entry", layout_bytes(&mem[i]));
+        }
+    }
 
     bst_free(&bst);
     avl_free(&avl);
     tbt_free(&tbt);
+    bpt_free(&bpt);
+    free(words);
+    free(batch_res);
+    free(batch_cnt);
+    free(batch_buf);
+    free(batch_pfx);
+}
+
+/*
+ * Build a BK-tree over n words and time BENCH_PREFIX_REPS typo queries
+ * (one character of a random word replaced) against a linear scan that
+ * measures every word.  Records them under "BK".
+ */
+static void bench_fuzzy(int n, BenchResults *res) {
+    WordRecord *words;
+    WordRecord  found[TOP_K_DEFAULT];
+    BKTree      bk;
+    AVLNode    *avl = NULL;
+    char        query[16];
+    int         i, r, hits = 0;
+    uint64_t    t;
+    double      bk_build_ms, bk_ms, scan_ms;
+
+    words = (WordRecord *)malloc((size_t)n * sizeof(WordRecord));
+    if (!words) return;
+    gen_words(words, n);
+    for (i = 0; i < n; i++) avl = avl_insert(avl, &words[i]);
+
+    bk_init(&bk);
+    t = bench_now_ns();
+    bk_build(&bk, avl);
+    bk_build_ms = ms_since(t);
+
+    srand(11);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(query, "wd%05d", 1 + rand() % n);
+        query[2 + rand() % 5] = 'x';
+        bk_suggest(&bk, query, BENCH_FUZZY_DIST, found, TOP_K_DEFAULT);
+    }
+    bk_ms = ms_since(t);
+
+    srand(11);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(query, "wd%05d", 1 + rand() % n);
+        query[2 + rand() % 5] = 'x';
+        for (i = 0; i < n; i++)
+            if (bk_edit_distance(query, words[i].word, BENCH_FUZZY_DIST) <= BENCH_FUZZY_DIST)
+                hits++;
+    }
+    scan_ms = ms_since(t);
+
+    put_cost(res, n, "BK", "build_ms", bk_build_ms);
+    put_cost(res, n, "BK", "query_ms", bk_ms);
+    put_cost(res, n, "BK", "scan_ms",  scan_ms);
+    put_info(res, n, "BK", "hits",     hits);
+
+    bk_free(&bk);
+    avl_free(&avl);
+    free(words);
+}
+
+/*
+ * Build the suffix array over n words and time BENCH_PREFIX_REPS
+ * substring queries (three random digits, matching anywhere in
+ * "wdNNNNN") against a linear strstr scan.  Records them under "SA".
+ */
+static void bench_substring(int n, BenchResults *res) {
+    WordRecord  *words;
+    WordRecord   found[TOP_K_DEFAULT];
+    SuffixIndex  sfx = SUFFIX_INDEX_INIT;
+    AVLNode     *avl = NULL;
+    char         sub[8];
+    int          i, r, hits = 0;
+    uint64_t     t;
+    double       build_ms, sfx_ms, scan_ms;
+
+    words = (WordRecord *)malloc((size_t)n * sizeof(WordRecord));
+    if (!words) return;
+    gen_words(words, n);
+    for (i = 0; i < n; i++) avl = avl_insert(avl, &words[i]);
+
+    t = bench_now_ns();
+    if (suffix_build(&sfx, avl) != 0) {
+        avl_free(&avl);
+        free(words);
+        return;
+    }
+    build_ms = ms_since(t);
+
+    srand(13);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(sub, "%03d", rand() % 1000);
+        suffix_search(&sfx, sub, found, TOP_K_DEFAULT);
+    }
+    sfx_ms = ms_since(t);
+
+    srand(13);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(sub, "%03d", rand() % 1000);
+        for (i = 0; i < n; i++)
+            if (strstr(words[i].word, sub)) hits++;
+    }
+    scan_ms = ms_since(t);
+
+    put_cost(res, n, "SA", "build_ms", build_ms);
+    put_cost(res, n, "SA", "bytes",    (double)suffix_memory(&sfx));
+    put_cost(res, n, "SA", "query_ms", sfx_ms);
+    put_cost(res, n, "SA", "scan_ms",  scan_ms);
+    put_info(res, n, "SA", "hits",     hits);
+
+    suffix_free(&sfx);
+    avl_free(&avl);
+    free(words);
+}
+
+/*
+ * Build the DAWG over n words and time BENCH_PREFIX_REPS exact lookups
+ * (word -> ordinal) against the AVL tree, then report its size next to
+ * the 64-byte keys the records carry.  Records them under "DAWG".
+ */
+static void bench_dawg(int n, BenchResults *res) {
+    WordRecord  *words;
+    Dawg         dawg = DAWG_INIT;
+    AVLNode     *avl = NULL;
+    char         query[16];
+    int          i, r, hits = 0;
+    uint64_t     t;
+    double       build_ms, dawg_ms, avl_ms;
+
+    words = (WordRecord *)malloc((size_t)n * sizeof(WordRecord));
+    if (!words) return;
+    gen_words(words, n);
+    for (i = 0; i < n; i++) avl = avl_insert(avl, &words[i]);
+
+    t = bench_now_ns();
+    if (dawg_build(&dawg, avl) != 0) {
+        avl_free(&avl);
+        free(words);
+        return;
+    }
+    build_ms = ms_since(t);
+
+    srand(17);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(query, "wd%05d", 1 + rand() % n);
+        if (dawg_lookup(&dawg, query) >= 0) hits++;
+    }
+    dawg_ms = ms_since(t);
+
+    srand(17);
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(query, "wd%05d", 1 + rand() % n);
+        avl_search(avl, query);
+    }
+    avl_ms = ms_since(t);
+
+    put_cost(res, n, "DAWG", "build_ms", build_ms);
+    put_info(res, n, "DAWG", "states",   dawg.num_states);
+    put_cost(res, n, "DAWG", "bytes",    (double)dawg_memory(&dawg));
+    put_cost(res, n, "DAWG", "query_ms", dawg_ms);
+    put_cost(res, n, "DAWG", "avl_ms",   avl_ms);
+    put_info(res, n, "DAWG", "hits",     hits);
+
+    dawg_free(&dawg);
+    avl_free(&avl);
     free(words);
 }
 
+/* xorshift32: rand() may stop at 32767, too few bits to shuffle millions */
+static unsigned int scale_rand(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/*
+ * Scale trial: n records ("sc0000000" ...) added to a RecordStore and
+ * inserted into the AVL tree in random order, the B+-tree bulk-built
+ * from it, then BENCH_SEARCH_REPS exact lookups and BENCH_PREFIX_REPS
+ * top-10 prefix queries (100 matches each).  Records them under "scale".
+ */
+static void bench_scale(int n, BenchResults *res) {
+    RecordStore  store;
+    WordRecord   tmp;
+    WordRecord   found[TOP_K_DEFAULT];
+    WordRecord  *rec;
+    AVLNode     *avl = NULL;
+    BPTree       bpt;
+    int         *perm;
+    char         word[16];
+    unsigned int seed = 42;
+    int          i, j, r;
+    uint64_t     t;
+    double       ins_ms, bpt_ms, find_ms, avl_ms, ac_avl_ms, ac_bpt_ms;
+
+    perm = (int *)malloc((size_t)n * sizeof(int));
+    if (!perm) return;
+    for (i = 0; i < n; i++) perm[i] = i;
+    for (i = n - 1; i > 0; i--) {
+        j = (int)(scale_rand(&seed) % (unsigned int)(i + 1));
+        r = perm[i]; perm[i] = perm[j]; perm[j] = r;
+    }
+
+    store_init(&store);
+    bpt_init(&bpt);
+    word_record_init(&tmp);
+    tmp.meaning        = "synthetic scale-test entry";
+    tmp.part_of_speech = "noun";
+    t = bench_now_ns();
+    for (i = 0; i < n; i++) {
+        sprintf(tmp.word, "sc%07d", perm[i]);
+        tmp.frequency_score = 1 + perm[i] % 100;
+        if (!(rec = store_add(&store, &tmp))) break;
+        avl = avl_insert(avl, rec);
+    }
+    ins_ms = ms_since(t);
+    free(perm);
+    if (i < n) {                   /* out of memory: no row */
+        avl_free(&avl);
+        store_free(&store);
+        return;
+    }
+
+    t = bench_now_ns();
+    bpt_build(&bpt, avl);
+    bpt_ms = ms_since(t);
+
+    seed = 99;
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_SEARCH_REPS; r++) {
+        sprintf(word, "sc%07u", scale_rand(&seed) % (unsigned int)n);
+        store_find(&store, word);
+    }
+    find_ms = ms_since(t);
+
+    seed = 99;
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_SEARCH_REPS; r++) {
+        sprintf(word, "sc%07u", scale_rand(&seed) % (unsigned int)n);
+        avl_search(avl, word);
+    }
+    avl_ms = ms_since(t);
+
+    seed = 7;
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(word, "sc%05u", scale_rand(&seed) % (unsigned int)(n / 100));
+        autocomplete_avl(avl, word, found, TOP_K_DEFAULT);
+    }
+    ac_avl_ms = ms_since(t);
+
+    seed = 7;
+    t = bench_now_ns();
+    for (r = 0; r < BENCH_PREFIX_REPS; r++) {
+        sprintf(word, "sc%05u", scale_rand(&seed) % (unsigned int)(n / 100));
+        autocomplete_bpt(&bpt, word, found, TOP_K_DEFAULT);
+    }
+    ac_bpt_ms = ms_since(t);
+
+    put_cost(res, n, "scale", "insert_ms",    ins_ms);
+    put_cost(res, n, "scale", "bpt_build_ms", bpt_ms);
+    put_cost(res, n, "scale", "find_ms",      find_ms);
+    put_cost(res, n, "scale", "avl_ms",       avl_ms);
+    put_cost(res, n, "scale", "ac_avl_ms",    ac_avl_ms);
+    put_cost(res, n, "scale", "ac_bpt_ms",    ac_bpt_ms);
+    put_info(res, n, "scale", "height",       avl_height(avl));
+
+    bpt_free(&bpt);
+    avl_free(&avl);
+    store_free(&store);
+}
+
+/* ── Suite ───────────────────────────────────────────────────── */
+
+/* Probes per dataset: exact lookups (hits, and as many misses) and
+   top-10 queries per prefix length */
+#define BENCH_LOOKUPS     10000
+#define BENCH_AC_QUERIES  500
+
+/* Most repetitions kept per timing */
+#define BENCH_MAX_REPS    15
+
+/* Synthetic dataset sizes (those up to BenchOptions.max_words) */
+static const int BENCH_SUITE_SIZES[] = { 10000, 100000, 1000000 };
+#define NUM_SUITE_SIZES  3
+
+/* Letters drawn roughly as often as in English text, so the synthetic
+   lists fan out under a prefix the way a real word list does */
+static const char BENCH_LETTERS[] =
+    "eeeeeeeeeeeetttttttttaaaaaaaaoooooooiiiiiiinnnnnnnssssss"
+    "hhhhhhrrrrrrddddllllcccuuummmwwffggyyppbbvkjxqz";
+
+/* The suite runs the first NUM_BACKENDS; the replay adds the weighted BST,
+   whose layout only means something over real word frequencies */
+enum {
+    BK_BST, BK_AVL, BK_TBT, BK_BPT, BK_TRIE, NUM_BACKENDS,
+    BK_WBST = NUM_BACKENDS, NUM_REPLAY_BACKENDS
+};
+static const char *const BACKEND_NAME[NUM_REPLAY_BACKENDS] = {
+    "BST", "AVL", "TBT", "B+", "Trie", "WBST"
+};
+
+enum { ORDER_RANDOM, ORDER_SORTED, ORDER_ZIGZAG, NUM_ORDERS };
+static const char *const ORDER_NAME[NUM_ORDERS] = {
+    "random", "sorted", "zig-zag (both ends inwards)"
+};
+
+/* Result rows of one dataset and insertion order; -1 marks a skip */
+enum {
+    ROW_INSERT, ROW_HEIGHT, ROW_DEPTH, ROW_COMPARES, ROW_BYTES, ROW_HIT,
+    ROW_MISS, ROW_DELETE,
+    ROW_PREFIX,                                   /* + prefix length - 1 */
+    NUM_ROWS = ROW_PREFIX + BENCH_PREFIX_LENS
+};
+
+/* Operations timed one call at a time, in random order */
+enum { LAT_HIT, LAT_MISS, LAT_PREFIX, NUM_LAT = LAT_PREFIX + BENCH_PREFIX_LENS };
+
+/* One backend's index over a dataset */
+typedef struct BenchIndex {
+    int      kind;
+    BSTNode *bst;
+    AVLNode *avl;
+    TBTNode *tbt;
+    BPTree   bpt;
+    Trie     trie;
+    WBST     wbst;
+} BenchIndex;
+
+/* A dataset: its records, owned by the store, and the same sorted */
+typedef struct BenchSet {
+    char         name[64];
+    RecordStore  store;
+    WordRecord **sorted;
+    int          n;
+} BenchSet;
+
+/* The probes every backend is timed with over one dataset */
+typedef struct BenchProbes {
+    DictKey *hit;                     /* BENCH_LOOKUPS stored words      */
+    DictKey *miss;                    /* BENCH_LOOKUPS absent ones        */
+    char   (*prefix)[BENCH_PREFIX_LENS + 1];  /* BENCH_AC_QUERIES per length */
+    int      num_prefix[BENCH_PREFIX_LENS];
+} BenchProbes;
+
+static void index_init(BenchIndex *x, int kind) {
+    x->kind = kind;
+    x->bst  = NULL;
+    x->avl  = NULL;
+    x->tbt  = kind == BK_TBT ? tbt_create_header() : NULL;
+    bpt_init(&x->bpt);
+    trie_init(&x->trie);
+    x->wbst.root    = NULL;
+    x->wbst.changes = 0;
+}
+
+static void index_insert(BenchIndex *x, WordRecord *rec) {
+    switch (x->kind) {
+    case BK_BST: bst_insert(&x->bst, rec);       break;
+    case BK_AVL: x->avl = avl_insert(x->avl, rec); break;
+    case BK_TBT: tbt_insert(x->tbt, rec);        break;
+    case BK_BPT: bpt_insert(&x->bpt, rec);       break;
+    default:     trie_insert(&x->trie, rec);     break;
+    }
+}
+
+static int index_find(const BenchIndex *x, const DictKey *key) {
+    const TrieNode *t;
+    switch (x->kind) {
+    case BK_BST: return bst_search_normalized(x->bst, key) != NULL;
+    case BK_AVL: return avl_search_normalized(x->avl, key) != NULL;
+    case BK_TBT: return tbt_search_normalized(x->tbt, key) != NULL;
+    case BK_BPT: return bpt_search_normalized(&x->bpt, key) != NULL;
+    case BK_WBST: return bst_search_normalized(x->wbst.root, key) != NULL;
+    default:
+        t = trie_search_normalized(&x->trie, key);
+        return t && t->rec;
+    }
+}
+
+static int index_autocomplete(BenchIndex *x, const char *prefix,
+                              WordRecord *results, int top_k) {
+    switch (x->kind) {
+    case BK_BST: return autocomplete_bst(x->bst, prefix, results, top_k);
+    case BK_AVL: return autocomplete_avl(x->avl, prefix, results, top_k);
+    case BK_TBT: return autocomplete_tbt(x->tbt, prefix, results, top_k);
+    case BK_BPT: return autocomplete_bpt(&x->bpt, prefix, results, top_k);
+    case BK_WBST: return autocomplete_bst(x->wbst.root, prefix, results, top_k);
+    default:     return autocomplete_trie(&x->trie, prefix, results, top_k);
+    }
+}
+
+static void index_delete(BenchIndex *x, const char *word) {
+    switch (x->kind) {
+    case BK_BST: bst_delete(&x->bst, word);          break;
+    case BK_AVL: x->avl = avl_delete(x->avl, word);  break;
+    case BK_TBT: tbt_delete(x->tbt, word);           break;
+    case BK_BPT: bpt_delete(&x->bpt, word);          break;
+    default:     trie_delete(&x->trie, word);        break;
+    }
+}
+
+static int index_height(BenchIndex *x) {
+    switch (x->kind) {
+    case BK_BST: return bst_height(x->bst);
+    case BK_AVL: return avl_height(x->avl);
+    case BK_TBT: return tbt_height(x->tbt);
+    case BK_BPT: return bpt_height(&x->bpt);
+    default:     return trie_height(&x->trie);
+    }
+}
+
+static void index_shape(const BenchIndex *x, TreeShape *s) {
+    switch (x->kind) {
+    case BK_BST: bst_shape(x->bst, s);     break;
+    case BK_AVL: avl_shape(x->avl, s);     break;
+    case BK_TBT: tbt_shape(x->tbt, s);     break;
+    case BK_BPT: bpt_shape(&x->bpt, s);    break;
+    default:     trie_shape(&x->trie, s);  break;
+    }
+}
+
+static void index_memory(const BenchIndex *x, MemUsage *u) {
+    switch (x->kind) {
+    case BK_BST: bst_memory(x->bst, u);   break;
+    case BK_AVL: avl_memory(x->avl, u);   break;
+    case BK_TBT: tbt_memory(x->tbt, u);   break;
+    case BK_BPT: bpt_memory(&x->bpt, u);  break;
+    default:     trie_memory(&x->trie, u); break;
+    }
+}
+
+static void index_free(BenchIndex *x) {
+    bst_free(&x->bst);
+    avl_free(&x->avl);
+    if (x->tbt) tbt_free(&x->tbt);
+    bpt_free(&x->bpt);
+    trie_free(&x->trie);
+    wbst_free(&x->wbst);
+}
+
+static int rec_ptr_cmp(const void *a, const void *b) {
+    return str_key_cmp((*(WordRecord *const *)a)->word, (*(WordRecord *const *)b)->word);
+}
+
+static double median(double *v, int n) {
+    int    i, j;
+    double x;
+    for (i = 1; i < n; i++) {
+        x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1];
+        v[j] = x;
+    }
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+static void avl_collect_cb(AVLNode *node, void *arg) {
+    BenchSet *set = (BenchSet *)arg;
+    set->sorted[set->n++] = node->rec;
+}
+
+/* The real word list at path.  Returns 0, or -1 if it cannot be read. */
+static int set_load(BenchSet *set, const char *path) {
+    AVLNode *avl = NULL;
+    int      n;
+
+    store_init(&set->store);
+    set->sorted = NULL;
+    set->n      = 0;
+    n = load_words(path, &set->store, NULL, &avl, NULL, NULL);
+    if (n <= 0 || !(set->sorted = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *)))) {
+        avl_free(&avl);
+        store_free(&set->store);
+        return -1;
+    }
+    avl_inorder(avl, avl_collect_cb, set);
+    avl_free(&avl);
+    snprintf(set->name, sizeof(set->name), "%s", path);
+    return 0;
+}
+
+/* n distinct pseudo-words, 3..12 letters, scores 1..100.  Returns 0, or
+   -1 on malloc failure. */
+static int set_synthetic(BenchSet *set, int n, unsigned int seed) {
+    WordRecord  tmp;
+    WordRecord *rec;
+    int         len, i;
+
+    store_init(&set->store);
+    set->n      = 0;
+    set->sorted = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *));
+    if (!set->sorted) return -1;
+    word_record_init(&tmp);
+    tmp.meaning        = "synthetic suite entry";
+    tmp.part_of_speech = "noun";
+    while (set->n < n) {
+        len = 3 + (int)(scale_rand(&seed) % 10);
+        for (i = 0; i < len; i++)
+            tmp.word[i] = BENCH_LETTERS[scale_rand(&seed) % (sizeof(BENCH_LETTERS) - 1)];
+        tmp.word[len] = '\0';
+        if (store_find(&set->store, tmp.word)) continue;
+        tmp.frequency_score = 1 + (int)(scale_rand(&seed) % 100);
+        if (!(rec = store_add(&set->store, &tmp))) {
+            free(set->sorted);
+            store_free(&set->store);
+            return -1;
+        }
+        set->sorted[set->n++] = rec;
+    }
+    qsort(set->sorted, (size_t)n, sizeof(WordRecord *), rec_ptr_cmp);
+    snprintf(set->name, sizeof(set->name), "synthetic %d", n);
+    return 0;
+}
+
+static void set_free(BenchSet *set) {
+    free(set->sorted);
+    store_free(&set->store);
+}
+
+/* The dataset in insertion order `order` into out[0..n). */
+static void make_order(WordRecord **out, const BenchSet *set, int order) {
+    unsigned int seed = 42;
+    WordRecord  *tmp;
+    int          i, j, n = set->n;
+
+    switch (order) {
+    case ORDER_SORTED:
+        memcpy(out, set->sorted, (size_t)n * sizeof(WordRecord *));
+        break;
+    case ORDER_ZIGZAG:
+        for (i = 0, j = 0; j < n; i++) {
+            out[j++] = set->sorted[i];
+            if (j < n) out[j++] = set->sorted[n - 1 - i];
+        }
+        break;
+    default:
+        memcpy(out, set->sorted, (size_t)n * sizeof(WordRecord *));
+        for (i = n - 1; i > 0; i--) {
+            j = (int)(scale_rand(&seed) % (unsigned int)(i + 1));
+            tmp = out[i]; out[i] = out[j]; out[j] = tmp;
+        }
+        break;
+    }
+}
+
+/* Draw the lookup and prefix probes from the dataset.  Returns 0, or -1
+   on malloc failure. */
+static int probes_make(BenchProbes *p, const BenchSet *set) {
+    unsigned int seed = 99;
+    const char  *w;
+    char         word[MAX_WORD_LEN];
+    int          i, len, tries;
+    size_t       wl;
+
+    p->hit    = (DictKey *)malloc(BENCH_LOOKUPS * sizeof(DictKey));
+    p->miss   = (DictKey *)malloc(BENCH_LOOKUPS * sizeof(DictKey));
+    p->prefix = (char (*)[BENCH_PREFIX_LENS + 1])malloc(
+        (size_t)BENCH_PREFIX_LENS * BENCH_AC_QUERIES * sizeof(*p->prefix));
+    if (!p->hit || !p->miss || !p->prefix) {
+        free(p->hit); free(p->miss); free(p->prefix);
+        return -1;
+    }
+    for (i = 0; i < BENCH_LOOKUPS; i++) {
+        dict_key_init(&p->hit[i], set->sorted[scale_rand(&seed) % (unsigned int)set->n]->word);
+        /* A stored word with two letters added is almost never stored */
+        do {
+            w  = set->sorted[scale_rand(&seed) % (unsigned int)set->n]->word;
+            wl = strlen(w);
+            if (wl > MAX_WORD_LEN - 3) wl = MAX_WORD_LEN - 3;
+            memcpy(word, w, wl);
+            word[wl]     = 'q';
+            word[wl + 1] = (char)('a' + scale_rand(&seed) % 26);
+            word[wl + 2] = '\0';
+        } while (store_find(&set->store, word));
+        dict_key_init(&p->miss[i], word);
+    }
+    for (len = 1; len <= BENCH_PREFIX_LENS; len++) {
+        char (*out)[BENCH_PREFIX_LENS + 1] = p->prefix + (size_t)(len - 1) * BENCH_AC_QUERIES;
+        p->num_prefix[len - 1] = 0;
+        for (i = 0, tries = 0; i < BENCH_AC_QUERIES && tries < 20 * BENCH_AC_QUERIES; tries++) {
+            w = set->sorted[scale_rand(&seed) % (unsigned int)set->n]->word;
+            if ((int)strlen(w) < len) continue;
+            memcpy(out[i], w, (size_t)len);
+            out[i][len] = '\0';
+            i++;
+        }
+        p->num_prefix[len - 1] = i;
+    }
+    return 0;
+}
+
+static void probes_free(BenchProbes *p) {
+    free(p->hit);
+    free(p->miss);
+    free(p->prefix);
+}
+
+/* Median ns per lookup of keys[0..BENCH_LOOKUPS) over reps passes. */
+static double time_lookups(const BenchIndex *x, const DictKey *keys, int reps) {
+    double   v[BENCH_MAX_REPS];
+    uint64_t t;
+    int      r, i;
+    for (r = 0; r < reps; r++) {
+        t = bench_now_ns();
+        for (i = 0; i < BENCH_LOOKUPS; i++) index_find(x, &keys[i]);
+        v[r] = (double)(bench_now_ns() - t) / BENCH_LOOKUPS;
+    }
+    return median(v, reps);
+}
+
+/* Median us per top-10 query over the prefixes of one length. */
+static double time_prefixes(BenchIndex *x, const BenchProbes *p, int len, int reps) {
+    char      (*q)[BENCH_PREFIX_LENS + 1] = p->prefix + (size_t)(len - 1) * BENCH_AC_QUERIES;
+    WordRecord  found[TOP_K_DEFAULT];
+    double      v[BENCH_MAX_REPS];
+    uint64_t    t;
+    int         r, i, n = p->num_prefix[len - 1];
+
+    if (n == 0) return -1;
+    for (r = 0; r < reps; r++) {
+        t = bench_now_ns();
+        for (i = 0; i < n; i++) index_autocomplete(x, q[i], found, TOP_K_DEFAULT);
+        v[r] = (double)(bench_now_ns() - t) / 1e3 / n;
+    }
+    return median(v, reps);
+}
+
+/* Each lookup of keys[0..BENCH_LOOKUPS) timed on its own into h. */
+static void hist_lookups(const BenchIndex *x, const DictKey *keys, LatencyHist *h) {
+    int i;
+    hist_init(h);
+    for (i = 0; i < BENCH_LOOKUPS; i++) BENCH_TIMED(h, index_find(x, &keys[i]));
+}
+
+/* Each top-10 query of one prefix length timed on its own into h. */
+static void hist_prefixes(BenchIndex *x, const BenchProbes *p, int len, LatencyHist *h) {
+    char      (*q)[BENCH_PREFIX_LENS + 1] = p->prefix + (size_t)(len - 1) * BENCH_AC_QUERIES;
+    WordRecord  found[TOP_K_DEFAULT];
+    int         i;
+    hist_init(h);
+    for (i = 0; i < p->num_prefix[len - 1]; i++)
+        BENCH_TIMED(h, index_autocomplete(x, q[i], found, TOP_K_DEFAULT));
+}
+
+/*
+ * Every measurement of one backend in one insertion order into
+ * row[0..NUM_ROWS) (column kind).  Each rep builds the index afresh;
+ * the last one is also probed, and in random order each rep ends by
+ * deleting half the words.  In random order the probes are then run
+ * once more one call at a time, for the latency distribution (lat).
+ */
+static void bench_backend(int kind, const BenchSet *set, WordRecord **order,
+                          int ord, const BenchProbes *p, int reps,
+                          double row[NUM_ROWS][NUM_BACKENDS],
+                          LatencySummary lat[NUM_LAT][NUM_BACKENDS]) {
+    static LatencyHist h;
+    BenchIndex x;
+    double     ins[BENCH_MAX_REPS], del[BENCH_MAX_REPS];
+    uint64_t   t;
+    int        r, i, len, n = set->n;
+
+    for (i = 0; i < NUM_ROWS; i++) row[i][kind] = -1;
+    if (!BST_SCAPEGOAT && kind == BK_BST && ord != ORDER_RANDOM &&
+        n > BENCH_DEGENERATE_MAX) return;
+
+    for (r = 0; r < reps; r++) {
+        index_init(&x, kind);
+        t = bench_now_ns();
+        for (i = 0; i < n; i++) index_insert(&x, order[i]);
+        ins[r] = (double)(bench_now_ns() - t) / n;
+
+        if (r == reps - 1) {
+            MemUsage  mem;
+            TreeShape shp;
+            mem_usage_clear(&mem);
+            index_memory(&x, &mem);
+            shape_clear(&shp);
+            index_shape(&x, &shp);
+            row[ROW_HEIGHT][kind]   = index_height(&x);
+            row[ROW_DEPTH][kind]    = shape_avg_depth(&shp);
+            row[ROW_COMPARES][kind] = shape_avg_compares(&shp);
+            row[ROW_BYTES][kind]  = layout_bytes(&mem);
+            row[ROW_HIT][kind]    = time_lookups(&x, p->hit, reps);
+            row[ROW_MISS][kind]   = time_lookups(&x, p->miss, reps);
+            for (len = 1; len <= BENCH_PREFIX_LENS; len++)
+                row[ROW_PREFIX + len - 1][kind] = time_prefixes(&x, p, len, reps);
+            if (ord == ORDER_RANDOM) {
+                hist_lookups(&x, p->hit, &h);
+                hist_summary(&h, &lat[LAT_HIT][kind]);
+                hist_lookups(&x, p->miss, &h);
+                hist_summary(&h, &lat[LAT_MISS][kind]);
+                for (len = 1; len <= BENCH_PREFIX_LENS; len++) {
+                    hist_prefixes(&x, p, len, &h);
+                    hist_summary(&h, &lat[LAT_PREFIX + len - 1][kind]);
+                }
+            }
+        }
+        if (ord == ORDER_RANDOM) {
+            t = bench_now_ns();
+            for (i = 0; i < n / 2; i++) index_delete(&x, order[i]->word);
+            del[r] = (double)(bench_now_ns() - t) / (n / 2 > 0 ? n / 2 : 1);
+        }
+        index_free(&x);
+    }
+    row[ROW_INSERT][kind] = median(ins, reps);
+    if (ord == ORDER_RANDOM) row[ROW_DELETE][kind] = median(del, reps);
+}
+
+static long file_size(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    long  n  = -1;
+    if (!fp) return -1;
+    if (fseek(fp, 0, SEEK_END) == 0) n = ftell(fp);
+    fclose(fp);
+    return n;
+}
+
+static void print_suite_row(const char *label, const double *v, int decimals) {
+    int b;
+    printf("  %-26s", label);
+    for (b = 0; b < NUM_BACKENDS; b++) {
+        if (v[b] < 0) printf("| %10s ", "-");
+        else          printf("| %10.*f ", decimals, v[b]);
+    }
+    printf("\n");
+}
+
+static void print_suite_sep(void) {
+    int b;
+    printf("  --------------------------");
+    for (b = 0; b < NUM_BACKENDS; b++) printf("+------------");
+    printf("\n");
+}
+
+static void lat_name(int op, char *buf, size_t size, int csv) {
+    if (op == LAT_HIT)       snprintf(buf, size, csv ? "lookup_hit"  : "lookup hit");
+    else if (op == LAT_MISS) snprintf(buf, size, csv ? "lookup_miss" : "lookup miss");
+    else snprintf(buf, size, csv ? "top10_prefix_%d" : "top-10 prefix %d", op - LAT_PREFIX + 1);
+}
+
+/* The latency distributions of one dataset: a table in microseconds,
+   and one CSV row each (nanoseconds) if csv is open. */
+static void print_latency(const BenchSet *set, LatencySummary lat[NUM_LAT][NUM_BACKENDS],
+                          FILE *csv) {
+    const LatencySummary *l;
+    char                  name[32], label[48];
+    int                   kind, op;
+
+    printf("\n  Latency per call, random order (us)\n");
+    printf("  %-26s| %9s | %9s | %9s | %9s | %9s | %9s\n",
+           "", "mean", "p50", "p95", "p99", "p99.9", "max");
+    printf("  --------------------------+-----------+-----------+-----------+"
+           "-----------+-----------+-----------\n");
+    for (kind = 0; kind < NUM_BACKENDS; kind++) {
+        if (kind > 0) printf("\n");
+        for (op = 0; op < NUM_LAT; op++) {
+            l = &lat[op][kind];
+            if (l->n == 0) continue;
+            lat_name(op, name, sizeof(name), 0);
+            snprintf(label, sizeof(label), "%-4s %s", BACKEND_NAME[kind], name);
+            printf("  %-26s| %9.2f | %9.2f | %9.2f | %9.2f | %9.2f | %9.2f\n", label,
+                   l->mean / 1e3, l->p50 / 1e3, l->p95 / 1e3, l->p99 / 1e3,
+                   l->p999 / 1e3, l->max / 1e3);
+            if (csv) {
+                lat_name(op, name, sizeof(name), 1);
+                fprintf(csv, "%s,%d,random,%s,%s,%llu,%.1f,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n",
+                        set->name, set->n, BACKEND_NAME[kind], name,
+                        (unsigned long long)l->n, l->mean, (unsigned long long)l->min,
+                        (unsigned long long)l->p50, (unsigned long long)l->p90,
+                        (unsigned long long)l->p95, (unsigned long long)l->p99,
+                        (unsigned long long)l->p999, (unsigned long long)l->max);
+            }
+        }
+    }
+    printf("  --------------------------+-----------+-----------+-----------+"
+           "-----------+-----------+-----------\n");
+}
+
+/* Every backend over one dataset, one table per insertion order, then
+   the latency distributions. */
+static void suite_run_set(const BenchSet *set, int reps, FILE *csv) {
+    static LatencySummary lat[NUM_LAT][NUM_BACKENDS];
+    double       row[NUM_ROWS][NUM_BACKENDS];
+    WordRecord **order;
+    BenchProbes  probes;
+    char         label[32];
+    int          ord, kind, len;
+
+    order = (WordRecord **)malloc((size_t)set->n * sizeof(WordRecord *));
+    if (!order || probes_make(&probes, set) != 0) {
+        printf("  [benchmark] malloc failed for %s — skipping.\n", set->name);
+        free(order);
+        return;
+    }
+    {
+        MemUsage mem;
+        mem_usage_clear(&mem);
+        store_memory(&set->store, &mem);
+        printf("\n  Dataset: %s — %d words, record store %.1f bytes/entry "
+               "(records %.1f, text %.1f, index %.1f, unused %.1f)\n",
+               set->name, set->n, mem_usage_per_entry(&mem),
+               (double)mem.node_bytes / set->n, (double)mem.string_bytes / set->n,
+               (double)mem.index_bytes / set->n, (double)mem.overhead_bytes / set->n);
+    }
+
+    for (ord = 0; ord < NUM_ORDERS; ord++) {
+        make_order(order, set, ord);
+        for (kind = 0; kind < NUM_BACKENDS; kind++)
+            bench_backend(kind, set, order, ord, &probes, reps, row, lat);
+
+        printf("\n  Insertion order: %s\n", ORDER_NAME[ord]);
+        printf("  %-26s", "");
+        for (kind = 0; kind < NUM_BACKENDS; kind++) printf("| %10s ", BACKEND_NAME[kind]);
+        printf("\n");
+        print_suite_sep();
+        print_suite_row("Insert (ns/op)",       row[ROW_INSERT], 1);
+        print_suite_row("Height",               row[ROW_HEIGHT], 0);
+        print_suite_row("Avg depth",            row[ROW_DEPTH],  2);
+        print_suite_row("Compares per hit",     row[ROW_COMPARES], 2);
+        print_suite_row("Index bytes/entry",    row[ROW_BYTES],  1);
+        print_suite_row("Lookup hit (ns/op)",   row[ROW_HIT],    1);
+        print_suite_row("Lookup miss (ns/op)",  row[ROW_MISS],   1);
+        if (ord == ORDER_RANDOM)
+            print_suite_row("Delete half (ns/op)", row[ROW_DELETE], 1);
+        for (len = 1; len <= BENCH_PREFIX_LENS; len++) {
+            snprintf(label, sizeof(label), "Top-10, prefix %d (us)", len);
+            print_suite_row(label, row[ROW_PREFIX + len - 1], 2);
+        }
+        print_suite_sep();
+    }
+    if (!BST_SCAPEGOAT && set->n > BENCH_DEGENERATE_MAX)
+        printf("  (BST skipped on sorted and zig-zag input above %d words:"
+               " O(n^2) to build)\n", BENCH_DEGENERATE_MAX);
+    print_latency(set, lat, csv);
+    probes_free(&probes);
+    free(order);
+}
+
+/* A dictionary loaded as the application loads it: every index. */
+typedef struct BenchDict {
+    RecordStore store;
+    BSTNode    *bst;
+    AVLNode    *avl;
+    TBTNode    *tbt;
+    Trie        trie;
+} BenchDict;
+
+static void dict_init(BenchDict *d) {
+    store_init(&d->store);
+    d->bst = NULL;
+    d->avl = NULL;
+    d->tbt = tbt_create_header();
+    trie_init(&d->trie);
+}
+
+static void dict_free(BenchDict *d) {
+    bst_free(&d->bst);
+    avl_free(&d->avl);
+    if (d->tbt) tbt_free(&d->tbt);
+    trie_free(&d->trie);
+    store_free(&d->store);
+}
+
+/* Load path and save it back through each file format, reps times. */
+static void suite_load_save(const char *path, int reps) {
+    static const char *const row_name[6] = {
+        "Text load", "Text save", "Snapshot save", "Snapshot load",
+        "Packed save", "Packed load"
+    };
+    const char *tmp_text = DATA_DIR "/bench_suite.tmp.txt";
+    const char *tmp_snap = DATA_DIR "/bench_suite.tmp.snap";
+    const char *tmp_pack = DATA_DIR "/bench_suite.tmp.sdz";
+    const char *file[6];
+    double      v[6][BENCH_MAX_REPS];
+    BenchDict   d;
+    uint64_t    t;
+    int         r, i, n = 0, ok = 1;
+
+    file[0] = path;     file[1] = tmp_text;
+    file[2] = tmp_snap; file[3] = tmp_snap;
+    file[4] = tmp_pack; file[5] = tmp_pack;
+
+    for (r = 0; r < reps && ok; r++) {
+        dict_init(&d);
+        t = bench_now_ns();
+        n = load_words(path, &d.store, &d.bst, &d.avl, d.tbt, &d.trie);
+        v[0][r] = ms_since(t);
+        ok = n > 0;
+        t = bench_now_ns();
+        ok = ok && save_custom_words(tmp_text, d.avl) >= 0;
+        v[1][r] = ms_since(t);
+        t = bench_now_ns();
+        ok = ok && snapshot_save(tmp_snap, d.avl) == 0;
+        v[2][r] = ms_since(t);
+        t = bench_now_ns();
+        ok = ok && packed_save(tmp_pack, d.avl) == 0;
+        v[4][r] = ms_since(t);
+        dict_free(&d);
+        if (!ok) break;
+
+        dict_init(&d);
+        t = bench_now_ns();
+        ok = snapshot_load(tmp_snap, &d.store, &d.bst, &d.avl, d.tbt, &d.trie) == n;
+        v[3][r] = ms_since(t);
+        dict_free(&d);
+
+        dict_init(&d);
+        t = bench_now_ns();
+        ok = ok && load_packed(tmp_pack, &d.store, &d.bst, &d.avl, d.tbt, &d.trie) == n;
+        v[5][r] = ms_since(t);
+        dict_free(&d);
+    }
+
+    printf("\n  Load and save: %s (%d words, every index built)\n", path, n);
+    if (!ok) {
+        printf("  [benchmark] a load or save failed — skipping.\n");
+    } else {
+        printf("  %-26s| %10s | %12s\n", "", "ms", "file bytes");
+        printf("  --------------------------+------------+-------------\n");
+        for (i = 0; i < 6; i++)
+            printf("  %-26s| %10.1f | %12ld\n", row_name[i], median(v[i], reps),
+                   file_size(file[i]));
+    }
+    remove(tmp_text);
+    remove(tmp_snap);
+    remove(tmp_pack);
+}
+
+/* ── Replay ──────────────────────────────────────────────────── */
+
+/* Operations of a query log */
+enum { RP_SEARCH, RP_COMPLETE, RP_PICK, NUM_RP };
+static const char *const RP_NAME[NUM_RP] = { "search", "complete", "pick" };
+
+/* The word list one backend is replayed against: every index built by
+   the loader, the way the application loads it, plus the B+-tree, and
+   for the weighted BST the loader's BST laid out by frequency */
+typedef struct ReplayDict {
+    RecordStore store;
+    BenchIndex  x;              /* x.kind picks the backend queried */
+    int         n;
+} ReplayDict;
+
+/* What the clients of one replay share */
+typedef struct ReplayShared {
+    const QueryLog   *log;
+    ReplayDict       *d;
+    ShardedDict      *sd;       /* instead of d: the shard pass, unlocked */
+    pthread_rwlock_t  lock;     /* queries and pick counts read; applying writes */
+} ReplayShared;
+
+/* One client: the whole log, from its own starting point */
+typedef struct ReplayClient {
+    ReplayShared *sh;
+    pthread_t     tid;
+    int           start;
+    int           hits[NUM_RP];
+    LatencyHist   hist[NUM_RP];
+} ReplayClient;
+
+/* Load path (and the frequency file) into d.  Returns 0, or -1. */
+static int replay_dict_load(ReplayDict *d, const char *path, int kind) {
+    store_init(&d->store);
+    index_init(&d->x, kind);
+    if (!d->x.tbt) d->x.tbt = tbt_create_header();
+    d->n = load_words(path, &d->store, &d->x.bst, &d->x.avl, d->x.tbt, &d->x.trie);
+    if (d->n <= 0 || bpt_build(&d->x.bpt, d->x.avl) < 0) {
+        index_free(&d->x);
+        store_free(&d->store);
+        return -1;
+    }
+    load_frequencies(FILE_WORD_FREQ, &d->store, d->x.avl, &d->x.trie);
+    if (kind == BK_WBST && wbst_adopt(&d->x.wbst, &d->x.bst) != 0) {
+        index_free(&d->x);
+        store_free(&d->store);
+        return -1;
+    }
+    return 0;
+}
+
+static void replay_dict_free(ReplayDict *d) {
+    index_free(&d->x);
+    store_free(&d->store);
+}
+
+/* Apply the picks counted so far; the weighted BST counts the records
+   they re-ranked towards its next layout.  Needs the write lock. */
+static void replay_apply_picks(ReplayDict *d) {
+    int moved = autocomplete_apply_selections(&d->store, d->x.avl, &d->x.trie);
+    if (d->x.kind == BK_WBST) wbst_reweigh(&d->x.wbst, moved);
+}
+
+/* One event against the sharded dictionary, which does its own locking:
+   picks are applied by their shard's worker at once.  A pick's hit is
+   looked up after its time is taken. */
+static void replay_sharded(ReplayClient *c, const QueryEvent *e, WordRecord *results) {
+    ShardedDict *sd = c->sh->sd;
+    uint64_t     t0 = bench_now_ns();
+    int          k;
+
+    if (e->op == QLOG_SEARCH) {
+        k = RP_SEARCH;
+        c->hits[k] += sharded_lookup(sd, e->text, results);
+    } else if (e->op == QLOG_COMPLETE) {
+        k = RP_COMPLETE;
+        c->hits[k] += sharded_autocomplete(sd, e->text, results, TOP_K_DEFAULT) > 0;
+    } else {
+        k = RP_PICK;
+        sharded_record_selection(sd, e->text);
+    }
+    hist_record(&c->hist[k], bench_now_ns() - t0);
+    if (k == RP_PICK) c->hits[k] += sharded_lookup(sd, e->text, results);
+}
+
+/*
+ * Replay every event of the log once, timing each one.  Lookups and
+ * prefix queries run under the read lock, and so do picks, which are
+ * only counted (autocomplete_count_selection, lock-free); whoever gets
+ * the write lock right after a pick applies every pick counted so far,
+ * as DictHandle's writers do.  One client never waits for that, so its
+ * picks are applied at once, like the single-threaded front ends.
+ */
+static void *replay_client(void *arg) {
+    ReplayClient     *c  = (ReplayClient *)arg;
+    ReplayShared     *sh = c->sh;
+    ReplayDict       *d  = sh->d;
+    WordRecord        results[TOP_K_DEFAULT];
+    DictKey           key;
+    const QueryEvent *e;
+    uint64_t          t0;
+    int               i, k, n = sh->log->count;
+
+    for (i = 0; i < n; i++) {
+        e  = &sh->log->events[(c->start + i) % n];
+        if (sh->sd) {
+            replay_sharded(c, e, results);
+            continue;
+        }
+        t0 = bench_now_ns();
+        pthread_rwlock_rdlock(&sh->lock);
+        if (e->op == QLOG_SEARCH) {
+            k = RP_SEARCH;
+            dict_key_init(&key, e->text);
+            c->hits[k] += index_find(&d->x, &key);
+        } else if (e->op == QLOG_COMPLETE) {
+            k = RP_COMPLETE;
+            c->hits[k] += index_autocomplete(&d->x, e->text, results, TOP_K_DEFAULT) > 0;
+        } else {
+            k = RP_PICK;
+            c->hits[k] += autocomplete_count_selection(e->text, &d->store);
+        }
+        pthread_rwlock_unlock(&sh->lock);
+        if (k == RP_PICK && pthread_rwlock_trywrlock(&sh->lock) == 0) {
+            replay_apply_picks(d);
+            pthread_rwlock_unlock(&sh->lock);
+        }
+        hist_record(&c->hist[k], bench_now_ns() - t0);
+    }
+    return NULL;
+}
+
+/* Replay log with `threads` clients against d, or sd if d is NULL.
+   Merges their latencies into hist and hits; returns the wall time in
+   ms, or -1 on failure. */
+static double replay_run(const QueryLog *log, ReplayDict *d, ShardedDict *sd,
+                         int threads, LatencyHist hist[NUM_RP], int hits[NUM_RP]) {
+    ReplayShared  sh;
+    ReplayClient *c;
+    uint64_t      start;
+    double        ms;
+    int           i, k, started;
+
+    c = (ReplayClient *)malloc((size_t)threads * sizeof(ReplayClient));
+    if (!c) return -1.0;
+    sh.log = log;
+    sh.d   = d;
+    sh.sd  = d ? NULL : sd;
+    if (pthread_rwlock_init(&sh.lock, NULL) != 0) {
+        free(c);
+        return -1.0;
+    }
+    for (i = 0; i < threads; i++) {
+        c[i].sh    = &sh;
+        c[i].start = (int)((long long)log->count * i / threads);
+        for (k = 0; k < NUM_RP; k++) {
+            c[i].hits[k] = 0;
+            hist_init(&c[i].hist[k]);
+        }
+    }
+
+    start = bench_now_ns();
+    for (started = 0; started < threads; started++)
+        if (pthread_create(&c[started].tid, NULL, replay_client, &c[started]) != 0) break;
+    for (i = 0; i < started; i++) pthread_join(c[i].tid, NULL);
+    ms = ms_since(start);
+    if (d) replay_apply_picks(d);
+
+    for (k = 0; k < NUM_RP; k++) {
+        hist_init(&hist[k]);
+        hits[k] = 0;
+        for (i = 0; i < started; i++) {
+            hist_merge(&hist[k], &c[i].hist[k]);
+            hits[k] += c[i].hits[k];
+        }
+    }
+    pthread_rwlock_destroy(&sh.lock);
+    free(c);
+    return started == threads ? ms : -1.0;
+}
+
+/* Print one replay's table (note follows the wall time on its heading
+   line) and, if out is non-NULL, add its costs to it. */
+static void replay_report(const char *name, int words, double ms, int events,
+                          const char *note, LatencyHist hist[NUM_RP],
+                          const int hits[NUM_RP], BenchResults *out) {
+    LatencySummary l;
+    char           metric[32];
+    int            k;
+
+    printf("\n  %-4s %d words: %.1f ms", name, words, ms);
+    if (ms > 0.0) printf(", %.0f events/s", (double)events / (ms / 1000.0));
+    printf("%s\n", note);
+    printf("  %-9s| %9s | %9s | %9s | %9s | %9s | %9s | %9s\n", "op", "count",
+           "hits", "mean", "p50", "p95", "p99", "max");
+    printf("  ---------+-----------+-----------+-----------+-----------+"
+           "-----------+-----------+-----------\n");
+    for (k = 0; k < NUM_RP; k++) {
+        if (hist[k].n == 0) continue;
+        hist_summary(&hist[k], &l);
+        printf("  %-9s| %9llu | %9d | %9.2f | %9.2f | %9.2f | %9.2f | %9.2f\n",
+               RP_NAME[k], (unsigned long long)l.n, hits[k], l.mean / 1e3,
+               l.p50 / 1e3, l.p95 / 1e3, l.p99 / 1e3, l.max / 1e3);
+        if (out) {
+            snprintf(metric, sizeof(metric), "%s_mean_us", RP_NAME[k]);
+            put_cost(out, words, name, metric, l.mean / 1e3);
+            snprintf(metric, sizeof(metric), "%s_p99_us", RP_NAME[k]);
+            put_cost(out, words, name, metric, l.p99 / 1e3);
+        }
+    }
+    if (out) put_cost(out, words, name, "ns_per_event", ms * 1e6 / (double)events);
+}
+
 /* ── Public API ──────────────────────────────────────────────── */
 
-void benchmark_run_all(void) {
+uint64_t bench_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER        now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000u +
+           (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000u /
+           (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+int benchmark_collect(BenchResults *out) {
     int i;
+
+    out->count = 0;
+    for (i = 0; i < NUM_SIZES; i++) {
+        bench_one(BENCH_SIZES[i], out);
+        bench_fuzzy(BENCH_SIZES[i], out);
+        bench_substring(BENCH_SIZES[i], out);
+        bench_dawg(BENCH_SIZES[i], out);
+    }
+    for (i = 0; i < NUM_SCALE_SIZES; i++) bench_scale(BENCH_SCALE_SIZES[i], out);
+    return out->count > 0 ? 0 : -1;
+}
+
+void benchmark_results_init(BenchResults *r) {
+    r->items = NULL;
+    r->count = 0;
+    r->cap   = 0;
+}
+
+void benchmark_results_free(BenchResults *r) {
+    free(r->items);
+    benchmark_results_init(r);
+}
+
+const BenchResult *benchmark_results_find(const BenchResults *r, int words,
+                                          const char *backend, const char *metric) {
+    return find_result(r, words, backend, metric);
+}
+
+char *benchmark_results_text(const BenchResults *r) {
+    static const struct { const char *label, *metric; int whole; } ROWS[] = {
+        { "  Bulk insert (ms)",   "insert_ms",     0 },
+        { "  Tree height",        "height",        1 },
+        { "  Avg depth",          "avg_depth",     0 },
+        { "  Compares per hit",   "compares_per_hit", 0 },
+        { "  Search x1000 (ms)",  "search_ms",     0 },
+        { "  Prefix x1000 (ms)",  "prefix_ms",     0 },
+        { "  Search p99 (us)",    "search_p99_us", 0 },
+        { "  Prefix p99 (us)",    "prefix_p99_us", 0 },
+        { "  Batched x1000 (ms)", "batch_ms",      0 },
+        { "  Traverse full (ms)", "traverse_ms",   0 },
+        { "  Bytes per entry",    "bytes_per_entry", 0 },
+    };
+    static const char *const SCALE[] = {
+        "insert_ms", "bpt_build_ms", "find_ms", "avl_ms", "ac_avl_ms", "ac_bpt_ms"
+    };
     const char *hdr =
-        "  %-24s|  %-9s|  %-9s|  %-9s";
+        "  %-24s|  %-9s|  %-9s|  %-9s|  %-9s\n";
     const char *sep =
-        "  ------------------------+----------+---------+---------";
+        "  ------------------------+-----------+-----------+-----------+-----------\n";
+    const BenchResult *v, *w, *x, *y;
+    TextBuf b = { NULL, 0, 0, 0 };
+    int     i, j, k, n;
+
+    tb_printf(&b, "\n");
+    tb_rule(&b, '=', 60);
+    tb_printf(&b, "  BENCHMARK: BST vs AVL vs TBT vs B+\n");
+    tb_printf(&b, "  Word order: pseudo-random (Fisher-Yates, seed=42)\n");
+    tb_printf(&b, "  Timing: monotonic clock, nanosecond resolution\n");
+    tb_rule(&b, '=', 60);
+
+    for (i = 0; i < NUM_SIZES; i++) {
+        n = BENCH_SIZES[i];
+        tb_printf(&b, "\n");
+        tb_printf(&b, hdr, "  Dataset: words", "  BST", "  AVL", "  TBT", "  B+");
+        tb_printf(&b, "  %-24s|  %-9d|  %-9d|  %-9d|  %-9d\n",
+                  "  Size (words)", n, n, n, n);
+        tb_printf(&b, "%s", sep);
+        if (!find_result(r, n, QUICK_TREE[0], ROWS[0].metric))
+            tb_printf(&b, "  (skipped: out of memory)\n");
+        else
+            for (j = 0; j < (int)(sizeof(ROWS) / sizeof(ROWS[0])); j++) {
+                tb_printf(&b, "  %-24s", ROWS[j].label);
+                for (k = 0; k < 4; k++) {
+                    v = find_result(r, n, QUICK_TREE[k], ROWS[j].metric);
+                    if (!v)                tb_printf(&b, "|  %7s  ", "-");
+                    else if (ROWS[j].whole) tb_printf(&b, "|  %7d  ", (int)v->value);
+                    else                   tb_printf(&b, "|  %7.3f  ", v->value);
+                }
+                tb_printf(&b, "\n");
+            }
+        tb_printf(&b, "%s", sep);
+
+        v = find_result(r, n, "BK", "build_ms");
+        w = find_result(r, n, "BK", "query_ms");
+        x = find_result(r, n, "BK", "scan_ms");
+        y = find_result(r, n, "BK", "hits");
+        if (v && w && x && y)
+            tb_printf(&b, "  BK-tree (d<=%d): build %.3f ms, fuzzy x1000 %.3f ms"
+                          "  (linear scan %.3f ms, %d hits)\n",
+                      BENCH_FUZZY_DIST, v->value, w->value, x->value, (int)y->value);
+
+        v = find_result(r, n, "SA", "build_ms");
+        w = find_result(r, n, "SA", "bytes");
+        x = find_result(r, n, "SA", "query_ms");
+        y = find_result(r, n, "SA", "scan_ms");
+        if (v && w && x && y && find_result(r, n, "SA", "hits"))
+            tb_printf(&b, "  Suffix array: build %.3f ms, %lu KB, substring x1000 %.3f ms"
+                          "  (linear scan %.3f ms, %d hits)\n",
+                      v->value, (unsigned long)(w->value / 1024), x->value, y->value,
+                      (int)find_result(r, n, "SA", "hits")->value);
+
+        v = find_result(r, n, "DAWG", "build_ms");
+        w = find_result(r, n, "DAWG", "bytes");
+        x = find_result(r, n, "DAWG", "query_ms");
+        y = find_result(r, n, "DAWG", "avl_ms");
+        if (v && w && x && y && find_result(r, n, "DAWG", "states") &&
+            find_result(r, n, "DAWG", "hits"))
+            tb_printf(&b, "  DAWG: build %.3f ms, %d states, %lu bytes (keys %lu KB),"
+                          " lookup x1000 %.3f ms  (AVL %.3f ms, %d hits)\n",
+                      v->value, (int)find_result(r, n, "DAWG", "states")->value,
+                      (unsigned long)w->value,
+                      (unsigned long)((size_t)n * MAX_WORD_LEN / 1024), x->value, y->value,
+                      (int)find_result(r, n, "DAWG", "hits")->value);
+    }
+
+    tb_printf(&b, "\n  Scale: RecordStore + AVL (random order), B+ bulk-built, all ms\n");
+    tb_printf(&b, "  %-10s| %9s | %9s | %9s | %9s | %9s | %9s | %4s\n", "Words",
+              "store+AVL", "B+ build", "find x1k", "AVL x1k", "top10 AVL", "top10 B+", "h");
+    tb_printf(&b, "  ----------+-----------+-----------+-----------+-----------+"
+                  "-----------+-----------+-----\n");
+    for (i = 0; i < NUM_SCALE_SIZES; i++) {
+        n = BENCH_SCALE_SIZES[i];
+        if (!(v = find_result(r, n, "scale", "height"))) {
+            tb_printf(&b, "  %-10d| (skipped: out of memory)\n", n);
+            continue;
+        }
+        tb_printf(&b, "  %-10d|", n);
+        for (j = 0; j < (int)(sizeof(SCALE) / sizeof(SCALE[0])); j++) {
+            w = find_result(r, n, "scale", SCALE[j]);
+            tb_printf(&b, j < 2 ? " %9.1f |" : " %9.3f |", w ? w->value : 0.0);
+        }
+        tb_printf(&b, " %4d\n", (int)v->value);
+    }
+
+    tb_printf(&b, "\n");
+    tb_rule(&b, '=', 60);
+    tb_printf(&b, "  Notes:\n");
+#if BST_SCAPEGOAT
+    tb_printf(&b, "  BST  - Scapegoat mode: subtrees out of weight balance are\n");
+    tb_printf(&b, "         rebuilt; height under 2.41 log2 n on any order.\n");
+#else
+    tb_printf(&b, "  BST  - Unbalanced; height depends on insertion order.\n");
+    tb_printf(&b, "         Worst case O(n) for sorted input.\n");
+#endif
+    tb_printf(&b, "  AVL  - Self-balancing; height always O(log n).\n");
+    tb_printf(&b, "         Slightly higher insert cost due to rotations.\n");
+    tb_printf(&b, "  TBT  - AVL-balanced threaded BST; height always O(log n),\n");
+    tb_printf(&b, "         traverse needs no stack/recursion.\n");
+    tb_printf(&b, "  B+   - %d-key nodes, linked leaves; height O(log n / log %d),\n",
+              BPT_LEAF_KEYS, BPT_INNER_KEYS + 1);
+    tb_printf(&b, "         prefix and full scans walk the leaf chain.\n");
+    tb_printf(&b, "  BK   - Edit-distance tree for typo suggestions; the\n");
+    tb_printf(&b, "         triangle inequality prunes most of the words.\n");
+    tb_printf(&b, "  SA   - Suffix array over every word; a substring query is\n");
+    tb_printf(&b, "         two binary searches plus the run of matching suffixes.\n");
+    tb_printf(&b, "  DAWG - Minimised word automaton; shared prefixes and\n");
+    tb_printf(&b, "         suffixes are stored once, ordinals by counting.\n");
+    tb_rule(&b, '=', 60);
+    tb_printf(&b, "\n");
+
+    if (b.failed) {
+        free(b.s);
+        return NULL;
+    }
+    return b.s;
+}
+
+int benchmark_results_save(const BenchResults *r, const char *path) {
+    size_t      len  = strlen(path);
+    int         json = len >= 5 && strcmp(path + len - 5, ".json") == 0;
+    FILE       *fp   = fopen(path, "w");
+    int         i;
+
+    if (!fp) return -1;
+    if (json) {
+        fprintf(fp, "{\n  \"benchmark\": \"quick\",\n  \"results\": [");
+        for (i = 0; i < r->count; i++)
+            fprintf(fp, "%s\n    {\"words\": %d, \"backend\": \"%s\", \"metric\": \"%s\","
+                        " \"value\": %.6g, \"lower_better\": %s}",
+                    i ? "," : "", r->items[i].words, r->items[i].backend,
+                    r->items[i].metric, r->items[i].value,
+                    r->items[i].lower_better ? "true" : "false");
+        fprintf(fp, "\n  ]\n}\n");
+    } else {
+        fprintf(fp, "words,backend,metric,value,lower_better\n");
+        for (i = 0; i < r->count; i++)
+            fprintf(fp, "%d,%s,%s,%.6g,%d\n", r->items[i].words, r->items[i].backend,
+                    r->items[i].metric, r->items[i].value, r->items[i].lower_better);
+    }
+    return fclose(fp) == 0 ? r->count : -1;
+}
+
+int benchmark_results_load(BenchResults *r, const char *path) {
+    FILE  *fp = fopen(path, "r");
+    char   line[160];
+    char   backend[sizeof(((BenchResult *)0)->backend)];
+    char   metric[sizeof(((BenchResult *)0)->metric)];
+    double value;
+    int    words, lower_better, n = 0;
+
+    if (!fp) return -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%d,%7[^,],%31[^,],%lf,%d",
+                   &words, backend, metric, &value, &lower_better) != 5)
+            continue;              /* the header, or a malformed line */
+        put(r, words, backend, metric, value, lower_better != 0);
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+int benchmark_compare(const BenchResults *base, const BenchResults *cur,
+                      double threshold_pct, FILE *out) {
+    const BenchResult *b, *c;
+    double             change;
+    int                i, compared = 0, worse = 0, better = 0;
+
+    fprintf(out, "\n  Against baseline (a rise of more than %.1f%% is a regression)\n",
+            threshold_pct);
+    fprintf(out, "  %-8s %-6s %-14s| %12s | %12s | %8s\n",
+            "Words", "Where", "Metric", "Baseline", "Now", "Change");
+    fprintf(out, "  ------------------------------+--------------+--------------+---------\n");
+    for (i = 0; i < base->count; i++) {
+        b = &base->items[i];
+        if (!b->lower_better || b->value <= 0.0) continue;
+        c = find_result(cur, b->words, b->backend, b->metric);
+        if (!c) continue;
+        compared++;
+        change = (c->value - b->value) / b->value * 100.0;
+        if (change > threshold_pct)       worse++;
+        else if (change < -threshold_pct) better++;
+        else continue;                 /* within the threshold: not listed */
+        fprintf(out, "  %-8d %-6s %-14s| %12.3f | %12.3f | %+7.1f%%%s\n",
+                b->words, b->backend, b->metric, b->value, c->value, change,
+                change > threshold_pct ? "  REGRESSION" : "");
+    }
+    fprintf(out, "  ------------------------------+--------------+--------------+---------\n");
+    fprintf(out, "  %d compared: %d regressed, %d improved, %d within %.1f%%\n",
+            compared, worse, better, compared - worse - better, threshold_pct);
+    return worse;
+}
+
+void benchmark_run_all(void) {
+    BenchResults r;
+    char        *text;
+
+    benchmark_results_init(&r);
+    if (benchmark_collect(&r) != 0) {
+        printf("  [benchmark] out of memory — no results.\n");
+        benchmark_results_free(&r);
+        return;
+    }
+    text = benchmark_results_text(&r);
+    if (text) fputs(text, stdout);
+    free(text);
+    benchmark_results_free(&r);
+}
+
+int benchmark_replay(const QueryLog *log, const ReplayOptions *opt, BenchResults *out) {
+    static LatencyHist hist[NUM_RP];
+    ReplayOptions      o = REPLAY_OPTIONS_INIT;
+    ReplayDict         d;
+    ShardedDict       *sd;
+    const char        *path;
+    char               note[64];
+    double             ms;
+    int                hits[NUM_RP];
+    int                kind, threads, done = 0;
+
+    if (opt) o = *opt;
+    path    = o.words_path ? o.words_path : FILE_WORDS;
+    threads = o.threads < 1 ? 1 : (o.threads > REPLAY_THREADS_MAX ? REPLAY_THREADS_MAX
+                                                                   : o.threads);
+    if (out) out->count = 0;
+    if (log->count == 0) return -1;
 
     printf("\n");
     print_separator('=', 60);
-    printf("  BENCHMARK: BST vs AVL vs TBT\n");
-    printf("  Word order: pseudo-random (Fisher-Yates, seed=42)\n");
-    printf("  Timing via clock() — values < 0.001 ms may appear as 0.000\n");
+    printf("  REPLAY: %d events x %d client%s, against %s\n", log->count, threads,
+           threads == 1 ? "" : "s", path);
+    printf("  Each backend gets a fresh load; latencies in us\n");
     print_separator('=', 60);
 
-    for (i = 0; i < NUM_SIZES; i++) {
-        int n = BENCH_SIZES[i];
-        printf("\n");
-        printf(hdr, "  Dataset: words", "  BST", "  AVL", "  TBT");
-        printf("\n");
-        printf("  %-24s|  %-9d|  %-9d|  %-9d\n",
-               "  Size (words)", n, n, n);
-        printf("%s\n", sep);
-        bench_one(n);
-        printf("%s\n", sep);
+    for (kind = 0; kind < NUM_REPLAY_BACKENDS; kind++) {
+        if (replay_dict_load(&d, path, kind) != 0) {
+            printf("  [benchmark] cannot load %s — no replay.\n", path);
+            return done ? 0 : -1;
+        }
+        ms = replay_run(log, &d, NULL, threads, hist, hits);
+        if (ms < 0.0) {
+            printf("  [benchmark] %s: could not start the clients — skipped.\n",
+                   BACKEND_NAME[kind]);
+            replay_dict_free(&d);
+            continue;
+        }
+        note[0] = '\0';
+        if (kind == BK_BST || kind == BK_WBST)
+            snprintf(note, sizeof(note), ", weighted depth %.2f",
+                     wbst_weighted_depth(kind == BK_BST ? d.x.bst : d.x.wbst.root));
+        replay_report(BACKEND_NAME[kind], d.n, ms, log->count * threads, note,
+                      hist, hits, out);
+        replay_dict_free(&d);
+        done++;
     }
 
+    if (o.shards > 0) {
+        sd = sharded_load(path, FILE_WORD_FREQ, o.shards);
+        if (!sd) {
+            printf("  [benchmark] cannot shard %s — skipped.\n", path);
+        } else {
+            ms = replay_run(log, NULL, sd, threads, hist, hits);
+            if (ms < 0.0) {
+                printf("  [benchmark] Shard: could not start the clients — skipped.\n");
+            } else {
+                snprintf(note, sizeof(note), ", %d shard%s", sharded_shards(sd),
+                         sharded_shards(sd) == 1 ? "" : "s");
+                replay_report("Shard", sharded_count(sd, -1), ms, log->count * threads,
+                              note, hist, hits, out);
+                done++;
+            }
+            sharded_destroy(sd);
+        }
+    }
+    printf("\n");
+    return done ? 0 : -1;
+}
+
+void benchmark_run_suite(const BenchOptions *opt) {
+    BenchOptions o = BENCH_OPTIONS_INIT;
+    BenchSet     set;
+    FILE        *csv = NULL;
+    const char  *path;
+    uint64_t     start = bench_now_ns();
+    int          i, reps;
+
+    if (opt) o = *opt;
+    reps = o.reps < 1 ? 1 : (o.reps > BENCH_MAX_REPS ? BENCH_MAX_REPS : o.reps);
+    path = o.words_path ? o.words_path : FILE_WORDS;
+
     printf("\n");
     print_separator('=', 60);
-    printf("  Notes:\n");
-    printf("  BST  - Unbalanced; height depends on insertion order.\n");
-    printf("         Worst case O(n) for sorted input.\n");
-    printf("  AVL  - Self-balancing; height always O(log n).\n");
-    printf("         Slightly higher insert cost due to rotations.\n");
-    printf("  TBT  - Threaded BST; traverse needs no stack/recursion.\n");
-    printf("         Insert slightly costlier (thread pointer setup).\n");
+    printf("  BENCHMARK SUITE: BST vs AVL vs TBT vs B+ vs Trie\n");
+    printf("  Median of %d runs per timing, monotonic clock\n", reps);
+    print_separator('=', 60);
+
+    if (o.csv_path && o.csv_path[0] != '\0') {
+        csv = fopen(o.csv_path, "w");
+        if (csv)
+            fprintf(csv, "dataset,words,order,backend,operation,count,mean_ns,min_ns,"
+                         "p50_ns,p90_ns,p95_ns,p99_ns,p999_ns,max_ns\n");
+        else
+            printf("  [benchmark] cannot write %s — no CSV output.\n", o.csv_path);
+    }
+
+    if (path[0] != '\0') {
+        if (set_load(&set, path) == 0) {
+            suite_run_set(&set, reps, csv);
+            set_free(&set);
+            suite_load_save(path, reps);
+        } else {
+            printf("\n  [benchmark] cannot read %s — skipping the real data.\n", path);
+        }
+    }
+    for (i = 0; i < NUM_SUITE_SIZES && BENCH_SUITE_SIZES[i] <= o.max_words; i++) {
+        if (set_synthetic(&set, BENCH_SUITE_SIZES[i], 42u + (unsigned int)i) != 0) {
+            printf("\n  [benchmark] malloc failed for %d words — skipping.\n",
+                   BENCH_SUITE_SIZES[i]);
+            continue;
+        }
+        suite_run_set(&set, reps, csv);
+        set_free(&set);
+    }
+
+    if (csv) {
+        if (fclose(csv) == 0) printf("\n  Latency rows written to %s\n", o.csv_path);
+        else                  printf("\n  [benchmark] error writing %s\n", o.csv_path);
+    }
+    printf("\n  Suite finished in %.1f s.\n", ms_since(start) / 1000.0);
     print_separator('=', 60);
     printf("\n");
 }
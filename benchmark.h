@@ -2,24 +2,207 @@
 #ifndef BENCHMARK_H
 #define BENCHMARK_H
 
+#include <stdint.h>
+#include <stdio.h>
 #include "dictionary.h"
 #include "bst.h"
 #include "avl.h"
 #include "tbt.h"
+#include "bpt.h"
+#include "querylog.h"
 
 /*
- * Run the full benchmark suite comparing BST, AVL, and TBT.
+ * BenchResult - one measurement of the quick comparison.
+ *
+ *   words         dataset size it was taken at
+ *   backend       "BST", "AVL", "TBT", "B+", "BK", "SA", "DAWG" or "scale"
+ *   metric        what was measured, with its unit as a suffix
+ *                 ("insert_ms", "prefix_p99_us", "bytes", "height", ...)
+ *   lower_better  1 for timings and sizes, where a rise is a regression;
+ *                 0 for heights and counts, which are only reported
+ */
+typedef struct BenchResult {
+    int    words;
+    char   backend[8];
+    char   metric[32];
+    double value;
+    int    lower_better;
+} BenchResult;
+
+/* BenchResults - a growable list of results, in the order taken */
+typedef struct BenchResults {
+    BenchResult *items;
+    int          count;
+    int          cap;
+} BenchResults;
+
+/* Initialise an empty list. */
+void benchmark_results_init(BenchResults *r);
+
+/* Release the list; r is left empty and reusable. */
+void benchmark_results_free(BenchResults *r);
+
+/* The result for (words, backend, metric), or NULL. */
+const BenchResult *benchmark_results_find(const BenchResults *r, int words,
+                                          const char *backend, const char *metric);
+
+/*
+ * Run the quick comparison described at benchmark_run_all without
+ * printing anything, replacing what out held.  Returns 0, or -1 if
+ * nothing could be measured (out of memory).
+ */
+int benchmark_collect(BenchResults *out);
+
+/* The human-readable tables for r, as benchmark_run_all prints them:
+   a malloc'd string the caller frees, or NULL on malloc failure. */
+char *benchmark_results_text(const BenchResults *r);
+
+/*
+ * Write r to path: JSON if the name ends in ".json" (an object with a
+ * "results" array of {words, backend, metric, value, lower_better}),
+ * else CSV with the header "words,backend,metric,value,lower_better".
+ * Returns the number of results written, or -1 on an I/O error.
+ */
+int benchmark_results_save(const BenchResults *r, const char *path);
+
+/* Append the results of a CSV file written by benchmark_results_save.
+   Returns the number read, or -1 if the file cannot be opened. */
+int benchmark_results_load(BenchResults *r, const char *path);
+
+/*
+ * Compare cur against base, metric by metric.  Every lower_better result
+ * present in both that moved by more than threshold_pct percent is
+ * listed to out, rises flagged as regressions, followed by a summary
+ * line.  Returns the number of regressions.
+ */
+int benchmark_compare(const BenchResults *base, const BenchResults *cur,
+                      double threshold_pct, FILE *out);
+
+/* Default threshold for benchmark_compare, in percent: the quick timings
+   are short, and their run-to-run noise alone reaches a few percent */
+#define BENCH_REGRESSION_PCT  10
+
+/*
+ * Run the quick comparison of BST, AVL, TBT, and B+-tree.
  *
  * For each dataset size (500, 2000, 5000 words, pseudo-random insertion order):
  *   - Bulk insertion timing
  *   - Tree height after insertion
  *   - Repeated search timing (1000 lookups)
+ *   - Repeated top-10 autocomplete timing (1000 prefixes)
+ *   - The same 1000 prefixes answered as one batch (autocomplete_batch_*)
  *   - Full sorted traversal timing
+ *   - BK-tree build and 1000 typo queries, against a linear scan
+ *   - Suffix array build, size and 1000 substring queries, against strstr
+ *   - DAWG build, size against the records' keys and 1000 exact lookups
  *
- * Results are printed as a formatted comparison table to stdout.
+ * Then a scale trial at 1M and 2M words: RecordStore + AVL insertion in
+ * random order, B+ bulk build, 1000 exact lookups (store hash index and
+ * AVL) and 1000 top-10 prefix queries (AVL and B+).
+ *
+ * Results are gathered by benchmark_collect and printed as formatted
+ * comparison tables to stdout (benchmark_results_text).
  * All trees are built fresh for each trial and freed afterwards.
  * Random seed is fixed (srand=42) for reproducible word order.
  */
 void benchmark_run_all(void);
 
+/* Prefix lengths the suite times autocomplete at (1..BENCH_PREFIX_LENS) */
+#define BENCH_PREFIX_LENS     6
+
+/* Largest dataset the unbalanced BST (BST_SCAPEGOAT 0) is built from in
+   sorted or zig-zag order: each insert walks the whole chain, so the
+   build is O(n^2) */
+#define BENCH_DEGENERATE_MAX  10000
+
+/*
+ * BenchOptions - what benchmark_run_suite measures.
+ *
+ *   words_path  real word list (any format load_words reads), or NULL
+ *               for FILE_WORDS; "" skips the real-data runs
+ *   max_words   largest synthetic dataset (BENCH_SUITE_SIZES up to it)
+ *   reps        repetitions of every timing; the median is reported
+ *   csv_path    also write every latency distribution to this CSV file
+ *               (one row per dataset, backend and operation, in ns), or
+ *               NULL for none
+ */
+typedef struct BenchOptions {
+    const char *words_path;
+    int         max_words;
+    int         reps;
+    const char *csv_path;
+} BenchOptions;
+
+#define BENCH_OPTIONS_INIT  { NULL, 1000000, 3, NULL }
+
+/*
+ * The full suite, for every backend (BST, AVL, TBT, B+, trie) on each
+ * dataset — the real word list, then synthetic word lists of 10k, 100k
+ * and 1M entries (up to max_words):
+ *
+ *   - insertion in random, sorted and zig-zag order (ns per insert),
+ *     with the resulting height and index bytes per entry; without
+ *     BST_SCAPEGOAT the BST's degenerate orders are only run up to
+ *     BENCH_DEGENERATE_MAX words
+ *   - exact lookups that hit and that miss (ns per lookup)
+ *   - top-10 autocomplete latency per prefix length 1..BENCH_PREFIX_LENS
+ *     (us per query), prefixes taken from the dataset's own words
+ *   - deleting half the words in random order (ns per delete)
+ *   - in random order, each lookup and top-10 query timed on its own
+ *     into a latency histogram (histogram.h): mean, p50, p95, p99,
+ *     p99.9 and max per backend, for hits, misses and each prefix length
+ *
+ * and for the real list the load and save paths: text load and save,
+ * snapshot save and load, packed save and load (ms each), plus record
+ * store bytes per entry.  Every timing uses the monotonic clock
+ * (bench_now_ns) and is repeated opt->reps times.  opt may be NULL for
+ * the defaults.  Prints tables to stdout; takes minutes at 1M words.
+ */
+void benchmark_run_suite(const BenchOptions *opt);
+
+/* Most concurrent clients benchmark_replay runs */
+#define REPLAY_THREADS_MAX  64
+
+/*
+ * ReplayOptions - how benchmark_replay runs a query log.
+ *
+ *   words_path  word list replayed against, or NULL for FILE_WORDS
+ *   threads     concurrent clients (1..REPLAY_THREADS_MAX); each replays
+ *               the whole log, starting at its own offset into it
+ *   shards      if > 0, also replay against the word list split into
+ *               this many key-range shards (shard.h), after the backends
+ */
+typedef struct ReplayOptions {
+    const char *words_path;
+    int         threads;
+    int         shards;
+} ReplayOptions;
+
+#define REPLAY_OPTIONS_INIT  { NULL, 1, 0 }
+
+/*
+ * Replay a query log (querylog.h) against each backend — BST, AVL, TBT,
+ * B+, trie and the frequency-weighted BST (wbst.h) — each over a fresh
+ * load of the word list, so picks made while one backend replays never
+ * reach the next.  Lookups go to the
+ * backend's own search, prefix queries to its top-k autocomplete, and
+ * picks re-rank the shared records.  With several clients, queries run
+ * in parallel under a reader-writer lock and picks are applied by
+ * whichever client next gets the write side.  The sharded pass takes no
+ * lock of its own: the clients call the shards' workers directly, and a
+ * pick is applied by its shard at once.
+ *
+ * Prints, per backend, the wall time, throughput and per-operation
+ * count, hits and mean/p50/p95/p99/max latency, and for the two BSTs
+ * their weighted depth (wbst_weighted_depth) after the replay.  If out is non-NULL its
+ * contents are replaced by the mean and p99 per operation and the wall
+ * ns per event, for benchmark_results_save and benchmark_compare.
+ * Returns 0, or -1 if the log is empty or the word list cannot be read.
+ */
+int benchmark_replay(const QueryLog *log, const ReplayOptions *opt, BenchResults *out);
+
+/* Nanoseconds on a monotonic clock with an arbitrary origin:
+   QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere. */
+uint64_t bench_now_ns(void);
+
 #endif /* BENCHMARK_H */
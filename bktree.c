@@ -0,0 +1,248 @@
+/* bktree.c - BK-tree implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "bktree.h"
+#include "utils.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/*
+ * Query-side state for the bit-parallel distance: bit i of peq[c] is set
+ * where word[i] == c.  Words are < MAX_WORD_LEN = 64 characters, so one
+ * 64-bit column covers a whole word.
+ */
+typedef struct BKPattern {
+    uint64_t peq[256];
+    int      len;
+} BKPattern;
+
+static void pattern_init(BKPattern *p, const char *word, int len) {
+    int i;
+    memset(p->peq, 0, sizeof(p->peq));
+    p->len = len;
+    for (i = 0; i < len; i++) p->peq[(unsigned char)word[i]] |= (uint64_t)1 << i;
+}
+
+/*
+ * Levenshtein distance from p to t[0..n), or limit + 1 once it must
+ * exceed limit — Myers' bit-vector algorithm (Hyyro's formulation): each
+ * character of t advances the whole DP column with a few word-wide
+ * operations instead of a loop over p.  score tracks the bottom cell; it
+ * moves by at most one per character, so it is hopeless as soon as the
+ * characters left could not bring it back under limit.
+ */
+static int distance(const BKPattern *p, const char *t, int n, int limit) {
+    uint64_t pv = ~(uint64_t)0, mv = 0, eq, xv, xh, ph, mh, high;
+    int      m = p->len, score = m, j;
+
+    if (limit < 0 || limit > MAX_WORD_LEN) limit = MAX_WORD_LEN;
+    if (m - n > limit || n - m > limit) return limit + 1;
+    if (m == 0) return n;
+
+    high = (uint64_t)1 << (m - 1);
+    for (j = 0; j < n; j++) {
+        eq = p->peq[(unsigned char)t[j]];
+        xv = eq | mv;
+        xh = (((eq & pv) + pv) ^ pv) | eq;
+        ph = mv | ~(xh | pv);
+        mh = pv & xh;
+        if (ph & high)      score++;
+        else if (mh & high) score--;
+        if (score - (n - j - 1) > limit) return limit + 1;
+        ph = (ph << 1) | 1;             /* row 0 of the DP grows by one */
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score > limit ? limit + 1 : score;
+}
+
+static BKNode *new_node(BKTree *t, WordRecord *rec, int len, int dist) {
+    BKNode *n = (BKNode *)pool_alloc(&t->pool);
+    if (!n) { perror("bk_new_node: malloc"); exit(EXIT_FAILURE); }
+    memcpy(n->word, rec->word, (size_t)len + 1);
+    n->rec       = rec;
+    n->child     = NULL;
+    n->sibling   = NULL;
+    n->dist      = (unsigned char)dist;
+    n->max_child = 0;
+    n->len       = (unsigned char)len;
+    t->nodes++;
+    return n;
+}
+
+/* The node holding word (deleted or not), or NULL: one distance per level. */
+static BKNode *find_node(const BKTree *t, const BKPattern *p) {
+    BKNode *n = t->root;
+    int     d;
+    while (n) {
+        d = distance(p, n->word, n->len, n->max_child);
+        if (d == 0) return n;
+        for (n = n->child; n && n->dist < d; n = n->sibling)
+            ;
+        if (n && n->dist != d) return NULL;
+    }
+    return NULL;
+}
+
+static void build_preorder(BKTree *t, const AVLNode *n) {
+    for (; n; n = avl_right(n)) {
+        bk_insert(t, n->rec);
+        build_preorder(t, avl_left(n));
+    }
+}
+
+/* A suggestion search: the query and the best top_k found so far. */
+typedef struct BKQuery {
+    BKPattern    pat;
+    int          radius;              /* shrinks once best[] is full */
+    int          top_k, n;
+    WordRecord  *best[TOP_K_MAX];     /* nearest first */
+    int          dist[TOP_K_MAX];
+} BKQuery;
+
+/* 1 if (rec, d) ranks before slot i of best[]. */
+static int ranks_before(const BKQuery *q, const WordRecord *rec, int d, int i) {
+    return d < q->dist[i] || (d == q->dist[i] && word_record_outranks(rec, q->best[i]));
+}
+
+static void offer(BKQuery *q, WordRecord *rec, int d) {
+    int i;
+    if (q->n == q->top_k) {
+        if (!ranks_before(q, rec, d, q->n - 1)) return;
+        i = q->n - 1;                       /* the worst one drops out */
+    } else {
+        i = q->n++;
+    }
+    for (; i > 0 && ranks_before(q, rec, d, i - 1); i--) {
+        q->best[i] = q->best[i - 1];
+        q->dist[i] = q->dist[i - 1];
+    }
+    q->best[i] = rec;
+    q->dist[i] = d;
+    if (q->n == q->top_k) q->radius = q->dist[q->n - 1];
+}
+
+static void search(BKQuery *q, const BKNode *n) {
+    const BKNode *c;
+    /* Past radius + max_child neither n nor any child can qualify */
+    int d = distance(&q->pat, n->word, n->len, q->radius + n->max_child);
+
+    if (n->rec && d <= q->radius) offer(q, n->rec, d);
+    for (c = n->child; c && c->dist <= d + q->radius; c = c->sibling)
+        if (c->dist + q->radius >= d) search(q, c);
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void bk_init(BKTree *t) {
+    NodePool empty = NODE_POOL_INIT(BKNode);
+    if (!t) return;
+    t->root  = NULL;
+    t->count = 0;
+    t->nodes = 0;
+    t->pool  = empty;
+}
+
+int bk_insert(BKTree *t, WordRecord *rec) {
+    BKPattern p;
+    BKNode   *n, *c, **link;
+    int       len, d;
+
+    if (!t || !rec) return 0;
+    len = (int)strlen(rec->word);
+    if (!t->root) {
+        t->root = new_node(t, rec, len, 0);
+        t->count++;
+        return 1;
+    }
+
+    pattern_init(&p, rec->word, len);
+    for (n = t->root;; n = c) {
+        d = distance(&p, n->word, n->len, -1);
+        if (d == 0) {
+            if (n->rec) return 0;
+            n->rec = rec;                   /* revive a deleted word */
+            t->count++;
+            return 1;
+        }
+        for (link = &n->child; *link && (*link)->dist < d; link = &(*link)->sibling)
+            ;
+        c = *link;
+        if (!c || c->dist != d) {
+            c = new_node(t, rec, len, d);   /* keep the list sorted by dist */
+            c->sibling = *link;
+            *link      = c;
+            if (d > n->max_child) n->max_child = (unsigned char)d;
+            t->count++;
+            return 1;
+        }
+    }
+}
+
+int bk_delete(BKTree *t, const char *word) {
+    DictKey   key;
+    BKPattern p;
+    BKNode   *n;
+
+    if (!t || !word) return 0;
+    dict_key_init(&key, word);
+    pattern_init(&p, key.text, (int)strlen(key.text));
+    n = find_node(t, &p);
+    if (!n || !n->rec) return 0;
+    n->rec = NULL;                          /* keep routing through it */
+    t->count--;
+    return 1;
+}
+
+int bk_build(BKTree *t, AVLNode *avl_root) {
+    if (!t || t->root) return -1;
+    build_preorder(t, avl_root);
+    return t->count;
+}
+
+int bk_suggest(const BKTree *t, const char *word, int max_dist,
+               WordRecord *results, int top_k) {
+    DictKey key;
+    BKQuery q;
+    int     i;
+
+    if (!t || !t->root || !word || !results || max_dist < 0) return 0;
+    if (top_k > TOP_K_MAX) top_k = TOP_K_MAX;
+    if (top_k <= 0) return 0;
+
+    dict_key_init(&key, word);
+    pattern_init(&q.pat, key.text, (int)strlen(key.text));
+    q.radius = max_dist;
+    q.top_k  = top_k;
+    q.n      = 0;
+    search(&q, t->root);
+
+    for (i = 0; i < q.n; i++) results[i] = *q.best[i];
+    return q.n;
+}
+
+int bk_edit_distance(const char *a, const char *b, int limit) {
+    BKPattern   p;
+    const char *c;
+    int         i, la = (int)strlen(a);
+
+    /* Only the entries distance() reads need clearing: b's characters */
+    for (c = b; *c; c++) p.peq[(unsigned char)*c] = 0;
+    for (i = 0; i < la; i++) p.peq[(unsigned char)a[i]] = 0;
+    for (i = 0; i < la; i++) p.peq[(unsigned char)a[i]] |= (uint64_t)1 << i;
+    p.len = la;
+    return distance(&p, b, (int)(c - b), limit);
+}
+
+int bk_count(const BKTree *t) {
+    return t ? t->count : 0;
+}
+
+void bk_free(BKTree *t) {
+    if (!t) return;
+    pool_destroy(&t->pool);     /* O(slabs) — no per-node walk */
+    bk_init(t);
+}
@@ -0,0 +1,88 @@
+/* bktree.h - BK-tree over edit distance for typo-tolerant suggestions */
+#ifndef BKTREE_H
+#define BKTREE_H
+
+#include "dictionary.h"
+#include "avl.h"
+#include "pool.h"
+
+/*
+ * BKNode - one word of the BK-tree.
+ *
+ * Every child sits at a distinct edit distance (dist) from its parent, so
+ * by the triangle inequality a query q within r of some word below a
+ * node n at distance d = lev(q, n) can only be under the children with
+ * d - r <= dist <= d + r.  Children are a first-child / next-sibling
+ * list sorted by dist, which keeps the node fixed-size for the pool and
+ * lets a query stop at the first child past d + r.
+ *
+ * The word is held inline: a query touches tens of thousands of nodes
+ * scattered over the pool, and reading the text from a second place
+ * would double the cache misses.  It is a copy, not the record's text,
+ * so a deleted word stays in place as a routing node (rec == NULL) —
+ * unlinking it would orphan every child keyed by distance to it.
+ */
+typedef struct BKNode {
+    struct BKNode  *child;              /* first (nearest) child           */
+    struct BKNode  *sibling;            /* next child, larger dist         */
+    WordRecord     *rec;                /* shared record, or NULL once deleted */
+    unsigned char   dist;               /* edit distance to the parent     */
+    unsigned char   max_child;          /* largest dist among the children */
+    unsigned char   len;                /* strlen(word)                    */
+    char            word[MAX_WORD_LEN]; /* normalised text                 */
+} BKNode;
+
+/*
+ * BKTree - the tree handle.  Like the trie and B+-tree it owns its node
+ * pool, so bk_free releases everything in O(slabs).  Deleted words are
+ * only marked; the bulk build after the next load starts from a clean
+ * tree.
+ */
+typedef struct BKTree {
+    BKNode      *root;
+    int          count;      /* live words                          */
+    int          nodes;      /* nodes, deleted ones included        */
+    NodePool     pool;
+} BKTree;
+
+/* Initialise an empty tree (no allocation until the first insert). */
+void bk_init(BKTree *t);
+
+/*
+ * Insert rec under rec->word (already lowercase, as store_add guarantees).
+ * Re-inserting a deleted word revives its node.  Returns 1 if inserted,
+ * 0 on duplicate.  Exits on malloc failure, like the other trees.
+ */
+int bk_insert(BKTree *t, WordRecord *rec);
+
+/* Remove word (case-insensitive). Returns 1 if it was found. */
+int bk_delete(BKTree *t, const char *word);
+
+/* Insert every record of the AVL tree into the empty tree t (in
+   preorder, so the root is a mid-alphabet word rather than the first).
+   Returns the number of words, or -1 if t is not empty. */
+int bk_build(BKTree *t, AVLNode *avl_root);
+
+/*
+ * Up to top_k words within max_dist edits of word (case-insensitive),
+ * nearest first; equal distances rank like autocomplete (higher
+ * composite score, then alphabetical).  Copies them into results and
+ * returns how many.  Once top_k are held the search radius shrinks to
+ * the worst distance kept, so a close match prunes most of the tree.
+ */
+int bk_suggest(const BKTree *t, const char *word, int max_dist,
+               WordRecord *results, int top_k);
+
+/*
+ * Levenshtein distance between two normalised words, or limit + 1 as
+ * soon as it is known to exceed limit (a negative limit means none).
+ */
+int bk_edit_distance(const char *a, const char *b, int limit);
+
+/* Return the number of live words (O(1)). */
+int bk_count(const BKTree *t);
+
+/* Free every node; t is left empty and reusable. */
+void bk_free(BKTree *t);
+
+#endif /* BKTREE_H */
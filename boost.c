@@ -0,0 +1,156 @@
+/* boost.c - Per-user ranking boosts */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "boost.h"
+#include "config.h"
+#include "utils.h"
+
+/* ── Helpers ─────────────────────────────────────────────────── */
+
+/* Boosts live in the same range as frequency scores, so a boosted
+   score cannot overflow. */
+static int clamp_boost(long boost) {
+    if (boost < 0)              return 0;
+    if (boost > FREQ_SCORE_MAX) return FREQ_SCORE_MAX;
+    return (int)boost;
+}
+
+/* Index of the first entry whose word is not below key. */
+static int lower_bound(const BoostTable *t, const char *key) {
+    int lo = 0, hi = t->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (strcmp(t->entries[mid].word, key) < 0) lo = mid + 1;
+        else                                       hi = mid;
+    }
+    return lo;
+}
+
+/* The entry for word (any case), inserted empty if missing.  NULL on
+   malloc failure or an empty word. */
+static BoostEntry *entry_for(BoostTable *t, const char *word) {
+    char        key[MAX_WORD_LEN];
+    BoostEntry *e;
+    int         at;
+
+    str_tolower(key, word, sizeof(key));
+    if (key[0] == '\0') return NULL;
+    at = lower_bound(t, key);
+    if (at < t->count && strcmp(t->entries[at].word, key) == 0)
+        return &t->entries[at];
+
+    if (t->count == t->cap) {
+        int         cap   = t->cap ? t->cap * 2 : 16;
+        BoostEntry *grown = (BoostEntry *)realloc(t->entries,
+                                                  (size_t)cap * sizeof(BoostEntry));
+        if (!grown) return NULL;
+        t->entries = grown;
+        t->cap     = cap;
+    }
+    e = &t->entries[at];
+    memmove(e + 1, e, (size_t)(t->count - at) * sizeof(BoostEntry));
+    t->count++;
+    memcpy(e->word, key, sizeof(key));
+    e->boost       = 0;
+    e->select_time = 0;
+    return e;
+}
+
+/* Drop e if it no longer adds anything. */
+static void prune(BoostTable *t, BoostEntry *e) {
+    int at = (int)(e - t->entries);
+    if (e->boost > 0 || e->select_time != 0) return;
+    memmove(e, e + 1, (size_t)(t->count - at - 1) * sizeof(BoostEntry));
+    t->count--;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void boost_init(BoostTable *t) {
+    t->entries = NULL;
+    t->count   = 0;
+    t->cap     = 0;
+}
+
+int boost_set(BoostTable *t, const char *word, int boost) {
+    BoostEntry *e = entry_for(t, word);
+    if (!e) return -1;
+    e->boost = clamp_boost(boost);
+    prune(t, e);
+    return 0;
+}
+
+int boost_pick(BoostTable *t, const char *word) {
+    BoostEntry *e = entry_for(t, word);
+    if (!e) return -1;
+    e->select_time = score_add_picks(e->select_time, 1, score_minutes());
+    return 0;
+}
+
+int boost_entry_value(const BoostEntry *e) {
+    int v = e->boost;
+    if (e->select_time != 0) v += score_pick_weight(e->select_time, score_clock());
+    return v;
+}
+
+int boost_value(const BoostTable *t, const char *word) {
+    char key[MAX_WORD_LEN];
+    int  at;
+
+    if (!t || t->count == 0) return 0;
+    str_tolower(key, word, sizeof(key));
+    at = lower_bound(t, key);
+    if (at < t->count && strcmp(t->entries[at].word, key) == 0)
+        return boost_entry_value(&t->entries[at]);
+    return 0;
+}
+
+int boost_lower_bound(const BoostTable *t, const char *prefix) {
+    return lower_bound(t, prefix);
+}
+
+int boost_save(const BoostTable *t, const char *path) {
+    FILE *fp = fopen(path, "w");
+    int   i;
+
+    if (!fp) return -1;
+    for (i = 0; i < t->count; i++)
+        fprintf(fp, "%s|%d|%d\n", t->entries[i].word,
+                t->entries[i].boost, t->entries[i].select_time);
+    if (fclose(fp) != 0) return -1;
+    return t->count;
+}
+
+int boost_load(BoostTable *t, const char *path) {
+    FILE *fp = fopen(path, "r");
+    char  line[MAX_WORD_LEN + 32];
+    int   n = 0;
+
+    if (!fp) return -1;
+    while (fgets(line, sizeof(line), fp)) {
+        char       *bar = strchr(line, '|');
+        char       *end;
+        long        boost, stamp = 0;
+        BoostEntry *e;
+
+        if (!bar) continue;
+        *bar  = '\0';
+        boost = strtol(bar + 1, &end, 10);
+        if (end == bar + 1) continue;
+        if (*end == '|') stamp = strtol(end + 1, NULL, 10);
+        e = entry_for(t, line);
+        if (!e) continue;
+        e->boost       = clamp_boost(boost);
+        e->select_time = stamp > 0 ? (int)stamp : 0;
+        prune(t, e);
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+void boost_free(BoostTable *t) {
+    free(t->entries);
+    boost_init(t);
+}
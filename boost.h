@@ -0,0 +1,68 @@
+/* boost.h - Per-user ranking boosts layered over the shared scores */
+#ifndef BOOST_H
+#define BOOST_H
+
+#include "dictionary.h"
+
+/*
+ * BoostTable - one user's adjustments to the shared ranking: a fixed
+ * boost per word (a pinned favourite) plus that user's own picks, kept
+ * as a select_time stamp and decayed exactly like the shared ones
+ * (dictionary.h, "Ranking").
+ *
+ * The table never touches the records or the indexes, so every user is
+ * served from the same cached top-k: autocomplete_trie_boosted
+ * (autocomplete.h) re-scores the shared answer and merges in the user's
+ * own boosted words under the prefix.  That merge is exact because a
+ * boost only ever raises a score — a word missing from the shared top-k
+ * and from the table cannot outrank what is already there.
+ *
+ * Entries are kept sorted by word, so one lookup is a binary search and
+ * the entries under a prefix are one contiguous run.  A table is a few
+ * words per user, not a copy of the dictionary.
+ */
+typedef struct BoostEntry {
+    char word[MAX_WORD_LEN];   /* normalised                             */
+    int  boost;                /* fixed points added to the score        */
+    int  select_time;          /* this user's picks, 0 if none           */
+} BoostEntry;
+
+typedef struct BoostTable {
+    BoostEntry *entries;       /* sorted by word */
+    int         count;
+    int         cap;
+} BoostTable;
+
+/* Initialise an empty table. */
+void boost_init(BoostTable *t);
+
+/* Set word's fixed boost, clamped to 0..FREQ_SCORE_MAX.  Returns 0, or
+   -1 on malloc failure. */
+int boost_set(BoostTable *t, const char *word, int boost);
+
+/* Record a pick of word by this user, made now.  Returns 0, or -1 on
+   malloc failure. */
+int boost_pick(BoostTable *t, const char *word);
+
+/* Points e adds to its word's score at the current ranking clock. */
+int boost_entry_value(const BoostEntry *e);
+
+/* Points the table adds to word (any case); 0 if it has no entry. */
+int boost_value(const BoostTable *t, const char *word);
+
+/* Index of the first entry not below prefix (already normalised); the
+   entries starting with prefix follow it contiguously. */
+int boost_lower_bound(const BoostTable *t, const char *prefix);
+
+/*
+ * Save to / load from path, one "word|boost|select_time" line per entry.
+ * boost_load adds to what t holds.  Both return the number of entries
+ * written or read, or -1 if the file cannot be opened.
+ */
+int boost_save(const BoostTable *t, const char *path);
+int boost_load(BoostTable *t, const char *path);
+
+/* Release the entries; t is left empty and reusable. */
+void boost_free(BoostTable *t);
+
+#endif /* BOOST_H */
@@ -0,0 +1,413 @@
+/* bpt.c - B+-tree implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bpt.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* A node split on the way up: the new right sibling and its separator. */
+typedef struct BPTSplit {
+    void       *right;   /* NULL if the child did not split */
+    const char *sep;
+    uint64_t    pfx;
+} BPTSplit;
+
+static BPTLeaf *new_leaf(BPTree *t) {
+    BPTLeaf *l = (BPTLeaf *)pool_alloc(&t->leaves);
+    if (!l) { perror("bpt_new_leaf: malloc"); exit(EXIT_FAILURE); }
+    l->next = NULL;
+    l->n    = 0;
+    return l;
+}
+
+static BPTInner *new_inner(BPTree *t) {
+    BPTInner *in = (BPTInner *)pool_alloc(&t->inners);
+    if (!in) { perror("bpt_new_inner: malloc"); exit(EXIT_FAILURE); }
+    in->n = 0;
+    return in;
+}
+
+static const char *copy_sep(BPTree *t, const char *word) {
+    const char *s = arena_strdup(&t->seps, word);
+    if (!s) { perror("bpt_copy_sep: malloc"); exit(EXIT_FAILURE); }
+    return s;
+}
+
+/* Index of the first key of l that is >= (p, w). */
+static int leaf_lower(const BPTLeaf *l, uint64_t p, const char *w) {
+    int i = 0;
+    while (i < l->n &&
+           (l->pfx[i] < p || (l->pfx[i] == p && strcmp(l->rec[i]->word, w) < 0)))
+        i++;
+    return i;
+}
+
+/* Child of in that routes (p, w): the number of separators <= it. */
+static int inner_child(const BPTInner *in, uint64_t p, const char *w) {
+    int i = 0;
+    while (i < in->n &&
+           (in->pfx[i] < p || (in->pfx[i] == p && strcmp(in->sep[i], w) <= 0)))
+        i++;
+    return i;
+}
+
+/* Walk from the root to the leaf whose range holds (p, w). */
+static BPTLeaf *find_leaf(const BPTree *t, uint64_t p, const char *w) {
+    void *node = t->root;
+    int   level;
+    for (level = t->height; level > 1; level--) {
+        const BPTInner *in = (const BPTInner *)node;
+        node = in->child[inner_child(in, p, w)];
+    }
+    return (BPTLeaf *)node;
+}
+
+static void leaf_put(BPTLeaf *l, int i, WordRecord *rec, uint64_t p) {
+    memmove(&l->pfx[i + 1], &l->pfx[i], (size_t)(l->n - i) * sizeof(l->pfx[0]));
+    memmove(&l->rec[i + 1], &l->rec[i], (size_t)(l->n - i) * sizeof(l->rec[0]));
+    l->pfx[i] = p;
+    l->rec[i] = rec;
+    l->n++;
+}
+
+/* Add separator i (and child i + 1 to its right) to a non-full node. */
+static void inner_put(BPTInner *in, int i, const BPTSplit *s) {
+    memmove(&in->pfx[i + 1],   &in->pfx[i],   (size_t)(in->n - i) * sizeof(in->pfx[0]));
+    memmove(&in->sep[i + 1],   &in->sep[i],   (size_t)(in->n - i) * sizeof(in->sep[0]));
+    memmove(&in->child[i + 2], &in->child[i + 1],
+            (size_t)(in->n - i) * sizeof(in->child[0]));
+    in->pfx[i]       = s->pfx;
+    in->sep[i]       = s->sep;
+    in->child[i + 1] = s->right;
+    in->n++;
+}
+
+/* Split a full leaf around the insert position i; the lower half stays. */
+static void leaf_split_put(BPTree *t, BPTLeaf *l, int i, WordRecord *rec,
+                           uint64_t p, BPTSplit *out) {
+    BPTLeaf *r    = new_leaf(t);
+    int      half = BPT_LEAF_KEYS / 2;
+
+    r->n = BPT_LEAF_KEYS - half;
+    memcpy(r->pfx, &l->pfx[half], (size_t)r->n * sizeof(l->pfx[0]));
+    memcpy(r->rec, &l->rec[half], (size_t)r->n * sizeof(l->rec[0]));
+    l->n    = half;
+    r->next = l->next;
+    l->next = r;
+
+    if (i <= half) leaf_put(l, i, rec, p);
+    else           leaf_put(r, i - half, rec, p);
+
+    out->right = r;
+    out->sep   = copy_sep(t, r->rec[0]->word);
+    out->pfx   = r->pfx[0];
+}
+
+/*
+ * Split a full inner node that must also take s at separator index i.
+ * Of the BPT_INNER_KEYS + 1 separators the middle one moves up into out;
+ * the lower ones stay in in, the upper ones go to the new right node.
+ */
+static void inner_split_put(BPTree *t, BPTInner *in, int i, const BPTSplit *s,
+                            BPTSplit *out) {
+    uint64_t    pfx[BPT_INNER_KEYS + 1];
+    const char *sep[BPT_INNER_KEYS + 1];
+    void       *child[BPT_INNER_KEYS + 2];
+    BPTInner   *r   = new_inner(t);
+    int         all = BPT_INNER_KEYS + 1;
+    int         mid = all / 2;
+    int         j;
+
+    /* Lay out the overfull node in temporaries, then cut it */
+    for (j = 0; j < i; j++) { pfx[j] = in->pfx[j]; sep[j] = in->sep[j]; }
+    pfx[i] = s->pfx;
+    sep[i] = s->sep;
+    for (j = i; j < in->n; j++) { pfx[j + 1] = in->pfx[j]; sep[j + 1] = in->sep[j]; }
+    for (j = 0; j <= i; j++) child[j] = in->child[j];
+    child[i + 1] = s->right;
+    for (j = i + 1; j <= in->n; j++) child[j + 1] = in->child[j];
+
+    in->n = mid;
+    for (j = 0; j < mid; j++) { in->pfx[j] = pfx[j]; in->sep[j] = sep[j]; }
+    for (j = 0; j <= mid; j++) in->child[j] = child[j];
+
+    r->n = all - mid - 1;
+    for (j = 0; j < r->n; j++) {
+        r->pfx[j] = pfx[mid + 1 + j];
+        r->sep[j] = sep[mid + 1 + j];
+    }
+    for (j = 0; j <= r->n; j++) r->child[j] = child[mid + 1 + j];
+
+    out->right = r;
+    out->sep   = sep[mid];
+    out->pfx   = pfx[mid];
+}
+
+/*
+ * Insert below node, which sits level levels above the leaves (1 = leaf).
+ * Returns 1 if inserted, 0 on duplicate; a split of node is reported in
+ * *out for the caller to link in.
+ */
+static int insert_at(BPTree *t, void *node, int level, WordRecord *rec,
+                     uint64_t p, BPTSplit *out) {
+    const char *w = rec->word;
+    BPTSplit    sub;
+    int         i, added;
+
+    if (level == 1) {
+        BPTLeaf *l = (BPTLeaf *)node;
+        i = leaf_lower(l, p, w);
+        if (i < l->n && l->pfx[i] == p && strcmp(l->rec[i]->word, w) == 0)
+            return 0;
+        if (l->n < BPT_LEAF_KEYS) leaf_put(l, i, rec, p);
+        else                      leaf_split_put(t, l, i, rec, p, out);
+        return 1;
+    }
+
+    {
+        BPTInner *in = (BPTInner *)node;
+        i         = inner_child(in, p, w);
+        sub.right = NULL;
+        added     = insert_at(t, in->child[i], level - 1, rec, p, &sub);
+        if (sub.right) {
+            if (in->n < BPT_INNER_KEYS) inner_put(in, i, &sub);
+            else                        inner_split_put(t, in, i, &sub, out);
+        }
+        return added;
+    }
+}
+
+static void collect_cb(AVLNode *node, void *arg) {
+    WordRecord ***out = (WordRecord ***)arg;
+    *(*out)++ = node->rec;
+}
+
+/* Count every key under node, level levels above the leaves (1: node is
+   a leaf), reached with c compares so far.  Each node is scanned left to
+   right up to the first key past the target (inner_child, leaf_lower). */
+static void bpt_shape_impl(const BPTree *t, const void *node, int level, int c,
+                           TreeShape *s) {
+    int i;
+    if (level == 1) {
+        const BPTLeaf *l = (const BPTLeaf *)node;
+        for (i = 0; i < l->n; i++) shape_add(s, t->height, c + i + 1);
+    } else {
+        const BPTInner *in = (const BPTInner *)node;
+        for (i = 0; i <= in->n; i++)
+            bpt_shape_impl(t, in->child[i], level - 1, c + i + (i < in->n), s);
+    }
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void bpt_init(BPTree *t) {
+    NodePool empty_leaves = NODE_POOL_INIT(BPTLeaf);
+    NodePool empty_inners = NODE_POOL_INIT(BPTInner);
+    if (!t) return;
+    t->root   = NULL;
+    t->height = 0;
+    t->count  = 0;
+    t->first  = NULL;
+    t->leaves = empty_leaves;
+    t->inners = empty_inners;
+    arena_init(&t->seps);
+}
+
+int bpt_insert(BPTree *t, WordRecord *rec) {
+    BPTSplit split;
+    int      added;
+
+    if (!t || !rec) return 0;
+    if (!t->root) {
+        t->first  = new_leaf(t);
+        t->root   = t->first;
+        t->height = 1;
+    }
+
+    split.right = NULL;
+    added = insert_at(t, t->root, t->height, rec, dict_word_prefix(rec->word), &split);
+    if (split.right) {
+        /* The root split: grow a level */
+        BPTInner *root = new_inner(t);
+        root->n        = 1;
+        root->pfx[0]   = split.pfx;
+        root->sep[0]   = split.sep;
+        root->child[0] = t->root;
+        root->child[1] = split.right;
+        t->root        = root;
+        t->height++;
+    }
+    t->count += added;
+    return added;
+}
+
+int bpt_delete(BPTree *t, const char *word) {
+    DictKey  key;
+    BPTLeaf *l;
+    uint64_t p;
+    int      i;
+
+    if (!t || !t->root) return 0;
+    dict_key_init(&key, word);
+    p = dict_word_prefix(key.text);
+    l = find_leaf(t, p, key.text);
+    i = leaf_lower(l, p, key.text);
+    if (i == l->n || l->pfx[i] != p || strcmp(l->rec[i]->word, key.text) != 0)
+        return 0;
+
+    l->n--;
+    memmove(&l->pfx[i], &l->pfx[i + 1], (size_t)(l->n - i) * sizeof(l->pfx[0]));
+    memmove(&l->rec[i], &l->rec[i + 1], (size_t)(l->n - i) * sizeof(l->rec[0]));
+    if (--t->count == 0) bpt_free(t);   /* drop the empty shell */
+    return 1;
+}
+
+WordRecord *bpt_search(const BPTree *t, const char *word) {
+    DictKey key;
+    dict_key_init(&key, word);
+    return bpt_search_normalized(t, &key);
+}
+
+WordRecord *bpt_search_normalized(const BPTree *t, const DictKey *key) {
+    BPTLeaf *l;
+    int      i;
+
+    /* A present key lives in the leaf it routes to, never further right */
+    l = bpt_lower_bound(t, key, &i);
+    if (!l || i == l->n || strcmp(l->rec[i]->word, key->text) != 0) return NULL;
+    return l->rec[i];
+}
+
+BPTLeaf *bpt_lower_bound(const BPTree *t, const DictKey *key, int *pos) {
+    uint64_t p;
+    BPTLeaf *l;
+
+    if (!t || !t->root) return NULL;
+    p    = dict_word_prefix(key->text);
+    l    = find_leaf(t, p, key->text);
+    *pos = leaf_lower(l, p, key->text);
+    return l;
+}
+
+int bpt_build_from_sorted(BPTree *t, WordRecord **recs, int n) {
+    const int    fanout = BPT_INNER_KEYS + 1;
+    void       **level;
+    const char **lo;     /* smallest word under level[j] */
+    BPTLeaf     *prev = NULL;
+    int          m, j, g;
+
+    if (!t || t->root || n < 0) return -1;
+    if (n == 0) return 0;
+
+    m     = (n + BPT_LEAF_KEYS - 1) / BPT_LEAF_KEYS;
+    level = (void **)malloc((size_t)m * sizeof(void *));
+    lo    = (const char **)malloc((size_t)m * sizeof(const char *));
+    if (!level || !lo) {
+        fprintf(stderr, "[ERROR] bpt_build_from_sorted: malloc failed\n");
+        free(level);
+        free((void *)lo);
+        return -1;
+    }
+
+    /* Leaves: full, left to right, chained as they are made */
+    for (j = 0; j < m; j++) {
+        BPTLeaf *l = new_leaf(t);
+        int      k;
+        l->n = n - j * BPT_LEAF_KEYS < BPT_LEAF_KEYS ? n - j * BPT_LEAF_KEYS
+                                                     : BPT_LEAF_KEYS;
+        for (k = 0; k < l->n; k++) {
+            l->rec[k] = recs[j * BPT_LEAF_KEYS + k];
+            l->pfx[k] = dict_word_prefix(l->rec[k]->word);
+        }
+        if (prev) prev->next = l;
+        else      t->first   = l;
+        prev     = l;
+        level[j] = l;
+        lo[j]    = l->rec[0]->word;
+    }
+    t->height = 1;
+
+    /* Inner levels: spread each level's nodes evenly over the fewest
+       parents, rewriting level[] in place (parent g <= its first child) */
+    while (m > 1) {
+        int groups = (m + fanout - 1) / fanout;
+        for (g = 0; g < groups; g++) {
+            int       begin = (int)((long)g * m / groups);
+            int       end   = (int)((long)(g + 1) * m / groups);
+            BPTInner *in    = new_inner(t);
+            in->n = end - begin - 1;
+            for (j = begin; j < end; j++) {
+                in->child[j - begin] = level[j];
+                if (j > begin) {
+                    in->sep[j - begin - 1] = copy_sep(t, lo[j]);
+                    in->pfx[j - begin - 1] = dict_word_prefix(lo[j]);
+                }
+            }
+            lo[g]    = lo[begin];
+            level[g] = in;
+        }
+        m = groups;
+        t->height++;
+    }
+
+    t->root  = level[0];
+    t->count = n;
+    free(level);
+    free((void *)lo);
+    return n;
+}
+
+int bpt_build(BPTree *t, AVLNode *avl_root) {
+    WordRecord **recs, **out;
+    int          n = avl_count(avl_root);
+
+    if (!t || t->root) return -1;
+    if (n == 0) return 0;
+    recs = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *));
+    if (!recs) {
+        fprintf(stderr, "[ERROR] bpt_build: malloc failed\n");
+        return -1;
+    }
+    out = recs;
+    avl_inorder(avl_root, collect_cb, &out);   /* already sorted, unique */
+    n = bpt_build_from_sorted(t, recs, n);
+    free(recs);
+    return n;
+}
+
+void bpt_inorder(const BPTree *t, void (*callback)(WordRecord *, void *), void *arg) {
+    const BPTLeaf *l;
+    int            i;
+    if (!t || !callback) return;
+    for (l = t->first; l; l = l->next)
+        for (i = 0; i < l->n; i++) callback(l->rec[i], arg);
+}
+
+int bpt_count(const BPTree *t) {
+    return t ? t->count : 0;
+}
+
+int bpt_height(const BPTree *t) {
+    return t ? t->height : 0;
+}
+
+void bpt_shape(const BPTree *t, TreeShape *s) {
+    if (t && t->root) bpt_shape_impl(t, t->root, t->height, 0, s);
+}
+
+void bpt_memory(const BPTree *t, MemUsage *u) {
+    if (!t) return;
+    pool_memory(&t->leaves, u);
+    pool_memory(&t->inners, u);
+    arena_memory(&t->seps, u);
+    u->entries += (size_t)t->count;
+}
+
+void bpt_free(BPTree *t) {
+    if (!t) return;
+    pool_destroy(&t->leaves);   /* O(slabs) — no per-node walk */
+    pool_destroy(&t->inners);
+    arena_free(&t->seps);
+    bpt_init(t);
+}
@@ -0,0 +1,125 @@
+/* bpt.h - B+-tree with wide nodes and a linked leaf chain */
+#ifndef BPT_H
+#define BPT_H
+
+#include <stdint.h>
+#include "dictionary.h"
+#include "avl.h"
+#include "pool.h"
+#include "arena.h"
+
+/* Keys per leaf and separators per inner node (fan-out BPT_INNER_KEYS+1) */
+#define BPT_LEAF_KEYS   16
+#define BPT_INNER_KEYS  15
+
+/*
+ * BPTLeaf / BPTInner - the two node kinds of the B+-tree.
+ *
+ * Every record sits in a leaf, in sorted order, and the leaves are linked
+ * left to right, so an ordered walk is a sequential scan of a few wide
+ * nodes instead of one pointer chase per word.  Inner nodes only route:
+ * child[i] holds the words w with sep[i-1] <= w < sep[i].
+ *
+ * Both kinds keep each key's packed 8-byte prefix (dict_word_prefix)
+ * inline, so a node is searched with integer compares over two cache
+ * lines of prefixes; a string compare is only needed between words that
+ * share their first 8 bytes.  Separators are copies (the tree's arena),
+ * never borrowed record text, so deleting the record a separator was
+ * taken from leaves the routing intact.
+ */
+typedef struct BPTLeaf {
+    uint64_t         pfx[BPT_LEAF_KEYS];   /* packed prefixes of rec[]      */
+    WordRecord      *rec[BPT_LEAF_KEYS];   /* shared records, sorted        */
+    struct BPTLeaf  *next;                 /* right neighbour, NULL at end  */
+    int              n;                    /* keys in use                   */
+} BPTLeaf;
+
+typedef struct BPTInner {
+    uint64_t     pfx[BPT_INNER_KEYS];       /* packed prefixes of sep[]     */
+    const char  *sep[BPT_INNER_KEYS];       /* separator words (arena)      */
+    void        *child[BPT_INNER_KEYS + 1]; /* BPTInner, or BPTLeaf one     */
+                                            /* level above the leaves       */
+    int          n;                         /* separators; n + 1 children   */
+} BPTInner;
+
+/*
+ * BPTree - the tree handle.  Like the trie it owns its node pools and
+ * separator arena, so bpt_free releases everything in O(slabs + blocks).
+ *
+ * Inserts split full nodes bottom-up; the tree grows at the root, so all
+ * leaves stay at the same depth.  Deletes remove the key from its leaf
+ * and never merge: a leaf may run below half full (or empty — empty
+ * leaves stay in the chain and scans step over them), and separators
+ * remain valid bounds.  Dictionary churn is small next to a load, and
+ * the bulk build after each load packs the leaves full again.
+ */
+typedef struct BPTree {
+    void        *root;     /* BPTLeaf if height == 1, else BPTInner   */
+    int          height;   /* levels including the leaves; 0 if empty  */
+    int          count;    /* words stored                             */
+    BPTLeaf     *first;    /* leftmost leaf: head of the leaf chain    */
+    NodePool     leaves;
+    NodePool     inners;
+    StringArena  seps;     /* separator text                           */
+} BPTree;
+
+/* Initialise an empty tree (no allocation until the first insert). */
+void bpt_init(BPTree *t);
+
+/*
+ * Insert rec under rec->word. The leaf references rec (no copy);
+ * rec->word must already be lowercase, as store_add guarantees.
+ * Returns 1 if inserted, 0 on duplicate.  Exits on malloc failure,
+ * like the AVL and TBT.
+ */
+int bpt_insert(BPTree *t, WordRecord *rec);
+
+/* Remove word (case-insensitive). Returns 1 if it was found. */
+int bpt_delete(BPTree *t, const char *word);
+
+/* Search for word (case-insensitive). Returns its record, or NULL. */
+WordRecord *bpt_search(const BPTree *t, const char *word);
+
+/* Same as bpt_search for a key already normalised with dict_key_init. */
+WordRecord *bpt_search_normalized(const BPTree *t, const DictKey *key);
+
+/*
+ * Position of the first word >= key: returns its leaf and stores the
+ * index in *pos (possibly == leaf->n, meaning "start of leaf->next").
+ * Returns NULL for an empty tree.  Scan on through leaf->rec[] and the
+ * next links for an ordered range.
+ */
+BPTLeaf *bpt_lower_bound(const BPTree *t, const DictKey *key, int *pos);
+
+/*
+ * Bulk-build the tree from recs[0..n), which must be sorted by word with
+ * no duplicates, filling every leaf.  O(n).  The tree must be empty.
+ * Returns n, or -1 if the tree is not empty or on malloc failure.
+ */
+int bpt_build_from_sorted(BPTree *t, WordRecord **recs, int n);
+
+/* Bulk-build the empty tree t from an inorder walk of the AVL tree.
+   Returns the number of words, or -1 (see bpt_build_from_sorted). */
+int bpt_build(BPTree *t, AVLNode *avl_root);
+
+/* Visit every record in sorted order (a scan of the leaf chain). */
+void bpt_inorder(const BPTree *t, void (*callback)(WordRecord *, void *), void *arg);
+
+/* Return the number of words stored (O(1)). */
+int bpt_count(const BPTree *t);
+
+/* Return the number of levels, leaves included (0 for an empty tree). */
+int bpt_height(const BPTree *t);
+
+/* Add every key to s (shape.h): all at depth height, with the compares
+   of the node scans on the way down. */
+void bpt_shape(const BPTree *t, TreeShape *s);
+
+/* Add the tree to u (memusage.h): leaves and inner nodes, separator
+   text as strings. */
+void bpt_memory(const BPTree *t, MemUsage *u);
+
+/* Free every node and separator; t is left empty and reusable. */
+void bpt_free(BPTree *t);
+
+#endif /* BPT_H */
@@ -3,8 +3,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include "bst.h"
+#include "pool.h"
+#include "stats.h"
 #include "utils.h"
 
+/* Every BSTNode of every BST comes from this pool (see pool.h) */
+static NodePool bst_pool = NODE_POOL_INIT(BSTNode);
+
 /* ── Private helpers ─────────────────────────────────────────── */
 
 /* Return the leftmost (minimum-key) node in a subtree. */
@@ -14,96 +19,274 @@ static BSTNode *bst_min_node(BSTNode *node) {
     return node;
 }
 
+#if BST_SCAPEGOAT
 /*
- * Recursive delete helper. 'lw' is the pre-lowercased target word.
- * Left recursive: delete is O(depth) in call-stack usage, but after
- * the preorder-save fix the tree height stays ~50, making this safe.
+ * 1 if n, whose size is already updated for an insert or delete below
+ * it, is out of weight balance: one child holds more than BST_ALPHA of
+ * its nodes.  off is the size of the child off the update path, which
+ * the update does not touch; the child on the path holds the rest.
  */
-static void bst_delete_impl(BSTNode **root, const char *lw) {
-    int cmp;
-    BSTNode *tmp;
-    BSTNode *succ;
-
-    if (!*root) return;
-
-    cmp = strcmp(lw, (*root)->data.word);
-    if      (cmp < 0) { bst_delete_impl(&(*root)->left,  lw); return; }
-    else if (cmp > 0) { bst_delete_impl(&(*root)->right, lw); return; }
-
-    /* Found the node to delete */
-    if (!(*root)->left && !(*root)->right) {
-        /* Case 1: leaf */
-        free(*root);
-        *root = NULL;
-    } else if (!(*root)->left) {
-        /* Case 2a: only right child */
-        tmp = *root;
-        *root = (*root)->right;
-        free(tmp);
-    } else if (!(*root)->right) {
-        /* Case 2b: only left child */
-        tmp = *root;
-        *root = (*root)->left;
-        free(tmp);
+static int out_of_balance(const BSTNode *n, int off) {
+    int on = n->size - 1 - off;
+    return (on > off ? on : off) > BST_ALPHA * n->size;
+}
+#define NOTE_SCAPEGOAT(goat, link, off) \
+    do { if (!(goat) && out_of_balance(*(link), (off))) (goat) = (link); } while (0)
+#else
+#define NOTE_SCAPEGOAT(goat, link, off)  ((void)(goat))
+#endif
+
+/*
+ * Iterative delete, safe on any depth. 'lw' is the pre-lowercased target
+ * word.  A first walk finds the node; only then does a second walk down
+ * the same path shrink the subtree sizes, on to the inorder successor
+ * when the node has two children (it takes the successor's record, and
+ * the successor, which has no left child, is the node unlinked).  In
+ * scapegoat mode that walk also notes the highest node left out of
+ * balance, and its subtree is rebuilt at the end.  Returns 1 if a node
+ * was removed.
+ */
+static int bst_delete_impl(BSTNode **root, const char *lw) {
+    BSTNode **cur = root, **link, **goat = NULL;
+    BSTNode  *node, *n, *gone;
+    int       cmp;
+
+    while (*cur) {
+        STATS_VISIT();
+        cmp = str_key_cmp(lw, (*cur)->rec->word);
+        if (cmp == 0) break;
+        cur = cmp < 0 ? &(*cur)->left : &(*cur)->right;
+    }
+    if (!*cur) return 0;
+    node = *cur;
+
+    for (link = root; *link != node; ) {
+        n = *link;
+        n->size--;
+        if (str_key_cmp(lw, n->rec->word) < 0) {
+            NOTE_SCAPEGOAT(goat, link, bst_count(n->right));
+            link = &n->left;
+        } else {
+            NOTE_SCAPEGOAT(goat, link, bst_count(n->left));
+            link = &n->right;
+        }
+    }
+
+    if (node->left && node->right) {
+        node->size--;
+        NOTE_SCAPEGOAT(goat, cur, bst_count(node->left));
+        for (link = &node->right; (*link)->left; link = &(*link)->left) {
+            (*link)->size--;
+            NOTE_SCAPEGOAT(goat, link, bst_count((*link)->right));
+        }
+        gone       = *link;
+        node->rec  = gone->rec;                 /* take over the record */
+        *link      = gone->right;
     } else {
-        /* Case 3: two children — use inorder successor */
-        succ = bst_min_node((*root)->right);
-        (*root)->data = succ->data;                        /* struct copy */
-        bst_delete_impl(&(*root)->right, succ->data.word); /* delete successor */
+        gone = node;
+        *cur = node->left ? node->left : node->right;
+    }
+    pool_release(&bst_pool, gone);
+#if BST_SCAPEGOAT
+    if (goat) bst_rebalance(goat);
+#endif
+    return 1;
+}
+
+/* Midpoint build of recs[lo..hi]: subtree sizes differ by at most one. */
+static BSTNode *bst_build_range(WordRecord **recs, int lo, int hi) {
+    BSTNode *node;
+    int      mid;
+
+    if (lo > hi) return NULL;
+    mid  = lo + (hi - lo) / 2;
+    node = bst_new_node(recs[mid]);
+    if (!node) return NULL;
+    node->left  = bst_build_range(recs, lo, mid - 1);
+    node->right = bst_build_range(recs, mid + 1, hi);
+    node->size  = 1 + bst_count(node->left) + bst_count(node->right);
+    return node;
+}
+
+/* Midpoint relink of nodes[lo..hi] (in key order) into a balanced
+   subtree, reusing the nodes as they are. */
+static BSTNode *relink_range(BSTNode **nodes, int lo, int hi) {
+    BSTNode *node;
+    int      mid;
+
+    if (lo > hi) return NULL;
+    mid   = lo + (hi - lo) / 2;
+    node  = nodes[mid];
+    node->left  = relink_range(nodes, lo, mid - 1);
+    node->right = relink_range(nodes, mid + 1, hi);
+    node->size  = hi - lo + 1;
+    return node;
+}
+
+/* ── Read-only iterator ──────────────────────────────────────── */
+
+/*
+ * Push n onto the iterator's stack, moving it from the inline frames to
+ * the heap (and doubling it there) when full.  On malloc failure the
+ * stack is dropped and the iterator continues in seek mode.
+ */
+static void iter_push(BSTIter *it, BSTNode *n) {
+    BSTNode **grown;
+    int       cap;
+
+    if (it->seek) return;
+    if (it->depth == it->cap) {
+        cap = it->cap * 2;
+        if (it->stack == it->frames) {
+            grown = (BSTNode **)malloc((size_t)cap * sizeof(BSTNode *));
+            if (grown) memcpy(grown, it->frames, sizeof(it->frames));
+        } else {
+            grown = (BSTNode **)realloc(it->stack, (size_t)cap * sizeof(BSTNode *));
+        }
+        if (!grown) {
+            if (it->stack != it->frames) free(it->stack);
+            it->stack = it->frames;
+            it->depth = 0;
+            it->seek  = 1;
+            return;
+        }
+        it->stack = grown;
+        it->cap   = cap;
+    }
+    it->stack[it->depth++] = n;
+}
+
+static void iter_push_left_spine(BSTIter *it, BSTNode *n) {
+    for (; n; n = n->left) iter_push(it, n);
+}
+
+/* Seek mode: the inorder successor of last (the minimum if last is
+   NULL), found by one descent from the root.  O(height), no memory. */
+static BSTNode *seek_inorder_next(const BSTIter *it) {
+    BSTNode *cur = it->root, *best = NULL;
+    if (!it->last) return bst_min_node(cur);
+    while (cur) {
+        if (str_key_cmp(cur->rec->word, it->last->rec->word) > 0) {
+            best = cur;
+            cur  = cur->left;
+        } else {
+            cur = cur->right;
+        }
+    }
+    return best;
+}
+
+/* Seek mode: the preorder successor of last (the root if last is NULL):
+   its first child, or else the right child of the deepest ancestor that
+   last lies to the left of. */
+static BSTNode *seek_preorder_next(const BSTIter *it) {
+    BSTNode *cur = it->root, *pending = NULL;
+    BSTNode *last = it->last;
+    int      cmp;
+
+    if (!last)       return cur;
+    if (last->left)  return last->left;
+    if (last->right) return last->right;
+    while (cur && cur != last) {
+        cmp = str_key_cmp(last->rec->word, cur->rec->word);
+        if (cmp < 0) {
+            if (cur->right) pending = cur->right;
+            cur = cur->left;
+        } else {
+            cur = cur->right;
+        }
     }
+    return pending;
 }
 
 /* ── Public API ──────────────────────────────────────────────── */
 
-BSTNode *bst_new_node(const WordRecord *rec) {
+BSTNode *bst_new_node(WordRecord *rec) {
     BSTNode *node;
     if (!rec) return NULL;
-    node = (BSTNode *)malloc(sizeof(BSTNode));
+    node = (BSTNode *)pool_alloc(&bst_pool);
     if (!node) {
         fprintf(stderr, "bst_new_node: malloc failed\n");
         return NULL;
     }
-    node->data  = *rec;   /* full struct copy — safe, no heap pointers */
+    node->rec   = rec;    /* shared — the store owns the record */
     node->left  = NULL;
     node->right = NULL;
+    node->size  = 1;
     return node;
 }
 
+void bst_release_node(BSTNode *node) {
+    if (node) pool_release(&bst_pool, node);
+}
+
 /*
  * Iterative insert — avoids stack overflow on skewed/sorted input.
  * Walks the tree with a pointer-to-pointer cursor; no recursion needed.
+ * Subtree sizes are only bumped once the key is known to be new, by a
+ * second walk down the same path.  In scapegoat mode that walk notes the
+ * highest node the new key puts out of weight balance, and its subtree
+ * is rebuilt in place (bst_rebalance) — amortised O(log n) per insert.
  */
-void bst_insert(BSTNode **root, const WordRecord *rec) {
-    BSTNode **cur;
-    WordRecord norm;
-    int cmp;
+int bst_insert(BSTNode **root, WordRecord *rec) {
+    BSTNode **cur, **next, **goat = NULL;
+    BSTNode  *n;
+    int       cmp;
 
-    if (!root || !rec) return;
-    norm = *rec;
-    str_tolower(norm.word, rec->word, sizeof(norm.word));
+    if (!root || !rec) return 0;
 
     cur = root;
     while (*cur) {
-        cmp = strcmp(norm.word, (*cur)->data.word);
+        STATS_VISIT();
+        cmp = str_key_cmp(rec->word, (*cur)->rec->word);
         if      (cmp < 0) cur = &(*cur)->left;
         else if (cmp > 0) cur = &(*cur)->right;
-        else return; /* duplicate — skip silently */
+        else return 0; /* duplicate — skip silently */
     }
-    *cur = bst_new_node(&norm);
+    *cur = bst_new_node(rec);
+    if (!*cur) return 0;
+
+    for (cur = root; (*cur)->rec != rec; cur = next) {
+        n = *cur;
+        n->size++;
+        STATS_VISIT();
+        if (str_key_cmp(rec->word, n->rec->word) < 0) {
+            NOTE_SCAPEGOAT(goat, cur, bst_count(n->right));
+            next = &n->left;
+        } else {
+            NOTE_SCAPEGOAT(goat, cur, bst_count(n->left));
+            next = &n->right;
+        }
+    }
+#if BST_SCAPEGOAT
+    if (goat) bst_rebalance(goat);   /* on failure the tree is only less balanced */
+#endif
+    return 1;
+}
+
+BSTNode *bst_build_from_sorted(WordRecord **recs, int n) {
+    if (!recs || n <= 0) return NULL;
+    return bst_build_range(recs, 0, n - 1);
 }
 
 /*
  * Iterative search — safe on any tree depth.
  */
 BSTNode *bst_search(BSTNode *root, const char *word) {
-    char lw[MAX_WORD_LEN];
-    int  cmp;
-
+    DictKey key;
     if (!word) return NULL;
-    str_tolower(lw, word, sizeof(lw));
+    dict_key_init(&key, word);
+    return bst_search_normalized(root, &key);
+}
+
+BSTNode *bst_search_normalized(BSTNode *root, const DictKey *key) {
+    int cmp;
+
+    if (!key) return NULL;
 
     while (root) {
-        cmp = strcmp(lw, root->data.word);
+        STATS_VISIT();
+        cmp = str_key_cmp(key->text, root->rec->word);
         if      (cmp == 0) return root;
         else if (cmp  < 0) root = root->left;
         else               root = root->right;
@@ -119,67 +302,87 @@ void bst_delete(BSTNode **root, const char *word) {
 }
 
 /*
- * Morris inorder traversal — O(n) time, O(1) extra space, no recursion.
- * Temporarily threads right-null pointers; restores them before returning.
- * Safe on trees of any depth including fully right-skewed 90k-node trees.
+ * Traversals run on a BSTIter, so they read the tree and never write to
+ * it (unlike a Morris walk, which threads right pointers as it goes).
+ * Safe on trees of any depth, including a fully right-skewed 90k-node
+ * tree: the stack grows to the height as needed.
  */
 void bst_inorder(BSTNode *root, void (*callback)(BSTNode *, void *), void *arg) {
-    BSTNode *cur = root, *pre;
+    BSTIter  it;
+    BSTNode *n;
     if (!callback) return;
-    while (cur) {
-        if (!cur->left) {
-            callback(cur, arg);
-            cur = cur->right;
+    bst_iter_init(&it, root);
+    while ((n = bst_iter_next(&it)) != NULL)
+        callback(n, arg);
+    bst_iter_free(&it);
+}
+
+static void iter_start(BSTIter *it, BSTNode *root, int preorder) {
+    it->root     = root;
+    it->last     = NULL;
+    it->stack    = it->frames;
+    it->depth    = 0;
+    it->cap      = BST_ITER_FRAMES;
+    it->preorder = preorder;
+    it->seek     = 0;
+}
+
+void bst_iter_init(BSTIter *it, BSTNode *root) {
+    iter_start(it, root, 0);
+    iter_push_left_spine(it, root);
+}
+
+void bst_iter_init_preorder(BSTIter *it, BSTNode *root) {
+    iter_start(it, root, 1);
+    if (root) iter_push(it, root);
+}
+
+BSTNode *bst_iter_next(BSTIter *it) {
+    BSTNode *n;
+
+    if (it->seek) {
+        n = it->preorder ? seek_preorder_next(it) : seek_inorder_next(it);
+    } else if (it->depth == 0) {
+        n = NULL;
+    } else {
+        n = it->stack[--it->depth];
+        if (it->preorder) {
+            if (n->right) iter_push(it, n->right);
+            if (n->left)  iter_push(it, n->left);
         } else {
-            /* Find inorder predecessor */
-            pre = cur->left;
-            while (pre->right && pre->right != cur)
-                pre = pre->right;
-            if (!pre->right) {
-                pre->right = cur;   /* thread: remember current for later */
-                cur = cur->left;
-            } else {
-                pre->right = NULL;  /* remove thread */
-                callback(cur, arg);
-                cur = cur->right;
-            }
+            iter_push_left_spine(it, n->right);
         }
     }
+    if (n) it->last = n;
+    return n;
+}
+
+void bst_iter_free(BSTIter *it) {
+    if (it->stack != it->frames) free(it->stack);
+    it->stack = it->frames;
+    it->depth = 0;
 }
 
 /*
- * Morris preorder traversal — visits root BEFORE descending left.
+ * Preorder traversal — visits root BEFORE descending left.
  * Used by save_custom_words so the saved file re-creates the same BST
  * structure on the next load (avoids the sorted-inorder → skewed-tree bug).
  */
 void bst_preorder(BSTNode *root, void (*callback)(BSTNode *, void *), void *arg) {
-    BSTNode *cur = root, *pre;
+    BSTIter  it;
+    BSTNode *n;
     if (!callback) return;
-    while (cur) {
-        if (!cur->left) {
-            callback(cur, arg);
-            cur = cur->right;
-        } else {
-            pre = cur->left;
-            while (pre->right && pre->right != cur)
-                pre = pre->right;
-            if (!pre->right) {
-                pre->right = cur;
-                callback(cur, arg); /* visit BEFORE going left */
-                cur = cur->left;
-            } else {
-                pre->right = NULL;
-                cur = cur->right;
-            }
-        }
-    }
+    bst_iter_init_preorder(&it, root);
+    while ((n = bst_iter_next(&it)) != NULL)
+        callback(n, arg);
+    bst_iter_free(&it);
 }
 
 /*
  * Iterative free — tree-to-vine (Day-Stout-Warren vine phase).
  * Converts every left child into a right child via right-rotation,
- * then frees the resulting right-linked list in one pass.
- * O(n) time, O(1) extra space, safe on trees of any depth.
+ * then returns the resulting right-linked list to the pool in one pass.
+ * O(n) time, O(1) extra space, safe on trees of any depth, no free().
  */
 void bst_free(BSTNode **root) {
     BSTNode *cur = *root, *tmp;
@@ -191,25 +394,35 @@ void bst_free(BSTNode **root) {
             tmp->right = cur;
             cur = tmp;
         } else {
-            /* No left child — free node, move right */
+            /* No left child — release node, move right */
             tmp = cur->right;
-            free(cur);
+            pool_release(&bst_pool, cur);
             cur = tmp;
         }
     }
     *root = NULL;
 }
 
+void bst_pool_reset(void) {
+    pool_reset(&bst_pool);
+}
+
+void bst_pool_destroy(void) {
+    pool_destroy(&bst_pool);
+}
+
 /*
- * Iterative height — DFS with a small fixed-size stack.
+ * Iterative depth walk — DFS with a small fixed-size stack.  Returns the
+ * height, and counts every node's depth into s unless s is NULL.
  * For right-skewed trees the DFS stack never exceeds 2 entries (no left
  * children, so only one right child is ever pending at a time).
  * For balanced trees with n ≤ 100 000 the height is ≤ 51, so a stack
  * of 128 frames is far more than enough.
  */
-int bst_height(BSTNode *root) {
-    struct { BSTNode *n; int d; } stk[128];
-    int top = 0, max_d = 0, d;
+static int walk_depths(BSTNode *root, TreeShape *s) {
+    typedef struct { BSTNode *n; int d; } Frame;
+    Frame    local[128], *stk = local, *grown;
+    int      cap = 128, top = 0, max_d = 0, d;
     BSTNode *n;
 
     if (!root) return 0;
@@ -219,37 +432,80 @@ int bst_height(BSTNode *root) {
         d = stk[top - 1].d;
         top--;
         if (d > max_d) max_d = d;
-        /* Push children — stack can hold at most O(height) entries */
+        if (s) shape_add(s, d, d);           /* one compare per level */
+        /* The stack holds at most one pending sibling per level, so it
+           only outgrows the local frames on a degenerate tree */
+        if (top + 2 > cap) {
+            grown = (Frame *)malloc((size_t)cap * 2 * sizeof(Frame));
+            if (!grown) break;               /* report the depth seen so far */
+            memcpy(grown, stk, (size_t)top * sizeof(Frame));
+            if (stk != local) free(stk);
+            stk  = grown;
+            cap *= 2;
+        }
         if (n->right) { stk[top].n = n->right; stk[top].d = d + 1; top++; }
         if (n->left)  { stk[top].n = n->left;  stk[top].d = d + 1; top++; }
     }
+    if (stk != local) free(stk);
     return max_d;
 }
 
-/*
- * Morris inorder count — same traversal as bst_inorder but just increments
- * a counter instead of calling a callback. O(n) time, O(1) space.
- */
-int bst_count(BSTNode *root) {
-    int count = 0;
-    BSTNode *cur = root, *pre;
-    while (cur) {
-        if (!cur->left) {
-            count++;
-            cur = cur->right;
-        } else {
-            pre = cur->left;
-            while (pre->right && pre->right != cur)
-                pre = pre->right;
-            if (!pre->right) {
-                pre->right = cur;
-                cur = cur->left;
-            } else {
-                pre->right = NULL;
-                count++;
-                cur = cur->right;
-            }
-        }
+int bst_height(BSTNode *root) {
+    return walk_depths(root, NULL);
+}
+
+void bst_shape(BSTNode *root, TreeShape *s) {
+    walk_depths(root, s);
+}
+
+int bst_depth(BSTNode *root, const char *word) {
+    DictKey key;
+    int     d, cmp;
+
+    if (!word) return 0;
+    dict_key_init(&key, word);
+    for (d = 1; root; d++) {
+        cmp = str_key_cmp(key.text, root->rec->word);
+        if (cmp == 0) return d;
+        root = cmp < 0 ? root->left : root->right;
     }
-    return count;
+    return 0;
+}
+
+int bst_rebalance(BSTNode **root) {
+    BSTNode **nodes, *n;
+    BSTIter   it;
+    int       count, i = 0;
+
+    if (!root || !*root) return 0;
+    count = bst_count(*root);
+    nodes = (BSTNode **)malloc((size_t)count * sizeof(BSTNode *));
+    if (!nodes) return -1;
+    bst_iter_init(&it, *root);
+    while ((n = bst_iter_next(&it)) != NULL) nodes[i++] = n;
+    bst_iter_free(&it);
+    *root = relink_range(nodes, 0, count - 1);
+    free(nodes);
+    return 0;
+}
+
+int bst_rebalance_if_deep(BSTNode **root, int depth) {
+    if (!root || !shape_too_deep(depth, (size_t)bst_count(*root))) return 0;
+    return bst_rebalance(root) == 0;
+}
+
+int bst_count(BSTNode *root) {
+    return root ? root->size : 0;
+}
+
+void bst_memory(BSTNode *root, MemUsage *u) {
+    MemUsage pool;
+    size_t   n = (size_t)bst_count(root);
+
+    mem_usage_clear(&pool);
+    pool_memory(&bst_pool, &pool);
+    u->node_bytes     += n * sizeof(BSTNode);
+    u->overhead_bytes += pool.overhead_bytes;
+    u->index_bytes    += pool.index_bytes;
+    u->entries        += n;
 }
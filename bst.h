@@ -3,32 +3,107 @@
 #define BST_H
 
 #include "dictionary.h"
+#include "memusage.h"
+#include "shape.h"
 
 /*
- * BSTNode - a node in the unbalanced Binary Search Tree.
+ * BSTNode - a node in the Binary Search Tree.
  *
- * Baseline implementation: O(log n) average, O(n) worst case (sorted input).
- * WordRecord is embedded directly — one malloc per node, one free per node.
+ * Baseline implementation: O(log n) average, O(n) worst case (sorted
+ * input) — unless BST_SCAPEGOAT (config.h) is on, as by default.  Then
+ * insert and delete check each subtree on their path against the node
+ * sizes: the highest one with a child holding more than BST_ALPHA of
+ * its nodes is rebuilt in place into a perfectly balanced subtree.  That
+ * keeps the height under log(n) / log(1 / BST_ALPHA) + 1 (2.41 log2 n at
+ * 0.75) on any input order, in amortised O(log n) per update, with the
+ * node layout unchanged: no height or balance field, just 'size'.
+ *
+ * The node points at a WordRecord owned by the RecordStore (store.h);
+ * nodes themselves come from a slab pool (pool.h), not one malloc each.
+ *
+ * 'size' counts the nodes in the subtree, so bst_count is O(1); insert
+ * and delete adjust it along the search path.
  */
 typedef struct BSTNode {
-    WordRecord       data;   /* embedded record payload                  */
+    WordRecord      *rec;    /* shared record (key = rec->word)          */
     struct BSTNode  *left;   /* left subtree  (word < this node's word)  */
     struct BSTNode  *right;  /* right subtree (word > this node's word)  */
+    int              size;   /* nodes in this subtree (leaf=1)           */
 } BSTNode;
 
+/*
+ * BSTIter - read-only inorder or preorder cursor over a BST.
+ *
+ * The tree is never written to, so any number of iterators (and
+ * searches) can run over the same tree at once.  Pending nodes live on an
+ * explicit stack: BST_ITER_FRAMES inline frames cover any balanced tree,
+ * and deeper (skewed) trees spill onto the heap, growing to the height.
+ * Should that allocation fail, the cursor keeps going without a stack
+ * by finding each successor with one O(height) descent from the root, so
+ * a walk always completes, on any depth.
+ *
+ * The tree must not change while an iterator is live.  Always call
+ * bst_iter_free at the end (it releases a spilled stack).
+ *
+ *   BSTIter it;  BSTNode *n;
+ *   bst_iter_init(&it, root);
+ *   while ((n = bst_iter_next(&it)) != NULL) ... ;
+ *   bst_iter_free(&it);
+ */
+#define BST_ITER_FRAMES  64
+
+typedef struct BSTIter {
+    BSTNode  *root;
+    BSTNode  *last;                     /* node returned last, or NULL     */
+    BSTNode **stack;                    /* frames, or a heap spill         */
+    int       depth, cap;
+    int       preorder;                 /* 0 = inorder, 1 = preorder       */
+    int       seek;                     /* stack lost: successor by search */
+    BSTNode  *frames[BST_ITER_FRAMES];
+} BSTIter;
+
 /* Allocate and initialise a new BST node. Returns NULL on malloc failure. */
-BSTNode *bst_new_node(const WordRecord *rec);
+BSTNode *bst_new_node(WordRecord *rec);
+
+/* Return one node, already unlinked from its tree, to the BST pool. */
+void bst_release_node(BSTNode *node);
 
-/* Insert rec into the tree rooted at *root. Updates *root when tree grows. */
-void bst_insert(BSTNode **root, const WordRecord *rec);
+/*
+ * Insert rec into the tree rooted at *root. Updates *root when tree grows.
+ * The node references rec (no copy); rec->word must already be lowercase,
+ * as store_add guarantees.  Returns 1 if inserted, 0 on duplicate/failure.
+ */
+int bst_insert(BSTNode **root, WordRecord *rec);
+
+/*
+ * Build a perfectly balanced tree over recs[0..n), which must be sorted
+ * by word with no duplicates (as after store_add + a sort).  O(n), with
+ * O(log n) recursion.  Returns the new root; any existing tree is not
+ * touched, so callers build into an empty root.
+ */
+BSTNode *bst_build_from_sorted(WordRecord **recs, int n);
 
 /* Search for word. Returns pointer to matching node, or NULL if not found. */
 BSTNode *bst_search(BSTNode *root, const char *word);
 
+/* Search for an already-normalised key (no lowercasing per call). */
+BSTNode *bst_search_normalized(BSTNode *root, const DictKey *key);
+
 /* Delete word from the tree. Updates *root if root changes. */
 void bst_delete(BSTNode **root, const char *word);
 
-/* In-order traversal: calls callback(node, arg) for each node. */
+/* Start an inorder (sorted) / preorder walk of the tree at root. */
+void bst_iter_init(BSTIter *it, BSTNode *root);
+void bst_iter_init_preorder(BSTIter *it, BSTNode *root);
+
+/* Return the next node of the walk, or NULL when it is finished. */
+BSTNode *bst_iter_next(BSTIter *it);
+
+/* Release the iterator's heap stack, if any. */
+void bst_iter_free(BSTIter *it);
+
+/* In-order traversal: calls callback(node, arg) for each node.
+   Read-only (runs on a BSTIter), like bst_preorder. */
 void bst_inorder(BSTNode *root, void (*callback)(BSTNode *, void *), void *arg);
 
 /* Pre-order traversal: visits root before left/right subtrees.
@@ -36,13 +111,48 @@ void bst_inorder(BSTNode *root, void (*callback)(BSTNode *, void *), void *arg);
    structure, preventing the sorted-input → skewed-tree performance bug. */
 void bst_preorder(BSTNode *root, void (*callback)(BSTNode *, void *), void *arg);
 
-/* Free all nodes recursively. Sets *root to NULL. */
+/* Free all nodes (the records stay in their store). Sets *root to NULL.
+   Nodes go back to the BST node pool, not to the C library. */
 void bst_free(BSTNode **root);
 
+/*
+ * Drop every node of every BST at once in O(slabs), keeping the pool's
+ * slabs for reuse — e.g. before reloading the dictionary.  All BSTNode
+ * pointers become invalid; callers must set their roots to NULL.
+ */
+void bst_pool_reset(void);
+
+/* Like bst_pool_reset, but also returns the slab memory (use at exit). */
+void bst_pool_destroy(void);
+
 /* Return height of the tree (0 for empty tree). */
 int bst_height(BSTNode *root);
 
-/* Return total number of nodes. */
+/* Add every node's depth to s (shape.h). */
+void bst_shape(BSTNode *root, TreeShape *s);
+
+/* Depth of word's node (the root is 1), or 0 if it is not in the tree.
+   O(depth). */
+int bst_depth(BSTNode *root, const char *word);
+
+/*
+ * Relink the tree in place into the balanced shape bst_build_from_sorted
+ * gives: no node is allocated or freed, so node pointers stay valid.
+ * O(n) time and an O(n) pointer array.  Returns 0, or -1 (tree unchanged)
+ * if the array cannot be allocated.
+ */
+int bst_rebalance(BSTNode **root);
+
+/* The automatic rebuild: bst_rebalance the tree if depth (of a node just
+   inserted, or the height) is skewed past SHAPE_SKEW_LIMIT (shape.h).
+   Returns 1 if the tree was rebuilt. */
+int bst_rebalance_if_deep(BSTNode **root, int depth);
+
+/* Return total number of nodes. O(1). */
 int bst_count(BSTNode *root);
 
+/* Add the tree to u (memusage.h): its nodes, plus the spare slots and
+   slab table of the pool every BST shares (normally there is one). */
+void bst_memory(BSTNode *root, MemUsage *u);
+
 #endif /* BST_H */
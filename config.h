@@ -4,25 +4,66 @@
 
 /* ── Buffer sizes ─────────────────────────────────────────── */
 #define MAX_WORD_LEN      64      /* max chars in a word (incl. NUL)    */
-#define MAX_MEANING_LEN   512     /* max chars in a definition           */
-#define MAX_POS_LEN       32      /* max chars in part-of-speech tag     */
+#define MAX_MEANING_LEN   512     /* max chars in a typed-in definition  */
+#define MAX_POS_LEN       32      /* max chars in a typed-in POS tag     */
 #define MAX_INPUT_BUF     128     /* console input buffer                */
-#define MAX_LINE_BUF      1024    /* line buffer for file I/O            */
+#define MAX_LINE_BUF      1024    /* initial line buffer for file I/O    */
+#define ARENA_BLOCK_SIZE  65536   /* bytes per string-arena block        */
 
 /* ── Capacity limits ──────────────────────────────────────── */
-#define MAX_WORDS         100000  /* max dictionary entries in RAM       */
 #define TOP_K_DEFAULT     10      /* default autocomplete results        */
 #define TOP_K_MAX         50      /* ceiling for top-K config            */
+#define TRIE_TOPK         TOP_K_DEFAULT  /* best records cached per trie node */
+#define PREFIX_CACHE_SIZE 256     /* autocomplete answers kept (power of 2) */
+#define AC_BATCH_CHUNK    64      /* prefixes per shared BST/AVL descent */
+#define AC_BATCH_THREADS_MAX 8    /* slices for autocomplete_batch_parallel */
+#define FUZZY_MAX_DIST    2       /* edits allowed in "did you mean" */
+#define DISPLAY_PAGE_SIZE 20      /* words per page in "Display all words" */
+#define STORE_CHUNK_RECORDS 4096  /* records per RecordStore slab        */
+#define POOL_SLAB_NODES   4096    /* tree nodes per NodePool slab        */
+#define LOAD_THREADS      8       /* parse/sort workers for big loads    */
+#define LOAD_PARALLEL_MIN_BYTES (1L << 20)  /* smaller files load serially */
+#define BULK_REBUILD_DIV  16      /* a batch of n/16+ words rebuilds the trees (loader.h) */
+#define JSONL_LINE_MAX    (64UL << 20)  /* longer JSONL dump lines are skipped */
+#define LAZY_INDEXES      1       /* 1: BST/TBT/Trie/B+ built on first use */
+#define LAZY_MEANINGS     1       /* 1: loaded definitions read on first use */
+#define JOURNAL_COMPACT_BYTES (1L << 20)  /* fold the journal into the save files past this */
+#ifndef BST_SCAPEGOAT
+#define BST_SCAPEGOAT     1       /* 1: rebuild BST subtrees out of weight balance */
+#endif
+#define BST_ALPHA         0.75    /* ... when a child holds more than this share */
+#define SHAPE_SKEW_LIMIT     4    /* rebuild a BST deeper than 4x balanced (shape.h) */
+#define SHAPE_SKEW_MIN_DEPTH 32   /* ... and than this many levels       */
+#define WBST_RELAYOUT_DIV    8    /* re-lay the weighted BST after n/8 changes (wbst.h) */
+#define FED_MAX_MEMBERS      8    /* dictionaries in one federation (federation.h) */
+#define FED_NAME_LEN        64    /* member name, incl. NUL              */
+#define SHARD_MAX           16    /* key-range shards in one ShardedDict (shard.h) */
+#define SERVER_PORT       7878    /* smart_dict_server TCP port          */
+#define SERVER_WORKERS       4    /* default request worker threads      */
+#define SERVER_WORKERS_MAX  64
+#define SERVER_MAX_CONNS  1024    /* clients connected at once           */
+#define SERVER_BUF_MAX    (1L << 20)  /* per-client unread/unsent backlog */
+#ifndef ENGINE_STATS
+#define ENGINE_STATS      1       /* 1: hot-path counters and timers (stats.h) */
+#endif
 
 /* ── Numeric defaults ─────────────────────────────────────── */
 #define FREQ_SCORE_DEFAULT   1    /* assigned when corpus count = 0      */
 #define FREQ_SCORE_MAX    100000  /* ceiling for normalisation           */
+#define FREQ_CORPUS_TOP    100    /* load_jsonl score of the most used word */
+#define SELECT_WEIGHT       10   /* score points a fresh pick is worth  */
+#define SELECT_HALF_LIFE_MIN (30 * 24 * 60)  /* a pick's weight halves every 30 days */
+#define SCORE_EPOCH_MIN     60    /* ranking clock step, in minutes      */
 
 /* ── Data file paths (relative to executable location) ────── */
 #define DATA_DIR             "data"
 #define FILE_WORDS           "data/words.txt"
+#define FILE_WORDS_PACKED    "data/words.sdz"         /* compressed twin of words.txt */
+#define FILE_WORDS_SNAP      "data/words.snap"        /* corpus-ranked build (pack_dict) */
 #define FILE_WORD_FREQ       "data/word_freq.txt"
 #define FILE_CUSTOM_WORDS    "data/custom_words.txt"
+#define FILE_SNAPSHOT        "data/dictionary.snap"   /* binary twin of custom_words */
+#define FILE_JOURNAL         "data/dictionary.journal" /* changes since the last save */
 
 /* ── Application metadata ─────────────────────────────────── */
 #define APP_NAME    "Smart Dictionary & Autocomplete Engine"
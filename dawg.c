@@ -0,0 +1,363 @@
+/* dawg.c - Minimal acyclic automaton implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dawg.h"
+#include "dictionary.h"
+
+#define DAWG_NONE  UINT32_MAX
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/*
+ * One state on the path of the last word added.  Its edges are in label
+ * order; all but the last point at frozen states, and the last at the
+ * next state down the path until that one is frozen too.
+ */
+typedef struct PathState {
+    int       final;
+    int       n;
+    uint8_t   label[256];
+    uint32_t  target[256];
+} PathState;
+
+typedef struct Builder {
+    Dawg      *d;
+    PathState  path[MAX_WORD_LEN];
+    uint32_t  *reg;          /* frozen states by content, DAWG_NONE empty */
+    uint32_t   mask;
+    int        cap_states, cap_edges;
+} Builder;
+
+static uint32_t state_hash(int final, int n, const uint8_t *label, const uint32_t *target) {
+    uint32_t h = 2166136261u ^ (uint32_t)final;
+    int      i;
+    for (i = 0; i < n; i++) {
+        h = (h ^ label[i]) * 16777619u;
+        h = (h ^ target[i]) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+static uint32_t frozen_hash(const Dawg *d, uint32_t s) {
+    uint32_t e = d->first[s];
+    return state_hash(d->final[s], (int)(d->first[s + 1] - e), d->label + e, d->target + e);
+}
+
+static int same_state(const Dawg *d, uint32_t s, const PathState *p) {
+    uint32_t e = d->first[s];
+    return d->final[s] == p->final
+        && d->first[s + 1] - e == (uint32_t)p->n
+        && memcmp(d->label + e, p->label, (size_t)p->n) == 0
+        && memcmp(d->target + e, p->target, (size_t)p->n * sizeof(uint32_t)) == 0;
+}
+
+static int grow_register(Builder *b) {
+    uint32_t  mask = b->mask * 2 + 1, *reg, s, h;
+    reg = (uint32_t *)malloc(((size_t)mask + 1) * sizeof(uint32_t));
+    if (!reg) return -1;
+    memset(reg, 0xFF, ((size_t)mask + 1) * sizeof(uint32_t));
+    for (s = 0; s < (uint32_t)b->d->num_states; s++) {
+        for (h = frozen_hash(b->d, s) & mask; reg[h] != DAWG_NONE; h = (h + 1) & mask)
+            ;
+        reg[h] = s;
+    }
+    free(b->reg);
+    b->reg  = reg;
+    b->mask = mask;
+    return 0;
+}
+
+static int reserve(Builder *b, int edges) {
+    Dawg *d = b->d;
+    void *p;
+    if (d->num_states + 1 >= b->cap_states) {
+        b->cap_states *= 2;
+        if (!(p = realloc(d->first, (size_t)(b->cap_states + 1) * sizeof(uint32_t)))) return -1;
+        d->first = (uint32_t *)p;
+        if (!(p = realloc(d->final, (size_t)b->cap_states))) return -1;
+        d->final = (uint8_t *)p;
+        if (!(p = realloc(d->count, (size_t)b->cap_states * sizeof(uint32_t)))) return -1;
+        d->count = (uint32_t *)p;
+    }
+    if (d->num_edges + edges > b->cap_edges) {
+        while (d->num_edges + edges > b->cap_edges) b->cap_edges *= 2;
+        if (!(p = realloc(d->label, (size_t)b->cap_edges))) return -1;
+        d->label = (uint8_t *)p;
+        if (!(p = realloc(d->target, (size_t)b->cap_edges * sizeof(uint32_t)))) return -1;
+        d->target = (uint32_t *)p;
+    }
+    /* Keep the register at most half full */
+    if ((uint32_t)d->num_states * 2 >= b->mask) return grow_register(b);
+    return 0;
+}
+
+/* The frozen state equal to p — an existing one if there is one, else a
+   new one appended.  DAWG_NONE on malloc failure. */
+static uint32_t freeze(Builder *b, const PathState *p) {
+    Dawg     *d = b->d;
+    uint32_t  h, s, words;
+    int       i;
+
+    if (reserve(b, p->n) != 0) return DAWG_NONE;
+    for (h = state_hash(p->final, p->n, p->label, p->target) & b->mask;
+         (s = b->reg[h]) != DAWG_NONE; h = (h + 1) & b->mask)
+        if (same_state(d, s, p)) return s;
+
+    s = (uint32_t)d->num_states++;
+    memcpy(d->label + d->num_edges, p->label, (size_t)p->n);
+    memcpy(d->target + d->num_edges, p->target, (size_t)p->n * sizeof(uint32_t));
+    d->num_edges  += p->n;
+    d->first[s + 1] = (uint32_t)d->num_edges;
+    d->final[s]     = (uint8_t)p->final;
+    for (words = (uint32_t)p->final, i = 0; i < p->n; i++) words += d->count[p->target[i]];
+    d->count[s]     = words;
+    b->reg[h]       = s;
+    return s;
+}
+
+/* Give back the slack of the doubling growth (a failed realloc keeps
+   the larger block). */
+static void shrink(Dawg *d) {
+    void *p;
+    if ((p = realloc(d->first, (size_t)(d->num_states + 1) * sizeof(uint32_t)))) d->first = (uint32_t *)p;
+    if ((p = realloc(d->final, (size_t)d->num_states))) d->final = (uint8_t *)p;
+    if ((p = realloc(d->count, (size_t)d->num_states * sizeof(uint32_t)))) d->count = (uint32_t *)p;
+    if (d->num_edges == 0) return;
+    if ((p = realloc(d->label, (size_t)d->num_edges))) d->label = (uint8_t *)p;
+    if ((p = realloc(d->target, (size_t)d->num_edges * sizeof(uint32_t)))) d->target = (uint32_t *)p;
+}
+
+/* Freeze the path below depth keep, deepest first, linking each frozen
+   state into its parent's last edge. */
+static int freeze_path(Builder *b, int depth, int keep) {
+    uint32_t s;
+    for (; depth > keep; depth--) {
+        if ((s = freeze(b, &b->path[depth])) == DAWG_NONE) return -1;
+        b->path[depth - 1].target[b->path[depth - 1].n - 1] = s;
+    }
+    return 0;
+}
+
+/* Follow c out of s, adding to *ord the words under the edges before it.
+   Returns the target or DAWG_NONE. */
+static uint32_t step(const Dawg *d, uint32_t s, unsigned char c, uint32_t *ord) {
+    uint32_t e, end = d->first[s + 1];
+    for (e = d->first[s]; e < end && d->label[e] < c; e++)
+        *ord += d->count[d->target[e]];
+    return e < end && d->label[e] == c ? d->target[e] : DAWG_NONE;
+}
+
+/* State reached by prefix, with *ord the words ordered before it. */
+static uint32_t walk(const Dawg *d, const char *prefix, uint32_t *ord) {
+    uint32_t s = d->root;
+    *ord = 0;
+    for (; *prefix && s != DAWG_NONE; prefix++) {
+        *ord += d->final[s];
+        s = step(d, s, (unsigned char)*prefix, ord);
+    }
+    return s;
+}
+
+typedef struct CollectCtx {
+    const char **out;
+} CollectCtx;
+
+static void collect_cb(AVLNode *n, void *arg) {
+    CollectCtx *c = (CollectCtx *)arg;
+    *c->out++ = n->rec->word;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int dawg_build_sorted(Dawg *d, const char *const *words, int n) {
+    Builder    *b;
+    const char *prev = "", *why = "malloc failed";
+    int         w, depth = 0, common, len;
+
+    if (!d || n < 0 || (n > 0 && !words)) return -1;
+    dawg_free(d);
+
+    b = (Builder *)malloc(sizeof(Builder));
+    if (!b) goto fail;
+    b->d          = d;
+    b->cap_states = 1024;
+    b->cap_edges  = 1024;
+    b->mask       = 1023;
+    b->reg        = (uint32_t *)malloc(((size_t)b->mask + 1) * sizeof(uint32_t));
+    d->first      = (uint32_t *)malloc((size_t)(b->cap_states + 1) * sizeof(uint32_t));
+    d->final      = (uint8_t *)malloc((size_t)b->cap_states);
+    d->count      = (uint32_t *)malloc((size_t)b->cap_states * sizeof(uint32_t));
+    d->label      = (uint8_t *)malloc((size_t)b->cap_edges);
+    d->target     = (uint32_t *)malloc((size_t)b->cap_edges * sizeof(uint32_t));
+    if (!b->reg || !d->first || !d->final || !d->count || !d->label || !d->target)
+        goto fail;
+    memset(b->reg, 0xFF, ((size_t)b->mask + 1) * sizeof(uint32_t));
+    d->first[0] = 0;
+    b->path[0].final = 0;
+    b->path[0].n     = 0;
+
+    for (w = 0; w < n; w++) {
+        len = (int)strlen(words[w]);
+        if (len >= MAX_WORD_LEN || (w > 0 && strcmp(prev, words[w]) >= 0)) {
+            why = "words not sorted and unique";
+            goto fail;
+        }
+        for (common = 0; common < depth && prev[common] == words[w][common]; common++)
+            ;
+        if (freeze_path(b, depth, common) != 0) goto fail;
+        for (depth = common; depth < len; depth++) {
+            PathState *p = &b->path[depth];
+            p->label[p->n]    = (uint8_t)words[w][depth];
+            p->target[p->n++] = DAWG_NONE;
+            b->path[depth + 1].final = 0;
+            b->path[depth + 1].n     = 0;
+        }
+        b->path[len].final = 1;
+        prev = words[w];
+    }
+    if (freeze_path(b, depth, 0) != 0) goto fail;
+    if ((d->root = freeze(b, &b->path[0])) == DAWG_NONE) goto fail;
+    d->words = n;
+    shrink(d);
+
+    free(b->reg);
+    free(b);
+    return 0;
+
+fail:
+    fprintf(stderr, "[ERROR] dawg_build: %s\n", why);
+    if (b) free(b->reg);
+    free(b);
+    dawg_free(d);
+    return -1;
+}
+
+int dawg_build(Dawg *d, AVLNode *avl_root) {
+    const char **words;
+    CollectCtx   ctx;
+    int          n = avl_count(avl_root), rc;
+
+    if (!d) return -1;
+    dawg_free(d);
+    if (n == 0) return 0;
+
+    words = (const char **)malloc((size_t)n * sizeof(const char *));
+    if (!words) {
+        fprintf(stderr, "[ERROR] dawg_build: malloc failed\n");
+        return -1;
+    }
+    ctx.out = words;
+    avl_inorder(avl_root, collect_cb, &ctx);
+    rc = dawg_build_sorted(d, words, n);
+    free(words);
+    return rc;
+}
+
+void dawg_free(Dawg *d) {
+    if (!d) return;
+    free(d->first);
+    free(d->final);
+    free(d->count);
+    free(d->label);
+    free(d->target);
+    d->first      = NULL;
+    d->final      = NULL;
+    d->count      = NULL;
+    d->label      = NULL;
+    d->target     = NULL;
+    d->root       = 0;
+    d->num_states = 0;
+    d->num_edges  = 0;
+    d->words      = 0;
+}
+
+int dawg_lookup(const Dawg *d, const char *word) {
+    DictKey  key;
+    uint32_t s, ord;
+
+    if (!d || d->words == 0 || !word) return -1;
+    dict_key_init(&key, word);
+    s = walk(d, key.text, &ord);
+    return s != DAWG_NONE && d->final[s] ? (int)ord : -1;
+}
+
+int dawg_word_at(const Dawg *d, int i, char *buf, size_t size) {
+    uint32_t s, e, end, c, rest;
+    size_t   len = 0;
+
+    if (!d || !buf || i < 0 || i >= d->words) return -1;
+    rest = (uint32_t)i;
+    s    = d->root;
+    for (;;) {
+        if (d->final[s]) {
+            if (rest == 0) break;
+            rest--;
+        }
+        for (e = d->first[s], end = d->first[s + 1]; e < end; e++) {
+            c = d->count[d->target[e]];
+            if (rest < c) break;
+            rest -= c;
+        }
+        if (len + 1 >= size) return -1;
+        buf[len++] = (char)d->label[e];
+        s = d->target[e];
+    }
+    if (len >= size) return -1;
+    buf[len] = '\0';
+    return (int)len;
+}
+
+int dawg_prefix_range(const Dawg *d, const char *prefix, int *first) {
+    DictKey  key;
+    uint32_t s, ord;
+
+    if (first) *first = 0;
+    if (!d || d->words == 0 || !prefix) return 0;
+    dict_key_init(&key, prefix);
+    s = walk(d, key.text, &ord);
+    if (s == DAWG_NONE) return 0;
+    if (first) *first = (int)ord;
+    return (int)d->count[s];
+}
+
+int dawg_enumerate(const Dawg *d, const char *prefix, int limit,
+                   void (*cb)(const char *word, int ordinal, void *arg), void *arg) {
+    struct { uint32_t s, e; } stack[MAX_WORD_LEN];
+    DictKey  key;
+    uint32_t s, ord;
+    size_t   len;
+    int      top = 0, seen = 0;
+
+    if (!d || d->words == 0 || !prefix || !cb || limit == 0) return 0;
+    dict_key_init(&key, prefix);
+    if ((s = walk(d, key.text, &ord)) == DAWG_NONE) return 0;
+    len = strlen(key.text);
+
+    /* Depth-first in label order visits the words in sorted order */
+    stack[0].s = s;
+    stack[0].e = d->first[s];
+    if (d->final[s]) cb(key.text, (int)ord + seen++, arg);
+    while (top >= 0 && seen != limit) {
+        if (stack[top].e == d->first[stack[top].s + 1]) {
+            top--;
+            len--;
+            continue;
+        }
+        s = d->target[stack[top].e];
+        key.text[len++] = (char)d->label[stack[top].e++];
+        key.text[len]   = '\0';
+        top++;
+        stack[top].s = s;
+        stack[top].e = d->first[s];
+        if (d->final[s]) cb(key.text, (int)ord + seen++, arg);
+    }
+    return seen;
+}
+
+size_t dawg_memory(const Dawg *d) {
+    if (!d || !d->first) return 0;
+    return (size_t)(d->num_states + 1) * sizeof(uint32_t)
+         + (size_t)d->num_states * (sizeof(uint8_t) + sizeof(uint32_t))
+         + (size_t)d->num_edges * (sizeof(uint8_t) + sizeof(uint32_t));
+}
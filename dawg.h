@@ -0,0 +1,86 @@
+/* dawg.h - Minimal acyclic automaton (DAWG) over the sorted word set */
+#ifndef DAWG_H
+#define DAWG_H
+
+#include <stddef.h>   /* size_t */
+#include <stdint.h>
+#include "avl.h"
+
+/*
+ * Dawg - the dictionary's words as a minimised deterministic acyclic
+ * automaton: a trie in which every set of equal subtrees is stored once,
+ * so shared suffixes ("-ing", "-ness", plural "-s") cost one path
+ * instead of one per word.  Built in one pass over the sorted words
+ * (Daciuk et al.'s incremental algorithm): only the path of the last
+ * word is ever mutable, and each state leaving it is either matched to
+ * an equal state already built or frozen as a new one.
+ *
+ * Frozen states are numbered in build order and stored flat:
+ *   first[s] .. first[s + 1]   s's edges in label[] / target[], labels
+ *                              ascending
+ *   final[s]                   1 if s ends a word
+ *   count[s]                   words accepted from s (1 for final[s])
+ *
+ * count turns the automaton into a perfect hash: a word's ordinal is its
+ * position in sorted order (0 .. n-1), summed from the counts of the
+ * edges left of the path, and the same sums walk an ordinal back to its
+ * word.  Ordinals match the inorder position of the tree it was built
+ * from, so a caller can keep a parallel array of records.
+ *
+ * Read-only once built: the word set a Dawg describes never changes.
+ */
+typedef struct Dawg {
+    uint32_t *first;      /* num_states + 1 entries                   */
+    uint8_t  *final;
+    uint32_t *count;
+    uint8_t  *label;      /* num_edges entries                        */
+    uint32_t *target;
+    uint32_t  root;
+    int       num_states;
+    int       num_edges;
+    int       words;
+} Dawg;
+
+/* Static initialiser for an empty automaton. */
+#define DAWG_INIT  { NULL, NULL, NULL, NULL, NULL, 0, 0, 0, 0 }
+
+/*
+ * Build d from words[0..n), which must be normalised and strictly
+ * increasing; any previous contents are freed.  O(total length).
+ * Returns 0 on success, -1 on malloc failure or unsorted input (d is
+ * left empty).
+ */
+int dawg_build_sorted(Dawg *d, const char *const *words, int n);
+
+/* Build d from an inorder walk of the AVL tree.  Returns 0 or -1. */
+int dawg_build(Dawg *d, AVLNode *avl_root);
+
+/* Free the arrays; d is left empty and reusable. */
+void dawg_free(Dawg *d);
+
+/* Ordinal of word (case-insensitive) in sorted order, or -1 if absent. */
+int dawg_lookup(const Dawg *d, const char *word);
+
+/* Write the word with ordinal i into buf[size].  Returns its length, or
+   -1 if i is out of range or the word does not fit. */
+int dawg_word_at(const Dawg *d, int i, char *buf, size_t size);
+
+/*
+ * Number of words starting with prefix (case-insensitive); *first gets
+ * the ordinal of the first one.  They are the ordinals first ..
+ * first + count - 1, because sorted order keeps them together.
+ */
+int dawg_prefix_range(const Dawg *d, const char *prefix, int *first);
+
+/*
+ * Call cb(word, ordinal, arg) for the words starting with prefix in
+ * sorted order, at most limit of them (limit < 0: all).  Returns the
+ * number visited.
+ */
+int dawg_enumerate(const Dawg *d, const char *prefix, int limit,
+                   void (*cb)(const char *word, int ordinal, void *arg), void *arg);
+
+/* Bytes held by the automaton's arrays. */
+size_t dawg_memory(const Dawg *d);
+
+#endif /* DAWG_H */
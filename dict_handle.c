@@ -0,0 +1,497 @@
+/* dict_handle.c - Thread-safe dictionary handle implementation */
+#define _POSIX_C_SOURCE 200809L   /* pthread_rwlock_t under -std=c99 */
+#define _GNU_SOURCE               /* glibc: writer-preferring rwlocks  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "dict_handle.h"
+#include "store.h"
+#include "bst.h"
+#include "avl.h"
+#include "tbt.h"
+#include "trie.h"
+#include "loader.h"
+#include "eytz.h"
+#include "autocomplete.h"
+
+/*
+ * Locks, always taken in this order:
+ *   h->write_lock   one writer per handle (in place or reload)
+ *   pool_lock       the per-module node pools, shared by every handle
+ *   v->lock         a version's trees: shared by readers, exclusive for
+ *                   in-place writes
+ *   ref_lock        h->cur and every refs count; held for a few
+ *                   instructions only, never around one of the above
+ * Readers only ever take v->lock and ref_lock, and only try pool_lock.
+ */
+struct DictView {                /* one version of the dictionary        */
+    pthread_rwlock_t lock;
+    RecordStore      store;      /* owns every WordRecord               */
+    BSTNode         *bst_root;
+    AVLNode         *avl_root;   /* lookups and sorted walks            */
+    TBTNode         *tbt_header;
+    Trie             trie;       /* ranked prefix queries               */
+    EytzIndex        frozen;     /* exact lookups; empty once stale     */
+    int              refs;       /* views, +1 while published           */
+    unsigned long    generation;
+    struct DictView *next_retired;
+};
+
+struct DictHandle {
+    pthread_mutex_t write_lock;
+    DictView       *cur;         /* published version                   */
+    unsigned long   generation;  /* of the newest version built         */
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t ref_lock  = PTHREAD_MUTEX_INITIALIZER;
+static DictView       *retired   = NULL;  /* unreferenced, awaiting pool_lock */
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/*
+ * glibc's default rwlock lets a steady stream of readers starve a writer
+ * indefinitely; ask for writer preference there (new readers queue behind
+ * a waiting writer, readers still never wait for each other).
+ */
+static int rwlock_init(pthread_rwlock_t *lock) {
+#ifdef __GLIBC__
+    pthread_rwlockattr_t attr;
+    int                  rc;
+    if (pthread_rwlockattr_init(&attr) != 0) return -1;
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    rc = pthread_rwlock_init(lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    return rc;
+#else
+    return pthread_rwlock_init(lock, NULL);
+#endif
+}
+
+/* New empty version holding one reference.  Caller holds pool_lock. */
+static DictView *version_create(void) {
+    DictView *v = (DictView *)malloc(sizeof(DictView));
+    if (!v) {
+        fprintf(stderr, "[ERROR] dict_handle: malloc failed\n");
+        return NULL;
+    }
+    if (rwlock_init(&v->lock) != 0) {
+        fprintf(stderr, "[ERROR] dict_handle: rwlock init failed\n");
+        free(v);
+        return NULL;
+    }
+    store_init(&v->store);
+    trie_init(&v->trie);
+    v->bst_root     = NULL;
+    v->avl_root     = NULL;
+    v->tbt_header   = tbt_create_header();
+    v->frozen.keys  = NULL;
+    v->frozen.recs  = NULL;
+    v->frozen.n     = 0;
+    v->refs         = 1;
+    v->generation   = 0;
+    v->next_retired = NULL;
+    return v;
+}
+
+/* Free v and everything it indexes.  Caller holds pool_lock. */
+static void version_free(DictView *v) {
+    bst_free(&v->bst_root);
+    avl_free(&v->avl_root);
+    tbt_free(&v->tbt_header);
+    trie_free(&v->trie);
+    eytz_free(&v->frozen);
+    store_free(&v->store);
+    pthread_rwlock_destroy(&v->lock);
+    free(v);
+}
+
+/* Free every retired version.  Caller holds pool_lock. */
+static void reclaim_retired(void) {
+    DictView *list, *next;
+
+    pthread_mutex_lock(&ref_lock);
+    list    = retired;
+    retired = NULL;
+    pthread_mutex_unlock(&ref_lock);
+
+    for (; list; list = next) {
+        next = list->next_retired;
+        version_free(list);
+    }
+}
+
+/*
+ * Drop one reference.  The last one frees the version at once if the
+ * pools are free; otherwise (a writer or a reload holds them) it goes on
+ * the retired list for that writer to reclaim, so a reader never waits
+ * on a build.
+ */
+static void version_unref(DictView *v) {
+    int last;
+
+    pthread_mutex_lock(&ref_lock);
+    last = --v->refs == 0;
+    pthread_mutex_unlock(&ref_lock);
+    if (!last) return;
+
+    if (pthread_mutex_trylock(&pool_lock) == 0) {
+        version_free(v);
+        pthread_mutex_unlock(&pool_lock);
+    } else {
+        pthread_mutex_lock(&ref_lock);
+        v->next_retired = retired;
+        retired         = v;
+        pthread_mutex_unlock(&ref_lock);
+    }
+}
+
+/* Enter / leave a writer section of h.  Returns the published version,
+   which cannot be swapped out before write_end. */
+static DictView *write_begin(DictHandle *h) {
+    pthread_mutex_lock(&h->write_lock);
+    pthread_mutex_lock(&pool_lock);
+    reclaim_retired();
+    return h->cur;
+}
+
+/* Apply the picks counted in v so far, and re-rank what decayed since
+   the ranking clock last moved.  Caller is in a writer section. */
+static void apply_scores(DictView *v) {
+    score_clock_advance(score_minutes());
+    if (store_pending_picks(&v->store) == 0 && !store_decay_due(&v->store)) return;
+    pthread_rwlock_wrlock(&v->lock);
+    autocomplete_apply_selections(&v->store, v->avl_root, &v->trie);
+    autocomplete_apply_decay(&v->store, v->avl_root, &v->trie);
+    pthread_rwlock_unlock(&v->lock);
+}
+
+static void write_end(DictHandle *h) {
+    apply_scores(h->cur);              /* every writer brings scores up to date */
+    reclaim_retired();
+    pthread_mutex_unlock(&pool_lock);
+    pthread_mutex_unlock(&h->write_lock);
+}
+
+typedef struct ForeachCtx {
+    void (*callback)(const WordRecord *, void *);
+    void  *arg;
+} ForeachCtx;
+
+static void foreach_cb(AVLNode *node, void *arg) {
+    ForeachCtx *ctx = (ForeachCtx *)arg;
+    ctx->callback(node->rec, ctx->arg);
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+DictHandle *dict_handle_create(void) {
+    DictHandle *h = (DictHandle *)malloc(sizeof(DictHandle));
+    if (!h) {
+        fprintf(stderr, "[ERROR] dict_handle_create: malloc failed\n");
+        return NULL;
+    }
+    pthread_mutex_lock(&pool_lock);
+    h->cur = version_create();
+    pthread_mutex_unlock(&pool_lock);
+    if (!h->cur || pthread_mutex_init(&h->write_lock, NULL) != 0) {
+        if (h->cur) version_unref(h->cur);
+        free(h);
+        return NULL;
+    }
+    h->generation      = 1;
+    h->cur->generation = 1;
+    return h;
+}
+
+void dict_handle_destroy(DictHandle *h) {
+    DictView *v;
+    if (!h) return;
+
+    pthread_mutex_lock(&ref_lock);
+    v      = h->cur;
+    h->cur = NULL;
+    pthread_mutex_unlock(&ref_lock);
+    version_unref(v);
+
+    pthread_mutex_lock(&pool_lock);
+    reclaim_retired();
+    pthread_mutex_unlock(&pool_lock);
+
+    pthread_mutex_destroy(&h->write_lock);
+    free(h);
+}
+
+int dict_handle_load(DictHandle *h, const char *path) {
+    DictView *v = write_begin(h);
+    int       n;
+
+    pthread_rwlock_wrlock(&v->lock);
+    n = load_words(path, &v->store, &v->bst_root, &v->avl_root,
+                   v->tbt_header, &v->trie);
+    eytz_build(&v->frozen, v->avl_root);    /* on failure: the word index */
+    pthread_rwlock_unlock(&v->lock);
+    write_end(h);
+    return n;
+}
+
+int dict_handle_reload(DictHandle *h, const char *path, const char *freq_path) {
+    DictView *old, *fresh;
+    int       n;
+
+    write_begin(h);
+    fresh = version_create();
+    if (!fresh) {
+        write_end(h);
+        return -1;
+    }
+
+    /* Off to the side: no reader can reach fresh yet, so no v->lock */
+    n = load_words(path, &fresh->store, &fresh->bst_root, &fresh->avl_root,
+                   fresh->tbt_header, &fresh->trie);
+    if (n <= 0) {
+        version_free(fresh);
+        write_end(h);
+        return -1;
+    }
+    if (freq_path) load_frequencies(freq_path, &fresh->store, fresh->avl_root,
+                                    &fresh->trie);
+    eytz_build(&fresh->frozen, fresh->avl_root);
+    fresh->generation = ++h->generation;
+
+    /* Publish: views taken from here on see fresh; views of old keep it
+       alive until they are released */
+    pthread_mutex_lock(&ref_lock);
+    old    = h->cur;
+    h->cur = fresh;
+    pthread_mutex_unlock(&ref_lock);
+    version_unref(old);            /* reclaimed by write_end if unpinned */
+
+    n = avl_count(fresh->avl_root);
+    write_end(h);
+    return n;
+}
+
+int dict_handle_build(DictHandle *h, WordRecord *const *recs, int n) {
+    DictView    *old, *fresh;
+    WordRecord **stored, copy;
+    int          i;
+
+    if (!recs || n <= 0) return -1;
+    stored = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *));
+    if (!stored) return -1;
+    write_begin(h);
+    fresh = version_create();
+    if (!fresh) {
+        write_end(h);
+        free(stored);
+        return -1;
+    }
+
+    /* Off to the side, as in dict_handle_reload.  A definition still on
+       disk is read now: the copy must not borrow the source's file. */
+    for (i = 0; i < n; i++) {
+        copy         = *recs[i];
+        copy.meaning = word_record_meaning(recs[i]);
+        stored[i]    = store_add(&fresh->store, &copy);
+        if (!stored[i]) {
+            version_free(fresh);
+            write_end(h);
+            free(stored);
+            return -1;
+        }
+        if (stored[i]->select_time != 0) store_track_decay(&fresh->store, stored[i]);
+    }
+    load_build_sorted(stored, n, &fresh->bst_root, &fresh->avl_root,
+                      fresh->tbt_header, &fresh->trie);
+    free(stored);
+    eytz_build(&fresh->frozen, fresh->avl_root);
+    fresh->generation = ++h->generation;
+
+    pthread_mutex_lock(&ref_lock);
+    old    = h->cur;
+    h->cur = fresh;
+    pthread_mutex_unlock(&ref_lock);
+    version_unref(old);
+
+    n = avl_count(fresh->avl_root);
+    write_end(h);
+    return n;
+}
+
+int dict_handle_insert(DictHandle *h, const WordRecord *rec) {
+    DictView   *v = write_begin(h);
+    WordRecord *stored;
+    int         added = 0;
+
+    pthread_rwlock_wrlock(&v->lock);
+    stored = store_add(&v->store, rec);
+    if (stored && store_find(&v->store, stored->word) == stored) {
+        if (bst_insert(&v->bst_root, stored))
+            bst_rebalance_if_deep(&v->bst_root, bst_depth(v->bst_root, stored->word));
+        v->avl_root = avl_insert(v->avl_root, stored);
+        tbt_insert(v->tbt_header, stored);
+        trie_insert(&v->trie, stored);
+        eytz_free(&v->frozen);              /* stale until the next reload */
+        added = 1;
+    } else if (stored) {
+        store_release(&v->store, stored);   /* duplicate — drop the new copy */
+    }
+    pthread_rwlock_unlock(&v->lock);
+    write_end(h);
+    return added;
+}
+
+int dict_handle_delete(DictHandle *h, const char *word) {
+    DictView   *v = write_begin(h);
+    WordRecord *rec;
+    int         found = 0;
+
+    pthread_rwlock_wrlock(&v->lock);
+    rec = store_find(&v->store, word);
+    if (rec) {
+        const char *key = rec->word;        /* stays valid until the release */
+        bst_delete(&v->bst_root, key);
+        v->avl_root = avl_delete(v->avl_root, key);
+        tbt_delete(v->tbt_header, key);
+        trie_delete(&v->trie, key);
+        eytz_free(&v->frozen);
+        store_release(&v->store, rec);      /* no tree references it now */
+        found = 1;
+    }
+    pthread_rwlock_unlock(&v->lock);
+    write_end(h);
+    return found;
+}
+
+void dict_handle_record_selection(DictHandle *h, const char *word) {
+    DictView *v = dict_handle_acquire(h);
+    int       counted;
+
+    /* Counting is lock-free: pickers share the lock with readers */
+    pthread_rwlock_rdlock(&v->lock);
+    counted = autocomplete_count_selection(word, &v->store);
+    pthread_rwlock_unlock(&v->lock);
+
+    /* Rank it now unless a writer is busy; that one applies it as it
+       leaves (write_end) */
+    if (counted && pthread_mutex_trylock(&h->write_lock) == 0) {
+        pthread_mutex_lock(&pool_lock);
+        write_end(h);
+    }
+    dict_view_release(v);
+}
+
+void dict_handle_refresh_scores(DictHandle *h) {
+    write_begin(h);
+    write_end(h);                       /* which applies and re-ranks */
+}
+
+DictView *dict_handle_acquire(DictHandle *h) {
+    DictView *v;
+    pthread_mutex_lock(&ref_lock);
+    v = h->cur;
+    v->refs++;
+    pthread_mutex_unlock(&ref_lock);
+    return v;
+}
+
+void dict_view_release(DictView *v) {
+    if (v) version_unref(v);
+}
+
+unsigned long dict_view_generation(const DictView *v) {
+    return v->generation;
+}
+
+int dict_view_lookup(DictView *v, const char *word, WordRecord *out) {
+    WordRecord *rec;
+    int         found = 0;
+
+    pthread_rwlock_rdlock(&v->lock);
+    rec = v->frozen.n > 0 ? eytz_search(&v->frozen, word)
+                          : store_find(&v->store, word);
+    if (rec) {
+        *out  = *rec;
+        found = 1;
+    }
+    pthread_rwlock_unlock(&v->lock);
+    return found;
+}
+
+int dict_view_autocomplete(DictView *v, const char *prefix,
+                           WordRecord *results, int top_k) {
+    int n;
+    pthread_rwlock_rdlock(&v->lock);
+    n = autocomplete_trie(&v->trie, prefix, results, top_k);
+    pthread_rwlock_unlock(&v->lock);
+    return n;
+}
+
+int dict_view_autocomplete_boosted(DictView *v, const BoostTable *boosts,
+                                   const char *prefix, WordRecord *results,
+                                   int top_k) {
+    int n;
+    pthread_rwlock_rdlock(&v->lock);
+    n = autocomplete_trie_boosted(&v->trie, &v->store, boosts, prefix,
+                                  results, top_k);
+    pthread_rwlock_unlock(&v->lock);
+    return n;
+}
+
+int dict_view_count(DictView *v) {
+    int n;
+    pthread_rwlock_rdlock(&v->lock);
+    n = avl_count(v->avl_root);
+    pthread_rwlock_unlock(&v->lock);
+    return n;
+}
+
+void dict_view_foreach(DictView *v,
+                       void (*callback)(const WordRecord *, void *), void *arg) {
+    ForeachCtx ctx;
+    ctx.callback = callback;
+    ctx.arg      = arg;
+
+    pthread_rwlock_rdlock(&v->lock);
+    avl_inorder(v->avl_root, foreach_cb, &ctx);
+    pthread_rwlock_unlock(&v->lock);
+}
+
+int dict_handle_lookup(DictHandle *h, const char *word, WordRecord *out) {
+    DictView *v     = dict_handle_acquire(h);
+    int       found = dict_view_lookup(v, word, out);
+    dict_view_release(v);
+    return found;
+}
+
+int dict_handle_autocomplete(DictHandle *h, const char *prefix,
+                             WordRecord *results, int top_k) {
+    DictView *v = dict_handle_acquire(h);
+    int       n = dict_view_autocomplete(v, prefix, results, top_k);
+    dict_view_release(v);
+    return n;
+}
+
+int dict_handle_autocomplete_boosted(DictHandle *h, const BoostTable *boosts,
+                                     const char *prefix, WordRecord *results,
+                                     int top_k) {
+    DictView *v = dict_handle_acquire(h);
+    int       n = dict_view_autocomplete_boosted(v, boosts, prefix, results, top_k);
+    dict_view_release(v);
+    return n;
+}
+
+int dict_handle_count(DictHandle *h) {
+    DictView *v = dict_handle_acquire(h);
+    int       n = dict_view_count(v);
+    dict_view_release(v);
+    return n;
+}
+
+void dict_handle_foreach(DictHandle *h,
+                         void (*callback)(const WordRecord *, void *), void *arg) {
+    DictView *v = dict_handle_acquire(h);
+    dict_view_foreach(v, callback, arg);
+    dict_view_release(v);
+}
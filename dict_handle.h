@@ -0,0 +1,172 @@
+/* dict_handle.h - Thread-safe dictionary handle (many readers, one writer) */
+#ifndef DICT_HANDLE_H
+#define DICT_HANDLE_H
+
+#include "dictionary.h"
+#include "boost.h"
+
+/*
+ * DictHandle - a dictionary (record store, BST, AVL, TBT and trie) that can
+ * be queried from a pool of threads while it is being updated.
+ *
+ * The handle publishes one version of the dictionary at a time.  Readers
+ * pin the current version (DictView) and query it; writers either edit
+ * the current version in place (insert, delete, load) or build
+ * a complete replacement off to the side and swap it in (reload):
+ *
+ *   - In-place writes and reads of a version exclude each other through
+ *     that version's reader-writer lock: readers run in parallel, a write
+ *     briefly holds everyone else out.  Writers are serialised per handle.
+ *   - A reload builds the new version without touching the published
+ *     one, so readers keep answering from the old dictionary for the
+ *     whole build.  Publishing is a pointer swap; the old version is
+ *     retired and reclaimed when the last view pinning it is released
+ *     (reference counting stands in for RCU's grace period).
+ *   - User picks are counted under the reader lock with atomic adds
+ *     (store.h, pending picks), so sessions recording picks never wait
+ *     for each other or for readers; a writer section applies them.
+ *
+ * Every read path is strictly read-only: lookups go through a frozen
+ * Eytzinger copy of the sorted keys (eytz.h) built by each load and
+ * reload, ranked prefix queries through the trie's cached top-k lists,
+ * and foreach walks the AVL in order.  An in-place insert or delete drops
+ * the frozen copy, and lookups fall back to the store's word index
+ * (store_find) until the next reload.
+ *
+ * Results are copied out under the version's lock, so the caller never
+ * holds a pointer into a tree.  A copied record's meaning and POS live
+ * in its version's store: they stay valid while a view of that version
+ * is held, even if the word is deleted meanwhile (arena text is never
+ * reused).  The dict_handle_* read shortcuts pin only for the call, so
+ * their text is only safe until the next reload.
+ *
+ * Tree nodes come from process-wide per-module pools, so writers of
+ * different handles are serialised too.  Code that drives the same tree
+ * modules directly (the CLI's globals) must not run a pool reset while a
+ * handle is alive.
+ *
+ * The types are opaque: every access goes through the locks.
+ */
+typedef struct DictHandle DictHandle;
+typedef struct DictView   DictView;
+
+/* Create an empty handle. Returns NULL on allocation failure. */
+DictHandle *dict_handle_create(void);
+
+/* Free the handle and its current version.  No other thread may still
+   use h; views still held keep their version alive until released. */
+void dict_handle_destroy(DictHandle *h);
+
+/* ── Writers ─────────────────────────────────────────────────── */
+
+/*
+ * Load a word file into the current version (see load_words for the
+ * formats).  Readers wait while it runs; use dict_handle_reload to
+ * refresh under load.  Returns the number of words added, or -1 on file
+ * open error.
+ */
+int dict_handle_load(DictHandle *h, const char *path);
+
+/*
+ * Build a new version from the word file at path (plus the frequency
+ * file freq_path, if non-NULL) and publish it in place of the current
+ * one.  Readers are never blocked by the build.  Writes issued meanwhile
+ * wait and then apply to the new version.  On failure (path missing,
+ * no words, out of memory) the current version stays published.
+ * Returns the number of words in the new version, or -1.
+ */
+int dict_handle_reload(DictHandle *h, const char *path, const char *freq_path);
+
+/*
+ * The same from records already in memory: recs[0..n), sorted by word
+ * with no duplicates (a sorted walk of another dictionary, or a slice of
+ * one).  Each record is copied, meaning and POS included, into the new
+ * version's own store.  Returns the number of words in the new version,
+ * or -1 (the current version stays published).
+ */
+int dict_handle_build(DictHandle *h, WordRecord *const *recs, int n);
+
+/*
+ * Add a copy of rec (word normalised, text copied).
+ * Returns 1 if added, 0 if the word already exists or on failure.
+ */
+int dict_handle_insert(DictHandle *h, const WordRecord *rec);
+
+/* Remove word from every index.  Returns 1 if it was found. */
+int dict_handle_delete(DictHandle *h, const char *word);
+
+/*
+ * Count a user pick of word (see autocomplete_record_selection).  Never
+ * waits for other pickers or readers: the pick is counted lock-free under
+ * the reader lock, then applied to the rankings at once if no writer is
+ * busy, else by that writer when it finishes.  A pick that lands just as
+ * a writer finishes is applied by the next pick or write.  Picks counted
+ * in a version that a reload replaces are dropped with it, like every
+ * pick not saved to the file the reload reads.
+ */
+void dict_handle_record_selection(DictHandle *h, const char *word);
+
+/*
+ * Bring the rankings up to date: apply the picks counted so far and
+ * re-rank the records whose picks decayed since the ranking clock last
+ * moved (see dictionary.h).  Every writer does this on its way out; a
+ * handle that goes long without writes should call it now and then —
+ * once per SCORE_EPOCH_MIN is enough — so ranked answers follow the
+ * clock.
+ */
+void dict_handle_refresh_scores(DictHandle *h);
+
+/* ── Readers ─────────────────────────────────────────────────── */
+
+/* Pin the current version.  O(1); never waits for a reload.  Release
+   with dict_view_release once the results are no longer needed. */
+DictView *dict_handle_acquire(DictHandle *h);
+
+/* Drop a pin; reclaims the version if it was retired and this was the
+   last view of it. */
+void dict_view_release(DictView *v);
+
+/* Version number of v: 1 for the first, +1 per successful reload. */
+unsigned long dict_view_generation(const DictView *v);
+
+/* Copy the record for word (case-insensitive) into *out.
+   Returns 1 if found, 0 otherwise. */
+int dict_view_lookup(DictView *v, const char *word, WordRecord *out);
+
+/* Up to top_k best-ranked words starting with prefix, copied into
+   results (see autocomplete_trie).  Returns the number found. */
+int dict_view_autocomplete(DictView *v, const char *prefix,
+                           WordRecord *results, int top_k);
+
+/* The same as one user sees it, with boosts applied on top (see
+   autocomplete_trie_boosted).  The table is the caller's and is only
+   read; one table per user, shared across threads only if no one
+   writes to it meanwhile. */
+int dict_view_autocomplete_boosted(DictView *v, const BoostTable *boosts,
+                                   const char *prefix, WordRecord *results,
+                                   int top_k);
+
+/* Return the number of words in v. */
+int dict_view_count(DictView *v);
+
+/*
+ * Call callback(rec, arg) for every record of v in sorted order.  The
+ * version's read lock is held for the whole walk, so the callback must
+ * not call back into the handle (a write would deadlock, and a nested
+ * read may wait behind a queued writer).
+ */
+void dict_view_foreach(DictView *v,
+                       void (*callback)(const WordRecord *, void *), void *arg);
+
+/* Shortcuts: acquire, query, release (see the text lifetime note above). */
+int dict_handle_lookup(DictHandle *h, const char *word, WordRecord *out);
+int dict_handle_autocomplete(DictHandle *h, const char *prefix,
+                             WordRecord *results, int top_k);
+int dict_handle_autocomplete_boosted(DictHandle *h, const BoostTable *boosts,
+                                     const char *prefix, WordRecord *results,
+                                     int top_k);
+int dict_handle_count(DictHandle *h);
+void dict_handle_foreach(DictHandle *h,
+                         void (*callback)(const WordRecord *, void *), void *arg);
+
+#endif /* DICT_HANDLE_H */
@@ -1,33 +1,174 @@
 /* dictionary.c - WordRecord utility function implementations */
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
 #include "dictionary.h"
+#include "lazytext.h"
 #include "utils.h"
 
+/* ── Ranking clock and pick decay ────────────────────────────── */
+
+#define PICK_WEIGHT_MAX  (1 << 24)   /* cap, far above any real frequency */
+#define PICK_EXP_MAX     40          /* half-lives 2^x is computed across */
+
+/* Read by every score on any thread; moved forward by compare-and-swap */
+#if defined(__GNUC__)
+#define CLOCK_LOAD(p)        __atomic_load_n((p), __ATOMIC_RELAXED)
+#define CLOCK_CAS(p, e, v)   __atomic_compare_exchange_n((p), (e), (v), 0, \
+                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#else
+#define CLOCK_LOAD(p)        (*(p))
+#define CLOCK_CAS(p, e, v)   (*(p) = (v), 1)
+#endif
+
+static int g_clock = 0;   /* minutes, a multiple of SCORE_EPOCH_MIN; 0: unset */
+
+/* 2^(i/64) in 16.16 fixed point, i = 0..64 */
+static const uint32_t EXP2_64THS[65] = {
+     65536,  66250,  66971,  67700,  68438,  69183,  69936,  70698,
+     71468,  72246,  73032,  73828,  74632,  75444,  76266,  77096,
+     77936,  78785,  79642,  80510,  81386,  82273,  83169,  84074,
+     84990,  85915,  86851,  87796,  88752,  89719,  90696,  91684,
+     92682,  93691,  94711,  95743,  96785,  97839,  98905,  99982,
+    101070, 102171, 103283, 104408, 105545, 106694, 107856, 109031,
+    110218, 111418, 112631, 113858, 115098, 116351, 117618, 118899,
+    120194, 121502, 122825, 124163, 125515, 126882, 128263, 129660,
+    131072,
+};
+
+/* 2^(num / den) in 16.16 fixed point (den > 0); 0 below 2^-PICK_EXP_MAX,
+   capped at 2^PICK_EXP_MAX.  The fraction is interpolated from the table. */
+static uint64_t exp2_q16(long long num, long long den) {
+    long long q = num / den, r = num % den, at;
+    uint64_t  v;
+    int       i;
+
+    if (r < 0) { r += den; q--; }          /* floor division */
+    if (q < -PICK_EXP_MAX) return 0;
+    if (q >= PICK_EXP_MAX) { q = PICK_EXP_MAX; r = 0; }
+    at = r * 64;
+    i  = (int)(at / den);
+    v  = EXP2_64THS[i] + (uint64_t)((EXP2_64THS[i + 1] - EXP2_64THS[i]) * (at % den) / den);
+    return q >= 0 ? v << q : v >> -q;
+}
+
+/* log2(v / 65536) in 16.16 fixed point, for v > 0. */
+static long long log2_q16(uint64_t v) {
+    long long e = 0;
+    int       i = 0;
+
+    while (v >= 2u * 65536u) { v >>= 1; e++; }
+    while (v < 65536u)       { v <<= 1; e--; }
+    while (i < 63 && EXP2_64THS[i + 1] <= v) i++;
+    return e * 65536 + i * 1024 +
+           (long long)(v - EXP2_64THS[i]) * 1024 / (EXP2_64THS[i + 1] - EXP2_64THS[i]);
+}
+
+int score_minutes(void) {
+    time_t now = time(NULL);
+    return now > 0 ? (int)(now / 60) : 0;
+}
+
+int score_clock(void) {
+    int c = CLOCK_LOAD(&g_clock);
+    if (c == 0) {
+        score_clock_advance(score_minutes());
+        c = CLOCK_LOAD(&g_clock);
+    }
+    return c;
+}
+
+int score_clock_advance(int now) {
+    int step = now - now % SCORE_EPOCH_MIN;
+    int cur  = CLOCK_LOAD(&g_clock);
+
+    while (step > cur)
+        if (CLOCK_CAS(&g_clock, &cur, step)) return 1;   /* else cur reloaded */
+    return 0;
+}
+
+int score_pick_weight(int select_time, int clock) {
+    uint64_t v;
+    if (select_time == 0) return 0;
+    v = exp2_q16((long long)select_time - clock, SELECT_HALF_LIFE_MIN);
+    v = (v * SELECT_WEIGHT + 32768) >> 16;
+    return v > PICK_WEIGHT_MAX ? PICK_WEIGHT_MAX : (int)v;
+}
+
+int score_add_picks(int select_time, int picks, int now) {
+    uint64_t  sum;
+    long long t;
+
+    if (picks <= 0) return select_time;
+    /* The sum of 2^(t_i/H), taken relative to now: the old picks' share
+       plus 1 for each new one */
+    sum = (select_time ? exp2_q16((long long)select_time - now, SELECT_HALF_LIFE_MIN) : 0) +
+          ((uint64_t)picks << 16);
+    t = now + (log2_q16(sum) * SELECT_HALF_LIFE_MIN + 32768) / 65536;
+    return t > INT32_MAX ? INT32_MAX : (int)t;
+}
+
+/* ── WordRecord ──────────────────────────────────────────────── */
+
 void word_record_init(WordRecord *rec) {
     if (!rec) return;
-    /* Zero all fields: empty strings, zero integers */
+    /* Zero all fields: empty key, zero integers */
     memset(rec, 0, sizeof(WordRecord));
+    /* Cold fields point at a shared empty string, never NULL */
+    rec->meaning           = "";
+    rec->part_of_speech    = "";
     /* Set frequency to default (1) to distinguish "no data" from "unset") */
     rec->frequency_score   = FREQ_SCORE_DEFAULT;
     rec->user_select_count = 0;
+    rec->id                = -1;   /* not yet owned by a RecordStore */
+}
+
+const char *word_record_meaning(const WordRecord *rec) {
+    if (!rec || !rec->meaning) return "";
+    if (rec->meaning[0] != '\0') return rec->meaning;   /* placeholders read as "" */
+    return lazytext_resolve(rec->meaning);
+}
+
+void dict_key_init(DictKey *key, const char *word) {
+    if (!key) return;
+    str_tolower(key->text, word ? word : "", sizeof(key->text));
+}
+
+uint64_t dict_word_prefix(const char *word) {
+    uint64_t k = 0;
+    int      i;
+    for (i = 0; i < 8; i++) {
+        k <<= 8;
+        if (*word) k |= (unsigned char)*word++;
+    }
+    return k;
 }
 
 int word_record_compare(const WordRecord *a, const WordRecord *b) {
-    char la[MAX_WORD_LEN];
-    char lb[MAX_WORD_LEN];
     if (!a || !b) return 0;
-    /* Lowercase both words into stack buffers before comparing */
-    str_tolower(la, a->word, sizeof(la));
-    str_tolower(lb, b->word, sizeof(lb));
-    return strcmp(la, lb);
+    /* Keys are normalised on the way into the store */
+    return str_key_cmp(a->word, b->word);
+}
+
+int word_record_score(const WordRecord *rec) {
+    if (rec->select_time == 0) return rec->frequency_score;   /* most records */
+    return rec->frequency_score + score_pick_weight(rec->select_time, score_clock());
+}
+
+int word_record_outranks(const WordRecord *a, const WordRecord *b) {
+    int sa = word_record_score(a), sb = word_record_score(b);
+    if (sa != sb) return sa > sb;
+    return str_key_cmp(a->word, b->word) < 0;
 }
 
 void word_record_print(const WordRecord *rec) {
+    const char *meaning;
     if (!rec) return;
+    meaning = word_record_meaning(rec);
     printf("  Word          : %s\n",  rec->word);
-    if (rec->meaning[0] != '\0')
-        printf("  Meaning       : %s\n",  rec->meaning);
+    if (meaning[0] != '\0')
+        printf("  Meaning       : %s\n",  meaning);
     if (rec->part_of_speech[0] != '\0')
         printf("  Part of speech: %s\n",  rec->part_of_speech);
     printf("  Freq score    : %d\n",  rec->frequency_score);
@@ -2,39 +2,137 @@
 #ifndef DICTIONARY_H
 #define DICTIONARY_H
 
+#include <stdint.h>
 #include "config.h"
 
 /*
  * WordRecord - the data payload for every dictionary entry.
  *
- * Fixed-size char arrays (not char*) keep each node self-contained:
- * one malloc per node, one free per node, no dangling pointers.
+ * Hot/cold split: the record itself carries only what lookups and ranking
+ * touch — the key and the two scores.  The definition text and POS tag
+ * are "cold": the record just points at them, and they live in the
+ * RecordStore's string arena (store.h, arena.h) at their exact length,
+ * only read when a word is displayed.  Every tree probe therefore pulls ~96 bytes through the
+ * cache instead of the old ~616-byte record.
  *
- * Layout (~616 bytes per record):
- *   char word[64]            - 64 bytes  (primary key, lowercase-normalised)
- *   char meaning[512]        - 512 bytes (human-readable definition)
- *   char part_of_speech[32]  - 32 bytes  (e.g. "noun", "verb")
- *   int  frequency_score     - 4 bytes   (corpus frequency)
- *   int  user_select_count   - 4 bytes   (incremented on user pick)
+ * Records are owned by the RecordStore; tree nodes only point at them,
+ * so each entry exists once no matter how many trees index it.
+ *
+ * Layout (~96 bytes per record on 64-bit):
+ *   char  word[64]            - 64 bytes (primary key, lowercase-normalised)
+ *   char *meaning             - 8 bytes  (cold: definition text, never NULL)
+ *   char *part_of_speech      - 8 bytes  (cold: e.g. "noun", never NULL)
+ *   int   frequency_score     - 4 bytes  (corpus frequency)
+ *   int   user_select_count   - 4 bytes  (incremented on user pick)
+ *   int   select_time         - 4 bytes  (how recent the picks are, below)
+ *   int   id                  - 4 bytes  (RecordStore slot, -1 if unstored)
+ *
+ * Before store_add, meaning/part_of_speech may point at any caller-owned
+ * strings; store_add copies them into the store's arena.  With
+ * LAZY_MEANINGS a loaded meaning may still be in its file: read it with
+ * word_record_meaning.
  */
 typedef struct WordRecord {
-    char word[MAX_WORD_LEN];
-    char meaning[MAX_MEANING_LEN];
-    char part_of_speech[MAX_POS_LEN];
-    int  frequency_score;
-    int  user_select_count;
+    char        word[MAX_WORD_LEN];
+    const char *meaning;
+    const char *part_of_speech;
+    int         frequency_score;
+    int         user_select_count;
+    int         select_time;
+    int         id;
 } WordRecord;
 
-/* Initialise all fields to safe empty state (zeroed strings, freq = FREQ_SCORE_DEFAULT). */
+/*
+ * Ranking - word_record_score is frequency_score plus the weight of the
+ * user's picks, which decays: a pick is worth SELECT_WEIGHT points when
+ * it is made and half that every SELECT_HALF_LIFE_MIN minutes after, so
+ * old picks fade instead of outranking fresh ones forever.
+ * user_select_count stays the lifetime total, for display.
+ *
+ * No per-pick history is kept; select_time alone carries the weight.  It
+ * is the time (minutes since 1970) at which a single fresh pick would be
+ * worth what all of the record's picks are worth — a pick at t adds
+ * 2^(t/H) to a running sum, and select_time is H * log2 of the sum — so
+ * a pick updates it in O(1) (score_add_picks) and the weight at any later
+ * time is SELECT_WEIGHT * 2^((select_time - now) / H).  0 means no picks
+ * that still count.
+ *
+ * "now" is the ranking clock: one per process, in steps of
+ * SCORE_EPOCH_MIN, moved only by score_clock_advance.  Between steps every
+ * score is constant, so whatever caches scores (AVL max_score, trie top-k
+ * lists) stays exact.  After a step a store re-ranks only the records
+ * whose picks still weigh something (store_decay) — never a whole tree.
+ * The weight is worked out from select_time when a score is read, with
+ * integer arithmetic alone.
+ */
+
+/* Wall-clock time in minutes since 1970. */
+int score_minutes(void);
+
+/* The ranking clock, in minutes (set to the current step on first use). */
+int score_clock(void);
+
+/* Move the ranking clock to the step holding now (minutes), if that is
+   later.  Thread-safe.  Returns 1 if it moved, else 0. */
+int score_clock_advance(int now);
+
+/* Weight of picks stamped select_time when the clock reads clock. */
+int score_pick_weight(int select_time, int clock);
+
+/* select_time after picks more picks at now (minutes).  select_time 0
+   means none yet, so score_add_picks(0, n, now) stamps n picks made now. */
+int score_add_picks(int select_time, int picks, int now);
+
+/*
+ * DictKey - a lookup key normalised once at the API boundary.
+ *
+ * Stored words are already lowercase and zero-filled past the NUL
+ * (store_add normalises them), so a query in DictKey form can be compared
+ * with str_key_cmp (utils.h) at every tree level.  Build one with dict_key_init, then reuse it for as many
+ * probes as needed (the *_search_normalized entry points take it as is).
+ */
+typedef struct DictKey {
+    char text[MAX_WORD_LEN];   /* lowercase, zero-filled past the NUL */
+} DictKey;
+
+/* Normalise word (lowercase, truncated to MAX_WORD_LEN-1) into key. */
+void dict_key_init(DictKey *key, const char *word);
+
+/*
+ * First 8 bytes of a normalised word packed big-endian (zero-padded past
+ * the NUL), so unsigned integer order matches strcmp order on that
+ * prefix.  Wide-node indexes keep these inline to compare keys without
+ * touching the record; equal values still need a strcmp to decide.
+ */
+uint64_t dict_word_prefix(const char *word);
+
+/*
+ * The definition text of rec.  Usually rec->meaning itself; a meaning
+ * loaded lazily (lazytext.h) is a placeholder that reads as "", and is
+ * fetched from its file on the first call.  Every reader of a meaning
+ * goes through here.
+ */
+const char *word_record_meaning(const WordRecord *rec);
+
+/* Initialise all fields to safe empty state (empty strings, freq = FREQ_SCORE_DEFAULT). */
 void word_record_init(WordRecord *rec);
 
+/* Autocomplete ranking score: frequency_score + the decayed weight of
+   the record's picks at the ranking clock. */
+int word_record_score(const WordRecord *rec);
+
+/* Ranking order for autocomplete: 1 if a sorts before b — higher score
+   first, equal scores alphabetically — else 0. */
+int word_record_outranks(const WordRecord *a, const WordRecord *b);
+
 /* Print a single WordRecord to stdout in a formatted block. */
 void word_record_print(const WordRecord *rec);
 
 /*
- * Compare two WordRecord instances by word field (case-insensitive, lexicographic).
+ * Compare two WordRecord instances by word field (lexicographic).
  * Returns negative / zero / positive like strcmp.
- * Used as the BST/AVL ordering predicate.
+ * Both words must already be normalised (true for every stored record),
+ * so this is a plain strcmp — no per-call lowercasing.
  */
 int word_record_compare(const WordRecord *a, const WordRecord *b);
 
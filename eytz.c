@@ -0,0 +1,151 @@
+/* eytz.c - Eytzinger-layout frozen index implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "eytz.h"
+
+/* Descendants of slot k three levels down start at 8k: one cache line
+   of packed keys.  Prefetching past the end is harmless. */
+#if defined(__GNUC__)
+#define EYTZ_PREFETCH(p)  __builtin_prefetch(p)
+#else
+#define EYTZ_PREFETCH(p)  ((void)0)
+#endif
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* Is the word in slot k strictly less than (packed, word)? */
+static int slot_less(const EytzIndex *ix, int k, uint64_t packed, const char *word) {
+    uint64_t q = ix->keys[k];
+    if (q != packed) return q < packed;
+    return strcmp(ix->recs[k]->word, word) < 0;
+}
+
+/* Slot of the smallest word: the leftmost leaf of the implicit tree. */
+static int first_slot(int n) {
+    int k = 1;
+    if (n < 1) return 0;
+    while (2 * k <= n) k *= 2;
+    return k;
+}
+
+static int alloc_slots(EytzIndex *ix, int n) {
+    eytz_free(ix);
+    if (n <= 0) return 0;
+    ix->keys = (uint64_t *)malloc(((size_t)n + 1) * sizeof(uint64_t));
+    ix->recs = (WordRecord **)malloc(((size_t)n + 1) * sizeof(WordRecord *));
+    if (!ix->keys || !ix->recs) {
+        fprintf(stderr, "[ERROR] eytz_build: malloc failed\n");
+        eytz_free(ix);
+        return -1;
+    }
+    ix->keys[0] = 0;
+    ix->recs[0] = NULL;
+    ix->n       = n;
+    return 0;
+}
+
+/* Sorted input arrives in order; the fill cursor walks the slots in
+   the same (inorder) sequence. */
+typedef struct FillCtx {
+    EytzIndex *ix;
+    int        slot;
+} FillCtx;
+
+static void fill(FillCtx *ctx, WordRecord *rec) {
+    EytzIndex *ix = ctx->ix;
+    if (ctx->slot == 0) return;               /* more records than counted */
+    ix->keys[ctx->slot] = dict_word_prefix(rec->word);
+    ix->recs[ctx->slot] = rec;
+    ctx->slot = eytz_next(ix, ctx->slot);
+}
+
+static void fill_cb(AVLNode *node, void *arg) {
+    fill((FillCtx *)arg, node->rec);
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int eytz_build_sorted(EytzIndex *ix, WordRecord *const *sorted, int n) {
+    FillCtx ctx;
+    int     i;
+
+    if (alloc_slots(ix, n) != 0) return -1;
+    ctx.ix   = ix;
+    ctx.slot = first_slot(n);
+    for (i = 0; i < n; i++) fill(&ctx, sorted[i]);
+    return 0;
+}
+
+int eytz_build(EytzIndex *ix, AVLNode *avl_root) {
+    FillCtx ctx;
+
+    if (alloc_slots(ix, avl_count(avl_root)) != 0) return -1;
+    ctx.ix   = ix;
+    ctx.slot = first_slot(ix->n);
+    avl_inorder(avl_root, fill_cb, &ctx);
+    return 0;
+}
+
+void eytz_free(EytzIndex *ix) {
+    free(ix->keys);
+    free(ix->recs);
+    ix->keys = NULL;
+    ix->recs = NULL;
+    ix->n    = 0;
+}
+
+WordRecord *eytz_search(const EytzIndex *ix, const char *word) {
+    DictKey key;
+    dict_key_init(&key, word);
+    return eytz_search_normalized(ix, &key);
+}
+
+WordRecord *eytz_search_normalized(const EytzIndex *ix, const DictKey *key) {
+    int k = eytz_lower_bound(ix, key);
+    if (k == 0 || strcmp(ix->recs[k]->word, key->text) != 0) return NULL;
+    return ix->recs[k];
+}
+
+int eytz_lower_bound(const EytzIndex *ix, const DictKey *key) {
+    uint64_t packed = dict_word_prefix(key->text);
+    int      k = 1;
+
+    /* Descend to a virtual leaf past slot n, going right whenever
+       the slot is smaller than the key */
+    while (k <= ix->n) {
+        EYTZ_PREFETCH(ix->keys + 8 * (size_t)k);
+        k = 2 * k + slot_less(ix, k, packed, key->text);
+    }
+    /* The answer is the last slot where we went left: drop the
+       trailing right turns (1 bits) and that left turn */
+    while (k & 1) k >>= 1;
+    return k >> 1;
+}
+
+int eytz_next(const EytzIndex *ix, int slot) {
+    if (slot < 1 || slot > ix->n) return 0;
+    if (2 * slot + 1 <= ix->n) {              /* leftmost of right subtree */
+        slot = 2 * slot + 1;
+        while (2 * slot <= ix->n) slot *= 2;
+        return slot;
+    }
+    while (slot & 1) slot >>= 1;              /* climb out of right subtrees */
+    return slot >> 1;
+}
+
+int eytz_foreach_prefix(const EytzIndex *ix, const char *prefix,
+                        void (*callback)(WordRecord *, void *), void *arg) {
+    DictKey key;
+    size_t  plen;
+    int     k, count = 0;
+
+    dict_key_init(&key, prefix ? prefix : "");
+    plen = strlen(key.text);
+    for (k = eytz_lower_bound(ix, &key); k != 0; k = eytz_next(ix, k)) {
+        if (strncmp(ix->recs[k]->word, key.text, plen) != 0) break;
+        callback(ix->recs[k], arg);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,76 @@
+/* eytz.h - Frozen, pointer-free search index in Eytzinger (BFS) order */
+#ifndef EYTZ_H
+#define EYTZ_H
+
+#include <stdint.h>
+#include "dictionary.h"
+#include "avl.h"
+
+/*
+ * EytzIndex - a read-only snapshot of the sorted word list laid out as an
+ * implicit complete binary search tree: slot 1 is the root and the
+ * children of slot k are 2k and 2k+1 (slot 0 is unused).
+ *
+ * A tree probe chases pointers to nodes scattered over the pools; here
+ * the first levels of every search share the same few cache lines and a
+ * descent is pure index arithmetic, so the hardware can fetch ahead:
+ * each step prefetches the line holding the node's descendants three
+ * levels down.  The comparison picks the next slot arithmetically
+ * (k = 2k + less) instead of branching on it.
+ *
+ * Two parallel arrays keep the hot path small:
+ *   keys[k]  the word's packed 8-byte prefix (dict_word_prefix), so
+ *            most compares are one integer compare (8 slots a cache line)
+ *   recs[k]  the record; its word is only read when the packed prefixes
+ *            are equal
+ *
+ * The index is frozen: it borrows the records and never changes after
+ * eytz_build.  Any insert or delete in the source dictionary makes it
+ * stale — free it (or rebuild) before the next query.
+ */
+typedef struct EytzIndex {
+    uint64_t    *keys;   /* packed word prefixes, 1-based           */
+    WordRecord **recs;   /* records in the same slots               */
+    int          n;      /* records indexed (slots 1..n)            */
+} EytzIndex;
+
+/* Static initialiser for an empty index. */
+#define EYTZ_INIT  { NULL, NULL, 0 }
+
+/*
+ * Build ix from the n records of sorted (strictly increasing words).
+ * Any previous contents are freed.  O(n).  Returns 0 on success, -1 on
+ * malloc failure (ix is left empty).
+ */
+int eytz_build_sorted(EytzIndex *ix, WordRecord *const *sorted, int n);
+
+/* Build ix from an inorder walk of the AVL tree.  Returns 0 or -1. */
+int eytz_build(EytzIndex *ix, AVLNode *avl_root);
+
+/* Free the arrays; ix is left empty and reusable. */
+void eytz_free(EytzIndex *ix);
+
+/* Exact lookup (case-insensitive).  O(log n). Returns NULL if absent. */
+WordRecord *eytz_search(const EytzIndex *ix, const char *word);
+
+/* Same as eytz_search for a key already normalised with dict_key_init. */
+WordRecord *eytz_search_normalized(const EytzIndex *ix, const DictKey *key);
+
+/*
+ * Slot of the first word >= key, or 0 if every word is smaller.
+ * Walk on in sorted order with eytz_next; ix->recs[slot] is the record.
+ */
+int eytz_lower_bound(const EytzIndex *ix, const DictKey *key);
+
+/* Slot following slot in sorted order, or 0 after the last word. */
+int eytz_next(const EytzIndex *ix, int slot);
+
+/*
+ * Call callback(rec, arg) for every word starting with prefix
+ * (case-insensitive), in sorted order: one lower-bound descent, then a
+ * forward scan.  Returns the number of words visited.
+ */
+int eytz_foreach_prefix(const EytzIndex *ix, const char *prefix,
+                        void (*callback)(WordRecord *, void *), void *arg);
+
+#endif /* EYTZ_H */
@@ -0,0 +1,180 @@
+/* federation.c - Several dictionaries searched as one, ranked together */
+#include <stdlib.h>
+#include <string.h>
+#include "federation.h"
+#include "utils.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* One ranked list, read from its head. */
+typedef struct FedStream {
+    WordRecord *rec;     /* results, best first           */
+    int         n;       /* results                       */
+    int         pos;     /* head: next to merge           */
+    int         score;   /* word_record_score of the head */
+    int         member;  /* which list                    */
+} FedStream;
+
+/* 1 if stream a's head ranks before b's, as word_record_outranks, with
+   equal ranks (one word in two lists) to the earlier list. */
+static int head_before(const FedStream *a, const FedStream *b) {
+    int cmp;
+    if (a->score != b->score) return a->score > b->score;
+    cmp = str_key_cmp(a->rec[a->pos].word, b->rec[b->pos].word);
+    if (cmp != 0) return cmp < 0;
+    return a->member < b->member;
+}
+
+/* Restore heap order below slot i (best head on top). */
+static void sift_down(FedStream **heap, int n, int i) {
+    FedStream *s;
+    int        c;
+    for (;;) {
+        c = 2 * i + 1;
+        if (c >= n) break;
+        if (c + 1 < n && head_before(heap[c + 1], heap[c])) c++;
+        if (!head_before(heap[c], heap[i])) break;
+        s = heap[i]; heap[i] = heap[c]; heap[c] = s;
+        i = c;
+    }
+}
+
+/* 1 if word is already among results[0..n).  At most k compares, and k
+   is small, so a scan beats any set. */
+static int already_listed(const WordRecord *results, int n, const char *word) {
+    int i;
+    for (i = 0; i < n; i++)
+        if (strcmp(results[i].word, word) == 0) return 1;
+    return 0;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void federation_init(Federation *f) {
+    if (!f) return;
+    memset(f, 0, sizeof(*f));
+}
+
+int federation_add(Federation *f, const char *name, const char *path,
+                   const char *freq_path) {
+    DictHandle *h;
+
+    if (!f || !name || !path || f->count >= FED_MAX_MEMBERS) return -1;
+    if (federation_find(f, name) >= 0) return -1;
+    h = dict_handle_create();
+    if (!h) return -1;
+    if (dict_handle_reload(h, path, freq_path) <= 0) {
+        dict_handle_destroy(h);
+        return -1;
+    }
+    str_safe_copy(f->member[f->count].name, name, FED_NAME_LEN);
+    f->member[f->count].dict = h;
+    return f->count++;
+}
+
+int federation_find(const Federation *f, const char *name) {
+    int i;
+    if (!f || !name) return -1;
+    for (i = 0; i < f->count; i++)
+        if (strcmp(f->member[i].name, name) == 0) return i;
+    return -1;
+}
+
+int federation_reload(Federation *f, int i, const char *path,
+                      const char *freq_path) {
+    if (!f || i < 0 || i >= f->count || !path) return -1;
+    return dict_handle_reload(f->member[i].dict, path, freq_path);
+}
+
+int federation_lookup(Federation *f, const char *word, WordRecord *out) {
+    int i;
+    if (!f || !word) return -1;
+    for (i = 0; i < f->count; i++)
+        if (dict_handle_lookup(f->member[i].dict, word, out)) return i;
+    return -1;
+}
+
+int federation_record_selection(Federation *f, const char *word) {
+    WordRecord rec;
+    int        i = federation_lookup(f, word, &rec);
+    if (i >= 0) dict_handle_record_selection(f->member[i].dict, word);
+    return i;
+}
+
+int federation_merge(WordRecord *const *lists, const int *counts, int m,
+                     WordRecord *results, int top_k, int *sources) {
+    FedStream  stream[FED_MERGE_MAX];
+    FedStream *heap[FED_MERGE_MAX], *top;
+    int        i, h = 0, n = 0;
+
+    if (!lists || !counts || !results) return 0;
+    if (m > FED_MERGE_MAX) m = FED_MERGE_MAX;
+    for (i = 0; i < m; i++) {
+        FedStream *s = &stream[i];
+        s->rec    = lists[i];
+        s->n      = counts[i];
+        s->pos    = 0;
+        s->member = i;
+        if (s->n <= 0) continue;
+        s->score  = word_record_score(&s->rec[0]);
+        heap[h++] = s;
+    }
+    for (i = h / 2 - 1; i >= 0; i--) sift_down(heap, h, i);
+
+    while (h > 0 && n < top_k) {
+        top = heap[0];
+        if (!already_listed(results, n, top->rec[top->pos].word)) {
+            results[n] = top->rec[top->pos];
+            if (sources) sources[n] = top->member;
+            n++;
+        }
+        if (++top->pos < top->n) {
+            top->score = word_record_score(&top->rec[top->pos]);
+        } else {
+            heap[0] = heap[--h];           /* list used up */
+        }
+        sift_down(heap, h, 0);
+    }
+    return n;
+}
+
+/* Each member's top k goes into one buffer, m * k records, under a view
+   pinned for the whole merge (so no reload frees the text meanwhile). */
+int federation_autocomplete(Federation *f, const char *prefix,
+                            WordRecord *results, int top_k, int *sources) {
+    DictView   *view[FED_MAX_MEMBERS];
+    WordRecord *lists[FED_MAX_MEMBERS];
+    int         counts[FED_MAX_MEMBERS];
+    WordRecord *buf;
+    int         i, n, k;
+
+    if (!f || !prefix || !results || top_k <= 0 || f->count == 0) return 0;
+    k   = top_k > TOP_K_MAX ? TOP_K_MAX : top_k;
+    buf = (WordRecord *)malloc((size_t)f->count * (size_t)k * sizeof(WordRecord));
+    if (!buf) return 0;
+
+    for (i = 0; i < f->count; i++) {
+        view[i]   = dict_handle_acquire(f->member[i].dict);
+        lists[i]  = buf + (size_t)i * (size_t)k;
+        counts[i] = dict_view_autocomplete(view[i], prefix, lists[i], k);
+    }
+    n = federation_merge(lists, counts, f->count, results, k, sources);
+
+    for (i = 0; i < f->count; i++) dict_view_release(view[i]);
+    free(buf);
+    return n;
+}
+
+int federation_count(Federation *f) {
+    int i, total = 0;
+    if (!f) return 0;
+    for (i = 0; i < f->count; i++) total += dict_handle_count(f->member[i].dict);
+    return total;
+}
+
+void federation_free(Federation *f) {
+    int i;
+    if (!f) return;
+    for (i = 0; i < f->count; i++) dict_handle_destroy(f->member[i].dict);
+    federation_init(f);
+}
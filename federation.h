@@ -0,0 +1,101 @@
+/* federation.h - Several dictionaries searched as one, ranked together */
+#ifndef FEDERATION_H
+#define FEDERATION_H
+
+#include "config.h"
+#include "dictionary.h"
+#include "dict_handle.h"
+
+/*
+ * Federation - an ordered list of independent dictionaries answered as
+ * one: a base word list, domain glossaries, a user's own words.  Each
+ * member is a DictHandle (dict_handle.h) with its own store, trees and
+ * trie top-k caches, so it is loaded, reloaded, edited and re-ranked on
+ * its own, through the federation or straight through its handle, while
+ * the others keep serving.
+ *
+ * Autocomplete asks every member for its own top k and merges the m
+ * ranked streams with a min-heap of their heads: O(m + k log m) past the
+ * member queries, with no concatenation and sort.  A word held by several
+ * members is listed once, as its best-ranked copy; equal ranks go to the
+ * earlier member.  This is exactly the top k of the union: a word that
+ * one member ranks below its k-th is outranked there by k others, and
+ * each of those ranks at least as high in the merge.
+ *
+ * Lookups and picks go to the first member that holds the word, so the
+ * order members are added in is their priority.
+ *
+ * Queries may run from many threads at once, since the handles lock for
+ * themselves.  Adding members and freeing the federation must not
+ * overlap with anything else.  Copied results keep their text while no
+ * member is reloaded, as with the dict_handle_* shortcuts.
+ */
+typedef struct FedMember {
+    char        name[FED_NAME_LEN];
+    DictHandle *dict;
+} FedMember;
+
+typedef struct Federation {
+    FedMember member[FED_MAX_MEMBERS];  /* in priority order */
+    int       count;
+} Federation;
+
+/* Initialise an empty federation. */
+void federation_init(Federation *f);
+
+/*
+ * Add a member called name, loaded from the word file at path and ranked
+ * by the frequency file freq_path (NULL for none).  Returns its index, or
+ * -1 if the federation is full, the name is taken, or the file gives no
+ * words.
+ */
+int federation_add(Federation *f, const char *name, const char *path,
+                   const char *freq_path);
+
+/* Index of the member called name, or -1. */
+int federation_find(const Federation *f, const char *name);
+
+/* Rebuild member i from path (and freq_path) with dict_handle_reload:
+   the member answers from its old words until the new ones are in.
+   Returns its new word count, or -1 (the old words stay). */
+int federation_reload(Federation *f, int i, const char *path,
+                      const char *freq_path);
+
+/* Copy the record for word from the first member holding it into *out.
+   Returns that member's index, or -1 if no member has the word. */
+int federation_lookup(Federation *f, const char *word, WordRecord *out);
+
+/* Count a pick of word in the first member holding it.  Returns that
+   member's index, or -1. */
+int federation_record_selection(Federation *f, const char *word);
+
+/*
+ * Up to top_k best-ranked words starting with prefix across every member,
+ * best first and each word once, copied into results.  If sources is
+ * non-NULL, sources[i] is the index of the member results[i] came from.
+ * Returns the number found.
+ */
+int federation_autocomplete(Federation *f, const char *prefix,
+                            WordRecord *results, int top_k, int *sources);
+
+/* Most lists one federation_merge call takes */
+#define FED_MERGE_MAX  64
+
+/*
+ * The heap merge under federation_autocomplete, for any ranked lists:
+ * lists[i] holds counts[i] records, best first (word_record_outranks).
+ * Copies the top_k best into results, each word once (its first and so
+ * best copy), with sources[i] (if non-NULL) the list results[i] came
+ * from.  Only the first FED_MERGE_MAX lists are read.  Returns the
+ * number of results.
+ */
+int federation_merge(WordRecord *const *lists, const int *counts, int m,
+                     WordRecord *results, int top_k, int *sources);
+
+/* Words held, over every member (a word in two members counts twice). */
+int federation_count(Federation *f);
+
+/* Destroy every member; f is left empty. */
+void federation_free(Federation *f);
+
+#endif /* FEDERATION_H */
@@ -0,0 +1,308 @@
+/* fulltext.c - Inverted index over definitions */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fulltext.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* Too common to narrow a search; never indexed, skipped in queries */
+static const char *const STOP_WORDS[] = {
+    "an", "and", "are", "as", "at", "be", "by", "for", "from", "in", "is",
+    "it", "its", "of", "on", "or", "that", "the", "this", "to", "was",
+    "which", "with"
+};
+#define NUM_STOP_WORDS  ((int)(sizeof(STOP_WORDS) / sizeof(STOP_WORDS[0])))
+
+static int is_term_char(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+static int is_stop_word(const char *term, int len) {
+    int i;
+    if (len > 5) return 0;
+    for (i = 0; i < NUM_STOP_WORDS; i++)
+        if (strcmp(term, STOP_WORDS[i]) == 0) return 1;
+    return 0;
+}
+
+/*
+ * Copy the next indexable term at or after *s into term (lowercased,
+ * NUL-terminated), advance *s past it and return its length; 0 once the
+ * text is used up.
+ */
+static int next_term(const char **s, char *term) {
+    const unsigned char *p = (const unsigned char *)*s;
+    int                  len;
+
+    for (;;) {
+        while (*p && !is_term_char(*p)) p++;
+        if (!*p) break;
+        for (len = 0; is_term_char(*p); p++, len++)
+            if (len < FULLTEXT_TERM_MAX)
+                term[len] = (char)(*p >= 'A' && *p <= 'Z' ? *p - 'A' + 'a' : *p);
+        if (len < 2 || len > FULLTEXT_TERM_MAX) continue;
+        term[len] = '\0';
+        if (is_stop_word(term, len)) continue;
+        *s = (const char *)p;
+        return len;
+    }
+    *s = (const char *)p;
+    return 0;
+}
+
+static uint32_t term_hash(const char *term) {
+    uint32_t h = 2166136261u;
+    while (*term) {
+        h ^= (unsigned char)*term++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* The table slot holding term, or the empty slot where it would go. */
+static uint32_t term_slot(const FullTextIndex *ix, const char *term) {
+    uint32_t i = term_hash(term) & ix->mask;
+    while (ix->terms[i] != UINT32_MAX &&
+           strcmp(ix->text + ix->text_off[ix->terms[i]], term) != 0)
+        i = (i + 1) & ix->mask;
+    return i;
+}
+
+/* Grow *p (*cap elements of size elem) to hold at least need. */
+static int grow(void *pp, size_t *cap, size_t need, size_t elem) {
+    void **p = (void **)pp;
+    size_t c = *cap ? *cap : 1024;
+    void  *q;
+    if (need <= *cap) return 0;
+    while (c < need) c *= 2;
+    q = realloc(*p, c * elem);
+    if (!q) return -1;
+    *p   = q;
+    *cap = c;
+    return 0;
+}
+
+/* Double the term table, re-placing every term. */
+static int grow_table(FullTextIndex *ix) {
+    uint32_t  old_mask = ix->mask, i;
+    uint32_t *old      = ix->terms;
+
+    ix->mask  = old ? old_mask * 2 + 1 : 4095;
+    ix->terms = (uint32_t *)malloc(((size_t)ix->mask + 1) * sizeof(uint32_t));
+    if (!ix->terms) { ix->terms = old; ix->mask = old_mask; return -1; }
+    memset(ix->terms, 0xFF, ((size_t)ix->mask + 1) * sizeof(uint32_t));
+    if (old) {
+        for (i = 0; i <= old_mask; i++)
+            if (old[i] != UINT32_MAX)
+                ix->terms[term_slot(ix, ix->text + ix->text_off[old[i]])] = old[i];
+        free(old);
+    }
+    return 0;
+}
+
+static void collect_cb(AVLNode *n, void *arg) {
+    WordRecord ***out = (WordRecord ***)arg;
+    *(*out)++ = n->rec;
+}
+
+static uint8_t *put_varint(uint8_t *b, uint32_t v) {
+    while (v >= 0x80) {
+        *b++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *b++ = (uint8_t)v;
+    return b;
+}
+
+static const uint8_t *get_varint(const uint8_t *b, uint32_t *v) {
+    uint32_t x = 0;
+    int      shift = 0;
+    while (*b & 0x80) {
+        x |= (uint32_t)(*b++ & 0x7F) << shift;
+        shift += 7;
+    }
+    *v = x | ((uint32_t)*b++ << shift);
+    return b;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int fulltext_build(FullTextIndex *ix, AVLNode *avl_root) {
+    char          term[FULLTEXT_TERM_MAX + 1];
+    WordRecord  **out;
+    uint32_t     *occ = NULL, *word_end = NULL, *last = NULL, *fill = NULL, *ids = NULL;
+    size_t        occ_cap = 0, text_cap = 0, term_cap = 0, last_cap = 0, df_cap = 0;
+    size_t        num_occ = 0, total;
+    const char   *s;
+    uint8_t      *b;
+    uint32_t      slot, t, prev, k;
+    int           n = avl_count(avl_root), w, len;
+
+    if (!ix) return -1;
+    fulltext_free(ix);
+    if (n == 0) return 0;
+
+    ix->recs = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *));
+    word_end = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+    if (!ix->recs || !word_end || grow_table(ix) != 0) goto fail;
+    out = ix->recs;
+    avl_inorder(avl_root, collect_cb, &out);
+
+    /* Pass 1: number the terms and list each word's distinct ones */
+    for (w = 0; w < n; w++) {
+        s = word_record_meaning(ix->recs[w]);
+        while ((len = next_term(&s, term)) > 0) {
+            slot = term_slot(ix, term);
+            t    = ix->terms[slot];
+            if (t == UINT32_MAX) {
+                t = (uint32_t)ix->num_terms;
+                if (grow(&ix->text, &text_cap, ix->text_len + (size_t)len + 1, 1) != 0 ||
+                    grow(&ix->text_off, &term_cap, t + 1, sizeof(uint32_t)) != 0 ||
+                    grow(&ix->df, &df_cap, t + 1, sizeof(uint32_t)) != 0 ||
+                    grow(&last, &last_cap, t + 1, sizeof(uint32_t)) != 0)
+                    goto fail;
+                memcpy(ix->text + ix->text_len, term, (size_t)len + 1);
+                ix->text_off[t] = (uint32_t)ix->text_len;
+                ix->text_len   += (size_t)len + 1;
+                ix->df[t]       = 0;
+                last[t]         = UINT32_MAX;
+                ix->num_terms++;
+                ix->terms[slot] = t;
+                if ((uint32_t)ix->num_terms * 4 > (ix->mask + 1) * 3 && grow_table(ix) != 0)
+                    goto fail;
+            }
+            if (last[t] == (uint32_t)w) continue;       /* repeated in this definition */
+            last[t] = (uint32_t)w;
+            if (grow(&occ, &occ_cap, num_occ + 1, sizeof(uint32_t)) != 0) goto fail;
+            occ[num_occ++] = t;
+            ix->df[t]++;
+        }
+        word_end[w] = (uint32_t)num_occ;
+    }
+
+    /* Pass 2: bucket the word ids by term (ascending within each term),
+       then encode every list as varint gaps */
+    ix->post_off = (uint32_t *)malloc(((size_t)ix->num_terms + 1) * sizeof(uint32_t));
+    fill         = (uint32_t *)malloc(((size_t)ix->num_terms + 1) * sizeof(uint32_t));
+    ids          = (uint32_t *)malloc((num_occ ? num_occ : 1) * sizeof(uint32_t));
+    ix->post     = (uint8_t *)malloc((num_occ ? num_occ : 1) * 5);
+    if (!ix->post_off || !fill || !ids || !ix->post) goto fail;
+
+    for (total = 0, t = 0; t < (uint32_t)ix->num_terms; t++) {
+        fill[t] = (uint32_t)total;
+        total  += ix->df[t];
+    }
+    for (w = 0, k = 0; w < n; w++)
+        for (; k < word_end[w]; k++) ids[fill[occ[k]]++] = (uint32_t)w;
+
+    b = ix->post;
+    for (k = 0, t = 0; t < (uint32_t)ix->num_terms; t++) {
+        ix->post_off[t] = (uint32_t)(b - ix->post);
+        for (prev = 0; k < fill[t]; k++) {
+            b    = put_varint(b, ids[k] - prev);
+            prev = ids[k];
+        }
+    }
+    ix->post_len = (size_t)(b - ix->post);
+    ix->post_off[ix->num_terms] = (uint32_t)ix->post_len;
+    b = (uint8_t *)realloc(ix->post, ix->post_len ? ix->post_len : 1);
+    if (b) ix->post = b;
+
+    ix->words = n;
+    free(occ); free(word_end); free(last); free(fill); free(ids);
+    return 0;
+
+fail:
+    fprintf(stderr, "[ERROR] fulltext_build: malloc failed\n");
+    free(occ); free(word_end); free(last); free(fill); free(ids);
+    fulltext_free(ix);
+    return -1;
+}
+
+void fulltext_free(FullTextIndex *ix) {
+    FullTextIndex empty = FULLTEXT_INIT;
+    if (!ix) return;
+    free(ix->terms);
+    free(ix->text);
+    free(ix->text_off);
+    free(ix->post_off);
+    free(ix->df);
+    free(ix->post);
+    free(ix->recs);
+    *ix = empty;
+}
+
+int fulltext_search(const FullTextIndex *ix, const char *query,
+                    WordRecord *results, int top_k, int *total) {
+    char            term[FULLTEXT_TERM_MAX + 1];
+    uint32_t        q[FULLTEXT_QUERY_TERMS];
+    uint32_t       *cand, v, t;
+    const uint8_t  *p, *end;
+    WordRecord     *best[TOP_K_MAX];
+    WordRecord     *rec;
+    int             nq = 0, i, j, m, kept, n = 0;
+
+    if (total) *total = 0;
+    if (!ix || ix->words == 0 || !query || !results) return 0;
+    if (top_k > TOP_K_MAX) top_k = TOP_K_MAX;
+    if (top_k <= 0) return 0;
+
+    /* Distinct query terms, rarest first; an unknown term matches nothing */
+    while (nq < FULLTEXT_QUERY_TERMS && next_term(&query, term) > 0) {
+        t = ix->terms[term_slot(ix, term)];
+        if (t == UINT32_MAX) return 0;
+        for (i = 0; i < nq && q[i] != t; i++)
+            ;
+        if (i < nq) continue;
+        for (i = nq++; i > 0 && ix->df[q[i - 1]] > ix->df[t]; i--) q[i] = q[i - 1];
+        q[i] = t;
+    }
+    if (nq == 0) return 0;
+
+    cand = (uint32_t *)malloc(ix->df[q[0]] * sizeof(uint32_t));
+    if (!cand) return 0;
+
+    /* Decode the rarest list, then keep only ids every other list holds */
+    p   = ix->post + ix->post_off[q[0]];
+    end = ix->post + ix->post_off[q[0] + 1];
+    for (m = 0, v = 0; p < end; m++) {
+        p = get_varint(p, &t);
+        v += t;
+        cand[m] = v;
+    }
+    for (i = 1; i < nq && m > 0; i++) {
+        p   = ix->post + ix->post_off[q[i]];
+        end = ix->post + ix->post_off[q[i] + 1];
+        for (j = 0, kept = 0, v = 0; p < end && j < m;) {
+            p = get_varint(p, &t);
+            v += t;
+            while (j < m && cand[j] < v) j++;
+            if (j < m && cand[j] == v) cand[kept++] = cand[j++];
+        }
+        m = kept;
+    }
+
+    for (i = 0; i < m; i++) {
+        rec = ix->recs[cand[i]];
+        if (n == top_k && !word_record_outranks(rec, best[n - 1])) continue;
+        j = n < top_k ? n++ : n - 1;        /* the worst one drops out */
+        for (; j > 0 && word_record_outranks(rec, best[j - 1]); j--)
+            best[j] = best[j - 1];
+        best[j] = rec;
+    }
+    free(cand);
+
+    for (i = 0; i < n; i++) results[i] = *best[i];
+    if (total) *total = m;
+    return n;
+}
+
+size_t fulltext_memory(const FullTextIndex *ix) {
+    if (!ix || ix->words == 0) return 0;
+    return ((size_t)ix->mask + 1) * sizeof(uint32_t)
+         + ix->text_len
+         + (size_t)ix->num_terms * 3 * sizeof(uint32_t) + sizeof(uint32_t)
+         + ix->post_len
+         + (size_t)ix->words * sizeof(WordRecord *);
+}
@@ -0,0 +1,78 @@
+/* fulltext.h - Inverted index over definitions (reverse-dictionary search) */
+#ifndef FULLTEXT_H
+#define FULLTEXT_H
+
+#include <stddef.h>   /* size_t */
+#include <stdint.h>
+#include "dictionary.h"
+#include "avl.h"
+
+/* Longest indexed term; longer runs of letters are not indexed */
+#define FULLTEXT_TERM_MAX  31
+
+/* Most distinct terms a query may hold (the rest are ignored) */
+#define FULLTEXT_QUERY_TERMS  8
+
+/*
+ * FullTextIndex - term -> the words whose definition contains it.
+ *
+ * A term is a run of ASCII letters and digits, lowercased, 2 to
+ * FULLTEXT_TERM_MAX long and not a stop word ("the", "of", ...).  Words
+ * are numbered in sorted order and each term's posting list holds the
+ * ascending ids of its words as gaps, each a little-endian base-128
+ * varint — one byte for most gaps — so the ~800k postings of the 90k
+ * definitions take about a byte apiece.
+ *
+ *   terms    open-addressing table (FNV-1a, linear probing) of term ids,
+ *            UINT32_MAX for an empty slot
+ *   text     term strings, NUL-terminated; term t starts at text_off[t]
+ *   post     the encoded lists; term t's is post[post_off[t] ..
+ *            post_off[t + 1]) and holds df[t] ids
+ *   recs     word id -> record
+ *
+ * Like the Eytzinger index and suffix array it is frozen: it borrows
+ * the records, so any insert or delete in the source dictionary makes
+ * it stale — free it (or rebuild) before the next query.
+ */
+typedef struct FullTextIndex {
+    uint32_t     *terms;
+    uint32_t      mask;       /* table slots - 1 (a power of 2 minus 1) */
+    char         *text;
+    uint32_t     *text_off;
+    uint32_t     *post_off;   /* num_terms + 1 entries                  */
+    uint32_t     *df;
+    uint8_t      *post;
+    WordRecord  **recs;
+    int           words;
+    int           num_terms;
+    size_t        text_len, post_len;
+} FullTextIndex;
+
+/* Static initialiser for an empty index. */
+#define FULLTEXT_INIT  { NULL, 0, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, 0, 0 }
+
+/*
+ * Build ix from the definitions of an inorder walk of the AVL tree; any
+ * previous contents are freed.  O(total definition length).  Returns 0
+ * on success, -1 on malloc failure (ix is left empty).
+ */
+int fulltext_build(FullTextIndex *ix, AVLNode *avl_root);
+
+/* Free the arrays; ix is left empty and reusable. */
+void fulltext_free(FullTextIndex *ix);
+
+/*
+ * Top-k words whose definition contains every term of query, ranked
+ * like autocomplete (higher composite score, then alphabetical).  Stop
+ * words and too-short runs in query are skipped.  The posting lists are
+ * intersected shortest first, so the cost follows the rarest term.
+ * Copies the words into results and returns how many; if total is not
+ * NULL it receives the number of words that matched.
+ */
+int fulltext_search(const FullTextIndex *ix, const char *query,
+                    WordRecord *results, int top_k, int *total);
+
+/* Bytes held by the index's arrays. */
+size_t fulltext_memory(const FullTextIndex *ix);
+
+#endif /* FULLTEXT_H */
@@ -1,6 +1,6 @@
 /* gui_main.c - GTK3 graphical interface for Smart Dictionary & Autocomplete Engine
  *
- * Shares all core logic (BST/AVL/TBT/loader/autocomplete/benchmark) with
+ * Shares all core logic (BST/AVL/TBT/Trie/B+/loader/autocomplete/benchmark) with
  * the CLI version.  Only the presentation layer is different.
  *
  * Build:  make gui          (see Makefile)
@@ -11,7 +11,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <io.h>          /* _dup, _dup2, _fileno — MinGW/Windows */
 
 #include "config.h"
 #include "dictionary.h"
@@ -19,23 +18,87 @@
 #include "bst.h"
 #include "avl.h"
 #include "tbt.h"
+#include "trie.h"
+#include "bpt.h"
+#include "bktree.h"
+#include "suffix.h"
+#include "fulltext.h"
+#include "store.h"
 #include "loader.h"
+#include "snapshot.h"
+#include "journal.h"
 #include "autocomplete.h"
+#include "prefix_cache.h"
 #include "benchmark.h"
+#include "querylog.h"
+#include "stats.h"
+#include "memusage.h"
+#include "shape.h"
 
 /* ── Forward declarations ────────────────────────────────────── */
 static void on_search_changed(GtkSearchEntry *entry, gpointer data);
 static void update_stats(void);
 static void show_status(const gchar *msg);
 static void clear_word_detail(void);
+static int  finish_save(int wait);
 
 /* ── Global tree state ───────────────────────────────────────── */
+static RecordStore g_store;           /* owns every WordRecord */
 static BSTNode *g_bst_root    = NULL;
 static AVLNode *g_avl_root    = NULL;
 static TBTNode *g_tbt_header  = NULL;
-static int      g_active_tree = 2;    /* 1=BST  2=AVL  3=TBT */
+static int      g_bst_rebuilds = 0;   /* automatic BST rebalances (shape.h) */
+static Trie     g_trie;               /* radix trie over the same records */
+static BPTree   g_bpt;                /* B+-tree over the same records */
+static int      g_active_tree = 2;    /* 1=BST  2=AVL  3=TBT  4=Trie  5=B+ */
 static int      g_word_count  = 0;
 
+/* Type-ahead state for the search box; reset whenever words or scores change */
+static AutocompleteSession g_session;
+
+/* Hot prefixes behind the session, invalidated word by word on writes */
+static PrefixCache g_cache;
+
+/* "Did you mean" index, built from the AVL the first time a prefix has
+   no completions; g_bk_built says it holds every word */
+static BKTree g_bk;
+static int    g_bk_built = 0;
+
+/* Suffix array for "*text" searches: built on first use, dropped by
+   every insert or delete (it borrows the records) */
+static SuffixIndex g_sfx = SUFFIX_INDEX_INIT;
+
+/* Inverted index over definitions for "?terms" searches; same lifetime */
+static FullTextIndex g_fts = FULLTEXT_INIT;
+
+/* Changes since the last full save; g_save_all is set when the base was
+   replaced and the journal no longer covers the session */
+static Journal g_journal;
+static int     g_save_all = 0;
+static QueryRecorder g_recorder = QUERY_RECORDER_INIT;  /* --record: queries served */
+
+/*
+ * Held by the query worker for each search, and by the main loop wherever
+ * it reads or changes the dictionary or the query state above (session,
+ * prefix cache, lazily built indexes, g_active_tree), so the two never
+ * touch them at once.  Never held across a nested main loop (a dialog)
+ * or a widget change that calls back into a handler taking it.
+ */
+static GMutex g_dict_lock;
+
+/*
+ * Indexes currently built, one bit per tree number (1u << g_active_tree).
+ * The AVL is always built: loading, ranking updates and saving look
+ * records up in it.  With LAZY_INDEXES the others are only built while
+ * they are, or once have been, the active tree; otherwise all five are.
+ */
+static unsigned g_built = 0;
+
+#define INDEX_BIT(tree)  (1u << (tree))
+#define IS_BUILT(tree)   ((g_built & INDEX_BIT(tree)) != 0)
+#define ALL_INDEXES      (INDEX_BIT(1) | INDEX_BIT(2) | INDEX_BIT(3) | \
+                          INDEX_BIT(4) | INDEX_BIT(5))
+
 /* ── Widget references (set during UI construction) ──────────── */
 static GtkWidget *g_window         = NULL;
 static GtkWidget *g_search_entry   = NULL;
@@ -48,6 +111,10 @@ static GtkWidget *g_lbl_picks      = NULL;
 static GtkWidget *g_lbl_stats      = NULL;
 static GtkWidget *g_lbl_status     = NULL;
 static GtkWidget *g_combo_tree     = NULL;
+static GtkWidget *g_btn_insert     = NULL;   /* greyed out while loading */
+static GtkWidget *g_btn_delete     = NULL;
+static GtkWidget *g_btn_load       = NULL;
+static GtkWidget *g_btn_benchmark  = NULL;
 
 /* Last word the user interacted with */
 static char g_selected_word[MAX_WORD_LEN] = "";
@@ -57,36 +124,381 @@ static char g_selected_word[MAX_WORD_LEN] = "";
 static const char *active_tree_name(void) {
     if (g_active_tree == 2) return "AVL";
     if (g_active_tree == 3) return "TBT";
+    if (g_active_tree == 4) return "Trie";
+    if (g_active_tree == 5) return "B+";
     return "BST";
 }
 
+/* The index arguments for loader / update calls: NULL when not built */
+static BSTNode **bst_slot(void)  { return IS_BUILT(1) ? &g_bst_root  : NULL; }
+static TBTNode  *tbt_slot(void)  { return IS_BUILT(3) ? g_tbt_header : NULL; }
+static Trie     *trie_slot(void) { return IS_BUILT(4) ? &g_trie      : NULL; }
+
+static unsigned initial_indexes(void) {
+#if LAZY_INDEXES
+    return INDEX_BIT(2) | INDEX_BIT(g_active_tree);
+#else
+    return ALL_INDEXES;
+#endif
+}
+
+/* Build the active tree from the AVL if it has not been built yet.
+   Returns 0 on success, -1 if it could not be built. */
+static int ensure_active_index(void) {
+    int t = g_active_tree;
+    if (IS_BUILT(t)) return 0;
+    if (t == 5) {
+        if (bpt_build(&g_bpt, g_avl_root) < 0) return -1;
+    } else if (load_build_indexes(g_avl_root, t == 1 ? &g_bst_root  : NULL,
+                                              t == 3 ? g_tbt_header : NULL,
+                                              t == 4 ? &g_trie      : NULL) < 0) {
+        return -1;
+    }
+    g_built |= INDEX_BIT(t);
+    return 0;
+}
+
+static void ensure_fuzzy_index(void) {
+    if (g_bk_built) return;
+    bk_build(&g_bk, g_avl_root);
+    g_bk_built = 1;
+}
+
+/* The loader does not know the B+-tree: bulk-build a wanted one from the
+   AVL after a load (or drop it, falling back to the AVL, on failure). */
+static void finish_load(void) {
+    prefix_cache_clear(&g_cache);      /* frequencies may all have moved */
+    if (IS_BUILT(1) && bst_rebalance_if_deep(&g_bst_root, bst_height(g_bst_root)))
+        g_bst_rebuilds++;              /* a merge of a sorted file skews it */
+    if (!IS_BUILT(5) || bpt_count(&g_bpt) > 0) return;
+    if (bpt_build(&g_bpt, g_avl_root) < 0) {
+        g_built &= ~INDEX_BIT(5);
+        if (g_active_tree == 5) {
+            g_active_tree = 2;
+            if (g_combo_tree)
+                gtk_combo_box_set_active(GTK_COMBO_BOX(g_combo_tree), 1);
+        }
+    }
+#if !LAZY_INDEXES
+    ensure_fuzzy_index();
+    suffix_build(&g_sfx, g_avl_root);
+    fulltext_build(&g_fts, g_avl_root);
+#endif
+}
+
+/*
+ * A dictionary being loaded from a file, off to the side of the one in
+ * the globals above: the load worker fills it while the window keeps
+ * answering from the old words, and the main loop then trades the two.
+ * Its indexes are the ones g_built would hold after the load.
+ */
+typedef struct LoadJob {
+    gchar        *path;
+    gchar        *name;        /* path's base name, for the status bar     */
+    unsigned      built;       /* INDEX_BIT()s to build (or, after the
+                                  trade, that the old dictionary had)      */
+    int           n;           /* words loaded, or <= 0 on failure         */
+    int           rebuilt;     /* the BST was skewed and rebalanced        */
+    RecordStore   store;
+    BSTNode      *bst_root;
+    AVLNode      *avl_root;
+    TBTNode      *tbt_header;
+    Trie          trie;
+    BPTree        bpt;
+    BKTree        bk;
+    int           bk_built;
+    SuffixIndex   sfx;
+    FullTextIndex fts;
+} LoadJob;
+
+static LoadJob *g_load_job    = NULL;   /* the load running, if any */
+static GThread *g_load_thread = NULL;
+
+static LoadJob *load_job_new(const gchar *path) {
+    static const SuffixIndex   no_sfx = SUFFIX_INDEX_INIT;
+    static const FullTextIndex no_fts = FULLTEXT_INIT;
+    LoadJob *job = g_new0(LoadJob, 1);
+
+    job->path  = g_strdup(path);
+    job->name  = g_path_get_basename(path);
+    job->built = initial_indexes();
+    store_init(&job->store);
+    trie_init(&job->trie);
+    bpt_init(&job->bpt);
+    bk_init(&job->bk);
+    job->sfx = no_sfx;
+    job->fts = no_fts;
+    return job;
+}
+
+/* Free job and every structure it holds.  Tree nodes go back to the
+   shared pools, so nothing else may be using them meanwhile. */
+static void load_job_free(LoadJob *job) {
+    bst_free(&job->bst_root);
+    avl_free(&job->avl_root);
+    tbt_free(&job->tbt_header);
+    trie_free(&job->trie);
+    bpt_free(&job->bpt);
+    bk_free(&job->bk);
+    suffix_free(&job->sfx);
+    fulltext_free(&job->fts);
+    store_free(&job->store);
+    g_free(job->path);
+    g_free(job->name);
+    g_free(job);
+}
+
+#define TRADE(type, a, b)  do { type t_ = (a); (a) = (b); (b) = t_; } while (0)
+
+/* Put the dictionary loaded into job in place of the current one, which
+   job then holds for load_job_free.  O(1): structures move, nothing is
+   copied.  With g_dict_lock held. */
+static void trade_dictionary(LoadJob *job) {
+    TRADE(RecordStore,   g_store,      job->store);
+    TRADE(BSTNode *,     g_bst_root,   job->bst_root);
+    TRADE(AVLNode *,     g_avl_root,   job->avl_root);
+    TRADE(TBTNode *,     g_tbt_header, job->tbt_header);
+    TRADE(Trie,          g_trie,       job->trie);
+    TRADE(BPTree,        g_bpt,        job->bpt);
+    TRADE(BKTree,        g_bk,         job->bk);
+    TRADE(int,           g_bk_built,   job->bk_built);
+    TRADE(SuffixIndex,   g_sfx,        job->sfx);
+    TRADE(FullTextIndex, g_fts,        job->fts);
+    TRADE(unsigned,      g_built,      job->built);
+    if (job->rebuilt) g_bst_rebuilds++;
+    g_word_count = avl_count(g_avl_root);
+    autocomplete_session_reset(&g_session);
+    prefix_cache_clear(&g_cache);
+    if (g_active_tree == 5 && !IS_BUILT(5)) {
+        /* The B+-tree could not be built: fall back to the AVL (the combo
+           handler sees the tree already set and returns) */
+        g_active_tree = 2;
+        gtk_combo_box_set_active(GTK_COMBO_BOX(g_combo_tree), 1);
+    }
+}
+
+#undef TRADE
+
+/* ── Changes ─────────────────────────────────────────────────── */
+
+/* Insert a copy of rec into the store and every built index.  Returns
+   the stored record, or NULL if the word is already there. */
+static WordRecord *dict_insert(const WordRecord *rec) {
+    WordRecord *stored = store_add(&g_store, rec);
+    if (!stored || store_find(&g_store, stored->word) != stored) {
+        store_release(&g_store, stored);  /* duplicate */
+        return NULL;
+    }
+    g_avl_root = avl_insert(g_avl_root, stored);
+    if (IS_BUILT(1) && bst_insert(&g_bst_root, stored) &&
+        bst_rebalance_if_deep(&g_bst_root, bst_depth(g_bst_root, stored->word)))
+        g_bst_rebuilds++;
+    if (IS_BUILT(3)) tbt_insert(g_tbt_header, stored);
+    if (IS_BUILT(4)) trie_insert(&g_trie, stored);
+    if (IS_BUILT(5)) bpt_insert(&g_bpt, stored);
+    if (g_bk_built)  bk_insert(&g_bk, stored);
+    suffix_free(&g_sfx);
+    fulltext_free(&g_fts);
+    prefix_cache_invalidate_word(&g_cache, stored->word);
+    autocomplete_session_reset(&g_session);
+    return stored;
+}
+
+/* Delete word from every index.  Returns 1 if it was there, else 0. */
+static int dict_delete(const char *word) {
+    WordRecord *rec = store_find(&g_store, word);
+    if (!rec) return 0;
+    prefix_cache_invalidate_word(&g_cache, rec->word);
+    g_avl_root = avl_delete(g_avl_root, word);
+    if (IS_BUILT(1)) bst_delete (&g_bst_root, word);
+    if (IS_BUILT(3)) tbt_delete (g_tbt_header, word);
+    if (IS_BUILT(4)) trie_delete(&g_trie, word);
+    if (IS_BUILT(5)) bpt_delete (&g_bpt, word);
+    if (g_bk_built)  bk_delete  (&g_bk, word);
+    suffix_free(&g_sfx);
+    fulltext_free(&g_fts);
+    store_release(&g_store, rec);
+    autocomplete_session_reset(&g_session);
+    return 1;
+}
+
+/* Set word's pick count and stamp, keeping the ranking aggregates exact.
+   A stamp of 0 with picks (a log from before picks were stamped) takes
+   them as made now. */
+static void dict_set_picks(const char *word, int picks, int select_time) {
+    WordRecord *rec = store_find(&g_store, word);
+    if (!rec) return;
+    prefix_cache_invalidate_word(&g_cache, rec->word);
+    rec->user_select_count = picks;
+    rec->select_time       = select_time || picks <= 0 ? select_time
+                                                       : score_add_picks(0, picks, score_minutes());
+    store_track_decay(&g_store, rec);
+    avl_score_changed(g_avl_root, rec);
+    if (IS_BUILT(4)) trie_score_changed(&g_trie, rec);
+    autocomplete_session_reset(&g_session);
+}
+
+/* JournalOps over the helpers above, for the replay at start up */
+static void replay_insert(const WordRecord *rec, void *arg) { (void)arg; dict_insert(rec); }
+static void replay_remove(const char *word, void *arg)      { (void)arg; dict_delete(word); }
+static void replay_picks(const char *word, int picks, int select_time, void *arg) {
+    (void)arg;
+    dict_set_picks(word, picks, select_time);
+}
+
+/* Write the whole dictionary out and empty the journal (0, or -1 with
+   the journal kept). */
+static int save_dictionary(void) {
+    if (!g_avl_root) return 0;   /* an empty dictionary would not load back */
+    if (journal_compact(&g_journal, g_avl_root, FILE_CUSTOM_WORDS, FILE_SNAPSHOT) != 0)
+        return -1;
+    g_save_all = 0;
+    return 0;
+}
+
+/*
+ * Complete a background save once it is done (or, with wait set, wait for
+ * it).  Returns its result: 0 saved, -1 failed, 1 nothing to complete.
+ * Must run before the store is freed.
+ */
+static int finish_save(int wait) {
+    if (!journal_compact_running(&g_journal)) return 1;
+    if (!wait && !journal_compact_finished(&g_journal)) return 1;
+    if (journal_compact_end(&g_journal) != 0) return -1;
+    g_save_all = 0;
+    return 0;
+}
+
+/* Back on the main loop after the worker wrote the files. */
+static gboolean on_save_done(gpointer data) {
+    gchar msg[128];
+    int   rc = finish_save(0);
+
+    (void)data;
+    if (rc == 0) {
+        g_snprintf(msg, sizeof(msg),
+                   "Saved %d words to %s.", g_word_count, FILE_CUSTOM_WORDS);
+        show_status(msg);
+    } else if (rc < 0) {
+        show_status("Error: could not write session file.");
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/* Worker thread: hand the result to the main loop. */
+static void save_done_cb(void *arg) {
+    (void)arg;
+    g_idle_add(on_save_done, NULL);
+}
+
+/*
+ * Start a full save on a worker thread, from a copy of the records, so
+ * the window stays responsive; on_save_done reports it.  Returns 0 if it
+ * started (or, short of memory for the copy, finished in place).
+ */
+static int start_save(void) {
+    if (journal_compact_begin(&g_journal, g_avl_root, FILE_CUSTOM_WORDS,
+                              FILE_SNAPSHOT, save_done_cb, NULL) == 0)
+        return 0;
+    return save_dictionary();
+}
+
+/* After a change: a full save once the journal is too big, an append
+   failed or the base was replaced. */
+static void save_if_due(void) {
+    if (!g_avl_root || journal_compact_running(&g_journal)) return;
+    if ((g_save_all || journal_needs_compact(&g_journal)) && start_save() != 0)
+        show_status("Error: could not write session file.");
+}
+
+/* A pick was recorded for word: log its new count. */
+static void log_picks(const char *word) {
+    const WordRecord *rec = store_find(&g_store, word);
+    if (rec) journal_log_picks(&g_journal, rec->word, rec->user_select_count,
+                               rec->select_time);
+    save_if_due();
+}
+
 static void show_status(const gchar *msg) {
     if (g_lbl_status)
         gtk_label_set_text(GTK_LABEL(g_lbl_status), msg);
 }
 
+/* Bytes held by the store and every built index (memusage.h). */
+static size_t memory_in_use(void) {
+    static size_t last = 0;
+    MemUsage      u;
+
+    /* A load worker moves the pools' counters under us: keep the last
+       figure until it is done */
+    if (g_load_job) return last;
+    mem_usage_clear(&u);
+    store_memory(&g_store, &u);
+    avl_memory(g_avl_root, &u);
+    if (IS_BUILT(1)) bst_memory(g_bst_root, &u);
+    if (IS_BUILT(3)) tbt_memory(g_tbt_header, &u);
+    if (IS_BUILT(4)) trie_memory(&g_trie, &u);
+    if (IS_BUILT(5)) bpt_memory(&g_bpt, &u);
+    return last = mem_usage_total(&u);
+}
+
+/* With g_dict_lock held. */
 static void update_stats(void) {
-    gchar buf[256];
+    gchar buf[448], engine[160] = "", rebuilt[40] = "";
+    double mb;
+#if ENGINE_STATS
+    EngineStats es;
+    guint64     q;
+#endif
+
     if (!g_lbl_stats) return;
-    g_snprintf(buf, sizeof(buf),
-               "Words: %d  |  BST h=%d  |  AVL h=%d  |  Active: %s",
-               g_word_count,
-               bst_height(g_bst_root),
-               avl_height(g_avl_root),
-               active_tree_name());
+    mb = memory_in_use() / (1024.0 * 1024.0);
+    if (g_bst_rebuilds > 0)   /* bst_rebalance_if_deep fired (shape.h) */
+        g_snprintf(rebuilt, sizeof(rebuilt), " (rebalanced x%d)", g_bst_rebuilds);
+#if ENGINE_STATS
+    /* What the trees did for every query so far (stats.h) */
+    stats_snapshot(&es);
+    q = es.v[STAT_AC_QUERIES];
+    g_snprintf(engine, sizeof(engine),
+               "  |  Visits %" G_GUINT64_FORMAT "  Cmp %" G_GUINT64_FORMAT
+               "  Rot %" G_GUINT64_FORMAT "  |  AC %" G_GUINT64_FORMAT
+               " q, %.1f cand/q, %.1f us/q",
+               (guint64)es.v[STAT_NODE_VISITS], (guint64)es.v[STAT_KEY_COMPARES],
+               (guint64)es.v[STAT_ROTATIONS], q,
+               q ? (double)es.v[STAT_AC_CANDIDATES] / (double)q : 0.0,
+               q ? (double)es.v[STAT_AC_NS] / (double)q / 1e3 : 0.0);
+#endif
+    if (IS_BUILT(1))
+        g_snprintf(buf, sizeof(buf),
+                   "Words: %d  |  BST h=%d%s  |  AVL h=%d  |  Active: %s"
+                   "  |  Mem %.1f MB  |  Cache %lu/%lu%s",
+                   g_word_count,
+                   bst_height(g_bst_root), rebuilt,
+                   avl_height(g_avl_root),
+                   active_tree_name(), mb,
+                   g_cache.hits, g_cache.hits + g_cache.misses, engine);
+    else
+        g_snprintf(buf, sizeof(buf),
+                   "Words: %d  |  AVL h=%d  |  Active: %s  |  Mem %.1f MB"
+                   "  |  Cache %lu/%lu%s",
+                   g_word_count,
+                   avl_height(g_avl_root),
+                   active_tree_name(), mb,
+                   g_cache.hits, g_cache.hits + g_cache.misses, engine);
     gtk_label_set_text(GTK_LABEL(g_lbl_stats), buf);
 }
 
 /* ── Detail panel ────────────────────────────────────────────── */
 
 static void show_word_detail(const WordRecord *rec) {
-    gchar buf[32];
+    gchar       buf[32];
+    const char *meaning;
     gtk_label_set_text(GTK_LABEL(g_lbl_word),
                        rec->word[0] ? rec->word : "—");
     gtk_label_set_text(GTK_LABEL(g_lbl_pos),
                        rec->part_of_speech[0] ? rec->part_of_speech : "—");
-    gtk_label_set_text(GTK_LABEL(g_lbl_meaning),
-                       rec->meaning[0] ? rec->meaning : "—");
+    meaning = word_record_meaning(rec);   /* read from the file on first use */
+    gtk_label_set_text(GTK_LABEL(g_lbl_meaning), meaning[0] ? meaning : "—");
     g_snprintf(buf, sizeof(buf), "%d", rec->frequency_score);
     gtk_label_set_text(GTK_LABEL(g_lbl_freq), buf);
     g_snprintf(buf, sizeof(buf), "%d", rec->user_select_count);
@@ -103,113 +515,316 @@ static void clear_word_detail(void) {
 
 /* ── Result list ─────────────────────────────────────────────── */
 
-/* Build one row widget for the search-results listbox. */
-static GtkWidget *build_result_row(const WordRecord *rec) {
+/* Build one (empty) row widget for the search-results listbox; set_row
+   fills it.  Its labels hang off it for reuse. */
+static GtkWidget *build_result_row(void) {
     GtkWidget *row, *box, *lbl_word, *lbl_score;
-    gchar score_buf[32];
-    gchar *word_copy;
 
     row  = gtk_list_box_row_new();
     box  = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
     gtk_container_set_border_width(GTK_CONTAINER(box), 6);
 
-    lbl_word = gtk_label_new(rec->word);
+    lbl_word = gtk_label_new("");
     gtk_label_set_xalign(GTK_LABEL(lbl_word), 0.0f);
     gtk_widget_set_hexpand(lbl_word, TRUE);
 
-    g_snprintf(score_buf, sizeof(score_buf), "%d",
-               rec->frequency_score + 10 * rec->user_select_count);
-    lbl_score = gtk_label_new(score_buf);
+    lbl_score = gtk_label_new("");
     gtk_style_context_add_class(gtk_widget_get_style_context(lbl_score),
                                 "score-label");
 
     gtk_box_pack_start(GTK_BOX(box), lbl_word,  TRUE,  TRUE,  0);
     gtk_box_pack_end  (GTK_BOX(box), lbl_score, FALSE, FALSE, 0);
     gtk_container_add(GTK_CONTAINER(row), box);
-
-    /* Attach word string so on_row_activated can retrieve it */
-    word_copy = g_strdup(rec->word);
-    g_object_set_data_full(G_OBJECT(row), "word", word_copy, g_free);
+    g_object_set_data(G_OBJECT(row), "lbl_word",  lbl_word);
+    g_object_set_data(G_OBJECT(row), "lbl_score", lbl_score);
 
     gtk_widget_show_all(row);
     return row;
 }
 
-/* Clear and repopulate the results listbox. */
+/* Show rec in row, touching only the labels whose text changes. */
+static void set_row(GtkWidget *row, const WordRecord *rec) {
+    GtkWidget   *lbl_word  = (GtkWidget *)g_object_get_data(G_OBJECT(row), "lbl_word");
+    GtkWidget   *lbl_score = (GtkWidget *)g_object_get_data(G_OBJECT(row), "lbl_score");
+    const gchar *word      = (const gchar *)g_object_get_data(G_OBJECT(row), "word");
+    gchar        score_buf[32];
+
+    if (!word || strcmp(word, rec->word) != 0) {
+        gtk_label_set_text(GTK_LABEL(lbl_word), rec->word);
+        /* Attach word string so on_row_activated can retrieve it */
+        g_object_set_data_full(G_OBJECT(row), "word", g_strdup(rec->word), g_free);
+    }
+    g_snprintf(score_buf, sizeof(score_buf), "%d", word_record_score(rec));
+    if (strcmp(gtk_label_get_text(GTK_LABEL(lbl_score)), score_buf) != 0)
+        gtk_label_set_text(GTK_LABEL(lbl_score), score_buf);
+}
+
+/*
+ * Show records[0..n) in the results listbox.  Rows are kept and reused:
+ * the first n are refilled in place (set_row), missing ones are added and
+ * the rest hidden, so typing never rebuilds the list.  There are never
+ * more than TOP_K_DEFAULT rows.
+ */
 static void populate_results(const WordRecord *records, int n) {
     GList *children, *c;
-    int i;
+    int    i;
 
-    /* Remove existing rows */
+    gtk_list_box_unselect_all(GTK_LIST_BOX(g_result_listbox));
     children = gtk_container_get_children(GTK_CONTAINER(g_result_listbox));
-    for (c = children; c; c = c->next)
-        gtk_container_remove(GTK_CONTAINER(g_result_listbox),
-                             GTK_WIDGET(c->data));
+    for (c = children, i = 0; c; c = c->next, i++) {
+        if (i < n) {
+            set_row(GTK_WIDGET(c->data), &records[i]);
+            gtk_widget_show(GTK_WIDGET(c->data));
+        } else {
+            gtk_widget_hide(GTK_WIDGET(c->data));
+        }
+    }
     g_list_free(children);
 
-    for (i = 0; i < n; i++)
-        gtk_container_add(GTK_CONTAINER(g_result_listbox),
-                          build_result_row(&records[i]));
-
-    gtk_widget_show_all(g_result_listbox);
+    for (; i < n; i++) {
+        GtkWidget *row = build_result_row();
+        set_row(row, &records[i]);
+        gtk_container_add(GTK_CONTAINER(g_result_listbox), row);
+    }
 }
 
 /* ── Signal callbacks ────────────────────────────────────────── */
 
-/* Called as user types in the search box (after GTK's 150 ms debounce). */
+/* AutocompleteFn for the session: query whichever tree is active. */
+static int active_autocomplete(const char *prefix, WordRecord *results,
+                               int top_k, void *arg) {
+    (void)arg;
+    if (g_active_tree == 2)
+        return autocomplete_avl(g_avl_root,   prefix, results, top_k);
+    if (g_active_tree == 3)
+        return autocomplete_tbt(g_tbt_header, prefix, results, top_k);
+    if (g_active_tree == 4)
+        return autocomplete_trie(&g_trie,     prefix, results, top_k);
+    if (g_active_tree == 5)
+        return autocomplete_bpt(&g_bpt,       prefix, results, top_k);
+    return autocomplete_bst(g_bst_root, prefix, results, top_k);
+}
+
+/* The session's query: the prefix cache, falling back to the active
+   tree.  A prefix nothing starts with takes neither. */
+static int cached_autocomplete(const char *prefix, WordRecord *results,
+                               int top_k, void *arg) {
+    (void)arg;
+    if (!autocomplete_prefix_exists(g_avl_root, trie_slot(), prefix)) return 0;
+    return prefix_cache_autocomplete(&g_cache, &g_store, prefix, results, top_k,
+                                     active_autocomplete, NULL);
+}
+
+/* ── Background queries ──────────────────────────────────────── */
+
+/*
+ * Searches run on a worker thread, so typing never waits for a query.
+ * The search box posts each text into a one-slot mailbox, replacing any
+ * text not yet taken, so a burst of keystrokes arriving while a query
+ * runs collapses into one query for the latest text (on top of
+ * GtkSearchEntry's own 150 ms delay).  Every posting bumps a
+ * generation; a reply whose generation is no longer the latest is
+ * stale and dropped when it reaches the main loop.
+ *
+ * The worker holds g_dict_lock for each query; only the main loop
+ * touches widgets.
+ */
+static GMutex   g_query_lock;          /* guards the mailbox below */
+static GCond    g_query_cond;
+static GThread *g_query_thread  = NULL;
+static gchar   *g_query_text    = NULL; /* posted, not yet taken    */
+static guint    g_query_gen     = 0;    /* latest posting           */
+static gboolean g_query_quit    = FALSE;
+
+/* What a query found, for the main loop to show */
+typedef enum { QUERY_PREFIX, QUERY_FUZZY, QUERY_SUBSTRING, QUERY_FULLTEXT } QueryKind;
+
+typedef struct QueryReply {
+    guint      gen;
+    QueryKind  kind;
+    gchar     *text;                    /* the text searched for           */
+    int        n;                       /* results                         */
+    int        total;                   /* QUERY_PREFIX, QUERY_FULLTEXT:   */
+                                        /* all matches                     */
+    WordRecord results[TOP_K_DEFAULT];  /* copies: the worker moves on     */
+} QueryReply;
+
+/* Answer text into r.  Runs on the worker with g_dict_lock held. */
+static void run_query(const gchar *text, QueryReply *r) {
+    /* Old picks fade: re-rank whatever decayed since the last query */
+    if (autocomplete_apply_decay(&g_store, g_avl_root, trie_slot()) > 0) {
+        prefix_cache_clear(&g_cache);
+        autocomplete_session_reset(&g_session);
+    }
+
+    if (text[0] == '*') {
+        /* "*text": words containing text, from the suffix array */
+        r->kind = QUERY_SUBSTRING;
+        if (g_sfx.n > 0 || suffix_build(&g_sfx, g_avl_root) == 0)
+            r->n = suffix_search(&g_sfx, text + 1, r->results, TOP_K_DEFAULT);
+        return;
+    }
+    if (text[0] == '?') {
+        /* "?terms": words whose definition holds every term */
+        r->kind = QUERY_FULLTEXT;
+        if (g_fts.words > 0 || fulltext_build(&g_fts, g_avl_root) == 0)
+            r->n = fulltext_search(&g_fts, text + 1, r->results, TOP_K_DEFAULT,
+                                   &r->total);
+        return;
+    }
+
+    /* The session answers backspaces and narrowed prefixes itself and
+       only asks the active tree for the rest */
+    r->kind = QUERY_PREFIX;
+    r->n    = autocomplete_session(&g_session, &g_store, text, r->results,
+                                   TOP_K_DEFAULT, cached_autocomplete, NULL);
+    r->total = r->n > 0 ? autocomplete_session_count(&g_session, g_avl_root, text) : 0;
+    if (r->n == 0) {
+        /* No completions: list the nearest words by edit distance instead */
+        r->kind = QUERY_FUZZY;
+        ensure_fuzzy_index();
+        r->n = bk_suggest(&g_bk, text, FUZZY_MAX_DIST, r->results, TOP_K_DEFAULT);
+    }
+}
+
+/* Back on the main loop: show a reply unless a newer text was posted. */
+static gboolean on_query_done(gpointer data) {
+    QueryReply *r = (QueryReply *)data;
+    gchar       msg[128];
+
+    if (r->gen == g_query_gen) {
+        populate_results(r->results, r->n);
+        switch (r->kind) {
+        case QUERY_SUBSTRING:
+            g_snprintf(msg, sizeof(msg), r->n > 0 ? "Top %d words containing \"%s\""
+                                                  : "%d words contain \"%s\".",
+                       r->n, r->text + 1);
+            break;
+        case QUERY_FULLTEXT:
+            g_snprintf(msg, sizeof(msg), "%d definition%s match \"%s\"",
+                       r->total, r->total == 1 ? "" : "s", r->text + 1);
+            break;
+        case QUERY_FUZZY:
+            g_snprintf(msg, sizeof(msg), "%s", r->n > 0
+                       ? "No matches found. Did you mean one of these?"
+                       : "No matches found.");
+            break;
+        default:
+            if (r->total > r->n)
+                g_snprintf(msg, sizeof(msg), "Top %d of %d words starting with \"%s\"",
+                           r->n, r->total, r->text);
+            else
+                g_snprintf(msg, sizeof(msg), "%d match%s for \"%s\"",
+                           r->n, r->n == 1 ? "" : "es", r->text);
+            break;
+        }
+        show_status(msg);
+        g_mutex_lock(&g_dict_lock);
+        update_stats();   /* the cache and engine counters moved */
+        g_mutex_unlock(&g_dict_lock);
+    }
+    g_free(r->text);
+    g_free(r);
+    return G_SOURCE_REMOVE;
+}
+
+/* The worker: take the latest posting, answer it, hand the reply over. */
+static gpointer query_worker(gpointer data) {
+    QueryReply *r;
+
+    (void)data;
+    g_mutex_lock(&g_query_lock);
+    for (;;) {
+        while (!g_query_text && !g_query_quit)
+            g_cond_wait(&g_query_cond, &g_query_lock);
+        if (g_query_quit) break;
+        r       = g_new0(QueryReply, 1);
+        r->text = g_query_text;
+        r->gen  = g_query_gen;
+        g_query_text = NULL;
+        g_mutex_unlock(&g_query_lock);
+
+        g_mutex_lock(&g_dict_lock);
+        run_query(r->text, r);
+        g_mutex_unlock(&g_dict_lock);
+        g_idle_add(on_query_done, r);
+
+        g_mutex_lock(&g_query_lock);
+    }
+    g_mutex_unlock(&g_query_lock);
+    return NULL;
+}
+
+/* Post text (NULL: nothing) as the latest query; any reply still to come
+   for an earlier one is dropped. */
+static void post_query(const gchar *text) {
+    g_mutex_lock(&g_query_lock);
+    g_query_gen++;
+    g_free(g_query_text);
+    g_query_text = text ? g_strdup(text) : NULL;
+    if (text) g_cond_signal(&g_query_cond);
+    g_mutex_unlock(&g_query_lock);
+}
+
+/* Stop the worker (at exit), dropping whatever it still had to do. */
+static void stop_query_worker(void) {
+    if (!g_query_thread) return;
+    g_mutex_lock(&g_query_lock);
+    g_query_quit = TRUE;
+    g_query_gen++;
+    g_free(g_query_text);
+    g_query_text = NULL;
+    g_cond_signal(&g_query_cond);
+    g_mutex_unlock(&g_query_lock);
+    g_thread_join(g_query_thread);
+    g_query_thread = NULL;
+}
+
+/* Called as user types in the search box (after GTK's 150 ms debounce),
+   and to refresh the list after a change: hands the text to the worker. */
 static void on_search_changed(GtkSearchEntry *entry, gpointer data) {
     const gchar *text = gtk_entry_get_text(GTK_ENTRY(entry));
-    WordRecord   results[TOP_K_DEFAULT];
-    int          n;
-    gchar        msg[64];
 
     (void)data;
 
     if (str_is_empty(text)) {
+        post_query(NULL);              /* cancels anything in flight */
         populate_results(NULL, 0);
         clear_word_detail();
         show_status("Type a prefix to search.");
         return;
     }
-
-    if (g_active_tree == 2)
-        n = autocomplete_avl(g_avl_root,   text, results, TOP_K_DEFAULT);
-    else if (g_active_tree == 3)
-        n = autocomplete_tbt(g_tbt_header, text, results, TOP_K_DEFAULT);
-    else
-        n = autocomplete_bst(g_bst_root,   text, results, TOP_K_DEFAULT);
-
-    populate_results(results, n);
-
-    if (n == 0)
-        show_status("No matches found.");
-    else {
-        g_snprintf(msg, sizeof(msg), "%d match%s for \"%s\"",
-                   n, n == 1 ? "" : "es", text);
-        show_status(msg);
-    }
+    if (text[0] != '*' && text[0] != '?')
+        querylog_record(&g_recorder, QLOG_COMPLETE, text);
+    post_query(text);
 }
 
 /* Called when the user presses Enter in the search box (exact lookup). */
 static void on_search_activate(GtkEntry *entry, gpointer data) {
     const gchar *text = gtk_entry_get_text(entry);
-    BSTNode     *node;
+    WordRecord  *rec;
     gchar        msg[128];
 
     (void)data;
 
     if (str_is_empty(text)) return;
 
-    node = bst_search(g_bst_root, text);
-    if (node) {
-        show_word_detail(&node->data);
+    querylog_record(&g_recorder, QLOG_SEARCH, text);
+    g_mutex_lock(&g_dict_lock);
+    rec = store_find(&g_store, text);
+    if (rec) {
+        querylog_record(&g_recorder, QLOG_PICK, text);
+        show_word_detail(rec);
         str_safe_copy(g_selected_word, text, sizeof(g_selected_word));
-        autocomplete_record_selection(text,
-                                      g_bst_root, g_avl_root, g_tbt_header);
+        prefix_cache_invalidate_word(&g_cache, text);
+        autocomplete_record_selection(text, &g_store, g_avl_root, trie_slot());
+        autocomplete_session_reset(&g_session);    /* rankings moved */
+        log_picks(text);
         g_snprintf(msg, sizeof(msg), "Found \"%s\".", text);
     } else {
         g_snprintf(msg, sizeof(msg), "\"%s\" not found.", text);
     }
+    g_mutex_unlock(&g_dict_lock);
     show_status(msg);
 }
 
@@ -218,9 +833,7 @@ static void on_row_activated(GtkListBox    *listbox,
                               GtkListBoxRow *row,
                               gpointer       data) {
     const gchar *word;
-    BSTNode     *bst_n;
-    AVLNode     *avl_n;
-    TBTNode     *tbt_n;
+    WordRecord  *rec;
     gchar        msg[128];
 
     (void)listbox; (void)data;
@@ -230,35 +843,159 @@ static void on_row_activated(GtkListBox    *listbox,
     if (!word) return;
     str_safe_copy(g_selected_word, word, sizeof(g_selected_word));
 
-    /* Look up full record in whichever tree is active */
-    if (g_active_tree == 2) {
-        avl_n = avl_search(g_avl_root, word);
-        if (avl_n) { show_word_detail(&avl_n->data); goto done; }
-    } else if (g_active_tree == 3) {
-        tbt_n = tbt_search(g_tbt_header, word);
-        if (tbt_n) { show_word_detail(&tbt_n->data); goto done; }
-    }
-    bst_n = bst_search(g_bst_root, word);
-    if (bst_n) { show_word_detail(&bst_n->data); }
+    /* Full record from the store's word index, whichever tree is active */
+    g_mutex_lock(&g_dict_lock);
+    rec = store_find(&g_store, word);
+    if (rec) show_word_detail(rec);
 
-done:
     /* Record user selection for personalised autocomplete scoring */
-    autocomplete_record_selection(word,
-                                  g_bst_root, g_avl_root, g_tbt_header);
+    querylog_record(&g_recorder, QLOG_PICK, word);
+    prefix_cache_invalidate_word(&g_cache, word);
+    autocomplete_record_selection(word, &g_store, g_avl_root, trie_slot());
+    autocomplete_session_reset(&g_session);        /* rankings moved */
+    log_picks(word);
+    g_mutex_unlock(&g_dict_lock);
     g_snprintf(msg, sizeof(msg), "Selected \"%s\".", word);
     show_status(msg);
 }
 
 /* Called when the tree selector combo changes. */
 static void on_tree_changed(GtkComboBox *combo, gpointer data) {
-    gint idx = gtk_combo_box_get_active(combo);
+    gint idx  = gtk_combo_box_get_active(combo);
+    int  prev = g_active_tree;
     (void)data;
-    g_active_tree = idx + 1;   /* combo indices 0/1/2 → trees 1/2/3 */
+    /* Set back from below or by finish_load: nothing to switch (and the
+       lock may be held) */
+    if (idx + 1 == prev) return;
+    g_mutex_lock(&g_dict_lock);
+    g_active_tree = idx + 1;   /* combo indices 0..4 → trees 1..5 */
+    if (ensure_active_index() != 0) {
+        /* Could not build it: stay on the previous tree */
+        g_active_tree = prev;
+        g_mutex_unlock(&g_dict_lock);
+        gtk_combo_box_set_active(combo, prev - 1);
+        show_status("Out of memory building that index.");
+        return;
+    }
+    prefix_cache_clear(&g_cache);      /* ties may rank differently */
     update_stats();
+    g_mutex_unlock(&g_dict_lock);
     /* Re-run the current search so results come from the new tree */
     on_search_changed(GTK_SEARCH_ENTRY(g_search_entry), NULL);
 }
 
+/* ── Background loading ──────────────────────────────────────── */
+
+/*
+ * Load File reads the file on a worker thread into a LoadJob, so the
+ * window stays live and the old dictionary keeps answering searches and
+ * taking picks until the new one is complete.  Each stage is reported
+ * to the status bar from an idle callback, and on_load_done then trades
+ * the two dictionaries under g_dict_lock — the query worker sees either
+ * the old one or the new one, whole — and frees the old one.
+ *
+ * The loader allocates BST, AVL and TBT nodes from their process-wide
+ * pools, which are not thread-safe (pool.h), so everything else that
+ * allocates from them — insert, delete, switching to an unbuilt tree, the
+ * benchmark and another load — is greyed out until the load is done.
+ */
+
+static void set_loading(gboolean on) {
+    gtk_widget_set_sensitive(g_btn_insert,    !on);
+    gtk_widget_set_sensitive(g_btn_delete,    !on);
+    gtk_widget_set_sensitive(g_btn_load,      !on);
+    gtk_widget_set_sensitive(g_btn_benchmark, !on);
+    gtk_widget_set_sensitive(g_combo_tree,    !on);
+}
+
+static gboolean on_load_progress(gpointer data) {
+    if (g_load_job) show_status((const gchar *)data);
+    g_free(data);
+    return G_SOURCE_REMOVE;
+}
+
+#define LOAD_STAGES  3
+
+/* Worker: report reaching stage step of LOAD_STAGES. */
+static void load_progress(const LoadJob *job, int step, const char *what) {
+    g_idle_add(on_load_progress,
+               g_strdup_printf("Loading %s (%d/%d): %s…  The current words "
+                               "stay searchable meanwhile.",
+                               job->name, step, LOAD_STAGES, what));
+}
+
+/* Back on the main loop once the worker is done. */
+static gboolean on_load_done(gpointer data) {
+    LoadJob *job = g_load_job;
+    gchar    msg[128];
+    int      n;
+
+    (void)data;
+    if (!job) return G_SOURCE_REMOVE;   /* the window closed first */
+    g_thread_join(g_load_thread);
+    g_load_thread = NULL;
+    g_load_job    = NULL;
+    set_loading(FALSE);
+
+    if (job->n <= 0) {
+        load_job_free(job);
+        show_status("Failed to load file (empty or not found).");
+        return G_SOURCE_REMOVE;
+    }
+
+    finish_save(1);                   /* it reads the records being replaced */
+    post_query(NULL);                 /* replies still to come are for the old words */
+    g_mutex_lock(&g_dict_lock);
+    trade_dictionary(job);
+    n = g_word_count;
+    g_save_all = 1;                   /* the new base replaces the saved session */
+    save_if_due();
+    update_stats();
+    g_mutex_unlock(&g_dict_lock);
+    load_job_free(job);               /* the old dictionary, out of everyone's reach */
+
+    g_snprintf(msg, sizeof(msg), "Loaded %d words.", n);
+    show_status(msg);
+    clear_word_detail();
+    populate_results(NULL, 0);
+    return G_SOURCE_REMOVE;
+}
+
+/* The load worker: build the job's dictionary from scratch, as finish_load
+   completes one loaded into the globals. */
+static gpointer load_worker(gpointer data) {
+    LoadJob *job = (LoadJob *)data;
+
+#define JOB_BUILT(tree)  ((job->built & INDEX_BIT(tree)) != 0)
+    job->tbt_header = tbt_create_header();
+    load_progress(job, 1, "reading words");
+    job->n = load_words(job->path, &job->store,
+                        JOB_BUILT(1) ? &job->bst_root  : NULL, &job->avl_root,
+                        JOB_BUILT(3) ? job->tbt_header : NULL,
+                        JOB_BUILT(4) ? &job->trie      : NULL);
+    if (job->n > 0) {
+        load_progress(job, 2, "applying word frequencies");
+        load_frequencies(FILE_WORD_FREQ, &job->store, job->avl_root,
+                         JOB_BUILT(4) ? &job->trie : NULL);
+
+        load_progress(job, 3, "building indexes");
+        if (JOB_BUILT(1))
+            job->rebuilt = bst_rebalance_if_deep(&job->bst_root,
+                                                 bst_height(job->bst_root));
+        if (JOB_BUILT(5) && bpt_build(&job->bpt, job->avl_root) < 0)
+            job->built &= ~INDEX_BIT(5);
+#if !LAZY_INDEXES
+        bk_build(&job->bk, job->avl_root);
+        job->bk_built = 1;
+        suffix_build(&job->sfx, job->avl_root);
+        fulltext_build(&job->fts, job->avl_root);
+#endif
+    }
+#undef JOB_BUILT
+    g_idle_add(on_load_done, NULL);
+    return NULL;
+}
+
 /* ── Button callbacks ────────────────────────────────────────── */
 
 static void on_insert_clicked(GtkButton *btn, gpointer data) {
@@ -318,28 +1055,30 @@ static void on_insert_clicked(GtkButton *btn, gpointer data) {
         const gchar *m = gtk_entry_get_text(GTK_ENTRY(entry_meaning));
 
         if (!str_is_empty(w)) {
-            WordRecord rec;
-            int prev = g_word_count;
+            WordRecord  rec;
+            WordRecord *stored;
 
             word_record_init(&rec);
             str_safe_copy(rec.word,           w, sizeof(rec.word));
-            str_safe_copy(rec.part_of_speech, p, sizeof(rec.part_of_speech));
-            str_safe_copy(rec.meaning,        m, sizeof(rec.meaning));
+            rec.part_of_speech = p;   /* copied by store_add */
+            rec.meaning        = m;
             rec.frequency_score = FREQ_SCORE_DEFAULT;
 
-            bst_insert(&g_bst_root, &rec);
-            g_avl_root = avl_insert(g_avl_root, &rec);
-            tbt_insert(g_tbt_header, &rec);
-            g_word_count = bst_count(g_bst_root);
+            g_mutex_lock(&g_dict_lock);
+            stored = dict_insert(&rec);
+            g_word_count = avl_count(g_avl_root);
 
-            if (g_word_count > prev) {
+            if (stored) {
                 gchar msg[128];
+                journal_log_insert(&g_journal, stored);
                 g_snprintf(msg, sizeof(msg), "Inserted \"%s\".", w);
                 show_status(msg);
                 update_stats();
+                save_if_due();
             } else {
                 show_status("Word already exists — skipped.");
             }
+            g_mutex_unlock(&g_dict_lock);
         } else {
             show_status("Insert cancelled: word field was empty.");
         }
@@ -351,6 +1090,7 @@ static void on_insert_clicked(GtkButton *btn, gpointer data) {
 static void on_delete_clicked(GtkButton *btn, gpointer data) {
     GtkListBoxRow *row;
     const gchar   *word = NULL;
+    char           target[MAX_WORD_LEN];
     GtkWidget     *confirm;
     gint           resp;
 
@@ -366,36 +1106,40 @@ static void on_delete_clicked(GtkButton *btn, gpointer data) {
         show_status("Select a word from the list to delete.");
         return;
     }
+    /* A search reply arriving while the dialog runs may reuse the row */
+    str_safe_copy(target, word, sizeof(target));
+    word = target;
 
     confirm = gtk_message_dialog_new(
                   GTK_WINDOW(g_window), GTK_DIALOG_MODAL,
                   GTK_MESSAGE_QUESTION, GTK_BUTTONS_YES_NO,
-                  "Delete \"%s\" from all three trees?", word);
+                  "Delete \"%s\" from the dictionary?", word);
     resp = gtk_dialog_run(GTK_DIALOG(confirm));
     gtk_widget_destroy(confirm);
 
     if (resp == GTK_RESPONSE_YES) {
-        int prev = g_word_count;
-        bst_delete  (&g_bst_root, word);
-        g_avl_root = avl_delete(g_avl_root, word);
-        tbt_delete  (g_tbt_header, word);
-        g_word_count = bst_count(g_bst_root);
-
-        if (g_word_count < prev) {
+        g_mutex_lock(&g_dict_lock);
+        if (dict_delete(word)) {
             gchar msg[128];
+            g_word_count = avl_count(g_avl_root);
+            journal_log_delete(&g_journal, word);
             g_snprintf(msg, sizeof(msg), "Deleted \"%s\".", word);
             show_status(msg);
+            save_if_due();
             g_selected_word[0] = '\0';
             clear_word_detail();
             update_stats();
+            g_mutex_unlock(&g_dict_lock);
             on_search_changed(GTK_SEARCH_ENTRY(g_search_entry), NULL);
         } else {
+            g_mutex_unlock(&g_dict_lock);
             show_status("Word not found.");
         }
     }
 }
 
 static void on_load_clicked(GtkButton *btn, gpointer data) {
+    gchar          msg[128];
     GtkWidget     *fc;
     GtkFileFilter *filter;
     gint           resp;
@@ -414,30 +1158,28 @@ static void on_load_clicked(GtkButton *btn, gpointer data) {
     gtk_file_filter_add_pattern(filter, "*.txt");
     gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(fc), filter);
 
+    /* Packed dictionaries (load_packed) */
+    filter = gtk_file_filter_new();
+    gtk_file_filter_set_name(filter, "Packed dictionaries (*.sdz)");
+    gtk_file_filter_add_pattern(filter, "*.sdz");
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(fc), filter);
+
+    /* Raw kaikki.org dumps are ingested directly (load_jsonl) */
+    filter = gtk_file_filter_new();
+    gtk_file_filter_set_name(filter, "kaikki.org JSONL dumps (*.jsonl)");
+    gtk_file_filter_add_pattern(filter, "*.jsonl");
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(fc), filter);
+
     resp = gtk_dialog_run(GTK_DIALOG(fc));
     if (resp == GTK_RESPONSE_ACCEPT) {
         gchar *path = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(fc));
-        int n;
-
-        bst_free  (&g_bst_root);
-        avl_free  (&g_avl_root);
-        tbt_free  (&g_tbt_header);
-        g_tbt_header = tbt_create_header();
-
-        n = load_words(path, &g_bst_root, &g_avl_root, g_tbt_header);
-        if (n > 0) {
-            load_frequencies(FILE_WORD_FREQ,
-                             g_bst_root, g_avl_root, g_tbt_header);
-            g_word_count = bst_count(g_bst_root);
-            gchar msg[128];
-            g_snprintf(msg, sizeof(msg), "Loaded %d words.", n);
-            show_status(msg);
-            clear_word_detail();
-            populate_results(NULL, 0);
-            update_stats();
-        } else {
-            show_status("Failed to load file (empty or not found).");
-        }
+
+        /* Read on a worker; on_load_done puts the words in place */
+        g_load_job = load_job_new(path);
+        set_loading(TRUE);
+        g_snprintf(msg, sizeof(msg), "Loading %s…", g_load_job->name);
+        show_status(msg);
+        g_load_thread = g_thread_new("load", load_worker, g_load_job);
         g_free(path);
     }
     gtk_widget_destroy(fc);
@@ -445,67 +1187,47 @@ static void on_load_clicked(GtkButton *btn, gpointer data) {
 
 static void on_save_clicked(GtkButton *btn, gpointer data) {
     gchar msg[128];
+    int   rc;
     (void)btn; (void)data;
 
-    if (!g_bst_root) { show_status("Nothing to save."); return; }
+    if (!g_avl_root) { show_status("Nothing to save."); return; }
+    if (journal_compact_running(&g_journal)) {
+        show_status("A save is already in progress.");
+        return;
+    }
 
-    if (save_custom_words(FILE_CUSTOM_WORDS, g_bst_root) == 0) {
-        g_snprintf(msg, sizeof(msg),
-                   "Saved %d words to %s.", g_word_count, FILE_CUSTOM_WORDS);
+    g_mutex_lock(&g_dict_lock);
+    rc = start_save();
+    g_mutex_unlock(&g_dict_lock);
+    if (rc == 0) {
+        if (journal_compact_running(&g_journal))
+            g_snprintf(msg, sizeof(msg), "Saving %d words in the background…",
+                       g_word_count);
+        else
+            g_snprintf(msg, sizeof(msg),
+                       "Saved %d words to %s.", g_word_count, FILE_CUSTOM_WORDS);
         show_status(msg);
     } else {
         show_status("Error: could not write session file.");
     }
 }
 
-/* Run benchmark_run_all(), capture its printf output via stdout redirect,
-   then display the captured text in a scrollable dialog. */
+/* Run the quick comparison (benchmark_collect), then display its tables
+   in a scrollable dialog. */
 static void on_benchmark_clicked(GtkButton *btn, gpointer data) {
-    char   tmppath[512];
-    int    saved_fd = -1;
-    FILE  *rf;
-    long   sz;
-    gchar *output = NULL;
+    BenchResults res;
+    char        *text = NULL;
+    gchar       *output;
     GtkWidget *dialog, *content, *scroll, *tv;
     GtkTextBuffer *tbuf;
 
     (void)btn; (void)data;
 
-    /* ── Capture stdout to a temp file ── */
-    g_snprintf(tmppath, sizeof(tmppath),
-               "%s\\sdict_bench.txt", g_get_tmp_dir());
-
-    if (_fileno(stdout) >= 0)
-        saved_fd = _dup(_fileno(stdout));
-
-    freopen(tmppath, "w", stdout);
-    benchmark_run_all();
-    fflush(stdout);
-
-    if (saved_fd >= 0) {
-        _dup2(saved_fd, _fileno(stdout));
-        _close(saved_fd);
-    } else {
-        freopen("NUL", "w", stdout);
-    }
-
-    /* ── Read captured output ── */
-    rf = fopen(tmppath, "r");
-    if (rf) {
-        fseek(rf, 0, SEEK_END);
-        sz = ftell(rf);
-        rewind(rf);
-        output = (gchar *)g_malloc((gsize)(sz + 1));
-        if (output) {
-            fread(output, 1, (size_t)sz, rf);
-            output[sz] = '\0';
-        }
-        fclose(rf);
-    }
-    remove(tmppath);
-
-    if (!output)
-        output = g_strdup("(Could not read benchmark output.)");
+    benchmark_results_init(&res);
+    if (benchmark_collect(&res) == 0) text = benchmark_results_text(&res);
+    benchmark_results_free(&res);
+    output = g_strdup(text ? text : "(Benchmark failed: out of memory.)");
+    free(text);
 
     /* ── Show in a resizable dialog with a monospace text view ── */
     dialog = gtk_dialog_new_with_buttons(
@@ -539,14 +1261,35 @@ static void on_benchmark_clicked(GtkButton *btn, gpointer data) {
     g_free(output);
 }
 
-/* Auto-save on window close. */
+/* On window close: the journal already holds every change, so a full
+   save is only needed if it does not cover the session or is too big. */
 static void on_window_destroy(GtkWidget *widget, gpointer data) {
     (void)widget; (void)data;
-    if (g_bst_root)
-        save_custom_words(FILE_CUSTOM_WORDS, g_bst_root);
-    bst_free  (&g_bst_root);
-    avl_free  (&g_avl_root);
-    tbt_free  (&g_tbt_header);
+    stop_query_worker();
+    if (g_load_thread) {
+        /* The loader cannot be stopped midway: wait, then drop its words */
+        g_thread_join(g_load_thread);
+        g_load_thread = NULL;
+        load_job_free(g_load_job);
+        g_load_job = NULL;
+    }
+    finish_save(1);
+    if (g_save_all || journal_needs_compact(&g_journal))
+        save_dictionary();
+    journal_close(&g_journal);
+    /* Whole-pool release: O(slabs) per tree type instead of O(n) frees */
+    bst_pool_destroy();
+    avl_pool_destroy();
+    tbt_pool_destroy();
+    trie_free(&g_trie);
+    bpt_free(&g_bpt);
+    bk_free(&g_bk);
+    suffix_free(&g_sfx);
+    fulltext_free(&g_fts);
+    g_bst_root   = NULL;
+    g_avl_root   = NULL;
+    g_tbt_header = NULL;
+    store_free(&g_store);
 }
 
 /* ── CSS ─────────────────────────────────────────────────────── */
@@ -617,15 +1360,15 @@ static GtkWidget *build_toolbar(void) {
     gtk_container_set_border_width(GTK_CONTAINER(bar), 6);
     gtk_style_context_add_class(gtk_widget_get_style_context(bar), "toolbar");
 
-    btn = gtk_button_new_with_label("Insert");
+    btn = g_btn_insert = gtk_button_new_with_label("Insert");
     g_signal_connect(btn, "clicked", G_CALLBACK(on_insert_clicked), NULL);
     gtk_box_pack_start(GTK_BOX(bar), btn, FALSE, FALSE, 0);
 
-    btn = gtk_button_new_with_label("Delete");
+    btn = g_btn_delete = gtk_button_new_with_label("Delete");
     g_signal_connect(btn, "clicked", G_CALLBACK(on_delete_clicked), NULL);
     gtk_box_pack_start(GTK_BOX(bar), btn, FALSE, FALSE, 0);
 
-    btn = gtk_button_new_with_label("Load File");
+    btn = g_btn_load = gtk_button_new_with_label("Load File");
     g_signal_connect(btn, "clicked", G_CALLBACK(on_load_clicked), NULL);
     gtk_box_pack_start(GTK_BOX(bar), btn, FALSE, FALSE, 0);
 
@@ -633,7 +1376,7 @@ static GtkWidget *build_toolbar(void) {
     g_signal_connect(btn, "clicked", G_CALLBACK(on_save_clicked), NULL);
     gtk_box_pack_start(GTK_BOX(bar), btn, FALSE, FALSE, 0);
 
-    btn = gtk_button_new_with_label("Benchmark");
+    btn = g_btn_benchmark = gtk_button_new_with_label("Benchmark");
     g_signal_connect(btn, "clicked", G_CALLBACK(on_benchmark_clicked), NULL);
     gtk_box_pack_start(GTK_BOX(bar), btn, FALSE, FALSE, 0);
 
@@ -652,6 +1395,10 @@ static GtkWidget *build_toolbar(void) {
                               "avl", "AVL  (Self-Balancing)");
     gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(g_combo_tree),
                               "tbt", "TBT  (Threaded)");
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(g_combo_tree),
+                              "trie", "Trie (Radix)");
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(g_combo_tree),
+                              "bpt", "B+   (Linked leaves)");
     gtk_combo_box_set_active(GTK_COMBO_BOX(g_combo_tree), 1); /* default AVL */
     g_signal_connect(g_combo_tree, "changed",
                      G_CALLBACK(on_tree_changed), NULL);
@@ -670,7 +1417,7 @@ static GtkWidget *build_left_panel(void) {
     /* Search entry */
     g_search_entry = gtk_search_entry_new();
     gtk_entry_set_placeholder_text(GTK_ENTRY(g_search_entry),
-                                   "Type a prefix…");
+                                   "Prefix, *text (inside words) or ?terms (definitions)…");
     gtk_widget_set_margin_start  (g_search_entry, 8);
     gtk_widget_set_margin_end    (g_search_entry, 8);
     gtk_widget_set_margin_top    (g_search_entry, 8);
@@ -803,7 +1550,7 @@ static GtkWidget *build_right_panel(void) {
 static void activate(GtkApplication *app, gpointer data) {
     GtkWidget *main_box, *paned, *left, *right;
     gchar      msg[128];
-    int        n;
+    int        n, r, ranked = 0;
 
     (void)data;
 
@@ -851,20 +1598,50 @@ static void activate(GtkApplication *app, gpointer data) {
     gtk_container_add(GTK_CONTAINER(g_window), main_box);
     gtk_widget_show_all(g_window);
 
-    /* Auto-load: try custom session file first, then canonical words.txt */
-    n = load_words(FILE_CUSTOM_WORDS, &g_bst_root, &g_avl_root, g_tbt_header);
+    /* Auto-load: binary snapshot, then the custom session file, then the
+       corpus-ranked snapshot if shipped (its scores are final), then the
+       packed dictionary, then canonical words.txt */
+    n = snapshot_load(FILE_SNAPSHOT, &g_store,
+                      bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
     if (n <= 0)
-        n = load_words(FILE_WORDS, &g_bst_root, &g_avl_root, g_tbt_header);
+        n = load_words(FILE_CUSTOM_WORDS, &g_store,
+                       bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+    if (n <= 0) {
+        n = snapshot_load(FILE_WORDS_SNAP, &g_store,
+                          bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+        ranked = n > 0;
+        if (n <= 0)
+            n = load_words(FILE_WORDS_PACKED, &g_store,
+                           bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+        if (n <= 0)
+            n = load_words(FILE_WORDS, &g_store,
+                           bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+        g_save_all = n > 0;   /* no save files yet */
+    }
 
     if (n > 0) {
-        load_frequencies(FILE_WORD_FREQ, g_bst_root, g_avl_root, g_tbt_header);
-        g_word_count = bst_count(g_bst_root);
+        if (!ranked)
+            load_frequencies(FILE_WORD_FREQ, &g_store, g_avl_root, trie_slot());
+        finish_load();
     }
 
+    /* Then the changes made since those files were written */
+    {
+        static const JournalOps ops = { replay_insert, replay_remove, replay_picks };
+        r = journal_open(&g_journal, FILE_JOURNAL, &ops, NULL);
+    }
+    g_word_count = avl_count(g_avl_root);
+
     update_stats();
-    g_snprintf(msg, sizeof(msg),
-               "Ready — %d words loaded. Type a prefix to search.",
-               g_word_count);
+    g_query_thread = g_thread_new("query", query_worker, NULL);
+    if (r > 0)
+        g_snprintf(msg, sizeof(msg),
+                   "Ready — %d words loaded (%d change%s replayed). Type a prefix to search.",
+                   g_word_count, r, r == 1 ? "" : "s");
+    else
+        g_snprintf(msg, sizeof(msg),
+                   "Ready — %d words loaded. Type a prefix to search.",
+                   g_word_count);
     show_status(msg);
 }
 
@@ -872,13 +1649,31 @@ int main(int argc, char **argv) {
     GtkApplication *app;
     int             status;
 
-    /* Initialise TBT header before anything touches the trees */
+    /* Initialise the record store and TBT header before anything touches the trees */
+    store_init(&g_store);
     g_tbt_header = tbt_create_header();
+    trie_init(&g_trie);
+    bpt_init(&g_bpt);
+    bk_init(&g_bk);
+    autocomplete_session_reset(&g_session);
+    prefix_cache_init(&g_cache);
+    g_built = initial_indexes();
+
+    /* --record LOG: append the queries served to a query log (querylog.h);
+       taken out of argv before GTK parses it */
+    if (argc >= 3 && strcmp(argv[1], "--record") == 0) {
+        if (querylog_record_open(&g_recorder, argv[2]) != 0)
+            g_printerr("%s: cannot write %s\n", argv[0], argv[2]);
+        argv[2] = argv[0];
+        argv   += 2;
+        argc   -= 2;
+    }
 
     app = gtk_application_new("com.smartdict.gui",
                               G_APPLICATION_DEFAULT_FLAGS);
     g_signal_connect(app, "activate", G_CALLBACK(activate), NULL);
     status = g_application_run(G_APPLICATION(app), argc, argv);
     g_object_unref(app);
+    querylog_record_close(&g_recorder);
     return status;
 }
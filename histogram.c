@@ -0,0 +1,94 @@
+/* histogram.c - Log-linear latency histogram */
+#include <string.h>
+#include "histogram.h"
+
+/* ── Helpers ─────────────────────────────────────────────────── */
+
+/* Index of the highest set bit of a non-zero v. */
+static int high_bit(uint64_t v) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(v);
+#else
+    int e = 0;
+    while (v >>= 1) e++;
+    return e;
+#endif
+}
+
+static int bucket_of(uint64_t v) {
+    int e;
+    if (v < HIST_SUB) return (int)v;
+    e = high_bit(v);
+    return (e - HIST_SUB_BITS + 1) * HIST_SUB +
+           (int)((v >> (e - HIST_SUB_BITS)) - HIST_SUB);
+}
+
+/* The largest value counted in bucket i. */
+static uint64_t bucket_high(int i) {
+    int shift;
+    if (i < HIST_SUB) return (uint64_t)i;
+    shift = i / HIST_SUB - 1;
+    return (((uint64_t)(HIST_SUB + i % HIST_SUB)) << shift) +
+           (((uint64_t)1 << shift) - 1);
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void hist_init(LatencyHist *h) {
+    memset(h->count, 0, sizeof(h->count));
+    h->n   = 0;
+    h->sum = 0;
+    h->min = UINT64_MAX;
+    h->max = 0;
+}
+
+void hist_record(LatencyHist *h, uint64_t v) {
+    h->count[bucket_of(v)]++;
+    h->n++;
+    h->sum += v;
+    if (v < h->min) h->min = v;
+    if (v > h->max) h->max = v;
+}
+
+void hist_merge(LatencyHist *dst, const LatencyHist *src) {
+    int i;
+    for (i = 0; i < HIST_BUCKETS; i++) dst->count[i] += src->count[i];
+    dst->n   += src->n;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t hist_percentile(const LatencyHist *h, double pct) {
+    uint64_t rank, seen = 0, high;
+    int      i;
+
+    if (h->n == 0) return 0;
+    if (pct >= 100.0) return h->max;
+    rank = (uint64_t)(pct / 100.0 * (double)h->n + 0.999999);
+    if (rank < 1) rank = 1;
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->count[i];
+        if (seen >= rank) {
+            high = bucket_high(i);
+            return high < h->max ? high : h->max;
+        }
+    }
+    return h->max;
+}
+
+double hist_mean(const LatencyHist *h) {
+    return h->n ? (double)h->sum / (double)h->n : 0.0;
+}
+
+void hist_summary(const LatencyHist *h, LatencySummary *out) {
+    out->n    = h->n;
+    out->mean = hist_mean(h);
+    out->min  = h->n ? h->min : 0;
+    out->p50  = hist_percentile(h, 50.0);
+    out->p90  = hist_percentile(h, 90.0);
+    out->p95  = hist_percentile(h, 95.0);
+    out->p99  = hist_percentile(h, 99.0);
+    out->p999 = hist_percentile(h, 99.9);
+    out->max  = h->max;
+}
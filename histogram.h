@@ -0,0 +1,61 @@
+/* histogram.h - Log-linear latency histogram (HDR-style buckets) */
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/*
+ * LatencyHist - a fixed-size histogram of non-negative values (latencies
+ * in nanoseconds), accurate to a constant relative error at any scale.
+ *
+ * Values below HIST_SUB are counted exactly.  Above that, each power of
+ * two [2^e, 2^(e+1)) is split into HIST_SUB equal sub-buckets, so a
+ * bucket is never wider than 1/HIST_SUB of the values in it (about 3%):
+ * the layout of an HdrHistogram with two significant digits.  Recording
+ * is a bit scan and an increment — cheap enough to time every operation
+ * of a benchmark loop — and the whole range of uint64_t fits in
+ * HIST_BUCKETS counters, with no configuration and no allocation.
+ *
+ * Percentiles report the highest value of the bucket holding the rank
+ * (never below the true value), clamped to the largest value recorded.
+ */
+#define HIST_SUB_BITS  5
+#define HIST_SUB       (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS   ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct LatencyHist {
+    uint64_t count[HIST_BUCKETS];
+    uint64_t n;       /* values recorded */
+    uint64_t sum;     /* their total     */
+    uint64_t min;     /* UINT64_MAX while empty */
+    uint64_t max;
+} LatencyHist;
+
+/* Summary of a histogram, values in the recorded unit. */
+typedef struct LatencySummary {
+    uint64_t n;
+    double   mean;
+    uint64_t min, p50, p90, p95, p99, p999, max;
+} LatencySummary;
+
+/* Initialise an empty histogram. */
+void hist_init(LatencyHist *h);
+
+/* Count one value. */
+void hist_record(LatencyHist *h, uint64_t v);
+
+/* Add every value counted in src to dst. */
+void hist_merge(LatencyHist *dst, const LatencyHist *src);
+
+/* The value at percentile pct (0..100) of what was recorded: the
+   smallest bucket bound at least pct% of the values fall at or below.
+   0 if empty. */
+uint64_t hist_percentile(const LatencyHist *h, double pct);
+
+/* Mean of the recorded values (exact: kept as a running sum), 0 if empty. */
+double hist_mean(const LatencyHist *h);
+
+/* Count, mean, min, p50, p90, p95, p99, p99.9 and max. */
+void hist_summary(const LatencyHist *h, LatencySummary *out);
+
+#endif /* HISTOGRAM_H */
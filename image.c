@@ -0,0 +1,502 @@
+/* image.c - Frozen dictionary image, queried in place from a shared mapping */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L   /* mmap, open and fstat under -std=c99 */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "image.h"
+#include "store.h"
+#include "config.h"
+#include "utils.h"
+
+#define IMAGE_MAGIC    "SDIMAGE\n"
+#define IMAGE_VERSION  1u
+#define IMAGE_ENDIAN   0x01020304u   /* reads back differently on the wrong byte order */
+#define IMAGE_ALIGN    8u            /* every section starts on this boundary */
+#define RANK_NONE      UINT32_MAX    /* rank tree slot past the last word */
+
+typedef struct ImageHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t count;       /* records                               */
+    uint32_t rec_size;    /* sizeof(ImageRecord) of the writer     */
+    uint32_t word_len;    /* MAX_WORD_LEN of the writer            */
+    uint32_t leaves;      /* rank tree width                       */
+    uint64_t recs_off;    /* section offsets, from the file start  */
+    uint64_t score_off;
+    uint64_t rank_off;
+    uint64_t first_off;
+    uint64_t text_off;
+    uint64_t text_size;
+    uint64_t file_size;
+} ImageHeader;
+
+struct ImageRecord {
+    char     word[MAX_WORD_LEN];   /* lowercase, zero-filled past the NUL */
+    uint32_t meaning;              /* text offsets                        */
+    uint32_t pos;
+    int32_t  freq;
+    int32_t  picks;
+    int32_t  select_time;
+};
+typedef struct ImageRecord ImageRecord;
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+static uint64_t align_up(uint64_t n) {
+    return (n + IMAGE_ALIGN - 1) & ~(uint64_t)(IMAGE_ALIGN - 1);
+}
+
+/* The better-ranked of ordinals a and b (RANK_NONE loses to any):
+   higher score first, then the earlier word, as word_record_outranks. */
+static uint32_t rank_better(const int32_t *score, uint32_t a, uint32_t b) {
+    if (a == RANK_NONE) return b;
+    if (b == RANK_NONE) return a;
+    if (score[a] != score[b]) return score[a] > score[b] ? a : b;
+    return a < b ? a : b;
+}
+
+/* Rank tree slot i; an ordinal past the last word (a stale or damaged
+   image) reads as RANK_NONE rather than indexing past score[]. */
+static uint32_t rank_at(const DictImage *img, uint32_t i) {
+    uint32_t r = img->rank[i];
+    return r < (uint32_t)img->count ? r : RANK_NONE;
+}
+
+/* Best-ranked ordinal in [lo, hi), or RANK_NONE if the range is empty.
+   Bottom-up over the tree: O(log n). */
+static uint32_t range_best(const DictImage *img, uint32_t lo, uint32_t hi) {
+    uint32_t best = RANK_NONE;
+    for (lo += img->leaves, hi += img->leaves; lo < hi; lo >>= 1, hi >>= 1) {
+        if (lo & 1) best = rank_better(img->score, best, rank_at(img, lo++));
+        if (hi & 1) best = rank_better(img->score, best, rank_at(img, --hi));
+    }
+    return best;
+}
+
+/* First ordinal in [lo, hi) whose word compares >= key (or, with
+   plen > 0, > key on its first plen bytes), else hi. */
+static uint32_t search(const DictImage *img, uint32_t lo, uint32_t hi,
+                       const char *key, size_t plen) {
+    uint32_t mid;
+    int      cmp;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        cmp = plen ? str_key_ncmp(img->recs[mid].word, key, plen)
+                   : str_key_cmp(img->recs[mid].word, key);
+        if (cmp < 0 || (plen && cmp == 0)) lo = mid + 1;
+        else                               hi = mid;
+    }
+    return lo;
+}
+
+/* A range of ordinals waiting in image_autocomplete's heap, keyed by the
+   rank of its best */
+typedef struct RankRange {
+    uint32_t lo, hi, best;
+} RankRange;
+
+static void heap_push(const int32_t *score, RankRange *heap, int *n, RankRange r) {
+    int i = (*n)++, p;
+    while (i > 0) {
+        p = (i - 1) / 2;
+        if (rank_better(score, heap[p].best, r.best) != r.best) break;
+        heap[i] = heap[p];
+        i = p;
+    }
+    heap[i] = r;
+}
+
+static RankRange heap_pop(const int32_t *score, RankRange *heap, int *n) {
+    RankRange top = heap[0], last = heap[--*n];
+    int       i = 0, c;
+    for (;;) {
+        c = 2 * i + 1;
+        if (c >= *n) break;
+        if (c + 1 < *n && rank_better(score, heap[c].best, heap[c + 1].best) == heap[c + 1].best)
+            c++;
+        if (rank_better(score, last.best, heap[c].best) == last.best) break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    if (*n > 0) heap[i] = last;
+    return top;
+}
+
+/* ── Publishing ──────────────────────────────────────────────── */
+
+typedef struct ImageWriter {
+    const WordRecord **recs;       /* in order                    */
+    int                n;
+    char              *text;
+    size_t             text_len, text_cap;
+    const char        *pos_seen[STORE_POS_INTERN_MAX];
+    uint32_t           pos_off[STORE_POS_INTERN_MAX];
+    int                num_pos;
+    int                failed;
+} ImageWriter;
+
+static void collect_cb(AVLNode *node, void *arg) {
+    ImageWriter *w = (ImageWriter *)arg;
+    w->recs[w->n++] = node->rec;
+}
+
+/* Append s with its NUL to the text and return its offset. */
+static uint32_t text_add(ImageWriter *w, const char *s) {
+    size_t   len = strlen(s) + 1;
+    uint32_t off = (uint32_t)w->text_len;
+
+    if (w->text_len + len > UINT32_MAX) {
+        w->failed = 1;
+        return 0;
+    }
+    if (w->text_len + len > w->text_cap) {
+        size_t cap = w->text_cap ? w->text_cap : 65536;
+        char  *p;
+        while (cap < w->text_len + len) cap *= 2;
+        p = (char *)realloc(w->text, cap);
+        if (!p) {
+            w->failed = 1;
+            return 0;
+        }
+        w->text     = p;
+        w->text_cap = cap;
+    }
+    memcpy(w->text + w->text_len, s, len);
+    w->text_len += len;
+    return off;
+}
+
+/* Interned POS tags share a pointer in the store, so each distinct one
+   is laid out once. */
+static uint32_t pos_add(ImageWriter *w, const char *pos) {
+    int i;
+    for (i = 0; i < w->num_pos; i++)
+        if (w->pos_seen[i] == pos) return w->pos_off[i];
+    if (w->num_pos == STORE_POS_INTERN_MAX) return text_add(w, pos);
+    w->pos_seen[w->num_pos] = pos;
+    w->pos_off[w->num_pos]  = text_add(w, pos);
+    return w->pos_off[w->num_pos++];
+}
+
+static int write_section(FILE *fp, const void *p, size_t size, uint64_t at) {
+    static const char zeros[IMAGE_ALIGN] = { 0 };
+    long              here = ftell(fp);
+    if (here < 0 || (uint64_t)here > at) return -1;
+    if (at > (uint64_t)here && fwrite(zeros, 1, (size_t)(at - (uint64_t)here), fp) !=
+                                   (size_t)(at - (uint64_t)here))
+        return -1;
+    return size == 0 || fwrite(p, 1, size, fp) == size ? 0 : -1;
+}
+
+/* ── Mapping ─────────────────────────────────────────────────── */
+
+#ifdef _WIN32
+
+/* A real file mapping here (snapshot.c reads instead): sharing the pages
+   between processes is the point.  The view keeps the mapping alive. */
+static void *image_map(const char *path, size_t *size) {
+    HANDLE        f, m;
+    LARGE_INTEGER len = { 0 };
+    void         *base = NULL;
+
+    f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                    FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return NULL;
+    if (GetFileSizeEx(f, &len) && len.QuadPart > 0) {
+        m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m) {
+            base = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(m);
+        }
+    }
+    CloseHandle(f);
+    *size = (size_t)len.QuadPart;
+    return base;
+}
+
+static void image_unmap(const void *base, size_t size) {
+    (void)size;
+    UnmapViewOfFile(base);
+}
+
+#else
+
+static void *image_map(const char *path, size_t *size) {
+    struct stat st;
+    void       *base;
+    int         fd = open(path, O_RDONLY);
+
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    /* MAP_SHARED: every process maps the same page-cache pages */
+    base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+    *size = (size_t)st.st_size;
+    return base;
+}
+
+static void image_unmap(const void *base, size_t size) {
+    munmap((void *)base, size);
+}
+
+#endif
+
+/* Does [off, off + len) lie inside a file of size bytes, aligned? */
+static int section_ok(uint64_t off, uint64_t len, uint64_t size) {
+    return off % IMAGE_ALIGN == 0 && off <= size && len <= size - off;
+}
+
+/*
+ * The header, the section bounds and the 257 first-letter ranges only:
+ * the records are not walked, so attaching stays O(1) however large the
+ * image.  Text offsets are checked as records are read instead
+ * (image_get), and rank entries as the rank tree is read (range_best).
+ */
+static int image_check(const unsigned char *base, size_t size, ImageHeader *h) {
+    uint32_t first[257];
+    uint64_t n;
+    int      c;
+
+    if (size < sizeof(*h)) return -1;
+    memcpy(h, base, sizeof(*h));
+    n = h->count;
+    if (memcmp(h->magic, IMAGE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version  != IMAGE_VERSION || h->endian != IMAGE_ENDIAN ||
+        h->rec_size != sizeof(ImageRecord) || h->word_len != MAX_WORD_LEN ||
+        h->file_size != size || n > INT32_MAX ||
+        h->leaves < n || h->leaves == 0 || (h->leaves & (h->leaves - 1)) != 0)
+        return -1;
+    if (!section_ok(h->recs_off, n * sizeof(ImageRecord), size) ||
+        !section_ok(h->score_off, n * sizeof(int32_t), size) ||
+        !section_ok(h->rank_off, 2 * (uint64_t)h->leaves * sizeof(uint32_t), size) ||
+        !section_ok(h->first_off, 257 * sizeof(uint32_t), size) ||
+        !section_ok(h->text_off, h->text_size, size) || h->text_size == 0 ||
+        base[h->text_off + h->text_size - 1] != '\0')
+        return -1;
+    memcpy(first, base + h->first_off, sizeof(first));
+    for (c = 0; c < 256; c++)
+        if (first[c] > first[c + 1]) return -1;
+    return first[256] == n ? 0 : -1;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int image_publish(const char *path, AVLNode *avl_root) {
+    ImageWriter  w;
+    ImageHeader  h;
+    ImageRecord *recs  = NULL;
+    int32_t     *score = NULL;
+    uint32_t    *rank  = NULL;
+    uint32_t     first[257];
+    uint32_t     i, n, leaves = 1;
+    char         tmp[512];
+    FILE        *fp;
+    int          c, failed;
+
+    if (!path || snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    memset(&w, 0, sizeof(w));
+    n = (uint32_t)avl_count(avl_root);
+    while (leaves < n) leaves *= 2;
+    w.recs = (const WordRecord **)malloc(((size_t)n + 1) * sizeof(WordRecord *));
+    recs   = (ImageRecord *)calloc((size_t)n + 1, sizeof(ImageRecord));
+    score  = (int32_t *)malloc(((size_t)n + 1) * sizeof(int32_t));
+    rank   = (uint32_t *)malloc(2 * (size_t)leaves * sizeof(uint32_t));
+    failed = !w.recs || !recs || !score || !rank;
+    if (!failed) avl_inorder(avl_root, collect_cb, &w);
+
+    text_add(&w, "");                    /* offset 0: the empty string */
+    for (i = 0; i < n && !failed; i++) {
+        const WordRecord *r = w.recs[i];
+        memcpy(recs[i].word, r->word, MAX_WORD_LEN);
+        recs[i].meaning     = text_add(&w, word_record_meaning(r));
+        recs[i].pos         = pos_add(&w, r->part_of_speech);
+        recs[i].freq        = r->frequency_score;
+        recs[i].picks       = r->user_select_count;
+        recs[i].select_time = r->select_time;
+        score[i]            = word_record_score(r);
+    }
+    failed |= w.failed;
+
+    if (!failed) {
+        for (i = 0; i < leaves; i++) rank[leaves + i] = i < n ? i : RANK_NONE;
+        for (i = leaves - 1; i >= 1; i--)
+            rank[i] = rank_better(score, rank[2 * i], rank[2 * i + 1]);
+        rank[0] = RANK_NONE;
+        for (c = 0, i = 0; c <= 256; c++) {
+            while (i < n && (unsigned char)recs[i].word[0] < c) i++;
+            first[c] = i;
+        }
+    }
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, IMAGE_MAGIC, sizeof(h.magic));
+    h.version   = IMAGE_VERSION;
+    h.endian    = IMAGE_ENDIAN;
+    h.count     = n;
+    h.rec_size  = sizeof(ImageRecord);
+    h.word_len  = MAX_WORD_LEN;
+    h.leaves    = leaves;
+    h.recs_off  = align_up(sizeof(h));
+    h.score_off = align_up(h.recs_off + (uint64_t)n * sizeof(ImageRecord));
+    h.rank_off  = align_up(h.score_off + (uint64_t)n * sizeof(int32_t));
+    h.first_off = align_up(h.rank_off + 2 * (uint64_t)leaves * sizeof(uint32_t));
+    h.text_off  = align_up(h.first_off + sizeof(first));
+    h.text_size = w.text_len;
+    h.file_size = h.text_off + h.text_size;
+
+    fp = failed ? NULL : fopen(tmp, "wb");
+    if (fp) {
+        failed = fwrite(&h, sizeof(h), 1, fp) != 1 ||
+                 write_section(fp, recs, (size_t)n * sizeof(ImageRecord), h.recs_off) != 0 ||
+                 write_section(fp, score, (size_t)n * sizeof(int32_t), h.score_off) != 0 ||
+                 write_section(fp, rank, 2 * (size_t)leaves * sizeof(uint32_t), h.rank_off) != 0 ||
+                 write_section(fp, first, sizeof(first), h.first_off) != 0 ||
+                 write_section(fp, w.text, w.text_len, h.text_off) != 0;
+        failed |= fclose(fp) != 0;
+    } else {
+        failed = 1;
+    }
+    free(w.recs);
+    free(w.text);
+    free(recs);
+    free(score);
+    free(rank);
+    if (failed) {
+        remove(tmp);
+        return -1;
+    }
+#ifdef _WIN32
+    remove(path);   /* rename does not replace an existing file here */
+#endif
+    if (rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int image_attach(DictImage *img, const char *path) {
+    ImageHeader          h;
+    const unsigned char *base;
+    size_t               size = 0;
+
+    if (!img) return -1;
+    memset(img, 0, sizeof(*img));
+    if (!path || !(base = (const unsigned char *)image_map(path, &size))) return -1;
+    if (image_check(base, size, &h) != 0) {
+        image_unmap(base, size);
+        return -1;
+    }
+    img->base      = base;
+    img->size      = size;
+    img->count     = (int)h.count;
+    img->recs      = (const ImageRecord *)(const void *)(base + h.recs_off);
+    img->score     = (const int32_t *)(const void *)(base + h.score_off);
+    img->rank      = (const uint32_t *)(const void *)(base + h.rank_off);
+    img->leaves    = h.leaves;
+    img->first     = (const uint32_t *)(const void *)(base + h.first_off);
+    img->text      = (const char *)(base + h.text_off);
+    img->text_size = (size_t)h.text_size;
+    return 0;
+}
+
+void image_detach(DictImage *img) {
+    if (!img) return;
+    if (img->base) image_unmap(img->base, img->size);
+    memset(img, 0, sizeof(*img));
+}
+
+int image_count(const DictImage *img) {
+    return img ? img->count : 0;
+}
+
+int image_find(const DictImage *img, const char *word) {
+    DictKey  key;
+    uint32_t c, at;
+
+    if (!img || !img->base || !word) return -1;
+    dict_key_init(&key, word);
+    c  = (unsigned char)key.text[0];
+    at = search(img, img->first[c], img->first[c + 1], key.text, 0);
+    if (at < img->first[c + 1] && str_key_cmp(img->recs[at].word, key.text) == 0)
+        return (int)at;
+    return -1;
+}
+
+int image_get(const DictImage *img, int ordinal, WordRecord *out) {
+    const ImageRecord *r;
+
+    if (!img || !img->base || !out || ordinal < 0 || ordinal >= img->count) return -1;
+    r = &img->recs[ordinal];
+    memcpy(out->word, r->word, MAX_WORD_LEN);
+    out->word[MAX_WORD_LEN - 1] = '\0';
+    out->meaning           = r->meaning < img->text_size ? img->text + r->meaning : "";
+    out->part_of_speech    = r->pos < img->text_size ? img->text + r->pos : "";
+    out->frequency_score   = r->freq;
+    out->user_select_count = r->picks;
+    out->select_time       = r->select_time;
+    out->id                = -1;
+    return 0;
+}
+
+int image_lookup(const DictImage *img, const char *word, WordRecord *out) {
+    int at = image_find(img, word);
+    return at >= 0 && image_get(img, at, out) == 0;
+}
+
+int image_autocomplete(const DictImage *img, const char *prefix,
+                       WordRecord *results, int top_k) {
+    RankRange heap[2 * IMAGE_TOP_K_MAX + 1], r, part;
+    DictKey   key;
+    size_t    plen;
+    uint32_t  lo, hi;
+    int       n = 0, h = 0;
+
+    if (!img || !img->base || !prefix || !results || top_k <= 0) return 0;
+    if (top_k > IMAGE_TOP_K_MAX) top_k = IMAGE_TOP_K_MAX;
+    dict_key_init(&key, prefix);
+    plen = strlen(key.text);
+    if (plen == 0) return 0;            /* as autocomplete: no empty-prefix dump */
+    lo = img->first[(unsigned char)key.text[0]];
+    hi = img->first[(unsigned char)key.text[0] + 1];
+    lo = search(img, lo, hi, key.text, 0);
+    hi = search(img, lo, hi, key.text, plen);
+    if (lo >= hi) return 0;
+
+    r.lo = lo;
+    r.hi = hi;
+    r.best = range_best(img, lo, hi);
+    heap_push(img->score, heap, &h, r);
+    while (h > 0 && n < top_k) {
+        r = heap_pop(img->score, heap, &h);
+        image_get(img, (int)r.best, &results[n++]);
+        part.lo = r.lo;
+        part.hi = r.best;
+        if (part.lo < part.hi) {
+            part.best = range_best(img, part.lo, part.hi);
+            heap_push(img->score, heap, &h, part);
+        }
+        part.lo = r.best + 1;
+        part.hi = r.hi;
+        if (part.lo < part.hi) {
+            part.best = range_best(img, part.lo, part.hi);
+            heap_push(img->score, heap, &h, part);
+        }
+    }
+    return n;
+}
@@ -0,0 +1,107 @@
+/* image.h - Frozen dictionary image, queried in place from a shared mapping */
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dictionary.h"
+#include "avl.h"
+
+/*
+ * Dictionary image (.sdi) - a frozen dictionary laid out to be queried
+ * where it lies, in a read-only mapping of the file.  Every process that
+ * attaches maps the same file, so the OS keeps one copy of its pages in
+ * memory however many processes attach.  Attaching checks the header and
+ * nothing else: there is no parse, no per-record allocation and no
+ * index build, and pages are read in as queries touch them.
+ *
+ *   [header]   magic, version, byte-order tag, layout sizes, record
+ *              count, section offsets, file size
+ *   [records]  count fixed-size entries, sorted by word: word, meaning
+ *              and POS offsets into the text, freq, picks, select_time
+ *   [scores]   each record's word_record_score when it was published
+ *   [rank]     a tournament tree over the scores: slots leaves..2*leaves
+ *              hold the ordinals in order, and every slot below them the
+ *              best-ranked ordinal of its two children
+ *   [first]    for each first byte c, the ordinal of the first word at
+ *              or past c (257 entries), to start each search
+ *   [text]     the meanings and POS tags, NUL-terminated
+ *
+ * No section holds a pointer: records refer to the text by offset and
+ * the rank tree to records by ordinal, so the image is valid at whatever
+ * address each process maps it.  Like a snapshot (snapshot.h) it is
+ * native-endian with the in-memory sizes baked in, and an image from a
+ * different build is rejected.
+ *
+ * A lookup is one binary search among the words with the same first
+ * byte.  A prefix query binary-searches the range of words with the
+ * prefix and takes the k best from the rank tree.  The best of a range
+ * is one O(log n) query of the tree; taking it splits the rest of the
+ * range in two around it, and a heap of such ranges keyed by their best
+ * gives the next one.  That is O(log n + k (log n + log k)), with no scan
+ * of the range however short the prefix.  Results rank as autocomplete
+ * does (word_record_outranks) by the scores frozen at publish time.
+ *
+ * An image is read-only: picks, inserts and deletes belong to the
+ * publisher, whose next publish replaces the file.  An attached process
+ * keeps the image it mapped until it detaches and attaches again.  On
+ * Windows a mapped file cannot be replaced, so publish a new file next
+ * to it instead.
+ */
+#define IMAGE_TOP_K_MAX  TOP_K_MAX   /* largest top_k image_autocomplete serves */
+
+struct ImageRecord;
+
+typedef struct DictImage {
+    const unsigned char      *base;    /* the mapping                   */
+    size_t                    size;
+    int                       count;   /* words                          */
+    const struct ImageRecord *recs;
+    const int32_t            *score;
+    const uint32_t           *rank;
+    uint32_t                  leaves;  /* rank tree width (power of 2)   */
+    const uint32_t           *first;
+    const char               *text;
+    size_t                    text_size;
+} DictImage;
+
+/*
+ * Write every record of the tree rooted at avl_root to path as an image,
+ * under a temporary name renamed into place (so attachers never map half
+ * a file).  Scores are taken as they stand: apply pending decay first.
+ * Returns 0 on success, -1 on error.
+ */
+int image_publish(const char *path, AVLNode *avl_root);
+
+/*
+ * Map the image at path read-only into img.  Returns 0, or -1 if it is
+ * missing, malformed or from an incompatible build (img is left
+ * detached).
+ */
+int image_attach(DictImage *img, const char *path);
+
+/* Unmap the image.  Records copied out of it are dangling after this. */
+void image_detach(DictImage *img);
+
+/* Number of words in the image. */
+int image_count(const DictImage *img);
+
+/* Ordinal of word (any case), or -1 if absent. */
+int image_find(const DictImage *img, const char *word);
+
+/*
+ * Fill out with the record at ordinal.  Its meaning and POS point into
+ * the mapping (valid until image_detach); out->id is -1.  Returns 0, or
+ * -1 if ordinal is out of range.
+ */
+int image_get(const DictImage *img, int ordinal, WordRecord *out);
+
+/* image_find and image_get in one.  Returns 1 if found, else 0. */
+int image_lookup(const DictImage *img, const char *word, WordRecord *out);
+
+/* Up to top_k (at most IMAGE_TOP_K_MAX) best-ranked words starting with
+   prefix, best first, into results.  Returns the number found. */
+int image_autocomplete(const DictImage *img, const char *prefix,
+                       WordRecord *results, int top_k);
+
+#endif /* IMAGE_H */
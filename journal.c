@@ -0,0 +1,443 @@
+/* journal.c - Append-only write-ahead log implementation */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "journal.h"
+#include "loader.h"
+#include "snapshot.h"
+#include "config.h"
+
+#define JOURNAL_MAGIC   "SDJRNL\r\n"  /* 8 bytes; \r\n exposes text-mode damage */
+#define JOURNAL_ENDIAN  0x01020304u
+#define ENTRY_FIXED     17u           /* op, a, b, word_len, pos_len, meaning_len */
+#define ENTRY_MAX       (1u << 24)    /* longer payloads are corruption          */
+
+typedef struct JournalHeader {
+    char     magic[8];
+    uint32_t endian;
+    uint32_t word_len;    /* MAX_WORD_LEN of the writer */
+} JournalHeader;
+
+typedef struct JournalCompaction {
+    pthread_t       thread;
+    int             threaded;      /* else it ran in journal_compact_begin */
+    pthread_mutex_t lock;          /* guards status and finished           */
+    int             status;
+    int             finished;
+    WordRecord     *recs;          /* the tree in order, at begin          */
+    int             n;
+    const char     *text_path;
+    const char     *snap_path;
+    void          (*done)(void *arg);
+    void           *arg;
+    long            mark_bytes;    /* journal size at begin: what recs hold */
+    int             mark_entries;
+    int             was_failed;    /* j->failed at begin                    */
+} JournalCompaction;
+
+/* ── Encoding ────────────────────────────────────────────────── */
+
+/* FNV-1a over the payload. */
+static uint32_t entry_check(const unsigned char *p, size_t n) {
+    uint32_t h = 2166136261u;
+    while (n--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void header_init(JournalHeader *h) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, JOURNAL_MAGIC, sizeof(h->magic));
+    h->endian   = JOURNAL_ENDIAN;
+    h->word_len = MAX_WORD_LEN;
+}
+
+static int header_ok(const JournalHeader *h) {
+    JournalHeader want;
+    header_init(&want);
+    return memcmp(h, &want, sizeof(want)) == 0;
+}
+
+/*
+ * Append one entry as a single write and flush it.  Any failure marks
+ * the journal failed: the file no longer holds every change, so only a
+ * full save can make the session durable again.
+ */
+static int append_entry(Journal *j, char op, int32_t a, int32_t b, const char *word,
+                        const char *pos, const char *meaning) {
+    size_t         wlen = strlen(word);
+    size_t         plen = pos ? strlen(pos) : 0;
+    size_t         mlen = meaning ? strlen(meaning) : 0;
+    size_t         len  = ENTRY_FIXED + wlen + plen + mlen;
+    unsigned char *buf, *p;
+    uint32_t       len32, check;
+    uint16_t       wlen16, plen16;
+    uint32_t       mlen32;
+    int            ok;
+
+    if (!j->fp || wlen == 0 || wlen >= MAX_WORD_LEN || plen > UINT16_MAX ||
+        len > ENTRY_MAX) {
+        j->failed = 1;
+        return -1;
+    }
+    buf = (unsigned char *)malloc(2 * sizeof(uint32_t) + len);
+    if (!buf) {
+        j->failed = 1;
+        return -1;
+    }
+    len32  = (uint32_t)len;
+    wlen16 = (uint16_t)wlen;
+    plen16 = (uint16_t)plen;
+    mlen32 = (uint32_t)mlen;
+
+    p = buf + 2 * sizeof(uint32_t);
+    *p++ = (unsigned char)op;
+    memcpy(p, &a, sizeof(a));           p += sizeof(a);
+    memcpy(p, &b, sizeof(b));           p += sizeof(b);
+    memcpy(p, &wlen16, sizeof(wlen16)); p += sizeof(wlen16);
+    memcpy(p, &plen16, sizeof(plen16)); p += sizeof(plen16);
+    memcpy(p, &mlen32, sizeof(mlen32)); p += sizeof(mlen32);
+    memcpy(p, word, wlen);              p += wlen;
+    if (plen) memcpy(p, pos, plen);
+    p += plen;
+    if (mlen) memcpy(p, meaning, mlen);
+
+    check = entry_check(buf + 2 * sizeof(uint32_t), len);
+    memcpy(buf, &len32, sizeof(len32));
+    memcpy(buf + sizeof(len32), &check, sizeof(check));
+
+    ok = fwrite(buf, 1, 2 * sizeof(uint32_t) + len, j->fp) == 2 * sizeof(uint32_t) + len &&
+         fflush(j->fp) == 0;
+    free(buf);
+    if (!ok) {
+        j->failed = 1;
+        return -1;
+    }
+    j->bytes += (long)(2 * sizeof(uint32_t) + len);
+    j->entries++;
+    return 0;
+}
+
+/* ── Replay ──────────────────────────────────────────────────── */
+
+/*
+ * Decode payload p[len] (writable: the strings are NUL-terminated in
+ * place) and apply it through ops.  Returns 0, or -1 if it is malformed.
+ */
+static int apply_entry(unsigned char *p, uint32_t len, const JournalOps *ops, void *arg) {
+    char       op = (char)p[0];
+    int32_t    a, b;
+    uint16_t   wlen, plen;
+    uint32_t   mlen;
+    char       word[MAX_WORD_LEN];
+    char      *pos, *meaning;
+    WordRecord rec;
+
+    memcpy(&a,    p + 1,  sizeof(a));
+    memcpy(&b,    p + 5,  sizeof(b));
+    memcpy(&wlen, p + 9,  sizeof(wlen));
+    memcpy(&plen, p + 11, sizeof(plen));
+    memcpy(&mlen, p + 13, sizeof(mlen));
+    if (wlen == 0 || wlen >= MAX_WORD_LEN ||
+        (uint64_t)ENTRY_FIXED + wlen + plen + mlen != len)
+        return -1;
+
+    memcpy(word, p + ENTRY_FIXED, wlen);
+    word[wlen] = '\0';
+    /* Shift POS and meaning down over the word, leaving room for the NULs */
+    pos     = (char *)p;
+    meaning = pos + plen + 1;
+    memmove(pos, p + ENTRY_FIXED + wlen, plen);
+    pos[plen] = '\0';
+    memmove(meaning, p + ENTRY_FIXED + wlen + plen, mlen);
+    meaning[mlen] = '\0';
+
+    switch (op) {
+    case 'I':
+        memset(&rec, 0, sizeof(rec));
+        memcpy(rec.word, word, sizeof(rec.word));
+        rec.part_of_speech    = pos;
+        rec.meaning           = meaning;
+        rec.frequency_score   = a;
+        rec.user_select_count = b;
+        if (ops && ops->insert) ops->insert(&rec, arg);
+        return 0;
+    case 'D':
+        if (ops && ops->remove) ops->remove(word, arg);
+        return 0;
+    case 'P':
+        if (ops && ops->picks) ops->picks(word, a, b, arg);
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+/*
+ * Apply every intact entry of fp (positioned past a valid header).
+ * *good gets the offset just past the last one.  Returns the count.
+ */
+static int replay_entries(FILE *fp, const JournalOps *ops, void *arg, long *good) {
+    unsigned char *buf = NULL;
+    size_t         cap = 0;
+    uint32_t       len, check;
+    int            entries = 0;
+
+    *good = ftell(fp);
+    for (;;) {
+        if (fread(&len, sizeof(len), 1, fp) != 1 ||
+            fread(&check, sizeof(check), 1, fp) != 1)
+            break;
+        if (len < ENTRY_FIXED || len > ENTRY_MAX) break;
+        /* +2: apply_entry terminates POS and meaning in place */
+        if (len + 2 > cap) {
+            unsigned char *nb = (unsigned char *)realloc(buf, len + 2);
+            if (!nb) break;
+            buf = nb;
+            cap = len + 2;
+        }
+        if (fread(buf, 1, len, fp) != len) break;
+        if (entry_check(buf, len) != check) break;
+        if (apply_entry(buf, len, ops, arg) != 0) break;
+        entries++;
+        *good = ftell(fp);
+    }
+    free(buf);
+    return entries;
+}
+
+/*
+ * Replace path with a fresh header followed by the entries at its bytes
+ * [from, to) (from == to: none), via a temporary file so a crash leaves
+ * one or the other.  path must not be open (Windows cannot replace it).
+ */
+static int rewrite_range(const char *path, long from, long to) {
+    char          tmp[512];
+    char          chunk[MAX_LINE_BUF];
+    JournalHeader h;
+    FILE         *src = NULL, *fp;
+    int           failed = 0;
+
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    if (from < to && (!(src = fopen(path, "rb")) || fseek(src, from, SEEK_SET) != 0)) {
+        if (src) fclose(src);
+        return -1;
+    }
+    fp = fopen(tmp, "wb");
+    if (!fp) {
+        if (src) fclose(src);
+        return -1;
+    }
+
+    header_init(&h);
+    if (fwrite(&h, sizeof(h), 1, fp) != 1) failed = 1;
+    while (from < to && !failed) {
+        size_t want = to - from < (long)sizeof(chunk) ? (size_t)(to - from) : sizeof(chunk);
+        if (fread(chunk, 1, want, src) != want || fwrite(chunk, 1, want, fp) != want)
+            failed = 1;
+        from += (long)want;
+    }
+    if (src) fclose(src);
+    if (fclose(fp) != 0) failed = 1;
+    if (failed) {
+        remove(tmp);
+        return -1;
+    }
+#ifdef _WIN32
+    remove(path);   /* rename does not replace an existing file here */
+#endif
+    if (rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* Open path for appending and note its size. */
+static int open_append(Journal *j) {
+    j->fp = fopen(j->path, "ab");
+    if (!j->fp || fseek(j->fp, 0, SEEK_END) != 0 || (j->bytes = ftell(j->fp)) < 0) {
+        if (j->fp) fclose(j->fp);
+        j->fp     = NULL;
+        j->bytes  = 0;
+        j->failed = 1;
+        return -1;
+    }
+    return 0;
+}
+
+/* ── Compaction ──────────────────────────────────────────────── */
+
+/* The copy carries each meaning read in, so the worker never reads a
+   file — least of all the one it is about to rewrite. */
+static void copy_cb(AVLNode *node, void *arg) {
+    WordRecord **out = (WordRecord **)arg;
+    **out = *node->rec;
+    (*out)->meaning = word_record_meaning(node->rec);
+    (*out)++;
+}
+
+/* Worker: both save files from the copy, then tell the owner. */
+static void *compact_main(void *arg) {
+    JournalCompaction *c = (JournalCompaction *)arg;
+    int status = save_custom_words_records(c->text_path, c->recs, c->n) == 0 &&
+                 snapshot_save_records(c->snap_path, c->recs, c->n) == 0 ? 0 : -1;
+
+    pthread_mutex_lock(&c->lock);
+    c->status   = status;
+    c->finished = 1;
+    pthread_mutex_unlock(&c->lock);
+    if (c->done) c->done(c->arg);
+    return NULL;
+}
+
+/*
+ * The save files now hold everything up to mark: keep only the entries
+ * logged after it.  If the journal cannot be rewritten it is kept whole,
+ * which is safe — replaying entries the files already hold is a no-op.
+ */
+static void drop_covered(Journal *j, long mark, int mark_entries) {
+    long end = j->bytes;
+
+    if (j->fp) fclose(j->fp);
+    j->fp = NULL;
+    if (rewrite_range(j->path, mark, end > mark ? end : mark) == 0)
+        j->entries -= mark_entries;
+    open_append(j);
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int journal_open(Journal *j, const char *path, const JournalOps *ops, void *arg) {
+    JournalHeader h;
+    FILE         *fp;
+    long          good = 0, size = 0;
+    int           entries = 0;
+
+    memset(j, 0, sizeof(*j));
+    j->path = path;
+
+    fp = fopen(path, "rb");
+    if (fp) {
+        if (fread(&h, sizeof(h), 1, fp) == 1 && header_ok(&h))
+            entries = replay_entries(fp, ops, arg, &good);
+        if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0) size = -1;
+        fclose(fp);
+    }
+
+    /* Missing, foreign or torn: start over from the intact part */
+    if (!fp || good == 0 || size != good) {
+        long from = good > 0 ? (long)sizeof(h) : 0;
+        if (rewrite_range(path, from, good > 0 ? good : 0) != 0) {
+            j->failed = 1;
+            return -1;
+        }
+    }
+
+    if (open_append(j) != 0) return -1;
+    j->entries = entries;
+    return entries;
+}
+
+int journal_log_insert(Journal *j, const WordRecord *rec) {
+    return append_entry(j, 'I', rec->frequency_score, rec->user_select_count, rec->word,
+                        rec->part_of_speech, word_record_meaning(rec));
+}
+
+int journal_log_delete(Journal *j, const char *word) {
+    return append_entry(j, 'D', 0, 0, word, NULL, NULL);
+}
+
+int journal_log_picks(Journal *j, const char *word, int picks, int select_time) {
+    return append_entry(j, 'P', picks, select_time, word, NULL, NULL);
+}
+
+int journal_needs_compact(const Journal *j) {
+    return !j->compaction && (j->failed || j->bytes >= JOURNAL_COMPACT_BYTES);
+}
+
+int journal_compact(Journal *j, AVLNode *avl_root, const char *text_path,
+                    const char *snap_path) {
+    if (j->compaction) return -1;
+    /* Straight from the tree: no copy, no thread */
+    if (save_custom_words(text_path, avl_root) != 0) return -1;
+    if (snapshot_save(snap_path, avl_root) != 0) return -1;
+    j->failed = 0;
+    drop_covered(j, j->bytes, j->entries);
+    return 0;
+}
+
+int journal_compact_begin(Journal *j, AVLNode *avl_root, const char *text_path,
+                          const char *snap_path, void (*done)(void *arg), void *arg) {
+    JournalCompaction *c;
+    WordRecord        *out;
+
+    if (j->compaction) return -1;
+    c = (JournalCompaction *)calloc(1, sizeof(JournalCompaction));
+    if (!c) return -1;
+    c->n    = avl_count(avl_root);
+    c->recs = (WordRecord *)malloc((size_t)(c->n ? c->n : 1) * sizeof(WordRecord));
+    if (!c->recs || pthread_mutex_init(&c->lock, NULL) != 0) {
+        free(c->recs);
+        free(c);
+        return -1;
+    }
+    out = c->recs;
+    avl_inorder(avl_root, copy_cb, &out);
+
+    c->text_path    = text_path;
+    c->snap_path    = snap_path;
+    c->done         = done;
+    c->arg          = arg;
+    c->mark_bytes   = j->bytes;
+    c->mark_entries = j->entries;
+    c->was_failed   = j->failed;
+    j->failed       = 0;    /* the copy holds whatever failed to append */
+    j->compaction   = c;
+
+    /* If no thread can be started, save right here */
+    c->threaded = pthread_create(&c->thread, NULL, compact_main, c) == 0;
+    if (!c->threaded) compact_main(c);
+    return 0;
+}
+
+int journal_compact_running(const Journal *j) {
+    return j->compaction != NULL;
+}
+
+int journal_compact_finished(Journal *j) {
+    int finished;
+    if (!j->compaction) return 0;
+    pthread_mutex_lock(&j->compaction->lock);
+    finished = j->compaction->finished;
+    pthread_mutex_unlock(&j->compaction->lock);
+    return finished;
+}
+
+int journal_compact_end(Journal *j) {
+    JournalCompaction *c = j->compaction;
+    int                status;
+
+    if (!c) return 0;
+    if (c->threaded) pthread_join(c->thread, NULL);
+    status = c->status;
+    if (status == 0)
+        drop_covered(j, c->mark_bytes, c->mark_entries);
+    else
+        j->failed |= c->was_failed;
+    pthread_mutex_destroy(&c->lock);
+    free(c->recs);
+    free(c);
+    j->compaction = NULL;
+    return status;
+}
+
+void journal_close(Journal *j) {
+    journal_compact_end(j);
+    if (j->fp) fclose(j->fp);
+    j->fp = NULL;
+}
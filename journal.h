@@ -0,0 +1,125 @@
+/* journal.h - Append-only write-ahead log of dictionary changes */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdio.h>
+#include "dictionary.h"
+#include "avl.h"
+
+/*
+ * Journal - every insert, delete and pick of a session, appended to one
+ * file as it happens, so saving costs O(changes) instead of a rewrite of
+ * the whole dictionary, and a crash loses nothing that was logged.
+ *
+ *   [header]   magic, byte-order tag, MAX_WORD_LEN of the writer
+ *   [entries]  [len:4][check:4][payload: len bytes] each, where check is
+ *              FNV-1a over the payload and the payload is
+ *              [op:1][a:4][b:4][word_len:2][pos_len:2][meaning_len:4]
+ *              followed by the word, POS and meaning bytes
+ *
+ *   op 'I'  insert  word, POS, meaning; a = frequency, b = picks
+ *   op 'D'  delete  word
+ *   op 'P'  picks   word; a = its new user_select_count, b = its new
+ *                   select_time (0 in logs from before picks were
+ *                   stamped)
+ *
+ * Picks are logged as the new count rather than the increment, so every
+ * entry is idempotent: replaying a log over a snapshot that already holds
+ * its changes (a crash between the two steps of journal_compact) leaves
+ * the same dictionary.
+ *
+ * Each append is flushed to the OS before the call returns, so the log
+ * outlives the process.  An entry cut short at the end of the file (the
+ * process died mid-write) fails its length or check and is dropped, with
+ * everything after it, when the journal is opened.
+ *
+ * Compaction folds the log into the full save files (custom_words.txt and
+ * the snapshot) and empties it — when it passes JOURNAL_COMPACT_BYTES,
+ * when the dictionary is replaced wholesale, or at exit if an append
+ * failed.
+ *
+ * It can run in the background: journal_compact_begin copies the records
+ * out of the tree in order (O(n) and a few milliseconds; the copies share
+ * the meaning and POS text, which the store never changes or frees before
+ * store_free) and writes both files from the copy on a worker thread.
+ * The caller goes on changing the dictionary and logging meanwhile;
+ * journal_compact_end then drops from the log only the entries the copy
+ * already holds.
+ */
+
+struct JournalCompaction;   /* a running background compaction */
+
+/* Callbacks journal_open applies each logged change through. */
+typedef struct JournalOps {
+    void (*insert)(const WordRecord *rec, void *arg);
+    void (*remove)(const char *word, void *arg);
+    void (*picks)(const char *word, int picks, int select_time, void *arg);
+} JournalOps;
+
+typedef struct Journal {
+    FILE       *fp;        /* open for appending, or NULL             */
+    const char *path;
+    long        bytes;     /* file size                               */
+    int         entries;   /* changes in the file                     */
+    int         failed;    /* an append failed since the last compact */
+    struct JournalCompaction *compaction;   /* or NULL */
+} Journal;
+
+/*
+ * Replay the journal at path through ops (arg is passed through), drop
+ * any torn tail, and open it for appending — creating it if it is
+ * missing or from an incompatible build.  path must outlive j.  Returns
+ * the number of entries replayed, or -1 if the file cannot be written
+ * (appends then fail and j->failed is set).
+ */
+int journal_open(Journal *j, const char *path, const JournalOps *ops, void *arg);
+
+/* Log one change.  Return 0, or -1 (and set j->failed) if it could not
+   be written. */
+int journal_log_insert(Journal *j, const WordRecord *rec);
+int journal_log_delete(Journal *j, const char *word);
+int journal_log_picks(Journal *j, const char *word, int picks, int select_time);
+
+/* 1 if the log should be folded into the save files now (never while a
+   compaction is running). */
+int journal_needs_compact(const Journal *j);
+
+/*
+ * Write the whole dictionary to text_path (save_custom_words) and
+ * snap_path (snapshot_save), then empty the journal, waiting for both.
+ * If either save fails the journal is kept as it is.  Returns 0 on
+ * success, -1 on error (or if a background compaction is running).
+ */
+int journal_compact(Journal *j, AVLNode *avl_root, const char *text_path,
+                    const char *snap_path);
+
+/*
+ * Start the same compaction in the background.  done(arg), if not NULL,
+ * is called on the worker thread once the files are written — not a
+ * place to touch the dictionary or a UI; hand control back to the owning
+ * thread (a GUI posts an idle callback), which calls journal_compact_end.
+ * The store must not be freed until then.  Returns 0 if it started, -1
+ * if it could not (out of memory, or one is already running).
+ */
+int journal_compact_begin(Journal *j, AVLNode *avl_root, const char *text_path,
+                          const char *snap_path, void (*done)(void *arg), void *arg);
+
+/* 1 if a compaction was begun and has not been ended. */
+int journal_compact_running(const Journal *j);
+
+/* 1 if that compaction's files are written: journal_compact_end will not
+   block. */
+int journal_compact_finished(Journal *j);
+
+/*
+ * Wait for the running compaction and finish it: on success the entries
+ * it covered are dropped from the journal.  Returns 0 on success (or if
+ * none is running), -1 if a save failed — the journal is kept whole.
+ */
+int journal_compact_end(Journal *j);
+
+/* Finish any running compaction and close the file (logged changes stay
+   in it for the next open). */
+void journal_close(Journal *j);
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,623 @@
+/* jsonl.c - Streaming kaikki.org JSONL reader */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L   /* fseeko under -std=c99 */
+#define _FILE_OFFSET_BITS 64      /* dumps past 2 GB on 32-bit hosts */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jsonl.h"
+#include "utils.h"
+
+#define JSON_DEPTH_MAX  64          /* deeper nesting is treated as malformed */
+
+/* read_line results besides a length */
+#define LINE_EOF       (-1L)
+#define LINE_TOO_LONG  (-2L)
+#define LINE_NOMEM     (-3L)
+
+/* ── Filters (kept in step with preprocess_jsonl.py) ─────────── */
+
+/* Kept parts of speech in preference order: when a word appears under
+   several, the earliest one here wins. */
+static const struct { const char *raw, *display; } KEPT_POS[] = {
+    { "noun", "noun" },         { "verb", "verb" },
+    { "adj", "adjective" },     { "adv", "adverb" },
+    { "pron", "pronoun" },      { "prep", "preposition" },
+    { "conj", "conjunction" },  { "intj", "interjection" },
+    { "det", "determiner" },    { "num", "numeral" },
+    { "article", "article" },
+};
+#define NUM_KEPT_POS  ((int)(sizeof(KEPT_POS) / sizeof(KEPT_POS[0])))
+
+/* Glosses starting with one of these (any case) are cross-references,
+   inflections, names or places rather than definitions. */
+static const char *const SKIP_PREFIXES[] = {
+    "alternative form of", "alternative spelling of",
+    "alternative letter-case form", "alternative capitalization of",
+    "present participle and", "third-person singular simple",
+    "simple past and", "simple past of", "past participle of", "plural of",
+    "comparative form of", "superlative form of", "gerund of", "inflection of",
+    "archaic form of", "archaic spelling of", "obsolete form of",
+    "obsolete spelling of", "dated form of", "dated spelling of",
+    "eye dialect spelling of", "misspelling of", "elongated form of",
+    "nonstandard spelling of", "nonstandard form of", "rare form of",
+    "rare spelling of",
+    "abbreviation of", "initialism of", "acronym of", "clipping of", "short for",
+    "synonym of", "antonym of", "diminutive of", "augmentative of",
+    "feminine of", "masculine of", "genitive of", "dative of", "nominative of",
+    "a surname", "a female given", "a male given", "a placename",
+    "a village in", "a village and", "a town in", "a city in", "a suburb of",
+    "a locality in", "an unincorporated community", "a barangay of",
+    "a place in",
+};
+#define NUM_SKIP_PREFIXES  ((int)(sizeof(SKIP_PREFIXES) / sizeof(SKIP_PREFIXES[0])))
+
+/* Parenthesised labels up to this long are dropped from a meaning */
+#define GLOSS_LABEL_MAX  40
+
+#define COUNTS_MIN_CAP   4096       /* first word-count table size          */
+#define COUNTS_KEYS_MIN  65536      /* first key buffer size, in bytes      */
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static int is_letter(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static int seek_to(FILE *fp, long long off) {
+#ifdef _WIN32
+    return _fseeki64(fp, off, SEEK_SET);
+#else
+    return fseeko(fp, (off_t)off, SEEK_SET);
+#endif
+}
+
+/* Size of the open file; the position is left at the start. */
+static long long size_of(FILE *fp) {
+    long long n;
+#ifdef _WIN32
+    if (_fseeki64(fp, 0, SEEK_END) != 0) return -1;
+    n = _ftelli64(fp);
+#else
+    if (fseeko(fp, 0, SEEK_END) != 0) return -1;
+    n = (long long)ftello(fp);
+#endif
+    return seek_to(fp, 0) == 0 ? n : -1;
+}
+
+/* Grow the line buffer (doubling, capped at JSONL_LINE_MAX). */
+static int grow_line(JsonlReader *r) {
+    size_t cap = r->cap ? r->cap * 2 : 65536;
+    char  *p;
+    if (cap > JSONL_LINE_MAX) cap = JSONL_LINE_MAX;
+    if (!(p = (char *)realloc(r->line, cap))) return -1;
+    r->line = p;
+    r->cap  = cap;
+    return 0;
+}
+
+/* Read the next line into r->line without its line ending.  Returns its
+   length or LINE_EOF / LINE_TOO_LONG (the line was drained) / LINE_NOMEM. */
+static long read_line(JsonlReader *r) {
+    size_t len = 0, n;
+    int    got = 0, too_long = 0;
+
+    for (;;) {
+        if (r->cap - len < 2) {
+            if (r->cap >= JSONL_LINE_MAX) {
+                too_long = 1;                  /* keep reading, drop it */
+                len = 0;
+            } else if (grow_line(r) != 0) {
+                return LINE_NOMEM;
+            }
+        }
+        if (!fgets(r->line + len, (int)(r->cap - len), r->fp)) break;
+        got = 1;
+        n    = strlen(r->line + len);
+        len += n;
+        r->offset += (long long)n;
+        if (len > 0 && r->line[len - 1] == '\n') break;
+    }
+    if (!got) return LINE_EOF;
+    if (too_long) return LINE_TOO_LONG;
+    while (len > 0 && (r->line[len - 1] == '\n' || r->line[len - 1] == '\r'))
+        r->line[--len] = '\0';
+    return (long)len;
+}
+
+static char *skip_ws(char *p) {
+    while (is_space(*p)) p++;
+    return p;
+}
+
+static int hex4(const char *p, unsigned long *out) {
+    unsigned long v = 0;
+    int           i;
+    for (i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if      (c >= '0' && c <= '9') v |= (unsigned long)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (unsigned long)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (unsigned long)(c - 'A' + 10);
+        else return 0;
+    }
+    *out = v;
+    return 1;
+}
+
+static char *put_utf8(char *w, unsigned long cp) {
+    if (cp < 0x80) {
+        *w++ = (char)cp;
+    } else if (cp < 0x800) {
+        *w++ = (char)(0xC0 | (cp >> 6));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *w++ = (char)(0xE0 | (cp >> 12));
+        *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *w++ = (char)(0xF0 | (cp >> 18));
+        *w++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return w;
+}
+
+/*
+ * p is at a string's opening quote.  Decode the string in place (the
+ * UTF-8 of an escape is never longer than the escape), NUL-terminate it
+ * and point *out at it.  Returns the position after the closing quote,
+ * or NULL if the string is malformed or holds a \u0000.
+ */
+static char *parse_string(char *p, char **out) {
+    unsigned long cp, lo;
+    char         *w = ++p;
+
+    *out = w;
+    for (;;) {
+        char c = *p++;
+        if (c == '"')  { *w = '\0'; return p; }
+        if (c == '\0') return NULL;
+        if (c != '\\') { *w++ = c; continue; }
+        switch (*p++) {
+            case '"':  *w++ = '"';  break;
+            case '\\': *w++ = '\\'; break;
+            case '/':  *w++ = '/';  break;
+            case 'b':  *w++ = '\b'; break;
+            case 'f':  *w++ = '\f'; break;
+            case 'n':  *w++ = '\n'; break;
+            case 'r':  *w++ = '\r'; break;
+            case 't':  *w++ = '\t'; break;
+            case 'u':
+                if (!hex4(p, &cp) || cp == 0) return NULL;
+                p += 4;
+                /* A high surrogate followed by a low one is one code point */
+                if (cp >= 0xD800 && cp < 0xDC00 && p[0] == '\\' && p[1] == 'u' &&
+                    hex4(p + 2, &lo) && lo >= 0xDC00 && lo < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    p += 6;
+                }
+                w = put_utf8(w, cp);
+                break;
+            default:
+                return NULL;
+        }
+    }
+}
+
+/* Skip the JSON value at p without decoding it.  Returns the position
+   after it, or NULL if it is malformed. */
+static char *skip_value(char *p, int depth) {
+    char *s;
+
+    p = skip_ws(p);
+    if (depth > JSON_DEPTH_MAX) return NULL;
+    switch (*p) {
+        case '"':
+            for (p++; *p != '"'; p++) {
+                if (*p == '\0') return NULL;
+                if (*p == '\\' && *++p == '\0') return NULL;
+            }
+            return p + 1;
+        case '{':
+        case '[': {
+            char close = *p == '{' ? '}' : ']';
+            p = skip_ws(p + 1);
+            if (*p == close) return p + 1;
+            for (;;) {
+                if (close == '}') {
+                    if (*p != '"' || !(p = skip_value(p, depth + 1))) return NULL;
+                    p = skip_ws(p);
+                    if (*p++ != ':') return NULL;
+                }
+                if (!(p = skip_value(p, depth + 1))) return NULL;
+                p = skip_ws(p);
+                if (*p == close) return p + 1;
+                if (*p++ != ',') return NULL;
+                p = skip_ws(p);
+            }
+        }
+        default:
+            /* number, true, false, null */
+            for (s = p; *p && !is_space(*p) && *p != ',' && *p != ']' && *p != '}'; p++)
+                ;
+            return p > s ? p : NULL;
+    }
+}
+
+/* ── Word counts ─────────────────────────────────────────────── */
+
+/* FNV-1a over w[0..n) */
+static uint32_t hash_word(const char *w, size_t n) {
+    uint32_t h = 2166136261u;
+    size_t   i;
+    for (i = 0; i < n; i++) h = (h ^ (unsigned char)w[i]) * 16777619u;
+    return h;
+}
+
+/* Double the table (or make the first one) and rehash into it. */
+static int counts_grow(JsonlCounts *c) {
+    size_t      cap = c->cap ? c->cap * 2 : COUNTS_MIN_CAP, i, j;
+    JsonlCount *slots = (JsonlCount *)calloc(cap, sizeof(JsonlCount));
+
+    if (!slots) return -1;
+    for (i = 0; i < c->cap; i++) {
+        if (!c->slots[i].key) continue;
+        for (j = c->slots[i].hash & (cap - 1); slots[j].key; j = (j + 1) & (cap - 1))
+            ;
+        slots[j] = c->slots[i];
+    }
+    free(c->slots);
+    c->slots = slots;
+    c->cap   = cap;
+    return 0;
+}
+
+/* Count one use of the lowercase word w[0..n). */
+static void counts_add(JsonlCounts *c, const char *w, size_t n) {
+    uint32_t h = hash_word(w, n);
+    size_t   i, need;
+
+    if (c->failed) return;
+    if ((c->used + 1) * 2 > c->cap && counts_grow(c) != 0) { c->failed = 1; return; }
+    for (i = h & (c->cap - 1); c->slots[i].key; i = (i + 1) & (c->cap - 1)) {
+        JsonlCount *s = &c->slots[i];
+        if (s->hash == h && strncmp(c->keys + s->key, w, n) == 0 &&
+            c->keys[s->key + n] == '\0') {
+            if (s->count < UINT32_MAX) s->count++;
+            return;
+        }
+    }
+
+    if (c->keys_len == 0) c->keys_len = 1;          /* offset 0 is "empty" */
+    need = c->keys_len + n + 1;
+    if (need > c->keys_cap) {
+        size_t cap = c->keys_cap ? c->keys_cap : COUNTS_KEYS_MIN;
+        char  *keys;
+        while (cap < need) cap *= 2;
+        if (cap > UINT32_MAX || !(keys = (char *)realloc(c->keys, cap))) {
+            c->failed = 1;
+            return;
+        }
+        c->keys     = keys;
+        c->keys_cap = cap;
+    }
+    memcpy(c->keys + c->keys_len, w, n);
+    c->keys[c->keys_len + n] = '\0';
+    c->slots[i].key   = (uint32_t)c->keys_len;
+    c->slots[i].hash  = h;
+    c->slots[i].count = 1;
+    c->keys_len += n + 1;
+    c->used++;
+}
+
+/* Count the words of s: runs of letters (and UTF-8 bytes, so "café" is
+   one run, not "caf"), kept when all ASCII and 2..MAX_WORD_LEN-1 long. */
+static void count_words(JsonlCounts *c, const char *s) {
+    char          w[MAX_WORD_LEN];
+    size_t        n;
+    int           ascii;
+    unsigned char ch;
+
+    while ((ch = (unsigned char)*s) != '\0') {
+        if (ch < 0x80 && !is_letter(ch)) { s++; continue; }
+        for (n = 0, ascii = 1; (ch = (unsigned char)*s) != '\0' &&
+                               (ch >= 0x80 || is_letter(ch)); s++, n++) {
+            if (ch >= 0x80)             ascii = 0;
+            else if (n < sizeof(w) - 1) w[n] = (char)(ch >= 'a' ? ch : ch - 'A' + 'a');
+        }
+        if (ascii && n >= 2 && n < sizeof(w)) counts_add(c, w, n);
+    }
+}
+
+/* ── Entry scanner ───────────────────────────────────────────── */
+
+/* The fields of one entry that the filters look at (NULL if absent),
+   and the table every gloss is counted into (NULL: none). */
+typedef struct EntryFields {
+    char        *word;
+    char        *pos;
+    char        *gloss;
+    JsonlCounts *counts;
+} EntryFields;
+
+/* Case-insensitive (ASCII) test that g starts with the lowercase prefix */
+static int starts_with_lower(const char *g, const char *prefix) {
+    for (; *prefix; g++, prefix++) {
+        char c = *g;
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != *prefix) return 0;
+    }
+    return 1;
+}
+
+static int is_skip_gloss(const char *g) {
+    int i;
+    for (i = 0; i < NUM_SKIP_PREFIXES; i++)
+        if (starts_with_lower(g, SKIP_PREFIXES[i])) return 1;
+    return 0;
+}
+
+/* p is at a "glosses" array: take the first usable gloss into f->gloss
+   (trimmed, in place) unless one was already found, and count the words
+   of every gloss if f->counts is set. */
+static char *parse_glosses(char *p, EntryFields *f) {
+    char *s;
+
+    if (*p != '[') return skip_value(p, 2);
+    p = skip_ws(p + 1);
+    if (*p == ']') return p + 1;
+    for (;;) {
+        if (*p == '"' && (!f->gloss || f->counts)) {
+            if (!(p = parse_string(p, &s))) return NULL;
+            if (f->counts) count_words(f->counts, s);
+            if (!f->gloss) {
+                s = str_trim(s);
+                if (*s && !is_skip_gloss(s)) f->gloss = s;
+            }
+        } else if (!(p = skip_value(p, 3))) {
+            return NULL;
+        }
+        p = skip_ws(p);
+        if (*p == ']') return p + 1;
+        if (*p++ != ',') return NULL;
+        p = skip_ws(p);
+    }
+}
+
+/* Parse an object at p, handing each key's value to the caller: on_key
+   returns the position after the value (NULL if malformed). */
+static char *parse_object(char *p, EntryFields *f, int depth,
+                          char *(*on_key)(char *key, char *value, EntryFields *f, int depth)) {
+    char *key;
+
+    if (*p != '{') return skip_value(p, depth);
+    p = skip_ws(p + 1);
+    if (*p == '}') return p + 1;
+    for (;;) {
+        if (*p != '"' || !(p = parse_string(p, &key))) return NULL;
+        p = skip_ws(p);
+        if (*p++ != ':') return NULL;
+        if (!(p = on_key(key, skip_ws(p), f, depth))) return NULL;
+        p = skip_ws(p);
+        if (*p == '}') return p + 1;
+        if (*p++ != ',') return NULL;
+        p = skip_ws(p);
+    }
+}
+
+static char *on_sense_key(char *key, char *value, EntryFields *f, int depth) {
+    if (strcmp(key, "glosses") == 0) return parse_glosses(value, f);
+    return skip_value(value, depth + 1);
+}
+
+static char *on_entry_key(char *key, char *value, EntryFields *f, int depth) {
+    char *p = value;
+
+    if (strcmp(key, "word") == 0 && *p == '"') return parse_string(p, &f->word);
+    if (strcmp(key, "pos") == 0 && *p == '"')  return parse_string(p, &f->pos);
+    if (strcmp(key, "senses") != 0 || *p != '[') return skip_value(p, depth + 1);
+
+    /* senses: an array of objects, each with its own glosses */
+    p = skip_ws(p + 1);
+    if (*p == ']') return p + 1;
+    for (;;) {
+        if (!(p = parse_object(p, f, depth + 2, on_sense_key))) return NULL;
+        p = skip_ws(p);
+        if (*p == ']') return p + 1;
+        if (*p++ != ',') return NULL;
+        p = skip_ws(p);
+    }
+}
+
+/* Trimmed, all ASCII letters, 2..MAX_WORD_LEN-1 long: lowercase it into out. */
+static int clean_word(char *w, char *out) {
+    size_t len, i;
+
+    w   = str_trim(w);
+    len = strlen(w);
+    if (len < 2 || len >= MAX_WORD_LEN) return 0;
+    for (i = 0; i < len; i++) {
+        char c = w[i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        else if (c < 'a' || c > 'z') return 0;
+        out[i] = c;
+    }
+    out[len] = '\0';
+    return 1;
+}
+
+/*
+ * Clean gloss g into out[MAX_MEANING_LEN]: drop "(...)" runs of up to
+ * GLOSS_LABEL_MAX characters, turn '|' and whitespace runs into single
+ * spaces, trim, and cut at the last space that fits.  Returns its length.
+ */
+static size_t clean_meaning(char *g, char *out) {
+    char  *r = g, *w = g, *q, *cut;
+    size_t len;
+
+    while (*r) {
+        if (*r == '(') {
+            for (q = r + 1; *q && *q != ')' && q - r <= GLOSS_LABEL_MAX; q++)
+                ;
+            if (*q == ')') {
+                if (w > g && w[-1] != ' ') *w++ = ' ';
+                r = q + 1;
+                continue;
+            }
+        }
+        if (*r == '|' || is_space(*r)) {
+            if (w > g && w[-1] != ' ') *w++ = ' ';
+        } else {
+            *w++ = *r;
+        }
+        r++;
+    }
+    while (w > g && w[-1] == ' ') w--;
+    len = (size_t)(w - g);
+
+    if (len > MAX_MEANING_LEN - 1) {
+        /* Like the script: keep what precedes the last space in the first
+           MAX_MEANING_LEN - 2 bytes, else those bytes (whole characters) */
+        len = MAX_MEANING_LEN - 2;
+        for (cut = g + len - 1; cut > g && *cut != ' '; cut--)
+            ;
+        if (cut > g) len = (size_t)(cut - g);
+        else while (len > 0 && ((unsigned char)g[len] & 0xC0) == 0x80) len--;
+        while (len > 0 && g[len - 1] == ' ') len--;
+    }
+    memcpy(out, g, len);
+    out[len] = '\0';
+    return len;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int jsonl_open(JsonlReader *r, const char *path) {
+    if (!r || !path) return -1;
+    memset(r, 0, sizeof(*r));
+    r->end = -1;
+    r->fp  = fopen(path, "rb");
+    return r->fp ? 0 : -1;
+}
+
+/*
+ * Part k covers bytes [size * k / parts, size * (k + 1) / parts).  It
+ * skips the line holding the byte before its range (the previous part
+ * reads it, whole) and stops at the first line starting past its range.
+ */
+int jsonl_open_part(JsonlReader *r, const char *path, int part, int parts) {
+    long long size, from;
+    int       c;
+
+    if (parts < 1 || part < 0 || part >= parts) return -1;
+    if (jsonl_open(r, path) != 0) return -1;
+    if (parts == 1) return 0;
+    if ((size = size_of(r->fp)) < 0) {
+        jsonl_close(r);
+        return -1;
+    }
+    from = size * part / parts;
+    if (part < parts - 1) r->end = size * (part + 1) / parts;
+    if (from > 0) {
+        if (seek_to(r->fp, from - 1) != 0) {
+            jsonl_close(r);
+            return -1;
+        }
+        r->offset = from - 1;
+        while ((c = getc(r->fp)) != EOF) {
+            r->offset++;
+            if (c == '\n') break;
+        }
+    }
+    return 0;
+}
+
+long long jsonl_file_size(const char *path) {
+    FILE     *fp = path ? fopen(path, "rb") : NULL;
+    long long n;
+    if (!fp) return -1;
+    n = size_of(fp);
+    fclose(fp);
+    return n;
+}
+
+int jsonl_next(JsonlReader *r, JsonlEntry *e) {
+    EntryFields f;
+    char       *p;
+    long        len;
+    int         i;
+
+    if (!r || !r->fp || !e) return 0;
+    for (;;) {
+        if (r->end >= 0 && r->offset >= r->end) return 0;   /* next part's */
+        len = read_line(r);
+        if (len == LINE_EOF)   return 0;
+        if (len == LINE_NOMEM) return -1;
+        r->lines++;
+        if (len == LINE_TOO_LONG) { r->bad_json++; continue; }
+        p = skip_ws(r->line);
+        if (*p == '\0') continue;
+
+        f.word = f.pos = f.gloss = NULL;
+        f.counts = r->counts;
+        if (*p == '{') p = parse_object(p, &f, 0, on_entry_key);
+        else           p = NULL;
+        if (!p || *skip_ws(p) != '\0') {
+            r->bad_json++;
+            continue;
+        }
+
+        for (i = 0; f.pos && i < NUM_KEPT_POS && strcmp(f.pos, KEPT_POS[i].raw) != 0; i++)
+            ;
+        if (!f.pos || i == NUM_KEPT_POS) { r->skipped_pos++;   continue; }
+        if (!f.word || !clean_word(f.word, e->word)) { r->skipped_word++; continue; }
+        if (!f.gloss || clean_meaning(f.gloss, e->meaning) == 0) {
+            r->skipped_gloss++;
+            continue;
+        }
+        e->pos      = KEPT_POS[i].display;
+        e->priority = i;
+        return 1;
+    }
+}
+
+void jsonl_close(JsonlReader *r) {
+    if (!r) return;
+    if (r->fp) fclose(r->fp);
+    free(r->line);
+    r->fp   = NULL;
+    r->line = NULL;
+    r->cap  = 0;
+}
+
+void jsonl_counts_init(JsonlCounts *c) {
+    if (c) memset(c, 0, sizeof(*c));
+}
+
+void jsonl_counts_free(JsonlCounts *c) {
+    if (!c) return;
+    free(c->slots);
+    free(c->keys);
+    memset(c, 0, sizeof(*c));
+}
+
+int jsonl_counts_next(const JsonlCounts *c, size_t *i, const char **word,
+                      unsigned long *count) {
+    if (!c || !i) return 0;
+    for (; *i < c->cap; (*i)++) {
+        const JsonlCount *s = &c->slots[*i];
+        if (!s->key) continue;
+        *word  = c->keys + s->key;
+        *count = s->count;
+        (*i)++;
+        return 1;
+    }
+    return 0;
+}
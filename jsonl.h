@@ -0,0 +1,104 @@
+/* jsonl.h - Streaming reader for the kaikki.org JSONL dictionary dump */
+#ifndef JSONL_H
+#define JSONL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "config.h"
+
+/* One usable dictionary entry, after the same filters as preprocess_jsonl.py */
+typedef struct JsonlEntry {
+    char        word[MAX_WORD_LEN];       /* lowercase ASCII letters, 2..63 */
+    const char *pos;                      /* display name, e.g. "adjective" */
+    int         priority;                 /* POS rank, lower is preferred   */
+    char        meaning[MAX_MEANING_LEN]; /* first usable gloss, cleaned    */
+} JsonlEntry;
+
+/*
+ * JsonlCounts - how often each word is used in the dump's definitions:
+ * every gloss of every sense of every line the reader parses (whatever
+ * its part of speech) is split into runs of letters, and
+ * each run of 2..MAX_WORD_LEN-1 ASCII letters counts once for that word,
+ * lowercased.  Those are the corpus counts load_jsonl ranks words by.
+ * An open-addressing table of the words seen, keys in one growing buffer.
+ */
+typedef struct JsonlCount {
+    uint32_t key;            /* offset of the word in keys; 0 = empty   */
+    uint32_t hash;
+    uint32_t count;
+} JsonlCount;
+
+typedef struct JsonlCounts {
+    JsonlCount *slots;
+    size_t      cap, used;   /* cap is 0 or a power of 2                */
+    char       *keys;        /* NUL-terminated words, from offset 1     */
+    size_t      keys_len, keys_cap;
+    int         failed;      /* out of memory: counting stopped there   */
+} JsonlCounts;
+
+/*
+ * JsonlReader - reads a kaikki.org dump one line (one JSON object) at a
+ * time.  Only the current line is held in memory, in a buffer that grows
+ * to the longest line seen (lines over JSONL_LINE_MAX bytes are skipped),
+ * so memory stays bounded however large the dump is.
+ *
+ * Each line is parsed with a small JSON scanner that decodes the strings
+ * it needs in place and skips the rest.  An entry is returned only when:
+ *   - its top-level "pos" is one of the kept parts of speech (noun, verb,
+ *     adj, adv, pron, prep, conj, intj, det, num, article);
+ *   - its "word", trimmed and lowercased, is 2..63 ASCII letters;
+ *   - one of its "senses" -> "glosses" is not a cross-reference, an
+ *     inflection, a name or a place ("plural of", "a surname", ...) —
+ *     the first such gloss is the meaning — and it survives cleaning:
+ *     short parenthesised labels dropped, '|' and runs of whitespace
+ *     turned into single spaces, cut at a word boundary to fit.
+ * The counters say why the other lines were dropped.
+ */
+typedef struct JsonlReader {
+    FILE   *fp;
+    char   *line;
+    size_t  cap;
+    long    lines;           /* lines read                              */
+    long    bad_json;        /* malformed or over JSONL_LINE_MAX        */
+    long    skipped_pos;
+    long    skipped_word;
+    long    skipped_gloss;
+    long long offset;        /* bytes consumed                          */
+    long long end;           /* no line starting here or later is read;
+                                -1 reads to end of file                 */
+    JsonlCounts *counts;     /* if set, gloss words are counted into it */
+} JsonlReader;
+
+/* Open path for reading.  Returns 0, or -1 if it cannot be opened. */
+int jsonl_open(JsonlReader *r, const char *path);
+
+/*
+ * Open part `part` of `parts` of the file at path: the lines whose first
+ * byte lies in the part-th of `parts` equal byte ranges.  The parts of a
+ * file together read each of its lines exactly once, so they can be read
+ * by as many threads at once.  Returns 0, or -1 if it cannot be opened.
+ */
+int jsonl_open_part(JsonlReader *r, const char *path, int part, int parts);
+
+/* Size of the file at path in bytes, or -1 if it cannot be opened. */
+long long jsonl_file_size(const char *path);
+
+/* Read up to the next usable entry into e.  Returns 1 for an entry, 0 at
+   end of file, -1 on malloc failure. */
+int jsonl_next(JsonlReader *r, JsonlEntry *e);
+
+/* Close the file and free the line buffer. */
+void jsonl_close(JsonlReader *r);
+
+/* Empty table (nothing is allocated until the first word). */
+void jsonl_counts_init(JsonlCounts *c);
+
+/* Free the table. */
+void jsonl_counts_free(JsonlCounts *c);
+
+/* Step through the counted words: start with *i = 0; each call gives the
+   next word and its count and returns 1, then 0 when there are no more. */
+int jsonl_counts_next(const JsonlCounts *c, size_t *i, const char **word,
+                      unsigned long *count);
+
+#endif /* JSONL_H */
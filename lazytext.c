@@ -0,0 +1,150 @@
+/* lazytext.c - Deferred definition text implementation */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include "lazytext.h"
+
+/* Every live source, and the lock for all of their state */
+static LazyText       *g_sources = NULL;
+static pthread_mutex_t g_lock    = PTHREAD_MUTEX_INITIALIZER;
+
+/* ── Helpers ─────────────────────────────────────────────────── */
+
+/* The source whose placeholder p is, or NULL. */
+static LazyText *source_of(const char *p) {
+    uintptr_t at = (uintptr_t)p;
+    LazyText *lt;
+    for (lt = g_sources; lt; lt = lt->next)
+        if (at >= (uintptr_t)lt->refs && at < (uintptr_t)(lt->refs + lt->used))
+            return lt;
+    return NULL;
+}
+
+static void close_source(LazyText *lt) {
+    if (!lt->is_open) return;
+    if (lt->packed) packed_close(&lt->pd);
+    else            fclose(lt->fp);
+    lt->fp      = NULL;
+    lt->is_open = 0;
+}
+
+/* Read ref's text from the file into lt's arena.  NULL on error. */
+static const char *read_ref(LazyText *lt, const LazyRef *ref) {
+    if (!lt->is_open) return NULL;
+    if (lt->packed) {
+        const char *m = packed_meaning(&lt->pd, (int)ref->off);
+        return m ? arena_strdup(&lt->text, m) : NULL;
+    }
+
+    if (ref->len > lt->scratch_cap) {
+        char *grown = (char *)realloc(lt->scratch, ref->len);
+        if (!grown) return NULL;
+        lt->scratch     = grown;
+        lt->scratch_cap = ref->len;
+    }
+    if (ref->off > (uint64_t)LONG_MAX ||
+        fseek(lt->fp, (long)ref->off, SEEK_SET) != 0 ||
+        fread(lt->scratch, 1, ref->len, lt->fp) != ref->len)
+        return NULL;
+    return arena_strndup(&lt->text, lt->scratch, ref->len);
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+LazyText *lazytext_open(const char *path, int packed, int capacity) {
+    LazyText *lt;
+
+    if (!path || capacity < 0) return NULL;
+    lt = (LazyText *)calloc(1, sizeof(LazyText));
+    if (!lt) return NULL;
+    lt->refs = (LazyRef *)malloc((size_t)(capacity ? capacity : 1) * sizeof(LazyRef));
+    lt->packed = packed;
+    lt->is_open = packed ? packed_open(&lt->pd, path) == 0
+                         : (lt->fp = fopen(path, "rb")) != NULL;
+    if (!lt->refs || !lt->is_open) {
+        if (lt->is_open) close_source(lt);
+        free(lt->refs);
+        free(lt);
+        return NULL;
+    }
+    lt->cap = capacity;
+    arena_init(&lt->text);
+
+    pthread_mutex_lock(&g_lock);
+    lt->next  = g_sources;
+    g_sources = lt;
+    pthread_mutex_unlock(&g_lock);
+    return lt;
+}
+
+const char *lazytext_add(LazyText *lt, uint64_t off, uint32_t len) {
+    LazyRef *ref;
+
+    if (!lt) return NULL;
+    pthread_mutex_lock(&g_lock);
+    if (lt->used == lt->cap || !lt->is_open) {
+        pthread_mutex_unlock(&g_lock);
+        return NULL;
+    }
+    ref = &lt->refs[lt->used++];
+    ref->empty = '\0';
+    ref->len   = len;
+    ref->off   = off;
+    ref->text  = NULL;
+    lt->unread++;
+    pthread_mutex_unlock(&g_lock);
+    return &ref->empty;
+}
+
+const char *lazytext_resolve(const char *meaning) {
+    LazyText   *lt;
+    LazyRef    *ref;
+    const char *text;
+
+    if (!meaning) return "";
+    pthread_mutex_lock(&g_lock);
+    lt = source_of(meaning);
+    if (!lt) {
+        pthread_mutex_unlock(&g_lock);
+        return meaning;                    /* ordinary text */
+    }
+    ref = (LazyRef *)(uintptr_t)meaning;   /* &ref->empty is the ref itself */
+    if (!ref->text) {
+        ref->text = read_ref(lt, ref);
+        if (ref->text && --lt->unread == 0)
+            close_source(lt);              /* every meaning is in memory now */
+    }
+    text = ref->text ? ref->text : "";
+    pthread_mutex_unlock(&g_lock);
+    return text;
+}
+
+void lazytext_memory(const LazyText *lt, MemUsage *u) {
+    if (!lt) return;
+    pthread_mutex_lock(&g_lock);
+    arena_memory(&lt->text, u);
+    u->index_bytes    += (size_t)lt->cap * sizeof(LazyRef);
+    u->overhead_bytes += lt->scratch_cap;
+    pthread_mutex_unlock(&g_lock);
+}
+
+void lazytext_free(LazyText *lt) {
+    LazyText **pp;
+
+    if (!lt) return;
+    pthread_mutex_lock(&g_lock);
+    for (pp = &g_sources; *pp; pp = &(*pp)->next)
+        if (*pp == lt) {
+            *pp = lt->next;
+            break;
+        }
+    pthread_mutex_unlock(&g_lock);
+
+    close_source(lt);
+    arena_free(&lt->text);
+    free(lt->refs);
+    free(lt->scratch);
+    free(lt);
+}
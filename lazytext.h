@@ -0,0 +1,82 @@
+/* lazytext.h - Definitions left in their file until first read */
+#ifndef LAZYTEXT_H
+#define LAZYTEXT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "arena.h"
+#include "packed.h"
+
+/*
+ * LazyText - the meanings of one loaded file, read from it only when a
+ * word is opened, so a load costs memory and time for the keys alone.
+ *
+ * Each record loaded lazily gets a placeholder from lazytext_add instead
+ * of its text: a LazyRef holding where the meaning is in the file (a
+ * byte offset and length in a text file, an ordinal in a packed one).
+ * The record's meaning pointer points at the placeholder, whose first
+ * byte is NUL, so code that reads it directly sees "" — never garbage.
+ * word_record_meaning (dictionary.h) passes it to lazytext_resolve, which
+ * reads the text on first use and keeps it in the source's own arena;
+ * later calls return the same string.
+ *
+ * Records are never written by a resolve, so copies of a record (and
+ * readers on other threads) resolve through the same placeholder.  Every
+ * live source is registered in one process-wide list, and all resolving
+ * is serialised by one lock — definitions are read one at a time, when a
+ * user opens a word, or all at once by a save.
+ *
+ * The file is kept open until every placeholder has been read, and must
+ * not change meanwhile.  Anything that rewrites the file a source reads
+ * (save_custom_words over the custom_words.txt it was loaded from)
+ * resolves every record first, which also closes the file.
+ */
+
+typedef struct LazyRef {
+    char        empty;    /* '\0': an unread meaning reads as ""       */
+    uint32_t    len;      /* text file: bytes at off                   */
+    uint64_t    off;      /* text file: byte offset; packed: ordinal   */
+    const char *text;     /* the meaning once read, or NULL            */
+} LazyRef;
+
+typedef struct LazyText {
+    struct LazyText *next;      /* registry of live sources             */
+    int              packed;    /* 1: a packed file read with packed.h  */
+    FILE            *fp;        /* text source while refs are unread    */
+    PackedDict       pd;        /* packed source, open likewise         */
+    int              is_open;
+    LazyRef         *refs;      /* cap placeholders, never moved        */
+    int              cap;
+    int              used;
+    int              unread;    /* placeholders handed out, not yet read */
+    StringArena      text;      /* meanings read so far                 */
+    char            *scratch;
+    size_t           scratch_cap;
+} LazyText;
+
+/*
+ * Open path as the source of up to capacity meanings (packed: a .sdz
+ * file, else the text file the offsets refer to, read in binary mode).
+ * Returns NULL if it cannot be opened or on malloc failure.
+ */
+LazyText *lazytext_open(const char *path, int packed, int capacity);
+
+/* A placeholder for the meaning at off (and len bytes, for a text file),
+   to store as a record's meaning.  NULL once capacity is used up. */
+const char *lazytext_add(LazyText *lt, uint64_t off, uint32_t len);
+
+/*
+ * The text of meaning: read (once) if it is a placeholder of a live
+ * source, else meaning itself.  A meaning that can no longer be read
+ * (the file changed or vanished) comes back as "".  Thread-safe.
+ */
+const char *lazytext_resolve(const char *meaning);
+
+/* Add lt to u (memusage.h): the meanings read so far as strings, the
+   placeholders as index.  Thread-safe. */
+void lazytext_memory(const LazyText *lt, MemUsage *u);
+
+/* Unregister lt, close its file and free it with every string it read. */
+void lazytext_free(LazyText *lt);
+
+#endif /* LAZYTEXT_H */
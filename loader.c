@@ -2,186 +2,1224 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
 #include "loader.h"
+#include "jsonl.h"
+#include "packed.h"
+#include "lazytext.h"
 #include "avl.h"
 #include "tbt.h"
 #include "utils.h"
 
 /* ── save_custom_words helper ────────────────────────────────── */
 
-/* bst_inorder callback: write one node to the FILE* passed via arg.
-   Extended format: word|pos|meaning|freq|picks — lets the loader
-   restore frequency_score and user_select_count across sessions. */
-static void write_word_cb(BSTNode *node, void *arg) {
-    FILE *fp = (FILE *)arg;
-    const WordRecord *r = &node->data;
-    fprintf(fp, "%s|%s|%s|%d|%d\n",
+/* Write one record to fp.
+   Extended format: word|pos|meaning|freq|picks|select_time — lets the
+   loader restore frequency_score, user_select_count and how recent the
+   picks are across sessions. */
+static void write_word(FILE *fp, const WordRecord *r) {
+    fprintf(fp, "%s|%s|%s|%d|%d|%d\n",
             r->word,
             r->part_of_speech,
-            r->meaning,
+            word_record_meaning(r),
             r->frequency_score,
-            r->user_select_count);
+            r->user_select_count,
+            r->select_time);
 }
 
-/* ── Public API ──────────────────────────────────────────────── */
+/* Preorder walk of the AVL; its height stays under 1.45 log2(n), so the
+   recursion is shallow. */
+static void write_preorder(FILE *fp, const AVLNode *node) {
+    if (!node) return;
+    write_word(fp, node->rec);
+    write_preorder(fp, avl_left(node));
+    write_preorder(fp, avl_right(node));
+}
 
-int load_words(const char *path, BSTNode **bst_root,
-               AVLNode **avl_root, TBTNode *tbt_header) {
-    FILE      *fp;
-    char       line[MAX_LINE_BUF];
-    char      *pipe1;
-    char      *pipe2;
-    WordRecord rec;
-    int        count = 0;
+/* Read every lazy meaning in before a save truncates its file, which may
+   be the very file they are read from (custom_words.txt). */
+static void read_meanings(const AVLNode *node) {
+    if (!node) return;
+    word_record_meaning(node->rec);
+    read_meanings(avl_left(node));
+    read_meanings(avl_right(node));
+}
 
-    /* avl_root and tbt_header receive the same records as the BST */
+/* Saves go to path.tmp and are renamed over path only once every write
+   and the close succeeded, so a full disk or a crash mid-save leaves the
+   old file whole (and the journal, which trusts a 0 here, intact). */
+static FILE *save_open(const char *path, char *tmp, size_t size) {
+    if (snprintf(tmp, size, "%s.tmp", path) >= (int)size) return NULL;
+    return fopen(tmp, "w");
+}
 
-    fp = fopen(path, "r");
-    if (!fp) return -1;
+static int save_close(FILE *fp, const char *tmp, const char *path) {
+    int failed = ferror(fp) != 0;
+
+    if (fclose(fp) != 0) failed = 1;
+    if (failed) {
+        remove(tmp);
+        return -1;
+    }
+#ifdef _WIN32
+    remove(path);   /* rename does not replace an existing file here */
+#endif
+    if (rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* The same order for a sorted array: the middle record, then each half —
+   the preorder of the balanced tree over recs[lo..hi). */
+static void write_balanced(FILE *fp, const WordRecord *recs, int lo, int hi) {
+    int mid;
+    if (lo >= hi) return;
+    mid = lo + (hi - lo) / 2;
+    write_word(fp, &recs[mid]);
+    write_balanced(fp, recs, lo, mid);
+    write_balanced(fp, recs, mid + 1, hi);
+}
+
+/* ── Whole-file scanner ──────────────────────────────────────── */
+
+/*
+ * Read the whole file into one malloc'd buffer (*len bytes, plus a NUL
+ * that is never scanned).  Returns NULL if the file cannot be opened
+ * (*len = -1) or read (*len = 0).
+ */
+static char *read_file(const char *path, long *len) {
+    FILE *fp = fopen(path, "rb");
+    char *buf;
+
+    *len = -1;
+    if (!fp) return NULL;
+    *len = 0;
+    if (fseek(fp, 0, SEEK_END) != 0 || (*len = ftell(fp)) < 0 ||
+        fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        *len = 0;
+        return NULL;
+    }
+    buf = (char *)malloc((size_t)*len + 1);
+    if (buf && fread(buf, 1, (size_t)*len, fp) != (size_t)*len) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) buf[*len] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+static int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* The text in [b, e) without surrounding blanks (str_trim's set). */
+static TextSlice slice_trim(const char *b, const char *e) {
+    TextSlice s;
+    while (b < e && is_blank(*b))     b++;
+    while (e > b && is_blank(e[-1])) e--;
+    s.ptr = b;
+    s.len = (size_t)(e - b);
+    return s;
+}
+
+/* Next '|' in [p, e), or NULL (memchr is vectorised in every libc we use). */
+static const char *find_pipe(const char *p, const char *e) {
+    return (const char *)memchr(p, '|', (size_t)(e - p));
+}
+
+/* atoi over a slice: optional sign, then digits; saturates instead of
+   overflowing. */
+static int slice_atoi(TextSlice s) {
+    size_t i = 0;
+    long   v = 0;
+    int    neg = 0;
+
+    if (i < s.len && (s.ptr[i] == '+' || s.ptr[i] == '-')) neg = s.ptr[i++] == '-';
+    for (; i < s.len && s.ptr[i] >= '0' && s.ptr[i] <= '9'; i++)
+        if ((v = v * 10 + (s.ptr[i] - '0')) > INT_MAX) v = INT_MAX;
+    return (int)(neg ? -v : v);
+}
 
-    while (fgets(line, (int)sizeof(line), fp)) {
-        str_trim(line);
-
-        /* Skip blank lines and comment lines */
-        if (str_is_empty(line) || line[0] == '#') continue;
-
-        /* Reject words that are too long before any processing */
-        if (strlen(line) >= MAX_WORD_LEN && strchr(line, '|') == NULL) continue;
-
-        word_record_init(&rec);
-
-        pipe1 = strchr(line, '|');
-        if (pipe1) {
-            /* Rich format: word|pos[|meaning[|freq|picks]] */
-            *pipe1 = '\0';
-            str_trim(line);
-            str_safe_copy(rec.word, line, sizeof(rec.word));
-
-            pipe2 = strchr(pipe1 + 1, '|');
-            if (pipe2) {
-                /* At least word|pos|meaning */
-                char *pipe3, *pipe4;
-                *pipe2 = '\0';
-                str_trim(pipe1 + 1);
-                str_safe_copy(rec.part_of_speech, pipe1 + 1, sizeof(rec.part_of_speech));
-
-                /* Check for extended format: word|pos|meaning|freq|picks */
-                pipe3 = strchr(pipe2 + 1, '|');
-                if (pipe3) {
-                    /* meaning ends at pipe3 */
-                    *pipe3 = '\0';
-                    str_trim(pipe2 + 1);
-                    str_safe_copy(rec.meaning, pipe2 + 1, sizeof(rec.meaning));
-
-                    pipe4 = strchr(pipe3 + 1, '|');
-                    if (pipe4) {
-                        int f, p;
-                        *pipe4 = '\0';
-                        str_trim(pipe3 + 1);   /* freq field */
-                        str_trim(pipe4 + 1);   /* picks field */
-                        f = atoi(pipe3 + 1);
-                        p = atoi(pipe4 + 1);
-                        if (f > 0) rec.frequency_score   = f;
-                        if (p > 0) rec.user_select_count = p;
+/*
+ * The select_time to give a record read with picks and the stamp st (-1
+ * if the file has none).  Files written before picks were stamped (and
+ * packed files, which carry none) have their picks taken as made now, so
+ * they rank as they always did and start to fade from here.
+ */
+static int stamp_picks(int st, int picks) {
+    return st >= 0 ? st : score_add_picks(0, picks, score_minutes());
+}
+
+/* One parsed dictionary line; the slices point into the file buffer. */
+typedef struct WordFields {
+    TextSlice word, pos, meaning;
+    int       freq, picks;
+    int       select_time;   /* -1: not in the line */
+} WordFields;
+
+/*
+ * Parse the line [b, e) (no newline) in place, in a single left-to-right
+ * pass.  Same rules as the line formats documented in loader.h; fields
+ * are trimmed by moving slice ends, never by copying.  Returns 1 for a
+ * usable entry, 0 for a line to skip.
+ */
+static int parse_word_fields(const char *b, const char *e, WordFields *f) {
+    const char *p1, *p2, *p3, *p4, *p5;
+    TextSlice   line = slice_trim(b, e);
+
+    f->pos.ptr     = f->meaning.ptr = NULL;
+    f->pos.len     = f->meaning.len = 0;
+    f->freq        = FREQ_SCORE_DEFAULT;
+    f->picks       = 0;
+    f->select_time = -1;
+
+    /* Skip blank lines and comment lines */
+    if (line.len == 0 || line.ptr[0] == '#') return 0;
+    b = line.ptr;
+    e = line.ptr + line.len;
+
+    p1 = find_pipe(b, e);
+    if (!p1) {
+        /* Simple format: word only */
+        f->word = line;
+    } else {
+        /* Rich format: word|pos[|meaning[|freq|picks[|select_time]]] */
+        f->word = slice_trim(b, p1);
+        p2 = find_pipe(p1 + 1, e);
+        if (!p2) {
+            f->pos = slice_trim(p1 + 1, e);              /* word|pos */
+        } else {
+            f->pos = slice_trim(p1 + 1, p2);
+            p3 = find_pipe(p2 + 1, e);
+            if (!p3) {
+                f->meaning = slice_trim(p2 + 1, e);      /* word|pos|meaning */
+            } else {
+                f->meaning = slice_trim(p2 + 1, p3);
+                p4 = find_pipe(p3 + 1, e);
+                if (p4) {                                /* ...|freq|picks */
+                    int fr, pk;
+                    p5 = find_pipe(p4 + 1, e);
+                    fr = slice_atoi(slice_trim(p3 + 1, p4));
+                    pk = slice_atoi(slice_trim(p4 + 1, p5 ? p5 : e));
+                    if (fr > 0) f->freq  = fr;
+                    if (pk > 0) f->picks = pk;
+                    if (p5) {                            /* ...|select_time */
+                        int st = slice_atoi(slice_trim(p5 + 1, e));
+                        f->select_time = st > 0 ? st : 0;
                     }
-                } else {
-                    /* Plain 3-field: word|pos|meaning */
-                    str_trim(pipe2 + 1);
-                    str_safe_copy(rec.meaning, pipe2 + 1, sizeof(rec.meaning));
                 }
-            } else {
-                /* word|pos (no meaning) */
-                str_trim(pipe1 + 1);
-                str_safe_copy(rec.part_of_speech, pipe1 + 1, sizeof(rec.part_of_speech));
             }
+        }
+    }
+
+    /* Skip empty and oversized words (MAX_WORD_LEN - 1 chars would be
+       truncated on the way into the record) */
+    return f->word.len > 0 && f->word.len < MAX_WORD_LEN - 1;
+}
+
+/*
+ * Store one parsed line.  With a lazy source, a non-empty meaning is left
+ * in the file: the record gets a placeholder for its offset in buf (the
+ * whole file as read), and no copy is made.
+ */
+static WordRecord *add_fields(RecordStore *store, LazyText *lazy, const char *buf,
+                              const WordFields *f) {
+    WordRecord *rec = NULL;
+
+    if (lazy && f->meaning.len > 0 && f->meaning.len <= UINT32_MAX) {
+        const char *ref = lazytext_add(lazy, (uint64_t)(f->meaning.ptr - buf),
+                                       (uint32_t)f->meaning.len);
+        if (ref)
+            rec = store_add_fields_borrowed(store, f->word, f->pos, ref,
+                                            f->freq, f->picks);
+    }
+    if (!rec) rec = store_add_fields(store, f->word, f->pos, f->meaning, f->freq, f->picks);
+    if (rec && (f->select_time > 0 || (f->select_time < 0 && f->picks > 0))) {
+        rec->select_time = stamp_picks(f->select_time, f->picks);
+        store_track_decay(store, rec);
+    }
+    return rec;
+}
+
+/*
+ * A lazy source for the file at path (len bytes in buf), if
+ * LAZY_MEANINGS is on and the store has none yet; else NULL.  It has
+ * room for a placeholder per line.
+ */
+static LazyText *open_lazy(const char *path, int packed, const char *buf, long len,
+                           int count, const RecordStore *store) {
+    const char *p, *end;
+
+    if (!LAZY_MEANINGS || store->lazy) return NULL;
+    if (!packed) {
+        count = 1;
+        for (p = buf, end = buf + len; (p = (const char *)memchr(p, '\n', (size_t)(end - p))) != NULL; p++)
+            if (count++ == INT_MAX - 1) return NULL;
+    }
+    return lazytext_open(path, packed, count);
+}
+
+/* Hand lazy to the store once the load is done (or drop it, if every
+   meaning was empty and no placeholder was made). */
+static void adopt_lazy(RecordStore *store, LazyText *lazy) {
+    if (!lazy) return;
+    if (lazy->used == 0 || !store_adopt_lazy(store, lazy))
+        lazytext_free(lazy);
+}
+
+/* ── Bulk build ──────────────────────────────────────────────── */
+
+/* One record read by the bulk loader, with its position in the file. */
+typedef struct LoadEntry {
+    WordRecord *rec;
+    int         seq;
+} LoadEntry;
+
+/* qsort order: by word, then file order, so the first copy of a
+   duplicate sorts first and is the one kept. */
+static int load_entry_cmp(const void *a, const void *b) {
+    const LoadEntry *x = (const LoadEntry *)a;
+    const LoadEntry *y = (const LoadEntry *)b;
+    int cmp = strcmp(x->rec->word, y->rec->word);
+    if (cmp != 0) return cmp;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+/*
+ * Index one stored record in every tree — the incremental path.  The
+ * store's word index is the duplicate check: a later copy of a word is
+ * released before any tree sees it.  Returns 1 if indexed, 0 if not.
+ */
+static int index_record(WordRecord *stored, RecordStore *store,
+                        BSTNode **bst_root, AVLNode **avl_root,
+                        TBTNode *tbt_header, Trie *trie) {
+    if (store_find(store, stored->word) != stored) {
+        store_release(store, stored);
+        return 0;
+    }
+    if (bst_root) bst_insert(bst_root, stored);
+    *avl_root = avl_insert(*avl_root, stored);
+    if (tbt_header) tbt_insert(tbt_header, stored);
+    if (trie)       trie_insert(trie, stored);
+    return 1;
+}
+
+/* ── Concurrent jobs ─────────────────────────────────────────── */
+
+#define LOAD_JOBS_MAX  (LOAD_THREADS > 4 ? LOAD_THREADS : 4)
+
+/*
+ * Run fn on each of the n jobs (job i at jobs + i * job_size, n <=
+ * LOAD_JOBS_MAX): job 0 on the calling thread, the rest on their own
+ * threads.  A job whose thread cannot be started runs here instead, so
+ * every job always completes.
+ */
+static void run_jobs(void *(*fn)(void *), void *jobs, size_t job_size, int n) {
+    pthread_t tid[LOAD_JOBS_MAX];
+    int       started[LOAD_JOBS_MAX];
+    int       i;
+
+    for (i = 1; i < n; i++)
+        started[i] = pthread_create(&tid[i], NULL, fn,
+                                    (char *)jobs + (size_t)i * job_size) == 0;
+    fn(jobs);
+    for (i = 1; i < n; i++) {
+        if (started[i]) pthread_join(tid[i], NULL);
+        else            fn((char *)jobs + (size_t)i * job_size);
+    }
+}
+
+/* One index to build from the sorted records.  Each tree type allocates
+   from its own node pool (the trie from its own handle), so the four
+   builds share nothing but the read-only records. */
+typedef struct BuildJob {
+    int          kind;          /* 0 = BST, 1 = AVL, 2 = TBT, 3 = trie */
+    WordRecord **recs;
+    int          n;
+    BSTNode    **bst_root;
+    AVLNode    **avl_root;
+    TBTNode     *tbt_header;
+    Trie        *trie;
+} BuildJob;
+
+static void *build_job_main(void *arg) {
+    BuildJob *j = (BuildJob *)arg;
+    int       i;
+    switch (j->kind) {
+        case 0: *j->bst_root = bst_build_from_sorted(j->recs, j->n); break;
+        case 1: *j->avl_root = avl_build_from_sorted(j->recs, j->n); break;
+        case 2: tbt_build_from_sorted(j->tbt_header, j->recs, j->n); break;
+        default:
+            for (i = 0; i < j->n; i++) trie_insert(j->trie, j->recs[i]);
+    }
+    return NULL;
+}
+
+void load_build_sorted(WordRecord **recs, int n, BSTNode **bst_root,
+                       AVLNode **avl_root, TBTNode *tbt_header, Trie *trie) {
+    BuildJob jobs[4];
+    int      i, num_jobs = 0;
+
+    for (i = 0; i < 4; i++) {
+        if (i == 0 && !bst_root)   continue;
+        if (i == 1 && !avl_root)   continue;
+        if (i == 2 && !tbt_header) continue;
+        if (i == 3 && !trie)       continue;
+        jobs[num_jobs].kind       = i;
+        jobs[num_jobs].recs       = recs;
+        jobs[num_jobs].n          = n;
+        jobs[num_jobs].bst_root   = bst_root;
+        jobs[num_jobs].avl_root   = avl_root;
+        jobs[num_jobs].tbt_header = tbt_header;
+        jobs[num_jobs].trie       = trie;
+        num_jobs++;
+    }
+    run_jobs(build_job_main, jobs, sizeof(BuildJob), num_jobs);
+}
+
+/* avl_inorder callback: append the record to the array behind arg. */
+static void collect_cb(AVLNode *node, void *arg) {
+    WordRecord ***out = (WordRecord ***)arg;
+    *(*out)++ = node->rec;
+}
+
+/*
+ * Empty every index that is passed and bulk-build them all again over
+ * recs[0..n), sorted and unique: one O(n) rebuild in place of a batch of
+ * rebalancing inserts or deletes.  The records themselves stay put.
+ */
+static void rebuild_all(WordRecord **recs, int n, BSTNode **bst_root,
+                        AVLNode **avl_root, TBTNode *tbt_header, Trie *trie) {
+    if (bst_root)   bst_free(bst_root);
+    avl_free(avl_root);
+    if (tbt_header) tbt_clear(tbt_header);
+    if (trie)       trie_free(trie);
+    load_build_sorted(recs, n, bst_root, avl_root, tbt_header, trie);
+}
+
+/*
+ * Sort the n stored records once, drop later duplicates (and, if the
+ * trees already hold words, the records for words they hold), and index
+ * the rest.  Empty trees are built from the sorted run: linear balanced
+ * builds for BST, AVL and TBT instead of n rebalancing inserts, and
+ * in-order trie inserts.  A batch of at least 1/BULK_REBUILD_DIV of the
+ * words already there is merged with them in order (the AVL is walked
+ * once) and every tree rebuilt over the merged run; a smaller one is
+ * inserted record by record, as is everything if the scratch array
+ * cannot be allocated.  Returns the number of records kept.
+ */
+static int bulk_build(LoadEntry *ents, int n, RecordStore *store,
+                      BSTNode **bst_root, AVLNode **avl_root,
+                      TBTNode *tbt_header, Trie *trie) {
+    WordRecord **recs, **all, **out;
+    int          i, j, w, kept = 0;
+    int          have = avl_count(*avl_root);
+
+    qsort(ents, (size_t)n, sizeof(LoadEntry), load_entry_cmp);
+
+    recs = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *));
+    if (!recs) {
+        for (i = 0; i < n; i++)
+            kept += index_record(ents[i].rec, store, bst_root, avl_root,
+                                 tbt_header, trie);
+        return kept;
+    }
+
+    for (i = 0; i < n; i++) {
+        WordRecord *r = ents[i].rec;
+        if ((kept > 0 && strcmp(r->word, recs[kept - 1]->word) == 0) ||
+            (have > 0 && store_find(store, r->word) != r))
+            store_release(store, r);          /* later duplicate */
+        else
+            recs[kept++] = r;
+    }
+
+    all = have <= 0 || (long)kept * BULK_REBUILD_DIV < (long)have ? NULL :
+          (WordRecord **)malloc((size_t)(have + kept) * sizeof(WordRecord *));
+    if (have <= 0) {
+        load_build_sorted(recs, kept, bst_root, avl_root, tbt_header, trie);
+    } else if (!all) {
+        for (i = 0; i < kept; i++)
+            index_record(recs[i], store, bst_root, avl_root, tbt_header, trie);
+    } else {
+        /* The old words go to all[kept..), then both runs merge forward
+           into all[0..): the write index never passes the old read index */
+        out = all + kept;
+        avl_inorder(*avl_root, collect_cb, &out);
+        for (i = j = w = 0; w < have + kept; w++) {
+            if (j == kept || (i < have && strcmp(all[kept + i]->word, recs[j]->word) < 0))
+                all[w] = all[kept + i++];
+            else
+                all[w] = recs[j++];
+        }
+        rebuild_all(all, have + kept, bst_root, avl_root, tbt_header, trie);
+        free(all);
+    }
+    free(recs);
+    return kept;
+}
+
+/* ── Parallel bulk load ──────────────────────────────────────── */
+
+/* One slice of the file, parsed and later sorted by its own worker. */
+typedef struct LoadChunk {
+    const char *begin, *end;    /* whole lines only                     */
+    WordFields *fields;         /* parse output, in file order          */
+    int         num_fields, cap_fields;
+    int         failed;         /* parse ran out of memory              */
+    LoadEntry  *ents;           /* its run of the shared entry array    */
+    int         num_ents;
+} LoadChunk;
+
+static void *parse_chunk_main(void *arg) {
+    LoadChunk  *c = (LoadChunk *)arg;
+    const char *p, *nl;
+    WordFields  f;
+
+    for (p = c->begin; p < c->end; p = nl < c->end ? nl + 1 : c->end) {
+        nl = (const char *)memchr(p, '\n', (size_t)(c->end - p));
+        if (!nl) nl = c->end;
+        if (!parse_word_fields(p, nl, &f)) continue;
+
+        if (c->num_fields == c->cap_fields) {
+            int         cap   = c->cap_fields ? c->cap_fields * 2 : 1024;
+            WordFields *grown = (WordFields *)realloc(c->fields,
+                                                      (size_t)cap * sizeof(WordFields));
+            if (!grown) { c->failed = 1; return NULL; }
+            c->fields     = grown;
+            c->cap_fields = cap;
+        }
+        c->fields[c->num_fields++] = f;
+    }
+    return NULL;
+}
+
+static void *sort_chunk_main(void *arg) {
+    LoadChunk *c = (LoadChunk *)arg;
+    qsort(c->ents, (size_t)c->num_ents, sizeof(LoadEntry), load_entry_cmp);
+    return NULL;
+}
+
+/*
+ * Bulk load of a large buffer on LOAD_THREADS workers:
+ *   1. parse    — one chunk of whole lines per worker, into slices
+ *   2. store    — this thread adds the records in file order (the store
+ *                 is single-threaded; this is one copy per record)
+ *   3. sort     — each worker sorts its own chunk's records
+ *   4. merge    — k-way merge of the sorted runs, dropping duplicates
+ *   5. build    — BST, AVL, TBT and trie built concurrently
+ * Returns the number of records kept, or -1 if the parse could not be
+ * done (nothing is stored then, and the caller loads serially).
+ */
+static int load_parallel(const char *buf, const char *end, RecordStore *store,
+                         LazyText *lazy, BSTNode **bst_root, AVLNode **avl_root,
+                         TBTNode *tbt_header, Trie *trie) {
+    LoadChunk    chunks[LOAD_THREADS];
+    LoadEntry   *ents;
+    WordRecord **recs;
+    int          head[LOAD_THREADS];
+    int          k, i, j, total = 0, seq = 0, kept = 0, failed = 0;
+    size_t       step = (size_t)(end - buf) / LOAD_THREADS;
+    const char  *p    = buf;
+
+    /* Chunk boundaries moved forward to the next line start */
+    memset(chunks, 0, sizeof(chunks));
+    for (k = 0; k < LOAD_THREADS; k++) {
+        const char *e = k == LOAD_THREADS - 1 ? end : p + step;
+        if (e > end) e = end;
+        if (e < end) {
+            const char *nl = (const char *)memchr(e, '\n', (size_t)(end - e));
+            e = nl ? nl + 1 : end;
+        }
+        chunks[k].begin = p;
+        chunks[k].end   = e;
+        p = e;
+    }
+
+    run_jobs(parse_chunk_main, chunks, sizeof(LoadChunk), LOAD_THREADS);
+    for (k = 0; k < LOAD_THREADS; k++) {
+        failed |= chunks[k].failed;
+        total  += chunks[k].num_fields;
+    }
+    ents = failed ? NULL : (LoadEntry *)malloc((size_t)(total ? total : 1) * sizeof(LoadEntry));
+    recs = ents ? (WordRecord **)malloc((size_t)(total ? total : 1) * sizeof(WordRecord *)) : NULL;
+    if (!recs) {
+        for (k = 0; k < LOAD_THREADS; k++) free(chunks[k].fields);
+        free(ents);
+        return -1;
+    }
+
+    /* Store in file order; a store failure ends the load there, as in
+       the serial loader */
+    for (k = 0; k < LOAD_THREADS; k++) {
+        chunks[k].ents = ents + seq;
+        for (i = 0; i < chunks[k].num_fields && !failed; i++) {
+            const WordFields *f = &chunks[k].fields[i];
+            WordRecord *stored = add_fields(store, lazy, buf, f);
+            if (!stored) { failed = 1; break; }
+            ents[seq].rec = stored;
+            ents[seq].seq = seq;
+            seq++;
+            chunks[k].num_ents++;
+        }
+        free(chunks[k].fields);
+    }
+
+    run_jobs(sort_chunk_main, chunks, sizeof(LoadChunk), LOAD_THREADS);
+
+    /* Merge: smallest head each step; ties go to the lower seq, so the
+       first copy of a word is the one kept */
+    for (k = 0; k < LOAD_THREADS; k++) head[k] = 0;
+    for (;;) {
+        const LoadEntry *e;
+        j = -1;
+        for (k = 0; k < LOAD_THREADS; k++) {
+            if (head[k] == chunks[k].num_ents) continue;
+            if (j < 0 || load_entry_cmp(&chunks[k].ents[head[k]],
+                                        &chunks[j].ents[head[j]]) < 0)
+                j = k;
+        }
+        if (j < 0) break;
+        e = &chunks[j].ents[head[j]++];
+        if (kept > 0 && strcmp(e->rec->word, recs[kept - 1]->word) == 0)
+            store_release(store, e->rec);     /* later duplicate */
+        else
+            recs[kept++] = e->rec;
+    }
+    free(ents);
+
+    load_build_sorted(recs, kept, bst_root, avl_root, tbt_header, trie);
+    free(recs);
+    return kept;
+}
+
+/* ── JSONL helpers ───────────────────────────────────────────── */
+
+/* POS rank of a record read from the current JSONL file, by slot id;
+   JSONL_RANK_NONE for records that were in the store before */
+#define JSONL_RANK_NONE  0xFF
+
+/* Does path end in ext (lowercase, with the dot), in any case? */
+static int has_extension(const char *path, const char *ext) {
+    size_t len = strlen(path), n = strlen(ext), i;
+    if (len < n) return 0;
+    for (i = 0; i < n; i++) {
+        char c = path[len - n + i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != ext[i]) return 0;
+    }
+    return 1;
+}
+
+static TextSlice slice_of(const char *s) {
+    TextSlice t;
+    t.ptr = s;
+    t.len = strlen(s);
+    return t;
+}
+
+/* One entry read from a dump part; its meaning is in the part's text. */
+typedef struct JsonlItem {
+    char        word[MAX_WORD_LEN];
+    const char *pos;
+    size_t      meaning;        /* offset into JsonlPart.text              */
+    int         priority;
+} JsonlItem;
+
+/* One byte range of a dump (jsonl_open_part), read by its own worker. */
+typedef struct JsonlPart {
+    const char  *path;
+    int          part, parts;
+    JsonlItem   *items;         /* in file order                           */
+    int          num_items, cap_items;
+    char        *text;
+    size_t       text_len, text_cap;
+    JsonlCounts  counts;        /* gloss words of every line of the part   */
+    int          failed;        /* -1: cannot open, 1: out of memory       */
+} JsonlPart;
+
+static void *jsonl_part_main(void *arg) {
+    JsonlPart  *p = (JsonlPart *)arg;
+    JsonlReader rd;
+    JsonlEntry  e;
+    JsonlItem  *it;
+    size_t      len;
+    int         r;
+
+    if (jsonl_open_part(&rd, p->path, p->part, p->parts) != 0) {
+        p->failed = -1;
+        return NULL;
+    }
+    rd.counts = &p->counts;
+    while ((r = jsonl_next(&rd, &e)) == 1) {
+        len = strlen(e.meaning) + 1;
+        if (p->num_items == p->cap_items) {
+            int        cap   = p->cap_items ? p->cap_items * 2 : 1024;
+            JsonlItem *grown = (JsonlItem *)realloc(p->items, (size_t)cap * sizeof(JsonlItem));
+            if (!grown) break;
+            p->items     = grown;
+            p->cap_items = cap;
+        }
+        if (p->text_cap - p->text_len < len) {
+            size_t cap = p->text_cap ? p->text_cap * 2 : 65536;
+            char  *grown;
+            while (cap - p->text_len < len) cap *= 2;
+            if (!(grown = (char *)realloc(p->text, cap))) break;
+            p->text     = grown;
+            p->text_cap = cap;
+        }
+        it = &p->items[p->num_items++];
+        memcpy(it->word, e.word, strlen(e.word) + 1);
+        memcpy(p->text + p->text_len, e.meaning, len);
+        it->pos      = e.pos;
+        it->meaning  = p->text_len;
+        it->priority = e.priority;
+        p->text_len += len;
+    }
+    if (r != 0 || p->counts.failed) p->failed = 1;
+    jsonl_close(&rd);
+    return NULL;
+}
+
+/* log2(v) in 8.8 fixed point, for v >= 1: the index of the top bit, and
+   the bits below it as the fraction (a straight line between powers). */
+static uint64_t log2_q8(uint64_t v) {
+    uint64_t b = 0;
+    while (v >> (b + 1)) b++;
+    return (b << 8) | ((b >= 8 ? v >> (b - 8) : v << (8 - b)) & 0xFF);
+}
+
+/*
+ * Score of a word used `hits` times in the dump's glosses, when the most
+ * used word is used `top` times: log-scaled onto 1..FREQ_CORPUS_TOP, so
+ * each doubling of use is worth about the same.  Unused words get
+ * FREQ_SCORE_DEFAULT.
+ */
+static int corpus_score(uint64_t hits, uint64_t top) {
+    if (hits == 0 || top == 0) return FREQ_SCORE_DEFAULT;
+    return 1 + (int)((FREQ_CORPUS_TOP - 1) * log2_q8(hits + 1) / log2_q8(top + 1));
+}
+
+/* ── Frequency join ──────────────────────────────────────────── */
+
+/* One word,score line; word is lowercased and NUL-terminated in place
+   inside the file buffer. */
+typedef struct FreqEntry {
+    const char *word;
+    int         score;
+} FreqEntry;
+
+/*
+ * Parse the line [b, e) of a frequency file into e, rewriting the word in
+ * place (lowercase, cut at MAX_WORD_LEN - 1 like a DictKey).  Returns 1
+ * for a usable line, 0 for one to skip.
+ */
+static int parse_freq_line(char *b, char *e, FreqEntry *out) {
+    TextSlice line = slice_trim(b, e), word, num;
+    const char *comma;
+    char       *w;
+    size_t      i, n;
+    int         score;
+
+    /* Skip blank lines and comment lines */
+    if (line.len == 0 || line.ptr[0] == '#') return 0;
+
+    comma = (const char *)memchr(line.ptr, ',', line.len);
+    if (!comma) return 0;   /* malformed line — skip */
+
+    word = slice_trim(line.ptr, comma);
+    num  = slice_trim(comma + 1, line.ptr + line.len);
+    if (word.len == 0 || num.len == 0) return 0;
+
+    score = slice_atoi(num);
+    if (score <= 0)              score = FREQ_SCORE_DEFAULT;
+    if (score > FREQ_SCORE_MAX)  score = FREQ_SCORE_MAX;
+
+    /* The score is read, so the byte after the word may be overwritten */
+    w = b + (word.ptr - b);
+    n = word.len < MAX_WORD_LEN - 1 ? word.len : MAX_WORD_LEN - 1;
+    for (i = 0; i < n; i++)
+        if (w[i] >= 'A' && w[i] <= 'Z') w[i] = (char)(w[i] + 32);
+    w[n] = '\0';
+
+    out->word  = w;
+    out->score = score;
+    return 1;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int load_words(const char *path, RecordStore *store, BSTNode **bst_root,
+               AVLNode **avl_root, TBTNode *tbt_header, Trie *trie) {
+    char       *buf;
+    const char *p, *end, *nl;
+    long        len;
+    WordFields  f;
+    WordRecord *stored;
+    LoadEntry  *ents = NULL;
+    LazyText   *lazy;
+    int         num_ents = 0, cap_ents = 0;
+    int         bulk, empty;
+    int         count = 0;
+
+    /* bst_root, tbt_header and trie index the same stored records as the AVL */
+    if (!store || !avl_root) return -1;
+    if (path && has_extension(path, ".jsonl"))
+        return load_jsonl(path, store, bst_root, avl_root, tbt_header, trie);
+    if (path && has_extension(path, ".sdz"))
+        return load_packed(path, store, bst_root, avl_root, tbt_header, trie);
+
+    buf = read_file(path, &len);
+    if (!buf) return len < 0 ? -1 : 0;
+    lazy = open_lazy(path, 0, buf, len, 0, store);
+
+    /* Collect first and build (or merge) once at the end */
+    bulk  = 1;
+    empty = (!bst_root || !*bst_root) && !*avl_root &&
+            (!tbt_header || tbt_count(tbt_header) == 0) &&
+            (!trie || trie_count(trie) == 0);
+
+    /* Large files into empty trees: parse, sort and build on workers */
+    end = buf + len;
+    if (empty && len >= LOAD_PARALLEL_MIN_BYTES) {
+        count = load_parallel(buf, end, store, lazy, bst_root, avl_root,
+                              tbt_header, trie);
+        if (count >= 0) {
+            adopt_lazy(store, lazy);
+            free(buf);
+            return count;
+        }
+        count = 0;
+    }
+
+    /* One buffer, one pass: memchr to each newline, fields as slices */
+    for (p = buf; p < end; p = nl < end ? nl + 1 : end) {
+        nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        if (!parse_word_fields(p, nl, &f)) continue;
+
+        stored = add_fields(store, lazy, buf, &f);   /* lowercases */
+        if (!stored) break;
+
+        if (!bulk) {
+            count += index_record(stored, store, bst_root, avl_root,
+                                  tbt_header, trie);
+            continue;
+        }
+
+        if (num_ents == cap_ents) {
+            int        cap   = cap_ents ? cap_ents * 2 : 1024;
+            LoadEntry *grown = (LoadEntry *)realloc(ents, (size_t)cap * sizeof(LoadEntry));
+            if (!grown) {
+                /* Index what we have so far and carry on one by one */
+                count += bulk_build(ents, num_ents, store, bst_root, avl_root,
+                                    tbt_header, trie);
+                num_ents = 0;
+                bulk     = 0;
+                count += index_record(stored, store, bst_root, avl_root,
+                                      tbt_header, trie);
+                continue;
+            }
+            ents     = grown;
+            cap_ents = cap;
+        }
+        ents[num_ents].rec = stored;
+        ents[num_ents].seq = num_ents;
+        num_ents++;
+    }
+
+    if (num_ents > 0)
+        count += bulk_build(ents, num_ents, store, bst_root, avl_root,
+                            tbt_header, trie);
+
+    adopt_lazy(store, lazy);
+    free(ents);
+    free(buf);
+    return count;
+}
+
+int load_packed(const char *path, RecordStore *store, BSTNode **bst_root,
+                AVLNode **avl_root, TBTNode *tbt_header, Trie *trie) {
+    PackedDict   pd;
+    WordRecord   rec, *stored;
+    WordRecord **recs = NULL;
+    LazyText    *lazy;
+    int          n, i, bulk, num = 0, count = 0;
+
+    if (!store || !avl_root) return -1;
+    if (packed_open(&pd, path) != 0) return -1;
+    n    = packed_count(&pd);
+    lazy = open_lazy(path, 1, NULL, 0, n, store);
+
+    /* The file is sorted and unique: into empty trees, straight to the
+       bulk builds */
+    bulk = (!bst_root || !*bst_root) && !*avl_root &&
+           (!tbt_header || tbt_count(tbt_header) == 0) &&
+           (!trie || trie_count(trie) == 0);
+    if (bulk && n > 0) {
+        recs = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *));
+        if (!recs) bulk = 0;
+    }
+
+    /* In order, so each word and meaning block is decoded once — or,
+       lazily, only the words, each meaning left for its first read */
+    for (i = 0; i < n; i++) {
+        const char *ref = lazy ? lazytext_add(lazy, (uint64_t)i, 0) : NULL;
+        if (ref) {
+            if (packed_get_word(&pd, i, &rec) != 0) break;
+            rec.meaning = ref;
+        } else if (packed_get(&pd, i, &rec) != 0) {
+            break;
+        }
+        if (rec.user_select_count > 0)
+            rec.select_time = stamp_picks(-1, rec.user_select_count);
+        stored = ref ? store_add_borrowed(store, &rec) : store_add(store, &rec);
+        if (!stored) break;
+        if (!bulk) {
+            count += index_record(stored, store, bst_root, avl_root,
+                                  tbt_header, trie);
+        } else if (store_find(store, stored->word) != stored) {
+            store_release(store, stored);
         } else {
-            /* Simple format: word only */
-            str_safe_copy(rec.word, line, sizeof(rec.word));
+            recs[num++] = stored;
+        }
+    }
+
+    if (bulk) {
+        load_build_sorted(recs, num, bst_root, avl_root, tbt_header, trie);
+        count = num;
+    }
+    adopt_lazy(store, lazy);
+    free(recs);
+    packed_close(&pd);
+    return count;
+}
+
+/*
+ * Parts are read and parsed on LOAD_THREADS workers (one for a small
+ * file), then stored on this thread in file order, so the outcome is
+ * that of one reader going through the file: the same dedupe, the same
+ * gloss for each word.  The counts of every part are joined through the
+ * store's word index before any record is indexed, so the trees are
+ * built with the final scores.
+ */
+int load_jsonl(const char *path, RecordStore *store, BSTNode **bst_root,
+               AVLNode **avl_root, TBTNode *tbt_header, Trie *trie) {
+    JsonlPart      parts[LOAD_THREADS];
+    WordRecord    *stored, *first;
+    LoadEntry     *ents = NULL;
+    unsigned char *rank = NULL;
+    uint64_t      *hits, top = 0;
+    long long      size;
+    int            n, k, i, total = 0, num_ents = 0, cap_rank = 0;
+    int            count = 0, failed = 0, stop = 0;
+
+    if (!store || !avl_root) return -1;
+    if ((size = jsonl_file_size(path)) < 0) return -1;
+    n = size >= LOAD_PARALLEL_MIN_BYTES ? LOAD_THREADS : 1;
+
+    /* 1. parse — each worker its part: entries, and gloss word counts */
+    memset(parts, 0, sizeof(parts));
+    for (k = 0; k < n; k++) {
+        parts[k].path  = path;
+        parts[k].part  = k;
+        parts[k].parts = n;
+        jsonl_counts_init(&parts[k].counts);
+    }
+    run_jobs(jsonl_part_main, parts, sizeof(JsonlPart), n);
+    for (k = 0; k < n; k++) {
+        if (parts[k].failed < 0) stop = 1;
+        if (parts[k].failed > 0) failed = 1;
+        total += parts[k].num_items;
+    }
+    if (!stop) {
+        ents = (LoadEntry *)malloc((size_t)(total ? total : 1) * sizeof(LoadEntry));
+        if (!ents) fprintf(stderr, "[ERROR] load_jsonl: malloc failed\n");
+    }
+    if (!ents) {
+        for (k = 0; k < n; k++) {
+            free(parts[k].items);
+            free(parts[k].text);
+            jsonl_counts_free(&parts[k].counts);
         }
+        return -1;
+    }
 
-        /* Skip if word field is empty after trimming */
-        if (str_is_empty(rec.word)) continue;
+    /* 2. store — in file order; a store failure ends the load there */
+    for (k = 0; k < n; k++) {
+        for (i = 0; i < parts[k].num_items && !stop; i++) {
+            const JsonlItem *it      = &parts[k].items[i];
+            const char      *meaning = parts[k].text + it->meaning;
+
+            first = store_find(store, it->word);
+            if (first) {
+                /* Seen under another POS: the better-ranked one's gloss
+                   wins, but a word that was here before the file is left
+                   alone */
+                if (first->id < cap_rank && rank[first->id] != JSONL_RANK_NONE &&
+                    it->priority < rank[first->id]) {
+                    stored = store_add_fields(store, slice_of(it->word), slice_of(it->pos),
+                                              slice_of(meaning), FREQ_SCORE_DEFAULT, 0);
+                    if (!stored) { stop = 1; break; }
+                    first->meaning        = stored->meaning;
+                    first->part_of_speech = stored->part_of_speech;
+                    rank[first->id]       = (unsigned char)it->priority;
+                    store_release(store, stored);
+                }
+                continue;
+            }
 
-        /* Skip oversized words (word field was truncated to MAX_WORD_LEN-1) */
-        if (strlen(rec.word) >= MAX_WORD_LEN - 1 &&
-            strlen(line) >= MAX_WORD_LEN - 1) continue;
+            stored = store_add_fields(store, slice_of(it->word), slice_of(it->pos),
+                                      slice_of(meaning), FREQ_SCORE_DEFAULT, 0);
+            if (!stored) { stop = 1; break; }
+            if (stored->id >= cap_rank) {
+                int            cap   = cap_rank ? cap_rank * 2 : 4096;
+                unsigned char *grown;
+                while (cap <= stored->id) cap *= 2;
+                grown = (unsigned char *)realloc(rank, (size_t)cap);
+                if (!grown) {
+                    store_release(store, stored);
+                    stop = 1;
+                    break;
+                }
+                memset(grown + cap_rank, JSONL_RANK_NONE, (size_t)(cap - cap_rank));
+                rank     = grown;
+                cap_rank = cap;
+            }
+            rank[stored->id]   = (unsigned char)it->priority;
+            ents[num_ents].rec = stored;
+            ents[num_ents].seq = num_ents;
+            num_ents++;
+        }
+        free(parts[k].items);
+        free(parts[k].text);
+    }
 
-        bst_insert(bst_root, &rec);          /* normalises to lowercase internally */
-        *avl_root = avl_insert(*avl_root, &rec);
-        if (tbt_header) tbt_insert(tbt_header, &rec);
-        count++;
+    /* 3. rank — each new word by its use across all the parts' glosses */
+    hits = (uint64_t *)calloc((size_t)(cap_rank ? cap_rank : 1), sizeof(uint64_t));
+    for (k = 0; k < n; k++) {
+        const char   *word;
+        unsigned long c;
+        size_t        at = 0;
+        while (hits && jsonl_counts_next(&parts[k].counts, &at, &word, &c)) {
+            WordRecord *rec = store_find(store, word);
+            if (rec && rec->id < cap_rank && rank[rec->id] != JSONL_RANK_NONE)
+                hits[rec->id] += c;
+        }
+        jsonl_counts_free(&parts[k].counts);
+    }
+    if (hits) {
+        for (i = 0; i < num_ents; i++)
+            if (hits[ents[i].rec->id] > top) top = hits[ents[i].rec->id];
+        for (i = 0; i < num_ents; i++)
+            ents[i].rec->frequency_score = corpus_score(hits[ents[i].rec->id], top);
+    } else {
+        fprintf(stderr, "[WARN] load_jsonl: out of memory, words left unranked\n");
     }
+    if (failed)
+        fprintf(stderr, "[WARN] load_jsonl: out of memory, part of %s was not read\n", path);
 
-    fclose(fp);
+    /* 4. build — or merge into what is already there */
+    if (num_ents > 0)
+        count = bulk_build(ents, num_ents, store, bst_root, avl_root,
+                           tbt_header, trie);
+
+    free(hits);
+    free(ents);
+    free(rank);
     return count;
 }
 
-int load_frequencies(const char *path, BSTNode *bst_root,
-                     AVLNode *avl_root, TBTNode *tbt_header) {
-    FILE    *fp;
-    char     line[MAX_LINE_BUF];
-    char    *comma;
-    BSTNode *node;
-    int      score;
-    int      updated = 0;
+int load_delete_words(const char *const *words, int n, RecordStore *store,
+                      BSTNode **bst_root, AVLNode **avl_root,
+                      TBTNode *tbt_header, Trie *trie) {
+    WordRecord    **found, **keep = NULL, **out;
+    unsigned char  *dead;
+    int             i, removed = 0, have;
 
-    /* avl_root and tbt_header frequency fields are updated alongside BST */
+    if (!store || !avl_root || n <= 0 || !words) return 0;
+    have  = avl_count(*avl_root);
+    found = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *));
+    dead  = (unsigned char *)calloc((size_t)store->next_slot + 1, 1);
+    if (!found || !dead) {
+        fprintf(stderr, "[ERROR] load_delete_words: malloc failed\n");
+        free(found);
+        free(dead);
+        return -1;
+    }
 
-    fp = fopen(path, "r");
-    if (!fp) return -1;
+    /* Mark: one batched word-index probe per word; found[0..removed)
+       becomes the distinct records to drop */
+    store_find_batch(store, words, n, found);
+    for (i = 0; i < n; i++) {
+        WordRecord *r = found[i];
+        if (!r || dead[r->id]) continue;
+        dead[r->id]       = 1;
+        found[removed++] = r;
+    }
+
+    /* Sweep: a big batch keeps the survivors of one AVL walk and rebuilds
+       every tree over them; a small one is cheaper deleted word by word */
+    if (removed > 0 && (long)removed * BULK_REBUILD_DIV >= (long)have)
+        keep = (WordRecord **)malloc((size_t)(have ? have : 1) * sizeof(WordRecord *));
+    if (keep) {
+        int kept = 0;
+        out = keep;
+        avl_inorder(*avl_root, collect_cb, &out);
+        for (i = 0; i < have; i++)
+            if (!dead[keep[i]->id]) keep[kept++] = keep[i];
+        rebuild_all(keep, kept, bst_root, avl_root, tbt_header, trie);
+        free(keep);
+    } else {
+        for (i = 0; i < removed; i++) {
+            const char *w = found[i]->word;
+            if (bst_root) bst_delete(bst_root, w);
+            *avl_root = avl_delete(*avl_root, w);
+            if (tbt_header) tbt_delete(tbt_header, w);
+            if (trie)       trie_delete(trie, w);
+        }
+    }
 
-    while (fgets(line, (int)sizeof(line), fp)) {
-        str_trim(line);
+    for (i = 0; i < removed; i++) store_release(store, found[i]);
+    free(found);
+    free(dead);
+    return removed;
+}
+
+int load_delete_file(const char *path, RecordStore *store, BSTNode **bst_root,
+                     AVLNode **avl_root, TBTNode *tbt_header, Trie *trie) {
+    char        *buf, *p, *end, *nl;
+    const char **words = NULL;
+    long         len;
+    WordFields   f;
+    int          n = 0, cap = 0, removed;
 
-        /* Skip blank lines and comment lines */
-        if (str_is_empty(line) || line[0] == '#') continue;
+    buf = read_file(path, &len);
+    if (!buf) return len < 0 ? -1 : 0;
 
-        comma = strchr(line, ',');
-        if (!comma) continue;   /* malformed line — skip */
+    /* Each line's word, cut off in place (the line is parsed by then) */
+    end = buf + len;
+    for (p = buf; p < end; p = nl < end ? nl + 1 : end) {
+        nl = (char *)memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        if (!parse_word_fields(p, nl, &f)) continue;
+        if (n == cap) {
+            int          grown_cap = cap ? cap * 2 : 1024;
+            const char **grown     = (const char **)realloc(words,
+                                         (size_t)grown_cap * sizeof(const char *));
+            if (!grown) {
+                fprintf(stderr, "[ERROR] load_delete_file: malloc failed\n");
+                free(words);
+                free(buf);
+                return -1;
+            }
+            words = grown;
+            cap   = grown_cap;
+        }
+        buf[(f.word.ptr - buf) + (long)f.word.len] = '\0';
+        words[n++] = f.word.ptr;
+    }
+
+    removed = load_delete_words(words, n, store, bst_root, avl_root,
+                                tbt_header, trie);
+    free(words);
+    free(buf);
+    return removed;
+}
 
-        *comma = '\0';
-        str_trim(line);        /* word */
-        str_trim(comma + 1);   /* score string */
+int load_frequencies(const char *path, RecordStore *store, AVLNode *avl_root,
+                     Trie *trie) {
+    char       *buf;
+    char       *p, *end, *nl;
+    long        len;
+    FreqEntry   e;
+    DictKey     key;
+    WordRecord *rec;
+    int         updated = 0;
 
-        if (str_is_empty(line) || str_is_empty(comma + 1)) continue;
+    buf = read_file(path, &len);
+    if (!buf) return len < 0 ? -1 : 0;
 
-        score = atoi(comma + 1);
-        if (score <= 0)              score = FREQ_SCORE_DEFAULT;
-        if (score > FREQ_SCORE_MAX)  score = FREQ_SCORE_MAX;
+    /* One word-index probe per line, applied in file order, so the last
+       line for a word wins */
+    end = buf + len;
+    for (p = buf; p < end; p = nl < end ? nl + 1 : end) {
+        nl = (char *)memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        if (!parse_freq_line(p, nl, &e)) continue;
 
-        node = bst_search(bst_root, line);
-        if (node) {
-            AVLNode *avl_node = avl_search(avl_root, line);
-            TBTNode *tbt_node = tbt_header ? tbt_search(tbt_header, line) : NULL;
-            node->data.frequency_score = score;
-            if (avl_node) avl_node->data.frequency_score = score;
-            if (tbt_node) tbt_node->data.frequency_score = score;
+        dict_key_init(&key, e.word);
+        rec = store_find_normalized(store, &key);
+        if (rec) {
+            rec->frequency_score = e.score;
             updated++;
         }
     }
 
-    fclose(fp);
+    free(buf);
+    avl_rescore(avl_root);               /* one O(n) pass, not per word */
+    if (trie) trie_topk_rebuild(trie);
     return updated;
 }
 
-int save_custom_words(const char *path, BSTNode *bst_root) {
+int load_build_indexes(AVLNode *avl_root, BSTNode **bst_root,
+                       TBTNode *tbt_header, Trie *trie) {
+    WordRecord **recs, **out;
+    int          n = avl_count(avl_root);
+
+    if ((bst_root && *bst_root) ||
+        (tbt_header && tbt_count(tbt_header) > 0) ||
+        (trie && trie_count(trie) > 0))
+        return -1;
+
+    recs = (WordRecord **)malloc((size_t)(n ? n : 1) * sizeof(WordRecord *));
+    if (!recs) {
+        fprintf(stderr, "[ERROR] load_build_indexes: malloc failed\n");
+        return -1;
+    }
+    out = recs;
+    avl_inorder(avl_root, collect_cb, &out);   /* already sorted, unique */
+    load_build_sorted(recs, n, bst_root, NULL, tbt_header, trie);
+    free(recs);
+    return n;
+}
+
+int save_custom_words(const char *path, AVLNode *avl_root) {
+    char  tmp[512];
     FILE *fp;
 
-    fp = fopen(path, "w");
+    read_meanings(avl_root);
+    fp = save_open(path, tmp, sizeof(tmp));
     if (!fp) return -1;
 
     /*
-     * Use preorder (not inorder) traversal so the saved file re-creates
-     * the exact same BST structure when re-loaded.  Inorder produces a
-     * sorted (alphabetical) sequence; inserting 90 000 sorted words into
-     * BST and TBT builds fully right-skewed trees of depth 90 000, which
-     * causes O(n^2) TBT construction and stack overflows in all recursive
-     * BST operations on the next startup.  Preorder insertion recreates
-     * the same tree shape as the current session (height ~50), keeping all
-     * operations fast and safe.
+     * Use preorder (not inorder) traversal so the saved file rebuilds a
+     * balanced BST even when it is merged into a non-empty dictionary one
+     * insert at a time: inserting in the AVL's preorder reproduces its
+     * shape, while a sorted sequence inserted word by word builds a fully
+     * right-skewed BST of depth n.  (A load into an empty dictionary
+     * sorts and bulk-builds anyway, so the order does not matter there.)
      */
-    bst_preorder(bst_root, write_word_cb, fp);
+    write_preorder(fp, avl_root);
 
-    fclose(fp);
-    return 0;
+    return save_close(fp, tmp, path);
+}
+
+int save_custom_words_records(const char *path, const WordRecord *recs, int n) {
+    char  tmp[512];
+    FILE *fp;
+    int   i;
+
+    if (n < 0 || (n > 0 && !recs)) return -1;
+    for (i = 0; i < n; i++) word_record_meaning(&recs[i]);   /* as above */
+    fp = save_open(path, tmp, sizeof(tmp));
+    if (!fp) return -1;
+    write_balanced(fp, recs, 0, n);
+    return save_close(fp, tmp, path);
 }
@@ -6,9 +6,14 @@
 #include "bst.h"
 #include "avl.h"
 #include "tbt.h"
+#include "trie.h"
+#include "store.h"
 
 /*
- * Load words from a file into the BST (and AVL/TBT once implemented).
+ * Load words from a file into the record store, and index every new
+ * record in the AVL and in the BST, TBT and radix trie (bst_root,
+ * tbt_header and trie may be NULL, e.g. for indexes built lazily with
+ * load_build_indexes).
  *
  * Supported file formats (auto-detected per line):
  *   word|pos|meaning   -- rich format (pipe-delimited)
@@ -17,34 +22,136 @@
  *   # comment          -- skipped
  *   (blank line)       -- skipped
  *
+ * All records are read first and sorted once.  When every tree is still
+ * empty, BST/AVL/TBT are built perfectly balanced in O(n) from the sorted
+ * run.  Otherwise the file is merged: a batch of at least
+ * 1/BULK_REBUILD_DIV of the words already there is merged with them in
+ * order and every tree rebuilt once over the result, in O(n + m log m)
+ * for m new words; a smaller batch is inserted record by record.
+ *
  * Returns the number of words successfully inserted, or -1 on file open error.
- * Duplicates in the file are silently skipped by bst_insert.
+ * Duplicates (already in the trees, or earlier in the same file) are
+ * silently skipped and never stored; the first occurrence wins.
+ *
+ * A path ending in ".jsonl" is read with load_jsonl instead, and one
+ * ending in ".sdz" with load_packed.
+ */
+int load_words(const char *path, RecordStore *store, BSTNode **bst_root,
+               AVLNode **avl_root, TBTNode *tbt_header, Trie *trie);
+
+/*
+ * Ingest a kaikki.org JSONL dump (jsonl.h) straight into the store and
+ * trees, with the filters of preprocess_jsonl.py and no words.txt in
+ * between.  A dump of LOAD_PARALLEL_MIN_BYTES or more is read as
+ * LOAD_THREADS parts at once (jsonl_open_part), each holding its parsed
+ * entries until they are stored, in file order.  A word listed under
+ * several parts of speech keeps the gloss of the preferred one (noun,
+ * then verb, adjective, ...); words already in the trees are kept as
+ * they are.
+ *
+ * New records are ranked by the dump itself: how often each word is used
+ * in the definitions of all its entries (JsonlCounts), log-scaled so the
+ * most used word scores FREQ_CORPUS_TOP and unused ones
+ * FREQ_SCORE_DEFAULT — the range word_freq.txt is written in, so its
+ * hand-set scores can still override a few.  Bulk-built into empty trees
+ * like load_words.  Returns the number of words inserted, or -1 if the
+ * file cannot be opened or on malloc failure.
+ */
+int load_jsonl(const char *path, RecordStore *store, BSTNode **bst_root,
+               AVLNode **avl_root, TBTNode *tbt_header, Trie *trie);
+
+/*
+ * Load a packed dictionary (packed.h) into the store and trees, decoding
+ * it in order — each word and meaning block once.  The file is sorted
+ * and unique, so empty trees are bulk-built from it without a sort;
+ * otherwise each record is inserted and words already present are kept.
+ * Returns the number of words inserted, or -1 if the file is missing or
+ * malformed.
+ */
+int load_packed(const char *path, RecordStore *store, BSTNode **bst_root,
+                AVLNode **avl_root, TBTNode *tbt_header, Trie *trie);
+
+/*
+ * Bulk-build every index that is passed (any of the four may be NULL; each
+ * one passed must be empty) over recs[0..n), sorted by word with no
+ * duplicates.  The builds run concurrently — each tree type allocates
+ * from its own node pool — and BST, AVL and TBT come out perfectly
+ * balanced in O(n).
+ */
+void load_build_sorted(WordRecord **recs, int n, BSTNode **bst_root,
+                       AVLNode **avl_root, TBTNode *tbt_header, Trie *trie);
+
+/*
+ * Materialise indexes on demand: build the BST, TBT and/or trie (the
+ * non-NULL ones, which must be empty) over every record in the AVL, with
+ * one inorder walk and the O(n) bulk builds.  Returns the number of
+ * records indexed, or -1 if an index is not empty or on malloc failure.
  */
-int load_words(const char *path, BSTNode **bst_root,
-               AVLNode **avl_root, TBTNode *tbt_header);
+int load_build_indexes(AVLNode *avl_root, BSTNode **bst_root,
+                       TBTNode *tbt_header, Trie *trie);
+
+/*
+ * Delete the n words (any case; absent and repeated ones are skipped)
+ * from the store and every tree passed, which must be every tree that
+ * references the store's records.  The words are marked first, with one
+ * batched word-index probe each (store_find_batch).  If they are at
+ * least 1/BULK_REBUILD_DIV of the dictionary, the survivors are taken
+ * from one AVL walk and every tree is rebuilt over them (load_build_sorted),
+ * in O(n + m) in all instead of m rebalancing deletes per tree; fewer are
+ * deleted one by one.  The records are released once no tree holds them.
+ * Returns the number of words deleted, or -1 on malloc failure (nothing
+ * is deleted then).
+ */
+int load_delete_words(const char *const *words, int n, RecordStore *store,
+                      BSTNode **bst_root, AVLNode **avl_root,
+                      TBTNode *tbt_header, Trie *trie);
+
+/*
+ * load_delete_words over the words of the file at path: one per line, or
+ * the first field of lines in the load_words formats (so a dictionary
+ * file deletes its own words).  Comments and blank lines are skipped.
+ * Returns the number deleted, or -1 if the file cannot be opened.
+ */
+int load_delete_file(const char *path, RecordStore *store, BSTNode **bst_root,
+                     AVLNode **avl_root, TBTNode *tbt_header, Trie *trie);
 
 /*
  * Read comma-separated word,score pairs from path and update the
- * frequency_score field of matching BST nodes.
+ * frequency_score field of matching records (every index shares the
+ * store's records, so one update reaches all of them).  The file is read
+ * in one buffer and each line is one probe of the store's word index
+ * (store_find), so the refresh costs O(lines) whatever the dictionary
+ * size.  If a word appears on several lines, the last one wins.  The
+ * AVL's subtree max scores — and the trie's top-k caches, if trie is
+ * non-NULL — are rebuilt once at the end.
  *
  * File format (per line):
  *   word,score    -- integer score in range [1, FREQ_SCORE_MAX]
  *   # comment     -- skipped
  *   (blank line)  -- skipped
  *
- * Returns the number of nodes updated, or -1 on file open error.
- * Words not found in the tree are silently skipped.
+ * Returns the number of lines applied, or -1 on file open error.
+ * Words not in the store are silently skipped.
  */
-int load_frequencies(const char *path, BSTNode *bst_root,
-                     AVLNode *avl_root, TBTNode *tbt_header);
+int load_frequencies(const char *path, RecordStore *store, AVLNode *avl_root,
+                     Trie *trie);
 
 /*
- * Write all words in the BST (in sorted order) to path in pipe format:
- *   word|pos|meaning
+ * Write all words in the AVL (in preorder) to path in pipe format:
+ *   word|pos|meaning|freq|picks|select_time
  *
+ * (select_time: how recent the picks are, see dictionary.h; a line
+ * without it has its picks taken as made at load time.)
  * This snapshot can be reloaded via load_words() in a future session.
- * Returns 0 on success, -1 on file open error.
+ * The file is written beside path and renamed over it, so path is only
+ * replaced by a complete save.  Returns 0 on success, -1 if any write
+ * fails (path is then left as it was).
  */
-int save_custom_words(const char *path, BSTNode *bst_root);
+int save_custom_words(const char *path, AVLNode *avl_root);
+
+/* The same from recs[0..n), sorted by word (a copy of the tree in order),
+   written in the preorder of a balanced tree over them.  Saved the same
+   way: 0 only once the whole file has replaced path, else -1. */
+int save_custom_words_records(const char *path, const WordRecord *recs, int n);
 
 #endif /* LOADER_H */
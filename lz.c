@@ -0,0 +1,202 @@
+/* lz.c - Small LZ77 block compressor implementation */
+#include <stdlib.h>
+#include <string.h>
+#include "lz.h"
+
+#define LZ_WINDOW     65535u
+#define LZ_HASH_BITS  15
+#define LZ_HASH_SIZE  (1u << LZ_HASH_BITS)
+#define LZ_CHAIN_MAX  48       /* candidates tried per position */
+#define LZ_NIL        0xFFFFFFFFu
+
+/* ── Compression ─────────────────────────────────────────────── */
+
+static unsigned hash4(const unsigned char *p) {
+    unsigned v = (unsigned)p[0] | (unsigned)p[1] << 8 |
+                 (unsigned)p[2] << 16 | (unsigned)p[3] << 24;
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Write a length nibble's continuation bytes. */
+static unsigned char *put_length(unsigned char *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/* One sequence: lit_len literals from lit, then a match (match_len 0: none). */
+static unsigned char *put_sequence(unsigned char *op, const unsigned char *lit,
+                                   size_t lit_len, size_t offset, size_t match_len) {
+    size_t ml = match_len ? match_len - LZ_MIN_MATCH : 0;
+    unsigned char *token = op++;
+
+    *token = (unsigned char)((lit_len < 15 ? lit_len : 15) << 4 | (ml < 15 ? ml : 15));
+    if (lit_len >= 15) op = put_length(op, lit_len - 15);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (match_len) {
+        *op++ = (unsigned char)(offset & 0xFF);
+        *op++ = (unsigned char)(offset >> 8);
+        if (ml >= 15) op = put_length(op, ml - 15);
+    }
+    return op;
+}
+
+/* Compress buf[start..n): earlier bytes are history a match may reach into. */
+static size_t compress_range(const unsigned char *buf, size_t start, size_t n,
+                             unsigned char *dst) {
+    unsigned      *head, *prev;
+    unsigned char *op = dst;
+    size_t         i, anchor = start;
+
+    head = (unsigned *)malloc(LZ_HASH_SIZE * sizeof(unsigned));
+    prev = (unsigned *)malloc((n ? n : 1) * sizeof(unsigned));
+    if (!head || !prev) {
+        /* No memory for the chains: store everything as literals */
+        free(head);
+        free(prev);
+        return (size_t)(put_sequence(op, buf + start, n - start, 0, 0) - dst);
+    }
+    memset(head, 0xFF, LZ_HASH_SIZE * sizeof(unsigned));
+
+    /* Chain the history so the first bytes can match into it */
+    for (i = start > LZ_WINDOW ? start - LZ_WINDOW : 0; i + LZ_MIN_MATCH <= start; i++) {
+        unsigned h = hash4(buf + i);
+        prev[i] = head[h];
+        head[h] = (unsigned)i;
+    }
+    i = start;
+
+    while (i + LZ_MIN_MATCH <= n) {
+        unsigned h = hash4(buf + i), cand = head[h];
+        size_t   best_len = 0, best_off = 0;
+        int      tries = LZ_CHAIN_MAX;
+
+        /* Longest earlier match within the window */
+        while (cand != LZ_NIL && i - cand <= LZ_WINDOW && tries-- > 0) {
+            if (i + best_len < n && buf[cand + best_len] == buf[i + best_len]) {
+                size_t len = 0;
+                while (i + len < n && buf[cand + len] == buf[i + len]) len++;
+                if (len > best_len) {
+                    best_len = len;
+                    best_off = i - cand;
+                }
+            }
+            cand = prev[cand];
+        }
+        prev[i] = head[h];
+        head[h] = (unsigned)i;
+
+        if (best_len < LZ_MIN_MATCH) {
+            i++;
+            continue;
+        }
+        op = put_sequence(op, buf + anchor, i - anchor, best_off, best_len);
+
+        /* Chain the positions the match covers, so later matches find them */
+        for (i++, best_len--; best_len > 0; i++, best_len--) {
+            if (i + LZ_MIN_MATCH <= n) {
+                h       = hash4(buf + i);
+                prev[i] = head[h];
+                head[h] = (unsigned)i;
+            }
+        }
+        anchor = i;
+    }
+    op = put_sequence(op, buf + anchor, n - anchor, 0, 0);
+
+    free(head);
+    free(prev);
+    return (size_t)(op - dst);
+}
+
+size_t lz_bound(size_t n) {
+    return n + n / 255 + 16;
+}
+
+size_t lz_compress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap) {
+    if (cap < lz_bound(n)) return 0;
+    return compress_range(src, 0, n, dst);
+}
+
+size_t lz_compress_dict(const unsigned char *dict, size_t dict_len,
+                        const unsigned char *src, size_t n,
+                        unsigned char *dst, size_t cap) {
+    unsigned char *buf;
+    size_t         out;
+
+    if (cap < lz_bound(n)) return 0;
+    if (dict_len > LZ_WINDOW) {
+        dict     += dict_len - LZ_WINDOW;
+        dict_len  = LZ_WINDOW;
+    }
+    if (dict_len == 0) return compress_range(src, 0, n, dst);
+
+    /* The matcher wants one buffer: history first, then the block */
+    buf = (unsigned char *)malloc(dict_len + n);
+    if (!buf) return (size_t)(put_sequence(dst, src, n, 0, 0) - dst);
+    memcpy(buf, dict, dict_len);
+    memcpy(buf + dict_len, src, n);
+    out = compress_range(buf, dict_len, dict_len + n, dst);
+    free(buf);
+    return out;
+}
+
+/* ── Decompression ───────────────────────────────────────────── */
+
+/* Read a length continued past its nibble.  Returns 0 if truncated. */
+static int get_length(const unsigned char **ip, const unsigned char *end, size_t *len) {
+    unsigned char b;
+    do {
+        if (*ip >= end) return 0;
+        b     = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 1;
+}
+
+size_t lz_decompress_dict(const unsigned char *dict, size_t dict_len,
+                          const unsigned char *src, size_t n,
+                          unsigned char *dst, size_t cap) {
+    const unsigned char *ip = src, *end = src + n;
+    size_t               out = 0;
+
+    while (ip < end) {
+        unsigned char token = *ip++;
+        size_t        lit = token >> 4, ml = token & 15, off;
+
+        if (lit == 15 && !get_length(&ip, end, &lit)) return (size_t)-1;
+        if (lit > (size_t)(end - ip) || lit > cap - out) return (size_t)-1;
+        memcpy(dst + out, ip, lit);
+        ip  += lit;
+        out += lit;
+        if (ip == end) break;               /* the closing literal run */
+
+        if (end - ip < 2) return (size_t)-1;
+        off = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (ml == 15 && !get_length(&ip, end, &ml)) return (size_t)-1;
+        ml += LZ_MIN_MATCH;
+        if (off == 0 || off > out + dict_len || ml > cap - out) return (size_t)-1;
+
+        /* The part of the match still inside the preset dictionary */
+        while (ml > 0 && off > out) {
+            dst[out] = dict[dict_len - (off - out)];
+            out++;
+            ml--;
+        }
+        /* Byte by byte: a match may overlap its own output */
+        while (ml-- > 0) {
+            dst[out] = dst[out - off];
+            out++;
+        }
+    }
+    return out;
+}
+
+size_t lz_decompress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap) {
+    return lz_decompress_dict(NULL, 0, src, n, dst, cap);
+}
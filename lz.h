@@ -0,0 +1,51 @@
+/* lz.h - Small LZ77 block compressor for dictionary text */
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>   /* size_t */
+
+/*
+ * A byte-oriented LZ77 codec in the LZ4 mould, for blocks of up to a few
+ * hundred KB that are compressed once and decompressed many times.  The
+ * compressed block is a run of sequences:
+ *
+ *   [token][literal length ext...][literals][offset:2][match length ext...]
+ *
+ * token holds the literal count in its high nibble and the match length
+ * minus LZ_MIN_MATCH in its low one; a nibble of 15 continues in bytes of
+ * 255 followed by a final byte below 255.  The offset (1..65535, little
+ * endian) points back into the output.  The last sequence has literals
+ * only and ends the block.
+ *
+ * Compression searches hash chains over the last 64 KB, so it is slow
+ * next to decompression, which is a plain copy loop.
+ *
+ * Small blocks compress poorly on their own: there is little history to
+ * match against.  The _dict variants take a preset dictionary — sample
+ * text shared by every block — that the block's matches may reach back
+ * into as if it came just before it; decompression must pass the same
+ * bytes.  Only the last 64 KB of a dictionary are used.
+ */
+
+#define LZ_MIN_MATCH  4
+
+/* Largest compressed size of n bytes (incompressible input grows slightly). */
+size_t lz_bound(size_t n);
+
+/* Compress src[n] into dst[cap] (cap >= lz_bound(n)).  Returns the
+   compressed size, or 0 if cap is too small. */
+size_t lz_compress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap);
+
+/* Decompress src[n] into dst[cap].  Returns the decompressed size, or
+   (size_t)-1 if the block is malformed or does not fit. */
+size_t lz_decompress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap);
+
+/* As above, with dict[dict_len] as the history before the block. */
+size_t lz_compress_dict(const unsigned char *dict, size_t dict_len,
+                        const unsigned char *src, size_t n,
+                        unsigned char *dst, size_t cap);
+size_t lz_decompress_dict(const unsigned char *dict, size_t dict_len,
+                          const unsigned char *src, size_t n,
+                          unsigned char *dst, size_t cap);
+
+#endif /* LZ_H */
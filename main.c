@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "config.h"
 #include "dictionary.h"
@@ -9,9 +10,25 @@
 #include "bst.h"
 #include "avl.h"
 #include "tbt.h"
+#include "trie.h"
+#include "bpt.h"
+#include "bktree.h"
+#include "suffix.h"
+#include "fulltext.h"
+#include "store.h"
 #include "loader.h"
+#include "snapshot.h"
+#include "journal.h"
 #include "autocomplete.h"
+#include "prefix_cache.h"
 #include "benchmark.h"
+#include "histogram.h"
+#include "querylog.h"
+#include "stats.h"
+#include "memusage.h"
+#include "shape.h"
+#include "federation.h"
+#include "image.h"
 
 /* ── Forward declarations ────────────────────────────────────── */
 static void menu_search_word(void);
@@ -23,20 +40,265 @@ static void menu_load_from_file(void);
 static void menu_switch_tree(void);
 static void menu_benchmark(void);
 static void menu_about(void);
+static void menu_engine_stats(void);
+static void menu_tree_shape(void);
+static void finish_save(int wait);
+static void ensure_fuzzy_index(void);
+static int  run_headless(int argc, char **argv);
 
 /* ── Global tree state ───────────────────────────────────────── */
+static RecordStore g_store;            /* owns every WordRecord */
 static BSTNode *g_bst_root   = NULL;
 static AVLNode *g_avl_root   = NULL;
 static TBTNode *g_tbt_header = NULL;
-static int      g_active_tree = 1;    /* 1=BST, 2=AVL, 3=TBT */
+static int      g_bst_rebuilds = 0;   /* automatic BST rebalances (shape.h) */
+static Trie     g_trie;               /* radix trie over the same records */
+static BPTree   g_bpt;                /* B+-tree over the same records */
+static PrefixCache g_cache;           /* hot autocomplete answers */
+static BKTree   g_bk;                 /* edit-distance index for "did you mean" */
+static int      g_bk_built    = 0;    /* g_bk holds every word (else empty) */
+static SuffixIndex g_sfx = SUFFIX_INDEX_INIT;  /* "*text" search; dropped on writes */
+static FullTextIndex g_fts = FULLTEXT_INIT;   /* "?terms" search; dropped on writes */
+static int      g_active_tree = 1;    /* 1=BST, 2=AVL, 3=TBT, 4=Trie, 5=B+ */
 static int      g_word_count  = 0;
+static Journal  g_journal;            /* changes since the last full save */
+static int      g_save_all    = 0;    /* base replaced: the journal does not cover it */
+static QueryRecorder g_recorder = QUERY_RECORDER_INIT;  /* --record: queries served */
+
+/*
+ * Indexes currently built, one bit per tree number (1u << g_active_tree).
+ * The AVL is always built: loading, ranking updates and saving look
+ * records up in it.  With LAZY_INDEXES the others are only built while
+ * they are, or once have been, the active tree; otherwise all five are.
+ */
+static unsigned g_built = 0;
+
+#define INDEX_BIT(tree)  (1u << (tree))
+#define IS_BUILT(tree)   ((g_built & INDEX_BIT(tree)) != 0)
+#define ALL_INDEXES      (INDEX_BIT(1) | INDEX_BIT(2) | INDEX_BIT(3) | \
+                          INDEX_BIT(4) | INDEX_BIT(5))
+
+/* The index arguments for loader / update calls: NULL when not built */
+static BSTNode **bst_slot(void)  { return IS_BUILT(1) ? &g_bst_root  : NULL; }
+static TBTNode  *tbt_slot(void)  { return IS_BUILT(3) ? g_tbt_header : NULL; }
+static Trie     *trie_slot(void) { return IS_BUILT(4) ? &g_trie      : NULL; }
+
+static unsigned initial_indexes(void) {
+#if LAZY_INDEXES
+    return INDEX_BIT(2) | INDEX_BIT(g_active_tree);
+#else
+    return ALL_INDEXES;
+#endif
+}
+
+/* Build the active tree from the AVL if it has not been built yet.
+   Returns 0 on success, -1 if it could not be built. */
+static int ensure_active_index(void) {
+    int t = g_active_tree;
+    if (IS_BUILT(t)) return 0;
+    if (t == 5) {
+        if (bpt_build(&g_bpt, g_avl_root) < 0) return -1;
+    } else if (load_build_indexes(g_avl_root, t == 1 ? &g_bst_root  : NULL,
+                                              t == 3 ? g_tbt_header : NULL,
+                                              t == 4 ? &g_trie      : NULL) < 0) {
+        return -1;
+    }
+    g_built |= INDEX_BIT(t);
+    return 0;
+}
+
+/*
+ * The loader fills the BST, AVL, TBT and trie; a wanted B+-tree is
+ * bulk-built from the AVL once a load into the empty dictionary is done.
+ * If that fails the B+-tree is dropped (and the AVL takes over if it was
+ * the active tree).
+ */
+static void finish_load(void) {
+    prefix_cache_clear(&g_cache);      /* frequencies may all have moved */
+    if (IS_BUILT(1) && bst_rebalance_if_deep(&g_bst_root, bst_height(g_bst_root)))
+        g_bst_rebuilds++;              /* a merge of a sorted file skews it */
+    if (!IS_BUILT(5) || bpt_count(&g_bpt) > 0) return;
+    if (bpt_build(&g_bpt, g_avl_root) < 0) {
+        g_built &= ~INDEX_BIT(5);
+        if (g_active_tree == 5) g_active_tree = 2;
+    }
+#if !LAZY_INDEXES
+    ensure_fuzzy_index();
+    suffix_build(&g_sfx, g_avl_root);
+    fulltext_build(&g_fts, g_avl_root);
+#endif
+}
+
+/* Build the BK-tree from the AVL on first use: only a prefix with no
+   completions ever needs it. */
+static void ensure_fuzzy_index(void) {
+    if (g_bk_built) return;
+    bk_build(&g_bk, g_avl_root);
+    g_bk_built = 1;
+}
+
+/* Words containing text, from the suffix array: built on first use after
+   a load or a write, since any insert or delete drops it.  Returns -1 if
+   it cannot be built. */
+static int substring_search(const char *text, WordRecord *results, int top_k) {
+    if (g_sfx.n == 0 && suffix_build(&g_sfx, g_avl_root) != 0) return -1;
+    return suffix_search(&g_sfx, text, results, top_k);
+}
+
+/* Words whose definition holds every term of query, from the inverted
+   index (built on first use, like the suffix array).  *total receives
+   the number of matches.  Returns -1 if it cannot be built. */
+static int definition_search(const char *query, WordRecord *results, int top_k,
+                             int *total) {
+    if (g_fts.words == 0 && fulltext_build(&g_fts, g_avl_root) != 0) return -1;
+    return fulltext_search(&g_fts, query, results, top_k, total);
+}
 
 static const char *active_tree_name(void) {
     if (g_active_tree == 2) return "AVL";
     if (g_active_tree == 3) return "TBT";
+    if (g_active_tree == 4) return "Trie";
+    if (g_active_tree == 5) return "B+";
     return "BST";
 }
 
+/*
+ * Drop every index and their records in one go, leaving an empty TBT
+ * header, trie, B+-tree and BK-tree.  The node pools keep their slabs, so the reload that follows
+ * does not go back to malloc for nodes.
+ */
+static void reset_dictionary(void) {
+    finish_save(1);                    /* it reads the records being freed */
+    bst_pool_reset();
+    avl_pool_reset();
+    tbt_pool_reset();
+    trie_free(&g_trie);
+    bpt_free(&g_bpt);
+    bk_free(&g_bk);
+    g_bk_built   = 0;
+    suffix_free(&g_sfx);
+    fulltext_free(&g_fts);
+    g_bst_root   = NULL;
+    g_avl_root   = NULL;
+    g_tbt_header = tbt_create_header();
+    store_free(&g_store);
+    prefix_cache_clear(&g_cache);
+    g_word_count = 0;
+    g_built      = initial_indexes();
+}
+
+/* ── Changes ─────────────────────────────────────────────────── */
+
+/*
+ * The three kinds of change, applied to the store and every built index.
+ * The menus log each one to the journal after making it; replay at start
+ * up goes through the same functions.
+ */
+
+/* Insert a copy of rec.  Returns the stored record, or NULL if the word
+   is already there. */
+static WordRecord *dict_insert(const WordRecord *rec) {
+    WordRecord *stored = store_add(&g_store, rec);
+    if (!stored || store_find(&g_store, stored->word) != stored) {
+        store_release(&g_store, stored);   /* duplicate — drop the new copy */
+        return NULL;
+    }
+    g_avl_root = avl_insert(g_avl_root, stored);
+    if (IS_BUILT(1) && bst_insert(&g_bst_root, stored) &&
+        bst_rebalance_if_deep(&g_bst_root, bst_depth(g_bst_root, stored->word)))
+        g_bst_rebuilds++;
+    if (IS_BUILT(3)) tbt_insert(g_tbt_header, stored);
+    if (IS_BUILT(4)) trie_insert(&g_trie, stored);
+    if (IS_BUILT(5)) bpt_insert(&g_bpt, stored);
+    if (g_bk_built)  bk_insert(&g_bk, stored);
+    suffix_free(&g_sfx);               /* stale until the next "*" / "?" query */
+    fulltext_free(&g_fts);
+    prefix_cache_invalidate_word(&g_cache, stored->word);
+    return stored;
+}
+
+/* Delete word.  Returns 1 if it was there, else 0. */
+static int dict_delete(const char *word) {
+    WordRecord *rec = store_find(&g_store, word);
+    if (!rec) return 0;
+    prefix_cache_invalidate_word(&g_cache, rec->word);
+    g_avl_root = avl_delete(g_avl_root, word);
+    if (IS_BUILT(1)) bst_delete(&g_bst_root, word);
+    if (IS_BUILT(3)) tbt_delete(g_tbt_header, word);
+    if (IS_BUILT(4)) trie_delete(&g_trie, word);
+    if (IS_BUILT(5)) bpt_delete(&g_bpt, word);
+    if (g_bk_built)  bk_delete(&g_bk, word);
+    suffix_free(&g_sfx);
+    fulltext_free(&g_fts);
+    store_release(&g_store, rec);      /* no tree references it now */
+    return 1;
+}
+
+/* Set word's pick count and stamp, keeping the ranking aggregates exact.
+   A stamp of 0 with picks (a log from before picks were stamped) takes
+   them as made now. */
+static void dict_set_picks(const char *word, int picks, int select_time) {
+    WordRecord *rec = store_find(&g_store, word);
+    if (!rec) return;
+    prefix_cache_invalidate_word(&g_cache, rec->word);
+    rec->user_select_count = picks;
+    rec->select_time       = select_time || picks <= 0 ? select_time
+                                                       : score_add_picks(0, picks, score_minutes());
+    store_track_decay(&g_store, rec);
+    avl_score_changed(g_avl_root, rec);
+    if (IS_BUILT(4)) trie_score_changed(&g_trie, rec);
+}
+
+/* JournalOps over the helpers above */
+static void replay_insert(const WordRecord *rec, void *arg) { (void)arg; dict_insert(rec); }
+static void replay_remove(const char *word, void *arg)      { (void)arg; dict_delete(word); }
+static void replay_picks(const char *word, int picks, int select_time, void *arg) {
+    (void)arg;
+    dict_set_picks(word, picks, select_time);
+}
+
+/*
+ * Write the whole dictionary out and empty the journal.  Returns 0, or
+ * -1 if it could not be saved (the journal is kept).
+ */
+static int save_dictionary(void) {
+    if (!g_avl_root) return 0;   /* an empty dictionary would not load back */
+    if (journal_compact(&g_journal, g_avl_root, FILE_CUSTOM_WORDS, FILE_SNAPSHOT) != 0)
+        return -1;
+    g_save_all = 0;
+    return 0;
+}
+
+/*
+ * Complete a background save (started by save_if_due) if it is done, or
+ * with wait set, once it is.  Must run before the store is freed.
+ */
+static void finish_save(int wait) {
+    if (!journal_compact_running(&g_journal)) return;
+    if (!wait && !journal_compact_finished(&g_journal)) return;
+    if (journal_compact_end(&g_journal) == 0)
+        g_save_all = 0;
+    else
+        printf("  Warning: could not save to %s\n", FILE_CUSTOM_WORDS);
+}
+
+/*
+ * After a change: save everything if the journal has grown past
+ * JOURNAL_COMPACT_BYTES, an append failed, or the dictionary was
+ * replaced wholesale (the journal only describes changes to the base it
+ * was started on).  The files are written on a worker thread from a copy
+ * of the records, so the menu comes straight back; finish_save picks the
+ * result up.
+ */
+static void save_if_due(void) {
+    if (!g_avl_root || journal_compact_running(&g_journal)) return;
+    if (!g_save_all && !journal_needs_compact(&g_journal)) return;
+    if (journal_compact_begin(&g_journal, g_avl_root, FILE_CUSTOM_WORDS,
+                              FILE_SNAPSHOT, NULL, NULL) != 0 &&
+        save_dictionary() != 0)   /* no memory for the copy: save in place */
+        printf("  Warning: could not save to %s\n", FILE_CUSTOM_WORDS);
+}
+
 /* ── Test dataset ────────────────────────────────────────────── */
 typedef struct { const char *word; const char *meaning; const char *pos; int freq; } TestEntry;
 
@@ -63,101 +325,202 @@ static void load_test_data(void) {
     int n = (int)(sizeof(TEST_WORDS) / sizeof(TEST_WORDS[0]));
     WordRecord rec;
 
-    /* Free and reinitialise all three trees */
-    bst_free(&g_bst_root);
-    avl_free(&g_avl_root);
-    tbt_free(&g_tbt_header);
-    g_tbt_header = tbt_create_header();
+    /* Free and reinitialise all three trees, then the records they shared */
+    reset_dictionary();
 
     for (i = 0; i < n; i++) {
         word_record_init(&rec);
         str_safe_copy(rec.word,           TEST_WORDS[i].word,    sizeof(rec.word));
-        str_safe_copy(rec.meaning,        TEST_WORDS[i].meaning, sizeof(rec.meaning));
-        str_safe_copy(rec.part_of_speech, TEST_WORDS[i].pos,     sizeof(rec.part_of_speech));
+        rec.meaning        = TEST_WORDS[i].meaning;
+        rec.part_of_speech = TEST_WORDS[i].pos;
         rec.frequency_score = TEST_WORDS[i].freq;
-        bst_insert(&g_bst_root, &rec);
-        g_avl_root = avl_insert(g_avl_root, &rec);
-        tbt_insert(g_tbt_header, &rec);
+        dict_insert(&rec);
     }
+    prefix_cache_clear(&g_cache);
+    g_save_all = 1;
+    save_if_due();
+
+    g_word_count = avl_count(g_avl_root);
+    printf("  Loaded %d test words into the %s index.\n", g_word_count,
+           active_tree_name());
+    printf("  AVL height : %d\n", avl_height(g_avl_root));
+}
 
-    g_word_count = bst_count(g_bst_root);
-    printf("  Loaded %d test words into BST / AVL / TBT.\n", g_word_count);
-    printf("  BST height : %d  |  AVL height : %d\n",
-           bst_height(g_bst_root), avl_height(g_avl_root));
+/* ── Paged display (menu 5) ─────────────────────────────────── */
+
+/*
+ * A position in sorted order for menu 5: the TBT's threads when the TBT
+ * is active, the AVL's cursor otherwise (the AVL is always built).  Each
+ * page is one seek plus DISPLAY_PAGE_SIZE steps, not a whole traversal.
+ */
+typedef struct PageCursor {
+    int       use_tbt;
+    TBTNode  *tbt;   /* current node (the header past either end) */
+    AVLCursor avl;
+} PageCursor;
+
+static WordRecord *page_rec(const PageCursor *pc) {
+    AVLNode *n;
+    if (pc->use_tbt) return pc->tbt && pc->tbt != g_tbt_header ? pc->tbt->rec : NULL;
+    n = avl_cursor_node(&pc->avl);
+    return n ? n->rec : NULL;
 }
 
-/* ── Display callbacks for each tree ────────────────────────── */
-static void bst_print_row(BSTNode *node, void *arg) {
-    int *counter = (int *)arg;
-    (*counter)++;
-    printf("  %3d. %-22s  %-13s  freq=%d\n",
-           *counter,
-           node->data.word,
-           node->data.part_of_speech[0] ? node->data.part_of_speech : "-",
-           node->data.frequency_score);
+/* First word >= word, or NULL if there is none. */
+static WordRecord *page_seek(PageCursor *pc, const char *word) {
+    pc->use_tbt = g_active_tree == 3;
+    if (pc->use_tbt) pc->tbt = tbt_lower_bound(g_tbt_header, word);
+    else             avl_lower_bound(g_avl_root, word, &pc->avl);
+    return page_rec(pc);
 }
 
-static void avl_print_row(AVLNode *node, void *arg) {
-    int *counter = (int *)arg;
-    (*counter)++;
-    printf("  %3d. %-22s  %-13s  freq=%d\n",
-           *counter,
-           node->data.word,
-           node->data.part_of_speech[0] ? node->data.part_of_speech : "-",
-           node->data.frequency_score);
+static WordRecord *page_seek_last(PageCursor *pc) {
+    pc->use_tbt = g_active_tree == 3;
+    if (pc->use_tbt) pc->tbt = tbt_inorder_predecessor(g_tbt_header);
+    else             avl_last(g_avl_root, &pc->avl);
+    return page_rec(pc);
 }
 
-static void tbt_print_row(TBTNode *node, void *arg) {
-    int *counter = (int *)arg;
-    (*counter)++;
-    printf("  %3d. %-22s  %-13s  freq=%d\n",
-           *counter,
-           node->data.word,
-           node->data.part_of_speech[0] ? node->data.part_of_speech : "-",
-           node->data.frequency_score);
+/* Step one word forward, or back if back is set. */
+static WordRecord *page_step(PageCursor *pc, int back) {
+    if (pc->use_tbt) {
+        if (page_rec(pc))
+            pc->tbt = back ? tbt_inorder_predecessor(pc->tbt)
+                           : tbt_inorder_successor(pc->tbt);
+    } else if (back) {
+        avl_cursor_prev(&pc->avl);
+    } else {
+        avl_cursor_next(&pc->avl);
+    }
+    return page_rec(pc);
 }
 
-/* ── Main entry point ────────────────────────────────────────── */
-int main(void) {
-    char input[MAX_INPUT_BUF];
-    int  choice;
-    int  running = 1;
+/* ── Session ─────────────────────────────────────────────────── */
 
-    /* Initialise TBT header sentinel before any inserts */
+/* Initialise the record store and TBT header sentinel before any inserts */
+static void init_dictionary(void) {
+    store_init(&g_store);
     g_tbt_header = tbt_create_header();
+    trie_init(&g_trie);
+    bpt_init(&g_bpt);
+    bk_init(&g_bk);
+    prefix_cache_init(&g_cache);
+    g_built = initial_indexes();
+}
 
-    print_header();
+/* Tree heights after a load; the BST only once it is built (IS_BUILT). */
+static void print_heights(void) {
+    printf("\n  ");
+    if (IS_BUILT(1)) printf("BST height: %d  |  ", bst_height(g_bst_root));
+    printf("AVL height: %d\n", avl_height(g_avl_root));
+}
 
-    /* ── Auto-load previous session or fresh dictionary ── */
-    {
-        int n, m;
-        /* Try custom_words.txt first (has freq + picks from last session) */
-        n = load_words(FILE_CUSTOM_WORDS, &g_bst_root, &g_avl_root, g_tbt_header);
+/* Load the previous session (snapshot, else custom_words.txt), or the
+   shipped dictionary on a first run, then replay the journal over it. */
+static void load_session(void) {
+    static const JournalOps ops = { replay_insert, replay_remove, replay_picks };
+    const char *src = FILE_SNAPSHOT;
+    int         n, m, r, ranked;
+
+    /* Binary snapshot first (no parsing), then its text twin
+       custom_words.txt (both have freq + picks from last session) */
+    n = snapshot_load(FILE_SNAPSHOT, &g_store,
+                      bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+    if (n <= 0) {
+        src = FILE_CUSTOM_WORDS;
+        n = load_words(FILE_CUSTOM_WORDS, &g_store,
+                       bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+    }
+    if (n > 0) {
+        /* Also refresh frequencies from canonical source */
+        m = load_frequencies(FILE_WORD_FREQ, &g_store, g_avl_root, trie_slot());
+        finish_load();
+        g_word_count = avl_count(g_avl_root);
+        printf("\n  Session restored: %d words from %s", n, src);
+        if (m >= 0) printf("  (+%d freq updates)", m);
+        print_heights();
+    } else {
+        /* First run — the corpus-ranked snapshot if shipped (its scores
+           are final), else the packed dictionary, else words.txt */
+        src    = FILE_WORDS_SNAP;
+        m      = -1;
+        n      = snapshot_load(FILE_WORDS_SNAP, &g_store,
+                               bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+        ranked = n > 0;
+        if (n <= 0) {
+            src = FILE_WORDS_PACKED;
+            n = load_words(FILE_WORDS_PACKED, &g_store,
+                           bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+        }
+        if (n <= 0) {
+            src = FILE_WORDS;
+            n = load_words(FILE_WORDS, &g_store,
+                           bst_slot(), &g_avl_root, tbt_slot(), trie_slot());
+        }
         if (n > 0) {
-            /* Also refresh frequencies from canonical source */
-            m = load_frequencies(FILE_WORD_FREQ, g_bst_root, g_avl_root, g_tbt_header);
-            g_word_count = bst_count(g_bst_root);
-            printf("\n  Session restored: %d words from %s", n, FILE_CUSTOM_WORDS);
+            if (!ranked)
+                m = load_frequencies(FILE_WORD_FREQ, &g_store, g_avl_root, trie_slot());
+            finish_load();
+            g_word_count = avl_count(g_avl_root);
+            printf("\n  Loaded %d words from %s", n, src);
             if (m >= 0) printf("  (+%d freq updates)", m);
-            printf("\n  BST height: %d  |  AVL height: %d\n",
-                   bst_height(g_bst_root), avl_height(g_avl_root));
+            print_heights();
+            g_save_all = 1;   /* no save files yet */
         } else {
-            /* First run — load from canonical words.txt */
-            n = load_words(FILE_WORDS, &g_bst_root, &g_avl_root, g_tbt_header);
-            if (n > 0) {
-                m = load_frequencies(FILE_WORD_FREQ, g_bst_root, g_avl_root, g_tbt_header);
-                g_word_count = bst_count(g_bst_root);
-                printf("\n  Loaded %d words from %s", n, FILE_WORDS);
-                if (m >= 0) printf("  (+%d freq updates)", m);
-                printf("\n  BST height: %d  |  AVL height: %d\n",
-                       bst_height(g_bst_root), avl_height(g_avl_root));
-            } else {
-                printf("\n  No dictionary file found. Use option 6 to load words.\n");
-            }
+            printf("\n  No dictionary file found. Use option 6 to load words.\n");
         }
     }
 
+    /* Replay what changed since those files were written */
+    r = journal_open(&g_journal, FILE_JOURNAL, &ops, NULL);
+    if (r > 0) {
+        g_word_count = avl_count(g_avl_root);
+        printf("  Replayed %d change%s from %s\n", r, r == 1 ? "" : "s",
+               FILE_JOURNAL);
+    } else if (r < 0) {
+        printf("  Warning: cannot write %s; changes are saved at exit only\n",
+               FILE_JOURNAL);
+    }
+}
+
+/* Free all trees at once (O(slabs) per pool), then the records */
+static void free_dictionary(void) {
+    bst_pool_destroy();
+    avl_pool_destroy();
+    tbt_pool_destroy();
+    trie_free(&g_trie);
+    bpt_free(&g_bpt);
+    bk_free(&g_bk);
+    suffix_free(&g_sfx);
+    fulltext_free(&g_fts);
+    g_bst_root   = NULL;
+    g_avl_root   = NULL;
+    g_tbt_header = NULL;
+    store_free(&g_store);
+}
+
+/* ── Main entry point ────────────────────────────────────────── */
+int main(int argc, char **argv) {
+    char input[MAX_INPUT_BUF];
+    int  choice;
+    int  running = 1;
+
+    if (argc == 3 && strcmp(argv[1], "--record") == 0) {
+        if (querylog_record_open(&g_recorder, argv[2]) != 0) {
+            fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[2]);
+            return 2;
+        }
+    } else if (argc > 1) {
+        return run_headless(argc, argv);
+    }
+
+    init_dictionary();
+    print_header();
+    load_session();
+    if (g_recorder.fp) printf("  Recording queries to %s\n", argv[2]);
+
     while (running) {
+        finish_save(0);
         printf("\n");
         print_separator('-', 60);
         printf(" MAIN MENU  [Active tree: %s]  [Words: %d]\n",
@@ -172,6 +535,8 @@ int main(void) {
         printf("  7. Switch active tree structure\n");
         printf("  8. Run benchmark comparison\n");
         printf("  9. About this application\n");
+        printf(" 10. Engine counters and memory use\n");
+        printf(" 11. Tree shape (depths, compares, skew)\n");
         printf("  0. Exit\n");
         print_separator('-', 60);
         printf("Enter choice: ");
@@ -189,24 +554,30 @@ int main(void) {
             case 7:  menu_switch_tree();    break;
             case 8:  menu_benchmark();      break;
             case 9:  menu_about();          break;
+            case 10: menu_engine_stats();   break;
+            case 11: menu_tree_shape();     break;
             case 0:  running = 0;           break;
             default:
-                printf("  Invalid choice. Enter a number 0-9.\n");
+                printf("  Invalid choice. Enter a number 0-11.\n");
         }
     }
 
-    /* Save current dictionary state before exit */
-    if (g_bst_root) {
-        if (save_custom_words(FILE_CUSTOM_WORDS, g_bst_root) == 0)
+    /* Every change is in the journal already; a full save is only needed
+       if the journal does not cover the session or has grown too big */
+    finish_save(1);
+    if (g_avl_root && (g_save_all || journal_needs_compact(&g_journal))) {
+        if (save_dictionary() == 0)
             printf("\n  Dictionary saved to %s\n", FILE_CUSTOM_WORDS);
         else
             printf("\n  Warning: could not save to %s\n", FILE_CUSTOM_WORDS);
+    } else if (g_journal.entries > 0) {
+        printf("\n  %d change%s since the last full save kept in %s\n",
+               g_journal.entries, g_journal.entries == 1 ? "" : "s", FILE_JOURNAL);
     }
+    journal_close(&g_journal);
 
-    /* Free all three trees */
-    avl_free(&g_avl_root);
-    tbt_free(&g_tbt_header);
-    bst_free(&g_bst_root);
+    free_dictionary();
+    querylog_record_close(&g_recorder);
 
     printf("Exiting Smart Dictionary. Goodbye.\n");
     return 0;
@@ -215,10 +586,8 @@ int main(void) {
 /* ── Menu handlers ───────────────────────────────────────────── */
 
 static void menu_search_word(void) {
-    char     word[MAX_WORD_LEN];
-    BSTNode *bst_result;
-    AVLNode *avl_result;
-    TBTNode *tbt_result;
+    char        word[MAX_WORD_LEN];
+    WordRecord *rec;
 
     printf("\n-- Search Word --\n");
     printf("Enter word to search: ");
@@ -230,36 +599,17 @@ static void menu_search_word(void) {
         return;
     }
 
-    if (g_active_tree == 2) {
-        avl_result = avl_search(g_avl_root, word);
-        if (avl_result) {
-            printf("  Found (AVL):\n");
-            print_separator('-', 40);
-            word_record_print(&avl_result->data);
-            print_separator('-', 40);
-        } else {
-            printf("  Word '%s' not found in AVL.\n", word);
-        }
-    } else if (g_active_tree == 3) {
-        tbt_result = tbt_search(g_tbt_header, word);
-        if (tbt_result) {
-            printf("  Found (TBT):\n");
-            print_separator('-', 40);
-            word_record_print(&tbt_result->data);
-            print_separator('-', 40);
-        } else {
-            printf("  Word '%s' not found in TBT.\n", word);
-        }
+    /* Exact match is one hash probe whichever tree is active; the trees
+       serve the ordered and prefix queries */
+    querylog_record(&g_recorder, QLOG_SEARCH, word);
+    rec = store_find(&g_store, word);
+    if (rec) {
+        printf("  Found (hash index):\n");
+        print_separator('-', 40);
+        word_record_print(rec);
+        print_separator('-', 40);
     } else {
-        bst_result = bst_search(g_bst_root, word);
-        if (bst_result) {
-            printf("  Found (BST):\n");
-            print_separator('-', 40);
-            word_record_print(&bst_result->data);
-            print_separator('-', 40);
-        } else {
-            printf("  Word '%s' not found in BST.\n", word);
-        }
+        printf("  Word '%s' not found.\n", word);
     }
 }
 
@@ -268,7 +618,7 @@ static void menu_insert_word(void) {
     char       word[MAX_WORD_LEN];
     char       meaning[MAX_MEANING_LEN];
     char       pos[MAX_POS_LEN];
-    int        prev_count;
+    WordRecord *stored;
 
     printf("\n-- Insert Word --\n");
 
@@ -284,19 +634,18 @@ static void menu_insert_word(void) {
 
     word_record_init(&rec);
     str_safe_copy(rec.word,           word,    sizeof(rec.word));
-    str_safe_copy(rec.meaning,        meaning, sizeof(rec.meaning));
-    str_safe_copy(rec.part_of_speech, pos,     sizeof(rec.part_of_speech));
+    rec.meaning        = meaning;   /* copied into the store's arena */
+    rec.part_of_speech = pos;
     rec.frequency_score = FREQ_SCORE_DEFAULT;
 
-    prev_count = g_word_count;
-    bst_insert(&g_bst_root, &rec);
-    g_avl_root = avl_insert(g_avl_root, &rec);
-    tbt_insert(g_tbt_header, &rec);
-    g_word_count = bst_count(g_bst_root);
+    stored = dict_insert(&rec);
+    g_word_count = avl_count(g_avl_root);
 
-    if (g_word_count > prev_count) {
-        printf("  Inserted '%s' into BST / AVL / TBT. Total words: %d\n",
+    if (stored) {
+        journal_log_insert(&g_journal, stored);
+        printf("  Inserted '%s' into every built index. Total words: %d\n",
                word, g_word_count);
+        save_if_due();
     } else {
         printf("  Word '%s' already exists (duplicate skipped).\n", word);
     }
@@ -304,7 +653,6 @@ static void menu_insert_word(void) {
 
 static void menu_delete_word(void) {
     char word[MAX_WORD_LEN];
-    int  prev_count;
 
     printf("\n-- Delete Word --\n");
 
@@ -317,20 +665,28 @@ static void menu_delete_word(void) {
     input_read_line(word, sizeof(word));
     if (str_is_empty(word)) { printf("  No input provided.\n"); return; }
 
-    prev_count = g_word_count;
-    bst_delete(&g_bst_root, word);
-    g_avl_root = avl_delete(g_avl_root, word);
-    tbt_delete(g_tbt_header, word);
-    g_word_count = bst_count(g_bst_root);
-
-    if (g_word_count < prev_count) {
-        printf("  Deleted '%s' from BST / AVL / TBT. Total words: %d\n",
+    if (dict_delete(word)) {
+        g_word_count = avl_count(g_avl_root);
+        journal_log_delete(&g_journal, word);
+        printf("  Deleted '%s' from every built index. Total words: %d\n",
                word, g_word_count);
+        save_if_due();
     } else {
         printf("  Word '%s' not found.\n", word);
     }
 }
 
+/* AutocompleteFn over the active tree, for the prefix cache */
+static int active_autocomplete(const char *prefix, WordRecord *results,
+                               int top_k, void *arg) {
+    (void)arg;
+    if (g_active_tree == 2) return autocomplete_avl(g_avl_root,   prefix, results, top_k);
+    if (g_active_tree == 3) return autocomplete_tbt(g_tbt_header, prefix, results, top_k);
+    if (g_active_tree == 4) return autocomplete_trie(&g_trie,     prefix, results, top_k);
+    if (g_active_tree == 5) return autocomplete_bpt(&g_bpt,       prefix, results, top_k);
+    return autocomplete_bst(g_bst_root, prefix, results, top_k);
+}
+
 static void menu_autocomplete(void) {
     char       prefix[MAX_WORD_LEN];
     char       sel[MAX_INPUT_BUF];
@@ -338,7 +694,7 @@ static void menu_autocomplete(void) {
     int        n, i, choice;
 
     printf("\n-- Autocomplete --\n");
-    printf("Enter prefix: ");
+    printf("Enter prefix (*text: words containing text, ?terms: search definitions): ");
     input_read_line(prefix, sizeof(prefix));
     if (str_is_empty(prefix)) { printf("  No prefix provided.\n"); return; }
 
@@ -347,29 +703,59 @@ static void menu_autocomplete(void) {
         return;
     }
 
-    /* Dispatch to the active tree's autocomplete function */
-    if (g_active_tree == 2)
-        n = autocomplete_avl(g_avl_root,   prefix, results, TOP_K_DEFAULT);
-    else if (g_active_tree == 3)
-        n = autocomplete_tbt(g_tbt_header, prefix, results, TOP_K_DEFAULT);
-    else
-        n = autocomplete_bst(g_bst_root,   prefix, results, TOP_K_DEFAULT);
+    /* Old picks fade: re-rank whatever decayed since the last query */
+    if (autocomplete_apply_decay(&g_store, g_avl_root, trie_slot()) > 0)
+        prefix_cache_clear(&g_cache);
 
-    if (n == 0) {
-        printf("  No words found matching '%s'.\n", prefix);
-        return;
+    if (prefix[0] == '*') {
+        n = substring_search(prefix + 1, results, TOP_K_DEFAULT);
+        if (n <= 0) {
+            printf("  No words contain '%s'.\n", prefix + 1);
+            return;
+        }
+        printf("\n  Words containing \"%s\"  (top %d by score):\n", prefix + 1, n);
+    } else if (prefix[0] == '?') {
+        int total;
+        n = definition_search(prefix + 1, results, TOP_K_DEFAULT, &total);
+        if (n <= 0) {
+            printf("  No definition contains every word of '%s'.\n", prefix + 1);
+            return;
+        }
+        printf("\n  Definitions matching \"%s\"  (top %d of %d by score):\n",
+               prefix + 1, n, total);
+    } else {
+        /* Hot prefixes come from the cache, the rest from the active
+           tree; a prefix nothing starts with is not looked up at all */
+        querylog_record(&g_recorder, QLOG_COMPLETE, prefix);
+        n = autocomplete_prefix_exists(g_avl_root, trie_slot(), prefix)
+            ? prefix_cache_autocomplete(&g_cache, &g_store, prefix, results,
+                                        TOP_K_DEFAULT, active_autocomplete, NULL)
+            : 0;
+        if (n > 0) {
+            int total = autocomplete_prefix_count(g_avl_root, prefix);
+            printf("\n  Results for \"%s\" [%s]  (%d of %d match%s):\n",
+                   prefix, active_tree_name(), n, total, total == 1 ? "" : "es");
+        } else {
+            /* Nothing starts with it: offer the nearest words by edit distance */
+            ensure_fuzzy_index();
+            n = bk_suggest(&g_bk, prefix, FUZZY_MAX_DIST, results, TOP_K_DEFAULT);
+            if (n == 0) {
+                printf("  No words found matching '%s'.\n", prefix);
+                return;
+            }
+            printf("\n  No words start with \"%s\". Did you mean (within %d edit%s):\n",
+                   prefix, FUZZY_MAX_DIST, FUZZY_MAX_DIST == 1 ? "" : "s");
+        }
     }
 
     /* Display numbered suggestions */
-    printf("\n  Results for \"%s\" [%s]  (%d match%s):\n",
-           prefix, active_tree_name(), n, n == 1 ? "" : "es");
     print_separator('-', 54);
     for (i = 0; i < n; i++) {
         printf("  %2d. %-22s  %-12s  score=%-5d  picks=%d\n",
                i + 1,
                results[i].word,
                results[i].part_of_speech[0] ? results[i].part_of_speech : "-",
-               results[i].frequency_score + 10 * results[i].user_select_count,
+               word_record_score(&results[i]),
                results[i].user_select_count);
     }
     print_separator('-', 54);
@@ -380,18 +766,27 @@ static void menu_autocomplete(void) {
     choice = atoi(sel);
 
     if (choice >= 1 && choice <= n) {
-        autocomplete_record_selection(results[choice - 1].word,
-                                      g_bst_root, g_avl_root, g_tbt_header);
+        const char       *word = results[choice - 1].word;
+        const WordRecord *rec;
+        querylog_record(&g_recorder, QLOG_PICK, word);
+        prefix_cache_invalidate_word(&g_cache, word);
+        autocomplete_record_selection(word, &g_store, g_avl_root, trie_slot());
+        rec = store_find(&g_store, word);
+        if (rec) journal_log_picks(&g_journal, rec->word, rec->user_select_count,
+                                   rec->select_time);
         printf("  Recorded: '%s'  (picks now %d)\n",
-               results[choice - 1].word,
-               results[choice - 1].user_select_count + 1);
+               word, results[choice - 1].user_select_count + 1);
+        save_if_due();
     } else {
         printf("  Skipped.\n");
     }
 }
 
 static void menu_display_all(void) {
-    int counter = 0;
+    char        input[MAX_INPUT_BUF];
+    PageCursor  start, pc;
+    WordRecord *rec;
+    int         pos, i;   /* pos: 0-based position of the page's first word */
 
     printf("\n-- Display All Words (Sorted In-Order) --\n");
 
@@ -400,30 +795,48 @@ static void menu_display_all(void) {
         return;
     }
 
-    printf("  %-3s  %-22s  %-13s  %s\n", "No.", "Word", "Part of Speech", "Freq");
-    print_separator('-', 58);
-
-    if (g_active_tree == 2) {
-        avl_inorder(g_avl_root, avl_print_row, &counter);
-        print_separator('-', 58);
-        printf("  Total: %d words  |  AVL height: %d\n",
-               avl_count(g_avl_root), avl_height(g_avl_root));
-    } else if (g_active_tree == 3) {
-        tbt_inorder(g_tbt_header, tbt_print_row, &counter);
-        print_separator('-', 58);
-        printf("  Total: %d words  (TBT iterative, no stack)\n",
-               tbt_count(g_tbt_header));
-    } else {
-        bst_inorder(g_bst_root, bst_print_row, &counter);
-        print_separator('-', 58);
-        printf("  Total: %d words  |  BST height: %d\n",
-               g_word_count, bst_height(g_bst_root));
+    page_seek(&start, "");
+    pos = 0;
+    for (;;) {
+        printf("\n  %-5s  %-22s  %-13s  %s\n", "No.", "Word", "Part of Speech", "Freq");
+        print_separator('-', 60);
+        pc  = start;
+        rec = page_rec(&pc);
+        for (i = 0; rec && i < DISPLAY_PAGE_SIZE; i++, rec = page_step(&pc, 0))
+            printf("  %5d. %-22s  %-13s  freq=%d\n",
+                   pos + i + 1,
+                   rec->word,
+                   rec->part_of_speech[0] ? rec->part_of_speech : "-",
+                   rec->frequency_score);
+        print_separator('-', 60);
+        printf("  Words %d-%d of %d  (%s)\n", pos + 1, pos + i, g_word_count,
+               start.use_tbt ? "TBT threads" : "AVL cursor");
+        printf("  Enter = next page, - = previous, a word = jump to it, 0 = done: ");
+        if (!input_read_line(input, sizeof(input)) || strcmp(input, "0") == 0) break;
+
+        if (input[0] == '\0') {
+            if (!rec) break;              /* Enter on the last page: done */
+            start = pc;
+            pos  += i;
+        } else if (strcmp(input, "-") == 0) {
+            for (i = 0; i < DISPLAY_PAGE_SIZE && pos > 0; i++, pos--)
+                page_step(&start, 1);
+        } else if (page_seek(&start, input)) {
+            pos = avl_rank(g_avl_root, input);
+        } else {
+            /* Past the last word: show the last page */
+            page_seek_last(&start);
+            for (pos = g_word_count - 1, i = 1; i < DISPLAY_PAGE_SIZE && pos > 0; i++, pos--)
+                page_step(&start, 1);
+        }
     }
 }
 
 static void menu_load_from_file(void) {
-    char input[MAX_INPUT_BUF];
-    int  n, m;
+    char        input[MAX_INPUT_BUF];
+    const char *path;
+    clock_t     t;
+    int         n, m;
 
     printf("\n-- Load Dictionary --\n");
 
@@ -436,34 +849,48 @@ static void menu_load_from_file(void) {
             return;
         }
         /* Free all trees before reloading */
-        bst_free(&g_bst_root);
-        avl_free(&g_avl_root);
-        tbt_free(&g_tbt_header);
-        g_tbt_header = tbt_create_header();
-        g_word_count = 0;
+        reset_dictionary();
     }
 
-    /* Try real file first */
-    n = load_words(FILE_WORDS, &g_bst_root, &g_avl_root, g_tbt_header);
+    /* words.txt by default; a .sdz path is a packed dictionary, a .jsonl
+       path a raw kaikki.org dump */
+    printf("  File to load [Enter: %s, a packed .sdz, or a kaikki .jsonl dump]: ",
+           FILE_WORDS);
+    input_read_line(input, sizeof(input));
+    path = input[0] ? input : FILE_WORDS;
+
+    t = clock();
+    n = load_words(path, &g_store, bst_slot(), &g_avl_root, tbt_slot(),
+                   trie_slot());
     if (n < 0) {
         printf("  '%s' not found — loading 15 hardcoded test words instead.\n",
-               FILE_WORDS);
+               path);
         load_test_data();
         return;
     }
-    printf("  Loaded %d words from %s\n", n, FILE_WORDS);
+    printf("  Loaded %d words from %s in %.1f ms\n", n, path,
+           (double)(clock() - t) * 1000.0 / (double)CLOCKS_PER_SEC);
 
     /* Optionally enrich with frequency scores */
-    m = load_frequencies(FILE_WORD_FREQ, g_bst_root, g_avl_root, g_tbt_header);
+    m = load_frequencies(FILE_WORD_FREQ, &g_store, g_avl_root, trie_slot());
     if (m >= 0)
         printf("  Updated %d frequency scores from %s\n", m, FILE_WORD_FREQ);
-
-    g_word_count = bst_count(g_bst_root);
-    printf("  BST height  : %d  |  AVL height : %d\n",
-           bst_height(g_bst_root), avl_height(g_avl_root));
-    printf("  BST/AVL/TBT : %d / %d / %d words\n",
-           bst_count(g_bst_root), avl_count(g_avl_root),
-           tbt_count(g_tbt_header));
+    finish_load();
+    g_save_all = 1;
+    save_if_due();
+
+    g_word_count = avl_count(g_avl_root);
+    printf("  AVL height  : %d", avl_height(g_avl_root));
+    if (IS_BUILT(1)) printf("  |  BST height : %d", bst_height(g_bst_root));
+    printf("\n  Indexed in  :");
+    if (IS_BUILT(1)) printf(" BST (%d)",  bst_count(g_bst_root));
+    printf(" AVL (%d)", avl_count(g_avl_root));
+    if (IS_BUILT(3)) printf(" TBT (%d)",  tbt_count(g_tbt_header));
+    if (IS_BUILT(4)) printf(" Trie (%d)", trie_count(&g_trie));
+    if (IS_BUILT(5)) printf(" B+ (%d)",   bpt_count(&g_bpt));
+    if (g_built != ALL_INDEXES)
+        printf("  — the others are built on first switch");
+    printf("\n");
 }
 
 static void menu_switch_tree(void) {
@@ -473,21 +900,141 @@ static void menu_switch_tree(void) {
     printf("  1. BST  (Binary Search Tree)           - O(log n) avg\n");
     printf("  2. AVL  (Self-Balancing BST)            - O(log n) guaranteed\n");
     printf("  3. TBT  (Threaded Binary Tree)          - stack-free traversal\n");
-    printf("Select tree (1-3): ");
+    printf("  4. Trie (Compressed radix trie)         - O(key length) lookup\n");
+    printf("  5. B+   (B+-tree, linked leaves)        - sequential prefix scans\n");
+    printf("Select tree (1-5): ");
     input_read_line(input, sizeof(input));
     choice = atoi(input);
-    if (choice >= 1 && choice <= 3) {
+    if (choice >= 1 && choice <= 5) {
+        int prev = g_active_tree;
         g_active_tree = choice;
+        if (!IS_BUILT(choice)) {
+            clock_t t = clock();
+            if (ensure_active_index() != 0) {
+                g_active_tree = prev;
+                printf("  Out of memory building the index; still on %s.\n",
+                       active_tree_name());
+                return;
+            }
+            printf("  Built the %s index over %d words in %.1f ms.\n",
+                   active_tree_name(), g_word_count,
+                   (double)(clock() - t) * 1000.0 / (double)CLOCKS_PER_SEC);
+        }
+        prefix_cache_clear(&g_cache);  /* ties may rank differently */
         printf("  Active tree switched to: %s\n", active_tree_name());
     } else {
-        printf("  Invalid selection. Enter 1, 2, or 3.\n");
+        printf("  Invalid selection. Enter 1, 2, 3, 4, or 5.\n");
     }
 }
 
+/* The quick comparison, or the replay of log if it is non-NULL, saved to
+   a results file and/or compared against a baseline one.  Returns the
+   number of regressions, or -1 on error. */
+static int benchmark_against(const char *save_path, const char *baseline_path,
+                             double threshold_pct, const QueryLog *log,
+                             const ReplayOptions *replay) {
+    BenchResults cur, base;
+    char        *text;
+    int          ret = 0;
+
+    benchmark_results_init(&cur);
+    benchmark_results_init(&base);
+    if (baseline_path && benchmark_results_load(&base, baseline_path) <= 0) {
+        printf("  Cannot read baseline %s\n", baseline_path);
+        return -1;
+    }
+    if (log) {
+        if (benchmark_replay(log, replay, &cur) != 0) {
+            benchmark_results_free(&cur);
+            benchmark_results_free(&base);
+            return -1;
+        }
+    } else {
+        if (benchmark_collect(&cur) != 0) {
+            printf("  [benchmark] out of memory — no results.\n");
+            benchmark_results_free(&base);
+            return -1;
+        }
+        text = benchmark_results_text(&cur);
+        if (text) fputs(text, stdout);
+        free(text);
+    }
+
+    if (save_path) {
+        if (benchmark_results_save(&cur, save_path) < 0) {
+            printf("  Cannot write %s\n", save_path);
+            ret = -1;
+        } else {
+            printf("  %d results written to %s\n", cur.count, save_path);
+        }
+    }
+    if (baseline_path && ret == 0)
+        ret = benchmark_compare(&base, &cur, threshold_pct, stdout);
+
+    benchmark_results_free(&cur);
+    benchmark_results_free(&base);
+    return ret;
+}
+
 static void menu_benchmark(void) {
+    char         input[MAX_INPUT_BUF];
+    char         path[MAX_INPUT_BUF];
+    char         csv[MAX_INPUT_BUF];
+    BenchOptions opt = BENCH_OPTIONS_INIT;
+    double       threshold;
+
     printf("\n-- Benchmark Comparison --\n");
-    printf("  Building fresh trees from synthetic data. Please wait...\n");
-    benchmark_run_all();
+    printf("  1. Quick comparison (synthetic, 500-5000 words + scale trial)\n");
+    printf("  2. Full suite (real word list, 10k-1M words; takes minutes)\n");
+    printf("  3. Quick comparison, save results (.csv, or .json)\n");
+    printf("  4. Quick comparison against a saved .csv baseline\n");
+    printf("  5. Replay a query log against every backend\n");
+    printf("Select (1-5): ");
+    input_read_line(input, sizeof(input));
+    if (strcmp(input, "2") == 0) {
+        printf("  Latency CSV file (Enter for none): ");
+        input_read_line(csv, sizeof(csv));
+        if (csv[0] != '\0') opt.csv_path = csv;
+        printf("  Running the suite over %s and synthetic lists. Please wait...\n",
+               FILE_WORDS);
+        benchmark_run_suite(&opt);
+    } else if (strcmp(input, "3") == 0 || strcmp(input, "4") == 0) {
+        printf("  %s file: ", input[0] == '3' ? "Results" : "Baseline");
+        input_read_line(path, sizeof(path));
+        if (path[0] == '\0') {
+            printf("  No file given.\n");
+            return;
+        }
+        if (input[0] == '3') {
+            printf("  Building fresh trees from synthetic data. Please wait...\n");
+            benchmark_against(path, NULL, 0.0, NULL, NULL);
+            return;
+        }
+        printf("  Regression threshold in %% (Enter for %d): ", BENCH_REGRESSION_PCT);
+        input_read_line(input, sizeof(input));
+        threshold = input[0] != '\0' ? atof(input) : BENCH_REGRESSION_PCT;
+        printf("  Building fresh trees from synthetic data. Please wait...\n");
+        benchmark_against(NULL, path, threshold, NULL, NULL);
+    } else if (strcmp(input, "5") == 0) {
+        ReplayOptions ro = REPLAY_OPTIONS_INIT;
+        QueryLog      log;
+        printf("  Query log file: ");
+        input_read_line(path, sizeof(path));
+        printf("  Concurrent clients (Enter for 1): ");
+        input_read_line(input, sizeof(input));
+        if (input[0] != '\0') ro.threads = atoi(input);
+        querylog_init(&log);
+        if (querylog_load(&log, path) <= 0) {
+            printf("  No events read from '%s'.\n", path);
+        } else {
+            printf("  Loading %s once per backend. Please wait...\n", FILE_WORDS);
+            benchmark_replay(&log, &ro, NULL);
+        }
+        querylog_free(&log);
+    } else {
+        printf("  Building fresh trees from synthetic data. Please wait...\n");
+        benchmark_run_all();
+    }
 }
 
 static void menu_about(void) {
@@ -502,9 +1049,17 @@ static void menu_about(void) {
     printf("    BST    Binary Search Tree         insert/search/delete\n");
     printf("    AVL    Self-Balancing BST          guaranteed O(log n)\n");
     printf("    TBT    Threaded Binary Tree        stack-free traversal\n");
+    printf("    TRIE   Compressed radix trie       O(key length) lookup\n");
+    printf("    B+     B+-tree, 16-key nodes       leaf-chain prefix scan\n");
     printf("    AC     Prefix autocomplete         BST-pruned + TBT iter\n");
+    printf("    BK     Typo suggestions            edit distance <= %d\n", FUZZY_MAX_DIST);
+    printf("    SA     Substring search (*text)    suffix array\n");
+    printf("    FTS    Definition search (?terms)  inverted index\n");
     printf("    BENCH  Performance benchmark       timed on 500-5000 words\n");
     print_separator('-', 60);
+    printf("  Prefix cache: %lu hits, %lu misses, %lu invalidations\n",
+           g_cache.hits, g_cache.misses, g_cache.invalidations);
+    print_separator('-', 60);
     printf("  Persistence:\n");
     printf("    Loads  %s  (canonical words + meanings)\n", FILE_WORDS);
     printf("    Saves  %s  (freq + picks preserved)\n", FILE_CUSTOM_WORDS);
@@ -515,3 +1070,511 @@ static void menu_about(void) {
     print_separator('=', 60);
     printf("\n");
 }
+
+/* v / d, or 0 when d is 0. */
+static double per(uint64_t v, uint64_t d) {
+    return d ? (double)v / (double)d : 0.0;
+}
+
+/* One line of the memory table: u's split in KB, and bytes per entry. */
+static void print_mem_row(const char *name, const MemUsage *u) {
+    printf("  %-8s %9.1f %9.1f %9.1f %9.1f %9.1f %8.1f\n", name,
+           u->node_bytes / 1024.0, u->string_bytes / 1024.0,
+           u->overhead_bytes / 1024.0, u->index_bytes / 1024.0,
+           mem_usage_total(u) / 1024.0, mem_usage_per_entry(u));
+}
+
+/* What the store and every built index hold (memusage.h). */
+static void print_memory(void) {
+    MemUsage all, u;
+
+    printf("  %-8s %9s %9s %9s %9s %9s %8s\n", "Memory", "nodes KB", "strings",
+           "overhead", "index", "total", "B/entry");
+    mem_usage_clear(&all);
+    mem_usage_clear(&u);
+    store_memory(&g_store, &u);
+    print_mem_row("Store", &u);
+    store_memory(&g_store, &all);
+    if (IS_BUILT(1)) {
+        mem_usage_clear(&u);
+        bst_memory(g_bst_root, &u);
+        print_mem_row("BST", &u);
+        bst_memory(g_bst_root, &all);
+    }
+    mem_usage_clear(&u);
+    avl_memory(g_avl_root, &u);
+    print_mem_row("AVL", &u);
+    avl_memory(g_avl_root, &all);
+    if (IS_BUILT(3)) {
+        mem_usage_clear(&u);
+        tbt_memory(g_tbt_header, &u);
+        print_mem_row("TBT", &u);
+        tbt_memory(g_tbt_header, &all);
+    }
+    if (IS_BUILT(4)) {
+        mem_usage_clear(&u);
+        trie_memory(&g_trie, &u);
+        print_mem_row("Trie", &u);
+        trie_memory(&g_trie, &all);
+    }
+    if (IS_BUILT(5)) {
+        mem_usage_clear(&u);
+        bpt_memory(&g_bpt, &u);
+        print_mem_row("B+", &u);
+        bpt_memory(&g_bpt, &all);
+    }
+    /* Per entry of the dictionary, not summed over every structure's count */
+    all.entries = (size_t)g_word_count;
+    print_mem_row("Total", &all);
+    printf("  Node pools are shared per tree type; their spare slots are counted\n"
+           "  in each tree's overhead.  Search indexes built on demand:\n"
+           "  suffix %.1f KB, full-text %.1f KB.\n",
+           suffix_memory(&g_sfx) / 1024.0, fulltext_memory(&g_fts) / 1024.0);
+}
+
+static void menu_engine_stats(void) {
+    char        input[MAX_INPUT_BUF];
+    EngineStats es;
+    uint64_t    q;
+    int         c;
+
+    printf("\n-- Engine Counters and Memory --\n");
+    print_memory();
+    print_separator('-', 60);
+    if (!ENGINE_STATS) {
+        printf("  Counters are compiled out (ENGINE_STATS 0 in config.h).\n");
+        return;
+    }
+    stats_snapshot(&es);
+    q = es.v[STAT_AC_QUERIES];
+    printf("  Since start or the last reset, all threads:\n");
+    for (c = 0; c < STAT_COUNTERS; c++)
+        printf("    %-14s %14llu\n", stats_name((StatsCounter)c),
+               (unsigned long long)es.v[c]);
+    print_separator('-', 60);
+    printf("  Per autocomplete query : %.1f candidates, %.1f results, %.2f us\n",
+           per(es.v[STAT_AC_CANDIDATES], q), per(es.v[STAT_AC_RESULTS], q),
+           per(es.v[STAT_AC_NS], q) / 1e3);
+    printf("  Per node visited       : %.2f key compares\n",
+           per(es.v[STAT_KEY_COMPARES], es.v[STAT_NODE_VISITS]));
+    printf("  Per sort               : %.1f items\n",
+           per(es.v[STAT_SORTED_ITEMS], es.v[STAT_SORTS]));
+    printf("  Reset the counters? (y/n): ");
+    input_read_line(input, sizeof(input));
+    if (input[0] == 'y' || input[0] == 'Y') {
+        stats_reset();
+        printf("  Counters reset.\n");
+    }
+}
+
+/* Shape of tree t (1-5) into s, if it is built; returns 0 if it is not. */
+static int tree_shape(int t, TreeShape *s) {
+    shape_clear(s);
+    if (t != 2 && !IS_BUILT(t)) return 0;
+    switch (t) {
+    case 1:  bst_shape(g_bst_root, s);    break;
+    case 2:  avl_shape(g_avl_root, s);    break;
+    case 3:  tbt_shape(g_tbt_header, s);  break;
+    case 4:  trie_shape(&g_trie, s);      break;
+    default: bpt_shape(&g_bpt, s);        break;
+    }
+    return 1;
+}
+
+static void menu_tree_shape(void) {
+    static const char *const NAME[6] = { "", "BST", "AVL", "TBT", "Trie", "B+" };
+    TreeShape s;
+    size_t    peak = 0;
+    int       t, d;
+
+    printf("\n-- Tree Shape --\n");
+    printf("  %-6s %9s %7s %10s %13s %7s\n",
+           "Tree", "Entries", "Height", "Avg depth", "Compares/hit", "Skew");
+    for (t = 1; t <= 5; t++) {
+        if (!tree_shape(t, &s)) {
+            printf("  %-6s  (not built)\n", NAME[t]);
+            continue;
+        }
+        printf("  %-6s %9lu %7d %10.2f %13.2f", NAME[t], (unsigned long)s.entries,
+               s.max_depth, shape_avg_depth(&s), shape_avg_compares(&s));
+        if (t <= 3)   /* binary trees: against a balanced one's height */
+            printf(" %6.2fx%s\n", shape_skew(&s),
+                   shape_too_deep(s.max_depth, s.entries) ? "  SKEWED" : "");
+        else
+            printf(" %7s\n", "-");
+    }
+    printf("  Skew is the height over a balanced binary tree's, floor(log2 n) + 1.\n");
+    printf("  BST rebalanced automatically %d time(s) this session (past %dx and\n"
+           "  %d levels).\n", g_bst_rebuilds, SHAPE_SKEW_LIMIT, SHAPE_SKEW_MIN_DEPTH);
+
+    if (!tree_shape(g_active_tree, &s) || s.entries == 0) return;
+    print_separator('-', 60);
+    printf("  Depth distribution, %s:\n", active_tree_name());
+    for (d = 0; d < SHAPE_DEPTHS; d++)
+        if (s.depth[d] > peak) peak = s.depth[d];
+    for (d = 0; d < SHAPE_DEPTHS; d++) {
+        int bar;
+        if (s.depth[d] == 0) continue;
+        bar = (int)((s.depth[d] * 40 + peak - 1) / peak);
+        printf("  %3d%s %9lu  %.*s\n", d, d == SHAPE_DEPTHS - 1 ? "+" : " ",
+               (unsigned long)s.depth[d], bar,
+               "########################################");
+    }
+}
+
+/* ── Headless modes ──────────────────────────────────────────── */
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] [mode]\n", prog);
+    printf("  With no mode, runs the interactive menu.  Modes (one per run):\n");
+    printf("    --bench            quick comparison; with --out, --baseline, --threshold\n");
+    printf("    --suite            full suite; with --words, --max, --reps, --csv\n");
+    printf("    --lookup FILE      exact lookup of every word in FILE (one per line)\n");
+    printf("    --complete FILE    top-%d autocomplete of every prefix in FILE\n",
+           TOP_K_DEFAULT);
+    printf("    --replay LOG       replay a query log (querylog.h: s|word, a|prefix,\n");
+    printf("                       p|word per line)\n");
+    printf("    --replay-all LOG   replay it against every backend; with --threads,\n");
+    printf("                       --shards, --words, --out, --baseline, --threshold\n");
+    printf("    --record LOG       (alone) the interactive menu, queries appended to LOG\n");
+    printf("    --publish IMAGE    freeze the saved session into an image file that\n");
+    printf("                       other processes attach read-only (--image)\n");
+    printf("    --delete FILE      delete every word in FILE (one per line) from the\n");
+    printf("                       saved session\n");
+    printf("    --merge FILE       add the words of FILE (words.txt formats) to it\n");
+    printf("    --freq FILE        apply the word,score lines of FILE to it\n");
+    printf("  Options:\n");
+    printf("    --tree NAME        bst, avl, tbt, trie or bpt (default bst)\n");
+    printf("    --out FILE         save the quick results (.csv, or .json)\n");
+    printf("    --baseline FILE    compare against a saved .csv; exit 1 on regressions\n");
+    printf("    --threshold PCT    regression threshold (default %d)\n",
+           BENCH_REGRESSION_PCT);
+    printf("    --threads N        concurrent replay clients (default 1)\n");
+    printf("    --shards N         --replay-all also against N key-range shards (up\n");
+    printf("                       to %d), one worker each\n", SHARD_MAX);
+    printf("    --words FILE       suite or replay word list (default %s)\n", FILE_WORDS);
+    printf("    --max N --reps N   suite dataset ceiling and repetitions\n");
+    printf("    --csv FILE         suite latency distributions as CSV\n");
+    printf("    --dict FILE        (repeatable, up to %d) run the lookup, complete or\n",
+           FED_MAX_MEMBERS);
+    printf("                       replay mode on these word files searched as one,\n");
+    printf("                       earlier files first for shared words\n");
+    printf("    --image IMAGE      run the lookup, complete or replay mode on a\n");
+    printf("                       published image, mapped in place of a load\n");
+    printf("  The lookup, complete and replay modes load the saved session as the\n");
+    printf("  menu does and print per-operation timings; replayed picks are not saved.\n");
+    printf("  The delete, merge and freq modes apply the whole file as one batch and\n");
+    printf("  save the session in full.\n");
+    printf("  Exit status: 0 done, 1 regressions found, 2 usage or I/O error.\n");
+}
+
+/* Tree number for a --tree name, 0 if unknown */
+static int tree_by_name(const char *name) {
+    static const char *const NAMES[] = { "bst", "avl", "tbt", "trie", "bpt" };
+    int i;
+    for (i = 0; i < 5; i++)
+        if (strcmp(name, NAMES[i]) == 0) return i + 1;
+    return strcmp(name, "b+") == 0 ? 5 : 0;
+}
+
+/*
+ * Run every event of log against the active tree, in order, timing each
+ * one, and print the per-operation counts and latencies.  Lookups are
+ * one store_find probe, as in menu 1; prefix queries go straight to the
+ * active tree (no prefix cache); picks are applied to the rankings but
+ * not journaled, so the session files are left as they were.  Returns 0, or 2 if the active index cannot be built.
+ * With fed non-NULL every event goes to that federation instead, and
+ * with img non-NULL to that attached image, where picks are only looked
+ * up (an image is read-only).
+ */
+static int run_events(const QueryLog *log, const char *what, Federation *fed,
+                      const DictImage *img) {
+    static const char *const NAMES[3] = { "search", "complete", "pick" };
+    static LatencyHist       hist[3];
+    WordRecord               results[TOP_K_DEFAULT];
+    LatencySummary           l;
+    const QueryEvent        *e;
+    uint64_t                 start, t0;
+    double                   ms;
+    WordRecord               found;
+    char                     target[64];
+    int                      hits[3] = { 0, 0, 0 };
+    int                      i, k;
+
+    if (fed) {
+        snprintf(target, sizeof(target), "%d dictionar%s", fed->count,
+                 fed->count == 1 ? "y" : "ies");
+    } else if (img) {
+        snprintf(target, sizeof(target), "an image of %d words", image_count(img));
+    } else if (ensure_active_index() != 0) {
+        printf("  Out of memory building the %s index.\n", active_tree_name());
+        return 2;
+    } else {
+        str_safe_copy(target, active_tree_name(), sizeof(target));
+        autocomplete_apply_decay(&g_store, g_avl_root, trie_slot());
+    }
+    for (k = 0; k < 3; k++) hist_init(&hist[k]);
+
+    start = bench_now_ns();
+    for (i = 0; i < log->count; i++) {
+        e  = &log->events[i];
+        t0 = bench_now_ns();
+        if (img && e->op == QLOG_COMPLETE) {
+            k = 1;
+            if (image_autocomplete(img, e->text, results, TOP_K_DEFAULT) > 0) hits[k]++;
+        } else if (img) {
+            k = e->op == QLOG_SEARCH ? 0 : 2;
+            if (image_find(img, e->text) >= 0) hits[k]++;
+        } else if (fed && e->op == QLOG_SEARCH) {
+            k = 0;
+            if (federation_lookup(fed, e->text, &found) >= 0) hits[k]++;
+        } else if (fed && e->op == QLOG_COMPLETE) {
+            k = 1;
+            if (federation_autocomplete(fed, e->text, results, TOP_K_DEFAULT, NULL) > 0)
+                hits[k]++;
+        } else if (fed) {
+            k = 2;
+            if (federation_record_selection(fed, e->text) >= 0) hits[k]++;
+        } else if (e->op == QLOG_SEARCH) {
+            k = 0;
+            if (store_find(&g_store, e->text)) hits[k]++;
+        } else if (e->op == QLOG_COMPLETE) {
+            k = 1;
+            if (active_autocomplete(e->text, results, TOP_K_DEFAULT, NULL) > 0) hits[k]++;
+        } else {
+            k = 2;
+            if (store_find(&g_store, e->text)) hits[k]++;
+            autocomplete_record_selection(e->text, &g_store, g_avl_root, trie_slot());
+        }
+        hist_record(&hist[k], bench_now_ns() - t0);
+    }
+    ms = (double)(bench_now_ns() - start) / 1e6;
+
+    printf("\n  %s: %d events on %s in %.1f ms", what, log->count, target, ms);
+    if (ms > 0.0) printf("  (%.0f events/s)", log->count / (ms / 1000.0));
+    printf("\n");
+    printf("  %-9s| %8s | %8s | %9s | %9s | %9s | %9s | %9s\n", "op", "count",
+           "hits", "mean us", "p50 us", "p95 us", "p99 us", "max us");
+    printf("  ---------+----------+----------+-----------+-----------+"
+           "-----------+-----------+-----------\n");
+    for (k = 0; k < 3; k++) {
+        if (hist[k].n == 0) continue;
+        hist_summary(&hist[k], &l);
+        printf("  %-9s| %8llu | %8d | %9.2f | %9.2f | %9.2f | %9.2f | %9.2f\n",
+               NAMES[k], (unsigned long long)l.n, hits[k], l.mean / 1e3,
+               l.p50 / 1e3, l.p95 / 1e3, l.p99 / 1e3, l.max / 1e3);
+    }
+    return 0;
+}
+
+/*
+ * --delete, --merge, --freq: one batch change to the saved session, then
+ * a full save.  The loader marks the batch and rebuilds BST, AVL, TBT
+ * and trie once (loader.h); the B+-tree is rebuilt once after it, and
+ * the indexes built on first use are dropped.  Returns the exit status.
+ */
+static int bulk_update(const char *prog, const char *mode, const char *path) {
+    const char *did;
+    int         n, before, ret = 0;
+
+    init_dictionary();
+    load_session();
+    before = g_word_count;
+    if (strcmp(mode, "--delete") == 0) {
+        did = "Deleted";
+        n   = load_delete_file(path, &g_store, bst_slot(), &g_avl_root,
+                               tbt_slot(), trie_slot());
+    } else if (strcmp(mode, "--merge") == 0) {
+        did = "Merged";
+        n   = load_words(path, &g_store, bst_slot(), &g_avl_root, tbt_slot(),
+                         trie_slot());
+    } else {
+        did = "Rescored";
+        n   = load_frequencies(path, &g_store, g_avl_root, trie_slot());
+    }
+
+    if (n < 0) {
+        fprintf(stderr, "%s: cannot read %s\n", prog, path);
+        ret = 2;
+    } else {
+        bpt_free(&g_bpt);              /* rebuilt by finish_load */
+        bk_free(&g_bk);
+        g_bk_built = 0;
+        suffix_free(&g_sfx);
+        fulltext_free(&g_fts);
+        finish_load();
+        g_word_count = avl_count(g_avl_root);
+        printf("%s %d word%s (%d -> %d words)\n", did, n, n == 1 ? "" : "s",
+               before, g_word_count);
+        if (n > 0 && g_word_count == 0) {
+            fprintf(stderr, "%s: the dictionary would be left empty; not saved\n", prog);
+            ret = 2;
+        } else if (n > 0 && save_dictionary() != 0) {
+            fprintf(stderr, "%s: cannot write %s\n", prog, FILE_CUSTOM_WORDS);
+            ret = 2;
+        }
+    }
+    journal_close(&g_journal);
+    free_dictionary();
+    return ret;
+}
+
+/* --publish: the saved session, frozen into an image (image.h) for other
+   processes to attach.  Returns the exit status. */
+static int publish_image(const char *prog, const char *path) {
+    int ret = 0;
+
+    init_dictionary();
+    load_session();
+    if (g_word_count == 0) {
+        fprintf(stderr, "%s: no dictionary loaded\n", prog);
+        ret = 2;
+    } else {
+        autocomplete_apply_decay(&g_store, g_avl_root, trie_slot());
+        if (image_publish(path, g_avl_root) != 0) {
+            fprintf(stderr, "%s: cannot write %s\n", prog, path);
+            ret = 2;
+        } else {
+            printf("Published %d words to %s\n", g_word_count, path);
+        }
+    }
+    journal_close(&g_journal);         /* nothing was logged to it */
+    free_dictionary();
+    return ret;
+}
+
+/*
+ * Run one command-line mode.  Returns the process exit status.
+ */
+static int run_headless(int argc, char **argv) {
+    BenchOptions  opt       = BENCH_OPTIONS_INIT;
+    ReplayOptions replay    = REPLAY_OPTIONS_INIT;
+    const char   *mode      = NULL, *mode_arg = NULL;
+    const char   *out       = NULL, *baseline = NULL;
+    double        threshold = BENCH_REGRESSION_PCT;
+    const char   *dicts[FED_MAX_MEMBERS];
+    Federation    fed;
+    DictImage     img;
+    const char   *image     = NULL;
+    QueryLog      log;
+    int           i, n, ret, ndicts = 0;
+
+    for (i = 1; i < argc; i++) {
+        const char *a    = argv[i];
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(a, "--help") == 0 || strcmp(a, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(a, "--bench") == 0 || strcmp(a, "--suite") == 0) {
+            if (mode) break;
+            mode = a;
+        } else if (!next) {
+            break;                     /* every other flag takes a value */
+        } else if (strcmp(a, "--lookup") == 0 || strcmp(a, "--complete") == 0 ||
+                   strcmp(a, "--replay") == 0 || strcmp(a, "--replay-all") == 0 ||
+                   strcmp(a, "--publish") == 0 || strcmp(a, "--delete") == 0 ||
+                   strcmp(a, "--merge") == 0 || strcmp(a, "--freq") == 0) {
+            if (mode) break;
+            mode = a; mode_arg = next; i++;
+        } else if (strcmp(a, "--tree") == 0) {
+            if (!(g_active_tree = tree_by_name(next))) break;
+            i++;
+        } else if (strcmp(a, "--out") == 0)       { out = next;                  i++;
+        } else if (strcmp(a, "--baseline") == 0)  { baseline = next;             i++;
+        } else if (strcmp(a, "--threshold") == 0) { threshold = atof(next);      i++;
+        } else if (strcmp(a, "--threads") == 0)   { replay.threads = atoi(next); i++;
+        } else if (strcmp(a, "--shards") == 0)    { replay.shards = atoi(next);  i++;
+        } else if (strcmp(a, "--words") == 0)     { opt.words_path = next;       i++;
+        } else if (strcmp(a, "--max") == 0)       { opt.max_words = atoi(next);  i++;
+        } else if (strcmp(a, "--reps") == 0)      { opt.reps = atoi(next);       i++;
+        } else if (strcmp(a, "--csv") == 0)       { opt.csv_path = next;         i++;
+        } else if (strcmp(a, "--image") == 0)     { image = next;                i++;
+        } else if (strcmp(a, "--dict") == 0) {
+            if (ndicts == FED_MAX_MEMBERS) break;
+            dicts[ndicts++] = next; i++;
+        } else {
+            break;
+        }
+    }
+    if (i < argc || !mode) {
+        if (i < argc) fprintf(stderr, "%s: bad or misplaced argument '%s'\n", argv[0], argv[i]);
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    if (strcmp(mode, "--bench") == 0) {
+        if (!out && !baseline) {
+            benchmark_run_all();
+            return 0;
+        }
+        ret = benchmark_against(out, baseline, threshold, NULL, NULL);
+        return ret < 0 ? 2 : (ret > 0 ? 1 : 0);
+    }
+    if (strcmp(mode, "--suite") == 0) {
+        benchmark_run_suite(&opt);
+        return 0;
+    }
+    if (strcmp(mode, "--publish") == 0) return publish_image(argv[0], mode_arg);
+    if (strcmp(mode, "--delete") == 0 || strcmp(mode, "--merge") == 0 ||
+        strcmp(mode, "--freq") == 0)
+        return bulk_update(argv[0], mode, mode_arg);
+
+    querylog_init(&log);
+    if (strcmp(mode, "--replay") == 0 || strcmp(mode, "--replay-all") == 0)
+        n = querylog_load(&log, mode_arg);
+    else
+        n = querylog_load_list(&log, mode_arg,
+                               strcmp(mode, "--lookup") == 0 ? QLOG_SEARCH : QLOG_COMPLETE);
+    if (n < 0) {
+        fprintf(stderr, "%s: cannot read %s\n", argv[0], mode_arg);
+        querylog_free(&log);
+        return 2;
+    }
+
+    if (strcmp(mode, "--replay-all") == 0) {
+        replay.words_path = opt.words_path;
+        ret = benchmark_against(out, baseline, threshold, &log, &replay);
+        querylog_free(&log);
+        return ret < 0 ? 2 : (ret > 0 ? 1 : 0);
+    }
+
+    if (image) {
+        /* --image: an attached image (image.h), nothing loaded */
+        if (image_attach(&img, image) != 0) {
+            fprintf(stderr, "%s: cannot attach %s\n", argv[0], image);
+            ret = 2;
+        } else {
+            ret = run_events(&log, mode_arg, NULL, &img);
+            image_detach(&img);
+        }
+        querylog_free(&log);
+        return ret;
+    }
+
+    if (ndicts > 0) {
+        /* --dict: the named files merged (federation.h), not the session */
+        federation_init(&fed);
+        for (i = 0; i < ndicts; i++) {
+            if (federation_add(&fed, dicts[i], dicts[i], FILE_WORD_FREQ) >= 0) continue;
+            fprintf(stderr, "%s: cannot load %s\n", argv[0], dicts[i]);
+            break;
+        }
+        ret = i < ndicts ? 2 : run_events(&log, mode_arg, &fed, NULL);
+        federation_free(&fed);
+        querylog_free(&log);
+        return ret;
+    }
+
+    init_dictionary();
+    load_session();
+    if (g_word_count == 0) {
+        fprintf(stderr, "%s: no dictionary loaded\n", argv[0]);
+        ret = 2;
+    } else {
+        ret = run_events(&log, mode_arg, NULL, NULL);
+    }
+    journal_close(&g_journal);         /* nothing was logged to it */
+    free_dictionary();
+    querylog_free(&log);
+    return ret;
+}
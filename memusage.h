@@ -0,0 +1,50 @@
+/* memusage.h - Memory accounting shared by every structure */
+#ifndef MEMUSAGE_H
+#define MEMUSAGE_H
+
+#include <stddef.h>   /* size_t */
+
+/*
+ * MemUsage - the bytes one structure holds, split by what they are for.
+ *
+ *   node_bytes      live nodes (or records, for the store): the structure
+ *                   proper, sizeof(node) per node in use
+ *   string_bytes    text the structure owns and uses: trie labels, B+
+ *                   separators, the store's definitions
+ *   overhead_bytes  allocated but not in use: free-listed and never-used
+ *                   pool slots, the unfilled tail of arena blocks, arena
+ *                   block headers
+ *   index_bytes     bookkeeping beside the nodes: slab tables, the store's
+ *                   word hash and pick arrays, the trie's cached top-k
+ *   entries         words held, for bytes per entry
+ *
+ * Every *_memory call adds to what u already holds, so one MemUsage can
+ * total several structures; clear it first with mem_usage_clear.  Counts
+ * are of the structures' own allocations (what malloc was asked for), not
+ * of malloc's headers.  The records belong to the store: a tree's
+ * footprint is its nodes, which point at them.
+ */
+typedef struct MemUsage {
+    size_t node_bytes;
+    size_t string_bytes;
+    size_t overhead_bytes;
+    size_t index_bytes;
+    size_t entries;
+} MemUsage;
+
+static inline void mem_usage_clear(MemUsage *u) {
+    u->node_bytes = u->string_bytes = u->overhead_bytes = u->index_bytes = 0;
+    u->entries = 0;
+}
+
+/* Every byte counted in u. */
+static inline size_t mem_usage_total(const MemUsage *u) {
+    return u->node_bytes + u->string_bytes + u->overhead_bytes + u->index_bytes;
+}
+
+/* Bytes per entry (0 if u holds none). */
+static inline double mem_usage_per_entry(const MemUsage *u) {
+    return u->entries ? (double)mem_usage_total(u) / (double)u->entries : 0.0;
+}
+
+#endif /* MEMUSAGE_H */
@@ -0,0 +1,142 @@
+/* pack_main.c - Build a packed dictionary (.sdz) from a word list */
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "store.h"
+#include "avl.h"
+#include "loader.h"
+#include "packed.h"
+#include "snapshot.h"
+
+/*
+ * Usage: pack_dict.exe [input] [output]
+ *
+ * Loads input (default words.txt; any format load_words reads, including
+ * a kaikki .jsonl dump), applies word_freq.txt, and writes the packed
+ * dictionary to output (default words.sdz) — the file to ship in place of
+ * words.txt.  An output ending in .snap is written as a snapshot
+ * (snapshot.h) instead: built from the dump, that is words.snap, which a
+ * first run maps as it is, ranked by the dump's own word counts, with no
+ * text parsed and no frequency pass.  The result is read back and
+ * checked word by word.
+ */
+
+static long file_size(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    long  n  = -1;
+    if (!fp) return -1;
+    if (fseek(fp, 0, SEEK_END) == 0) n = ftell(fp);
+    fclose(fp);
+    return n;
+}
+
+/* Does path end in ext (lowercase, with the dot), in any case? */
+static int has_extension(const char *path, const char *ext) {
+    size_t len = strlen(path), n = strlen(ext), i;
+    if (len < n) return 0;
+    for (i = 0; i < n; i++) {
+        char c = path[len - n + i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != ext[i]) return 0;
+    }
+    return 1;
+}
+
+typedef struct VerifyWalk {
+    PackedDict  *pd;         /* a packed output, or                     */
+    RecordStore *snap;       /* a snapshot output, loaded back          */
+    int          ordinal;
+    int          bad;
+} VerifyWalk;
+
+static int same_record(const WordRecord *got, const WordRecord *r) {
+    return strcmp(got->word, r->word) == 0 &&
+           strcmp(word_record_meaning(got), word_record_meaning(r)) == 0 &&
+           strcmp(got->part_of_speech, r->part_of_speech) == 0 &&
+           got->frequency_score == r->frequency_score &&
+           got->user_select_count == r->user_select_count;
+}
+
+static void verify_cb(AVLNode *node, void *arg) {
+    VerifyWalk       *v = (VerifyWalk *)arg;
+    const WordRecord *r = node->rec, *found;
+    WordRecord        got;
+
+    if (v->bad) return;
+    v->ordinal++;
+    if (v->snap) {
+        found = store_find(v->snap, r->word);
+        v->bad = !found || !same_record(found, r);
+    } else {
+        v->bad = packed_get(v->pd, v->ordinal - 1, &got) != 0 || !same_record(&got, r);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *in  = argc > 1 ? argv[1] : FILE_WORDS;
+    const char *out = argc > 2 ? argv[2] : FILE_WORDS_PACKED;
+    RecordStore store, snap;
+    AVLNode    *root = NULL, *snap_root = NULL;
+    PackedDict  pd;
+    VerifyWalk  v;
+    long        in_size, out_size;
+    int         n, m, as_snap = has_extension(out, ".snap");
+
+    store_init(&store);
+    n = load_words(in, &store, NULL, &root, NULL, NULL);
+    if (n < 0) {
+        fprintf(stderr, "pack_dict: cannot read %s\n", in);
+        return 1;
+    }
+    m = load_frequencies(FILE_WORD_FREQ, &store, root, NULL);
+    printf("Loaded %d words from %s", n, in);
+    if (m >= 0) printf("  (+%d freq updates)", m);
+    printf("\n");
+
+    if ((as_snap ? snapshot_save(out, root) : packed_save(out, root)) != 0) {
+        fprintf(stderr, "pack_dict: cannot write %s\n", out);
+        avl_free(&root);
+        store_free(&store);
+        return 1;
+    }
+
+    /* Read it back before anyone ships it */
+    v.pd      = &pd;
+    v.snap    = NULL;
+    v.ordinal = 0;
+    if (as_snap) {
+        store_init(&snap);
+        v.snap = &snap;
+        v.bad  = snapshot_load(out, &snap, NULL, &snap_root, NULL, NULL) != avl_count(root);
+        if (!v.bad) avl_inorder(root, verify_cb, &v);
+        avl_free(&snap_root);
+        store_free(&snap);
+    } else {
+        v.bad = packed_open(&pd, out) != 0;
+        if (!v.bad) {
+            avl_inorder(root, verify_cb, &v);
+            v.bad |= v.ordinal != packed_count(&pd);
+            packed_close(&pd);
+        }
+    }
+    if (v.bad) {
+        fprintf(stderr, "pack_dict: %s does not read back as written\n", out);
+        remove(out);
+        avl_free(&root);
+        store_free(&store);
+        return 1;
+    }
+
+    in_size  = file_size(in);
+    out_size = file_size(out);
+    printf("Wrote %s: %ld bytes", out, out_size);
+    if (in_size > 0 && out_size > 0)
+        printf(" (%s is %ld bytes, %.2fx smaller)", in, in_size,
+               (double)in_size / (double)out_size);
+    printf("\n");
+
+    avl_free(&root);
+    store_free(&store);
+    return 0;
+}
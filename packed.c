@@ -0,0 +1,655 @@
+/* packed.c - Compressed dictionary file implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "packed.h"
+#include "lz.h"
+
+#define PACK_MAGIC      "SDPACK\r\n"  /* 8 bytes; \r\n exposes text-mode damage */
+#define PACK_VERSION    1u
+#define PACK_HEADER     64u           /* bytes, the fields below in order */
+#define PACK_SLICE      256u          /* bytes per preset dictionary sample */
+#define PACK_RAW_MAX    (1u << 28)    /* larger meaning blocks are refused */
+#define PACK_NO_WORD    UINT32_MAX    /* cur_ord before any word is decoded */
+
+/* The header, at these byte offsets, each field a little-endian u32. */
+enum {
+    H_VERSION = 8, H_COUNT = 12, H_NUM_POS = 16, H_WORD_BLOCKS = 20,
+    H_TEXT_BLOCKS = 24, H_DICT_LEN = 28, H_POS_OFF = 32, H_WORDS_OFF = 36,
+    H_WINDEX_OFF = 40, H_TINDEX_OFF = 44, H_DICT_OFF = 48, H_TEXT_OFF = 52,
+    H_FILE_SIZE = 56, H_TEXT_RAW = 60
+};
+
+/* ── Encoding ────────────────────────────────────────────────── */
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)(v >> 8 & 0xFF);
+    p[2] = (unsigned char)(v >> 16 & 0xFF);
+    p[3] = (unsigned char)(v >> 24 & 0xFF);
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+           (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* A growable output section. */
+typedef struct ByteBuf {
+    unsigned char *p;
+    size_t         len;
+    size_t         cap;
+    int            failed;
+} ByteBuf;
+
+static unsigned char *buf_reserve(ByteBuf *b, size_t n) {
+    if (b->failed) return NULL;
+    if (b->len + n > b->cap) {
+        size_t         cap = b->cap ? b->cap : 4096;
+        unsigned char *grown;
+        while (cap < b->len + n) cap *= 2;
+        grown = (unsigned char *)realloc(b->p, cap);
+        if (!grown) {
+            b->failed = 1;
+            return NULL;
+        }
+        b->p   = grown;
+        b->cap = cap;
+    }
+    return b->p + b->len;
+}
+
+static void buf_put(ByteBuf *b, const void *data, size_t n) {
+    unsigned char *dst = buf_reserve(b, n);
+    if (!dst) return;
+    memcpy(dst, data, n);
+    b->len += n;
+}
+
+static void buf_u32(ByteBuf *b, uint32_t v) {
+    unsigned char tmp[4];
+    put_u32(tmp, v);
+    buf_put(b, tmp, sizeof(tmp));
+}
+
+/* LEB128: seven bits a byte, low bits first, high bit set on all but the
+   last. */
+static void buf_varint(ByteBuf *b, uint32_t v) {
+    unsigned char tmp[5];
+    size_t        n = 0;
+    while (v >= 0x80) {
+        tmp[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    tmp[n++] = (unsigned char)v;
+    buf_put(b, tmp, n);
+}
+
+/* Read a varint at *at of p[len].  Returns 0 if it runs off the end. */
+static int get_varint(const unsigned char *p, size_t len, size_t *at, uint32_t *v) {
+    uint32_t x = 0;
+    int      shift;
+    for (shift = 0; shift < 35 && *at < len; shift += 7) {
+        unsigned char c = p[(*at)++];
+        x |= (uint32_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) {
+            *v = x;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ── Writing ─────────────────────────────────────────────────── */
+
+typedef struct PackCollect {
+    const WordRecord **recs;
+    uint32_t           n;
+} PackCollect;
+
+static void collect_cb(AVLNode *node, void *arg) {
+    PackCollect *c = (PackCollect *)arg;
+    c->recs[c->n++] = node->rec;
+}
+
+/* The distinct POS tags in order of first use.  The store interns them,
+   so the pointer check usually settles it. */
+typedef struct PosTable {
+    const char **tags;
+    uint32_t     n;
+    uint32_t     cap;
+} PosTable;
+
+static int pos_id(PosTable *t, const char *pos, uint32_t *id) {
+    uint32_t i;
+    for (i = 0; i < t->n; i++)
+        if (t->tags[i] == pos || strcmp(t->tags[i], pos) == 0) {
+            *id = i;
+            return 1;
+        }
+    if (t->n == t->cap) {
+        uint32_t     cap   = t->cap ? t->cap * 2 : 64;
+        const char **grown = (const char **)realloc((void *)t->tags,
+                                                    cap * sizeof(const char *));
+        if (!grown) return 0;
+        t->tags = grown;
+        t->cap  = cap;
+    }
+    t->tags[t->n] = pos;
+    *id = t->n++;
+    return 1;
+}
+
+static size_t common_prefix(const char *a, const char *b) {
+    size_t i = 0;
+    while (a[i] && a[i] == b[i]) i++;
+    return i;
+}
+
+/*
+ * Fill dict[len] with PACK_SLICE-byte runs of meaning text taken at even
+ * steps through the records, so every part of the alphabet (and the
+ * phrasing common to all of it) has a sample to match against.
+ */
+static void sample_dict(const WordRecord **recs, uint32_t n, unsigned char *dict,
+                        uint32_t len) {
+    uint32_t slices = len / PACK_SLICE, k, filled = 0;
+
+    for (k = 0; k < slices; k++) {
+        uint32_t i = (uint32_t)((uint64_t)n * k / slices), end = (k + 1) * PACK_SLICE;
+        for (; i < n && filled < end; i++) {
+            const char *text = word_record_meaning(recs[i]);
+            size_t      m    = strlen(text) + 1;          /* with the NUL */
+            if (m > end - filled) m = end - filled;
+            memcpy(dict + filled, text, m);
+            filled += (uint32_t)m;
+        }
+    }
+    memset(dict + filled, 0, len - filled);
+}
+
+/* Compress raw[0..raw_len) as one text block onto text, and index it. */
+static void flush_block(ByteBuf *text, ByteBuf *tindex, const unsigned char *dict,
+                        uint32_t dict_len, const ByteBuf *raw, uint32_t first) {
+    size_t         bound = lz_bound(raw->len), clen;
+    unsigned char *dst   = buf_reserve(text, bound);
+
+    if (!dst) { tindex->failed = 1; return; }
+    clen = lz_compress_dict(dict, dict_len, raw->p, raw->len, dst, bound);
+    if (clen == 0 || text->len + clen > UINT32_MAX) { tindex->failed = 1; return; }
+    buf_u32(tindex, first);
+    buf_u32(tindex, (uint32_t)text->len);
+    buf_u32(tindex, (uint32_t)clen);
+    buf_u32(tindex, (uint32_t)raw->len);
+    text->len += clen;
+}
+
+static int write_all(FILE *fp, const void *p, size_t n) {
+    return n == 0 || fwrite(p, 1, n, fp) == n;
+}
+
+/* Write the sections of recs[0..n) (sorted, unique) to fp.  0 or -1. */
+static int write_packed(FILE *fp, const WordRecord **recs, uint32_t n) {
+    ByteBuf        pos = { 0 }, words = { 0 }, windex = { 0 }, tindex = { 0 };
+    ByteBuf        text = { 0 }, raw = { 0 };
+    PosTable       tags = { 0 };
+    unsigned char  head[PACK_HEADER], *dict = NULL;
+    uint32_t       i, id = 0, block_first = 0, dict_len = 0, blocks;
+    uint64_t       text_raw = 0;
+    const char    *prev = "";
+    int            failed = 0;
+
+    /* Also reads in every meaning still left in its file (lazytext.h) */
+    for (i = 0; i < n; i++) text_raw += strlen(word_record_meaning(recs[i])) + 1;
+    if (text_raw > UINT32_MAX) return -1;
+
+    /* A preset dictionary only pays for itself over many blocks */
+    if (text_raw >= 4u * PACK_DICT_SIZE) {
+        dict = (unsigned char *)malloc(PACK_DICT_SIZE);
+        if (!dict) return -1;
+        dict_len = PACK_DICT_SIZE;
+        sample_dict(recs, n, dict, dict_len);
+    }
+
+    /* Words, front-coded, and their meanings cut into blocks */
+    for (i = 0; i < n && !failed; i++) {
+        const WordRecord *r = recs[i];
+        const char *meaning = word_record_meaning(r);
+        size_t shared = i % PACK_WORD_BLOCK ? common_prefix(prev, r->word) : 0;
+        size_t suffix = strlen(r->word) - shared;
+
+        if (i % PACK_WORD_BLOCK == 0) buf_u32(&windex, (uint32_t)words.len);
+        if (!pos_id(&tags, r->part_of_speech, &id)) failed = 1;
+        buf_varint(&words, (uint32_t)shared);
+        buf_varint(&words, (uint32_t)suffix);
+        buf_put(&words, r->word + shared, suffix);
+        buf_varint(&words, id);
+        buf_varint(&words, (uint32_t)(r->frequency_score > 0 ? r->frequency_score : 0));
+        buf_varint(&words, (uint32_t)(r->user_select_count > 0 ? r->user_select_count : 0));
+        prev = r->word;
+
+        if (raw.len == 0) block_first = i;
+        buf_put(&raw, meaning, strlen(meaning) + 1);
+        if (raw.len >= PACK_TEXT_BLOCK) {
+            flush_block(&text, &tindex, dict, dict_len, &raw, block_first);
+            raw.len = 0;
+        }
+    }
+    if (raw.len > 0) flush_block(&text, &tindex, dict, dict_len, &raw, block_first);
+
+    for (i = 0; i < tags.n; i++) {
+        size_t len = strlen(tags.tags[i]);
+        unsigned char lb[2];
+        if (len > 0xFFFF) len = 0xFFFF;
+        lb[0] = (unsigned char)(len & 0xFF);
+        lb[1] = (unsigned char)(len >> 8);
+        buf_put(&pos, lb, 2);
+        buf_put(&pos, tags.tags[i], len);
+    }
+
+    failed |= pos.failed || words.failed || windex.failed || tindex.failed ||
+              text.failed || raw.failed;
+    if (!failed && (uint64_t)PACK_HEADER + pos.len + words.len + windex.len +
+                   tindex.len + dict_len + text.len > 0x7FFFFFFFu)
+        failed = 1;   /* offsets are read back as longs */
+
+    if (!failed) {
+        uint32_t off = PACK_HEADER;
+        blocks = (uint32_t)(tindex.len / 16);
+        memset(head, 0, sizeof(head));
+        memcpy(head, PACK_MAGIC, 8);
+        put_u32(head + H_VERSION, PACK_VERSION);
+        put_u32(head + H_COUNT, n);
+        put_u32(head + H_NUM_POS, tags.n);
+        put_u32(head + H_WORD_BLOCKS, (uint32_t)(windex.len / 4));
+        put_u32(head + H_TEXT_BLOCKS, blocks);
+        put_u32(head + H_DICT_LEN, dict_len);
+        put_u32(head + H_POS_OFF, off);    off += (uint32_t)pos.len;
+        put_u32(head + H_WORDS_OFF, off);  off += (uint32_t)words.len;
+        put_u32(head + H_WINDEX_OFF, off); off += (uint32_t)windex.len;
+        put_u32(head + H_TINDEX_OFF, off); off += (uint32_t)tindex.len;
+        put_u32(head + H_DICT_OFF, off);   off += dict_len;
+        put_u32(head + H_TEXT_OFF, off);   off += (uint32_t)text.len;
+        put_u32(head + H_FILE_SIZE, off);
+        put_u32(head + H_TEXT_RAW, (uint32_t)text_raw);
+
+        failed = !write_all(fp, head, sizeof(head)) ||
+                 !write_all(fp, pos.p, pos.len) || !write_all(fp, words.p, words.len) ||
+                 !write_all(fp, windex.p, windex.len) ||
+                 !write_all(fp, tindex.p, tindex.len) ||
+                 !write_all(fp, dict, dict_len) || !write_all(fp, text.p, text.len);
+    }
+
+    free(pos.p);
+    free(words.p);
+    free(windex.p);
+    free(tindex.p);
+    free(text.p);
+    free(raw.p);
+    free((void *)tags.tags);
+    free(dict);
+    return failed ? -1 : 0;
+}
+
+/* ── Reading ─────────────────────────────────────────────────── */
+
+/*
+ * Decode the word entry at *at after prev (the previous word of the block,
+ * ignored when shared is 0) into word.  Returns 0 if it is malformed.
+ */
+static int decode_entry(const PackedDict *pd, size_t *at, char *word,
+                        uint32_t *pos, uint32_t *freq, uint32_t *picks) {
+    uint32_t shared, suffix;
+    if (!get_varint(pd->words, pd->words_len, at, &shared) ||
+        !get_varint(pd->words, pd->words_len, at, &suffix))
+        return 0;
+    if (shared > strlen(word) || suffix > MAX_WORD_LEN - 1 - shared ||
+        suffix > pd->words_len - *at)
+        return 0;
+    memcpy(word + shared, pd->words + *at, suffix);
+    word[shared + suffix] = '\0';
+    *at += suffix;
+    return get_varint(pd->words, pd->words_len, at, pos) &&
+           get_varint(pd->words, pd->words_len, at, freq) &&
+           get_varint(pd->words, pd->words_len, at, picks) && *pos < pd->num_pos;
+}
+
+/* Read n bytes at off into a new buffer (n may be 0).  NULL on error. */
+static unsigned char *read_at(FILE *fp, uint32_t off, uint32_t n) {
+    unsigned char *p = (unsigned char *)malloc(n ? n : 1);
+    if (!p) return NULL;
+    if (n > 0 && (fseek(fp, (long)off, SEEK_SET) != 0 || fread(p, 1, n, fp) != n)) {
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+static int parse_pos(PackedDict *pd, const unsigned char *p, uint32_t len) {
+    uint32_t i, at = 0;
+
+    pd->pos = (char **)calloc(pd->num_pos ? pd->num_pos : 1, sizeof(char *));
+    if (!pd->pos) return 0;
+    for (i = 0; i < pd->num_pos; i++) {
+        uint32_t n;
+        if (len - at < 2) return 0;
+        n   = (uint32_t)p[at] | (uint32_t)p[at + 1] << 8;
+        at += 2;
+        if (n > len - at || memchr(p + at, '\0', n)) return 0;
+        pd->pos[i] = (char *)malloc(n + 1);
+        if (!pd->pos[i]) return 0;
+        memcpy(pd->pos[i], p + at, n);
+        pd->pos[i][n] = '\0';
+        at += n;
+    }
+    return at == len;
+}
+
+/* Decode every word once: block heads, lengths, POS ids and order. */
+static int check_words(PackedDict *pd) {
+    char     word[MAX_WORD_LEN] = "", prev[MAX_WORD_LEN] = "";
+    DictKey  key;
+    size_t   at = 0;
+    uint32_t i, pos, freq, picks;
+
+    for (i = 0; i < pd->count; i++) {
+        if (i % PACK_WORD_BLOCK == 0) {
+            if (pd->word_index[i / PACK_WORD_BLOCK] != at) return 0;
+            word[0] = '\0';      /* a head must not share a prefix */
+        }
+        if (!decode_entry(pd, &at, word, &pos, &freq, &picks) || word[0] == '\0')
+            return 0;
+        dict_key_init(&key, word);
+        if (strcmp(key.text, word) != 0 || (i > 0 && strcmp(prev, word) >= 0))
+            return 0;
+        memcpy(prev, word, sizeof(prev));
+    }
+    return at == pd->words_len;
+}
+
+static int check_text_index(const PackedDict *pd, uint32_t text_len) {
+    uint32_t i, off = 0;
+    for (i = 0; i < pd->text_blocks; i++) {
+        const PackedTextBlock *b = &pd->text_index[i];
+        if (b->first >= pd->count || (i == 0 ? b->first != 0 : b->first <= b[-1].first) ||
+            b->offset != off || b->comp_len > text_len - off ||
+            b->raw_len == 0 || b->raw_len > PACK_RAW_MAX)
+            return 0;
+        off += b->comp_len;
+    }
+    return off == text_len && (pd->count == 0) == (pd->text_blocks == 0);
+}
+
+/* Read pd->fp's sections in.  Returns 1 if they are all well-formed. */
+static int open_sections(PackedDict *pd) {
+    unsigned char  head[PACK_HEADER], *p;
+    uint32_t       off[7], size, i;
+    long           actual;
+
+    if (fread(head, 1, sizeof(head), pd->fp) != sizeof(head) ||
+        memcmp(head, PACK_MAGIC, 8) != 0 || get_u32(head + H_VERSION) != PACK_VERSION)
+        return 0;
+    pd->count       = get_u32(head + H_COUNT);
+    pd->num_pos     = get_u32(head + H_NUM_POS);
+    pd->word_blocks = get_u32(head + H_WORD_BLOCKS);
+    pd->text_blocks = get_u32(head + H_TEXT_BLOCKS);
+    pd->dict_len    = get_u32(head + H_DICT_LEN);
+    for (i = 0; i < 7; i++) off[i] = get_u32(head + H_POS_OFF + 4 * i);
+    size = off[6];
+
+    /* The sections follow one another in order, up to file_size */
+    if (fseek(pd->fp, 0, SEEK_END) != 0 || (actual = ftell(pd->fp)) < 0 ||
+        (uint32_t)actual != size || off[0] != PACK_HEADER || size > 0x7FFFFFFFu)
+        return 0;
+    for (i = 1; i < 7; i++)
+        if (off[i] < off[i - 1]) return 0;
+    if (pd->count > INT32_MAX || pd->num_pos > 0xFFFFFF ||
+        pd->word_blocks != (pd->count + PACK_WORD_BLOCK - 1) / PACK_WORD_BLOCK ||
+        off[3] - off[2] != 4u * pd->word_blocks ||
+        (off[4] - off[3]) / 16 != pd->text_blocks || (off[4] - off[3]) % 16 != 0 ||
+        off[5] - off[4] != pd->dict_len || pd->dict_len > 65535)
+        return 0;
+
+    p = read_at(pd->fp, off[0], off[1] - off[0]);
+    if (!p) return 0;
+    i = (uint32_t)parse_pos(pd, p, off[1] - off[0]);
+    free(p);
+    if (!i) return 0;
+
+    pd->words_len = off[2] - off[1];
+    pd->words     = read_at(pd->fp, off[1], off[2] - off[1]);
+    pd->dict      = read_at(pd->fp, off[4], pd->dict_len);
+    p             = read_at(pd->fp, off[2], off[4] - off[2]);
+    pd->word_index = (uint32_t *)malloc((pd->word_blocks ? pd->word_blocks : 1) * sizeof(uint32_t));
+    pd->text_index = (PackedTextBlock *)malloc((pd->text_blocks ? pd->text_blocks : 1) *
+                                               sizeof(PackedTextBlock));
+    if (!pd->words || !pd->dict || !p || !pd->word_index || !pd->text_index) {
+        free(p);
+        return 0;
+    }
+    for (i = 0; i < pd->word_blocks; i++) pd->word_index[i] = get_u32(p + 4 * i);
+    for (i = 0; i < pd->text_blocks; i++) {
+        const unsigned char *e = p + 4u * pd->word_blocks + 16u * i;
+        pd->text_index[i].first    = get_u32(e);
+        pd->text_index[i].offset   = get_u32(e + 4);
+        pd->text_index[i].comp_len = get_u32(e + 8);
+        pd->text_index[i].raw_len  = get_u32(e + 12);
+    }
+    free(p);
+
+    pd->text_off = (long)off[5];
+    return check_words(pd) && check_text_index(pd, size - off[5]);
+}
+
+/* Decompress text block b into pd->block.  Returns 0 on error. */
+static int load_block(PackedDict *pd, uint32_t b) {
+    const PackedTextBlock *tb = &pd->text_index[b];
+
+    if (pd->cached == (long)b) return 1;
+    pd->cached = -1;
+    if (tb->raw_len + 1u > pd->block_cap) {
+        char *grown = (char *)realloc(pd->block, tb->raw_len + 1u);
+        if (!grown) return 0;
+        pd->block     = grown;
+        pd->block_cap = tb->raw_len + 1u;
+    }
+    if (tb->comp_len > pd->comp_cap) {
+        unsigned char *grown = (unsigned char *)realloc(pd->comp, tb->comp_len);
+        if (!grown) return 0;
+        pd->comp     = grown;
+        pd->comp_cap = tb->comp_len;
+    }
+    if (fseek(pd->fp, pd->text_off + (long)tb->offset, SEEK_SET) != 0 ||
+        fread(pd->comp, 1, tb->comp_len, pd->fp) != tb->comp_len ||
+        lz_decompress_dict(pd->dict, pd->dict_len, pd->comp, tb->comp_len,
+                           (unsigned char *)pd->block, tb->raw_len) != tb->raw_len)
+        return 0;
+    pd->block[tb->raw_len] = '\0';   /* a bad block cannot run a meaning off the end */
+    pd->cached   = (long)b;
+    pd->text_ord = tb->first;
+    pd->text_at  = 0;
+    return 1;
+}
+
+/* The meaning of ordinal, from its block.  NULL on error. */
+static const char *meaning_at(PackedDict *pd, uint32_t ordinal) {
+    uint32_t lo = 0, hi = pd->text_blocks;
+    const PackedTextBlock *tb;
+
+    /* Last block whose first ordinal is <= ordinal */
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (pd->text_index[mid].first <= ordinal) lo = mid;
+        else                                     hi = mid;
+    }
+    if (!load_block(pd, lo)) return NULL;
+    tb = &pd->text_index[lo];
+    if (ordinal < pd->text_ord) {
+        pd->text_ord = tb->first;
+        pd->text_at  = 0;
+    }
+    while (pd->text_ord < ordinal) {
+        const char *nul = (const char *)memchr(pd->block + pd->text_at, '\0',
+                                               tb->raw_len - pd->text_at);
+        if (!nul || (size_t)(nul - pd->block) + 1 >= tb->raw_len) return NULL;
+        pd->text_at = (size_t)(nul - pd->block) + 1;
+        pd->text_ord++;
+    }
+    return pd->block + pd->text_at;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int packed_save(const char *path, AVLNode *avl_root) {
+    char        tmp[512];
+    PackCollect c;
+    FILE       *fp;
+    int         n = avl_count(avl_root), failed;
+
+    if (!path) return -1;
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    c.recs = (const WordRecord **)malloc((size_t)(n > 0 ? n : 1) * sizeof(WordRecord *));
+    if (!c.recs) return -1;
+    c.n = 0;
+    avl_inorder(avl_root, collect_cb, &c);
+
+    fp = fopen(tmp, "wb");
+    if (!fp) {
+        free((void *)c.recs);
+        return -1;
+    }
+    failed = write_packed(fp, c.recs, c.n) != 0;
+    if (fclose(fp) != 0) failed = 1;
+    free((void *)c.recs);
+    if (failed) {
+        remove(tmp);
+        return -1;
+    }
+
+#ifdef _WIN32
+    remove(path);   /* rename does not replace an existing file here */
+#endif
+    if (rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int packed_open(PackedDict *pd, const char *path) {
+    if (!pd) return -1;
+    memset(pd, 0, sizeof(PackedDict));
+    pd->cached  = -1;
+    pd->cur_ord = PACK_NO_WORD;
+    if (!path || !(pd->fp = fopen(path, "rb"))) return -1;
+    if (!open_sections(pd)) {
+        packed_close(pd);
+        return -1;
+    }
+    return 0;
+}
+
+int packed_count(const PackedDict *pd) {
+    return pd ? (int)pd->count : 0;
+}
+
+int packed_find(PackedDict *pd, const char *word) {
+    DictKey  key;
+    char     cur[MAX_WORD_LEN];
+    size_t   at;
+    uint32_t lo = 0, hi, i, end, pos, freq, picks;
+
+    if (!pd || !word || pd->count == 0) return -1;
+    dict_key_init(&key, word);
+
+    /* Last block whose head sorts at or before the key */
+    hi = pd->word_blocks;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        cur[0] = '\0';
+        at = pd->word_index[mid];
+        decode_entry(pd, &at, cur, &pos, &freq, &picks);   /* checked at open */
+        if (strcmp(cur, key.text) <= 0) lo = mid;
+        else                            hi = mid;
+    }
+
+    cur[0] = '\0';
+    at  = pd->word_index[lo];
+    end = (lo + 1) * PACK_WORD_BLOCK < pd->count ? (lo + 1) * PACK_WORD_BLOCK : pd->count;
+    for (i = lo * PACK_WORD_BLOCK; i < end; i++) {
+        int cmp;
+        decode_entry(pd, &at, cur, &pos, &freq, &picks);
+        cmp = strcmp(cur, key.text);
+        if (cmp == 0) return (int)i;
+        if (cmp > 0) break;
+    }
+    return -1;
+}
+
+/* Decode the word at ordinal into out (meaning ""), moving the cursor. */
+static int get_word(PackedDict *pd, uint32_t ord, WordRecord *out) {
+    uint32_t pos = 0, freq = 0, picks = 0;
+
+    /* The next word continues from the cursor; any other restarts its block */
+    if (pd->cur_ord == PACK_NO_WORD || ord != pd->cur_ord + 1 ||
+        ord % PACK_WORD_BLOCK == 0) {
+        pd->cur_ord     = ord - ord % PACK_WORD_BLOCK;
+        pd->cur_at      = pd->word_index[ord / PACK_WORD_BLOCK];
+        pd->cur_word[0] = '\0';
+        decode_entry(pd, &pd->cur_at, pd->cur_word, &pos, &freq, &picks);
+    } else {
+        pd->cur_ord++;
+        decode_entry(pd, &pd->cur_at, pd->cur_word, &pos, &freq, &picks);
+    }
+    while (pd->cur_ord < ord) {
+        pd->cur_ord++;
+        decode_entry(pd, &pd->cur_at, pd->cur_word, &pos, &freq, &picks);
+    }
+
+    word_record_init(out);
+    memcpy(out->word, pd->cur_word, sizeof(out->word));
+    out->part_of_speech = pd->pos[pos];
+    if (freq > 0 && freq <= INT32_MAX)  out->frequency_score   = (int)freq;
+    if (picks <= INT32_MAX)             out->user_select_count = (int)picks;
+    out->id = -1;
+    return 0;
+}
+
+int packed_get(PackedDict *pd, int ordinal, WordRecord *out) {
+    const char *meaning;
+
+    if (!pd || !out || ordinal < 0 || (uint32_t)ordinal >= pd->count) return -1;
+    meaning = meaning_at(pd, (uint32_t)ordinal);
+    if (!meaning) return -1;
+    get_word(pd, (uint32_t)ordinal, out);
+    out->meaning = meaning;
+    return 0;
+}
+
+int packed_get_word(PackedDict *pd, int ordinal, WordRecord *out) {
+    if (!pd || !out || ordinal < 0 || (uint32_t)ordinal >= pd->count) return -1;
+    return get_word(pd, (uint32_t)ordinal, out);
+}
+
+const char *packed_meaning(PackedDict *pd, int ordinal) {
+    if (!pd || ordinal < 0 || (uint32_t)ordinal >= pd->count) return NULL;
+    return meaning_at(pd, (uint32_t)ordinal);
+}
+
+void packed_close(PackedDict *pd) {
+    uint32_t i;
+    if (!pd) return;
+    if (pd->fp) fclose(pd->fp);
+    if (pd->pos)
+        for (i = 0; i < pd->num_pos; i++) free(pd->pos[i]);
+    free(pd->pos);
+    free(pd->words);
+    free(pd->word_index);
+    free(pd->text_index);
+    free(pd->dict);
+    free(pd->block);
+    free(pd->comp);
+    memset(pd, 0, sizeof(PackedDict));
+    pd->cached = -1;
+}
@@ -0,0 +1,113 @@
+/* packed.h - Compressed, randomly accessible dictionary file */
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "dictionary.h"
+#include "avl.h"
+
+/*
+ * Packed dictionary (.sdz) - the dictionary as shipped: small on disk
+ * and readable a word at a time without unpacking the rest.
+ *
+ *   [header]       magic, version, counts, section offsets, file size
+ *   [pos table]    each distinct POS tag once: [len:2][bytes]
+ *   [words]        every word in sorted order, front-coded:
+ *                  [shared][suffix len][suffix][pos id][freq][picks]
+ *                  (varints) — shared is the prefix length kept from the
+ *                  previous word, 0 at the head of each PACK_WORD_BLOCK
+ *   [word index]   byte offset of each word block's head
+ *   [text index]   per meaning block: first ordinal, offset and size
+ *                  compressed, size raw
+ *   [preset dict]  sample meaning text every block is compressed against
+ *   [text]         the meanings in word order, NUL-terminated, cut into
+ *                  blocks of about PACK_TEXT_BLOCK bytes, each compressed
+ *                  on its own (lz.h)
+ *
+ * Every integer is little-endian whatever the host, so one file serves
+ * every machine.  Words and scores are small and read in full at open;
+ * a meaning costs one seek, one read and one decompression of its block,
+ * and the last block read is cached, so neighbours come free.
+ */
+
+#define PACK_WORD_BLOCK  32       /* words per front-coding restart       */
+#define PACK_TEXT_BLOCK  4096     /* raw meaning bytes per compressed block */
+#define PACK_DICT_SIZE   32768    /* bytes of preset dictionary            */
+
+typedef struct PackedTextBlock {
+    uint32_t first;      /* ordinal of the block's first meaning */
+    uint32_t offset;     /* compressed bytes, from the text section */
+    uint32_t comp_len;
+    uint32_t raw_len;
+} PackedTextBlock;
+
+typedef struct PackedDict {
+    FILE            *fp;
+    uint32_t         count;         /* words                          */
+    uint32_t         num_pos;
+    char           **pos;           /* num_pos NUL-terminated tags    */
+    unsigned char   *words;         /* the front-coded word section   */
+    size_t           words_len;
+    uint32_t         word_blocks;
+    uint32_t        *word_index;
+    uint32_t         text_blocks;
+    PackedTextBlock *text_index;
+    unsigned char   *dict;          /* preset dictionary              */
+    uint32_t         dict_len;
+    long             text_off;      /* file offset of the text section */
+    /* Sequential cursor over the words: ordinal cur_ord is cur_word */
+    uint32_t         cur_ord;
+    size_t           cur_at;        /* offset of the entry after it   */
+    char             cur_word[MAX_WORD_LEN];
+    /* The last meaning block read */
+    long             cached;        /* block number, or -1            */
+    char            *block;
+    size_t           block_cap;
+    unsigned char   *comp;
+    size_t           comp_cap;
+    uint32_t         text_ord;      /* meaning text_ord starts at text_at */
+    size_t           text_at;
+} PackedDict;
+
+/*
+ * Write every record of the tree rooted at avl_root to path, under a
+ * temporary name renamed into place.  Returns 0 on success, -1 on error.
+ */
+int packed_save(const char *path, AVLNode *avl_root);
+
+/*
+ * Open the packed file at path: read and check the header, POS table,
+ * words and indexes (meanings stay on disk).  The file stays open until
+ * packed_close.  Returns 0, or -1 if it is missing or malformed.
+ */
+int packed_open(PackedDict *pd, const char *path);
+
+/* Number of words in an open file. */
+int packed_count(const PackedDict *pd);
+
+/* Ordinal (sort position) of word, case-insensitive, or -1 if absent.
+   A binary search over the block heads, then one block decoded. */
+int packed_find(PackedDict *pd, const char *word);
+
+/*
+ * Fill out with the word at ordinal: word, POS, scores, and the meaning,
+ * which points into pd's block cache and stays valid only until the next
+ * call on pd.  out->id is -1.  Reading ordinals in increasing order
+ * decodes each word and block once.  Returns 0, or -1 if ordinal is out
+ * of range or its block cannot be read.
+ */
+int packed_get(PackedDict *pd, int ordinal, WordRecord *out);
+
+/* The same without the meaning (left ""): no text block is read. */
+int packed_get_word(PackedDict *pd, int ordinal, WordRecord *out);
+
+/* Just the meaning at ordinal, valid until the next call on pd: one
+   block read and decompressed, unless it is the cached one.  NULL if
+   ordinal is out of range or the block cannot be read. */
+const char *packed_meaning(PackedDict *pd, int ordinal);
+
+/* Release everything and close the file. */
+void packed_close(PackedDict *pd);
+
+#endif /* PACKED_H */
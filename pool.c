@@ -0,0 +1,154 @@
+/* pool.c - Fixed-size node pool allocator implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+#include "config.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+#define POOL_TABLE_MIN  16       /* first slab table's capacity */
+
+/* Grow the slab table (and its address order) to twice the size.  The
+   copy is complete before it is published (POOL_TABLE_STORE), and the
+   old table is kept for readers that may still hold it.  Returns 0 on
+   failure. */
+static int pool_grow_table(NodePool *p) {
+    int    cap = p->cap_slabs ? p->cap_slabs * 2 : POOL_TABLE_MIN;
+    char **tbl;
+    int   *order;
+
+    if (p->slabs && p->num_old == POOL_TABLES_MAX) return 0;
+    tbl   = (char **)malloc((size_t)cap * sizeof(char *));
+    order = (int *)realloc(p->by_addr, (size_t)cap * sizeof(int));
+    if (order) p->by_addr = order;
+    if (!tbl || !order) {
+        free(tbl);
+        return 0;
+    }
+    if (p->slabs) {
+        memcpy(tbl, p->slabs, (size_t)p->num_slabs * sizeof(char *));
+        p->old_tables[p->num_old++] = p->slabs;
+    }
+    POOL_TABLE_STORE(p, tbl);
+    p->cap_slabs = cap;
+    return 1;
+}
+
+/* Append one slab to the pool. Returns 0 on failure. */
+static int pool_add_slab(NodePool *p) {
+    char     *slab;
+    uintptr_t at;
+    int       i;
+
+    if ((long long)(p->num_slabs + 1) * POOL_SLAB_NODES > (long long)POOL_SLOTS_MAX)
+        return 0;
+    if (p->num_slabs == p->cap_slabs && !pool_grow_table(p)) return 0;
+
+    slab = (char *)malloc((size_t)POOL_SLAB_NODES * p->node_size);
+    if (!slab) return 0;
+
+    /* Keep by_addr sorted: slabs are few, so an insertion is enough */
+    at = (uintptr_t)slab;
+    for (i = p->num_slabs; i > 0 && (uintptr_t)p->slabs[p->by_addr[i - 1]] > at; i--)
+        p->by_addr[i] = p->by_addr[i - 1];
+    p->by_addr[i] = p->num_slabs;
+    p->slabs[p->num_slabs++] = slab;
+    return 1;
+}
+
+/* Slot of the node at offset off bytes into slab s. */
+static uint32_t slot_in(const NodePool *p, int s, uintptr_t off) {
+    return (uint32_t)((size_t)s * POOL_SLAB_NODES + off / p->node_size) + 1;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void *pool_alloc(NodePool *p) {
+    void *node;
+
+    /* Recycled nodes first — keeps the working set compact */
+    if (p->free_list) {
+        node = p->free_list;
+        memcpy(&p->free_list, node, sizeof(void *));
+        p->live++;
+        return node;
+    }
+
+    /* Current slab exhausted: move on to the next kept slab, or grow */
+    if (p->num_slabs == 0 || p->bump == POOL_SLAB_NODES) {
+        if (p->num_slabs > 0 && p->cur_slab + 1 < p->num_slabs) {
+            p->cur_slab++;
+        } else {
+            if (!pool_add_slab(p)) return NULL;
+            p->cur_slab = p->num_slabs - 1;
+        }
+        p->bump = 0;
+    }
+
+    node = p->slabs[p->cur_slab] + (size_t)p->bump * p->node_size;
+    p->bump++;
+    p->live++;
+    return node;
+}
+
+uint32_t pool_slot(const NodePool *p, const void *node) {
+    uintptr_t at   = (uintptr_t)node;
+    size_t    span = (size_t)POOL_SLAB_NODES * p->node_size;
+    int       lo, hi, mid;
+
+    if (!node || p->num_slabs == 0) return 0;
+    /* Most nodes asked about were just carved from the current slab */
+    if (at - (uintptr_t)p->slabs[p->cur_slab] < span)
+        return slot_in(p, p->cur_slab, at - (uintptr_t)p->slabs[p->cur_slab]);
+
+    /* Otherwise the last slab starting at or below node */
+    lo = 0;
+    hi = p->num_slabs - 1;
+    while (lo < hi) {
+        mid = lo + (hi - lo + 1) / 2;
+        if ((uintptr_t)p->slabs[p->by_addr[mid]] <= at) lo = mid;
+        else                                          hi = mid - 1;
+    }
+    return slot_in(p, p->by_addr[lo], at - (uintptr_t)p->slabs[p->by_addr[lo]]);
+}
+
+void pool_release(NodePool *p, void *node) {
+    if (!node) return;
+    /* Intrusive link: the dead node's first bytes point at the old head */
+    memcpy(node, &p->free_list, sizeof(void *));
+    p->free_list = node;
+    p->live--;
+}
+
+void pool_reset(NodePool *p) {
+    p->cur_slab  = 0;
+    p->bump      = 0;
+    p->free_list = NULL;
+    p->live      = 0;
+}
+
+void pool_memory(const NodePool *p, MemUsage *u) {
+    size_t live = (size_t)p->live * p->node_size;
+    u->node_bytes     += live;
+    u->overhead_bytes += (size_t)p->num_slabs * POOL_SLAB_NODES * p->node_size - live;
+    u->index_bytes    += (size_t)p->cap_slabs * (sizeof(char *) + sizeof(int));
+    if (p->num_old > 0)          /* the outgrown tables: 16 + 32 + ... */
+        u->index_bytes += (size_t)(p->cap_slabs - POOL_TABLE_MIN) * sizeof(char *);
+}
+
+void pool_destroy(NodePool *p) {
+    int i;
+    for (i = 0; i < p->num_slabs; i++)
+        free(p->slabs[i]);
+    for (i = 0; i < p->num_old; i++)
+        free(p->old_tables[i]);
+    free(p->slabs);
+    free(p->by_addr);
+    p->slabs     = NULL;
+    p->by_addr   = NULL;
+    p->num_old   = 0;
+    p->num_slabs = 0;
+    p->cap_slabs = 0;
+    pool_reset(p);
+}
@@ -0,0 +1,103 @@
+/* pool.h - Fixed-size node pool allocator with free list and bulk release */
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>   /* size_t */
+#include <stdint.h>
+#include "config.h"
+#include "memusage.h"
+
+/*
+ * NodePool - slab allocator for one node type (BSTNode, AVLNode, TBTNode).
+ *
+ * Nodes are carved out of slabs of POOL_SLAB_NODES nodes each, so loading
+ * 90 000 words costs ~22 malloc calls per tree instead of 90 000.
+ * Released nodes go onto an intrusive free list (the first pointer-sized
+ * bytes of a dead node hold the next link) and are handed out again
+ * before any fresh slot, so insert/delete churn never touches malloc.
+ *
+ *   pool_reset   — O(slabs): forget every node at once, keep the slabs,
+ *                  so the next load is allocation-free
+ *   pool_destroy — O(slabs): give the slabs back to the C library
+ *
+ * Slots: every node also has a 32-bit slot number, its 1-based position
+ * across the slabs (0 stands for no node).  Trees that link their nodes
+ * by slot instead of by pointer (AVL, TBT) halve the size of each link;
+ * pool_node turns a slot back into its node with one slab-table load.
+ *
+ * Readers and one writer: a grown slab table is filled in first, then
+ * published with a release store (POOL_TABLE_STORE), and pool_node reads
+ * the table with an acquire load (POOL_TABLE_LOAD).  A reader decoding
+ * slots while a writer of another tree grows the same pool therefore
+ * sees either the old table or the new one with every entry in place.
+ * The old table is kept until pool_destroy, so it is never freed under
+ * the reader.  The slot itself must still reach the reader through the
+ * lock that publishes its tree (dict_handle.h), which also makes the
+ * slab it names visible.  Keeping the slab pointer visible is all this
+ * guarantees: pool_alloc, pool_release, pool_reset and pool_destroy are
+ * not thread-safe and need one writer at a time.
+ *
+ * Each tree module owns one static pool shared by every tree of that
+ * type; see bst_pool_reset() and friends.
+ */
+#define POOL_TABLES_MAX  32      /* slab tables one pool can outgrow    */
+
+/* Publish / read the slab table pointer with release / acquire order.
+   MSVC's volatile accesses have that order by default (/volatile:ms). */
+#if defined(__GNUC__) || defined(__clang__)
+#define POOL_TABLE_LOAD(p)       __atomic_load_n(&(p)->slabs, __ATOMIC_ACQUIRE)
+#define POOL_TABLE_STORE(p, t)   __atomic_store_n(&(p)->slabs, (t), __ATOMIC_RELEASE)
+#elif defined(_MSC_VER)
+#define POOL_TABLE_LOAD(p)       (*(char **volatile const *)&(p)->slabs)
+#define POOL_TABLE_STORE(p, t)   (*(char **volatile *)&(p)->slabs = (t))
+#else
+#error "pool.h: no release/acquire access for the slab table on this compiler"
+#endif
+#define POOL_SLOTS_MAX   0x7FFFFFFFu  /* slots fit in 31 bits           */
+
+typedef struct NodePool {
+    size_t   node_size;   /* bytes per node, >= sizeof(void *)      */
+    char   **slabs;       /* slab table (POOL_TABLE_LOAD to read it
+                             where a writer may be growing it)      */
+    int      num_slabs;   /* slabs allocated                        */
+    int      cap_slabs;   /* capacity of the slab table             */
+    int      cur_slab;    /* slab currently being bump-allocated    */
+    int      bump;        /* next never-used node in slabs[cur_slab] */
+    void    *free_list;   /* released nodes, most recent first      */
+    int      live;        /* nodes currently handed out             */
+    int     *by_addr;     /* slab numbers sorted by address (pool_slot) */
+    char   **old_tables[POOL_TABLES_MAX];  /* outgrown slab tables  */
+    int      num_old;
+} NodePool;
+
+/* Static initialiser: static NodePool p = NODE_POOL_INIT(BSTNode); */
+#define NODE_POOL_INIT(type)  { sizeof(type), NULL, 0, 0, 0, 0, NULL, 0, NULL, { NULL }, 0 }
+
+/* The node in slot (from pool_slot), or NULL for slot 0.  O(1). */
+static inline void *pool_node(const NodePool *p, uint32_t slot) {
+    if (slot == 0) return NULL;
+    slot--;
+    return POOL_TABLE_LOAD(p)[slot / POOL_SLAB_NODES] +
+           (size_t)(slot % POOL_SLAB_NODES) * p->node_size;
+}
+
+/* Slot of node (from pool_alloc(p)), or 0 for NULL.  O(log slabs). */
+uint32_t pool_slot(const NodePool *p, const void *node);
+
+/* Return one uninitialised node, or NULL on malloc failure. */
+void *pool_alloc(NodePool *p);
+
+/* Put node back on the free list. node must have come from pool_alloc(p). */
+void pool_release(NodePool *p, void *node);
+
+/* Invalidate every node handed out, keeping the slabs for reuse. */
+void pool_reset(NodePool *p);
+
+/* Free every slab. The pool stays usable and re-grows on the next alloc. */
+void pool_destroy(NodePool *p);
+
+/* Add the pool to u (memusage.h): live nodes, the spare slots of its
+   slabs as overhead, and its slab table as index. */
+void pool_memory(const NodePool *p, MemUsage *u);
+
+#endif /* POOL_H */
@@ -0,0 +1,151 @@
+/* prefix_cache.c - Bounded LRU cache of autocomplete results by prefix */
+#include <stdio.h>
+#include <string.h>
+#include "prefix_cache.h"
+#include "utils.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* FNV-1a over the normalised prefix, folded to a bucket. */
+static int bucket_of(const char *prefix) {
+    unsigned int h = 2166136261u;
+    while (*prefix) {
+        h ^= (unsigned char)*prefix++;
+        h *= 16777619u;
+    }
+    return (int)(h & (PREFIX_CACHE_SIZE - 1));
+}
+
+static int find_entry(const PrefixCache *c, const char *prefix, int b) {
+    int i;
+    for (i = c->bucket[b]; i >= 0; i = c->entry[i].chain)
+        if (str_key_cmp(c->entry[i].prefix, prefix) == 0) return i;
+    return -1;
+}
+
+static void lru_unlink(PrefixCache *c, int i) {
+    PrefixCacheEntry *e = &c->entry[i];
+    if (e->prev >= 0) c->entry[e->prev].next = e->next; else c->head = e->next;
+    if (e->next >= 0) c->entry[e->next].prev = e->prev; else c->tail = e->prev;
+    e->prev = e->next = -1;
+}
+
+static void lru_push_front(PrefixCache *c, int i) {
+    PrefixCacheEntry *e = &c->entry[i];
+    e->prev = -1;
+    e->next = c->head;
+    if (c->head >= 0) c->entry[c->head].prev = i; else c->tail = i;
+    c->head = i;
+}
+
+/* Take entry i out of its bucket and the LRU list, onto the free list. */
+static void drop_entry(PrefixCache *c, int i) {
+    PrefixCacheEntry *e = &c->entry[i];
+    int              *link = &c->bucket[bucket_of(e->prefix)];
+
+    while (*link != i) link = &c->entry[*link].chain;
+    *link = e->chain;
+    lru_unlink(c, i);
+    memset(e->prefix, 0, sizeof(e->prefix));
+    e->next      = c->free_list;
+    c->free_list = i;
+}
+
+/* A free entry, evicting the least recently used one if need be. */
+static int take_entry(PrefixCache *c) {
+    int i;
+    if (c->free_list < 0) drop_entry(c, c->tail);
+    i            = c->free_list;
+    c->free_list = c->entry[i].next;
+    return i;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void prefix_cache_init(PrefixCache *c) {
+    c->hits = c->misses = c->invalidations = 0;
+    prefix_cache_clear(c);
+}
+
+void prefix_cache_clear(PrefixCache *c) {
+    int i;
+    for (i = 0; i < PREFIX_CACHE_SIZE; i++) {
+        memset(c->entry[i].prefix, 0, sizeof(c->entry[i].prefix));
+        c->entry[i].prev = -1;
+        c->entry[i].next = i + 1 < PREFIX_CACHE_SIZE ? i + 1 : -1;
+        c->bucket[i]     = -1;
+    }
+    c->head = c->tail = -1;
+    c->free_list      = 0;
+}
+
+int prefix_cache_autocomplete(PrefixCache *c, const RecordStore *store,
+                              const char *prefix, WordRecord *results, int top_k,
+                              AutocompleteFn query, void *arg) {
+    DictKey           key;
+    PrefixCacheEntry *e;
+    int               b, i, n;
+
+    dict_key_init(&key, prefix);
+    if (top_k > TOP_K_MAX) top_k = TOP_K_MAX;
+    if (key.text[0] == '\0' || top_k <= 0) return query(key.text, results, top_k, arg);
+
+    b = bucket_of(key.text);
+    i = find_entry(c, key.text, b);
+    /* Ranked for at least top_k, or holding every match: its first
+       top_k are the answer */
+    if (i >= 0 && (c->entry[i].k >= top_k || c->entry[i].n < c->entry[i].k)) {
+        e = &c->entry[i];
+        c->hits++;
+        lru_unlink(c, i);
+        lru_push_front(c, i);
+        n = e->n < top_k ? e->n : top_k;
+        for (i = 0; i < n; i++) results[i] = *e->best[i];
+        return n;
+    }
+
+    c->misses++;
+    n = query(key.text, results, top_k, arg);
+    if (i < 0) {
+        i = take_entry(c);
+        e = &c->entry[i];
+        memcpy(e->prefix, key.text, sizeof(e->prefix));
+        e->chain     = c->bucket[b];
+        c->bucket[b] = i;
+    } else {
+        lru_unlink(c, i);                   /* re-ranked for a larger k */
+    }
+    lru_push_front(c, i);
+
+    e    = &c->entry[c->head];
+    e->k = top_k;
+    e->n = n;
+    for (i = 0; i < n; i++) {
+        e->best[i] = store_find(store, results[i].word);
+        if (!e->best[i]) {                  /* cannot map it: do not keep it */
+            drop_entry(c, c->head);
+            break;
+        }
+    }
+    return n;
+}
+
+void prefix_cache_invalidate_word(PrefixCache *c, const char *word) {
+    DictKey key;
+    char    pre[MAX_WORD_LEN];
+    size_t  l;
+    int     i;
+
+    if (c->head < 0) return;
+    dict_key_init(&key, word);
+    /* Grow pre one character at a time; it stays a zero-filled key */
+    memset(pre, 0, sizeof(pre));
+    for (l = 0; key.text[l] != '\0'; l++) {
+        pre[l] = key.text[l];
+        i = find_entry(c, pre, bucket_of(pre));
+        if (i >= 0) {
+            drop_entry(c, i);
+            c->invalidations++;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/* prefix_cache.h - Bounded LRU cache of autocomplete results by prefix */
+#ifndef PREFIX_CACHE_H
+#define PREFIX_CACHE_H
+
+#include "dictionary.h"
+#include "store.h"
+#include "autocomplete.h"
+
+/*
+ * PrefixCache - prefix -> ranked top-k, in front of any autocomplete_*
+ * query (an AutocompleteFn, as the type-ahead session uses).
+ *
+ * A few short prefixes carry most of the traffic, and on the scanning
+ * trees those are exactly the costly queries: a one-letter prefix walks
+ * thousands of matches.  The cache keeps the last PREFIX_CACHE_SIZE
+ * answers as record pointers, evicting the least recently used.
+ *
+ * Invalidation is by affected prefix.  A word can only enter, leave or
+ * move within the results of its own prefixes, so an insert, delete or
+ * pick of w drops just the entries for w's prefixes — one probe per
+ * character of w (prefix_cache_invalidate_word).  Anything that touches
+ * many records at once (a load, a frequency refresh) calls
+ * prefix_cache_clear.  The entries borrow the store's records, so every
+ * delete must be reported before the record is released.
+ *
+ * Fixed-size and allocation-free: the whole cache is one struct.
+ */
+typedef struct PrefixCacheEntry {
+    char         prefix[MAX_WORD_LEN];  /* normalised key; "" while free  */
+    int          k;                     /* top_k it was ranked for        */
+    int          n;                     /* results (< k: every match)     */
+    int          chain;                 /* next entry in the same bucket  */
+    int          prev, next;            /* LRU neighbours (-1 at an end)  */
+    WordRecord  *best[TOP_K_MAX];       /* best first                     */
+} PrefixCacheEntry;
+
+typedef struct PrefixCache {
+    PrefixCacheEntry entry[PREFIX_CACHE_SIZE];
+    int              bucket[PREFIX_CACHE_SIZE];  /* chain heads, or -1     */
+    int              head, tail;    /* most / least recently used, or -1   */
+    int              free_list;     /* unused entries, chained via next    */
+    unsigned long    hits;          /* answered from the cache             */
+    unsigned long    misses;        /* passed on to the query              */
+    unsigned long    invalidations; /* entries dropped by writes           */
+} PrefixCache;
+
+/* Initialise an empty cache with zeroed counters. */
+void prefix_cache_init(PrefixCache *c);
+
+/* Drop every entry (counters are kept). */
+void prefix_cache_clear(PrefixCache *c);
+
+/*
+ * Top-k completions of prefix: from the cache when an entry ranked for
+ * at least top_k holds them, else query(prefix, ...) and remember the
+ * answer.  store maps the query's result copies back to records.
+ * Returns the number of results.
+ */
+int prefix_cache_autocomplete(PrefixCache *c, const RecordStore *store,
+                              const char *prefix, WordRecord *results, int top_k,
+                              AutocompleteFn query, void *arg);
+
+/* Drop the entries for every prefix of word (case-insensitive).  Call on
+   each insert, delete (before the release) and pick of word. */
+void prefix_cache_invalidate_word(PrefixCache *c, const char *word);
+
+#endif /* PREFIX_CACHE_H */
@@ -11,7 +11,20 @@ Constraints from config.h:
     MAX_WORD_LEN    64   ->  word   <= 63 chars
     MAX_POS_LEN     32   ->  pos    <= 31 chars
     MAX_MEANING_LEN 512  ->  meaning<= 511 chars
-    MAX_WORDS    100000  ->  hard cap on entries
+
+The engine can also ingest the dump directly (load_jsonl in loader.h,
+same filters as below, kept in step with jsonl.c), which skips this
+stage, reads the dump on several threads and ranks every word by how
+often the dump's definitions use it -- this script leaves ranking to
+word_freq.txt.  `pack_dict.exe <dump> data/words.snap` saves that ranked
+dictionary as a snapshot for first runs to map.  Every usable entry is
+written; the dictionary store grows as needed, so the full dump
+(millions of words) loads as is.  To build a smaller list, pass
+--limit N: all short words are kept first and the remaining slots are
+sampled from the longer words across a-z.
+
+Usage:
+    python preprocess_jsonl.py [--limit N]
 """
 
 import json
@@ -27,7 +40,7 @@ OUTPUT_FILE = r"data\words_processed.txt"
 MAX_WORD    = 63
 MAX_POS     = 31
 MAX_MEANING = 511
-MAX_OUTPUT  = 90_000   # leave headroom below MAX_WORDS=100000
+MAX_OUTPUT  = None     # no cap; --limit N sets one
 
 # ── POS we want to keep, mapped to full display names ────────────────────────
 POS_MAP = {
@@ -154,7 +167,15 @@ def pos_priority(raw_pos: str) -> int:
         return len(POS_PRIORITY)
 
 # ── main pass ─────────────────────────────────────────────────────────────────
+def parse_limit(argv: list[str]):
+    if len(argv) == 3 and argv[1] == "--limit" and argv[2].isdigit() and int(argv[2]) > 0:
+        return int(argv[2])
+    if len(argv) == 1:
+        return MAX_OUTPUT
+    sys.exit("usage: python preprocess_jsonl.py [--limit N]")
+
 def main():
+    limit = parse_limit(sys.argv)
     print(f"Reading {INPUT_FILE} …", flush=True)
 
     # dict: word -> (raw_pos, display_pos, meaning)
@@ -209,7 +230,7 @@ def main():
           f"no gloss: {skipped_gloss:,}")
     print(f"  Unique words collected: {len(best):,}")
 
-    # Selection strategy:
+    # Selection strategy (only with --limit; otherwise every word is kept):
     #   1. Take ALL words of length 2–7 (core vocabulary, ~82k words).
     #   2. For the remaining slots, sample 8+ letter words proportionally by
     #      starting letter (a–z) so that the long-word selection is spread
@@ -219,10 +240,10 @@ def main():
     short_words = sorted(w for w in best if len(w) <= SHORT_MAX_LEN)
     long_words  = sorted(w for w in best if len(w) >  SHORT_MAX_LEN)
 
-    remaining = MAX_OUTPUT - len(short_words)
+    remaining = limit - len(short_words) if limit is not None else len(long_words)
     if remaining <= 0:
-        print(f"  Capping to {MAX_OUTPUT:,} entries (only short words fit).")
-        words_sorted = short_words[:MAX_OUTPUT]
+        print(f"  Capping to {limit:,} entries (only short words fit).")
+        words_sorted = short_words[:limit]
     elif len(long_words) <= remaining:
         words_sorted = short_words + long_words
     else:
@@ -252,7 +273,7 @@ def main():
             sampled.extend(group[int(j * step)] for j in range(slots))
             allocated += slots
 
-        print(f"  Capping to {MAX_OUTPUT:,} entries: all {len(short_words):,} "
+        print(f"  Capping to {limit:,} entries: all {len(short_words):,} "
               f"short + {len(sampled):,} sampled long words (spread across a-z).")
         words_sorted = short_words + sampled
 
@@ -0,0 +1,108 @@
+/* querylog.c - Query logs: lookups, prefix queries and picks to replay */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "querylog.h"
+#include "utils.h"
+
+/* ── Helpers ─────────────────────────────────────────────────── */
+
+static int known_op(char op) {
+    return op == QLOG_SEARCH || op == QLOG_COMPLETE || op == QLOG_PICK;
+}
+
+/*
+ * Read path line by line.  A line with a known "op|" in front is that
+ * event; otherwise, if list_op is non-zero, the line up to any '|' is a
+ * list_op event.  Everything else is skipped.
+ */
+static int load_lines(QueryLog *log, const char *path, char list_op) {
+    FILE *fp = fopen(path, "r");
+    char  line[MAX_LINE_BUF];
+    char *text, *bar;
+    char  op;
+    int   n = 0;
+
+    if (!fp) return -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (!strchr(line, '\n')) {    /* a long definition: drop the rest */
+            int c;
+            while ((c = fgetc(fp)) != EOF && c != '\n') {}
+        }
+        text = str_trim(line);
+        if (text[0] == '\0' || text[0] == '#') continue;
+        if (list_op) {
+            op = list_op;
+            if ((bar = strchr(text, '|')) != NULL) *bar = '\0';
+            text = str_trim(text);
+        } else {
+            if (!known_op(text[0]) || text[1] != '|') continue;
+            op   = text[0];
+            text = str_trim(text + 2);
+        }
+        if (text[0] == '\0') continue;
+        if (querylog_add(log, op, text) != 0) {
+            fclose(fp);
+            return -1;
+        }
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void querylog_init(QueryLog *log) {
+    log->events = NULL;
+    log->count  = 0;
+    log->cap    = 0;
+}
+
+int querylog_add(QueryLog *log, char op, const char *text) {
+    QueryEvent *e;
+    if (log->count == log->cap) {
+        int         cap   = log->cap ? log->cap * 2 : 1024;
+        QueryEvent *grown = (QueryEvent *)realloc(log->events,
+                                                  (size_t)cap * sizeof(QueryEvent));
+        if (!grown) return -1;
+        log->events = grown;
+        log->cap    = cap;
+    }
+    e = &log->events[log->count++];
+    e->op = op;
+    snprintf(e->text, sizeof(e->text), "%s", text);
+    return 0;
+}
+
+int querylog_load(QueryLog *log, const char *path) {
+    return load_lines(log, path, 0);
+}
+
+int querylog_load_list(QueryLog *log, const char *path, char op) {
+    return load_lines(log, path, op);
+}
+
+void querylog_free(QueryLog *log) {
+    free(log->events);
+    querylog_init(log);
+}
+
+int querylog_record_open(QueryRecorder *r, const char *path) {
+    r->events = 0;
+    r->fp     = fopen(path, "a");
+    if (!r->fp) return -1;
+    setvbuf(r->fp, NULL, _IOLBF, BUFSIZ);
+    return 0;
+}
+
+void querylog_record(QueryRecorder *r, char op, const char *text) {
+    if (!r->fp || !text || text[0] == '\0') return;
+    fprintf(r->fp, "%c|%s\n", op, text);
+    r->events++;
+}
+
+void querylog_record_close(QueryRecorder *r) {
+    if (r->fp) fclose(r->fp);
+    r->fp = NULL;
+}
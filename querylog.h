@@ -0,0 +1,74 @@
+/* querylog.h - Query logs: lookups, prefix queries and picks to replay */
+#ifndef QUERYLOG_H
+#define QUERYLOG_H
+
+#include <stdio.h>
+#include "config.h"
+
+/*
+ * A query log is a text file with one event per line, "op|text":
+ *
+ *   s|word      exact lookup of word
+ *   a|prefix    top-k autocomplete of prefix
+ *   p|word      the user picked word from a suggestion list
+ *
+ * Blank lines and lines starting with '#' are skipped, as are unknown
+ * ops, so a log can carry notes.  Events replay in file order.
+ */
+#define QLOG_SEARCH    's'
+#define QLOG_COMPLETE  'a'
+#define QLOG_PICK      'p'
+
+typedef struct QueryEvent {
+    char op;                   /* QLOG_SEARCH, QLOG_COMPLETE or QLOG_PICK */
+    char text[MAX_WORD_LEN];   /* as logged (not normalised)              */
+} QueryEvent;
+
+typedef struct QueryLog {
+    QueryEvent *events;        /* in file order */
+    int         count;
+    int         cap;
+} QueryLog;
+
+/*
+ * QueryRecorder - appends the queries a front end serves to a query log,
+ * to replay later (benchmark_replay, or the --replay modes).  Lines are
+ * flushed as they are written, so a log survives a crash; recording is
+ * one short write per query and off unless a log was opened.
+ */
+typedef struct QueryRecorder {
+    FILE *fp;                  /* NULL when not recording */
+    int   events;              /* written since opened    */
+} QueryRecorder;
+
+#define QUERY_RECORDER_INIT  { NULL, 0 }
+
+/* Start appending to the log at path.  Returns 0, or -1 if it cannot be
+   opened (r is then left off). */
+int querylog_record_open(QueryRecorder *r, const char *path);
+
+/* Append one event; does nothing if r is off or text is empty. */
+void querylog_record(QueryRecorder *r, char op, const char *text);
+
+/* Stop recording and close the log. */
+void querylog_record_close(QueryRecorder *r);
+
+/* Initialise an empty log. */
+void querylog_init(QueryLog *log);
+
+/* Append the events of the query log at path.  Returns the number read,
+   or -1 if the file cannot be opened or memory runs out. */
+int querylog_load(QueryLog *log, const char *path);
+
+/* Append one op event per non-blank line of a plain list at path (one
+   word or prefix per line, as in a word file — anything after a '|' is
+   ignored).  Returns the number read, or -1 as for querylog_load. */
+int querylog_load_list(QueryLog *log, const char *path, char op);
+
+/* Append one event.  Returns 0, or -1 on malloc failure. */
+int querylog_add(QueryLog *log, char op, const char *text);
+
+/* Release the events; log is left empty and reusable. */
+void querylog_free(QueryLog *log);
+
+#endif /* QUERYLOG_H */
@@ -0,0 +1,285 @@
+/* ranker.h - Top-k autocomplete core, specialised per ranking at compile time */
+
+/*
+ * A template: include it once per ranking, with two macros defined.
+ *
+ *   static int by_freq(const WordRecord *r) { return r->frequency_score; }
+ *
+ *   #define RANKER_NAME   freq
+ *   #define RANKER_SCORE  by_freq
+ *   #include "ranker.h"
+ *
+ * RANKER_SCORE(rec) is any function or macro giving an int, higher ranks
+ * first (equal scores alphabetically, like word_record_outranks).  It is
+ * expanded straight into the heap code below, so the compiler inlines it
+ * into every traversal — no call through a pointer per candidate.  Each
+ * record is scored once, when it is offered, and the score is kept in
+ * the heap next to it, so sifting never scores again.
+ *
+ * Generated, with RANKER_NAME as the prefix (freq_ here):
+ *
+ *   freq_heap                  bounded min-heap of (score, record)
+ *   freq_init / _push / _finish
+ *   freq_cannot_enter          pruning test for a known score bound
+ *   freq_bst_collect, freq_avl_collect, freq_trie_collect
+ *                              every record in a prefix range or subtree
+ *   freq_bst, freq_avl, freq_tbt, freq_bpt, freq_trie
+ *       (index, prefix, results, top_k) -> number of results, best first:
+ *       the same contract as the autocomplete_* calls (autocomplete.h)
+ *
+ * The traversals only know the key order, so they serve any ranking.
+ * The indexes' score shortcuts — AVL max_score pruning and the trie's
+ * cached top-k lists — are built for word_record_score alone, and only
+ * autocomplete.c (whose ranking that is) layers them on.
+ *
+ * Everything is static inline, so a ranker costs nothing for the parts
+ * it does not use.  There is no include guard on purpose; RANKER_NAME
+ * and RANKER_SCORE are undefined at the end.
+ */
+#if !defined(RANKER_NAME) || !defined(RANKER_SCORE)
+#error "define RANKER_NAME and RANKER_SCORE before including ranker.h"
+#endif
+
+#include <string.h>
+#include "config.h"
+#include "dictionary.h"
+#include "stats.h"
+#include "utils.h"
+#include "bst.h"
+#include "avl.h"
+#include "tbt.h"
+#include "bpt.h"
+#include "trie.h"
+
+#ifndef RANKER_CAT
+#define RANKER_CAT_(a, b)  a##_##b
+#define RANKER_CAT(a, b)   RANKER_CAT_(a, b)
+#endif
+#define RK(x)  RANKER_CAT(RANKER_NAME, x)
+
+/* ── Heap ────────────────────────────────────────────────────── */
+
+typedef struct RK(heap) {
+    WordRecord *rec[TOP_K_MAX];
+    int         score[TOP_K_MAX];   /* RANKER_SCORE(rec[i]) */
+    int         n;                  /* entries in use       */
+    int         k;                  /* capacity (top_k, clamped to TOP_K_MAX) */
+} RK(heap);
+
+static inline void RK(init)(RK(heap) *h, int top_k) {
+    h->n = 0;
+    h->k = top_k < 0 ? 0 : (top_k > TOP_K_MAX ? TOP_K_MAX : top_k);
+}
+
+/* 1 if (sa, a) ranks before (sb, b). */
+static inline int RK(before)(int sa, const WordRecord *a, int sb, const WordRecord *b) {
+    if (sa != sb) return sa > sb;
+    return str_key_cmp(a->word, b->word) < 0;
+}
+
+static inline void RK(swap)(RK(heap) *h, int i, int j) {
+    WordRecord *r = h->rec[i];
+    int         s = h->score[i];
+    h->rec[i] = h->rec[j]; h->score[i] = h->score[j];
+    h->rec[j] = r;         h->score[j] = s;
+}
+
+/* Heap order: a parent never outranks its children (worst on top). */
+static inline void RK(sift_down)(RK(heap) *h, int i) {
+    int c;
+    for (;;) {
+        c = 2 * i + 1;
+        if (c >= h->n) break;
+        if (c + 1 < h->n &&
+            RK(before)(h->score[c], h->rec[c], h->score[c + 1], h->rec[c + 1])) c++;
+        if (!RK(before)(h->score[i], h->rec[i], h->score[c], h->rec[c])) break;
+        RK(swap)(h, i, c);
+        i = c;
+    }
+}
+
+static inline void RK(push)(RK(heap) *h, WordRecord *r) {
+    int s = RANKER_SCORE(r);
+    int i, p;
+
+    STATS_INC(STAT_AC_CANDIDATES);
+    if (h->n < h->k) {
+        i = h->n++;
+        h->rec[i]   = r;
+        h->score[i] = s;
+        while (i > 0) {
+            p = (i - 1) / 2;
+            if (!RK(before)(h->score[p], h->rec[p], s, r)) break;
+            RK(swap)(h, p, i);
+            i = p;
+        }
+    } else if (h->k > 0 && RK(before)(s, r, h->score[0], h->rec[0])) {
+        h->rec[0]   = r;           /* evict the current worst */
+        h->score[0] = s;
+        RK(sift_down)(h, 0);
+    }
+}
+
+/*
+ * 1 if no word of a subtree can enter the heap any more, given best, a
+ * bound on the subtree's scores, and lo, a key every word in it sorts
+ * after (NULL if unknown).  Equal scores lose the alphabetical tie-break
+ * only when the whole subtree sorts after the current k-th result.
+ */
+static inline int RK(cannot_enter)(const RK(heap) *h, int best, const char *lo) {
+    if (h->k == 0) return 1;
+    if (h->n < h->k) return 0;
+    if (best != h->score[0]) return best < h->score[0];
+    return lo && str_key_cmp(lo, h->rec[0]->word) >= 0;
+}
+
+/* Copy the selection into results, best first.  Empties the heap. */
+static inline int RK(finish)(RK(heap) *h, WordRecord *results) {
+    int ret = h->n, i;
+    if (ret > 0) {
+        STATS_INC(STAT_SORTS);
+        STATS_ADD(STAT_SORTED_ITEMS, ret);
+    }
+    for (i = ret - 1; i >= 0; i--) {
+        results[i] = *h->rec[0];   /* worst remaining goes last */
+        h->n--;
+        h->rec[0]   = h->rec[h->n];
+        h->score[0] = h->score[h->n];
+        RK(sift_down)(h, 0);
+    }
+    return ret;
+}
+
+/* ── Traversals ──────────────────────────────────────────────── */
+
+/* Every word of a search tree starting with prefix (plen bytes, already
+ * normalised), pruned by key order:
+ *   > 0 → the node is past the prefix range → only its left subtree can match
+ *   < 0 → the node is before the range      → only its right subtree can match
+ *   = 0 → the node matches                  → offer it and descend both sides */
+static inline void RK(bst_collect)(BSTNode *root, const char *prefix, size_t plen,
+                                   RK(heap) *h) {
+    int cmp;
+    if (!root) return;
+    STATS_VISIT();
+    cmp = str_key_ncmp(root->rec->word, prefix, plen);
+    if (cmp >= 0) RK(bst_collect)(root->left, prefix, plen, h);
+    if (cmp == 0) RK(push)(h, root->rec);
+    if (cmp <= 0) RK(bst_collect)(root->right, prefix, plen, h);
+}
+
+static inline void RK(avl_collect)(AVLNode *root, const char *prefix, size_t plen,
+                                   RK(heap) *h) {
+    int cmp;
+    if (!root) return;
+    STATS_VISIT();
+    cmp = str_key_ncmp(root->rec->word, prefix, plen);
+    if (cmp >= 0) RK(avl_collect)(avl_left(root), prefix, plen, h);
+    if (cmp == 0) RK(push)(h, root->rec);
+    if (cmp <= 0) RK(avl_collect)(avl_right(root), prefix, plen, h);
+}
+
+/* Every record at or below the trie nodes from n along its siblings:
+   all of them match, so there is no comparison at all. */
+static inline void RK(trie_collect)(TrieNode *n, RK(heap) *h) {
+    for (; n; n = n->sibling) {
+        STATS_INC(STAT_NODE_VISITS);
+        if (n->rec) RK(push)(h, n->rec);
+        RK(trie_collect)(n->child, h);
+    }
+}
+
+/* ── Queries ─────────────────────────────────────────────────── */
+
+static inline int RK(bst)(BSTNode *root, const char *prefix,
+                          WordRecord *results, int top_k) {
+    char     buf[MAX_WORD_LEN];
+    RK(heap) h;
+
+    RK(init)(&h, top_k);
+    str_tolower(buf, prefix, sizeof(buf));
+    RK(bst_collect)(root, buf, strlen(buf), &h);
+    return RK(finish)(&h, results);
+}
+
+static inline int RK(avl)(AVLNode *root, const char *prefix,
+                          WordRecord *results, int top_k) {
+    char     buf[MAX_WORD_LEN];
+    RK(heap) h;
+
+    RK(init)(&h, top_k);
+    str_tolower(buf, prefix, sizeof(buf));
+    RK(avl_collect)(root, buf, strlen(buf), &h);
+    return RK(finish)(&h, results);
+}
+
+/* Inorder thread successors from the lower bound, up to the first word
+   past the prefix range — no recursion, no stack. */
+static inline int RK(tbt)(TBTNode *header, const char *prefix,
+                          WordRecord *results, int top_k) {
+    DictKey  key;
+    size_t   plen;
+    RK(heap) h;
+    TBTNode *cur;
+
+    dict_key_init(&key, prefix);
+    plen = strlen(key.text);
+    if (plen == 0) return 0;       /* no empty-prefix dump */
+
+    RK(init)(&h, top_k);
+    for (cur = tbt_lower_bound_normalized(header, &key); cur && cur != header;
+         cur = tbt_inorder_successor(cur)) {
+        STATS_VISIT();
+        if (str_key_ncmp(cur->rec->word, key.text, plen) != 0) break;
+        RK(push)(&h, cur->rec);
+    }
+    return RK(finish)(&h, results);
+}
+
+/* One descent to the lower bound, then along the leaf chain. */
+static inline int RK(bpt)(const BPTree *tree, const char *prefix,
+                          WordRecord *results, int top_k) {
+    DictKey        key;
+    size_t         plen;
+    RK(heap)       h;
+    const BPTLeaf *leaf;
+    int            i;
+
+    dict_key_init(&key, prefix);
+    plen = strlen(key.text);
+    if (plen == 0) return 0;
+
+    RK(init)(&h, top_k);
+    for (leaf = bpt_lower_bound(tree, &key, &i); leaf; leaf = leaf->next, i = 0) {
+        STATS_INC(STAT_NODE_VISITS);
+        for (; i < leaf->n; i++) {
+            STATS_INC(STAT_KEY_COMPARES);
+            if (str_key_ncmp(leaf->rec[i]->word, key.text, plen) != 0)
+                return RK(finish)(&h, results);
+            RK(push)(&h, leaf->rec[i]);
+        }
+    }
+    return RK(finish)(&h, results);
+}
+
+/* A descent to the prefix node, then its whole subtree. */
+static inline int RK(trie)(const Trie *trie, const char *prefix,
+                           WordRecord *results, int top_k) {
+    char      buf[MAX_WORD_LEN];
+    RK(heap)  h;
+    TrieNode *start;
+
+    str_tolower(buf, prefix, sizeof(buf));
+    if (buf[0] == '\0') return 0;
+    start = trie_prefix_node(trie, buf);
+    if (!start) return 0;
+
+    RK(init)(&h, top_k);
+    if (start->rec) RK(push)(&h, start->rec);
+    RK(trie_collect)(start->child, &h);
+    return RK(finish)(&h, results);
+}
+
+#undef RK
+#undef RANKER_NAME
+#undef RANKER_SCORE
@@ -0,0 +1,773 @@
+/* server_main.c - Dictionary query server: one load, many clients over TCP */
+#ifdef _WIN32
+#define _WIN32_WINNT 0x0600       /* WSAPoll and inet_pton: Vista and later */
+#else
+#define _POSIX_C_SOURCE 200809L   /* sockets and poll under -std=c99 */
+#endif
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+#endif
+
+#include "config.h"
+#include "dict_handle.h"
+#include "querylog.h"
+#include "utils.h"
+
+/*
+ * Usage: smart_dict_server.exe [--port N] [--host ADDR] [--threads N]
+ *                              [--words FILE]
+ *
+ * Loads the word list (default words.txt, ranked by word_freq.txt) once
+ * into a DictHandle and answers any number of clients over TCP, so the
+ * services on a host share one copy of the dictionary.  Requests are
+ * query-log lines (querylog.h), and every request gets exactly one reply
+ * line, in order, so a client may pipeline as many as it likes:
+ *
+ *   s|word    ->  1|word|pos|meaning, or 0 if there is no such word
+ *   a|prefix  ->  n|word1|...|wordn, the top TOP_K_DEFAULT, best first
+ *   p|word    ->  1 once the pick is counted, or 0 if there is no such word
+ *   n|        ->  the number of words
+ *   other     ->  ?
+ *
+ * Blank lines and '#' lines are not requests and get no reply.  Picks
+ * re-rank in memory only; nothing is ever saved.
+ *
+ * One thread runs the event loop — epoll on Linux, poll on other POSIX
+ * systems and WSAPoll on Windows — over non-blocking sockets, and never
+ * touches the dictionary.  A client's complete request lines go to a
+ * pool of worker threads as one batch.  Each client has at most one
+ * batch out at a time, which keeps its replies in order; lines that
+ * arrive meanwhile are read on and make up its next batch.  A worker
+ * answers its batch under one view of the dictionary, posts the replies
+ * back and wakes the loop through a socket pair.  Queries from different
+ * clients run in parallel under the handle's read lock, and picks are
+ * counted lock-free (dict_handle.h).  A client that stops reading its
+ * replies is not read from once SERVER_BUF_MAX of them are waiting.
+ */
+
+/* Server-only request: the word count */
+#define SRV_COUNT  'n'
+
+/* ── Sockets ─────────────────────────────────────────────────── */
+
+#ifdef _WIN32
+typedef SOCKET sock_t;
+#define SOCK_NONE        INVALID_SOCKET
+#define sock_close       closesocket
+#define sock_would_block() (WSAGetLastError() == WSAEWOULDBLOCK)
+
+static int sock_nonblock(sock_t s) {
+    u_long on = 1;
+    return ioctlsocket(s, FIONBIO, &on) == 0 ? 0 : -1;
+}
+#else
+typedef int sock_t;
+#define SOCK_NONE        (-1)
+#define sock_close       close
+#define sock_would_block() (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+
+static int sock_nonblock(sock_t s) {
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0 ? 0 : -1;
+}
+#endif
+
+/* A connected pair of non-blocking sockets on the loopback, for the
+   workers to wake the loop with.  Returns 0, or -1. */
+static int wake_pair(sock_t pair[2]) {
+#ifdef _WIN32
+    struct sockaddr_in addr;
+    int                len = sizeof(addr);
+    sock_t             l   = socket(AF_INET, SOCK_STREAM, 0);
+
+    pair[0] = pair[1] = SOCK_NONE;
+    if (l == SOCK_NONE) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(l, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+        getsockname(l, (struct sockaddr *)&addr, &len) == 0 && listen(l, 1) == 0 &&
+        (pair[1] = socket(AF_INET, SOCK_STREAM, 0)) != SOCK_NONE &&
+        connect(pair[1], (struct sockaddr *)&addr, sizeof(addr)) == 0)
+        pair[0] = accept(l, NULL, NULL);
+    sock_close(l);
+#else
+    int fd[2];
+    pair[0] = pair[1] = SOCK_NONE;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) == 0) {
+        pair[0] = fd[0];
+        pair[1] = fd[1];
+    }
+#endif
+    if (pair[0] != SOCK_NONE && sock_nonblock(pair[0]) == 0 &&
+        sock_nonblock(pair[1]) == 0)
+        return 0;
+    if (pair[0] != SOCK_NONE) sock_close(pair[0]);
+    if (pair[1] != SOCK_NONE) sock_close(pair[1]);
+    return -1;
+}
+
+/* ── Readiness ───────────────────────────────────────────────── */
+
+/* What a socket is watched for, and what it was found ready for */
+#define EV_IN   1
+#define EV_OUT  2
+#define EV_ERR  4
+
+typedef struct EvReady {
+    void *tag;
+    int   events;
+} EvReady;
+
+#define EV_BATCH  64   /* readiness reports taken per wait */
+
+#ifdef __linux__
+typedef struct EvLoop {
+    int ep;
+} EvLoop;
+
+static int ev_init(EvLoop *ev) {
+    ev->ep = epoll_create1(0);
+    return ev->ep >= 0 ? 0 : -1;
+}
+
+static int ev_ctl(EvLoop *ev, int op, sock_t s, void *tag, int want) {
+    struct epoll_event e;
+    memset(&e, 0, sizeof(e));
+    e.events   = (want & EV_IN ? EPOLLIN : 0u) | (want & EV_OUT ? EPOLLOUT : 0u);
+    e.data.ptr = tag;
+    return epoll_ctl(ev->ep, op, s, &e);
+}
+
+static int  ev_add(EvLoop *ev, sock_t s, void *tag, int want) { return ev_ctl(ev, EPOLL_CTL_ADD, s, tag, want); }
+static void ev_mod(EvLoop *ev, sock_t s, void *tag, int want) { ev_ctl(ev, EPOLL_CTL_MOD, s, tag, want); }
+static void ev_del(EvLoop *ev, sock_t s)                      { ev_ctl(ev, EPOLL_CTL_DEL, s, NULL, 0); }
+
+static int ev_wait(EvLoop *ev, EvReady *out, int timeout_ms) {
+    struct epoll_event e[EV_BATCH];
+    int                i, n = epoll_wait(ev->ep, e, EV_BATCH, timeout_ms);
+    for (i = 0; i < n; i++) {
+        out[i].tag    = e[i].data.ptr;
+        out[i].events = (e[i].events & EPOLLIN ? EV_IN : 0) |
+                        (e[i].events & EPOLLOUT ? EV_OUT : 0) |
+                        (e[i].events & (EPOLLERR | EPOLLHUP) ? EV_ERR : 0);
+    }
+    return n < 0 ? 0 : n;
+}
+
+static void ev_free(EvLoop *ev) {
+    close(ev->ep);
+}
+#else
+/* poll and WSAPoll take the whole set each call, so it is kept here */
+typedef struct EvLoop {
+    struct pollfd *fd;
+    void         **tag;
+    int            n, cap;
+} EvLoop;
+
+#ifdef _WIN32
+#define poll  WSAPoll
+#endif
+
+static int ev_init(EvLoop *ev) {
+    memset(ev, 0, sizeof(*ev));
+    return 0;
+}
+
+static short ev_mask(int want) {
+    return (short)((want & EV_IN ? POLLIN : 0) | (want & EV_OUT ? POLLOUT : 0));
+}
+
+static int ev_add(EvLoop *ev, sock_t s, void *tag, int want) {
+    if (ev->n == ev->cap) {
+        int            cap = ev->cap ? ev->cap * 2 : 64;
+        struct pollfd *fd  = (struct pollfd *)realloc(ev->fd, (size_t)cap * sizeof(*fd));
+        void         **tg;
+        if (!fd) return -1;
+        ev->fd = fd;
+        tg     = (void **)realloc(ev->tag, (size_t)cap * sizeof(*tg));
+        if (!tg) return -1;
+        ev->tag = tg;
+        ev->cap = cap;
+    }
+    ev->fd[ev->n].fd      = s;
+    ev->fd[ev->n].events  = ev_mask(want);
+    ev->fd[ev->n].revents = 0;
+    ev->tag[ev->n++]      = tag;
+    return 0;
+}
+
+static int ev_find(const EvLoop *ev, sock_t s) {
+    int i;
+    for (i = 0; i < ev->n; i++)
+        if (ev->fd[i].fd == s) return i;
+    return -1;
+}
+
+static void ev_mod(EvLoop *ev, sock_t s, void *tag, int want) {
+    int i = ev_find(ev, s);
+    (void)tag;
+    if (i >= 0) ev->fd[i].events = ev_mask(want);
+}
+
+static void ev_del(EvLoop *ev, sock_t s) {
+    int i = ev_find(ev, s);
+    if (i < 0) return;
+    ev->n--;
+    ev->fd[i]  = ev->fd[ev->n];
+    ev->tag[i] = ev->tag[ev->n];
+}
+
+static int ev_wait(EvLoop *ev, EvReady *out, int timeout_ms) {
+    int i, k = 0;
+    if (poll(ev->fd, (unsigned long)ev->n, timeout_ms) <= 0) return 0;
+    for (i = 0; i < ev->n && k < EV_BATCH; i++) {
+        short r = ev->fd[i].revents;
+        if (!r) continue;
+        out[k].tag    = ev->tag[i];
+        out[k].events = (r & POLLIN ? EV_IN : 0) | (r & POLLOUT ? EV_OUT : 0) |
+                        (r & (POLLERR | POLLHUP | POLLNVAL) ? EV_ERR : 0);
+        k++;
+    }
+    return k;
+}
+
+static void ev_free(EvLoop *ev) {
+    free(ev->fd);
+    free(ev->tag);
+    memset(ev, 0, sizeof(*ev));
+}
+#endif
+
+/* ── Buffers and clients ─────────────────────────────────────── */
+
+typedef struct Buf {
+    char  *p;
+    size_t len, cap;
+} Buf;
+
+/* Append n bytes.  Returns 0, or -1 on malloc failure. */
+static int buf_put(Buf *b, const char *s, size_t n) {
+    if (b->len + n > b->cap) {
+        size_t cap = b->cap ? b->cap : 256;
+        char  *p;
+        while (cap < b->len + n) cap *= 2;
+        p = (char *)realloc(b->p, cap);
+        if (!p) return -1;
+        b->p   = p;
+        b->cap = cap;
+    }
+    memcpy(b->p + b->len, s, n);
+    b->len += n;
+    return 0;
+}
+
+static int buf_puts(Buf *b, const char *s) {
+    return buf_put(b, s, strlen(s));
+}
+
+/* Drop the first n bytes. */
+static void buf_consume(Buf *b, size_t n) {
+    memmove(b->p, b->p + n, b->len - n);
+    b->len -= n;
+}
+
+typedef struct Conn {
+    sock_t       fd;       /* SOCK_NONE once closed                      */
+    Buf          in;       /* bytes read, not yet batched (loop's)       */
+    Buf          out;      /* replies not yet sent (loop's)              */
+    Buf          work;     /* the batch out with a worker (its while busy) */
+    Buf          reply;    /* its replies (the worker's while busy)      */
+    int          busy;     /* a batch is out                             */
+    int          eof;      /* the client sent its last request           */
+    int          want;     /* EV_* watched for                           */
+    int          slot;     /* index in Server.conn                       */
+    struct Conn *next;     /* on the job or done queue                   */
+} Conn;
+
+typedef struct Server {
+    DictHandle     *dict;
+    EvLoop          ev;
+    sock_t          listener;
+    sock_t          wake[2];          /* [0] watched by the loop, [1] written */
+    Conn           *conn[SERVER_MAX_CONNS];
+    int             nconn;
+    pthread_mutex_t lock;             /* the queues and quit                  */
+    pthread_cond_t  work;
+    Conn           *jobs, *jobs_tail; /* batches waiting for a worker (FIFO)  */
+    Conn           *done;             /* batches answered                     */
+    int             quit;
+    pthread_t       worker[SERVER_WORKERS_MAX];
+    int             workers;
+    unsigned long   requests;         /* answered so far                      */
+} Server;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+/* ── Answering ───────────────────────────────────────────────── */
+
+/* Reply to one request line (no newline) into out.  Returns 1 if it was
+   a request, 0 for a blank or comment line. */
+static int answer(DictHandle *h, DictView *v, const char *line, Buf *out) {
+    WordRecord results[TOP_K_DEFAULT];
+    WordRecord rec;
+    char       text[MAX_WORD_LEN];
+    char       num[32];
+    int        i, n;
+
+    if (line[0] == '\0' || line[0] == '#') return 0;
+    if (line[1] != '|') {
+        buf_puts(out, "?\n");
+        return 1;
+    }
+    str_safe_copy(text, line + 2, sizeof(text));
+    switch (line[0]) {
+    case QLOG_SEARCH:
+        if (!dict_view_lookup(v, text, &rec)) {
+            buf_puts(out, "0\n");
+            break;
+        }
+        buf_puts(out, "1|");
+        buf_puts(out, rec.word);
+        buf_puts(out, "|");
+        buf_puts(out, rec.part_of_speech);
+        buf_puts(out, "|");
+        buf_puts(out, word_record_meaning(&rec));
+        buf_puts(out, "\n");
+        break;
+    case QLOG_COMPLETE:
+        n = text[0] ? dict_view_autocomplete(v, text, results, TOP_K_DEFAULT) : 0;
+        snprintf(num, sizeof(num), "%d", n);
+        buf_puts(out, num);
+        for (i = 0; i < n; i++) {
+            buf_puts(out, "|");
+            buf_puts(out, results[i].word);
+        }
+        buf_puts(out, "\n");
+        break;
+    case QLOG_PICK:
+        n = dict_view_lookup(v, text, &rec);
+        if (n) dict_handle_record_selection(h, text);
+        buf_puts(out, n ? "1\n" : "0\n");
+        break;
+    case SRV_COUNT:
+        snprintf(num, sizeof(num), "%d\n", dict_view_count(v));
+        buf_puts(out, num);
+        break;
+    default:
+        buf_puts(out, "?\n");
+        break;
+    }
+    return 1;
+}
+
+/* Reply to every line of c->work into c->reply, under one view. */
+static int answer_batch(DictHandle *h, Conn *c) {
+    DictView *v = dict_handle_acquire(h);
+    char     *line = c->work.p, *end = c->work.p + c->work.len, *nl;
+    int       n = 0;
+
+    c->reply.len = 0;
+    while (line < end && (nl = (char *)memchr(line, '\n', (size_t)(end - line))) != NULL) {
+        *nl = '\0';
+        if (nl > line && nl[-1] == '\r') nl[-1] = '\0';
+        n += answer(h, v, line, &c->reply);
+        line = nl + 1;
+    }
+    dict_view_release(v);
+    return n;
+}
+
+static void *worker_main(void *arg) {
+    Server *s = (Server *)arg;
+    Conn   *c;
+    char    byte = 1;
+    int     n;
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        while (!s->jobs && !s->quit) pthread_cond_wait(&s->work, &s->lock);
+        c = s->jobs;
+        if (!c) {
+            pthread_mutex_unlock(&s->lock);
+            break;
+        }
+        s->jobs = c->next;
+        if (!s->jobs) s->jobs_tail = NULL;
+        pthread_mutex_unlock(&s->lock);
+
+        n = answer_batch(s->dict, c);
+
+        pthread_mutex_lock(&s->lock);
+        c->next      = s->done;
+        s->done      = c;
+        s->requests += (unsigned long)n;
+        pthread_mutex_unlock(&s->lock);
+        send(s->wake[1], &byte, 1, 0);    /* a full pipe already wakes it */
+    }
+    return NULL;
+}
+
+/* ── Event loop ──────────────────────────────────────────────── */
+
+static void conn_free(Conn *c) {
+    free(c->in.p);
+    free(c->out.p);
+    free(c->work.p);
+    free(c->reply.p);
+    free(c);
+}
+
+/* Stop serving c.  A busy client is freed when its batch comes back. */
+static void conn_close(Server *s, Conn *c) {
+    if (c->fd != SOCK_NONE) {
+        ev_del(&s->ev, c->fd);
+        sock_close(c->fd);
+        c->fd = SOCK_NONE;
+    }
+    if (c->slot >= 0) {
+        s->conn[c->slot] = s->conn[--s->nconn];
+        s->conn[c->slot]->slot = c->slot;
+        c->slot = -1;
+    }
+    if (!c->busy) conn_free(c);
+}
+
+/* Hand c's complete lines to the workers, unless a batch is already out
+   or too many replies are waiting. */
+static void conn_dispatch(Server *s, Conn *c) {
+    size_t end = c->in.len;
+
+    if (c->busy || c->out.len >= (size_t)SERVER_BUF_MAX) return;
+    while (end > 0 && c->in.p[end - 1] != '\n') end--;
+    if (end == 0) return;
+    c->work.len = 0;
+    if (buf_put(&c->work, c->in.p, end) != 0) return;
+    buf_consume(&c->in, end);
+
+    c->busy = 1;
+    c->next = NULL;
+    pthread_mutex_lock(&s->lock);
+    if (s->jobs_tail) s->jobs_tail->next = c;
+    else              s->jobs            = c;
+    s->jobs_tail = c;
+    pthread_cond_signal(&s->work);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/* Send what can be sent.  Returns 0, or -1 if the client is gone. */
+static int conn_flush(Conn *c) {
+    while (c->out.len > 0) {
+        int n = (int)send(c->fd, c->out.p, c->out.len, 0);
+        if (n > 0) {
+            buf_consume(&c->out, (size_t)n);
+            continue;
+        }
+        return n < 0 && sock_would_block() ? 0 : -1;
+    }
+    return 0;
+}
+
+/* Watch c for what it can use next, or close it once it is finished:
+   the client has sent its last request and every reply is out. */
+static void conn_update(Server *s, Conn *c) {
+    int want = 0;
+
+    if (c->eof && !c->busy && c->out.len == 0) {
+        conn_close(s, c);
+        return;
+    }
+    if (!c->eof && c->in.len < (size_t)SERVER_BUF_MAX && c->out.len < (size_t)SERVER_BUF_MAX)
+        want |= EV_IN;
+    if (c->out.len > 0) want |= EV_OUT;
+    if (want != c->want) {
+        ev_mod(&s->ev, c->fd, c, want);
+        c->want = want;
+    }
+}
+
+/* Read all there is.  Returns 0, or -1 if c must be closed: the client
+   is gone, or sent a line longer than SERVER_BUF_MAX. */
+static int conn_read(Conn *c) {
+    char chunk[16384];
+    int  n;
+
+    while (c->in.len < (size_t)SERVER_BUF_MAX) {
+        n = (int)recv(c->fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            if (buf_put(&c->in, chunk, (size_t)n) != 0) return -1;
+            continue;
+        }
+        if (n == 0) {
+            c->eof = 1;
+            if (c->in.len > 0 && c->in.p[c->in.len - 1] != '\n' &&
+                buf_put(&c->in, "\n", 1) != 0)          /* last line unterminated */
+                return -1;
+            break;
+        }
+        if (sock_would_block()) break;
+        return -1;
+    }
+    if (c->in.len >= (size_t)SERVER_BUF_MAX && !memchr(c->in.p, '\n', c->in.len)) return -1;
+    return 0;
+}
+
+static void accept_clients(Server *s) {
+    Conn  *c;
+    sock_t fd;
+
+    while ((fd = accept(s->listener, NULL, NULL)) != SOCK_NONE) {
+        if (s->nconn == SERVER_MAX_CONNS || sock_nonblock(fd) != 0 ||
+            (c = (Conn *)calloc(1, sizeof(Conn))) == NULL) {
+            sock_close(fd);
+            continue;
+        }
+        c->fd   = fd;
+        c->want = EV_IN;
+        if (ev_add(&s->ev, fd, c, EV_IN) != 0) {
+            sock_close(fd);
+            free(c);
+            continue;
+        }
+        c->slot = s->nconn;
+        s->conn[s->nconn++] = c;
+    }
+}
+
+/* Take back the answered batches: queue their replies and send what
+   can be sent, then batch what arrived meanwhile. */
+static void collect_replies(Server *s) {
+    Conn *c, *next;
+    char  drain[256];
+
+    while (recv(s->wake[0], drain, sizeof(drain), 0) > 0) { }
+    pthread_mutex_lock(&s->lock);
+    c       = s->done;
+    s->done = NULL;
+    pthread_mutex_unlock(&s->lock);
+
+    for (; c; c = next) {
+        next    = c->next;
+        c->busy = 0;
+        if (c->fd == SOCK_NONE) {             /* closed while busy */
+            conn_free(c);
+            continue;
+        }
+        if (buf_put(&c->out, c->reply.p, c->reply.len) != 0 || conn_flush(c) != 0) {
+            conn_close(s, c);
+            continue;
+        }
+        conn_dispatch(s, c);
+        conn_update(s, c);
+    }
+}
+
+static void serve_client(Server *s, Conn *c, int events) {
+    if (events & (EV_IN | EV_ERR)) {
+        if (conn_read(c) != 0) {
+            conn_close(s, c);
+            return;
+        }
+        conn_dispatch(s, c);
+    }
+    if ((events & EV_OUT) && conn_flush(c) != 0) {
+        conn_close(s, c);
+        return;
+    }
+    conn_dispatch(s, c);          /* sending may have made room */
+    conn_update(s, c);
+}
+
+/* Until SIGINT/SIGTERM.  Picks are applied as they come; the rankings
+   are refreshed once per SCORE_EPOCH_MIN besides, as dict_handle.h asks
+   of a handle that may go long without writes. */
+static void run_loop(Server *s) {
+    EvReady ready[EV_BATCH];
+    time_t  refreshed = time(NULL);
+    int     i, n, woke;
+
+    while (!g_stop) {
+        n    = ev_wait(&s->ev, ready, 500);
+        woke = 0;
+        for (i = 0; i < n; i++) {
+            if (ready[i].tag == &s->listener)     accept_clients(s);
+            else if (ready[i].tag == &s->wake[0]) woke = 1;
+            else serve_client(s, (Conn *)ready[i].tag, ready[i].events);
+        }
+        if (woke) collect_replies(s);     /* last: it may free a closed client */
+        if (difftime(time(NULL), refreshed) >= SCORE_EPOCH_MIN * 60.0) {
+            dict_handle_refresh_scores(s->dict);
+            refreshed = time(NULL);
+        }
+    }
+}
+
+/* ── Setup ───────────────────────────────────────────────────── */
+
+static sock_t open_listener(const char *host, int port) {
+    struct sockaddr_in addr;
+    sock_t             s;
+    int                on = 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "smart_dict_server: bad address %s\n", host);
+        return SOCK_NONE;
+    }
+    s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == SOCK_NONE) return SOCK_NONE;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
+    if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(s, 128) != 0 ||
+        sock_nonblock(s) != 0) {
+        fprintf(stderr, "smart_dict_server: cannot listen on %s:%d\n", host, port);
+        sock_close(s);
+        return SOCK_NONE;
+    }
+    return s;
+}
+
+/* Stop the workers (after the batches already queued) and free every
+   client. */
+static void shut_down(Server *s) {
+    int i;
+
+    pthread_mutex_lock(&s->lock);
+    s->quit = 1;
+    pthread_cond_broadcast(&s->work);
+    pthread_mutex_unlock(&s->lock);
+    for (i = 0; i < s->workers; i++) pthread_join(s->worker[i], NULL);
+    collect_replies(s);
+    while (s->nconn > 0) conn_close(s, s->conn[0]);
+}
+
+static void usage(void) {
+    printf("Usage: smart_dict_server.exe [--port N] [--host ADDR] [--threads N]\n"
+           "                             [--words FILE]\n"
+           "  --port N      TCP port (default %d)\n"
+           "  --host ADDR   IPv4 address to listen on (default 127.0.0.1)\n"
+           "  --threads N   request workers, 1..%d (default %d)\n"
+           "  --words FILE  word list served (default %s)\n"
+           "  Requests, one per line: s|word, a|prefix, p|word, n|\n",
+           SERVER_PORT, SERVER_WORKERS_MAX, SERVER_WORKERS, FILE_WORDS);
+}
+
+int main(int argc, char **argv) {
+    static Server s;
+    const char   *host  = "127.0.0.1";
+    const char   *words = FILE_WORDS;
+    int           port  = SERVER_PORT, threads = SERVER_WORKERS;
+    int           i, n, ret = 1;
+#ifdef _WIN32
+    WSADATA       wsa;
+#endif
+
+    for (i = 1; i < argc; i++) {
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!next) {
+            usage();
+            return 2;
+        }
+        if (strcmp(argv[i], "--port") == 0)         port    = atoi(next);
+        else if (strcmp(argv[i], "--host") == 0)    host    = next;
+        else if (strcmp(argv[i], "--threads") == 0) threads = atoi(next);
+        else if (strcmp(argv[i], "--words") == 0)   words   = next;
+        else {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+    if (port <= 0 || port > 65535) {
+        usage();
+        return 2;
+    }
+    threads = threads < 1 ? 1 : (threads > SERVER_WORKERS_MAX ? SERVER_WORKERS_MAX : threads);
+
+#ifdef _WIN32
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        fprintf(stderr, "smart_dict_server: no Winsock\n");
+        return 1;
+    }
+#else
+    signal(SIGPIPE, SIG_IGN);         /* a vanished client is a send error */
+#endif
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    s.listener = s.wake[0] = s.wake[1] = SOCK_NONE;
+    s.dict     = dict_handle_create();
+    if (!s.dict) return 1;
+    n = dict_handle_reload(s.dict, words, FILE_WORD_FREQ);
+    if (n <= 0) {
+        fprintf(stderr, "smart_dict_server: cannot load %s\n", words);
+        dict_handle_destroy(s.dict);
+        return 1;
+    }
+    printf("Loaded %d words from %s\n", n, words);
+
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.work, NULL);
+    if (ev_init(&s.ev) != 0 || wake_pair(s.wake) != 0 ||
+        (s.listener = open_listener(host, port)) == SOCK_NONE ||
+        ev_add(&s.ev, s.listener, &s.listener, EV_IN) != 0 ||
+        ev_add(&s.ev, s.wake[0], &s.wake[0], EV_IN) != 0) {
+        fprintf(stderr, "smart_dict_server: cannot start\n");
+        goto out;
+    }
+    for (s.workers = 0; s.workers < threads; s.workers++)
+        if (pthread_create(&s.worker[s.workers], NULL, worker_main, &s) != 0) break;
+    if (s.workers == 0) {
+        fprintf(stderr, "smart_dict_server: cannot start the workers\n");
+        goto out;
+    }
+
+    printf("Serving on %s:%d with %d worker%s (Ctrl+C stops)\n", host, port, s.workers,
+           s.workers == 1 ? "" : "s");
+    fflush(stdout);
+    run_loop(&s);
+    shut_down(&s);
+    printf("Stopped after %lu requests\n", s.requests);
+    ret = 0;
+
+out:
+    if (s.listener != SOCK_NONE) sock_close(s.listener);
+    if (s.wake[0] != SOCK_NONE) {
+        sock_close(s.wake[0]);
+        sock_close(s.wake[1]);
+    }
+    ev_free(&s.ev);
+    pthread_cond_destroy(&s.work);
+    pthread_mutex_destroy(&s.lock);
+    dict_handle_destroy(s.dict);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return ret;
+}
@@ -0,0 +1,87 @@
+/* shape.h - Tree shape diagnostics shared by every index */
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <stddef.h>   /* size_t   */
+#include <stdint.h>   /* uint64_t */
+#include "config.h"
+
+/*
+ * TreeShape - how deep an index's entries sit, and what a lookup of each
+ * one costs.
+ *
+ * An entry's depth is the number of nodes a search visits to reach it,
+ * the root counting as 1, so the largest depth is the height that the
+ * *_height calls report.  In the B+-tree every entry's depth is the
+ * height; in the trie it is the number of edges spelled out.
+ *
+ * An entry's compares are the key comparisons its lookup makes: one per
+ * node in the binary trees, a sibling scan per level in the trie (one
+ * first-character test per sibling passed over), and a scan of each node
+ * in the B+-tree.  The average over all entries is the expected cost of a
+ * successful lookup with every word equally likely.
+ *
+ * depth[d] counts the entries at depth d; the last bucket holds every
+ * entry at SHAPE_DEPTHS - 1 or deeper.  Every *_shape call adds to what s
+ * already holds; clear it first with shape_clear.
+ */
+#define SHAPE_DEPTHS  64
+
+typedef struct TreeShape {
+    size_t   entries;
+    int      max_depth;
+    uint64_t sum_depth;
+    uint64_t sum_compares;
+    size_t   depth[SHAPE_DEPTHS];
+} TreeShape;
+
+static inline void shape_clear(TreeShape *s) {
+    size_t i;
+    s->entries = 0;
+    s->max_depth = 0;
+    s->sum_depth = s->sum_compares = 0;
+    for (i = 0; i < SHAPE_DEPTHS; i++) s->depth[i] = 0;
+}
+
+/* Count one entry at depth d, found with c compares. */
+static inline void shape_add(TreeShape *s, int d, int c) {
+    s->entries++;
+    s->sum_depth    += (uint64_t)d;
+    s->sum_compares += (uint64_t)c;
+    if (d > s->max_depth) s->max_depth = d;
+    s->depth[d < SHAPE_DEPTHS - 1 ? d : SHAPE_DEPTHS - 1]++;
+}
+
+static inline double shape_avg_depth(const TreeShape *s) {
+    return s->entries ? (double)s->sum_depth / (double)s->entries : 0.0;
+}
+
+/* Expected compares of a successful lookup. */
+static inline double shape_avg_compares(const TreeShape *s) {
+    return s->entries ? (double)s->sum_compares / (double)s->entries : 0.0;
+}
+
+/* Height of a perfectly balanced binary tree of n nodes: floor(log2 n) + 1. */
+static inline int shape_min_height(size_t n) {
+    int h = 0;
+    for (; n; n >>= 1) h++;
+    return h;
+}
+
+/* Max depth over the balanced minimum: 1.0 is perfect, an AVL tree stays
+   under 1.45, and a tree built from sorted input reaches n / log2 n. */
+static inline double shape_skew(const TreeShape *s) {
+    return s->entries ? (double)s->max_depth / shape_min_height(s->entries) : 0.0;
+}
+
+/*
+ * 1 if a binary tree of n nodes with an entry at depth d is skewed enough
+ * to be rebuilt: the entry is deeper than SHAPE_SKEW_LIMIT times the balanced
+ * minimum and than SHAPE_SKEW_MIN_DEPTH (config.h).  A random insertion
+ * order gives about 3 times the minimum, so only ordered runs trip it.
+ */
+static inline int shape_too_deep(int d, size_t n) {
+    return d > SHAPE_SKEW_MIN_DEPTH && d > SHAPE_SKEW_LIMIT * shape_min_height(n);
+}
+
+#endif /* SHAPE_H */
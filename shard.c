@@ -0,0 +1,332 @@
+/* shard.c - One dictionary split by key range, one worker per shard */
+#define _POSIX_C_SOURCE 200809L   /* pthreads under -std=c99 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "shard.h"
+#include "dict_handle.h"
+#include "federation.h"
+#include "utils.h"
+
+/* What a request asks of its shard */
+enum { SHARD_LOOKUP, SHARD_COMPLETE, SHARD_INSERT, SHARD_DELETE, SHARD_PICK, SHARD_COUNT };
+
+/* The requests of one call, and the caller waiting for them */
+typedef struct ShardBatch {
+    pthread_mutex_t lock;
+    pthread_cond_t  done;
+    int             pending;    /* requests not yet answered */
+} ShardBatch;
+
+/* One request, queued on its shard (it lives on the caller's stack) */
+typedef struct ShardJob {
+    int                op;
+    const char        *text;    /* word or prefix                  */
+    const WordRecord  *rec;     /* SHARD_INSERT                    */
+    WordRecord        *out;     /* SHARD_LOOKUP, SHARD_COMPLETE    */
+    int                top_k;
+    int                ret;
+    ShardBatch        *batch;
+    struct ShardJob   *next;
+} ShardJob;
+
+typedef struct Shard {
+    DictHandle     *dict;
+    char            lo[MAX_WORD_LEN];  /* first key of the range      */
+    pthread_t       tid;
+    int             started;
+    pthread_mutex_t lock;              /* guards the queue and quit   */
+    pthread_cond_t  wake;
+    ShardJob       *head, *tail;
+    int             quit;
+} Shard;
+
+struct ShardedDict {
+    Shard shard[SHARD_MAX];
+    int   n;
+};
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+static void run_job(Shard *s, ShardJob *j) {
+    switch (j->op) {
+    case SHARD_LOOKUP:   j->ret = dict_handle_lookup(s->dict, j->text, j->out);   break;
+    case SHARD_COMPLETE: j->ret = dict_handle_autocomplete(s->dict, j->text, j->out,
+                                                           j->top_k);            break;
+    case SHARD_INSERT:   j->ret = dict_handle_insert(s->dict, j->rec);            break;
+    case SHARD_DELETE:   j->ret = dict_handle_delete(s->dict, j->text);           break;
+    case SHARD_PICK:     dict_handle_record_selection(s->dict, j->text);
+                         j->ret = 0;                                              break;
+    default:             j->ret = dict_handle_count(s->dict);                     break;
+    }
+}
+
+/* A shard's worker: its queue's requests, in order, until told to quit. */
+static void *shard_main(void *arg) {
+    Shard      *s = (Shard *)arg;
+    ShardJob   *j;
+    ShardBatch *b;
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        while (!s->head && !s->quit) pthread_cond_wait(&s->wake, &s->lock);
+        j = s->head;
+        if (j) {
+            s->head = j->next;
+            if (!s->head) s->tail = NULL;
+        }
+        pthread_mutex_unlock(&s->lock);
+        if (!j) break;                     /* quit, queue drained */
+
+        b = j->batch;                      /* j may vanish once answered */
+        run_job(s, j);
+        pthread_mutex_lock(&b->lock);
+        if (--b->pending == 0) pthread_cond_signal(&b->done);
+        pthread_mutex_unlock(&b->lock);
+    }
+    return NULL;
+}
+
+static void submit(Shard *s, ShardJob *j) {
+    j->next = NULL;
+    pthread_mutex_lock(&s->lock);
+    if (s->tail) s->tail->next = j;
+    else         s->head       = j;
+    s->tail = j;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void batch_init(ShardBatch *b, int pending) {
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->done, NULL);
+    b->pending = pending;
+}
+
+/* Sleep until every request of b is answered, then dispose of b. */
+static void batch_wait(ShardBatch *b) {
+    pthread_mutex_lock(&b->lock);
+    while (b->pending > 0) pthread_cond_wait(&b->done, &b->lock);
+    pthread_mutex_unlock(&b->lock);
+    pthread_cond_destroy(&b->done);
+    pthread_mutex_destroy(&b->lock);
+}
+
+/* One request to shard i, answered before returning. */
+static int ask(ShardedDict *sd, int i, int op, const char *text,
+               const WordRecord *rec, WordRecord *out, int top_k) {
+    ShardBatch b;
+    ShardJob   j;
+
+    batch_init(&b, 1);
+    j.op    = op;
+    j.text  = text;
+    j.rec   = rec;
+    j.out   = out;
+    j.top_k = top_k;
+    j.ret   = 0;
+    j.batch = &b;
+    submit(&sd->shard[i], &j);
+    batch_wait(&b);
+    return j.ret;
+}
+
+/* Last shard whose range starts at or before key (normalised). */
+static int shard_for_key(const ShardedDict *sd, const char *key) {
+    int lo = 0, hi = sd->n - 1, mid;
+    while (lo < hi) {
+        mid = lo + (hi - lo + 1) / 2;
+        if (str_key_cmp(sd->shard[mid].lo, key) <= 0) lo = mid;
+        else                                           hi = mid - 1;
+    }
+    return lo;
+}
+
+typedef struct Collect {
+    WordRecord **recs;
+    int          n;
+} Collect;
+
+static void collect_cb(const WordRecord *rec, void *arg) {
+    Collect *c = (Collect *)arg;
+    c->recs[c->n++] = (WordRecord *)rec;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+/*
+ * The file is read once into a scratch handle, so that every tree node,
+ * its own included, is allocated under the pools' lock; each shard is
+ * then built from its slice of the sorted walk (dict_handle_build copies
+ * the records), and the scratch copy is dropped.
+ */
+ShardedDict *sharded_load(const char *path, const char *freq_path, int shards) {
+    ShardedDict *sd;
+    DictHandle  *scratch;
+    DictView    *v;
+    Collect      all;
+    int          i, total, from, to, ok = 1;
+
+    if (!path) return NULL;
+    scratch = dict_handle_create();
+    if (!scratch) return NULL;
+    if (dict_handle_reload(scratch, path, freq_path) <= 0) {
+        dict_handle_destroy(scratch);
+        return NULL;
+    }
+    v     = dict_handle_acquire(scratch);
+    total = dict_view_count(v);
+    all.n    = 0;
+    all.recs = (WordRecord **)malloc((size_t)total * sizeof(WordRecord *));
+    sd       = (ShardedDict *)calloc(1, sizeof(ShardedDict));
+    if (!all.recs || !sd) {
+        fprintf(stderr, "[ERROR] sharded_load: malloc failed\n");
+        free(all.recs);
+        free(sd);
+        dict_view_release(v);
+        dict_handle_destroy(scratch);
+        return NULL;
+    }
+    dict_view_foreach(v, collect_cb, &all);
+
+    if (shards > SHARD_MAX) shards = SHARD_MAX;
+    if (shards > all.n)     shards = all.n;
+    if (shards < 1)         shards = 1;
+    for (i = 0; i < shards && ok; i++) {
+        Shard *s = &sd->shard[i];
+        from = (int)((long long)all.n * i / shards);
+        to   = (int)((long long)all.n * (i + 1) / shards);
+        str_safe_copy(s->lo, i == 0 ? "" : all.recs[from]->word, sizeof(s->lo));
+        s->dict = dict_handle_create();
+        pthread_mutex_init(&s->lock, NULL);
+        pthread_cond_init(&s->wake, NULL);
+        sd->n = i + 1;
+        ok = s->dict && dict_handle_build(s->dict, all.recs + from, to - from) >= 0 &&
+             pthread_create(&s->tid, NULL, shard_main, s) == 0;
+        s->started = ok;
+    }
+
+    free(all.recs);
+    dict_view_release(v);
+    dict_handle_destroy(scratch);
+    if (!ok) {
+        sharded_destroy(sd);
+        return NULL;
+    }
+    return sd;
+}
+
+void sharded_destroy(ShardedDict *sd) {
+    int i;
+    if (!sd) return;
+    for (i = 0; i < sd->n; i++) {
+        Shard *s = &sd->shard[i];
+        if (s->started) {
+            pthread_mutex_lock(&s->lock);
+            s->quit = 1;
+            pthread_cond_signal(&s->wake);
+            pthread_mutex_unlock(&s->lock);
+            pthread_join(s->tid, NULL);
+        }
+        dict_handle_destroy(s->dict);
+        pthread_cond_destroy(&s->wake);
+        pthread_mutex_destroy(&s->lock);
+    }
+    free(sd);
+}
+
+int sharded_shards(const ShardedDict *sd) {
+    return sd ? sd->n : 0;
+}
+
+const char *sharded_split(const ShardedDict *sd, int i) {
+    return sd && i >= 0 && i < sd->n ? sd->shard[i].lo : "";
+}
+
+int sharded_shard_of(const ShardedDict *sd, const char *word) {
+    DictKey key;
+    if (!sd || !word) return 0;
+    dict_key_init(&key, word);
+    return shard_for_key(sd, key.text);
+}
+
+int sharded_count(ShardedDict *sd, int i) {
+    int total = 0;
+    if (!sd) return 0;
+    if (i >= 0 && i < sd->n) return ask(sd, i, SHARD_COUNT, NULL, NULL, NULL, 0);
+    for (i = 0; i < sd->n; i++) total += ask(sd, i, SHARD_COUNT, NULL, NULL, NULL, 0);
+    return total;
+}
+
+int sharded_lookup(ShardedDict *sd, const char *word, WordRecord *out) {
+    if (!sd || !word || !out) return 0;
+    return ask(sd, sharded_shard_of(sd, word), SHARD_LOOKUP, word, NULL, out, 0);
+}
+
+/*
+ * The shards meeting the prefix range are first..last: first holds the
+ * prefix itself, and each later one whose first key still starts with
+ * the prefix may hold more of its words.  One shard answers straight
+ * into results; several answer into a buffer each, in parallel, and are
+ * merged.
+ */
+int sharded_autocomplete(ShardedDict *sd, const char *prefix,
+                         WordRecord *results, int top_k) {
+    ShardBatch  b;
+    ShardJob    job[SHARD_MAX];
+    WordRecord *buf, *lists[SHARD_MAX];
+    DictKey     key;
+    size_t      plen;
+    int         counts[SHARD_MAX];
+    int         first, last, i, k, n;
+
+    if (!sd || !prefix || !results || top_k <= 0) return 0;
+    dict_key_init(&key, prefix);
+    plen = strlen(key.text);
+    if (plen == 0) return 0;           /* no empty-prefix dump */
+    k     = top_k > TOP_K_MAX ? TOP_K_MAX : top_k;
+    first = last = shard_for_key(sd, key.text);
+    while (last + 1 < sd->n && str_key_ncmp(sd->shard[last + 1].lo, key.text, plen) == 0)
+        last++;
+    if (first == last)
+        return ask(sd, first, SHARD_COMPLETE, key.text, NULL, results, k);
+
+    buf = (WordRecord *)malloc((size_t)(last - first + 1) * (size_t)k * sizeof(WordRecord));
+    if (!buf) return 0;
+    batch_init(&b, last - first + 1);
+    for (i = first; i <= last; i++) {
+        ShardJob *j = &job[i - first];
+        j->op    = SHARD_COMPLETE;
+        j->text  = key.text;
+        j->rec   = NULL;
+        j->out   = buf + (size_t)(i - first) * (size_t)k;
+        j->top_k = k;
+        j->ret   = 0;
+        j->batch = &b;
+        submit(&sd->shard[i], j);
+    }
+    batch_wait(&b);
+    for (i = 0; i <= last - first; i++) {
+        lists[i]  = job[i].out;
+        counts[i] = job[i].ret;
+    }
+    n = federation_merge(lists, counts, last - first + 1, results, k, NULL);
+    free(buf);
+    return n;
+}
+
+int sharded_insert(ShardedDict *sd, const WordRecord *rec) {
+    if (!sd || !rec) return 0;
+    return ask(sd, sharded_shard_of(sd, rec->word), SHARD_INSERT, NULL, rec, NULL, 0);
+}
+
+int sharded_delete(ShardedDict *sd, const char *word) {
+    if (!sd || !word) return 0;
+    return ask(sd, sharded_shard_of(sd, word), SHARD_DELETE, word, NULL, NULL, 0);
+}
+
+void sharded_record_selection(ShardedDict *sd, const char *word) {
+    if (!sd || !word) return;
+    ask(sd, sharded_shard_of(sd, word), SHARD_PICK, word, NULL, NULL, 0);
+}
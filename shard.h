@@ -0,0 +1,84 @@
+/* shard.h - One dictionary split by key range, one worker per shard */
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "config.h"
+#include "dictionary.h"
+
+/*
+ * ShardedDict - a dictionary partitioned into up to SHARD_MAX key ranges,
+ * each held by its own DictHandle (dict_handle.h) and served by its own
+ * worker thread.
+ *
+ * The ranges are balanced splits of the sorted word list, made when it is
+ * loaded: shard i holds the words from lo[i], the (i * n / shards)-th
+ * word, up to lo[i + 1] (shard 0 from "", the last to the end).  They are
+ * fixed from then on, so inserts make shards drift apart in size until
+ * the next load.
+ *
+ * Every call is routed and queued, much as a request to another process
+ * or node would be:
+ *
+ *   - a lookup, insert, delete or pick goes to the one shard whose range
+ *     holds the word;
+ *   - a prefix query goes to every shard whose range meets the prefix's.
+ *     That is one shard unless the prefix spans a split, as short ones
+ *     do.  The shards answer in parallel and their ranked lists are
+ *     merged (federation_merge).  The ranges are disjoint, so the merge
+ *     needs no dedupe.
+ *
+ * Each worker takes its shard's requests in order from a FIFO queue, and
+ * the caller sleeps until the last shard it asked has answered.  A shard's
+ * writes, rebalancing and re-ranking run on its worker while the other
+ * shards keep serving.  Its trees are about log2(shards) levels shallower
+ * than one tree over every word.  Tree nodes still come from the
+ * process-wide pools, so writes to different shards take turns on the
+ * pools' lock (dict_handle.h); reads never take it.
+ *
+ * Any number of threads may call in at once; results are copied out, and
+ * their text stays valid while the dictionary is alive.
+ */
+typedef struct ShardedDict ShardedDict;
+
+/*
+ * Load the word file at path (ranked by freq_path, if non-NULL), split it
+ * into `shards` ranges (clamped to 1..SHARD_MAX, and to the word count)
+ * and start one worker per shard.  Returns NULL if the file gives no
+ * words or on failure.
+ */
+ShardedDict *sharded_load(const char *path, const char *freq_path, int shards);
+
+/* Stop the workers and free every shard.  No call may still be running. */
+void sharded_destroy(ShardedDict *sd);
+
+/* Number of shards. */
+int sharded_shards(const ShardedDict *sd);
+
+/* First word of shard i's range ("" for shard 0). */
+const char *sharded_split(const ShardedDict *sd, int i);
+
+/* Shard whose range holds word (any case). */
+int sharded_shard_of(const ShardedDict *sd, const char *word);
+
+/* Words in shard i, or in every shard for i < 0. */
+int sharded_count(ShardedDict *sd, int i);
+
+/* Copy the record for word into *out.  Returns 1 if found, else 0. */
+int sharded_lookup(ShardedDict *sd, const char *word, WordRecord *out);
+
+/* Up to top_k best-ranked words starting with prefix, best first, copied
+   into results.  Returns the number found. */
+int sharded_autocomplete(ShardedDict *sd, const char *prefix,
+                         WordRecord *results, int top_k);
+
+/* Add a copy of rec to its shard.  Returns 1 if added, 0 if the word is
+   already there or on failure. */
+int sharded_insert(ShardedDict *sd, const WordRecord *rec);
+
+/* Remove word from its shard.  Returns 1 if it was there. */
+int sharded_delete(ShardedDict *sd, const char *word);
+
+/* Count a pick of word (dict_handle_record_selection on its shard). */
+void sharded_record_selection(ShardedDict *sd, const char *word);
+
+#endif /* SHARD_H */
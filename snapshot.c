@@ -0,0 +1,384 @@
+/* snapshot.c - Binary dictionary snapshot implementation */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L   /* mmap, open and fstat under -std=c99 */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "snapshot.h"
+#include "loader.h"
+#include "config.h"
+
+#define SNAP_MAGIC    "SDSNAP\r\n"  /* 8 bytes; \r\n exposes text-mode damage */
+#define SNAP_VERSION  2u           /* 2: select_time */
+#define SNAP_ENDIAN   0x01020304u   /* reads back differently on the wrong byte order */
+
+typedef struct SnapHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t count;       /* records in the table                  */
+    uint32_t rec_size;    /* sizeof(SnapRecord) of the writer      */
+    uint32_t word_len;    /* MAX_WORD_LEN of the writer            */
+    uint32_t text_size;   /* bytes in the text section             */
+} SnapHeader;
+
+typedef struct SnapRecord {
+    char     word[MAX_WORD_LEN];   /* lowercase, NUL-terminated      */
+    uint32_t meaning;              /* text offset, past the prefix   */
+    uint32_t pos;                  /* text offset, past the prefix   */
+    int32_t  freq;
+    int32_t  picks;
+    int32_t  select_time;
+} SnapRecord;
+
+/* ── Writing ─────────────────────────────────────────────────── */
+
+/*
+ * Both save passes walk the tree in the same order and lay out the text
+ * the same way: each meaning gets its own entry, each distinct POS tag
+ * (the store interns them, so equal tags share a pointer) only the first
+ * time it is seen.
+ */
+typedef struct SnapWriter {
+    FILE       *fp;
+    size_t      text;                             /* text bytes laid out */
+    const char *pos_seen[STORE_POS_INTERN_MAX];
+    uint32_t    pos_off[STORE_POS_INTERN_MAX];
+    int         num_pos;
+    int         failed;
+} SnapWriter;
+
+static void writer_reset(SnapWriter *w, FILE *fp) {
+    memset(w, 0, sizeof(SnapWriter));
+    w->fp = fp;
+}
+
+/* Bytes one string takes in the arena layout: prefix, text, NUL, padding. */
+static size_t text_entry_size(const char *s) {
+    size_t n = sizeof(uint32_t) + strlen(s) + 1;
+    return (n + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
+
+/*
+ * Lay out s at the current text offset and return the offset of its
+ * first byte.  With emit set the entry is also written out.
+ */
+static uint32_t text_place(SnapWriter *w, const char *s, int emit) {
+    static const char zeros[sizeof(uint32_t)] = { 0 };
+    size_t   size = text_entry_size(s);
+    uint32_t off;
+
+    if (w->text + size > UINT32_MAX) { w->failed = 1; return 0; }
+    off = (uint32_t)(w->text + sizeof(uint32_t));
+
+    if (emit) {
+        uint32_t len = (uint32_t)strlen(s);
+        size_t   pad = size - sizeof(len) - len;   /* NUL + alignment */
+        if (fwrite(&len, sizeof(len), 1, w->fp) != 1 ||
+            fwrite(s, 1, len, w->fp) != len ||
+            fwrite(zeros, 1, pad, w->fp) != pad)
+            w->failed = 1;
+    }
+    w->text += size;
+    return off;
+}
+
+/* Like text_place, but each interned POS tag is laid out only once. */
+static uint32_t pos_place(SnapWriter *w, const char *pos, int emit) {
+    int i;
+    for (i = 0; i < w->num_pos; i++)
+        if (w->pos_seen[i] == pos) return w->pos_off[i];
+    if (w->num_pos == STORE_POS_INTERN_MAX)   /* un-interned overflow tag */
+        return text_place(w, pos, emit);
+    w->pos_seen[w->num_pos] = pos;
+    w->pos_off[w->num_pos]  = text_place(w, pos, emit);
+    return w->pos_off[w->num_pos++];
+}
+
+/* Pass 1: the record table, assigning text offsets as it goes. */
+static void write_record(SnapWriter *w, const WordRecord *r) {
+    SnapRecord sr;
+
+    memset(&sr, 0, sizeof(sr));
+    memcpy(sr.word, r->word, sizeof(sr.word));
+    sr.meaning     = text_place(w, word_record_meaning(r), 0);
+    sr.pos         = pos_place(w, r->part_of_speech, 0);
+    sr.freq        = r->frequency_score;
+    sr.picks       = r->user_select_count;
+    sr.select_time = r->select_time;
+    if (fwrite(&sr, sizeof(sr), 1, w->fp) != 1) w->failed = 1;
+}
+
+/* Pass 2: the text section, in exactly the order pass 1 laid it out. */
+static void write_text(SnapWriter *w, const WordRecord *r) {
+    text_place(w, word_record_meaning(r), 1);
+    pos_place(w, r->part_of_speech, 1);
+}
+
+/* The records to save: a tree, or a sorted copy of one (recs != NULL). */
+typedef struct SnapSource {
+    AVLNode          *root;
+    const WordRecord *recs;
+    int               n;
+} SnapSource;
+
+typedef struct SnapWalk {
+    SnapWriter *w;
+    void      (*fn)(SnapWriter *w, const WordRecord *r);
+} SnapWalk;
+
+static void walk_cb(AVLNode *node, void *arg) {
+    SnapWalk *walk = (SnapWalk *)arg;
+    walk->fn(walk->w, node->rec);
+}
+
+/* Call fn for every record of src in sorted order. */
+static void for_each_record(const SnapSource *src, SnapWriter *w,
+                            void (*fn)(SnapWriter *w, const WordRecord *r)) {
+    SnapWalk walk;
+    int      i;
+
+    if (src->recs) {
+        for (i = 0; i < src->n; i++) fn(w, &src->recs[i]);
+        return;
+    }
+    walk.w  = w;
+    walk.fn = fn;
+    avl_inorder(src->root, walk_cb, &walk);
+}
+
+/* ── Mapping ─────────────────────────────────────────────────── */
+
+#ifdef _WIN32
+
+/* A mapped file cannot be replaced on Windows, and the next save has to
+   replace it while the dictionary is still live — so read it instead. */
+static void *snap_map(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+    long  len;
+    void *base;
+
+    if (!fp) return NULL;
+    if (fseek(fp, 0, SEEK_END) != 0 || (len = ftell(fp)) <= 0 ||
+        fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return NULL;
+    }
+    base = malloc((size_t)len);
+    if (base && fread(base, 1, (size_t)len, fp) != (size_t)len) {
+        free(base);
+        base = NULL;
+    }
+    fclose(fp);
+    *size = (size_t)len;
+    return base;
+}
+
+static void snap_unmap(void *base, size_t size) {
+    (void)size;
+    free(base);
+}
+
+#else
+
+static void *snap_map(const char *path, size_t *size) {
+    struct stat st;
+    void       *base;
+    int         fd = open(path, O_RDONLY);
+
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                        /* the mapping keeps the file alive */
+    if (base == MAP_FAILED) return NULL;
+    *size = (size_t)st.st_size;
+    return base;
+}
+
+static void snap_unmap(void *base, size_t size) {
+    munmap(base, size);
+}
+
+#endif
+
+/* ── Validation ──────────────────────────────────────────────── */
+
+/* Is off the start of a complete, NUL-terminated text entry? */
+static int text_ok(const char *text, uint32_t text_size, uint32_t off) {
+    uint32_t len;
+    if (off < sizeof(len) || off > text_size || off % sizeof(len) != 0) return 0;
+    memcpy(&len, text + off - sizeof(len), sizeof(len));
+    return len < text_size - off && text[off + len] == '\0';
+}
+
+/*
+ * Check header, sizes, every offset and the sort order before anything
+ * is indexed.  Returns the record count, or -1 if the image is unusable.
+ */
+static int snap_check(const char *base, size_t size) {
+    SnapHeader        h;
+    const SnapRecord *recs;
+    const char       *text;
+    DictKey           prev, key;
+    uint32_t          i;
+
+    if (size < sizeof(h)) return -1;
+    memcpy(&h, base, sizeof(h));
+    if (memcmp(h.magic, SNAP_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version  != SNAP_VERSION || h.endian != SNAP_ENDIAN ||
+        h.rec_size != sizeof(SnapRecord) || h.word_len != MAX_WORD_LEN ||
+        h.count    >  (size - sizeof(h)) / sizeof(SnapRecord) ||
+        h.text_size != size - sizeof(h) - h.count * sizeof(SnapRecord))
+        return -1;
+
+    recs = (const SnapRecord *)(const void *)(base + sizeof(h));
+    text = (const char *)(recs + h.count);
+    prev.text[0] = '\0';
+    for (i = 0; i < h.count; i++) {
+        const SnapRecord *r = &recs[i];
+        if (!memchr(r->word, '\0', sizeof(r->word)) || r->word[0] == '\0') return -1;
+        if (!text_ok(text, h.text_size, r->meaning) ||
+            !text_ok(text, h.text_size, r->pos))
+            return -1;
+        /* Stored keys are lowercased, so check the order they will have */
+        dict_key_init(&key, r->word);
+        if (i > 0 && strcmp(prev.text, key.text) >= 0) return -1;
+        prev = key;
+    }
+    return (int)h.count;
+}
+
+/* ── Saving ──────────────────────────────────────────────────── */
+
+static int save_source(const char *path, const SnapSource *src) {
+    char       tmp[512];
+    SnapHeader h;
+    SnapWriter w;
+    FILE      *fp;
+    int        failed;
+
+    if (!path) return -1;
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    fp = fopen(tmp, "wb");
+    if (!fp) return -1;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAP_MAGIC, sizeof(h.magic));
+    h.version  = SNAP_VERSION;
+    h.endian   = SNAP_ENDIAN;
+    h.count    = (uint32_t)(src->recs ? src->n : avl_count(src->root));
+    h.rec_size = sizeof(SnapRecord);
+    h.word_len = MAX_WORD_LEN;
+
+    /* Header goes first as a placeholder; text_size is known after pass 1 */
+    writer_reset(&w, fp);
+    if (fwrite(&h, sizeof(h), 1, fp) != 1) w.failed = 1;
+    for_each_record(src, &w, write_record);
+    h.text_size = (uint32_t)w.text;
+    failed      = w.failed;
+
+    writer_reset(&w, fp);
+    for_each_record(src, &w, write_text);
+    failed |= w.failed || w.text != h.text_size;
+
+    if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(&h, sizeof(h), 1, fp) != 1)
+        failed = 1;
+    if (fclose(fp) != 0) failed = 1;
+    if (failed) {
+        remove(tmp);
+        return -1;
+    }
+
+#ifdef _WIN32
+    remove(path);   /* rename does not replace an existing file here */
+#endif
+    if (rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int snapshot_save(const char *path, AVLNode *avl_root) {
+    SnapSource src;
+    src.root = avl_root;
+    src.recs = NULL;
+    src.n    = 0;
+    return save_source(path, &src);
+}
+
+int snapshot_save_records(const char *path, const WordRecord *recs, int n) {
+    SnapSource src;
+    if (n < 0 || (n > 0 && !recs)) return -1;
+    src.root = NULL;
+    src.recs = recs;
+    src.n    = n;
+    return save_source(path, &src);
+}
+
+int snapshot_load(const char *path, RecordStore *store, BSTNode **bst_root,
+                  AVLNode **avl_root, TBTNode *tbt_header, Trie *trie) {
+    const SnapRecord *recs;
+    const char       *text;
+    WordRecord      **sorted;
+    WordRecord        rec;
+    char             *base;
+    size_t            size = 0;
+    int               n, i;
+
+    if (!path || !store || !avl_root) return -1;
+    if ((bst_root && *bst_root) || *avl_root ||
+        (tbt_header && tbt_count(tbt_header) > 0) ||
+        (trie && trie_count(trie) > 0))
+        return -1;
+
+    base = (char *)snap_map(path, &size);
+    if (!base) return -1;
+
+    n = snap_check(base, size);
+    sorted = n > 0 ? (WordRecord **)malloc((size_t)n * sizeof(WordRecord *)) : NULL;
+    if (!sorted || !store_adopt_backing(store, base, size, snap_unmap)) {
+        free(sorted);
+        snap_unmap(base, size);
+        return n == 0 ? 0 : -1;
+    }
+
+    /* From here on the store owns the mapping */
+    recs = (const SnapRecord *)(const void *)(base + sizeof(SnapHeader));
+    text = (const char *)(recs + n);
+    for (i = 0; i < n; i++) {
+        word_record_init(&rec);
+        memcpy(rec.word, recs[i].word, sizeof(rec.word));
+        rec.meaning        = text + recs[i].meaning;         /* borrowed */
+        rec.part_of_speech = text + recs[i].pos;
+        if (recs[i].freq  > 0) rec.frequency_score   = recs[i].freq;
+        if (recs[i].picks > 0) rec.user_select_count = recs[i].picks;
+        if (recs[i].select_time > 0) rec.select_time = recs[i].select_time;
+
+        sorted[i] = store_add_borrowed(store, &rec);
+        if (!sorted[i]) {
+            while (i-- > 0) store_release(store, sorted[i]);
+            free(sorted);
+            return -1;
+        }
+    }
+
+    /* The table is already sorted and unique: straight to the bulk builds */
+    load_build_sorted(sorted, n, bst_root, avl_root, tbt_header, trie);
+
+    free(sorted);
+    return n;
+}
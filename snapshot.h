@@ -0,0 +1,57 @@
+/* snapshot.h - Binary dictionary snapshot with memory-mapped loading */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "bst.h"
+#include "avl.h"
+#include "tbt.h"
+#include "trie.h"
+#include "store.h"
+
+/*
+ * Snapshot file - the whole dictionary in one versioned binary image, so
+ * startup needs no text parsing, no sort and no per-record allocation:
+ *
+ *   [header]   magic, version, byte-order tag, record count, layout sizes
+ *   [records]  count fixed-size entries, strictly sorted by word:
+ *              word[MAX_WORD_LEN], meaning/pos offsets, freq, picks,
+ *              select_time
+ *   [text]     every meaning and POS string in the StringArena layout
+ *              ([len:4][bytes][\0], 4-byte aligned), so the strings can
+ *              be used in place exactly like arena-owned ones
+ *
+ * Loading maps the file read-only (POSIX mmap; on Windows one fread into
+ * a single buffer, so the file is never locked against the next save),
+ * hands the block to the record store, and adds each record with its
+ * meaning borrowed from the mapping.  The record table is already sorted,
+ * so the trees are bulk-built in O(n) straight from it — the sorted order
+ * is the prebuilt index.
+ *
+ * The layout is native-endian with the in-memory sizes baked in; a file
+ * written by a different build (byte order, MAX_WORD_LEN, version) is
+ * rejected and the caller falls back to the text files.
+ */
+
+/*
+ * Write every record of the tree rooted at avl_root to path, in sorted
+ * order.  The file is written under a temporary name and renamed into
+ * place, so a crash mid-save never leaves a truncated snapshot.
+ * Returns 0 on success, -1 on error.
+ */
+int snapshot_save(const char *path, AVLNode *avl_root);
+
+/* The same from recs[0..n), which must be sorted and unique by word (a
+   copy of the tree in order).  Returns 0 on success, -1 on error. */
+int snapshot_save_records(const char *path, const WordRecord *recs, int n);
+
+/*
+ * Load the snapshot at path into an empty store and empty trees (bst_root,
+ * tbt_header and trie may be NULL).  The store takes ownership of the
+ * mapping and releases it in store_free.  Returns the number of words
+ * loaded, or -1 if the file is missing, malformed or from an incompatible
+ * build, or the trees are not empty — nothing is indexed in that case.
+ */
+int snapshot_load(const char *path, RecordStore *store, BSTNode **bst_root,
+                  AVLNode **avl_root, TBTNode *tbt_header, Trie *trie);
+
+#endif /* SNAPSHOT_H */
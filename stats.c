@@ -0,0 +1,134 @@
+/* stats.c - Engine counters: per-thread blocks and their totals */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L   /* clock_gettime under -std=c99 */
+#endif
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "stats.h"
+
+static const char *const STATS_NAMES[STAT_COUNTERS] = {
+    "node_visits", "key_compares", "rotations", "ac_queries",
+    "ac_candidates", "ac_results", "ac_ns", "sorts", "sorted_items",
+};
+
+#if ENGINE_STATS
+
+__thread StatsBlock *stats_tls = NULL;
+
+/* Used by a thread whose block could not be allocated: its counts are
+   dropped rather than shared unsafely. */
+static __thread StatsBlock unlisted;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   stats_key;
+static int             stats_key_ok = 0;
+
+static StatsBlock *live = NULL;               /* blocks of running threads  */
+static uint64_t    retired[STAT_COUNTERS];    /* folded in from exited ones */
+static uint64_t    base[STAT_COUNTERS];       /* totals at the last reset   */
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* Thread exit: fold the block into the retired totals and drop it. */
+static void stats_detach(void *arg) {
+    StatsBlock *b = (StatsBlock *)arg;
+    int         c;
+
+    pthread_mutex_lock(&stats_lock);
+    for (c = 0; c < STAT_COUNTERS; c++) retired[c] += b->v[c];
+    if (b->prev) b->prev->next = b->next;
+    else         live          = b->next;
+    if (b->next) b->next->prev = b->prev;
+    pthread_mutex_unlock(&stats_lock);
+    stats_tls = &unlisted;   /* in case a later destructor still counts */
+    free(b);
+}
+
+static void stats_key_create(void) {
+    stats_key_ok = pthread_key_create(&stats_key, stats_detach) == 0;
+}
+
+/* Sum of every block ever attached, as of now.  Caller holds the lock. */
+static void stats_totals(uint64_t *t) {
+    const StatsBlock *b;
+    int               c;
+
+    for (c = 0; c < STAT_COUNTERS; c++) t[c] = retired[c];
+    for (b = live; b; b = b->next)
+        for (c = 0; c < STAT_COUNTERS; c++)
+            t[c] += __atomic_load_n(&b->v[c], __ATOMIC_RELAXED);
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+StatsBlock *stats_attach(void) {
+    StatsBlock *b;
+
+    pthread_once(&stats_once, stats_key_create);
+    b = (StatsBlock *)calloc(1, sizeof(StatsBlock));
+    if (!b || !stats_key_ok || pthread_setspecific(stats_key, b) != 0) {
+        free(b);
+        stats_tls = &unlisted;
+        return stats_tls;
+    }
+    pthread_mutex_lock(&stats_lock);
+    b->next = live;
+    if (live) live->prev = b;
+    live = b;
+    pthread_mutex_unlock(&stats_lock);
+    stats_tls = b;
+    return b;
+}
+
+uint64_t stats_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER        now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000u +
+           (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000u /
+           (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void stats_snapshot(EngineStats *out) {
+    uint64_t t[STAT_COUNTERS];
+    int      c;
+
+    pthread_mutex_lock(&stats_lock);
+    stats_totals(t);
+    for (c = 0; c < STAT_COUNTERS; c++) out->v[c] = t[c] - base[c];
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void stats_reset(void) {
+    pthread_mutex_lock(&stats_lock);
+    stats_totals(base);
+    pthread_mutex_unlock(&stats_lock);
+}
+
+#else
+
+void stats_snapshot(EngineStats *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+void stats_reset(void) {
+}
+
+#endif /* ENGINE_STATS */
+
+const char *stats_name(StatsCounter c) {
+    return (int)c >= 0 && c < STAT_COUNTERS ? STATS_NAMES[c] : "?";
+}
@@ -0,0 +1,107 @@
+/* stats.h - Engine counters and timers on the query hot paths */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include "config.h"
+
+/*
+ * What the trees and the autocomplete engine do under load: how many
+ * nodes a search or prefix scan touched, how many keys it compared, how
+ * many rotations kept the balanced trees balanced, and per autocomplete
+ * query how many records were offered to the top-k heap and how many
+ * were sorted into the answer.
+ *
+ * Compiled in with ENGINE_STATS (config.h).  With it at 0 every STATS_*
+ * macro below is empty, the hot paths are exactly as they were, and a
+ * snapshot reads all zeros.  With it at 1 each thread counts into a
+ * block of its own — a plain load and store, no lock and no shared
+ * cache line — and stats_snapshot sums every thread's block, including
+ * those of threads that have since exited.
+ *
+ * The counters are for watching trends (per query, per benchmark run),
+ * not accounting: a snapshot taken while other threads run is a sum of
+ * values each read at a slightly different moment.
+ */
+typedef enum StatsCounter {
+    STAT_NODE_VISITS,     /* tree nodes reached by searches, updates and scans */
+    STAT_KEY_COMPARES,    /* word comparisons made on those paths              */
+    STAT_ROTATIONS,       /* AVL / TBT rotations (a double rotation is two)     */
+    STAT_AC_QUERIES,      /* autocomplete prefixes answered                     */
+    STAT_AC_CANDIDATES,   /* records offered to a top-k heap                    */
+    STAT_AC_RESULTS,      /* records returned                                   */
+    STAT_AC_NS,           /* nanoseconds inside autocomplete calls              */
+    STAT_SORTS,           /* sorts run: heap drains into an answer, batch qsorts */
+    STAT_SORTED_ITEMS,    /* elements those sorts ordered                       */
+    STAT_COUNTERS
+} StatsCounter;
+
+/* Totals of every counter. */
+typedef struct EngineStats {
+    uint64_t v[STAT_COUNTERS];
+} EngineStats;
+
+/* Every thread's counts since the last stats_reset (zeros if
+   ENGINE_STATS is off). */
+void stats_snapshot(EngineStats *out);
+
+/* Start counting from zero again. */
+void stats_reset(void);
+
+/* Short display name of a counter ("node_visits", ...). */
+const char *stats_name(StatsCounter c);
+
+/* ── Hot-path macros ─────────────────────────────────────────── */
+
+#if ENGINE_STATS
+
+/* One thread's counters: only the owning thread writes them. */
+typedef struct StatsBlock {
+    uint64_t           v[STAT_COUNTERS];
+    struct StatsBlock *prev, *next;   /* list of live threads' blocks */
+} StatsBlock;
+
+extern __thread StatsBlock *stats_tls;  /* this thread's block, NULL until first use */
+
+/* Give the calling thread its block (stats.c). */
+StatsBlock *stats_attach(void);
+
+/* Monotonic clock in nanoseconds, for STATS_TIME. */
+uint64_t stats_now_ns(void);
+
+static inline void stats_add(StatsCounter c, uint64_t n) {
+    StatsBlock *b = stats_tls ? stats_tls : stats_attach();
+    /* Relaxed: a plain increment on every target, but readable from
+       stats_snapshot on another thread without a data race */
+    __atomic_store_n(&b->v[c], b->v[c] + n, __ATOMIC_RELAXED);
+}
+
+/* One node reached and its key compared: the step of every descent. */
+static inline void stats_visit(void) {
+    StatsBlock *b = stats_tls ? stats_tls : stats_attach();
+    __atomic_store_n(&b->v[STAT_NODE_VISITS],  b->v[STAT_NODE_VISITS]  + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&b->v[STAT_KEY_COMPARES], b->v[STAT_KEY_COMPARES] + 1, __ATOMIC_RELAXED);
+}
+
+#define STATS_ADD(c, n)  stats_add((c), (uint64_t)(n))
+#define STATS_VISIT()    stats_visit()
+
+/* Run call, adding the nanoseconds it took to counter c. */
+#define STATS_TIME(c, call)                                   \
+    do {                                                      \
+        uint64_t stats_t0_ = stats_now_ns();                  \
+        call;                                                 \
+        stats_add((c), stats_now_ns() - stats_t0_);           \
+    } while (0)
+
+#else
+
+#define STATS_ADD(c, n)      ((void)0)
+#define STATS_VISIT()        ((void)0)
+#define STATS_TIME(c, call)  do { call; } while (0)
+
+#endif /* ENGINE_STATS */
+
+#define STATS_INC(c)  STATS_ADD((c), 1)
+
+#endif /* STATS_H */
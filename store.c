@@ -0,0 +1,544 @@
+/* store.c - Shared record store implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "store.h"
+#include "lazytext.h"
+#include "utils.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* Make sure slot 'id' is backed by an allocated slab. Returns 0 on failure. */
+static int store_ensure_slab(RecordStore *s, int id) {
+    int need = id / STORE_CHUNK_RECORDS + 1;
+
+    if (need <= s->num_chunks) return 1;
+
+    if (need > s->cap_chunks) {
+        int          cap = s->cap_chunks ? s->cap_chunks * 2 : 16;
+        WordRecord **tbl;
+        StorePick  **picks;
+        while (cap < need) cap *= 2;
+        /* Only the slab tables move — the slabs themselves never do */
+        tbl = (WordRecord **)realloc(s->chunks, (size_t)cap * sizeof(WordRecord *));
+        if (!tbl) return 0;
+        s->chunks = tbl;
+        picks = (StorePick **)realloc(s->picks, (size_t)cap * sizeof(StorePick *));
+        if (!picks) return 0;
+        s->picks      = picks;
+        s->cap_chunks = cap;
+    }
+
+    while (s->num_chunks < need) {
+        WordRecord *slab = (WordRecord *)malloc(STORE_CHUNK_RECORDS * sizeof(WordRecord));
+        StorePick  *pend = (StorePick *)calloc(STORE_CHUNK_RECORDS, sizeof(StorePick));
+        if (!slab || !pend) {
+            free(slab);
+            free(pend);
+            return 0;
+        }
+        s->picks[s->num_chunks]    = pend;
+        s->chunks[s->num_chunks++] = slab;
+    }
+    return 1;
+}
+
+/* Return the shared copy of the POS tag pos[0..len), adding it on first
+   sight.  Past STORE_POS_INTERN_MAX distinct tags, new ones are stored
+   un-interned. */
+static const char *store_intern_pos(RecordStore *s, const char *pos, size_t len) {
+    const char *p;
+    int         i;
+
+    for (i = 0; i < s->num_pos_tags; i++)
+        if (strncmp(s->pos_tags[i], pos, len) == 0 && s->pos_tags[i][len] == '\0')
+            return s->pos_tags[i];
+
+    p = arena_strndup(&s->text, pos, len);
+    if (p && s->num_pos_tags < STORE_POS_INTERN_MAX)
+        s->pos_tags[s->num_pos_tags++] = p;
+    return p;
+}
+
+/* Hand out a free slot (released ones first) with its id set, or NULL. */
+static WordRecord *store_slot(RecordStore *s) {
+    WordRecord *dst;
+    int         id;
+
+    if (s->num_free > 0) {
+        id = s->free_ids[--s->num_free];   /* reuse a released slot first */
+    } else {
+        if (!store_ensure_slab(s, s->next_slot)) {
+            fprintf(stderr, "store_add: malloc failed\n");
+            return NULL;
+        }
+        id = s->next_slot++;
+    }
+
+    dst     = &s->chunks[id / STORE_CHUNK_RECORDS][id % STORE_CHUNK_RECORDS];
+    dst->id = id;
+    s->count++;
+    return dst;
+}
+
+/* Pick state of slot id. */
+static StorePick *pick_slot(const RecordStore *s, int id) {
+    return &s->picks[id / STORE_CHUNK_RECORDS][id % STORE_CHUNK_RECORDS];
+}
+
+/* Put rec on the decaying list unless it is there.  0 on malloc failure. */
+static int track_decay(RecordStore *s, const WordRecord *rec) {
+    StorePick *p = pick_slot(s, rec->id);
+
+    if (p->decaying) return 1;
+    if (s->num_decaying == s->cap_decaying) {
+        int  cap = s->cap_decaying ? s->cap_decaying * 2 : 64;
+        int *ids = (int *)realloc(s->decaying, (size_t)cap * sizeof(int));
+        if (!ids) {
+            fprintf(stderr, "store: realloc failed\n");
+            return 0;
+        }
+        s->decaying     = ids;
+        s->cap_decaying = cap;
+    }
+    s->decaying[s->num_decaying++] = rec->id;
+    p->decaying = 1;
+    return 1;
+}
+
+/* Fold the pending picks of slot id, made at now, into its record. */
+static int apply_slot(RecordStore *s, int id, int now,
+                      void (*changed)(WordRecord *rec, void *arg), void *arg) {
+    StorePick  *p = pick_slot(s, id);
+    WordRecord *rec;
+
+    if (p->pending == 0) return 0;         /* released, or queued twice */
+    rec = &s->chunks[id / STORE_CHUNK_RECORDS][id % STORE_CHUNK_RECORDS];
+    rec->user_select_count += p->pending;
+    rec->select_time        = score_add_picks(rec->select_time, p->pending, now);
+    p->pending = 0;
+    track_decay(s, rec);
+    if (changed) changed(rec, arg);
+    return 1;
+}
+
+/* ── Word index ──────────────────────────────────────────────── */
+
+#define STORE_INDEX_MIN  1024   /* first table size (entries) */
+#define STORE_BATCH_GROUP  16   /* lookups store_find_batch keeps in flight */
+
+#if defined(__GNUC__)
+#define STORE_PREFETCH(p)  __builtin_prefetch(p)
+#else
+#define STORE_PREFETCH(p)  ((void)0)
+#endif
+
+/* Pick counters are bumped by many threads at once with no lock.  Relaxed
+   order is enough: they are only read back under exclusive access, which
+   the caller's lock already orders after every bump. */
+#if defined(__GNUC__)
+#define STORE_ATOMIC_ADD(p, n)  __atomic_fetch_add((p), (n), __ATOMIC_RELAXED)
+#define STORE_ATOMIC_LOAD(p)    __atomic_load_n((p), __ATOMIC_RELAXED)
+#else
+/* No atomics known: picks must then be counted by one thread at a time */
+#define STORE_ATOMIC_ADD(p, n)  ((*(p) += (n)) - (n))
+#define STORE_ATOMIC_LOAD(p)    (*(p))
+#endif
+
+/* FNV-1a over the normalised word. */
+static unsigned int word_hash(const char *w) {
+    unsigned int h = 2166136261u;
+    while (*w) {
+        h ^= (unsigned char)*w++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static const WordRecord *slot_record(const RecordStore *s, int id) {
+    return &s->chunks[id / STORE_CHUNK_RECORDS][id % STORE_CHUNK_RECORDS];
+}
+
+/* Table position holding word, or -1. */
+static int index_find(const RecordStore *s, const char *word, unsigned int h) {
+    int mask = s->index_cap - 1;
+    int i;
+    if (s->index_cap == 0) return -1;
+    for (i = (int)(h & (unsigned int)mask); s->index[i].id >= 0; i = (i + 1) & mask)
+        if (s->index[i].hash == h &&
+            str_key_cmp(slot_record(s, s->index[i].id)->word, word) == 0)
+            return i;
+    return -1;
+}
+
+/* Double the table (or create it).  Returns 0 on malloc failure. */
+static int index_grow(RecordStore *s) {
+    int        cap = s->index_cap ? s->index_cap * 2 : STORE_INDEX_MIN;
+    int        mask = cap - 1;
+    StoreSlot *tbl = (StoreSlot *)malloc((size_t)cap * sizeof(StoreSlot));
+    int        i, j;
+
+    if (!tbl) return 0;
+    for (i = 0; i < cap; i++) tbl[i].id = -1;
+    for (i = 0; i < s->index_cap; i++) {
+        if (s->index[i].id < 0) continue;
+        for (j = (int)(s->index[i].hash & (unsigned int)mask); tbl[j].id >= 0;
+             j = (j + 1) & mask)
+            ;
+        tbl[j] = s->index[i];
+    }
+    free(s->index);
+    s->index     = tbl;
+    s->index_cap = cap;
+    return 1;
+}
+
+/* Index rec under its word unless the word is already indexed.
+   Returns 0 only if the table is full and cannot grow. */
+static int index_add(RecordStore *s, const WordRecord *rec) {
+    unsigned int h = word_hash(rec->word);
+    int          mask, i;
+
+    if ((s->index_used + 1) * 4 > s->index_cap * 3 && !index_grow(s) &&
+        s->index_used + 1 >= s->index_cap)
+        return 0;
+
+    mask = s->index_cap - 1;
+    for (i = (int)(h & (unsigned int)mask); s->index[i].id >= 0; i = (i + 1) & mask)
+        if (s->index[i].hash == h &&
+            str_key_cmp(slot_record(s, s->index[i].id)->word, rec->word) == 0)
+            return 1;                      /* duplicate: the first one stays */
+    s->index[i].hash = h;
+    s->index[i].id   = rec->id;
+    s->index_used++;
+    return 1;
+}
+
+/* Drop rec's entry, if it has one, closing the gap by shifting later
+   entries of the probe run back (no tombstones). */
+static void index_remove(RecordStore *s, const WordRecord *rec) {
+    int i = index_find(s, rec->word, word_hash(rec->word));
+    int mask = s->index_cap - 1;
+    int j, home;
+
+    if (i < 0 || s->index[i].id != rec->id) return;
+    for (j = (i + 1) & mask; s->index[j].id >= 0; j = (j + 1) & mask) {
+        home = (int)(s->index[j].hash & (unsigned int)mask);
+        /* Entry j may move into the hole at i if its home is not in (i, j] */
+        if ((j > i) ? (home <= i || home > j) : (home <= i && home > j)) {
+            s->index[i] = s->index[j];
+            i = j;
+        }
+    }
+    s->index[i].id = -1;
+    s->index_used--;
+}
+
+/* Shared body of store_add and store_add_borrowed. */
+static WordRecord *store_add_impl(RecordStore *s, const WordRecord *rec,
+                                  int copy_meaning) {
+    WordRecord *dst;
+    const char *meaning, *pos;
+    int         id;
+
+    if (!s || !rec) return NULL;
+
+    /* Cold text goes to the arena at its exact length; borrowed text is
+       referenced where it already lives */
+    if (copy_meaning) meaning = arena_strdup(&s->text, word_record_meaning(rec));
+    else              meaning = rec->meaning ? rec->meaning : "";
+    pos = rec->part_of_speech ? rec->part_of_speech : "";
+    pos = store_intern_pos(s, pos, strlen(pos));
+    if (!meaning || !pos) return NULL;
+
+    dst = store_slot(s);
+    if (!dst) return NULL;
+    id   = dst->id;
+    *dst = *rec;                           /* struct copy of the hot fields */
+    str_tolower(dst->word, rec->word, sizeof(dst->word));
+    dst->meaning        = meaning;
+    dst->part_of_speech = pos;
+    dst->id             = id;
+    if (!index_add(s, dst)) {
+        fprintf(stderr, "store_add: malloc failed\n");
+        store_release(s, dst);
+        return NULL;
+    }
+    if (dst->select_time != 0) track_decay(s, dst);
+    return dst;
+}
+
+/* Shared body of store_add_fields and store_add_fields_borrowed: m is
+   the meaning already placed. */
+static WordRecord *add_fields_impl(RecordStore *s, TextSlice word, TextSlice pos,
+                                   const char *m, int frequency, int picks) {
+    WordRecord *dst;
+    const char *p;
+    size_t      i, n;
+
+    p = store_intern_pos(s, pos.ptr ? pos.ptr : "", pos.ptr ? pos.len : 0);
+    if (!m || !p) return NULL;
+
+    dst = store_slot(s);
+    if (!dst) return NULL;
+
+    /* Lowercase straight out of the input buffer (ASCII, like str_tolower) */
+    n = word.len < sizeof(dst->word) - 1 ? word.len : sizeof(dst->word) - 1;
+    for (i = 0; i < n && word.ptr[i] != '\0'; i++) {
+        char c = word.ptr[i];
+        dst->word[i] = (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
+    }
+    memset(dst->word + i, 0, sizeof(dst->word) - i);   /* zero-filled key */
+    dst->meaning           = m;
+    dst->part_of_speech    = p;
+    dst->frequency_score   = frequency;
+    dst->user_select_count = picks;
+    dst->select_time       = 0;
+    if (!index_add(s, dst)) {
+        fprintf(stderr, "store_add: malloc failed\n");
+        store_release(s, dst);
+        return NULL;
+    }
+    return dst;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void store_init(RecordStore *s) {
+    if (!s) return;
+    memset(s, 0, sizeof(RecordStore));
+    arena_init(&s->text);
+}
+
+WordRecord *store_add(RecordStore *s, const WordRecord *rec) {
+    return store_add_impl(s, rec, 1);
+}
+
+WordRecord *store_add_borrowed(RecordStore *s, const WordRecord *rec) {
+    return store_add_impl(s, rec, 0);
+}
+
+WordRecord *store_add_fields(RecordStore *s, TextSlice word, TextSlice pos,
+                             TextSlice meaning, int frequency, int picks) {
+    if (!s || !word.ptr) return NULL;
+    return add_fields_impl(s, word, pos,
+                           arena_strndup(&s->text, meaning.ptr, meaning.ptr ? meaning.len : 0),
+                           frequency, picks);
+}
+
+WordRecord *store_add_fields_borrowed(RecordStore *s, TextSlice word, TextSlice pos,
+                                      const char *meaning, int frequency, int picks) {
+    if (!s || !word.ptr) return NULL;
+    return add_fields_impl(s, word, pos, meaning ? meaning : "", frequency, picks);
+}
+
+int store_adopt_backing(RecordStore *s, void *base, size_t size,
+                        void (*release)(void *base, size_t size)) {
+    if (!s || s->backing) return 0;
+    s->backing         = base;
+    s->backing_size    = size;
+    s->backing_release = release;
+    return 1;
+}
+
+int store_adopt_lazy(RecordStore *s, struct LazyText *lazy) {
+    if (!s || s->lazy) return 0;
+    s->lazy = lazy;
+    return 1;
+}
+
+WordRecord *store_find(const RecordStore *s, const char *word) {
+    DictKey key;
+    dict_key_init(&key, word);
+    return store_find_normalized(s, &key);
+}
+
+WordRecord *store_find_normalized(const RecordStore *s, const DictKey *key) {
+    int i;
+    if (!s || !key->text[0]) return NULL;
+    i = index_find(s, key->text, word_hash(key->text));
+    return i < 0 ? NULL : (WordRecord *)slot_record(s, s->index[i].id);
+}
+
+int store_find_batch(const RecordStore *s, const char *const *words, int count,
+                     WordRecord **out) {
+    DictKey      key[STORE_BATCH_GROUP];
+    unsigned int h[STORE_BATCH_GROUP];
+    unsigned int mask;
+    int          g, i, n, pos, found = 0;
+
+    if (!s || s->index_cap == 0) {
+        for (i = 0; i < count; i++) out[i] = NULL;
+        return 0;
+    }
+    mask = (unsigned int)s->index_cap - 1u;
+    for (g = 0; g < count; g += n) {
+        n = count - g < STORE_BATCH_GROUP ? count - g : STORE_BATCH_GROUP;
+        /* Hash the whole group and start fetching its buckets ... */
+        for (i = 0; i < n; i++) {
+            dict_key_init(&key[i], words[g + i]);
+            h[i] = word_hash(key[i].text);
+            STORE_PREFETCH(&s->index[h[i] & mask]);
+        }
+        /* ... then the records the buckets point at ... */
+        for (i = 0; i < n; i++) {
+            pos = s->index[h[i] & mask].id;
+            if (pos >= 0) STORE_PREFETCH(slot_record(s, pos)->word);
+        }
+        /* ... so the probes themselves mostly hit the cache */
+        for (i = 0; i < n; i++) {
+            pos        = key[i].text[0] ? index_find(s, key[i].text, h[i]) : -1;
+            out[g + i] = pos < 0 ? NULL : (WordRecord *)slot_record(s, s->index[pos].id);
+            if (out[g + i]) found++;
+        }
+    }
+    return found;
+}
+
+WordRecord *store_get(const RecordStore *s, int id) {
+    if (!s || id < 0 || id >= s->next_slot) return NULL;
+    return &s->chunks[id / STORE_CHUNK_RECORDS][id % STORE_CHUNK_RECORDS];
+}
+
+void store_release(RecordStore *s, WordRecord *rec) {
+    if (!s || !rec) return;
+    index_remove(s, rec);
+    pick_slot(s, rec->id)->pending  = 0;   /* picks still pending die with it */
+    pick_slot(s, rec->id)->decaying = 0;   /* and its decaying entry lapses   */
+
+    if (s->num_free == s->cap_free) {
+        int  cap = s->cap_free ? s->cap_free * 2 : 64;
+        int *ids = (int *)realloc(s->free_ids, (size_t)cap * sizeof(int));
+        if (!ids) {
+            /* Slot is simply leaked until store_free — never handed out twice */
+            fprintf(stderr, "store_release: realloc failed\n");
+            s->count--;
+            return;
+        }
+        s->free_ids = ids;
+        s->cap_free = cap;
+    }
+
+    s->free_ids[s->num_free++] = rec->id;
+    rec->word[0] = '\0';                   /* mark slot as dead */
+    s->count--;
+}
+
+void store_add_pick(RecordStore *s, const WordRecord *rec) {
+    int queued;
+
+    if (!s || !rec || rec->id < 0 || rec->id >= s->next_slot) return;
+    if (STORE_ATOMIC_ADD(&pick_slot(s, rec->id)->pending, 1) != 0)
+        return;                                     /* already queued */
+
+    /* First pending pick of this record: queue it, unless the queue is
+       full — then store_apply_picks scans every slot instead */
+    queued = STORE_ATOMIC_ADD(&s->num_dirty, 1);
+    if (queued < STORE_PICK_QUEUE) s->dirty[queued] = rec->id;
+}
+
+int store_pending_picks(const RecordStore *s) {
+    return s ? STORE_ATOMIC_LOAD(&s->num_dirty) : 0;
+}
+
+int store_apply_picks(RecordStore *s, void (*changed)(WordRecord *rec, void *arg),
+                      void *arg) {
+    int i, now, n = 0;
+
+    if (!s || s->num_dirty == 0) return 0;
+    now = score_minutes();
+    if (s->num_dirty <= STORE_PICK_QUEUE) {
+        for (i = 0; i < s->num_dirty; i++)
+            n += apply_slot(s, s->dirty[i], now, changed, arg);
+    } else {
+        for (i = 0; i < s->next_slot; i++)  /* the queue overflowed */
+            n += apply_slot(s, i, now, changed, arg);
+    }
+    s->num_dirty = 0;
+    return n;
+}
+
+void store_track_decay(RecordStore *s, WordRecord *rec) {
+    if (s && rec && rec->select_time != 0 && rec->id >= 0 && rec->id < s->next_slot)
+        track_decay(s, rec);
+}
+
+int store_decay_due(const RecordStore *s) {
+    return s && s->num_decaying > 0 && s->ranked_clock != score_clock();
+}
+
+int store_decay(RecordStore *s, void (*changed)(WordRecord *rec, void *arg), void *arg) {
+    int clock, i, kept = 0, n = 0;
+
+    if (!s) return 0;
+    clock = score_clock();
+    if (s->ranked_clock == clock) return 0;
+
+    for (i = 0; i < s->num_decaying; i++) {
+        int         id  = s->decaying[i];
+        StorePick  *p   = pick_slot(s, id);
+        WordRecord *rec = &s->chunks[id / STORE_CHUNK_RECORDS][id % STORE_CHUNK_RECORDS];
+        int         was, now;
+
+        if (p->decaying != 1) continue;    /* released since, or listed twice */
+        /* ranked_clock 0: never ranked here, so assume it moved */
+        was = s->ranked_clock ? score_pick_weight(rec->select_time, s->ranked_clock) : -1;
+        now = score_pick_weight(rec->select_time, clock);
+        if (now == 0) {
+            rec->select_time = 0;          /* faded out: off the list */
+            p->decaying      = 0;
+        } else {
+            s->decaying[kept++] = id;
+            p->decaying = 2;               /* seen this pass */
+        }
+        if (now != was) {
+            if (changed) changed(rec, arg);
+            n++;
+        }
+    }
+    for (i = 0; i < kept; i++) pick_slot(s, s->decaying[i])->decaying = 1;
+    s->num_decaying = kept;
+    s->ranked_clock = clock;
+    return n;
+}
+
+void store_free(RecordStore *s) {
+    int i;
+    if (!s) return;
+    for (i = 0; i < s->num_chunks; i++) {
+        free(s->chunks[i]);
+        free(s->picks[i]);
+    }
+    free(s->chunks);
+    free(s->picks);
+    free(s->decaying);
+    arena_free(&s->text);                  /* every meaning and POS at once */
+    free(s->free_ids);
+    free(s->index);
+    if (s->backing && s->backing_release)
+        s->backing_release(s->backing, s->backing_size);   /* after the text users */
+    lazytext_free(s->lazy);
+    store_init(s);
+}
+
+int store_count(const RecordStore *s) {
+    return s ? s->count : 0;
+}
+
+void store_memory(const RecordStore *s, MemUsage *u) {
+    size_t slots;
+
+    if (!s) return;
+    slots = (size_t)s->num_chunks * STORE_CHUNK_RECORDS;
+    u->node_bytes     += (size_t)s->count * sizeof(WordRecord);
+    u->overhead_bytes += (slots - (size_t)s->count) * sizeof(WordRecord);
+    u->index_bytes    += (size_t)s->cap_chunks * (sizeof(WordRecord *) + sizeof(StorePick *))
+                       + slots * sizeof(StorePick)
+                       + (size_t)s->index_cap * sizeof(StoreSlot)
+                       + (size_t)s->cap_free * sizeof(int)
+                       + (size_t)s->cap_decaying * sizeof(int);
+    u->string_bytes   += s->backing_size;
+    u->entries        += (size_t)s->count;
+    arena_memory(&s->text, u);
+    lazytext_memory(s->lazy, u);
+}
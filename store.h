@@ -0,0 +1,245 @@
+/* store.h - Shared record store: one WordRecord per dictionary entry */
+#ifndef STORE_H
+#define STORE_H
+
+#include "dictionary.h"
+#include "arena.h"
+
+/*
+ * RecordStore - owns every WordRecord in the dictionary.
+ *
+ * BST, AVL and TBT nodes hold a WordRecord* into this store instead of
+ * embedding their own ~616-byte copy, so each entry exists exactly once
+ * and an update (frequency refresh, user pick) is visible to all trees.
+ *
+ * Records live in fixed-size slabs of STORE_CHUNK_RECORDS entries.  Slabs
+ * are never moved or resized, so a WordRecord* stays valid until the
+ * record is released or the store is freed — growing the store only adds
+ * new slabs.  Released slots go onto a free list and are reused first.
+ *
+ * Handle = slot index (WordRecord.id), stable for the record's lifetime.
+ *
+ * Hot/cold split: the hot WordRecord slabs hold key + scores only.  The
+ * definition and POS text are the cold side: they are copied into a
+ * StringArena (arena.h) at exactly their own length — no MAX_MEANING_LEN
+ * truncation, no padding — and the record's meaning/part_of_speech point
+ * into it.  POS tags are interned: the handful of distinct tags ("noun",
+ * "verb", ...) are stored once and shared by every record.
+ *
+ * Arena text is released in one shot by store_free; a released record's
+ * strings stay in the arena until then (they are never reused).
+ *
+ * Word index: the store also keeps an open-addressing hash table from
+ * word to slot (linear probing, backward-shift deletion, grown at 3/4
+ * full), so exact lookups (store_find) are one probe instead of a tree
+ * descent.  Every add indexes the new record unless a live record already
+ * has the same word — the first one added keeps the entry, matching the
+ * trees' "first occurrence wins" on load — and store_release drops the
+ * entry only if it is the released record's.  While a record is in no
+ * tree, its word is the only field the table reads.
+ *
+ * Borrowed text: a store can also adopt one read-only block (e.g. a
+ * memory-mapped snapshot, see snapshot.h) and add records whose meanings
+ * point straight into it, with no copy.  The block stays alive until
+ * store_free, which hands it back to its release function.
+ *
+ * Lazy text: a store can likewise own one LazyText source (lazytext.h)
+ * whose placeholders stand in for meanings still in a file; the loader
+ * adds those records with store_add_fields_borrowed.  Read meanings
+ * through word_record_meaning.
+ *
+ * Pending picks: beside every slab the store keeps a dense array of pick
+ * counters, one per slot.  store_add_pick bumps a record's counter with
+ * an atomic add and takes no lock, so any number of threads that only
+ * read the dictionary (a reader lock held, see dict_handle.h) can count
+ * picks at once.  Records, and the trees' score caches built on them, are
+ * not touched until someone with exclusive access calls
+ * store_apply_picks, which adds the counters to user_select_count and
+ * reports each record changed so the caller can re-rank it.  The first
+ * pick of a record also queues its slot, so applying costs one step per
+ * picked record; past STORE_PICK_QUEUE of them, it scans every slot.
+ *
+ * Decay: the store also lists the records whose picks still carry weight
+ * (select_time != 0, see dictionary.h), and the ranking clock it last
+ * ranked them at.  When the clock has moved on, store_decay reports each
+ * listed record whose weight changed, so the caller re-ranks just those,
+ * and drops the ones whose weight has reached 0.
+ */
+#define STORE_POS_INTERN_MAX  64   /* distinct POS tags interned per store */
+#define STORE_PICK_QUEUE     256   /* records with pending picks queued     */
+
+/* Per-slot pick state, in arrays beside the slabs. */
+typedef struct StorePick {
+    int pending;    /* picks counted, not yet applied (atomic)       */
+    int decaying;   /* nonzero while the slot is on the decaying list */
+} StorePick;
+
+/* One word index entry: the word's hash and its record slot (-1: empty). */
+typedef struct StoreSlot {
+    unsigned int hash;
+    int          id;
+} StoreSlot;
+
+/* A run of text that need not be NUL-terminated, e.g. one field inside a
+   file buffer.  ptr == NULL is treated as the empty string. */
+typedef struct TextSlice {
+    const char *ptr;
+    size_t      len;
+} TextSlice;
+
+typedef struct RecordStore {
+    WordRecord **chunks;      /* slab table; chunks[i] holds STORE_CHUNK_RECORDS */
+    StringArena  text;        /* cold side: meanings and POS tags                */
+    const char  *pos_tags[STORE_POS_INTERN_MAX]; /* interned POS strings         */
+    int          num_pos_tags;
+    int          num_chunks;  /* slabs allocated                                  */
+    int          cap_chunks;  /* capacity of the slab table                       */
+    int          next_slot;   /* first never-used slot (high-water mark)          */
+    int         *free_ids;    /* stack of released slots for reuse                */
+    int          num_free;
+    int          cap_free;
+    int          count;       /* live records                                     */
+    StoreSlot   *index;       /* word index, index_cap entries (power of two)     */
+    int          index_cap;
+    int          index_used;
+    void        *backing;     /* adopted block borrowed text lives in, or NULL    */
+    size_t       backing_size;
+    void       (*backing_release)(void *base, size_t size);
+    struct LazyText *lazy;    /* source of meanings still on disk, or NULL        */
+    StorePick  **picks;       /* per slab: pending picks and decay state         */
+    int          dirty[STORE_PICK_QUEUE];  /* slots whose first pick is pending  */
+    int          num_dirty;   /* records with pending picks (may pass the queue) */
+    int         *decaying;    /* slots whose picks still weigh something         */
+    int          num_decaying;
+    int          cap_decaying;
+    int          ranked_clock;  /* ranking clock they were last ranked at, or 0  */
+} RecordStore;
+
+/* Initialise an empty store (no allocation until the first add). */
+void store_init(RecordStore *s);
+
+/*
+ * Copy rec into the store and return the stored record.
+ * The stored word is lowercase-normalised, rec->meaning/part_of_speech are
+ * copied into the arena (NULL is treated as ""), and rec->id is
+ * ignored — the returned record carries its own slot id.  The record is
+ * added to the word index unless its word is already there (compare
+ * store_find(s, word) with the result to detect a duplicate).
+ * Returns NULL on malloc failure.
+ */
+WordRecord *store_add(RecordStore *s, const WordRecord *rec);
+
+/*
+ * Like store_add, but rec->meaning is referenced instead of copied.  It
+ * must stay valid until store_free — normally it points into the block
+ * given to store_adopt_backing.  POS tags are still interned.
+ */
+WordRecord *store_add_borrowed(RecordStore *s, const WordRecord *rec);
+
+/*
+ * Add a record built from slices of an input buffer, with no intermediate
+ * copy: the word is lowercased straight into the record (truncated to
+ * MAX_WORD_LEN - 1 chars), the meaning is copied once into the arena and
+ * the POS is interned.  Returns NULL on malloc failure or a NULL word.
+ */
+WordRecord *store_add_fields(RecordStore *s, TextSlice word, TextSlice pos,
+                             TextSlice meaning, int frequency, int picks);
+
+/*
+ * Like store_add_fields, but meaning is referenced instead of copied; it
+ * must stay valid until store_free (normally a placeholder from the
+ * store's LazyText).
+ */
+WordRecord *store_add_fields_borrowed(RecordStore *s, TextSlice word, TextSlice pos,
+                                      const char *meaning, int frequency, int picks);
+
+/*
+ * Give the store ownership of the block [base, base + size): store_free
+ * calls release(base, size).  One block per store; returns 0 if the
+ * store already holds one.
+ */
+int store_adopt_backing(RecordStore *s, void *base, size_t size,
+                        void (*release)(void *base, size_t size));
+
+/* Give the store ownership of lazy, freed by store_free.  One per store;
+   returns 0 if the store already holds one. */
+int store_adopt_lazy(RecordStore *s, struct LazyText *lazy);
+
+/* Return the live record for word (case-insensitive) in O(1) expected
+   time, or NULL.  With duplicates, the one added first. */
+WordRecord *store_find(const RecordStore *s, const char *word);
+
+/* Same as store_find for a key already normalised with dict_key_init. */
+WordRecord *store_find_normalized(const RecordStore *s, const DictKey *key);
+
+/*
+ * Look up count words at once: out[i] = store_find(s, words[i]).  The
+ * words are hashed a group at a time and their buckets and records
+ * prefetched before any probe, so the cache misses of a group overlap
+ * instead of being paid one lookup after another.  Returns the number
+ * of words found.
+ */
+int store_find_batch(const RecordStore *s, const char *const *words, int count,
+                     WordRecord **out);
+
+/* Return the record in slot id, or NULL if id is out of range. */
+WordRecord *store_get(const RecordStore *s, int id);
+
+/* Return rec's slot to the free list (and drop its word index entry).
+   rec must have come from store_add and must already be removed from
+   every tree that references it. */
+void store_release(RecordStore *s, WordRecord *rec);
+
+/*
+ * Count one pick of rec (a live record of s) without applying it: safe
+ * to call from many threads at once, and alongside readers, but not
+ * alongside anything that adds, releases or applies.
+ */
+void store_add_pick(RecordStore *s, const WordRecord *rec);
+
+/* Number of records with picks counted but not yet applied. */
+int store_pending_picks(const RecordStore *s);
+
+/*
+ * Add every pending pick to its record's user_select_count and call
+ * changed(rec, arg) (if non-NULL) once per record that moved, e.g. to
+ * fix up AVL and trie score caches.  Needs exclusive access to s.
+ * Returns the number of records changed.
+ */
+int store_apply_picks(RecordStore *s, void (*changed)(WordRecord *rec, void *arg),
+                      void *arg);
+
+/* Put rec on the decaying list if it has a select_time (store_add and
+   applied picks do this themselves; call it after setting select_time
+   on a stored record directly). */
+void store_track_decay(RecordStore *s, WordRecord *rec);
+
+/* 1 if the ranking clock has moved since the store's records were last
+   ranked and some of them may have decayed. */
+int store_decay_due(const RecordStore *s);
+
+/*
+ * Bring the store up to the ranking clock: call changed(rec, arg) (if
+ * non-NULL) for every record whose pick weight moved since the last
+ * call, so score caches can be fixed, and forget records whose weight
+ * is now 0 (their select_time is cleared).  O(records with weight), not
+ * O(store).  Needs exclusive access.  Returns the number changed.
+ */
+int store_decay(RecordStore *s, void (*changed)(WordRecord *rec, void *arg), void *arg);
+
+/* Free every slab (and any adopted block) and reset to the empty state. */
+void store_free(RecordStore *s);
+
+/* Return the number of live records. */
+int store_count(const RecordStore *s);
+
+/*
+ * Add the store to u (memusage.h): live records as nodes; definitions
+ * and POS tags (arena, adopted block, text read lazily) as strings;
+ * unused record slots and arena slack as overhead; the slab tables, the
+ * word hash, the pick and decay arrays and the lazy placeholders as
+ * index.
+ */
+void store_memory(const RecordStore *s, MemUsage *u);
+
+#endif /* STORE_H */
@@ -0,0 +1,173 @@
+/* suffix.c - Generalised suffix array implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include "suffix.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/* One suffix while sorting: its packed 8-byte prefix decides most compares. */
+typedef struct SuffixSortItem {
+    uint64_t     key;    /* dict_word_prefix of the suffix        */
+    const char  *s;      /* the suffix                            */
+    uint32_t     e;      /* packed (word id, offset)              */
+} SuffixSortItem;
+
+static int sort_item_cmp(const void *pa, const void *pb) {
+    const SuffixSortItem *a = (const SuffixSortItem *)pa;
+    const SuffixSortItem *b = (const SuffixSortItem *)pb;
+    int c;
+    if (a->key != b->key) return a->key < b->key ? -1 : 1;
+    /* Equal and both longer than 8: the rest decides */
+    if ((a->key & 0xFF) != 0) {
+        c = strcmp(a->s + 8, b->s + 8);
+        if (c) return c;
+    }
+    return a->e < b->e ? -1 : a->e > b->e;   /* same text: word order */
+}
+
+typedef struct CollectCtx {
+    WordRecord **out;
+    size_t       bytes;
+} CollectCtx;
+
+static void collect_cb(AVLNode *n, void *arg) {
+    CollectCtx *c = (CollectCtx *)arg;
+    *c->out++ = n->rec;
+    c->bytes += strlen(n->rec->word) + 1;
+}
+
+static const char *suffix_at(const SuffixIndex *ix, uint32_t e) {
+    return ix->text + ix->start[e >> SUFFIX_OFFSET_BITS] + (e & SUFFIX_OFFSET_MASK);
+}
+
+/* First suffix whose first len characters compare >= sub (or > sub if
+   past is set) — the two ends of the run starting with sub. */
+static int run_bound(const SuffixIndex *ix, const char *sub, size_t len, int past) {
+    int lo = 0, hi = ix->n, mid, c;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        c = strncmp(suffix_at(ix, ix->sa[mid]), sub, len);
+        if (c < 0 || (past && c == 0)) lo = mid + 1;
+        else                           hi = mid;
+    }
+    return lo;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int suffix_build(SuffixIndex *ix, AVLNode *avl_root) {
+    SuffixSortItem *items;
+    CollectCtx      ctx;
+    size_t          pos;
+    int             n = avl_count(avl_root), w, i, len, m;
+
+    if (!ix) return -1;
+    suffix_free(ix);
+    if (n == 0) return 0;
+    if (n > (int)(UINT32_MAX >> SUFFIX_OFFSET_BITS)) {
+        fprintf(stderr, "[ERROR] suffix_build: %d words exceed the packed id range\n", n);
+        return -1;
+    }
+
+    ix->recs  = (WordRecord **)malloc((size_t)n * sizeof(WordRecord *));
+    ix->start = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+    if (!ix->recs || !ix->start) goto fail;
+    ctx.out   = ix->recs;
+    ctx.bytes = 0;
+    avl_inorder(avl_root, collect_cb, &ctx);
+    if (ctx.bytes - (size_t)n > (size_t)INT_MAX) {
+        fprintf(stderr, "[ERROR] suffix_build: too many suffixes to index\n");
+        suffix_free(ix);
+        return -1;
+    }
+
+    /* Every character but the NULs starts one suffix */
+    ix->text  = (char *)malloc(ctx.bytes);
+    ix->sa    = (uint32_t *)malloc((ctx.bytes - (size_t)n) * sizeof(uint32_t));
+    items     = (SuffixSortItem *)malloc((ctx.bytes - (size_t)n) * sizeof(SuffixSortItem));
+    if (!ix->text || !ix->sa || !items) { free(items); goto fail; }
+
+    pos = 0;
+    m   = 0;
+    for (w = 0; w < n; w++) {
+        len = (int)strlen(ix->recs[w]->word);
+        ix->start[w] = (uint32_t)pos;
+        memcpy(ix->text + pos, ix->recs[w]->word, (size_t)len + 1);
+        for (i = 0; i < len; i++, m++) {
+            items[m].s   = ix->text + pos + i;
+            items[m].key = dict_word_prefix(items[m].s);
+            items[m].e   = ((uint32_t)w << SUFFIX_OFFSET_BITS) | (uint32_t)i;
+        }
+        pos += (size_t)len + 1;
+    }
+    qsort(items, (size_t)m, sizeof(SuffixSortItem), sort_item_cmp);
+    for (i = 0; i < m; i++) ix->sa[i] = items[i].e;
+    free(items);
+
+    ix->words    = n;
+    ix->n        = m;
+    ix->text_len = pos;
+    return 0;
+
+fail:
+    fprintf(stderr, "[ERROR] suffix_build: malloc failed\n");
+    suffix_free(ix);
+    return -1;
+}
+
+void suffix_free(SuffixIndex *ix) {
+    if (!ix) return;
+    free(ix->text);
+    free(ix->start);
+    free(ix->recs);
+    free(ix->sa);
+    ix->text     = NULL;
+    ix->start    = NULL;
+    ix->recs     = NULL;
+    ix->sa       = NULL;
+    ix->words    = 0;
+    ix->n        = 0;
+    ix->text_len = 0;
+}
+
+int suffix_search(const SuffixIndex *ix, const char *sub,
+                  WordRecord *results, int top_k) {
+    DictKey      key;
+    WordRecord  *best[TOP_K_MAX];
+    WordRecord  *rec;
+    size_t       len;
+    int          lo, hi, i, j, n = 0;
+
+    if (!ix || ix->n == 0 || !sub || !results) return 0;
+    if (top_k > TOP_K_MAX) top_k = TOP_K_MAX;
+    if (top_k <= 0) return 0;
+    dict_key_init(&key, sub);
+    len = strlen(key.text);
+    if (len == 0) return 0;
+
+    lo = run_bound(ix, key.text, len, 0);
+    hi = run_bound(ix, key.text, len, 1);
+    for (i = lo; i < hi; i++) {
+        rec = ix->recs[ix->sa[i] >> SUFFIX_OFFSET_BITS];
+        if (n == top_k && !word_record_outranks(rec, best[n - 1])) continue;
+        for (j = 0; j < n && best[j] != rec; j++)
+            ;
+        if (j < n) continue;                /* sub occurs twice in it */
+        j = n < top_k ? n++ : n - 1;        /* the worst one drops out */
+        for (; j > 0 && word_record_outranks(rec, best[j - 1]); j--)
+            best[j] = best[j - 1];
+        best[j] = rec;
+    }
+
+    for (i = 0; i < n; i++) results[i] = *best[i];
+    return n;
+}
+
+size_t suffix_memory(const SuffixIndex *ix) {
+    if (!ix) return 0;
+    return ix->text_len
+         + (size_t)ix->words * (sizeof(uint32_t) + sizeof(WordRecord *))
+         + (size_t)ix->n * sizeof(uint32_t);
+}
@@ -0,0 +1,67 @@
+/* suffix.h - Generalised suffix array for substring search over all words */
+#ifndef SUFFIX_H
+#define SUFFIX_H
+
+#include <stddef.h>   /* size_t */
+#include <stdint.h>
+#include "dictionary.h"
+#include "avl.h"
+
+/* A suffix is packed as (word id << SUFFIX_OFFSET_BITS) | offset in word */
+#define SUFFIX_OFFSET_BITS  6                         /* MAX_WORD_LEN == 64 */
+#define SUFFIX_OFFSET_MASK  ((1u << SUFFIX_OFFSET_BITS) - 1)
+
+/*
+ * SuffixIndex - every non-empty suffix of every word, sorted, so the
+ * words containing s are the owners of one contiguous run of suffixes
+ * that start with s: two binary searches find it, and only that run is
+ * read — no pass over the dictionary.
+ *
+ *   text[]   each word and its NUL, back to back in word-id order; a
+ *            suffix's string ends at its own word's NUL
+ *   start[]  word id -> offset of the word in text
+ *   recs[]   word id -> record (ids follow sorted word order)
+ *   sa[]     the suffixes in sorted order, 4 bytes each
+ *
+ * Like the Eytzinger index the suffix array is frozen: it borrows the
+ * records, so any insert or delete in the source dictionary makes it
+ * stale — free it (or rebuild) before the next query.  Scores are read
+ * through the records, so picks and frequency updates need nothing.
+ */
+typedef struct SuffixIndex {
+    char         *text;
+    uint32_t     *start;
+    WordRecord  **recs;
+    uint32_t     *sa;
+    int           words;    /* records indexed                    */
+    int           n;        /* suffixes in sa                     */
+    size_t        text_len; /* bytes of text, NULs included       */
+} SuffixIndex;
+
+/* Static initialiser for an empty index. */
+#define SUFFIX_INDEX_INIT  { NULL, NULL, NULL, NULL, 0, 0, 0 }
+
+/*
+ * Build ix from an inorder walk of the AVL tree; any previous contents
+ * are freed.  O(L log L) for L characters in all.  Returns 0 on success,
+ * -1 on malloc failure (ix is left empty).
+ */
+int suffix_build(SuffixIndex *ix, AVLNode *avl_root);
+
+/* Free the arrays; ix is left empty and reusable. */
+void suffix_free(SuffixIndex *ix);
+
+/*
+ * Top-k words containing sub (case-insensitive), ranked like
+ * autocomplete: higher composite score first, equal scores
+ * alphabetically.  Each word counts once however often sub occurs in
+ * it.  Copies them into results and returns how many (0 for an empty
+ * sub or index).
+ */
+int suffix_search(const SuffixIndex *ix, const char *sub,
+                  WordRecord *results, int top_k);
+
+/* Bytes held by the index's arrays. */
+size_t suffix_memory(const SuffixIndex *ix);
+
+#endif /* SUFFIX_H */
@@ -4,19 +4,41 @@
 #include <string.h>
 #include "tbt.h"
 #include "dictionary.h"
+#include "pool.h"
+#include "stats.h"
 #include "utils.h"
 
+/* Deepest path an AVL-balanced tree can have: 1.44 log2(n) < 64 for any
+   n that fits in memory. */
+#define TBT_MAX_DEPTH 64
+
+/* Every TBTNode (headers included) comes from this pool (see pool.h) */
+static NodePool tbt_pool = NODE_POOL_INIT(TBTNode);
+
 /* ── Static helpers ──────────────────────────────────────────── */
 
+/* Slot a link names, thread bit dropped. */
+#define LINK_SLOT(l)  ((l) & ~TBT_THREAD)
+
+/* The node a link names (child or thread target), or NULL for slot 0. */
+static TBTNode *node_at(uint32_t link) {
+    return (TBTNode *)pool_node(&tbt_pool, LINK_SLOT(link));
+}
+
+static int is_thread(uint32_t link) { return (link & TBT_THREAD) != 0; }
+
+/* The header's own slot: its right link is a thread to itself. */
+static uint32_t header_slot(const TBTNode *header) { return LINK_SLOT(header->right); }
+
 /*
- * Iterative free — walks inorder via thread pointers, freeing each data
+ * Iterative free — walks inorder via thread links, freeing each data
  * node before advancing to its successor.  Safe on trees of any depth
  * (a recursive approach would stack-overflow at ~90 000 nodes on Windows).
  *
  * We capture the successor BEFORE freeing the current node so we never
- * dereference a freed pointer.  Left-thread pointers of later nodes may
- * dangle after their target is freed, but tbt_inorder_successor never
- * follows left threads, so those are never accessed.
+ * read a freed node.  Left threads of later nodes may name freed slots
+ * after this, but tbt_inorder_successor never follows left threads, so
+ * those are never read.
  */
 static void tbt_free_nodes(TBTNode *root, TBTNode *header) {
     TBTNode *cur, *next;
@@ -24,127 +46,334 @@ static void tbt_free_nodes(TBTNode *root, TBTNode *header) {
 
     /* Walk to the leftmost (smallest) real node */
     cur = root;
-    while (!cur->lthread) cur = cur->left;
+    while (!is_thread(cur->left)) cur = node_at(cur->left);
 
     /* Visit every node in inorder sequence until we reach the header */
     while (cur != header) {
-        next = tbt_inorder_successor(cur); /* get successor BEFORE free */
-        free(cur);
+        next = tbt_inorder_successor(cur); /* get successor BEFORE release */
+        pool_release(&tbt_pool, cur);
         cur = next;
     }
 }
 
+/* ── AVL balancing on threaded links ── */
+
+/* Height of the real subtree behind a link (a thread counts as empty). */
+static int link_height(uint32_t l) { return is_thread(l) ? 0 : node_at(l)->height; }
+static int link_size(uint32_t l)   { return is_thread(l) ? 0 : node_at(l)->size;   }
+
+/* Recompute height and size from the real children. */
+static void update_height(TBTNode *n) {
+    int l = link_height(n->left), r = link_height(n->right);
+    n->height = 1 + (l > r ? l : r);
+    n->size   = 1 + link_size(n->left) + link_size(n->right);
+}
+
+static int balance_factor(const TBTNode *n) {
+    return link_height(n->left) - link_height(n->right);
+}
+
+/*
+ * Rotations move one real link between x and y, and take and return
+ * subtree roots as slots (the form a real link holds).  The only subtle
+ * case is an empty middle subtree: the link that used to hold it must
+ * become a thread to the partner node, which is exactly its new inorder
+ * neighbour.  No other thread in the tree changes, because the inorder
+ * order does not.
+ */
+static uint32_t rotate_right(uint32_t ys) {
+    TBTNode *y  = node_at(ys);
+    uint32_t xs = y->left;
+    TBTNode *x  = node_at(xs);
+    STATS_INC(STAT_ROTATIONS);
+    if (is_thread(x->right))       /* x had no right subtree */
+        y->left = xs | TBT_THREAD; /* thread: y's predecessor is x */
+    else
+        y->left = x->right;
+    x->right = ys;
+    update_height(y);   /* y is now lower — update first */
+    update_height(x);
+    return xs;
+}
+
+static uint32_t rotate_left(uint32_t xs) {
+    TBTNode *x  = node_at(xs);
+    uint32_t ys = x->right;
+    TBTNode *y  = node_at(ys);
+    STATS_INC(STAT_ROTATIONS);
+    if (is_thread(y->left))        /* y had no left subtree */
+        x->right = ys | TBT_THREAD; /* thread: x's successor is y */
+    else
+        x->right = y->left;
+    y->left = xs;
+    update_height(x);   /* x is now lower — update first */
+    update_height(y);
+    return ys;
+}
+
+static uint32_t rebalance(uint32_t slot) {
+    TBTNode *n = node_at(slot);
+    int      bf;
+    update_height(n);
+    bf = balance_factor(n);
+
+    if (bf > 1) {
+        if (balance_factor(node_at(n->left)) < 0)   /* LR */
+            n->left = rotate_left(n->left);
+        return rotate_right(slot);                  /* LL */
+    }
+    if (bf < -1) {
+        if (balance_factor(node_at(n->right)) > 0)  /* RL */
+            n->right = rotate_right(n->right);
+        return rotate_left(slot);                   /* RR */
+    }
+    return slot;
+}
+
+/*
+ * Rebalance path[depth-1] .. path[0] (slots) bottom-up after an insert or
+ * delete below them, re-hanging each rotated subtree on its parent.
+ * dirs[i] is 1 if path[i+1] (or the changed spot) is path[i]'s left
+ * child; the root hangs off header->left.
+ */
+static void tbt_fix_path(TBTNode *header, const uint32_t *path, const int *dirs,
+                         int depth) {
+    TBTNode *par;
+    uint32_t r;
+    int      i;
+
+    for (i = depth - 1; i >= 0; i--) {
+        r = rebalance(path[i]);
+        if (r == path[i]) continue;
+        par = i > 0 ? node_at(path[i - 1]) : header;
+        if (i == 0 || dirs[i - 1]) par->left  = r;   /* real link already */
+        else                       par->right = r;
+    }
+}
+
+/*
+ * Midpoint build of recs[lo..hi], creating nodes in inorder so that
+ * *prev is always the slot of the node just before the next one made.
+ * A fresh node threads left to *prev and right (for now) to the header
+ * (slot hs); *prev's provisional right thread is pointed at the new
+ * node, and is replaced by a real link if *prev later turns out to have
+ * a right subtree.  Returns the subtree's slot, 0 if empty.
+ */
+static uint32_t tbt_build_range(uint32_t hs, WordRecord **recs,
+                                int lo, int hi, uint32_t *prev) {
+    TBTNode *n;
+    uint32_t l, ns, r;
+    int      mid;
+
+    if (lo > hi) return 0;
+    mid = lo + (hi - lo) / 2;
+
+    l  = tbt_build_range(hs, recs, lo, mid - 1, prev);
+    n  = tbt_new_node(recs[mid]);
+    ns = pool_slot(&tbt_pool, n);
+    n->left = l ? l : *prev | TBT_THREAD;          /* header for the first */
+    if (*prev != hs) node_at(*prev)->right = ns | TBT_THREAD;  /* still a thread here */
+    n->right = hs | TBT_THREAD;
+    *prev    = ns;
+
+    r = tbt_build_range(hs, recs, mid + 1, hi, prev);
+    if (r) n->right = r;
+    update_height(n);
+    return ns;
+}
+
+/* Count every real node under n, n itself at depth d: thread links are
+   not children.  AVL-balanced, so the recursion stays shallow. */
+static void tbt_shape_impl(const TBTNode *n, int d, TreeShape *s) {
+    for (;;) {
+        shape_add(s, d, d);
+        if (!is_thread(n->left)) tbt_shape_impl(node_at(n->left), d + 1, s);
+        if (is_thread(n->right)) return;
+        n = node_at(n->right);
+        d++;
+    }
+}
+
 /* ── Public API ──────────────────────────────────────────────── */
 
 TBTNode *tbt_create_header(void) {
-    TBTNode *h = (TBTNode *)malloc(sizeof(TBTNode));
+    TBTNode *h = (TBTNode *)pool_alloc(&tbt_pool);
+    uint32_t hs;
     if (!h) { perror("tbt_create_header: malloc"); exit(EXIT_FAILURE); }
-    word_record_init(&h->data);
-    h->left    = h;   /* self-referential when empty */
-    h->right   = h;   /* always points back to header (end sentinel) */
-    h->lthread = 1;   /* treat left as thread when tree is empty */
-    h->rthread = 1;   /* right is always a thread */
+    hs         = pool_slot(&tbt_pool, h);
+    h->rec     = NULL;  /* sentinel carries no record */
+    h->left    = hs | TBT_THREAD;  /* self-referential thread when empty */
+    h->right   = hs | TBT_THREAD;  /* always threads back to the header (end sentinel) */
+    h->height  = 0;   /* unused on the sentinel */
+    h->size    = 0;
     return h;
 }
 
-TBTNode *tbt_new_node(const WordRecord *rec) {
-    TBTNode *n = (TBTNode *)malloc(sizeof(TBTNode));
+TBTNode *tbt_new_node(WordRecord *rec) {
+    TBTNode *n = (TBTNode *)pool_alloc(&tbt_pool);
     if (!n) { perror("tbt_new_node: malloc"); exit(EXIT_FAILURE); }
-    n->data    = *rec;
-    n->left    = NULL;
-    n->right   = NULL;
-    n->lthread = 1;   /* threads will be wired on insertion */
-    n->rthread = 1;
+    n->rec     = rec;
+    n->left    = TBT_THREAD;   /* threads will be wired on insertion */
+    n->right   = TBT_THREAD;
+    n->height  = 1;
+    n->size    = 1;
     return n;
 }
 
-void tbt_insert(TBTNode *header, const WordRecord *rec) {
-    char buf[MAX_WORD_LEN];
-    WordRecord r;
+void tbt_insert(TBTNode *header, WordRecord *rec) {
+    uint32_t path[TBT_MAX_DEPTH];
+    int      dirs[TBT_MAX_DEPTH];
     TBTNode *parent, *cur, *n;
-    int went_left, cmp;
+    uint32_t parent_s, cur_s, ns;
+    int went_left, cmp, depth = 0;
 
-    r = *rec;
-    str_tolower(buf, rec->word, sizeof(buf));
-    str_safe_copy(r.word, buf, sizeof(r.word));
+    if (!header || !rec) return;
 
     /* Navigate to insertion point (BST-style, respecting thread flags) */
     parent    = header;
+    parent_s  = header_slot(header);
     went_left = 1;                              /* first step goes left from header */
-    cur       = header->lthread ? NULL : header->left;  /* tree root, or NULL if empty */
+    cur_s     = is_thread(header->left) ? 0 : header->left;  /* tree root, or 0 if empty */
 
-    while (cur) {
-        cmp = strcmp(r.word, cur->data.word);
+    while (cur_s) {
+        cur = node_at(cur_s);
+        STATS_VISIT();
+        cmp = str_key_cmp(rec->word, cur->rec->word);
         if (cmp == 0) return;                   /* duplicate — silently skip */
-        parent = cur;
-        if (cmp < 0) {
-            went_left = 1;
-            cur = cur->lthread ? NULL : cur->left;
-        } else {
-            went_left = 0;
-            cur = cur->rthread ? NULL : cur->right;
-        }
+        parent    = cur;
+        parent_s  = cur_s;
+        went_left = cmp < 0;
+        path[depth]   = cur_s;
+        dirs[depth++] = went_left;
+        if (went_left) cur_s = is_thread(cur->left)  ? 0 : cur->left;
+        else           cur_s = is_thread(cur->right) ? 0 : cur->right;
     }
 
-    n = tbt_new_node(&r);
+    n  = tbt_new_node(rec);
+    ns = pool_slot(&tbt_pool, n);
 
     if (went_left) {
         /* Insert as left child of parent.
            New node's inorder predecessor = parent's current left-thread target.
            New node's inorder successor   = parent itself. */
-        n->left    = parent->left;     /* inherit parent's left-thread target */
-        n->lthread = parent->lthread;  /* thread or real — copied as-is */
-        n->right   = parent;           /* right thread -> parent (successor) */
-        n->rthread = 1;
-        parent->left    = n;
-        parent->lthread = 0;           /* parent's left is now a real link */
+        n->left      = parent->left;           /* thread or real — copied as-is */
+        n->right     = parent_s | TBT_THREAD;  /* right thread -> parent (successor) */
+        parent->left = ns;                     /* parent's left is now a real link */
     } else {
         /* Insert as right child of parent.
            New node's inorder successor   = parent's current right-thread target.
            New node's inorder predecessor = parent itself. */
-        n->right   = parent->right;    /* inherit parent's right-thread target */
-        n->rthread = parent->rthread;  /* thread or real — copied as-is */
-        n->left    = parent;           /* left thread -> parent (predecessor) */
-        n->lthread = 1;
-        parent->right   = n;
-        parent->rthread = 0;           /* parent's right is now a real link */
+        n->right      = parent->right;         /* thread or real — copied as-is */
+        n->left       = parent_s | TBT_THREAD; /* left thread -> parent (predecessor) */
+        parent->right = ns;                    /* parent's right is now a real link */
     }
+
+    tbt_fix_path(header, path, dirs, depth);
+}
+
+void tbt_build_from_sorted(TBTNode *header, WordRecord **recs, int n) {
+    uint32_t prev;
+    int      i;
+
+    if (!header || !recs || n <= 0) return;
+    if (!is_thread(header->left)) {
+        for (i = 0; i < n; i++) tbt_insert(header, recs[i]);
+        return;
+    }
+    prev         = header_slot(header);
+    header->left = tbt_build_range(prev, recs, 0, n - 1, &prev);
 }
 
 TBTNode *tbt_search(TBTNode *header, const char *word) {
-    char buf[MAX_WORD_LEN];
+    DictKey key;
+    dict_key_init(&key, word);
+    return tbt_search_normalized(header, &key);
+}
+
+TBTNode *tbt_search_normalized(TBTNode *header, const DictKey *key) {
     TBTNode *cur;
     int cmp;
 
-    str_tolower(buf, word, sizeof(buf));
+    if (!header || !key) return NULL;
 
-    cur = header->lthread ? NULL : header->left;
+    cur = is_thread(header->left) ? NULL : node_at(header->left);
     while (cur) {
-        cmp = strcmp(buf, cur->data.word);
+        STATS_VISIT();
+        cmp = str_key_cmp(key->text, cur->rec->word);
         if (cmp == 0) return cur;
-        if (cmp < 0) cur = cur->lthread ? NULL : cur->left;
-        else         cur = cur->rthread ? NULL : cur->right;
+        if (cmp < 0) cur = is_thread(cur->left)  ? NULL : node_at(cur->left);
+        else         cur = is_thread(cur->right) ? NULL : node_at(cur->right);
     }
     return NULL;
 }
 
 TBTNode *tbt_inorder_successor(TBTNode *node) {
-    /* If right is a thread, it already points directly to the inorder successor */
-    if (node->rthread) return node->right;
+    /* If right is a thread, it already names the inorder successor */
+    if (is_thread(node->right)) return node_at(node->right);
 
     /* Otherwise go right once, then find the leftmost node in that subtree */
-    node = node->right;
-    while (!node->lthread) node = node->left;
+    node = node_at(node->right);
+    while (!is_thread(node->left)) node = node_at(node->left);
     return node;
 }
 
+TBTNode *tbt_inorder_predecessor(TBTNode *node) {
+    /* Mirror of the successor: a left thread is the answer already */
+    if (is_thread(node->left)) return node_at(node->left);
+    node = node_at(node->left);
+    while (!is_thread(node->right)) node = node_at(node->right);
+    return node;
+}
+
+TBTNode *tbt_lower_bound(TBTNode *header, const char *word) {
+    DictKey key;
+    dict_key_init(&key, word);
+    return tbt_lower_bound_normalized(header, &key);
+}
+
+TBTNode *tbt_lower_bound_normalized(TBTNode *header, const DictKey *key) {
+    TBTNode *best = NULL, *cur;
+
+    if (!header || is_thread(header->left)) return NULL;
+    /* On word >= key, remember it and look for an earlier one on the
+       left; otherwise the answer can only be on the right */
+    cur = node_at(header->left);
+    while (cur) {
+        STATS_VISIT();
+        if (str_key_cmp(cur->rec->word, key->text) >= 0) {
+            best = cur;
+            cur  = is_thread(cur->left)  ? NULL : node_at(cur->left);
+        } else {
+            cur  = is_thread(cur->right) ? NULL : node_at(cur->right);
+        }
+    }
+    return best;
+}
+
+int tbt_range(TBTNode *header, const char *lo, const char *hi, int limit,
+              void (*callback)(TBTNode *, void *), void *arg) {
+    DictKey  end;
+    TBTNode *cur;
+    int      visited = 0;
+
+    if (!header || is_thread(header->left)) return 0;
+    if (hi) dict_key_init(&end, hi);
+    cur = tbt_lower_bound(header, lo ? lo : "");
+    for (; cur && cur != header && visited != limit; cur = tbt_inorder_successor(cur)) {
+        if (hi && str_key_cmp(cur->rec->word, end.text) >= 0) break;
+        callback(cur, arg);
+        visited++;
+    }
+    return visited;
+}
+
 void tbt_inorder(TBTNode *header, void (*callback)(TBTNode *, void *), void *arg) {
     TBTNode *cur;
-    if (!header || header->lthread) return;  /* NULL header or empty tree */
+    if (!header || is_thread(header->left)) return;  /* NULL header or empty tree */
 
     /* Find the leftmost (smallest) real data node */
-    cur = header->left;
-    while (!cur->lthread) cur = cur->left;
+    cur = node_at(header->left);
+    while (!is_thread(cur->left)) cur = node_at(cur->left);
 
     /* Visit each node until we loop back to the header sentinel */
     while (cur != header) {
@@ -153,76 +382,143 @@ void tbt_inorder(TBTNode *header, void (*callback)(TBTNode *, void *), void *arg
     }
 }
 
+/*
+ * In-place threaded delete, O(log n).  Only the threads that named the
+ * removed node are repaired, then the path is rebalanced:
+ *   leaf       — the parent's link becomes a thread again (to the node's
+ *                predecessor if it was a left child, successor if right)
+ *   one child  — the child is spliced into the parent, and the one thread
+ *                that named the node (the subtree's extreme node) is
+ *                redirected past it
+ *   two children — the inorder successor's record moves up into the node
+ *                (records are shared, so nothing is copied) and the
+ *                successor, which has no left child, is removed instead
+ */
 void tbt_delete(TBTNode *header, const char *word) {
-    char       buf[MAX_WORD_LEN];
-    WordRecord *arr;
-    int         n, idx, i;
-    TBTNode    *cur;
-
+    char     buf[MAX_WORD_LEN];
+    uint32_t path[TBT_MAX_DEPTH];
+    int      dirs[TBT_MAX_DEPTH];
+    TBTNode *par, *cur = NULL, *t;
+    uint32_t cur_s, t_s, child;
+    int      is_left, cmp, depth = 0;
+
+    if (!header || !word) return;
     str_tolower(buf, word, sizeof(buf));
 
-    n = tbt_count(header);
-    if (n == 0) return;
-
-    /* Collect all records except the target into a temporary array */
-    arr = (WordRecord *)malloc((size_t)n * sizeof(WordRecord));
-    if (!arr) { perror("tbt_delete: malloc"); return; }
-
-    idx = 0;
-    if (!header->lthread) {
-        cur = header->left;
-        while (!cur->lthread) cur = cur->left;   /* walk to leftmost node */
-
-        while (cur != header) {
-            if (strcmp(cur->data.word, buf) != 0)
-                arr[idx++] = cur->data;
-            cur = tbt_inorder_successor(cur);
+    /* Find the node and its parent (the header is the root's parent) */
+    par     = header;
+    is_left = 1;
+    cur_s   = is_thread(header->left) ? 0 : header->left;
+    while (cur_s) {
+        cur = node_at(cur_s);
+        STATS_VISIT();
+        cmp = str_key_cmp(buf, cur->rec->word);
+        if (cmp == 0) break;
+        par     = cur;
+        is_left = cmp < 0;
+        path[depth]   = cur_s;
+        dirs[depth++] = is_left;
+        if (is_left) cur_s = is_thread(cur->left)  ? 0 : cur->left;
+        else         cur_s = is_thread(cur->right) ? 0 : cur->right;
+    }
+    if (!cur_s) return;   /* not found — nothing changed */
+
+    /* Two children: hand the job to the inorder successor */
+    if (!is_thread(cur->left) && !is_thread(cur->right)) {
+        par     = cur;
+        is_left = 0;
+        path[depth]   = cur_s;
+        dirs[depth++] = 0;
+        t_s = cur->right;
+        t   = node_at(t_s);
+        while (!is_thread(t->left)) {
+            par     = t;
+            is_left = 1;
+            path[depth]   = t_s;
+            dirs[depth++] = 1;
+            t_s = t->left;
+            t   = node_at(t_s);
         }
+        cur->rec = t->rec;
+        cur      = t;
     }
 
-    /* Word not found — nothing changed */
-    if (idx == n) { free(arr); return; }
-
-    /* Free all data nodes iteratively */
-    if (!header->lthread)
-        tbt_free_nodes(header->left, header);
-
-    /* Reset header to empty-tree state */
-    header->left    = header;
-    header->lthread = 1;
-    /* header->right and header->rthread stay as end-sentinel (unchanged) */
-
-    /* Re-insert all collected records */
-    for (i = 0; i < idx; i++)
-        tbt_insert(header, &arr[i]);
+    if (is_thread(cur->left) && is_thread(cur->right)) {
+        /* Leaf: the parent's link turns back into a thread */
+        if (is_left) par->left  = cur->left;
+        else         par->right = cur->right;
+    } else {
+        /* One child: splice it in, then fix the thread that named cur */
+        if (!is_thread(cur->left)) {
+            child = cur->left;
+            t = node_at(child);
+            while (!is_thread(t->right)) t = node_at(t->right);  /* cur's predecessor */
+            t->right = cur->right;
+        } else {
+            child = cur->right;
+            t = node_at(child);
+            while (!is_thread(t->left)) t = node_at(t->left);    /* cur's successor   */
+            t->left = cur->left;
+        }
+        if (is_left) par->left  = child;
+        else         par->right = child;
+    }
 
-    free(arr);
+    pool_release(&tbt_pool, cur);
+    tbt_fix_path(header, path, dirs, depth);
 }
 
 void tbt_free(TBTNode **header) {
     if (!header || !*header) return;
 
     /* Free all data nodes iteratively */
-    if (!(*header)->lthread)
-        tbt_free_nodes((*header)->left, *header);
+    if (!is_thread((*header)->left))
+        tbt_free_nodes(node_at((*header)->left), *header);
 
     /* Free the header sentinel */
-    free(*header);
+    pool_release(&tbt_pool, *header);
     *header = NULL;
 }
 
+void tbt_clear(TBTNode *header) {
+    if (!header) return;
+    if (!is_thread(header->left))
+        tbt_free_nodes(node_at(header->left), header);
+    header->left = header_slot(header) | TBT_THREAD;
+    header->size = 0;
+}
+
+void tbt_pool_reset(void) {
+    pool_reset(&tbt_pool);
+}
+
+void tbt_pool_destroy(void) {
+    pool_destroy(&tbt_pool);
+}
+
 int tbt_count(TBTNode *header) {
-    int      count = 0;
-    TBTNode *cur;
+    if (!header || is_thread(header->left)) return 0;
+    return node_at(header->left)->size;
+}
 
-    if (!header || header->lthread) return 0;
+int tbt_height(TBTNode *header) {
+    if (!header || is_thread(header->left)) return 0;
+    return node_at(header->left)->height;
+}
 
-    cur = header->left;
-    while (!cur->lthread) cur = cur->left;  /* leftmost node */
+void tbt_shape(TBTNode *header, TreeShape *s) {
+    if (!header || is_thread(header->left)) return;
+    tbt_shape_impl(node_at(header->left), 1, s);
+}
 
-    while (cur != header) {
-        count++;
-        cur = tbt_inorder_successor(cur);
-    }
-    return count;
+void tbt_memory(TBTNode *header, MemUsage *u) {
+    MemUsage pool;
+    size_t   n = (size_t)tbt_count(header);
+
+    mem_usage_clear(&pool);
+    pool_memory(&tbt_pool, &pool);
+    u->node_bytes     += (n + (header != NULL)) * sizeof(TBTNode);
+    u->overhead_bytes += pool.overhead_bytes;
+    u->index_bytes    += pool.index_bytes;
+    u->entries        += n;
 }
@@ -2,7 +2,10 @@
 #ifndef TBT_H
 #define TBT_H
 
+#include <stdint.h>
 #include "dictionary.h"
+#include "memusage.h"
+#include "shape.h"
 
 /*
  * TBTNode - a node in the Right-Threaded Binary Tree (RTBT).
@@ -18,21 +21,35 @@
  *   rthread = 0  =>  right points to a real right child
  *   rthread = 1  =>  right points to the inorder successor (thread)
  *
- * int flags (not bitfields): avoids undefined behaviour from bitfield
- * sign/size ambiguity in C99 on MinGW.
+ * Compact links: left and right hold the target's 32-bit slot in the
+ * TBT node pool (pool.h) rather than a pointer, with the thread flag in
+ * the top bit (TBT_THREAD) — masks, not bitfields, which avoids the
+ * bitfield sign/size ambiguity of C99 on MinGW.  A node is 24 bytes
+ * instead of 40.  Slot 0 is no node (a fresh node's unwired threads).
  *
  * Header node pattern (Knuth):
  *   A special sentinel header node is used whose left pointer points to
  *   the tree root (lthread=0). Traversal starts by going to the leftmost
  *   real node. This eliminates all NULL checks during traversal and
  *   simplifies insertion into an empty tree.
+ *
+ * AVL balancing: every data node stores the height of its real subtree
+ * (threads count as empty), and insert/delete rebalance the search path
+ * with rotations that keep the thread invariants.  Search, insert and
+ * delete are therefore O(log n) whatever the load order — sorted input
+ * no longer degrades the TBT into a list.  Each node also keeps its
+ * subtree size, maintained alongside the height, so tbt_count is O(1).
  */
+#define TBT_THREAD  0x80000000u   /* link bit: a thread, not a child */
+
 typedef struct TBTNode {
-    WordRecord       data;     /* embedded record payload              */
-    struct TBTNode  *left;     /* left child or inorder predecessor    */
-    struct TBTNode  *right;    /* right child or inorder successor     */
-    int              lthread;  /* 0 = real child, 1 = thread           */
-    int              rthread;  /* 0 = real child, 1 = thread           */
+    WordRecord *rec;      /* shared record (NULL for the header)         */
+    uint32_t    left;     /* slot of left child, or | TBT_THREAD: of the
+                             inorder predecessor (lthread)               */
+    uint32_t    right;    /* slot of right child, or | TBT_THREAD: of the
+                             inorder successor (rthread)                 */
+    int         height;   /* AVL height of real subtree (leaf=1)         */
+    int         size;     /* nodes in real subtree (leaf=1)              */
 } TBTNode;
 
 /*
@@ -43,15 +60,27 @@ typedef struct TBTNode {
 TBTNode *tbt_create_header(void);
 
 /* Allocate a new TBT data node (both thread flags = 1, both pointers = NULL initially). */
-TBTNode *tbt_new_node(const WordRecord *rec);
+TBTNode *tbt_new_node(WordRecord *rec);
+
+/* Insert rec (referenced, not copied; word already lowercase) into the TBT
+   whose header is 'header', rebalancing as needed. O(log n). */
+void tbt_insert(TBTNode *header, WordRecord *rec);
 
-/* Insert rec into the TBT whose header is 'header'. Updates header->left if tree was empty. */
-void tbt_insert(TBTNode *header, const WordRecord *rec);
+/*
+ * Hang a perfectly balanced tree over recs[0..n) (sorted by word, no
+ * duplicates) off an empty header, with every thread wired, in O(n).
+ * If the tree is not empty the records are inserted one by one instead.
+ */
+void tbt_build_from_sorted(TBTNode *header, WordRecord **recs, int n);
 
 /* Search for word. Returns pointer to matching node, or NULL. */
 TBTNode *tbt_search(TBTNode *header, const char *word);
 
-/* Delete word using simplified rebuild approach. */
+/* Search for an already-normalised key (no lowercasing per call). */
+TBTNode *tbt_search_normalized(TBTNode *header, const DictKey *key);
+
+/* Delete word in place, repairing the threads around it and rebalancing
+   the path. O(log n). */
 void tbt_delete(TBTNode *header, const char *word);
 
 /*
@@ -63,10 +92,57 @@ void tbt_inorder(TBTNode *header, void (*callback)(TBTNode *, void *), void *arg
 /* Return the inorder successor of node. Used by traversal and autocomplete. */
 TBTNode *tbt_inorder_successor(TBTNode *node);
 
-/* Free all nodes including the header. Sets *header to NULL. */
+/* Return the inorder predecessor of node: its left thread, or the
+   rightmost node of its left subtree.  The header precedes the first
+   word, and the header's predecessor is the last word. */
+TBTNode *tbt_inorder_predecessor(TBTNode *node);
+
+/*
+ * First node whose word >= word (case-insensitive), or NULL if every
+ * word sorts before it.  One O(log n) descent; walk on either way with
+ * tbt_inorder_successor / tbt_inorder_predecessor (the header marks both
+ * ends), so a window of k words around any word costs O(log n + k).
+ */
+TBTNode *tbt_lower_bound(TBTNode *header, const char *word);
+
+/* Same as tbt_lower_bound for a key already normalised with dict_key_init. */
+TBTNode *tbt_lower_bound_normalized(TBTNode *header, const DictKey *key);
+
+/*
+ * Call callback(node, arg) for each word w with lo <= w < hi in sorted
+ * order (case-insensitive; lo NULL: from the first word, hi NULL: to the
+ * last), stopping after limit words if limit >= 0.  Returns the number
+ * visited.  O(log n + visited), with no stack.
+ */
+int tbt_range(TBTNode *header, const char *lo, const char *hi, int limit,
+              void (*callback)(TBTNode *, void *), void *arg);
+
+/* Free all nodes including the header. Sets *header to NULL.
+   Nodes go back to the TBT node pool, not to the C library. */
 void tbt_free(TBTNode **header);
 
-/* Return count of real data nodes (excludes header). */
+/* Free every data node, leaving header as an empty tree (as from
+   tbt_create_header) for a rebuild. */
+void tbt_clear(TBTNode *header);
+
+/* Drop every node (headers included) of every TBT at once in O(slabs),
+   keeping the slabs for reuse. All TBTNode pointers become invalid. */
+void tbt_pool_reset(void);
+
+/* Like tbt_pool_reset, but also returns the slab memory (use at exit). */
+void tbt_pool_destroy(void);
+
+/* Return count of real data nodes (excludes header). O(1). */
 int tbt_count(TBTNode *header);
 
+/* Return height of the tree (0 for an empty tree). O(1). */
+int tbt_height(TBTNode *header);
+
+/* Add every node's depth to s (shape.h).  O(n). */
+void tbt_shape(TBTNode *header, TreeShape *s);
+
+/* Add the tree to u (memusage.h): its nodes and header, plus the spare
+   slots and slab table of the pool every TBT shares (normally one). */
+void tbt_memory(TBTNode *header, MemUsage *u);
+
 #endif /* TBT_H */
@@ -0,0 +1,493 @@
+/* trie.c - Compressed radix trie (Patricia) implementation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trie.h"
+
+/* ── Private helpers ─────────────────────────────────────────── */
+
+static TrieNode *trie_new_node(Trie *t, const char *label, int len,
+                               WordRecord *rec) {
+    TrieNode *n = (TrieNode *)pool_alloc(&t->nodes);
+    if (!n) {
+        fprintf(stderr, "trie_new_node: malloc failed\n");
+        return NULL;
+    }
+    n->label     = label;
+    n->label_len = len;
+    n->rec       = rec;
+    n->child     = NULL;
+    n->sibling   = NULL;
+    n->top       = NULL;
+    return n;
+}
+
+/*
+ * Return the link (child pointer or sibling pointer) where a child
+ * starting with c is, or would be inserted to keep the list sorted.
+ * The child exists iff *link && (*link)->label[0] == c.
+ * Characters compare as unsigned, matching strcmp order.
+ */
+static TrieNode **trie_child_link(TrieNode *node, unsigned char c) {
+    TrieNode **link = &node->child;
+    while (*link && (unsigned char)(*link)->label[0] < c)
+        link = &(*link)->sibling;
+    return link;
+}
+
+/* Find the child of node whose edge starts with c, or NULL. */
+static TrieNode *trie_find_child(const TrieNode *node, unsigned char c) {
+    const TrieNode *n = node->child;
+    while (n && (unsigned char)n->label[0] < c) n = n->sibling;
+    return (n && (unsigned char)n->label[0] == c) ? (TrieNode *)n : NULL;
+}
+
+/* ── Top-k cache helpers ── */
+
+/* Insert r into k if it ranks among the best TRIE_TOPK.
+   Returns 1 if it entered the list, 0 otherwise. */
+static int topk_offer(TrieTopK *k, WordRecord *r) {
+    int i = k->n;
+    if (i == TRIE_TOPK) {
+        if (!word_record_outranks(r, k->rec[TRIE_TOPK - 1])) return 0;
+        i--;                                   /* evict the current worst */
+    } else {
+        k->n++;
+    }
+    while (i > 0 && word_record_outranks(r, k->rec[i - 1])) {
+        k->rec[i] = k->rec[i - 1];
+        i--;
+    }
+    k->rec[i] = r;
+    return 1;
+}
+
+static int topk_contains(const TrieTopK *k, const WordRecord *r) {
+    int i;
+    for (i = 0; i < k->n; i++)
+        if (k->rec[i] == r) return 1;
+    return 0;
+}
+
+/* Offer the best records of n's subtree to k. */
+static void topk_offer_subtree(TrieTopK *k, const TrieNode *n) {
+    const TrieNode *c;
+    int             i;
+
+    if (n->top) {
+        /* Sorted list: once one entry is rejected, the rest would be too */
+        for (i = 0; i < n->top->n; i++)
+            if (!topk_offer(k, n->top->rec[i])) break;
+        return;
+    }
+    if (n->rec) topk_offer(k, n->rec);
+    /* Only reached below a branch whose cache allocation failed */
+    for (c = n->child; c; c = c->sibling) topk_offer_subtree(k, c);
+}
+
+/* Rebuild n's cache from its own record and its children's caches
+   (children must be up to date).  Leaves drop their cache. */
+static void topk_recompute(Trie *t, TrieNode *n) {
+    const TrieNode *c;
+
+    if (!n->child) {
+        if (n->top) pool_release(&t->tops, n->top);
+        n->top = NULL;
+        return;
+    }
+    if (!n->top) {
+        n->top = (TrieTopK *)pool_alloc(&t->tops);
+        if (!n->top) {
+            /* Autocomplete falls back to ranking the subtree itself */
+            fprintf(stderr, "trie: top-k cache malloc failed\n");
+            return;
+        }
+    }
+    n->top->n = 0;
+    if (n->rec) topk_offer(n->top, n->rec);
+    for (c = n->child; c; c = c->sibling) topk_offer_subtree(n->top, c);
+}
+
+/* rec was just added below every node of path[0..depth). */
+static void topk_after_insert(Trie *t, TrieNode **path, int depth,
+                              WordRecord *rec) {
+    TrieNode *n;
+    while (depth-- > 0) {
+        n = path[depth];
+        if (!n->child) continue;             /* leaf: its record is its list */
+        if (!n->top) topk_recompute(t, n);   /* new branch (split / first child) */
+        else         topk_offer(n->top, rec);
+    }
+}
+
+/* rec was just removed below every node of path[0..depth). */
+static void topk_after_delete(Trie *t, TrieNode **path, int depth,
+                              const WordRecord *rec) {
+    TrieNode *n;
+    while (depth-- > 0) {
+        n = path[depth];
+        /* Caches that never held rec are unaffected */
+        if (!n->child || !n->top || topk_contains(n->top, rec))
+            topk_recompute(t, n);
+    }
+}
+
+/* Record root..node for key in path; returns the node count, or 0 if
+   key is not stored. path needs MAX_WORD_LEN + 1 slots. */
+static int trie_path(Trie *t, const char *key, TrieNode **path) {
+    TrieNode *node = &t->root, *child;
+    int       klen = (int)strlen(key), pos = 0, depth = 0;
+
+    path[depth++] = node;
+    while (pos < klen) {
+        child = trie_find_child(node, (unsigned char)key[pos]);
+        if (!child || child->label_len > klen - pos ||
+            memcmp(child->label, key + pos, (size_t)child->label_len) != 0)
+            return 0;
+        pos  += child->label_len;
+        node  = child;
+        path[depth++] = node;
+    }
+    return node->rec ? depth : 0;
+}
+
+static void topk_rebuild_impl(Trie *t, TrieNode *n) {
+    TrieNode *c;
+    for (c = n->child; c; c = c->sibling) topk_rebuild_impl(t, c);
+    topk_recompute(t, n);
+}
+
+/*
+ * Fold n's only child into n: n takes the joined label, the child's
+ * record and grandchildren.  If the arena copy fails the trie is simply
+ * left uncompressed at this point — still correct.
+ */
+static void trie_merge_child(Trie *t, TrieNode *n) {
+    char        buf[MAX_WORD_LEN];
+    TrieNode   *c = n->child;
+    const char *joined;
+    int         len;
+
+    if (!c || c->sibling || n->rec) return;
+    len = n->label_len + c->label_len;
+    if (len >= MAX_WORD_LEN) return;   /* cannot happen for valid keys */
+
+    memcpy(buf,                n->label, (size_t)n->label_len);
+    memcpy(buf + n->label_len, c->label, (size_t)c->label_len);
+    joined = arena_strndup(&t->labels, buf, (size_t)len);
+    if (!joined) return;
+
+    n->label     = joined;
+    n->label_len = len;
+    n->rec       = c->rec;
+    n->child     = c->child;
+    if (n->top) pool_release(&t->tops, n->top);
+    n->top       = c->top;                 /* same subtree, same best list */
+    pool_release(&t->nodes, c);
+}
+
+/* Pre-order walk: a node's own word sorts before every longer completion. */
+static void trie_walk(TrieNode *n, void (*callback)(TrieNode *, void *), void *arg) {
+    for (; n; n = n->sibling) {
+        if (n->rec) callback(n, arg);
+        trie_walk(n->child, callback, arg);
+    }
+}
+
+static int trie_height_impl(const TrieNode *n) {
+    int best = 0, h;
+    for (n = n->child; n; n = n->sibling) {
+        h = trie_height_impl(n);
+        if (h > best) best = h;
+    }
+    return best + 1;
+}
+
+/* Count every word at or below the children of n, which sit at depth d
+   and were reached with c compares: the i-th sibling of a list costs i
+   more first-character tests. */
+static void trie_shape_impl(const TrieNode *n, int d, int c, TreeShape *s) {
+    int i = 1;
+    for (n = n->child; n; n = n->sibling, i++) {
+        if (n->rec) shape_add(s, d, c + i);
+        trie_shape_impl(n, d + 1, c + i, s);
+    }
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void trie_init(Trie *t) {
+    NodePool empty_nodes = NODE_POOL_INIT(TrieNode);
+    NodePool empty_tops  = NODE_POOL_INIT(TrieTopK);
+    if (!t) return;
+    memset(&t->root, 0, sizeof(t->root));
+    t->root.label = "";
+    t->nodes      = empty_nodes;
+    t->tops       = empty_tops;
+    arena_init(&t->labels);
+    t->count      = 0;
+}
+
+/*
+ * Iterative insert.  Follows matching edges; where the key leaves an
+ * edge part-way, the edge is split into a branch node plus the old tail.
+ */
+int trie_insert(Trie *t, WordRecord *rec) {
+    TrieNode  *node, *child, *mid, *leaf, **link;
+    TrieNode  *path[MAX_WORD_LEN + 1];
+    const char *key, *label;
+    int        klen, pos, common, depth = 0;
+
+    if (!t || !rec) return 0;
+
+    key  = rec->word;
+    klen = (int)strlen(key);
+    node = &t->root;
+    pos  = 0;
+
+    for (;;) {
+        path[depth++] = node;
+
+        if (pos == klen) {
+            if (node->rec) return 0;   /* duplicate — skip silently */
+            node->rec = rec;
+            t->count++;
+            topk_after_insert(t, path, depth, rec);
+            return 1;
+        }
+
+        link  = trie_child_link(node, (unsigned char)key[pos]);
+        child = *link;
+
+        if (!child || child->label[0] != key[pos]) {
+            /* No edge starts with this character: hang the rest as a leaf */
+            label = arena_strndup(&t->labels, key + pos, (size_t)(klen - pos));
+            if (!label) {
+                fprintf(stderr, "trie_insert: malloc failed\n");
+                return 0;
+            }
+            leaf = trie_new_node(t, label, klen - pos, rec);
+            if (!leaf) return 0;
+            leaf->sibling = child;
+            *link = leaf;
+            t->count++;
+            topk_after_insert(t, path, depth, rec);
+            return 1;
+        }
+
+        common = 1;
+        while (common < child->label_len && pos + common < klen &&
+               child->label[common] == key[pos + common])
+            common++;
+
+        if (common < child->label_len) {
+            /* Split: both halves point into the same label bytes */
+            mid = trie_new_node(t, child->label, common, NULL);
+            if (!mid) return 0;
+            mid->child       = child;
+            mid->sibling     = child->sibling;
+            child->sibling   = NULL;
+            child->label    += common;
+            child->label_len -= common;
+            *link = mid;
+            child = mid;
+        }
+
+        node = child;
+        pos += common;
+    }
+}
+
+TrieNode *trie_search(const Trie *t, const char *word) {
+    DictKey key;
+    if (!word) return NULL;
+    dict_key_init(&key, word);
+    return trie_search_normalized(t, &key);
+}
+
+TrieNode *trie_search_normalized(const Trie *t, const DictKey *key) {
+    const TrieNode *node;
+    const char     *k;
+    int             klen, pos = 0;
+    TrieNode       *child;
+
+    if (!t || !key) return NULL;
+
+    k    = key->text;
+    klen = (int)strlen(k);
+    node = &t->root;
+
+    while (pos < klen) {
+        child = trie_find_child(node, (unsigned char)k[pos]);
+        if (!child || child->label_len > klen - pos ||
+            memcmp(child->label, k + pos, (size_t)child->label_len) != 0)
+            return NULL;
+        pos += child->label_len;
+        node = child;
+    }
+    return node->rec ? (TrieNode *)node : NULL;
+}
+
+TrieNode *trie_prefix_node(const Trie *t, const char *prefix) {
+    const TrieNode *node;
+    TrieNode       *child;
+    int             plen, pos = 0, n;
+
+    if (!t || !prefix) return NULL;
+
+    plen = (int)strlen(prefix);
+    node = &t->root;
+
+    while (pos < plen) {
+        child = trie_find_child(node, (unsigned char)prefix[pos]);
+        if (!child) return NULL;
+        /* The prefix may end part-way along this edge */
+        n = child->label_len < plen - pos ? child->label_len : plen - pos;
+        if (memcmp(child->label, prefix + pos, (size_t)n) != 0) return NULL;
+        pos += n;
+        node = child;
+    }
+    return (TrieNode *)node;
+}
+
+int trie_has_prefix(const Trie *t, const char *prefix) {
+    DictKey key;
+    if (!t || !prefix || t->count == 0) return 0;
+    dict_key_init(&key, prefix);
+    return trie_prefix_node(t, key.text) != NULL;
+}
+
+void trie_delete(Trie *t, const char *word) {
+    DictKey     key;
+    TrieNode   *parent = NULL, *node, *child, **link = NULL, **cl;
+    TrieNode   *path[MAX_WORD_LEN + 1];
+    WordRecord *rec;
+    int         klen, pos = 0, depth = 0;
+
+    if (!t || !word) return;
+    dict_key_init(&key, word);
+    klen = (int)strlen(key.text);
+    node = &t->root;
+    path[depth++] = node;
+
+    while (pos < klen) {
+        cl    = trie_child_link(node, (unsigned char)key.text[pos]);
+        child = *cl;
+        if (!child || child->label[0] != key.text[pos] ||
+            child->label_len > klen - pos ||
+            memcmp(child->label, key.text + pos, (size_t)child->label_len) != 0)
+            return;   /* not present */
+        parent = node;
+        link   = cl;
+        node   = child;
+        pos   += child->label_len;
+        path[depth++] = node;
+    }
+
+    rec = node->rec;
+    if (!rec) return;
+    node->rec = NULL;
+    t->count--;
+
+    if (node != &t->root) {
+        if (!node->child) {
+            /* Leaf: unlink it, then the parent may be a one-child branch */
+            *link = node->sibling;
+            pool_release(&t->nodes, node);
+            depth--;
+            if (parent != &t->root) trie_merge_child(t, parent);
+        } else {
+            /* Branch left with a single child collapses into one edge */
+            trie_merge_child(t, node);
+        }
+    }
+    topk_after_delete(t, path, depth, rec);
+}
+
+int trie_topk(const Trie *t, const char *prefix, WordRecord **out, int k) {
+    const TrieNode *node;
+    int             i, n;
+
+    node = trie_prefix_node(t, prefix);
+    if (!node || k <= 0) return 0;
+
+    if (!node->child) {                 /* leaf: exactly one completion */
+        if (!node->rec) return 0;
+        out[0] = node->rec;
+        return 1;
+    }
+    if (k > TRIE_TOPK || !node->top) return -1;
+
+    n = node->top->n < k ? node->top->n : k;
+    for (i = 0; i < n; i++) out[i] = node->top->rec[i];
+    return n;
+}
+
+void trie_score_changed(Trie *t, WordRecord *rec) {
+    TrieNode *path[MAX_WORD_LEN + 1];
+    TrieNode *n;
+    int       depth;
+
+    if (!t || !rec) return;
+    depth = trie_path(t, rec->word, path);
+
+    /* Bottom-up, so a recompute always sees up-to-date children */
+    while (depth-- > 0) {
+        n = path[depth];
+        if (!n->child) continue;
+        if (!n->top || topk_contains(n->top, rec))
+            topk_recompute(t, n);       /* rec may have moved or dropped out */
+        else
+            topk_offer(n->top, rec);    /* rec may have climbed in */
+    }
+}
+
+void trie_topk_rebuild(Trie *t) {
+    if (!t) return;
+    topk_rebuild_impl(t, &t->root);
+}
+
+void trie_inorder(const Trie *t, void (*callback)(TrieNode *, void *), void *arg) {
+    if (!t || !callback) return;
+    trie_inorder_from((TrieNode *)&t->root, callback, arg);
+}
+
+void trie_inorder_from(TrieNode *node, void (*callback)(TrieNode *, void *), void *arg) {
+    if (!node || !callback) return;
+    if (node->rec) callback(node, arg);
+    trie_walk(node->child, callback, arg);
+}
+
+int trie_count(const Trie *t) {
+    return t ? t->count : 0;
+}
+
+int trie_height(const Trie *t) {
+    if (!t || !t->root.child) return 0;
+    return trie_height_impl(&t->root) - 1;   /* root edge is empty */
+}
+
+void trie_shape(const Trie *t, TreeShape *s) {
+    if (t) trie_shape_impl(&t->root, 1, 0, s);
+}
+
+void trie_memory(const Trie *t, MemUsage *u) {
+    MemUsage tops;
+
+    if (!t) return;
+    mem_usage_clear(&tops);
+    pool_memory(&t->tops, &tops);
+    pool_memory(&t->nodes, u);
+    arena_memory(&t->labels, u);
+    u->index_bytes    += tops.node_bytes + tops.index_bytes;   /* the caches */
+    u->overhead_bytes += tops.overhead_bytes;
+    u->entries        += (size_t)t->count;
+}
+
+void trie_free(Trie *t) {
+    if (!t) return;
+    pool_destroy(&t->nodes);    /* O(slabs) — no per-node walk */
+    pool_destroy(&t->tops);
+    arena_free(&t->labels);
+    trie_init(t);
+}
@@ -0,0 +1,138 @@
+/* trie.h - Compressed radix trie (Patricia) node and operation signatures */
+#ifndef TRIE_H
+#define TRIE_H
+
+#include "dictionary.h"
+#include "pool.h"
+#include "arena.h"
+#include "shape.h"
+
+/*
+ * TrieNode - one edge + node of the compressed radix trie.
+ *
+ * Each node is reached over an edge labelled with one or more characters
+ * (label[0..label_len)); chains of single-child nodes are collapsed into
+ * one label, so the trie has at most ~2n nodes for n words.  A node that
+ * ends a word points at its shared record (store-owned, never copied);
+ * pure branch nodes have rec == NULL.
+ *
+ * Children form a singly linked sibling list sorted by first label
+ * character, so a pre-order walk yields words in lexicographic order.
+ * Siblings never share a first character.
+ *
+ * Lookup walks one edge per distinct prefix: O(key length) character
+ * compares instead of O(log n) full string compares, and a prefix query
+ * lands directly on the subtree holding every completion.
+ *
+ * Every node with children also caches its subtree's TRIE_TOPK best
+ * records by word_record_score (ties: alphabetical), so autocomplete is
+ * "descend to the prefix node, read the list" — no subtree walk, no sort.
+ * A leaf's list is implicitly its own record, so leaves carry no cache.
+ */
+typedef struct TrieTopK {
+    WordRecord *rec[TRIE_TOPK];  /* best first                            */
+    int         n;               /* entries used (< TRIE_TOPK only when   */
+                                 /* the subtree has fewer words)          */
+} TrieTopK;
+
+typedef struct TrieNode {
+    const char      *label;      /* edge text (not NUL-terminated here)   */
+    int              label_len;  /* characters on the edge (root: 0)      */
+    WordRecord      *rec;        /* record ending here, or NULL           */
+    struct TrieNode *child;      /* first child (smallest first char)     */
+    struct TrieNode *sibling;    /* next sibling (larger first char)      */
+    TrieTopK        *top;        /* subtree's best (NULL on leaves)       */
+} TrieNode;
+
+/*
+ * Trie - the trie handle.  Unlike the pointer-rooted trees, a trie owns
+ * its own node pool and label arena, so trie_free releases everything in
+ * O(slabs + blocks) without walking the nodes.
+ *
+ * Edge labels live in the arena.  Splitting an edge only re-points the
+ * two halves into the same arena bytes; merges after a delete copy the
+ * joined label (the old text stays in the arena until trie_free).
+ *
+ * Top-k caches are kept exact by insert and delete (O(depth * K) along
+ * the key's path).  Scores live in the shared records, so anyone who
+ * changes one must tell the trie: trie_score_changed for a single
+ * record, trie_topk_rebuild after a bulk update such as load_frequencies.
+ */
+typedef struct Trie {
+    TrieNode    root;      /* empty-label root, never freed           */
+    NodePool    nodes;     /* every TrieNode except the root          */
+    NodePool    tops;      /* TrieTopK caches of branch nodes         */
+    StringArena labels;    /* edge label text                         */
+    int         count;     /* words stored                            */
+} Trie;
+
+/* Initialise an empty trie (no allocation until the first insert). */
+void trie_init(Trie *t);
+
+/*
+ * Insert rec under rec->word. The node references rec (no copy);
+ * rec->word must already be lowercase, as store_add guarantees.
+ * Returns 1 if inserted, 0 on duplicate/failure.
+ */
+int trie_insert(Trie *t, WordRecord *rec);
+
+/* Search for word. Returns the node holding it, or NULL if not found. */
+TrieNode *trie_search(const Trie *t, const char *word);
+
+/* Search for an already-normalised key (no lowercasing per call). */
+TrieNode *trie_search_normalized(const Trie *t, const DictKey *key);
+
+/*
+ * Return the highest node whose subtree holds exactly the words starting
+ * with prefix (already lowercase), or NULL if no word does.  The node's
+ * own label may run past the prefix.  An empty prefix returns the root.
+ */
+TrieNode *trie_prefix_node(const Trie *t, const char *prefix);
+
+/* Return 1 if any word starts with prefix (any case), else 0: the
+   descent of trie_prefix_node and nothing more.  O(prefix length). */
+int trie_has_prefix(const Trie *t, const char *prefix);
+
+/* Delete word. Collapses branch nodes that are left with one child. */
+void trie_delete(Trie *t, const char *word);
+
+/*
+ * Copy up to k of the best-scored words starting with prefix (already
+ * lowercase) into out, best first, straight from the prefix node's cache.
+ * Returns the number copied (0 if no word matches), or -1 when the cache
+ * cannot answer (k > TRIE_TOPK, or its allocation failed) and the caller
+ * has to rank the subtree itself.
+ */
+int trie_topk(const Trie *t, const char *prefix, WordRecord **out, int k);
+
+/* Re-rank rec (already in the trie) after its score changed. O(depth * K). */
+void trie_score_changed(Trie *t, WordRecord *rec);
+
+/* Recompute every cache, e.g. after many scores changed at once. O(n * K). */
+void trie_topk_rebuild(Trie *t);
+
+/* Sorted traversal: calls callback(node, arg) for each word node. */
+void trie_inorder(const Trie *t, void (*callback)(TrieNode *, void *), void *arg);
+
+/* Same, restricted to the subtree rooted at node (e.g. trie_prefix_node). */
+void trie_inorder_from(TrieNode *node, void (*callback)(TrieNode *, void *), void *arg);
+
+/* Return the number of words stored — O(1). */
+int trie_count(const Trie *t);
+
+/* Return the length of the longest root-to-leaf path in nodes (0 if empty). */
+int trie_height(const Trie *t);
+
+/* Add every word's depth (edges from the root) and lookup compares to s
+   (shape.h). */
+void trie_shape(const Trie *t, TreeShape *s);
+
+/* Add the trie to u (memusage.h): its nodes, edge labels as strings and
+   the branch nodes' cached top-k lists as index. */
+void trie_memory(const Trie *t, MemUsage *u);
+
+/* Free every node and label (the records stay in their store);
+   the trie is left empty and reusable. */
+void trie_free(Trie *t);
+
+#endif /* TRIE_H */
@@ -4,18 +4,110 @@
 #include "utils.h"
 #include "config.h"
 
+/* ── Fixed-width key kernels ─────────────────────────────────── */
+
+/*
+ * The kernels below work a block of bytes at a time: 16 with SSE2 (part
+ * of every x86-64 target, so no extra compiler flags), otherwise 8 in a
+ * 64-bit integer.  Both operands of a compare are whole MAX_WORD_LEN key
+ * buffers, zero-filled past the NUL, so every block load stays inside
+ * them and the first differing byte is never past either terminator.
+ */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define KEY_BLOCK  16
+#else
+#include <stdint.h>
+#define KEY_BLOCK  8
+#endif
+
+/* Index of the lowest set bit of a non-zero mask. */
+static int low_bit(unsigned int mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int i = 0;
+    while (!(mask & 1u)) { mask >>= 1; i++; }
+    return i;
+#endif
+}
+
+/*
+ * strncmp over the first n bytes (n <= MAX_WORD_LEN) of two key buffers,
+ * a block at a time, stopping after the first block that holds a's
+ * terminator.  A block straddling n is loaded whole and masked.
+ */
+static int key_blocks_cmp(const char *a, const char *b, size_t n) {
+    size_t off;
+    for (off = 0; off < n; off += KEY_BLOCK) {
+        size_t left = n - off;
+#if defined(__SSE2__)
+        __m128i va = _mm_loadu_si128((const __m128i *)(const void *)(a + off));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(const void *)(b + off));
+        unsigned int keep = left >= 16 ? 0xFFFFu : (1u << left) - 1u;
+        unsigned int diff = keep & ~(unsigned int)
+                            _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        if (diff) {
+            int i = low_bit(diff);
+            return (unsigned char)a[off + i] - (unsigned char)b[off + i];
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, _mm_setzero_si128())))
+            return 0;
+#else
+        uint64_t x, y;
+        memcpy(&x, a + off, sizeof(x));
+        memcpy(&y, b + off, sizeof(y));
+        if (x != y) {
+            size_t i = 0;
+            while (i < left && a[off + i] == b[off + i]) i++;
+            if (i == left) return 0;
+            return (unsigned char)a[off + i] - (unsigned char)b[off + i];
+        }
+        /* Equal blocks: done once one of the bytes is the terminator */
+        if ((x - 0x0101010101010101ull) & ~x & 0x8080808080808080ull)
+            return 0;
+#endif
+    }
+    return 0;
+}
+
+int str_key_cmp(const char *a, const char *b) {
+    return key_blocks_cmp(a, b, MAX_WORD_LEN);
+}
+
+int str_key_ncmp(const char *a, const char *b, size_t n) {
+    return key_blocks_cmp(a, b, n < MAX_WORD_LEN ? n : MAX_WORD_LEN);
+}
+
 /* ── Case normalisation ──────────────────────────────────────── */
 
 char *str_tolower(char *dst, const char *src, size_t dst_size) {
-    size_t i = 0;
+    const char *nul;
+    size_t      len, i = 0;
+
     if (!dst || !src || dst_size == 0) return dst;
-    for (i = 0; i < dst_size - 1 && src[i] != '\0'; i++) {
+
+    /* Copy and zero-fill first, then fold dst in whole blocks: src is
+       never read past its terminator, and zero bytes fold to zero */
+    nul = (const char *)memchr(src, '\0', dst_size - 1);
+    len = nul ? (size_t)(nul - src) : dst_size - 1;
+    memmove(dst, src, len);
+    memset(dst + len, 0, dst_size - len);
+
+#if defined(__SSE2__)
+    for (; i < len && i + 16 <= dst_size; i += 16) {
+        /* 'A'..'Z' as signed bytes: c > 'A'-1 and c < 'Z'+1 */
+        __m128i v     = _mm_loadu_si128((const __m128i *)(const void *)(dst + i));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        _mm_storeu_si128((__m128i *)(void *)(dst + i), v);
+    }
+#endif
+    for (; i < len; i++) {
         /* ASCII-only: avoids locale-dependent ctype tolower() */
-        dst[i] = (src[i] >= 'A' && src[i] <= 'Z')
-                     ? (char)(src[i] + 32)
-                     : src[i];
+        if (dst[i] >= 'A' && dst[i] <= 'Z') dst[i] = (char)(dst[i] + 32);
     }
-    dst[i] = '\0';
     return dst;
 }
 
@@ -96,7 +188,7 @@ int str_starts_with_ci(const char *str, const char *prefix) {
     if (!str || !prefix) return 0;
     str_tolower(s_buf, str,    sizeof(s_buf));
     str_tolower(p_buf, prefix, sizeof(p_buf));
-    return str_starts_with(s_buf, p_buf);
+    return str_key_ncmp(s_buf, p_buf, strlen(p_buf)) == 0;
 }
 
 int str_is_empty(const char *str) {
@@ -7,12 +7,29 @@
 
 /* ── Case normalisation ──────────────────────────────────────── */
 
-/* Convert src to lowercase (ASCII-only), write result into dst[dst_size]. Returns dst. */
+/*
+ * Convert src to lowercase (ASCII-only), write result into dst[dst_size]
+ * and zero-fill the rest of dst, so a MAX_WORD_LEN dst is a ready key
+ * for str_key_cmp.  dst may equal src.  Returns dst.
+ */
 char *str_tolower(char *dst, const char *src, size_t dst_size);
 
 /* Convert src to uppercase (ASCII-only), write result into dst[dst_size]. Returns dst. */
 char *str_toupper(char *dst, const char *src, size_t dst_size);
 
+/* ── Fixed-width key compare ─────────────────────────────────── */
+
+/*
+ * strcmp for keys: a and b must each point at a whole MAX_WORD_LEN
+ * buffer, zero-filled past its NUL — as every stored word and DictKey
+ * is.  Compares 16 bytes per step with SSE2, 8 without, and stops at the
+ * first block holding the terminator.  Same sign as strcmp.
+ */
+int str_key_cmp(const char *a, const char *b);
+
+/* strncmp for keys (see str_key_cmp); n above MAX_WORD_LEN is clamped. */
+int str_key_ncmp(const char *a, const char *b, size_t n);
+
 /* ── Whitespace trimming (in-place) ─────────────────────────── */
 
 /* Remove leading and trailing whitespace (space, tab, \r, \n) from str. Returns str. */
@@ -0,0 +1,207 @@
+/* wbst.c - BST laid out by word frequency (Mehlhorn's bisection rule) */
+#include <stdint.h>
+#include <stdlib.h>
+#include "wbst.h"
+#include "shape.h"
+#include "stats.h"
+#include "utils.h"
+
+/* ── Static helpers ──────────────────────────────────────────── */
+
+/*
+ * Build the subtree over recs[lo..hi) (in key order) whose root holds
+ * the middle of the range's weight: sum[i] is the weight of recs[0..i),
+ * and the root is the k with sum[k] <= middle < sum[k + 1].  Each side
+ * then weighs at most half the range, so the recursion is as deep as the
+ * tree it builds, log2(W / lightest) + 2 at most.  Nodes are allocated
+ * in preorder, so a search mostly runs forward through the pool's slabs.
+ * Clears *ok if an allocation fails (the subtree is then partial).
+ */
+static BSTNode *place(WordRecord **recs, const uint64_t *sum, int lo, int hi, int *ok) {
+    BSTNode *node;
+    uint64_t mid;
+    int      a = lo, b = hi - 1, m;
+
+    if (lo >= hi) return NULL;
+    mid = sum[lo] + (sum[hi] - sum[lo]) / 2;
+    while (a < b) {                       /* last k in [lo, hi) with sum[k] <= mid */
+        m = a + (b - a + 1) / 2;
+        if (sum[m] <= mid) a = m;
+        else               b = m - 1;
+    }
+    node = bst_new_node(recs[a]);
+    if (!node) {
+        *ok = 0;
+        return NULL;
+    }
+    node->left  = place(recs, sum, lo, a, ok);
+    node->right = place(recs, sum, a + 1, hi, ok);
+    node->size  = hi - lo;
+    return node;
+}
+
+/* A tree over recs[0..n), sorted, laid out by weight into new nodes.
+   Returns 0 with *root set, or -1 on malloc failure. */
+static int build(WordRecord **recs, int n, BSTNode **root) {
+    uint64_t *sum;
+    int       i, ok = 1;
+
+    sum = (uint64_t *)malloc(((size_t)n + 1) * sizeof(uint64_t));
+    if (!sum) return -1;
+    sum[0] = 0;
+    for (i = 0; i < n; i++) sum[i + 1] = sum[i] + (uint64_t)wbst_weight(recs[i]);
+    *root = place(recs, sum, 0, n, &ok);
+    free(sum);
+    if (ok) return 0;
+    bst_free(root);
+    return -1;
+}
+
+/* Lay *root out again by the current weights, into new nodes, and free
+   the old ones.  Returns 0, or -1 (unchanged) on malloc failure. */
+static int layout(BSTNode **root) {
+    WordRecord **recs;
+    BSTNode     *n, *fresh;
+    BSTIter      it;
+    int          count, i = 0, ret;
+
+    if (!*root) return 0;
+    count = bst_count(*root);
+    recs  = (WordRecord **)malloc((size_t)count * sizeof(WordRecord *));
+    if (!recs) return -1;
+    bst_iter_init(&it, *root);
+    while ((n = bst_iter_next(&it)) != NULL) recs[i++] = n->rec;
+    bst_iter_free(&it);
+    ret = build(recs, count, &fresh);
+    free(recs);
+    if (ret != 0) return -1;
+    bst_free(root);
+    *root = fresh;
+    return 0;
+}
+
+/* Count k changes; lay the tree out if enough are due. */
+static int note_changes(WBST *t, int k) {
+    t->changes += k;
+    if ((long long)t->changes * WBST_RELAYOUT_DIV < bst_count(t->root)) return 0;
+    return wbst_layout(t) == 0;
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int wbst_weight(const WordRecord *rec) {
+    return 1 + word_record_score(rec);
+}
+
+int wbst_build(WBST *t, WordRecord **recs, int n) {
+    wbst_free(t);
+    if (!recs || n <= 0) return 0;
+    return build(recs, n, &t->root);
+}
+
+int wbst_adopt(WBST *t, BSTNode **root) {
+    wbst_free(t);
+    t->root = *root;
+    *root   = NULL;
+    return wbst_layout(t);
+}
+
+int wbst_layout(WBST *t) {
+    if (layout(&t->root) != 0) return -1;
+    t->changes = 0;
+    return 0;
+}
+
+/* Two walks, like bst_insert: sizes grow only once the key is new. */
+int wbst_insert(WBST *t, WordRecord *rec) {
+    BSTNode **cur;
+    BSTNode  *node;
+    int       cmp, depth = 1;
+
+    if (!t || !rec) return 0;
+    for (cur = &t->root; *cur; depth++) {
+        STATS_VISIT();
+        cmp = str_key_cmp(rec->word, (*cur)->rec->word);
+        if (cmp == 0) return 0;          /* duplicate — skip */
+        cur = cmp < 0 ? &(*cur)->left : &(*cur)->right;
+    }
+    node = bst_new_node(rec);
+    if (!node) return 0;
+    *cur = node;
+
+    for (cur = &t->root; *cur != node; ) {
+        (*cur)->size++;
+        cur = str_key_cmp(rec->word, (*cur)->rec->word) < 0 ? &(*cur)->left
+                                                           : &(*cur)->right;
+    }
+    if (shape_too_deep(depth, (size_t)bst_count(t->root))) wbst_layout(t);
+    else                                                   note_changes(t, 1);
+    return 1;
+}
+
+/* As bst_delete, less the scapegoat checks: find, shrink the sizes along
+   the path (on to the successor if the node has two children), unlink. */
+int wbst_delete(WBST *t, const char *word) {
+    char      lw[MAX_WORD_LEN];
+    BSTNode **cur, **link;
+    BSTNode  *node, *gone;
+    int       cmp;
+
+    if (!t || !word) return 0;
+    str_tolower(lw, word, sizeof(lw));
+    for (cur = &t->root; *cur; ) {
+        STATS_VISIT();
+        cmp = str_key_cmp(lw, (*cur)->rec->word);
+        if (cmp == 0) break;
+        cur = cmp < 0 ? &(*cur)->left : &(*cur)->right;
+    }
+    if (!*cur) return 0;
+    node = *cur;
+
+    for (link = &t->root; *link != node; ) {
+        (*link)->size--;
+        link = str_key_cmp(lw, (*link)->rec->word) < 0 ? &(*link)->left
+                                                       : &(*link)->right;
+    }
+    if (node->left && node->right) {
+        node->size--;
+        for (link = &node->right; (*link)->left; link = &(*link)->left)
+            (*link)->size--;
+        gone      = *link;
+        node->rec = gone->rec;            /* take over the record */
+        *link     = gone->right;
+    } else {
+        gone = node;
+        *cur = node->left ? node->left : node->right;
+    }
+    bst_release_node(gone);
+    note_changes(t, 1);
+    return 1;
+}
+
+int wbst_reweigh(WBST *t, int k) {
+    if (!t || k <= 0) return 0;
+    return note_changes(t, k);
+}
+
+/* O(n * depth): one descent per word, safe on a tree of any shape. */
+double wbst_weighted_depth(BSTNode *root) {
+    BSTIter  it;
+    BSTNode *n;
+    double   cost = 0.0, total = 0.0, w;
+
+    bst_iter_init(&it, root);
+    while ((n = bst_iter_next(&it)) != NULL) {
+        w      = (double)wbst_weight(n->rec);
+        cost  += w * bst_depth(root, n->rec->word);
+        total += w;
+    }
+    bst_iter_free(&it);
+    return total > 0.0 ? cost / total : 0.0;
+}
+
+void wbst_free(WBST *t) {
+    if (!t) return;
+    bst_free(&t->root);
+    t->changes = 0;
+}
@@ -0,0 +1,90 @@
+/* wbst.h - BST laid out by word frequency, rebuilt as the weights drift */
+#ifndef WBST_H
+#define WBST_H
+
+#include "dictionary.h"
+#include "bst.h"
+
+/*
+ * WBST - a binary search tree shaped by expected lookup cost rather than
+ * by count.  Each word weighs 1 + word_record_score (its frequency_score
+ * from data/word_freq.txt plus the weight of its picks), and a layout
+ * puts the word holding the middle of each range's total weight at the
+ * range's root (Mehlhorn's bisection rule).  A word of weight w then sits
+ * at most log2(W / w) + 2 deep, W being the total: common words rise to
+ * the top few levels, and since nearly every word has the default score
+ * the rest stay within a level or two of a balanced tree.  The expected
+ * cost then stays within two compares of the best any tree can do for
+ * those weights, from an O(n log n) build (an exactly optimal tree takes
+ * O(n^2)).
+ *
+ * The nodes are ordinary BSTNodes from the BST pool, so every read-only
+ * BST call serves it as it is: bst_search_normalized, autocomplete_bst,
+ * bst_shape, bst_memory and the iterators all take t.root.  Only updates
+ * go through here, since bst_insert and bst_delete would treat the
+ * deliberately uneven sizes as imbalance to rebuild away (BST_SCAPEGOAT).
+ *
+ * Between layouts the tree is a plain BST: inserts hang new words where
+ * the search ends, deletes splice in the inorder successor, and score
+ * changes leave words where they are.  Every such change is counted, and
+ * after WBST_RELAYOUT_DIV (config.h) of them per n words the tree is laid
+ * out again — O(n log n), so amortised O(WBST_RELAYOUT_DIV log n) per
+ * change.  A layout allocates the nodes afresh in preorder (and frees the
+ * old ones) rather than relinking them, so the nodes a search passes
+ * through sit close together in the pool, as after bst_build_from_sorted;
+ * BSTNode pointers into the tree do not survive it.  An insert that lands skewed deep (shape_too_deep) lays the
+ * tree out at once, so a sorted run cannot build a chain, though it then
+ * costs a layout every few dozen words: fill a tree with wbst_build.
+ */
+typedef struct WBST {
+    BSTNode *root;
+    int      changes;   /* inserts, deletes and reweighs since the last layout */
+} WBST;
+
+/* Static initialiser for an empty tree. */
+#define WBST_INIT  { NULL, 0 }
+
+/* The weight a layout gives rec: 1 + word_record_score(rec). */
+int wbst_weight(const WordRecord *rec);
+
+/*
+ * Build t over recs[0..n), sorted by word with no duplicates, laid out
+ * by weight.  Any previous tree is freed.  Returns 0, or -1 on malloc
+ * failure (t is left empty).
+ */
+int wbst_build(WBST *t, WordRecord **recs, int n);
+
+/*
+ * Take over the BST at *root (which is set to NULL) and lay it out by
+ * weight.  Any previous tree is freed.  Returns 0, or -1 on malloc
+ * failure (t then holds the tree as it was).
+ */
+int wbst_adopt(WBST *t, BSTNode **root);
+
+/* Lay the tree out again by the current weights.  Returns 0, or -1
+   (tree unchanged) on malloc failure. */
+int wbst_layout(WBST *t);
+
+/* Insert rec (word already lowercase, as store_add guarantees).  Returns
+   1 if inserted, 0 on duplicate or malloc failure. */
+int wbst_insert(WBST *t, WordRecord *rec);
+
+/* Delete word (any case).  Returns 1 if it was in the tree. */
+int wbst_delete(WBST *t, const char *word);
+
+/* Count k score changes (picks applied, decay) towards the next layout:
+   the words stay put until then.  Returns 1 if this laid the tree out. */
+int wbst_reweigh(WBST *t, int k);
+
+/*
+ * Expected compares of a successful lookup when each word is looked up
+ * in proportion to its weight: sum(weight * depth) / sum(weight) over
+ * every word, by current weights.  Any BST can be measured, so a
+ * count-balanced tree over the same words gives the comparison.
+ */
+double wbst_weighted_depth(BSTNode *root);
+
+/* Free every node (the records stay in their store); t is left empty. */
+void wbst_free(WBST *t);
+
+#endif /* WBST_H */